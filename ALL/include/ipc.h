@@ -45,7 +45,12 @@ enum IPC_TYPE {
     IPC_TYPE_SHARC0_READY,
     IPC_TYPE_AUDIO_ROUTING,
     IPC_TYPE_CYCLES,
-    IPC_TYPE_PROCESS_AUDIO
+    IPC_TYPE_PROCESS_AUDIO,
+    IPC_TYPE_TRACE,
+    IPC_TYPE_METER,
+    IPC_TYPE_LATENCY,
+    IPC_TYPE_MIXER,
+    IPC_TYPE_SCENE
 };
 
 /*
@@ -85,7 +90,10 @@ typedef struct _IPC_MSG_AUDIO {
 #pragma pack()
 
 /*
- * Routing Information (IPC_TYPE_AUDIO_ROUTING messages)
+ * Routing Information (IPC_TYPE_AUDIO_ROUTING messages).  Every table
+ * is a new message that is never modified once sent.  SHARC0 switches
+ * to it between blocks, releases the table it replaces and
+ * acknowledges by copying 'generation' into 'ack'.
  */
 #pragma pack(1)
 typedef struct _ROUTE_INFO {
@@ -100,12 +108,16 @@ typedef struct _ROUTE_INFO {
 typedef struct _IPC_MSG_ROUTING {
     uint8_t numRoutes;
     uint8_t reserved[3];
+    uint32_t generation;
+    volatile uint32_t ack;
     ROUTE_INFO routes[1];
 } IPC_MSG_ROUTING;
 #pragma pack()
 
 /*
- * CPU cycles (IPC_TYPE_CYCLES messages)
+ * CPU cycles (IPC_TYPE_CYCLES messages).  'coreCycles' holds the
+ * cycles of the most recent block routed without the copy engine
+ * (zero until one has run), 'cycles' those of the latest block.
  */
 #pragma pack(1)
 typedef struct _IPC_MSG_CYCLES {
@@ -113,6 +125,7 @@ typedef struct _IPC_MSG_CYCLES {
     uint8_t max;
     uint8_t reserved[2];
     uint32_t cycles[IPC_CYCLE_DOMAIN_MAX];
+    uint32_t coreCycles[IPC_CYCLE_DOMAIN_MAX];
 } IPC_MSG_CYCLES;
 #pragma pack()
 
@@ -126,6 +139,81 @@ typedef struct _IPC_MSG_PROCESS_AUDIO {
 } IPC_MSG_PROCESS_AUDIO;
 #pragma pack()
 
+/*
+ * Event trace buffer (IPC_TYPE_TRACE messages).  The trace buffer
+ * follows the message header and stays owned by the ARM.
+ */
+#pragma pack(1)
+typedef struct _IPC_MSG_TRACE {
+    uint8_t reserved[4];
+    uint8_t buffer[];
+} IPC_MSG_TRACE;
+#pragma pack()
+
+/*
+ * Level meter table (IPC_TYPE_METER messages).  The meter table
+ * follows the message header and stays owned by the ARM.
+ */
+#pragma pack(1)
+typedef struct _IPC_MSG_METER {
+    uint8_t reserved[4];
+    uint8_t table[];
+} IPC_MSG_METER;
+#pragma pack()
+
+/*
+ * Latency probe table (IPC_TYPE_LATENCY messages).  The probe table
+ * follows the message header and stays owned by the ARM.
+ */
+#pragma pack(1)
+typedef struct _IPC_MSG_LATENCY {
+    uint8_t reserved[4];
+    uint8_t probe[];
+} IPC_MSG_LATENCY;
+#pragma pack()
+
+/*
+ * Crosspoint mixer matrix (IPC_TYPE_MIXER messages).  The CSR matrix
+ * follows the message header.  SHARC0 holds on to the message until
+ * the next matrix replaces it.
+ */
+#pragma pack(1)
+typedef struct _IPC_MSG_MIXER {
+    uint8_t reserved[4];
+    uint8_t matrix[];
+} IPC_MSG_MIXER;
+#pragma pack()
+
+/*
+ * Scene (IPC_TYPE_SCENE messages).  A routing table and, 'matrix'
+ * bytes from the start of the message, a crosspoint mixer matrix that
+ * SHARC0 switches to together, crossfading from the previous routes
+ * and matrix over 'fadeBlocks' blocks.  SHARC0 holds on to the
+ * message until both are replaced.  A scene that arrives during a
+ * fade waits for it to end, along with any routes and matrix sent
+ * after it.
+ */
+#pragma pack(1)
+typedef struct _IPC_MSG_SCENE {
+    uint16_t fadeBlocks;
+    uint8_t reserved[2];
+    uint32_t matrix;
+    IPC_MSG_ROUTING routes;
+} IPC_MSG_SCENE;
+#pragma pack()
+
+/*
+ * Ping (IPC_TYPE_PING messages).  The SHARCs echo 'seq' back and fill
+ * in their core.  Periodic housekeeping pings use a 'seq' of zero.
+ */
+#pragma pack(1)
+typedef struct _IPC_MSG_PING {
+    uint8_t core;
+    uint8_t reserved[3];
+    uint32_t seq;
+} IPC_MSG_PING;
+#pragma pack()
+
 /*
  * Generic message.  Query type to determine which union'd payload to
  * use.
@@ -139,6 +227,12 @@ typedef struct _IPC_MSG {
         IPC_MSG_ROUTING routes;
         IPC_MSG_CYCLES cycles;
         IPC_MSG_PROCESS_AUDIO process;
+        IPC_MSG_TRACE trace;
+        IPC_MSG_METER meter;
+        IPC_MSG_LATENCY latency;
+        IPC_MSG_MIXER mixer;
+        IPC_MSG_SCENE scene;
+        IPC_MSG_PING ping;
     };
 } IPC_MSG;
 #pragma pack()
@@ -0,0 +1,35 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _trace_cfg_h
+#define _trace_cfg_h
+
+#include "clocks.h"
+
+/*
+ * Set to 0 to compile out all trace points
+ */
+#define TRACE_ENABLE             (1)
+
+/*
+ * Number of events kept per core.  Must be a power of 2.  The trace
+ * buffer lives in the SAE shared heap so keep this modest.
+ */
+#define TRACE_EVENTS_PER_CORE    (256)
+
+/*
+ * All cores timestamp events from the free running CGU0 timestamp
+ * counter so the per-core buffers share a common time base.
+ */
+#define TRACE_TIMESTAMP()        (*pREG_CGU0_TSCOUNT0)
+#define TRACE_TIMESTAMP_HZ       (CGU_TS_CLK)
+
+#endif
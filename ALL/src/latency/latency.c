@@ -0,0 +1,460 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Standard includes */
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+/* Module includes */
+#include "latency.h"
+
+#if defined(__ADSP21000__)
+#define LATENCY_BARRIER()   asm volatile ("SYNC;" ::: "memory")
+#else
+#define LATENCY_BARRIER()   __sync_synchronize()
+#endif
+
+/* Galois LFSR taps for x^10 + x^7 + 1 */
+#define LATENCY_MLS_TAPS    (0x240)
+
+/* Clock domain of a stream not seen yet */
+#define LATENCY_NO_DOMAIN   (0xFF)
+
+static LATENCY_PROBE * volatile latencyProbe = NULL;
+
+/* Injection and capture state, only ever touched by SHARC0 */
+static uint8_t streamDomain[IPC_STREAM_ID_MAX];
+static uint32_t domainFrames[IPC_CYCLE_DOMAIN_MAX];
+static uint32_t injectRef;
+static uint32_t injectPos;
+static uint32_t injectLfsr;
+static bool captureStarted;
+
+/* +/-1 sequence for the correlator, ARM only */
+static int8_t latencyMls[LATENCY_MLS_LEN];
+static bool latencyMlsValid = false;
+
+size_t latency_size(void)
+{
+    return(sizeof(LATENCY_PROBE));
+}
+
+LATENCY_PROBE *latency_init(void *mem)
+{
+    LATENCY_PROBE *lp = (LATENCY_PROBE *)mem;
+
+    memset(lp, 0, sizeof(*lp));
+    lp->magic = LATENCY_MAGIC;
+
+    return(lp);
+}
+
+void latency_attach(LATENCY_PROBE *lp)
+{
+    if (lp && (lp->magic != LATENCY_MAGIC)) {
+        return;
+    }
+    memset(streamDomain, LATENCY_NO_DOMAIN, sizeof(streamDomain));
+    memset(domainFrames, 0, sizeof(domainFrames));
+    latencyProbe = lp;
+}
+
+LATENCY_PROBE *latency_get(void)
+{
+    return(latencyProbe);
+}
+
+bool latency_arm(LATENCY_PROBE *lp, uint8_t srcID, uint8_t srcChannel,
+    uint8_t sinkID, uint8_t sinkChannel, LATENCY_SIGNAL signal,
+    int32_t level, uint32_t captureLen)
+{
+    if ((lp == NULL) ||
+        (lp->state == LATENCY_STATE_ARMED) ||
+        (lp->state == LATENCY_STATE_RUNNING)) {
+        return(false);
+    }
+    if ((srcID >= IPC_STREAM_ID_MAX) || (sinkID >= IPC_STREAM_ID_MAX)) {
+        return(false);
+    }
+
+    if (captureLen > LATENCY_CAPTURE_MAX) {
+        captureLen = LATENCY_CAPTURE_MAX;
+    }
+
+    lp->srcID = srcID;
+    lp->srcChannel = srcChannel;
+    lp->sinkID = sinkID;
+    lp->sinkChannel = sinkChannel;
+    lp->signal = signal;
+    lp->level = level;
+    lp->captureLen = captureLen;
+    lp->lead = LATENCY_LEAD_FRAMES;
+    lp->offset = 0;
+    lp->captured = 0;
+
+    LATENCY_BARRIER();
+    lp->state = LATENCY_STATE_ARMED;
+
+    return(true);
+}
+
+void latency_abort(LATENCY_PROBE *lp)
+{
+    if (lp) {
+        lp->state = LATENCY_STATE_IDLE;
+    }
+}
+
+/***********************************************************************
+ * SHARC0 side
+ **********************************************************************/
+static bool latency_is_sink(uint8_t streamID)
+{
+    switch (streamID) {
+        case IPC_STREAMID_CODEC_OUT:
+        case IPC_STREAMID_SPDIF_OUT:
+        case IPC_STREAMID_A2B_OUT:
+        case IPC_STREAMID_USB_TX:
+        case IPC_STREAM_ID_WAVE_SINK:
+        case IPC_STREAM_ID_RTP_OUT:
+            return(true);
+        default:
+            return(false);
+    }
+}
+
+static IPC_MSG_AUDIO *latency_stream(IPC_MSG_AUDIO **streamInfo,
+    uint8_t streamID, uint8_t clockDomain)
+{
+    IPC_MSG_AUDIO *audio = streamInfo[streamID];
+
+    if ((audio == NULL) || (audio->clockDomain != clockDomain)) {
+        return(NULL);
+    }
+
+    return(audio);
+}
+
+/*
+ * Writes the next block of the lead, marker or trailing silence into
+ * the inject channel.  The first block also notes where the detect
+ * stream's clock domain stands.
+ */
+static void latency_inject(LATENCY_PROBE *lp, IPC_MSG_AUDIO *audio)
+{
+    unsigned channels, frame, lead, len;
+    uint8_t sinkDomain;
+    int32_t *data;
+    int32_t level;
+    unsigned bit;
+
+    if (lp->state == LATENCY_STATE_ARMED) {
+        if ((audio->wordSize != sizeof(int32_t)) ||
+            (lp->srcChannel >= audio->numChannels)) {
+            lp->state = LATENCY_STATE_ERROR;
+            return;
+        }
+        /* Wait until the detect stream has shown up once */
+        sinkDomain = streamDomain[lp->sinkID];
+        if (sinkDomain >= IPC_CYCLE_DOMAIN_MAX) {
+            return;
+        }
+        injectRef = domainFrames[sinkDomain];
+        injectPos = 0;
+        injectLfsr = 1;
+        captureStarted = false;
+        lp->clockDomain = sinkDomain;
+        LATENCY_BARRIER();
+        lp->state = LATENCY_STATE_RUNNING;
+    }
+
+    lead = lp->lead;
+    len = (lp->signal == LATENCY_SIGNAL_MLS) ? LATENCY_MLS_LEN : 1;
+    len += lead;
+    level = lp->level;
+    channels = audio->numChannels;
+    data = audio->data + lp->srcChannel;
+
+    for (frame = 0; frame < audio->numFrames; frame++) {
+        if ((injectPos < lead) || (injectPos >= len)) {
+            *data = 0;
+        } else if (lp->signal == LATENCY_SIGNAL_MLS) {
+            bit = injectLfsr & 1;
+            injectLfsr >>= 1;
+            if (bit) {
+                injectLfsr ^= LATENCY_MLS_TAPS;
+            }
+            *data = bit ? level : -level;
+        } else {
+            *data = level;
+        }
+        if (injectPos < len) {
+            injectPos++;
+        }
+        data += channels;
+    }
+}
+
+static void latency_capture(LATENCY_PROBE *lp, IPC_MSG_AUDIO *audio,
+    uint8_t clockDomain)
+{
+    unsigned channels, frame;
+    const int32_t *data;
+    uint32_t captured;
+
+    if ((audio->wordSize != sizeof(int32_t)) ||
+        (lp->sinkChannel >= audio->numChannels)) {
+        lp->state = LATENCY_STATE_ERROR;
+        return;
+    }
+
+    if (!captureStarted) {
+        lp->offset = domainFrames[clockDomain] - injectRef;
+        captureStarted = true;
+    }
+
+    channels = audio->numChannels;
+    data = audio->data + lp->sinkChannel;
+    captured = lp->captured;
+
+    for (frame = 0; (frame < audio->numFrames) &&
+            (captured < lp->captureLen); frame++) {
+        lp->capture[captured++] = *data;
+        data += channels;
+    }
+    lp->captured = captured;
+
+    if (captured >= lp->captureLen) {
+        lp->trials++;
+        LATENCY_BARRIER();
+        lp->state = LATENCY_STATE_DONE;
+    }
+}
+
+void latency_pre_route(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain)
+{
+    LATENCY_PROBE *lp = latencyProbe;
+    IPC_MSG_AUDIO *audio;
+    unsigned id;
+
+    if ((lp == NULL) || (clockDomain >= IPC_CYCLE_DOMAIN_MAX)) {
+        return;
+    }
+
+    for (id = 0; id < IPC_STREAM_ID_MAX; id++) {
+        if (latency_stream(streamInfo, id, clockDomain)) {
+            streamDomain[id] = clockDomain;
+        }
+    }
+
+    if ((lp->state == LATENCY_STATE_RUNNING) && !latency_is_sink(lp->sinkID)) {
+        audio = latency_stream(streamInfo, lp->sinkID, clockDomain);
+        if (audio) {
+            latency_capture(lp, audio, clockDomain);
+        }
+    }
+
+    if (((lp->state == LATENCY_STATE_ARMED) ||
+         (lp->state == LATENCY_STATE_RUNNING)) && !latency_is_sink(lp->srcID)) {
+        audio = latency_stream(streamInfo, lp->srcID, clockDomain);
+        if (audio) {
+            latency_inject(lp, audio);
+        }
+    }
+}
+
+void latency_post_route(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain)
+{
+    LATENCY_PROBE *lp = latencyProbe;
+    IPC_MSG_AUDIO *audio;
+    unsigned id;
+
+    if ((lp == NULL) || (clockDomain >= IPC_CYCLE_DOMAIN_MAX)) {
+        return;
+    }
+
+    if (((lp->state == LATENCY_STATE_ARMED) ||
+         (lp->state == LATENCY_STATE_RUNNING)) && latency_is_sink(lp->srcID)) {
+        audio = latency_stream(streamInfo, lp->srcID, clockDomain);
+        if (audio) {
+            latency_inject(lp, audio);
+        }
+    }
+
+    if ((lp->state == LATENCY_STATE_RUNNING) && latency_is_sink(lp->sinkID)) {
+        audio = latency_stream(streamInfo, lp->sinkID, clockDomain);
+        if (audio) {
+            latency_capture(lp, audio, clockDomain);
+        }
+    }
+
+    /* Advance the domain's frame count by one block */
+    for (id = 0; id < IPC_STREAM_ID_MAX; id++) {
+        audio = latency_stream(streamInfo, id, clockDomain);
+        if (audio) {
+            domainFrames[clockDomain] += audio->numFrames;
+            break;
+        }
+    }
+}
+
+/***********************************************************************
+ * ARM side
+ **********************************************************************/
+static void latency_mls_init(void)
+{
+    uint32_t lfsr = 1;
+    unsigned bit;
+    unsigned i;
+
+    for (i = 0; i < LATENCY_MLS_LEN; i++) {
+        bit = lfsr & 1;
+        lfsr >>= 1;
+        if (bit) {
+            lfsr ^= LATENCY_MLS_TAPS;
+        }
+        latencyMls[i] = bit ? 1 : -1;
+    }
+    latencyMlsValid = true;
+}
+
+/* Marker response at 'lag', in full scale units of the capture */
+static float latency_response(LATENCY_PROBE *lp, unsigned lag)
+{
+    const int32_t *x;
+    float sum;
+    unsigned i;
+
+    if (lp->signal != LATENCY_SIGNAL_MLS) {
+        return((float)lp->capture[lag]);
+    }
+
+    x = &lp->capture[lag];
+    sum = 0.0f;
+    for (i = 0; i < LATENCY_MLS_LEN; i++) {
+        sum += (float)x[i] * (float)latencyMls[i];
+    }
+
+    return(sum / (float)LATENCY_MLS_LEN);
+}
+
+bool latency_analyze(LATENCY_PROBE *lp, LATENCY_RESULT *result)
+{
+    unsigned first, lags, lag, best;
+    float y, peak, y0, y2, denom, delta;
+    float level, rms;
+    double sumSq;
+
+    memset(result, 0, sizeof(*result));
+
+    if ((lp == NULL) || (lp->state != LATENCY_STATE_DONE)) {
+        return(false);
+    }
+
+    lags = lp->captured;
+    if (lp->signal == LATENCY_SIGNAL_MLS) {
+        if (!latencyMlsValid) {
+            latency_mls_init();
+        }
+        lags = (lags >= LATENCY_MLS_LEN) ? lags - LATENCY_MLS_LEN + 1 : 0;
+    }
+
+    /* Nothing sent before the end of the lead can be the marker */
+    first = (lp->lead > lp->offset) ? lp->lead - lp->offset : 0;
+    if (first > lags) {
+        first = lags;
+    }
+
+    best = first;
+    peak = 0.0f;
+    sumSq = 0.0;
+    for (lag = first; lag < lags; lag++) {
+        y = latency_response(lp, lag);
+        sumSq += (double)y * y;
+        if (fabsf(y) > fabsf(peak)) {
+            peak = y;
+            best = lag;
+        }
+    }
+
+    /* Parabolic fit through the magnitudes around the peak */
+    delta = 0.0f;
+    if ((best > first) && (best + 1 < lags)) {
+        y0 = fabsf(latency_response(lp, best - 1));
+        y2 = fabsf(latency_response(lp, best + 1));
+        denom = y0 - 2.0f * fabsf(peak) + y2;
+        if (denom < 0.0f) {
+            delta = 0.5f * (y0 - y2) / denom;
+            if (delta > 0.5f) {
+                delta = 0.5f;
+            } else if (delta < -0.5f) {
+                delta = -0.5f;
+            }
+        }
+    }
+
+    level = fabsf((float)lp->level);
+    if (level > 0.0f) {
+        result->gain = fabsf(peak) / level;
+    }
+    rms = (lags > first) ? (float)sqrt(sumSq / (lags - first)) : 0.0f;
+    result->found = (lags > first) &&
+        (result->gain >= powf(10.0f, -(float)LATENCY_DETECT_DB / 20.0f)) &&
+        (fabsf(peak) >= rms * powf(10.0f, (float)LATENCY_DETECT_SNR_DB / 20.0f));
+    result->inverted = (peak < 0.0f);
+    result->samples = (float)lp->offset + (float)best + delta -
+        (float)lp->lead;
+
+    lp->state = LATENCY_STATE_IDLE;
+
+    return(true);
+}
+
+void latency_stats_reset(LATENCY_STATS *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->min = FLT_MAX;
+    stats->max = -FLT_MAX;
+}
+
+void latency_stats_add(LATENCY_STATS *stats, const LATENCY_RESULT *result)
+{
+    if (!result->found) {
+        stats->missed++;
+        return;
+    }
+    stats->found++;
+    if (result->samples < stats->min) {
+        stats->min = result->samples;
+    }
+    if (result->samples > stats->max) {
+        stats->max = result->samples;
+    }
+    stats->sum += result->samples;
+    stats->sumSq += (double)result->samples * result->samples;
+}
+
+void latency_stats_get(const LATENCY_STATS *stats, float *mean, float *jitter)
+{
+    double m, var;
+
+    *mean = 0.0f;
+    *jitter = 0.0f;
+    if (stats->found == 0) {
+        return;
+    }
+
+    m = stats->sum / stats->found;
+    var = stats->sumSq / stats->found - m * m;
+    *mean = (float)m;
+    *jitter = (var > 0.0) ? (float)sqrt(var) : 0.0f;
+}
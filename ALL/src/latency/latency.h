@@ -0,0 +1,257 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Audio path latency probe
+ *
+ *   SHARC0 injects a marker (a single impulse or a maximum length
+ *   sequence) into one channel of an inject stream and captures one
+ *   channel of a detect stream into a table in SAE shared memory
+ *   allocated by the ARM.  Source streams are injected before routing
+ *   and sink streams after, while source streams are captured before
+ *   routing and sink streams after.  This measures internal routes
+ *   (source -> sink) as well as external loopbacks (sink -> cable ->
+ *   source) with the same code.  The inject channel carries nothing
+ *   but the marker, preceded by LATENCY_LEAD_FRAMES of silence, until
+ *   the capture completes.
+ *
+ *   The ARM locates the marker in the capture with latency_analyze()
+ *   so SHARC0 never does more than a copy per block.  Latency is
+ *   counted in frames of the detect stream's clock domain from the
+ *   first frame of the injected block.
+ *
+ * @file      latency.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _latency_h
+#define _latency_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ipc.h"
+
+/*!****************************************************************
+ * @brief  Max number of captured detect stream frames
+ ******************************************************************/
+#ifndef LATENCY_CAPTURE_MAX
+#define LATENCY_CAPTURE_MAX      (8192)
+#endif
+
+/*!****************************************************************
+ * @brief  Muted frames sent ahead of the marker
+ * Whatever the path still carries from before the trial arrives
+ * during this time and is kept out of the search.  Must exceed the
+ * longest latency measured.
+ ******************************************************************/
+#ifndef LATENCY_LEAD_FRAMES
+#define LATENCY_LEAD_FRAMES      (1024)
+#endif
+
+/*!****************************************************************
+ * @brief  Length of the maximum length sequence (2^10 - 1)
+ ******************************************************************/
+#define LATENCY_MLS_LEN          (1023)
+
+/*!****************************************************************
+ * @brief  A marker must come back no more than this many dB below
+ *         its injected level to count as detected
+ ******************************************************************/
+#ifndef LATENCY_DETECT_DB
+#define LATENCY_DETECT_DB        (30)
+#endif
+
+/*!****************************************************************
+ * @brief  The marker peak must stand this many dB above the RMS of
+ *         the whole response to count as detected
+ ******************************************************************/
+#ifndef LATENCY_DETECT_SNR_DB
+#define LATENCY_DETECT_SNR_DB    (20)
+#endif
+
+/*!****************************************************************
+ * @brief  Probe states
+ ******************************************************************/
+typedef enum _LATENCY_STATE {
+    LATENCY_STATE_IDLE = 0,   /**< Nothing to do */
+    LATENCY_STATE_ARMED,      /**< Inject at the next inject stream block */
+    LATENCY_STATE_RUNNING,    /**< Injected, capturing */
+    LATENCY_STATE_DONE,       /**< Capture complete */
+    LATENCY_STATE_ERROR       /**< Bad stream, channel or word size */
+} LATENCY_STATE;
+
+/*!****************************************************************
+ * @brief  Marker signals
+ ******************************************************************/
+typedef enum _LATENCY_SIGNAL {
+    LATENCY_SIGNAL_IMPULSE = 0,
+    LATENCY_SIGNAL_MLS
+} LATENCY_SIGNAL;
+
+/*!****************************************************************
+ * @brief  Shared probe table
+ * The ARM fills in the request and sets 'state' to ARMED, SHARC0
+ * fills in 'offset', 'captured' and 'capture' and sets 'state' to
+ * DONE.  'offset' is the number of detect stream frames between the
+ * first injected block and capture[0], 'lead' the number of muted
+ * frames sent ahead of the marker.
+ ******************************************************************/
+typedef struct _LATENCY_PROBE {
+    uint32_t magic;
+    volatile uint32_t state;
+    uint8_t srcID;
+    uint8_t srcChannel;
+    uint8_t sinkID;
+    uint8_t sinkChannel;
+    uint8_t signal;
+    uint8_t clockDomain;
+    uint8_t reserved[2];
+    int32_t level;
+    uint32_t captureLen;
+    uint32_t offset;
+    uint32_t lead;
+    uint32_t captured;
+    uint32_t trials;
+    int32_t capture[LATENCY_CAPTURE_MAX];
+} LATENCY_PROBE;
+
+#define LATENCY_MAGIC  (0x4C415459)
+
+/*!****************************************************************
+ * @brief  Result of one trial
+ * 'samples' is the latency in detect stream frames including the
+ * interpolated fraction, 'gain' the returned marker level relative
+ * to the injected level.
+ ******************************************************************/
+typedef struct _LATENCY_RESULT {
+    bool found;
+    bool inverted;
+    float samples;
+    float gain;
+} LATENCY_RESULT;
+
+/*!****************************************************************
+ * @brief  Latency statistics over a number of trials
+ ******************************************************************/
+typedef struct _LATENCY_STATS {
+    unsigned found;
+    unsigned missed;
+    float min;
+    float max;
+    double sum;
+    double sumSq;
+} LATENCY_STATS;
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!****************************************************************
+ * @brief  Returns the number of bytes required for a probe table
+ ******************************************************************/
+size_t latency_size(void);
+
+/*!****************************************************************
+ * @brief  Initialize an idle probe table (ARM only)
+ * @param [in]  mem  Shared memory of at least latency_size() bytes
+ * @return Initialized probe table
+ ******************************************************************/
+LATENCY_PROBE *latency_init(void *mem);
+
+/*!****************************************************************
+ * @brief  Attach this core to a probe table
+ * @param [in]  lp  Shared probe table or NULL to detach
+ ******************************************************************/
+void latency_attach(LATENCY_PROBE *lp);
+
+/*!****************************************************************
+ * @brief  Returns the probe table this core is attached to
+ ******************************************************************/
+LATENCY_PROBE *latency_get(void);
+
+/*!****************************************************************
+ * @brief  Request one trial (ARM only)
+ * @param [in]  lp          Probe table
+ * @param [in]  srcID       Inject stream
+ * @param [in]  srcChannel  Inject channel
+ * @param [in]  sinkID      Detect stream
+ * @param [in]  sinkChannel Detect channel
+ * @param [in]  signal      Marker signal
+ * @param [in]  level       Marker amplitude relative to 32-bit full scale
+ * @param [in]  captureLen  Frames to capture including the lead,
+ *                          clipped to LATENCY_CAPTURE_MAX
+ * @return false if a trial is already in progress
+ ******************************************************************/
+bool latency_arm(LATENCY_PROBE *lp, uint8_t srcID, uint8_t srcChannel,
+    uint8_t sinkID, uint8_t sinkChannel, LATENCY_SIGNAL signal,
+    int32_t level, uint32_t captureLen);
+
+/*!****************************************************************
+ * @brief  Abandon the current trial (ARM only)
+ ******************************************************************/
+void latency_abort(LATENCY_PROBE *lp);
+
+/*!****************************************************************
+ * @brief  Injects into and captures source streams (SHARC0)
+ *
+ * Call before the clock domain is routed.
+ *
+ * @param [in]  streamInfo   Stream table indexed by stream ID
+ * @param [in]  clockDomain  Clock domain about to be routed
+ ******************************************************************/
+void latency_pre_route(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain);
+
+/*!****************************************************************
+ * @brief  Injects into and captures sink streams (SHARC0)
+ *
+ * Call once the clock domain has been routed.
+ *
+ * @param [in]  streamInfo   Stream table indexed by stream ID
+ * @param [in]  clockDomain  Clock domain just routed
+ ******************************************************************/
+void latency_post_route(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain);
+
+/*!****************************************************************
+ * @brief  Locates the marker in a completed capture (ARM only)
+ *
+ * Impulses are found by their peak, sequences by cross correlation,
+ * searching from the end of the lead only.  Either way the peak is
+ * refined with a parabolic fit.  Returns the probe to idle.
+ *
+ * @param [in]  lp      Probe table in the DONE state
+ * @param [out] result  Trial result
+ * @return false if the probe was not DONE
+ ******************************************************************/
+bool latency_analyze(LATENCY_PROBE *lp, LATENCY_RESULT *result);
+
+/*!****************************************************************
+ * @brief  Clears a set of statistics
+ ******************************************************************/
+void latency_stats_reset(LATENCY_STATS *stats);
+
+/*!****************************************************************
+ * @brief  Adds a trial result to a set of statistics
+ ******************************************************************/
+void latency_stats_add(LATENCY_STATS *stats, const LATENCY_RESULT *result);
+
+/*!****************************************************************
+ * @brief  Mean and standard deviation (jitter) of the found trials
+ ******************************************************************/
+void latency_stats_get(const LATENCY_STATS *stats, float *mean, float *jitter);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,301 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Standard includes */
+#include <string.h>
+#include <math.h>
+
+/* Module includes */
+#include "meter.h"
+
+#if defined(__ADSP21000__)
+#define METER_BARRIER()   asm volatile ("SYNC;" ::: "memory")
+#else
+#define METER_BARRIER()   __sync_synchronize()
+#endif
+
+/* Number of snapshot attempts in meter_read() */
+#define METER_READ_TRIES  (100)
+
+/* Full scale of a 32-bit sample */
+#define METER_SCALE       (1.0f / 2147483648.0f)
+
+typedef struct _METER_STATE {
+    float peak[METER_MAX_CHANNELS];
+    float ms[METER_MAX_CHANNELS];
+} METER_STATE;
+
+static METER_TABLE * volatile meterTable = NULL;
+
+/* Smoothed levels, only ever written by the metering core */
+static METER_STATE meterState[IPC_STREAM_ID_MAX];
+
+/* Per block peak and sum of squares */
+static float blockPeak[METER_MAX_CHANNELS];
+static float blockSq[METER_MAX_CHANNELS];
+
+size_t meter_size(void)
+{
+    return(sizeof(METER_TABLE));
+}
+
+METER_TABLE *meter_init(void *mem, unsigned blockHz)
+{
+    METER_TABLE *mt = (METER_TABLE *)mem;
+
+    memset(mt, 0, sizeof(*mt));
+    mt->streams = METER_ALL_STREAMS;
+    meter_ballistics(mt, METER_RMS_MS, METER_PEAK_DECAY_DB, blockHz);
+    mt->magic = METER_MAGIC;
+
+    return(mt);
+}
+
+void meter_ballistics(METER_TABLE *mt, unsigned rmsMs, unsigned decayDb,
+    unsigned blockHz)
+{
+    float blockSec;
+
+    mt->rmsMs = rmsMs;
+    mt->decayDb = decayDb;
+    if (blockHz == 0) {
+        return;
+    }
+    blockSec = 1.0f / (float)blockHz;
+
+    if (rmsMs == 0) {
+        mt->rmsCoef = 1.0f;
+    } else {
+        mt->rmsCoef = 1.0f - expf(-blockSec * 1000.0f / (float)rmsMs);
+    }
+    mt->peakDecay = powf(10.0f, -(float)decayDb * blockSec / 20.0f);
+}
+
+void meter_rate(METER_TABLE *mt, unsigned blockHz)
+{
+    meter_ballistics(mt, mt->rmsMs, mt->decayDb, blockHz);
+}
+
+void meter_attach(METER_TABLE *mt)
+{
+    if (mt && (mt->magic != METER_MAGIC)) {
+        return;
+    }
+    memset(meterState, 0, sizeof(meterState));
+    meterTable = mt;
+}
+
+METER_TABLE *meter_table(void)
+{
+    return(meterTable);
+}
+
+/*
+ * Peak and sum of squares of the first 'channels' channels of an
+ * interleaved block.  The inner loop runs across adjacent channels
+ * so it vectorizes with one accumulator pair per channel.  The peak
+ * is a plain compare, fmaxf() is a libm call per sample on hosts
+ * without -ffinite-math-only.
+ */
+#if defined(__ADSP21000__)
+#pragma optimize_for_speed
+#endif
+static void meter_kernel(const int32_t *data, unsigned stride,
+    unsigned channels, unsigned frames, float *peak, float *sq)
+{
+    unsigned frame;
+    unsigned ch;
+    float x, ax;
+
+    for (ch = 0; ch < channels; ch++) {
+        peak[ch] = 0.0f;
+        sq[ch] = 0.0f;
+    }
+
+    for (frame = 0; frame < frames; frame++) {
+#if defined(__ADSP21000__)
+#pragma SIMD_for
+#endif
+        for (ch = 0; ch < channels; ch++) {
+            x = (float)data[ch];
+            ax = fabsf(x);
+            peak[ch] = (ax > peak[ch]) ? ax : peak[ch];
+            sq[ch] += x * x;
+        }
+        data += stride;
+    }
+}
+
+/*
+ * Copies the smoothed levels into the shared table.  The entry's
+ * sequence counter is odd for the duration of the update.
+ */
+static void meter_publish(METER_STREAM *entry, METER_STATE *state,
+    IPC_MSG_AUDIO *audio, unsigned channels)
+{
+    volatile float *peak = entry->peak;
+    volatile float *ms = entry->ms;
+    unsigned ch;
+
+    entry->seq++;
+    METER_BARRIER();
+
+    for (ch = 0; ch < channels; ch++) {
+        peak[ch] = state->peak[ch];
+        ms[ch] = state->ms[ch];
+    }
+    entry->numChannels = channels;
+    entry->clockDomain = audio->clockDomain;
+    entry->blocks++;
+
+    METER_BARRIER();
+    entry->seq++;
+}
+
+#if defined(__ADSP21000__)
+#pragma optimize_for_speed
+#endif
+void meter_audio(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain)
+{
+    METER_TABLE *mt = meterTable;
+    IPC_MSG_AUDIO *audio;
+    METER_STATE *state;
+    float rmsCoef, peakDecay;
+    float sqScale;
+    float p, m;
+    unsigned channels, total;
+    unsigned id, ch;
+    uint32_t streams;
+
+    if ((mt == NULL) || !mt->enable) {
+        return;
+    }
+
+    rmsCoef = mt->rmsCoef;
+    peakDecay = mt->peakDecay;
+    streams = mt->streams;
+    total = 0;
+
+    for (id = 0; id < IPC_STREAM_ID_MAX; id++) {
+
+        if ((streams & METER_STREAM(id)) == 0) {
+            continue;
+        }
+        audio = streamInfo[id];
+        if ((audio == NULL) || (audio->clockDomain != clockDomain)) {
+            continue;
+        }
+        if ((audio->wordSize != sizeof(int32_t)) || (audio->numFrames == 0)) {
+            continue;
+        }
+
+        channels = audio->numChannels;
+        if (channels > METER_MAX_CHANNELS) {
+            channels = METER_MAX_CHANNELS;
+        }
+
+        meter_kernel(audio->data, audio->numChannels, channels,
+            audio->numFrames, blockPeak, blockSq);
+
+        /* Ballistics, all in full scale units */
+        state = &meterState[id];
+        sqScale = METER_SCALE * METER_SCALE / (float)audio->numFrames;
+        for (ch = 0; ch < channels; ch++) {
+            p = blockPeak[ch] * METER_SCALE;
+            state->peak[ch] = fmaxf(p, state->peak[ch] * peakDecay);
+            m = blockSq[ch] * sqScale;
+            state->ms[ch] += rmsCoef * (m - state->ms[ch]);
+        }
+
+        meter_publish(&mt->stream[id], state, audio, channels);
+        total += channels;
+    }
+
+    if (clockDomain < IPC_CYCLE_DOMAIN_MAX) {
+        mt->channels[clockDomain] = total;
+    }
+}
+
+void meter_cycles(uint8_t clockDomain, uint32_t cycles)
+{
+    METER_TABLE *mt = meterTable;
+
+    if ((mt == NULL) || !mt->enable || (clockDomain >= IPC_CYCLE_DOMAIN_MAX)) {
+        return;
+    }
+    mt->cycles[clockDomain] = cycles;
+    if (cycles > mt->maxCycles[clockDomain]) {
+        mt->maxCycles[clockDomain] = cycles;
+    }
+}
+
+bool meter_read(METER_TABLE *mt, unsigned streamID, METER_LEVELS *levels)
+{
+    METER_STREAM *entry;
+    volatile float *peak;
+    volatile float *ms;
+    uint32_t seq;
+    unsigned tries;
+    unsigned ch;
+    bool ok;
+
+    if ((mt == NULL) || (streamID >= IPC_STREAM_ID_MAX)) {
+        return(false);
+    }
+
+    entry = &mt->stream[streamID];
+    peak = entry->peak;
+    ms = entry->ms;
+    ok = false;
+
+    for (tries = 0; (tries < METER_READ_TRIES) && !ok; tries++) {
+        seq = entry->seq;
+        if (seq & 1) {
+            continue;
+        }
+        METER_BARRIER();
+        levels->blocks = entry->blocks;
+        levels->numChannels = entry->numChannels;
+        levels->clockDomain = entry->clockDomain;
+        if (levels->numChannels > METER_MAX_CHANNELS) {
+            levels->numChannels = METER_MAX_CHANNELS;
+        }
+        for (ch = 0; ch < levels->numChannels; ch++) {
+            levels->peak[ch] = peak[ch];
+            levels->rms[ch] = ms[ch];
+        }
+        METER_BARRIER();
+        ok = (entry->seq == seq);
+    }
+
+    if (ok) {
+        for (ch = 0; ch < levels->numChannels; ch++) {
+            levels->rms[ch] = sqrtf(levels->rms[ch]);
+        }
+    }
+
+    return(ok);
+}
+
+int meter_db10(float level)
+{
+    int db10;
+
+    if (level <= 1.0e-6f) {
+        return(METER_FLOOR_DB10);
+    }
+    db10 = (int)lrintf(200.0f * log10f(level));
+    if (db10 < METER_FLOOR_DB10) {
+        db10 = METER_FLOOR_DB10;
+    }
+
+    return(db10);
+}
@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Per-stream level meters
+ *
+ *   SHARC0 meters every audio stream of a clock domain once it has
+ *   been routed, so sources show what arrived and sinks show what
+ *   will be sent.  The smoothed peak and mean square of each channel
+ *   are published into a table in SAE shared memory allocated by the
+ *   ARM.  Each stream entry is guarded by a sequence counter (seqlock)
+ *   so the ARM reads consistent snapshots without ever blocking the
+ *   SHARC.
+ *
+ *   Ballistics are per block: peaks attack instantly and decay by a
+ *   fixed factor, mean squares follow a one pole average.  Only the
+ *   streams in the table's 'streams' mask are metered, so a view of
+ *   one stream does not pay for all of them.
+ *
+ * @file      meter.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _meter_h
+#define _meter_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ipc.h"
+
+/*!****************************************************************
+ * @brief  Max number of channels metered per stream
+ ******************************************************************/
+#ifndef METER_MAX_CHANNELS
+#define METER_MAX_CHANNELS       (32)
+#endif
+
+/*!****************************************************************
+ * @brief  Default RMS averaging time constant in mS
+ ******************************************************************/
+#ifndef METER_RMS_MS
+#define METER_RMS_MS             (300)
+#endif
+
+/*!****************************************************************
+ * @brief  Default peak decay in dB per second
+ ******************************************************************/
+#ifndef METER_PEAK_DECAY_DB
+#define METER_PEAK_DECAY_DB      (20)
+#endif
+
+/*!****************************************************************
+ * @brief  Lowest level reported by meter_db10() (-120.0 dBFS)
+ ******************************************************************/
+#define METER_FLOOR_DB10         (-1200)
+
+/*!****************************************************************
+ * @brief  Stream mask bits
+ ******************************************************************/
+#define METER_STREAM(id)         (1UL << (id))
+#define METER_ALL_STREAMS        (0xFFFFFFFFUL)
+
+/*!****************************************************************
+ * @brief  Shared per-stream meter entry
+ *
+ * 'seq' is odd while SHARC0 is updating the entry.  'peak' is the
+ * linear peak and 'ms' the mean square, both relative to full scale.
+ ******************************************************************/
+typedef struct _METER_STREAM {
+    volatile uint32_t seq;
+    uint32_t blocks;
+    uint8_t numChannels;
+    uint8_t clockDomain;
+    uint8_t reserved[2];
+    float peak[METER_MAX_CHANNELS];
+    float ms[METER_MAX_CHANNELS];
+} METER_STREAM;
+
+/*!****************************************************************
+ * @brief  Shared meter table
+ *
+ * 'cycles' and 'channels' are the SHARC0 cost and channel count of
+ * the most recent block of each clock domain.  'rmsMs' and 'decayDb'
+ * are kept so the per block coefficients can be recomputed when the
+ * block rate changes.
+ ******************************************************************/
+typedef struct _METER_TABLE {
+    uint32_t magic;
+    volatile uint32_t enable;
+    volatile uint32_t streams;
+    float rmsCoef;
+    float peakDecay;
+    uint32_t rmsMs;
+    uint32_t decayDb;
+    uint32_t cycles[IPC_CYCLE_DOMAIN_MAX];
+    uint32_t maxCycles[IPC_CYCLE_DOMAIN_MAX];
+    uint32_t channels[IPC_CYCLE_DOMAIN_MAX];
+    METER_STREAM stream[IPC_STREAM_ID_MAX];
+} METER_TABLE;
+
+#define METER_MAGIC  (0x4D455452)
+
+/*!****************************************************************
+ * @brief  A consistent copy of one stream's meters
+ ******************************************************************/
+typedef struct _METER_LEVELS {
+    uint32_t blocks;
+    uint8_t numChannels;
+    uint8_t clockDomain;
+    float peak[METER_MAX_CHANNELS];
+    float rms[METER_MAX_CHANNELS];
+} METER_LEVELS;
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!****************************************************************
+ * @brief  Returns the number of bytes required for a meter table
+ ******************************************************************/
+size_t meter_size(void);
+
+/*!****************************************************************
+ * @brief  Initialize a meter table with the default ballistics
+ *         (ARM only)
+ *
+ * @param [in]  mem      Shared memory of at least meter_size() bytes
+ * @param [in]  blockHz  Audio block rate
+ *
+ * @return Initialized meter table
+ ******************************************************************/
+METER_TABLE *meter_init(void *mem, unsigned blockHz);
+
+/*!****************************************************************
+ * @brief  Set the meter ballistics (ARM only)
+ *
+ * @param [in]  mt        Meter table
+ * @param [in]  rmsMs     RMS averaging time constant in mS
+ * @param [in]  decayDb   Peak decay in dB per second
+ * @param [in]  blockHz   Audio block rate
+ ******************************************************************/
+void meter_ballistics(METER_TABLE *mt, unsigned rmsMs, unsigned decayDb,
+    unsigned blockHz);
+
+/*!****************************************************************
+ * @brief  Recompute the ballistics for a new block rate (ARM only)
+ *
+ * @param [in]  mt        Meter table
+ * @param [in]  blockHz   Audio block rate
+ ******************************************************************/
+void meter_rate(METER_TABLE *mt, unsigned blockHz);
+
+/*!****************************************************************
+ * @brief  Attach this core to a meter table
+ *
+ * @param [in]  mt  Shared meter table or NULL to detach
+ ******************************************************************/
+void meter_attach(METER_TABLE *mt);
+
+/*!****************************************************************
+ * @brief  Returns the meter table this core is attached to
+ ******************************************************************/
+METER_TABLE *meter_table(void);
+
+/*!****************************************************************
+ * @brief  Meters the selected 32-bit streams of a clock domain
+ *         (SHARC0)
+ *
+ * @param [in]  streamInfo   Stream table indexed by stream ID
+ * @param [in]  clockDomain  Clock domain to meter
+ ******************************************************************/
+void meter_audio(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain);
+
+/*!****************************************************************
+ * @brief  Records the cost of the last meter_audio() call (SHARC0)
+ ******************************************************************/
+void meter_cycles(uint8_t clockDomain, uint32_t cycles);
+
+/*!****************************************************************
+ * @brief  Takes a consistent snapshot of one stream's meters.
+ *
+ * Never blocks the writer.  Retries a few times if SHARC0 is
+ * updating the entry.
+ *
+ * @param [in]  mt        Meter table
+ * @param [in]  streamID  Stream to read
+ * @param [out] levels    Peak and RMS levels
+ *
+ * @return Returns true if a consistent snapshot was taken.
+ ******************************************************************/
+bool meter_read(METER_TABLE *mt, unsigned streamID, METER_LEVELS *levels);
+
+/*!****************************************************************
+ * @brief  Converts a linear level to tenths of a dBFS.
+ ******************************************************************/
+int meter_db10(float level);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,418 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Standard includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+/* Module includes */
+#include "mixer.h"
+
+/* Largest block, IPC_MSG_AUDIO 'numFrames' is 8 bits */
+#define MIXER_MAX_FRAMES    (256)
+
+/* Fails to compile if 'numFrames' can exceed MIXER_MAX_FRAMES */
+typedef char MIXER_MAX_FRAMES_CHECK[
+    ((1UL << (8 * sizeof(((IPC_MSG_AUDIO *)0)->numFrames))) <=
+     MIXER_MAX_FRAMES) ? 1 : -1];
+
+/* Largest float below 2^31 */
+#define MIXER_CLIP          (2147483520.0f)
+
+typedef struct _MIXER_STREAM {
+    uint8_t streamID;
+    bool sink;
+    const char *name;
+} MIXER_STREAM;
+
+static const MIXER_STREAM mixerStreams[] = {
+    { IPC_STREAMID_CODEC_IN,   false, "CODEC_IN" },
+    { IPC_STREAMID_CODEC_OUT,  true,  "CODEC_OUT" },
+    { IPC_STREAMID_SPDIF_IN,   false, "SPDIF_IN" },
+    { IPC_STREAMID_SPDIF_OUT,  true,  "SPDIF_OUT" },
+    { IPC_STREAMID_A2B_IN,     false, "A2B_IN" },
+    { IPC_STREAMID_A2B_OUT,    true,  "A2B_OUT" },
+    { IPC_STREAMID_USB_RX,     false, "USB_RX" },
+    { IPC_STREAMID_USB_TX,     true,  "USB_TX" },
+    { IPC_STREAMID_MIC_IN,     false, "MIC_IN" },
+    { IPC_STREAM_ID_WAVE_SRC,  false, "WAV_SRC" },
+    { IPC_STREAM_ID_WAVE_SINK, true,  "WAV_SINK" },
+    { IPC_STREAM_ID_RTP_IN,    false, "RTP_IN" },
+    { IPC_STREAM_ID_RTP_OUT,   true,  "RTP_OUT" },
+};
+
+#define MIXER_NUM_STREAMS  (sizeof(mixerStreams) / sizeof(mixerStreams[0]))
+
+static MIXER_MATRIX * volatile mixerMatrix = NULL;
+
+/* One row's accumulator */
+static float mixAcc[MIXER_MAX_FRAMES];
+
+/***********************************************************************
+ * ARM side
+ **********************************************************************/
+static int mixer_compare(const void *a, const void *b)
+{
+    const MIXER_POINT *pa = (const MIXER_POINT *)a;
+    const MIXER_POINT *pb = (const MIXER_POINT *)b;
+
+    if (pa->sinkID != pb->sinkID) {
+        return((int)pa->sinkID - (int)pb->sinkID);
+    }
+    if (pa->sinkChannel != pb->sinkChannel) {
+        return((int)pa->sinkChannel - (int)pb->sinkChannel);
+    }
+    if (pa->srcID != pb->srcID) {
+        return((int)pa->srcID - (int)pb->srcID);
+    }
+    return((int)pa->srcChannel - (int)pb->srcChannel);
+}
+
+void mixer_sort(MIXER_POINT *points, unsigned numPoints)
+{
+    qsort(points, numPoints, sizeof(*points), mixer_compare);
+}
+
+unsigned mixer_rows(const MIXER_POINT *points, unsigned numPoints)
+{
+    unsigned rows = 0;
+    unsigned i;
+
+    for (i = 0; i < numPoints; i++) {
+        if ((i == 0) ||
+            (points[i].sinkID != points[i-1].sinkID) ||
+            (points[i].sinkChannel != points[i-1].sinkChannel)) {
+            rows++;
+        }
+    }
+
+    return(rows);
+}
+
+size_t mixer_size(unsigned numRows, unsigned numTaps)
+{
+    return(sizeof(MIXER_MATRIX) + numRows * sizeof(MIXER_ROW) +
+        numTaps * sizeof(MIXER_TAP));
+}
+
+MIXER_MATRIX *mixer_build(void *mem, const MIXER_POINT *points,
+    unsigned numPoints)
+{
+    MIXER_MATRIX *mm = (MIXER_MATRIX *)mem;
+    MIXER_ROW *row;
+    MIXER_TAP *taps;
+    unsigned numRows;
+    unsigned i;
+
+    numRows = mixer_rows(points, numPoints);
+    memset(mm, 0, mixer_size(numRows, numPoints));
+    mm->numRows = numRows;
+    mm->numTaps = numPoints;
+    taps = (MIXER_TAP *)&mm->rows[numRows];
+
+    row = NULL;
+    for (i = 0; i < numPoints; i++) {
+        if ((row == NULL) ||
+            (points[i].sinkID != row->sinkID) ||
+            (points[i].sinkChannel != row->sinkChannel)) {
+            row = (row == NULL) ? &mm->rows[0] : row + 1;
+            row->sinkID = points[i].sinkID;
+            row->sinkChannel = points[i].sinkChannel;
+            row->first = i;
+        }
+        row->count++;
+        taps[i].srcID = points[i].srcID;
+        taps[i].srcChannel = points[i].srcChannel;
+        taps[i].gain = points[i].gain;
+    }
+    mm->magic = MIXER_MAGIC;
+
+    return(mm);
+}
+
+/***********************************************************************
+ * SHARC0 side
+ **********************************************************************/
+bool mixer_attach(MIXER_MATRIX *mm)
+{
+    MIXER_ROW *row;
+    MIXER_TAP *taps;
+    unsigned i;
+
+    if (mm) {
+        if (mm->magic != MIXER_MAGIC) {
+            return(false);
+        }
+        taps = (MIXER_TAP *)&mm->rows[mm->numRows];
+        for (i = 0; i < mm->numRows; i++) {
+            row = &mm->rows[i];
+            if ((row->sinkID >= IPC_STREAM_ID_MAX) ||
+                (row->first + row->count > mm->numTaps)) {
+                return(false);
+            }
+        }
+        for (i = 0; i < mm->numTaps; i++) {
+            if (taps[i].srcID >= IPC_STREAM_ID_MAX) {
+                return(false);
+            }
+        }
+    }
+
+    mixerMatrix = mm;
+
+    return(true);
+}
+
+MIXER_MATRIX *mixer_get(void)
+{
+    return(mixerMatrix);
+}
+
+/*
+ * acc[] += gain * in[], 'in' being one channel of an interleaved
+ * block.  Consecutive frames are independent so the loop runs two at
+ * a time in SIMD mode.
+ */
+#if defined(__ADSP21000__)
+#pragma optimize_for_speed
+#endif
+static void mixer_tap(float *acc, const int32_t *in, unsigned stride,
+    float gain, unsigned frames)
+{
+    unsigned frame;
+
+#if defined(__ADSP21000__)
+#pragma SIMD_for
+#endif
+    for (frame = 0; frame < frames; frame++) {
+        acc[frame] += gain * (float)in[frame * stride];
+    }
+}
+
+#if defined(__ADSP21000__)
+#pragma optimize_for_speed
+#endif
+static void mixer_store(int32_t *out, unsigned stride, const float *acc,
+    unsigned frames)
+{
+    unsigned frame;
+    float x;
+
+#if defined(__ADSP21000__)
+#pragma SIMD_for
+#endif
+    for (frame = 0; frame < frames; frame++) {
+        x = fminf(fmaxf(acc[frame], -MIXER_CLIP), MIXER_CLIP);
+        out[frame * stride] = (int32_t)x;
+    }
+}
+
+static IPC_MSG_AUDIO *mixer_stream(IPC_MSG_AUDIO **streamInfo,
+    uint8_t streamID, uint8_t channel, uint8_t clockDomain)
+{
+    IPC_MSG_AUDIO *audio = streamInfo[streamID];
+
+    if ((audio == NULL) || (audio->clockDomain != clockDomain)) {
+        return(NULL);
+    }
+    if ((audio->wordSize != sizeof(int32_t)) ||
+        (channel >= audio->numChannels)) {
+        return(NULL);
+    }
+
+    return(audio);
+}
+
+void mixer_audio(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain)
+{
+    mixer_run(mixerMatrix, streamInfo, clockDomain);
+}
+
+#if defined(__ADSP21000__)
+#pragma optimize_for_speed
+#endif
+void mixer_run(const MIXER_MATRIX *mm, IPC_MSG_AUDIO **streamInfo,
+    uint8_t clockDomain)
+{
+    IPC_MSG_AUDIO *sink, *src;
+    const int32_t *in;
+    int32_t *out;
+    const MIXER_ROW *row;
+    const MIXER_TAP *taps, *tap;
+    unsigned frames, frame;
+    unsigned r, t;
+
+    if (mm == NULL) {
+        return;
+    }
+
+    taps = (const MIXER_TAP *)&mm->rows[mm->numRows];
+
+    for (r = 0; r < mm->numRows; r++) {
+
+        row = &mm->rows[r];
+        sink = mixer_stream(streamInfo, row->sinkID, row->sinkChannel,
+            clockDomain);
+        if (sink == NULL) {
+            continue;
+        }
+        frames = sink->numFrames;
+        out = sink->data + row->sinkChannel;
+
+        /* Unity single tap rows are a straight copy and stay bit exact */
+        tap = &taps[row->first];
+        if ((row->count == 1) && (tap->gain == 1.0f)) {
+            src = mixer_stream(streamInfo, tap->srcID, tap->srcChannel,
+                clockDomain);
+            if (src && (src->numFrames == frames)) {
+                in = src->data + tap->srcChannel;
+                for (frame = 0; frame < frames; frame++) {
+                    out[frame * sink->numChannels] = in[frame * src->numChannels];
+                }
+                continue;
+            }
+        }
+
+        memset(mixAcc, 0, frames * sizeof(float));
+        for (t = 0; t < row->count; t++, tap++) {
+            src = mixer_stream(streamInfo, tap->srcID, tap->srcChannel,
+                clockDomain);
+            if ((src == NULL) || (src->numFrames != frames)) {
+                continue;
+            }
+            mixer_tap(mixAcc, src->data + tap->srcChannel, src->numChannels,
+                tap->gain, frames);
+        }
+        mixer_store(out, sink->numChannels, mixAcc, frames);
+    }
+}
+
+/***********************************************************************
+ * Matrix files
+ **********************************************************************/
+static const MIXER_STREAM *mixer_find(const char *name)
+{
+    const char *s;
+    unsigned i, j;
+
+    for (i = 0; i < MIXER_NUM_STREAMS; i++) {
+        s = mixerStreams[i].name;
+        for (j = 0; s[j] && name[j]; j++) {
+            if (toupper((int)name[j]) != s[j]) {
+                break;
+            }
+        }
+        if ((s[j] == '\0') && (name[j] == '\0')) {
+            return(&mixerStreams[i]);
+        }
+    }
+
+    return(NULL);
+}
+
+int mixer_stream_id(const char *name)
+{
+    const MIXER_STREAM *ms = mixer_find(name);
+
+    return(ms ? ms->streamID : IPC_STREAMID_UNKNOWN);
+}
+
+const char *mixer_stream_name(int streamID)
+{
+    unsigned i;
+
+    for (i = 0; i < MIXER_NUM_STREAMS; i++) {
+        if (mixerStreams[i].streamID == streamID) {
+            return(mixerStreams[i].name);
+        }
+    }
+
+    return("UNKNOWN");
+}
+
+MIXER_PARSE mixer_parse(const char *line, MIXER_POINT *point)
+{
+    const MIXER_STREAM *sink, *src;
+    char sinkName[16], srcName[16], gain[16];
+    unsigned sinkChannel, srcChannel;
+    char *end;
+    float db;
+    int n;
+
+    while (isspace((int)*line)) {
+        line++;
+    }
+    if ((*line == '\0') || (*line == '#')) {
+        return(MIXER_PARSE_SKIP);
+    }
+
+    n = sscanf(line, "%15[^: \t]:%u %15[^: \t]:%u %15s", sinkName,
+        &sinkChannel, srcName, &srcChannel, gain);
+    if (n != 5) {
+        return(MIXER_PARSE_ERROR);
+    }
+
+    sink = mixer_find(sinkName);
+    src = mixer_find(srcName);
+    if ((sink == NULL) || !sink->sink || (src == NULL) || src->sink) {
+        return(MIXER_PARSE_ERROR);
+    }
+    if ((sinkChannel > UINT8_MAX) || (srcChannel > UINT8_MAX)) {
+        return(MIXER_PARSE_ERROR);
+    }
+
+    if (strcmp(gain, "off") == 0) {
+        db = MIXER_GAIN_OFF_DB;
+    } else {
+        db = strtof(gain, &end);
+        if (*end != '\0') {
+            return(MIXER_PARSE_ERROR);
+        }
+    }
+
+    point->sinkID = sink->streamID;
+    point->sinkChannel = sinkChannel;
+    point->srcID = src->streamID;
+    point->srcChannel = srcChannel;
+    point->gain = (db <= MIXER_GAIN_OFF_DB) ? 0.0f : powf(10.0f, db / 20.0f);
+
+    return(MIXER_PARSE_POINT);
+}
+
+void mixer_format(const MIXER_POINT *point, char *buf, size_t size)
+{
+    int db10;
+
+    if (point->gain == 0.0f) {
+        snprintf(buf, size, "%s:%u %s:%u off",
+            mixer_stream_name(point->sinkID), point->sinkChannel,
+            mixer_stream_name(point->srcID), point->srcChannel);
+        return;
+    }
+
+    db10 = mixer_db10(point->gain);
+    snprintf(buf, size, "%s:%u %s:%u %s%d.%d",
+        mixer_stream_name(point->sinkID), point->sinkChannel,
+        mixer_stream_name(point->srcID), point->srcChannel,
+        db10 < 0 ? "-" : "", abs(db10) / 10, abs(db10) % 10);
+}
+
+int mixer_db10(float gain)
+{
+    if (gain <= 0.0f) {
+        return(MIXER_GAIN_OFF_DB * 10);
+    }
+
+    return((int)lrintf(200.0f * log10f(fabsf(gain))));
+}
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Sparse crosspoint mixer matrix
+ *
+ *   Mixes any source stream channel into any sink stream channel with
+ *   an arbitrary float gain.  Only nonzero crosspoints are stored, in
+ *   compressed sparse rows (CSR) by output channel, so the cost per
+ *   block scales with the number of crosspoints and not with the ~150
+ *   x 90 size of the full matrix.
+ *
+ *   The ARM keeps the crosspoints as a flat list, builds the CSR form
+ *   with mixer_build() into an IPC message and sends the whole matrix
+ *   to SHARC0 in one go.  SHARC0 runs mixer_audio() after the route
+ *   list, so every output channel with a matrix row is owned by the
+ *   matrix and routes keep working for all other channels.  Like
+ *   routes, only crosspoints with both ends in the clock domain being
+ *   processed are mixed.
+ *
+ *   Matrix files are text, one crosspoint per line:
+ *
+ *     <sink>:<channel> <source>:<channel> <gain dB>
+ *
+ *   e.g. "CODEC_OUT:0 USB_RX:1 -6.0".  '#' starts a comment.
+ *
+ * @file      mixer.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _mixer_h
+#define _mixer_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ipc.h"
+
+/*!****************************************************************
+ * @brief  Max number of crosspoints in a matrix
+ ******************************************************************/
+#ifndef MIXER_MAX_POINTS
+#define MIXER_MAX_POINTS         (2048)
+#endif
+
+/*!****************************************************************
+ * @brief  Gains at or below this level turn a crosspoint off
+ ******************************************************************/
+#define MIXER_GAIN_OFF_DB        (-120)
+
+/*!****************************************************************
+ * @brief  One crosspoint, as kept by the ARM
+ ******************************************************************/
+typedef struct _MIXER_POINT {
+    uint8_t sinkID;
+    uint8_t sinkChannel;
+    uint8_t srcID;
+    uint8_t srcChannel;
+    float gain;
+} MIXER_POINT;
+
+/*!****************************************************************
+ * @brief  One output channel of the CSR matrix
+ * 'first' and 'count' select the row's taps.
+ ******************************************************************/
+typedef struct _MIXER_ROW {
+    uint8_t sinkID;
+    uint8_t sinkChannel;
+    uint16_t count;
+    uint16_t first;
+    uint16_t reserved;
+} MIXER_ROW;
+
+/*!****************************************************************
+ * @brief  One nonzero input of a row
+ ******************************************************************/
+typedef struct _MIXER_TAP {
+    uint8_t srcID;
+    uint8_t srcChannel;
+    uint8_t reserved[2];
+    float gain;
+} MIXER_TAP;
+
+/*!****************************************************************
+ * @brief  CSR matrix, 'numRows' rows followed by 'numTaps' taps
+ ******************************************************************/
+typedef struct _MIXER_MATRIX {
+    uint32_t magic;
+    uint16_t numRows;
+    uint16_t numTaps;
+    MIXER_ROW rows[];
+} MIXER_MATRIX;
+
+#define MIXER_MAGIC  (0x4D495852)
+
+/*!****************************************************************
+ * @brief  mixer_parse() results
+ ******************************************************************/
+typedef enum _MIXER_PARSE {
+    MIXER_PARSE_POINT = 0,    /**< Line held a crosspoint */
+    MIXER_PARSE_SKIP,         /**< Blank or comment line */
+    MIXER_PARSE_ERROR         /**< Malformed line */
+} MIXER_PARSE;
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!****************************************************************
+ * @brief  Sorts crosspoints into row order (ARM only)
+ ******************************************************************/
+void mixer_sort(MIXER_POINT *points, unsigned numPoints);
+
+/*!****************************************************************
+ * @brief  Returns the number of rows of a sorted crosspoint list
+ ******************************************************************/
+unsigned mixer_rows(const MIXER_POINT *points, unsigned numPoints);
+
+/*!****************************************************************
+ * @brief  Returns the number of bytes required for a CSR matrix
+ ******************************************************************/
+size_t mixer_size(unsigned numRows, unsigned numTaps);
+
+/*!****************************************************************
+ * @brief  Builds a CSR matrix from a sorted crosspoint list (ARM only)
+ * @param [in]  mem        At least mixer_size() bytes
+ * @param [in]  points     Crosspoints sorted with mixer_sort()
+ * @param [in]  numPoints  Number of crosspoints
+ * @return The matrix
+ ******************************************************************/
+MIXER_MATRIX *mixer_build(void *mem, const MIXER_POINT *points,
+    unsigned numPoints);
+
+/*!****************************************************************
+ * @brief  Attach SHARC0 to a new matrix
+ * @param [in]  mm  CSR matrix or NULL to stop mixing
+ * @return Returns false if the matrix is malformed
+ ******************************************************************/
+bool mixer_attach(MIXER_MATRIX *mm);
+
+/*!****************************************************************
+ * @brief  Returns the matrix SHARC0 is attached to
+ ******************************************************************/
+MIXER_MATRIX *mixer_get(void);
+
+/*!****************************************************************
+ * @brief  Runs the matrix for one clock domain (SHARC0)
+ *
+ * Call once the clock domain has been routed.
+ *
+ * @param [in]  streamInfo   Stream table indexed by stream ID
+ * @param [in]  clockDomain  Clock domain just routed
+ ******************************************************************/
+void mixer_audio(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain);
+
+/*!****************************************************************
+ * @brief  Runs any attached or previously attached matrix (SHARC0)
+ * @param [in]  mm  Matrix, NULL does nothing
+ ******************************************************************/
+void mixer_run(const MIXER_MATRIX *mm, IPC_MSG_AUDIO **streamInfo,
+    uint8_t clockDomain);
+
+/*!****************************************************************
+ * @brief  Returns the stream ID for a stream name such as "usb_rx"
+ *         (case insensitive) or IPC_STREAMID_UNKNOWN.  Shared by the
+ *         matrix files and the shell commands.
+ ******************************************************************/
+int mixer_stream_id(const char *name);
+
+/*!****************************************************************
+ * @brief  Returns the matrix file name of a stream
+ ******************************************************************/
+const char *mixer_stream_name(int streamID);
+
+/*!****************************************************************
+ * @brief  Parses one matrix file line
+ ******************************************************************/
+MIXER_PARSE mixer_parse(const char *line, MIXER_POINT *point);
+
+/*!****************************************************************
+ * @brief  Formats a crosspoint as a matrix file line (no newline)
+ ******************************************************************/
+void mixer_format(const MIXER_POINT *point, char *buf, size_t size);
+
+/*!****************************************************************
+ * @brief  Converts a linear gain to tenths of a dB
+ ******************************************************************/
+int mixer_db10(float gain);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
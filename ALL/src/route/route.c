@@ -0,0 +1,301 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "route.h"
+#include "route_copy.h"
+
+static bool routeOffload = true;
+static unsigned routeOffloaded = 0;
+
+/*
+ * All audio SPORT interrupts (CODEC, SPDIF, A2B) have been hardware aligned
+ * at startup by gating their respective bit clocks until all
+ * SPORTs have been configured then turning on all clocks at once.  The
+ * SPORTs count down exactly 1 frame of bit clocks before starting. This
+ * is initiated on the ARM side in init.c -> enable_sport_mclk()
+ *
+ * The USB RX/TX, WAV src/sink, and RTP sink piggy-back off of their
+ * associated clock domain to function like time aligned SPORTs.
+ *
+ */
+bool route_new_audio(IPC_MSG_AUDIO **streamInfo, IPC_MSG_AUDIO *audio)
+{
+    bool clear = false;
+    bool unknown = false;
+
+    switch (audio->streamID) {
+        case IPC_STREAMID_CODEC_IN:
+            break;
+        case IPC_STREAMID_CODEC_OUT:
+            clear = true;
+            break;
+        case IPC_STREAMID_SPDIF_IN:
+            break;
+        case IPC_STREAMID_SPDIF_OUT:
+            clear = true;
+            break;
+        case IPC_STREAMID_A2B_IN:
+            break;
+        case IPC_STREAMID_A2B_OUT:
+            clear = true;
+            break;
+        case IPC_STREAMID_MIC_IN:
+            break;
+        case IPC_STREAMID_USB_RX:
+            break;
+        case IPC_STREAMID_USB_TX:
+            clear = true;
+            break;
+        case IPC_STREAM_ID_WAVE_SRC:
+            break;
+        case IPC_STREAM_ID_WAVE_SINK:
+            clear = true;
+            break;
+        case IPC_STREAM_ID_RTP_IN:
+            break;
+        case IPC_STREAM_ID_RTP_OUT:
+            clear = true;
+            break;
+        default:
+            unknown = true;
+            break;
+    }
+
+    if (!unknown) {
+        streamInfo[audio->streamID] = audio;
+        if (clear) {
+            memset(audio->data, 0,
+                audio->numChannels * audio->numFrames * audio->wordSize);
+        }
+    }
+
+    return(!unknown);
+}
+
+bool route_sink(uint8_t streamID)
+{
+    switch (streamID) {
+        case IPC_STREAMID_CODEC_OUT:
+        case IPC_STREAMID_SPDIF_OUT:
+        case IPC_STREAMID_A2B_OUT:
+        case IPC_STREAMID_USB_TX:
+        case IPC_STREAM_ID_WAVE_SINK:
+        case IPC_STREAM_ID_RTP_OUT:
+            return(true);
+        default:
+            return(false);
+    }
+}
+
+void route_offload(bool enable)
+{
+    routeOffload = enable;
+}
+
+unsigned route_offloaded(void)
+{
+    return(routeOffloaded);
+}
+
+/*
+ * Returns true if both ends of a route are registered in 'clockDomain'
+ * and compatible.
+ */
+static bool route_streams(ROUTE_INFO *route, IPC_MSG_AUDIO **streamInfo,
+    uint8_t clockDomain, IPC_MSG_AUDIO **srcPtr, IPC_MSG_AUDIO **sinkPtr)
+{
+    IPC_MSG_AUDIO *src, *sink;
+
+    if (route->srcID == IPC_STREAMID_UNKNOWN) {
+        return(false);
+    }
+    if (route->sinkID == IPC_STREAMID_UNKNOWN) {
+        return(false);
+    }
+
+    src = streamInfo[route->srcID];
+    sink = streamInfo[route->sinkID];
+
+    if ((src == NULL) || (sink == NULL)) {
+        return(false);
+    }
+
+    if (src->clockDomain != clockDomain) {
+        return(false);
+    }
+    if (sink->clockDomain != clockDomain) {
+        return(false);
+    }
+
+#if 1
+    if (src->numFrames != sink->numFrames) {
+        return(false);
+    }
+    if (src->wordSize != sink->wordSize) {
+        return(false);
+    }
+    if (src->wordSize != sizeof(int32_t)) {
+        return(false);
+    }
+    if (route->srcOffset >= src->numChannels) {
+        return(false);
+    }
+    if (route->sinkOffset >= sink->numChannels) {
+        return(false);
+    }
+#endif
+
+    *srcPtr = src;
+    *sinkPtr = sink;
+
+    return(true);
+}
+
+/*
+ * Later routes overwrite earlier ones, so a copy can only run
+ * alongside the core if no other route writes any of its sink
+ * channels.
+ */
+static bool route_exclusive(IPC_MSG_ROUTING *routeInfo, unsigned idx)
+{
+    ROUTE_INFO *route, *other;
+    unsigned i;
+
+    route = &routeInfo->routes[idx];
+
+    for (i = 0; i < routeInfo->numRoutes; i++) {
+        other = &routeInfo->routes[i];
+        if ((i == idx) || (other->srcID == IPC_STREAMID_UNKNOWN)) {
+            continue;
+        }
+        if (other->sinkID != route->sinkID) {
+            continue;
+        }
+        if ((other->sinkOffset < (route->sinkOffset + route->channels)) &&
+            (route->sinkOffset < (other->sinkOffset + other->channels))) {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+#if defined(__ADSP21000__)
+#pragma optimize_for_speed
+#endif
+void route_audio(IPC_MSG_ROUTING *routeInfo, IPC_MSG_AUDIO **streamInfo,
+    uint8_t clockDomain)
+{
+    bool offloaded[UINT8_MAX + 1];
+    ROUTE_INFO *route;
+    IPC_MSG_AUDIO *src, *sink, *stream;
+    uint8_t channels;
+    int32_t *in, *out;
+    uint8_t inChannel, outChannel;
+    unsigned frame;
+    unsigned channel;
+    int32_t sample;
+    unsigned i;
+    uint8_t attenuationShift;
+
+    routeOffloaded = 0;
+
+    if (routeInfo == NULL) {
+        return;
+    }
+
+    /* Hand the plain copies to the copy engine */
+    memset(offloaded, 0, routeInfo->numRoutes * sizeof(offloaded[0]));
+    if (routeOffload) {
+        for (i = 0; i < routeInfo->numRoutes; i++) {
+            route = &routeInfo->routes[i];
+            if (!route_streams(route, streamInfo, clockDomain, &src, &sink)) {
+                continue;
+            }
+            if ((route->attenuation / 6) != 0) {
+                continue;
+            }
+            if ((route->srcOffset + route->channels) > src->numChannels) {
+                continue;
+            }
+            if ((route->sinkOffset + route->channels) > sink->numChannels) {
+                continue;
+            }
+            if ((route->channels * src->numFrames) < ROUTE_COPY_MIN_SAMPLES) {
+                continue;
+            }
+            if (!route_exclusive(routeInfo, i)) {
+                continue;
+            }
+            offloaded[i] = route_copy_add(
+                sink->data + route->sinkOffset, sink->numChannels,
+                src->data + route->srcOffset, src->numChannels,
+                route->channels, src->numFrames);
+            if (offloaded[i]) {
+                routeOffloaded += route->channels * src->numFrames;
+            }
+        }
+        route_copy_start();
+    }
+
+    /* Run all remaining routes associated with this clock domain */
+    for (i = 0; i < routeInfo->numRoutes; i++) {
+
+        if (offloaded[i]) {
+            continue;
+        }
+
+        route = &routeInfo->routes[i];
+
+        if (!route_streams(route, streamInfo, clockDomain, &src, &sink)) {
+            continue;
+        }
+
+        inChannel = route->srcOffset;
+        outChannel = route->sinkOffset;
+
+        channels = route->channels;
+        in = src->data + inChannel;
+        out = sink->data + outChannel;
+
+        attenuationShift = route->attenuation / 6;
+
+        for (frame = 0; frame < src->numFrames; frame++) {
+            for (channel = 0; channel < channels; channel++) {
+                if ((outChannel + channel) < sink->numChannels) {
+                    if ((inChannel + channel) < src->numChannels) {
+                        sample = *(in + channel);
+                    } else {
+                        sample = 0;
+                    }
+                    *(out + channel) = sample >> attenuationShift;
+                }
+            }
+            in += src->numChannels;
+            out += sink->numChannels;
+        }
+
+    }
+
+    /* The sinks must be complete before they are released */
+    route_copy_wait();
+
+    /* Invalidate all streams associated with this clock domain */
+    for (i = 0; i < IPC_STREAM_ID_MAX; i++) {
+        stream = streamInfo[i];
+        if (stream && (stream->clockDomain == clockDomain)) {
+            streamInfo[i] = NULL;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Clock domain audio router
+ *
+ *   Portable core of the SHARC0 audio router.  Audio stream messages
+ *   are registered as they arrive and all routes belonging to a clock
+ *   domain are run once every stream in that domain has been
+ *   registered.  Plain copies are offloaded to a target specific copy
+ *   engine (route_copy.h), everything else contains no target
+ *   specific code so it can also be built into the host simulation.
+ *
+ * @file      route.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _route_h
+#define _route_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ipc.h"
+
+/*!****************************************************************
+ * @brief  Every ROUTE_CALIBRATE_BLOCKS'th block of a clock domain is
+ *         routed by the core alone to measure the cycles the bulk
+ *         copy backend saves
+ ******************************************************************/
+#ifndef ROUTE_CALIBRATE_BLOCKS
+#define ROUTE_CALIBRATE_BLOCKS   (100)
+#endif
+
+/*!****************************************************************
+ * @brief  Registers a newly arrived audio stream.
+ *
+ * Sink streams are cleared so unrouted channels play silence.
+ *
+ * @param [in]  streamInfo  Stream table indexed by stream ID
+ * @param [in]  audio       Audio stream message payload
+ *
+ * @return Returns true if the stream ID was known and registered.
+ ******************************************************************/
+bool route_new_audio(IPC_MSG_AUDIO **streamInfo, IPC_MSG_AUDIO *audio);
+
+/*!****************************************************************
+ * @brief  Returns true for sink (output) stream IDs
+ ******************************************************************/
+bool route_sink(uint8_t streamID);
+
+/*!****************************************************************
+ * @brief  Runs all routes associated with a clock domain.
+ *
+ * Every registered stream in the clock domain is released from
+ * 'streamInfo' on return.
+ *
+ * @param [in]  routeInfo    Routing table, may be NULL
+ * @param [in]  streamInfo   Stream table indexed by stream ID
+ * @param [in]  clockDomain  Clock domain to route
+ ******************************************************************/
+void route_audio(IPC_MSG_ROUTING *routeInfo, IPC_MSG_AUDIO **streamInfo,
+    uint8_t clockDomain);
+
+/*!****************************************************************
+ * @brief  Enables or disables the bulk copy backend (route_copy.h)
+ *
+ * While disabled every route is run by the core.  Enabled by
+ * default.
+ ******************************************************************/
+void route_offload(bool enable);
+
+/*!****************************************************************
+ * @brief  Returns the number of samples the last route_audio() call
+ *         handed to the bulk copy backend
+ ******************************************************************/
+unsigned route_offloaded(void);
+
+#endif
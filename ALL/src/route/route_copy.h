@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Bulk copy backend of the audio router
+ *
+ *   route_audio() hands routes that are plain copies (no attenuation,
+ *   every channel present in both streams, no other route writing the
+ *   same sink channels) to a copy engine and only moves the remaining
+ *   samples with the core.  Each copy is a 2D transfer of 'channels'
+ *   words per frame over 'frames' frames with independent source and
+ *   destination frame strides.
+ *
+ *   The router queues all copies of a clock domain, starts them
+ *   before running its own routes and waits for them before releasing
+ *   the domain's streams.  The engine is target specific, SHARC0 uses
+ *   MDMA (route_mdma.c) and the host simulation an emulation.
+ *
+ * @file      route_copy.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _route_copy_h
+#define _route_copy_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!****************************************************************
+ * @brief  Routes moving fewer samples per block stay on the core
+ * Below this size queueing the copy costs the core about as much as
+ * doing it.
+ ******************************************************************/
+#ifndef ROUTE_COPY_MIN_SAMPLES
+#define ROUTE_COPY_MIN_SAMPLES   (64)
+#endif
+
+/*!****************************************************************
+ * @brief  Queues one 2D copy
+ *
+ * @param [in]  out        First destination word
+ * @param [in]  outStride  Destination frame stride in words
+ * @param [in]  in         First source word
+ * @param [in]  inStride   Source frame stride in words
+ * @param [in]  channels   Words per frame
+ * @param [in]  frames     Number of frames
+ *
+ * @return Returns false if the copy could not be queued, in which
+ *         case the caller must copy it itself.
+ ******************************************************************/
+bool route_copy_add(int32_t *out, unsigned outStride, const int32_t *in,
+    unsigned inStride, unsigned channels, unsigned frames);
+
+/*!****************************************************************
+ * @brief  Starts all queued copies
+ ******************************************************************/
+void route_copy_start(void);
+
+/*!****************************************************************
+ * @brief  Waits for all started copies to complete
+ *
+ * Empties the queue.  Returns immediately if nothing was queued.
+ * The copies are complete on return even if the engine failed; the
+ * backend then finishes them with the core.
+ ******************************************************************/
+void route_copy_wait(void);
+
+#endif
@@ -23,6 +23,7 @@
 #include "sae_lock.h"
 #include "sae_alloc.h"
 #include "sae_util.h"
+#include "trace.h"
 
 /* Identify the entire MCAPI L2 memory region.
  *
@@ -99,9 +100,8 @@ SAE_RESULT sae_initialize(SAE_CONTEXT **contextPtr, SAE_CORE_IDX coreIdx, bool i
     if (ipcMaster) {
         SAE_MEMSET(saeSharcArmIPC, 0, sizeof(*saeSharcArmIPC));
         saeSharcArmIPC->lock = SAE_SHARC_ARM_IPC_UNLOCKED;
-        sae_heapInit(saeSharcArmIPC->heap, MCAPI_SIZE - sizeof(*saeSharcArmIPC) + 1);
-    } else {
-        sae_heapInit(saeSharcArmIPC->heap, 0);
+        sae_heapInit(SAE_POOL_L2, saeSharcArmIPC->heap,
+            MCAPI_SIZE - sizeof(*saeSharcArmIPC) + 1);
     }
 
     /* Get a reference to the global context */
@@ -132,12 +132,13 @@ void *sae_getMsgBufferPayload(SAE_MSG_BUFFER *msg)
 }
 
 
-SAE_MSG_BUFFER *sae_createMsgBuffer(SAE_CONTEXT *context, size_t size, void **payload)
+SAE_MSG_BUFFER *sae_createMsgBuffer(SAE_CONTEXT *context, size_t size,
+    SAE_ALLOC_POLICY policy, void **payload)
 {
     SAE_MSG_BUFFER *msg = NULL;
 
     /* Allocate a new message */
-    msg = sae_safeMalloc(sizeof(*msg) + size);
+    msg = sae_safeMalloc(policy, sizeof(*msg) + size);
 
     /* Initialize the new message buffer */
     if (msg) {
@@ -263,6 +264,8 @@ SAE_RESULT sae_sendMsgBuffer(SAE_CONTEXT *context, SAE_MSG_BUFFER *msg,
 {
     SAE_RESULT result = SAE_RESULT_OK;
 
+    TRACE_INSTANT(TRACE_ID_SAE_SEND, dstCoreIdx);
+
     /* Get an exclusive lock on the IPC area */
     sae_lockIpc();
 
@@ -299,11 +302,32 @@ SAE_RESULT sae_registerEventCallback(SAE_CONTEXT *context,
     return(SAE_RESULT_OK);
 }
 
-SAE_RESULT sae_heapInfo(SAE_CONTEXT *context, SAE_HEAP_INFO *heapInfo)
+SAE_RESULT sae_addPool(SAE_CONTEXT *context, SAE_POOL pool,
+    void *memory, size_t size)
+{
+    if ((pool == SAE_POOL_L2) || (pool >= SAE_POOL_MAX)) {
+        return(SAE_RESULT_ERROR);
+    }
+    if ((memory == NULL) || (size < SAE_POOL_MIN_SIZE)) {
+        return(SAE_RESULT_ERROR);
+    }
+
+    sae_lockIpc();
+    sae_heapInit(pool, memory, size);
+    sae_unLockIpc();
+
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_heapInfo(SAE_CONTEXT *context, SAE_POOL pool,
+    SAE_HEAP_INFO *heapInfo)
 {
     SAE_RESULT result;
     bool ok;
-    ok = sae_safeHeapInfo(heapInfo);
+    if ((pool >= SAE_POOL_MAX) || (saeSharcArmIPC->pools[pool].start == NULL)) {
+        return(SAE_RESULT_ERROR);
+    }
+    ok = sae_safeHeapInfo(pool, heapInfo);
     result = ok ? SAE_RESULT_OK : SAE_RESULT_CORRUPT_HEAP;
     return(result);
 }
@@ -61,6 +61,30 @@ typedef struct _SAE_HEAP_INFO {
     size_t maxContigFreeSize;
 } SAE_HEAP_INFO;
 
+/*!****************************************************************
+ * @brief SHARC Audio Engine shared memory pools
+ *
+ * The L2 pool is always present and covers the MCAPI L2 region.
+ * The SDRAM pool is optional and is added by the IPC master with
+ * sae_addPool().
+ ******************************************************************/
+typedef enum _SAE_POOL {
+    SAE_POOL_L2 = 0,            /**< Fast shared L2 memory */
+    SAE_POOL_SDRAM,             /**< Uncached shared SDRAM */
+    SAE_POOL_MAX
+} SAE_POOL;
+
+/*!****************************************************************
+ * @brief SHARC Audio Engine message buffer allocation policy
+ *
+ * Each policy prefers one pool and falls back to the other when the
+ * preferred pool is absent or exhausted.
+ ******************************************************************/
+typedef enum _SAE_ALLOC_POLICY {
+    SAE_ALLOC_FAST = 0,         /**< Latency critical (audio), L2 first */
+    SAE_ALLOC_BULK              /**< Large or control buffers, SDRAM first */
+} SAE_ALLOC_POLICY;
+
 /*!****************************************************************
  * @brief SHARC Audio Engine result codes
  ******************************************************************/
@@ -166,21 +190,46 @@ SAE_RESULT sae_unInitialize(SAE_CONTEXT **contextPtr);
 
 
 /*!****************************************************************
- * @brief Check the status of the SAE heap
+ * @brief Add a shared memory pool
+ *
+ * This function adds a memory pool to the SAE heap.  It must only
+ * be called on the IPC master core after sae_initialize() and
+ * before any other core calls sae_initialize().
+ *
+ * The memory must be uncached and at the same address on all
+ * participating cores.
+ *
+ * This function is not thread safe.
  *
- * This function gathers statistics about the SAE heap.  It can 
+ * @param [in]  context   A pointer to an SAE context
+ * @param [in]  pool      Pool to add (SAE_POOL_L2 is reserved)
+ * @param [in]  memory    Start of the pool memory
+ * @param [in]  size      Size of the pool memory in bytes
+ *
+ * @return Returns SAE_RESULT_OK if successful, otherwise
+ *         an error.
+ ******************************************************************/
+SAE_RESULT sae_addPool(SAE_CONTEXT *context, SAE_POOL pool,
+    void *memory, size_t size);
+
+/*!****************************************************************
+ * @brief Check the status of an SAE heap pool
+ *
+ * This function gathers statistics about one SAE heap pool.  It can
  * take some time to execute and may result in excessive latency 
  * in time critical systems.  Use with caution.
  *
  * This function is thread safe.
  *
  * @param [in]  context   A pointer to an SAE context
+ * @param [in]  pool      The pool to report
  * @param [in]  heapInfo  A pointer to a SAE_HEAP_INFO struct
  *
- * @return Returns SAE_RESULT_OK if successful, otherwise
- *         an error.
+ * @return Returns SAE_RESULT_OK if successful, SAE_RESULT_ERROR
+ *         if the pool is not configured, otherwise an error.
  ******************************************************************/
-SAE_RESULT sae_heapInfo(SAE_CONTEXT *context, SAE_HEAP_INFO *heapInfo);
+SAE_RESULT sae_heapInfo(SAE_CONTEXT *context, SAE_POOL pool,
+    SAE_HEAP_INFO *heapInfo);
 
 
 /*!****************************************************************
@@ -190,10 +239,15 @@ SAE_RESULT sae_heapInfo(SAE_CONTEXT *context, SAE_HEAP_INFO *heapInfo);
  * the given size.  The returned message buffer is pre-initialized with
  * a reference count of 1.
  *
+ * Audio data buffers should use SAE_ALLOC_FAST so they stay in L2.
+ * Control messages and large, rarely touched buffers should use
+ * SAE_ALLOC_BULK so they don't fragment L2.
+ *
  * This function is thread safe.
  *
  * @param [in]  context    A pointer to an SAE context
  * @param [in]  size       The size of the buffer payload to allocate
+ * @param [in]  policy     Allocation policy
  * @param [out] payload    Returns a pointer to the payload area.  Can be
  *                         NULL if no return value is needed.
  *
@@ -201,7 +255,7 @@ SAE_RESULT sae_heapInfo(SAE_CONTEXT *context, SAE_HEAP_INFO *heapInfo);
  *         created SAE_MSG_BUFFER.
  ******************************************************************/
 SAE_MSG_BUFFER *sae_createMsgBuffer(SAE_CONTEXT *context, size_t size,
-    void **payload);
+    SAE_ALLOC_POLICY policy, void **payload);
 
 /*!****************************************************************
  * @brief Gets the size of a message buffer in bytes.
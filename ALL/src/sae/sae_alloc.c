@@ -51,9 +51,11 @@
 #define ALIGN_UP(size, align) (((size) + ((align)-1)) & ~((align)-1))
 #define ALIGN_DN(size, align) ((size) & ~((align)-1))
 
-static char *sae_heap_start;
-
-int sae_alloc_init(void *memory, size_t size)
+/*
+ * Initialize a heap over 'memory' and return the address of its first
+ * block.  The end of heap marker is returned in 'heapEnd'.
+ */
+static char *sae_alloc_init(void *memory, size_t size, char **heapEnd)
 {
     char *start, *end;
 
@@ -63,13 +65,6 @@ int sae_alloc_init(void *memory, size_t size)
     /* Reserve space at the top for specialized block markers */
     start += ALIGN_UP(2*ALIGNMENT, ALIGNMENT);
 
-    /* Size of 0 indicates that this is not the IPC master and
-     * that only the heap start address should be stored */
-    if (size == 0) {
-        sae_heap_start = start;
-        return 0;
-    }
-
     /* Align top downward, but point to end of aligned section */
     end = (char *)ALIGN_DN((uintptr_t)memory + size, ALIGNMENT);
 
@@ -88,12 +83,12 @@ int sae_alloc_init(void *memory, size_t size)
     /* Allocate a single free block */
     MARK_BLK(start, size, 0);
 
-    sae_heap_start = start;
+    *heapEnd = end;
 
-    return 0;
+    return(start);
 }
 
-void *sae_alloc_malloc(size_t size)
+static void *sae_alloc_malloc(char *heap, size_t size)
 {
     char *ptr = NULL;
     char *next = NULL;
@@ -101,7 +96,7 @@ void *sae_alloc_malloc(size_t size)
 
     if (size > 0) {
         size = ALIGN_UP(BSIZE(size), ALIGNMENT);
-        ptr = sae_heap_start;
+        ptr = heap;
         while (BLK_SIZE(ptr) > 0) {
             if (BLK_FREE(ptr) && (BLK_SIZE(ptr) >= size)) {
                 break;
@@ -151,16 +146,16 @@ static void *sae_alloc_coalesce(char *ptr)
 }
 
 
-void sae_alloc_free(void *ptr)
+static void sae_alloc_free(void *ptr)
 {
     MARK_BLK((char *)ptr, BLK_SIZE((char *)ptr), 0);
     sae_alloc_coalesce(ptr);
 }
 
-bool sae_alloc_checkheap(void)
+static bool sae_alloc_checkheap(char *heap)
 {
-    char *ptr = sae_heap_start;
-    char *prev = PREV(sae_heap_start);
+    char *ptr = heap;
+    char *prev = PREV(heap);
 
     if ((BLK_SIZE(prev) != ALIGNMENT) || BLK_FREE(prev)) {
         return(false);
@@ -181,18 +176,34 @@ bool sae_alloc_checkheap(void)
 }
 
 #include "sae_util.h"
+#include "sae_ipc.h"
+#include "sae_alloc.h"
+
+/* Pool search order for each allocation policy */
+static const SAE_POOL sae_policyPools[][SAE_POOL_MAX] = {
+    { SAE_POOL_L2, SAE_POOL_SDRAM },    /* SAE_ALLOC_FAST */
+    { SAE_POOL_SDRAM, SAE_POOL_L2 }     /* SAE_ALLOC_BULK */
+};
 
-bool sae_safeHeapInfo(SAE_HEAP_INFO *heapInfo)
+static char *sae_poolStart(SAE_POOL pool)
 {
-    char *ptr = sae_heap_start;
+    if ((unsigned)pool >= SAE_POOL_MAX) {
+        return(NULL);
+    }
+    return(saeSharcArmIPC->pools[pool].start);
+}
+
+bool sae_safeHeapInfo(SAE_POOL pool, SAE_HEAP_INFO *heapInfo)
+{
+    char *ptr = sae_poolStart(pool);
     size_t size;
     bool ok;
 
-    if (heapInfo == NULL) {
+    if ((heapInfo == NULL) || (ptr == NULL)) {
         return(false);
     }
     sae_lockIpc();
-    ok = sae_alloc_checkheap();
+    ok = sae_alloc_checkheap(ptr);
     if (ok) {
         memset(heapInfo, 0, sizeof(*heapInfo));
         while (BLK_SIZE(ptr) > 0) {
@@ -217,19 +228,27 @@ bool sae_safeHeapInfo(SAE_HEAP_INFO *heapInfo)
 
 bool sae_safeHeapCheck(void)
 {
-    bool ok;
+    char *heap;
+    bool ok = true;
+    int i;
+
     sae_lockIpc();
-    ok = sae_alloc_checkheap();
+    for (i = 0; i < SAE_POOL_MAX; i++) {
+        heap = sae_poolStart((SAE_POOL)i);
+        if (heap && !sae_alloc_checkheap(heap)) {
+            ok = false;
+        }
+    }
     sae_unLockIpc();
     return(ok);
 }
 
-void *sae_safeMalloc(size_t size)
+void *sae_safeMalloc(SAE_ALLOC_POLICY policy, size_t size)
 {
     void *mem;
 
     sae_lockIpc();
-    mem = sae_alloc_malloc(size);
+    mem = sae_malloc(policy, size);
     sae_unLockIpc();
 
     return(mem);
@@ -242,17 +261,39 @@ void sae_safeFree(void *mem)
     sae_unLockIpc();
 }
 
-void *sae_malloc(size_t size)
+void *sae_malloc(SAE_ALLOC_POLICY policy, size_t size)
 {
-    return(sae_alloc_malloc(size));
+    const SAE_POOL *pools = sae_policyPools[policy == SAE_ALLOC_BULK];
+    void *mem = NULL;
+    char *heap;
+    int i;
+
+    for (i = 0; (i < SAE_POOL_MAX) && (mem == NULL); i++) {
+        heap = sae_poolStart(pools[i]);
+        if (heap) {
+            mem = sae_alloc_malloc(heap, size);
+        }
+    }
+
+    return(mem);
 }
 
+/* Blocks never coalesce across pools so the owning pool isn't needed */
 void sae_free(void *mem)
 {
     sae_alloc_free(mem);
 }
 
-int sae_heapInit(void *memory, size_t size)
+int sae_heapInit(SAE_POOL pool, void *memory, size_t size)
 {
-    return(sae_alloc_init(memory, size));
+    SAE_POOL_DESC *desc;
+
+    if ((unsigned)pool >= SAE_POOL_MAX) {
+        return(-1);
+    }
+
+    desc = &saeSharcArmIPC->pools[pool];
+    desc->start = sae_alloc_init(memory, size, &desc->end);
+
+    return(0);
 }
@@ -16,11 +16,15 @@
 #include <stddef.h>
 #include <stdbool.h>
 
-int sae_heapInit(void *memory, size_t size);
-void *sae_safeMalloc(size_t size);
+/* Smallest useful pool */
+#define SAE_POOL_MIN_SIZE  (64)
+
+int sae_heapInit(SAE_POOL pool, void *memory, size_t size);
+void *sae_safeMalloc(SAE_ALLOC_POLICY policy, size_t size);
 void sae_safeFree(void *mem);
-void *sae_malloc(size_t size);
+void *sae_malloc(SAE_ALLOC_POLICY policy, size_t size);
 void sae_free(void *mem);
-bool sae_safeHeapInfo(SAE_HEAP_INFO *heapInfo);
+bool sae_safeHeapInfo(SAE_POOL pool, SAE_HEAP_INFO *heapInfo);
+bool sae_safeHeapCheck(void);
 
 #endif
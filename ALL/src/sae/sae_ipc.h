@@ -25,12 +25,19 @@ typedef struct _SAE_IPC_MSG_QUEUE {
     void *queue[IPC_MAX_MSG_QUEUE_SIZE];
 } SAE_IPC_MSG_QUEUE;
 
+/* Shared heap pool.  'start' is NULL if the pool is not configured. */
+typedef struct _SAE_POOL_DESC {
+    char *start;
+    char *end;
+} SAE_POOL_DESC;
+
 #pragma pack(1)
 typedef struct _SAE_SHARC_ARM_IPC {
     uint32_t lock;
     int32_t idx2trigger[IPC_MAX_CORES];
     SAE_IPC_MSG_QUEUE msgQueues[IPC_MAX_CORES];
     SAE_STREAM *streamList;
+    SAE_POOL_DESC pools[SAE_POOL_MAX];
     uint8_t heap[1];
 } SAE_SHARC_ARM_IPC;
 #pragma pack()
@@ -26,6 +26,7 @@
 #include "sae_priv.h"
 #include "sae_irq.h"
 #include "sae_ipc.h"
+#include "trace.h"
 
 static void sae_interruptHandler(uint32_t iid, void *handlerArg)
 {
@@ -33,6 +34,8 @@ static void sae_interruptHandler(uint32_t iid, void *handlerArg)
     SAE_MSG_BUFFER *buffer;
     SAE_RESULT result;
 
+    TRACE_BEGIN(TRACE_ID_SAE_IRQ, iid);
+
     do {
         result = sae_receiveMsgBuffer(context, &buffer);
         if (buffer) {
@@ -50,6 +53,8 @@ static void sae_interruptHandler(uint32_t iid, void *handlerArg)
             }
         }
     } while (result == SAE_RESULT_OK);
+
+    TRACE_END(TRACE_ID_SAE_IRQ, iid);
 }
 
 SAE_RESULT sae_raiseInterrupt(SAE_CONTEXT *context, int8_t coreIdx)
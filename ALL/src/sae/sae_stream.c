@@ -88,7 +88,7 @@ SAE_RESULT sae_registerStream(SAE_CONTEXT *context, char *streamName, SAE_STREAM
     }
 
     /* Allocate and add the stream to the list */
-    stream = sae_malloc(sizeof(*stream));
+    stream = sae_malloc(SAE_ALLOC_BULK, sizeof(*stream));
     if (stream == NULL) {
         sae_unLockIpc();
         return(SAE_RESULT_NO_MEM);
@@ -97,7 +97,7 @@ SAE_RESULT sae_registerStream(SAE_CONTEXT *context, char *streamName, SAE_STREAM
     /* Initialize the new stream */
     SAE_MEMSET(stream, 0, sizeof(*stream));
     len = SAE_STRLEN(streamName) + 1;
-    stream->streamInfo.streamName = sae_malloc(len);
+    stream->streamInfo.streamName = sae_malloc(SAE_ALLOC_BULK, len);
     SAE_MEMSET(stream->streamInfo.streamName, 0, len);
     SAE_STRCPY(stream->streamInfo.streamName, streamName);
 
@@ -41,7 +41,7 @@ SAE_RESULT sae_broadcastEvent(SAE_CONTEXT *context, SAE_EVENT event, void *data,
     int i;
 
     /* Create a message buffer */
-    msg = sae_createMsgBuffer(context, len, &payload);
+    msg = sae_createMsgBuffer(context, len, SAE_ALLOC_BULK, &payload);
     if ((msg == NULL) || (payload == NULL)) {
         return(SAE_RESULT_ERROR);
     }
@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "scene.h"
+#include "route.h"
+#include "mixer.h"
+
+/* Clock domains tracked, each fades over its own blocks */
+#define SCENE_DOMAINS  (8)
+
+/* Largest float below 2^31 */
+#define SCENE_CLIP     (2147483520.0f)
+
+static IPC_MSG_ROUTING *fadeRoutes = NULL;
+static const MIXER_MATRIX *fadeMatrix = NULL;
+static unsigned fadeBlocks = 0;
+static unsigned fadePos[SCENE_DOMAINS];
+static uint32_t fadeStarted = 0;
+static bool fadeActive = false;
+
+/* Previous state sinks of the clock domain being routed */
+static int32_t fadeSave[SCENE_FADE_WORDS];
+
+void scene_fade_start(IPC_MSG_ROUTING *routes, const MIXER_MATRIX *mm,
+    unsigned blocks)
+{
+    fadeRoutes = routes;
+    fadeMatrix = mm;
+    fadeBlocks = blocks;
+    memset(fadePos, 0, sizeof(fadePos));
+    fadeStarted = 0;
+    fadeActive = (blocks > 0);
+}
+
+bool scene_fading(void)
+{
+    return(fadeActive);
+}
+
+/*
+ * Returns the number of words of a sink stream in 'clockDomain' or
+ * zero if it is not one.  Both passes walk the sinks in stream ID
+ * order so they agree on where each one is saved.
+ */
+static unsigned scene_sink_words(IPC_MSG_AUDIO *audio, uint8_t streamID,
+    uint8_t clockDomain)
+{
+    if ((audio == NULL) || (audio->clockDomain != clockDomain)) {
+        return(0);
+    }
+    if (!route_sink(streamID) || (audio->wordSize != sizeof(int32_t))) {
+        return(0);
+    }
+
+    return(audio->numChannels * audio->numFrames);
+}
+
+void scene_fade_pre(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain)
+{
+    IPC_MSG_AUDIO *domainStreams[IPC_STREAM_ID_MAX];
+    IPC_MSG_AUDIO *audio;
+    unsigned offset, words;
+    unsigned i;
+
+    if (!fadeActive || (clockDomain >= SCENE_DOMAINS)) {
+        return;
+    }
+    fadeStarted |= 1u << clockDomain;
+
+    /*
+     * A domain that has faded all the way holds the new state while
+     * the domains that joined later catch up
+     */
+    if (fadePos[clockDomain] >= fadeBlocks) {
+        return;
+    }
+
+    /* route_audio() releases the streams it routes, run it on a copy */
+    memcpy(domainStreams, streamInfo, sizeof(domainStreams));
+    route_audio(fadeRoutes, domainStreams, clockDomain);
+    mixer_run(fadeMatrix, streamInfo, clockDomain);
+
+    offset = 0;
+    for (i = 0; i < IPC_STREAM_ID_MAX; i++) {
+        audio = streamInfo[i];
+        words = scene_sink_words(audio, i, clockDomain);
+        if ((words == 0) || ((offset + words) > SCENE_FADE_WORDS)) {
+            continue;
+        }
+        memcpy(&fadeSave[offset], audio->data, words * sizeof(int32_t));
+        memset(audio->data, 0, words * sizeof(int32_t));
+        offset += words;
+    }
+}
+
+/*
+ * out[] = prev[] + g * (out[] - prev[]) with 'g' stepping up every
+ * frame so it reaches one at the last frame of the last block
+ */
+#if defined(__ADSP21000__)
+#pragma optimize_for_speed
+#endif
+static void scene_blend(int32_t *out, const int32_t *prev,
+    unsigned channels, unsigned frames, unsigned pos)
+{
+    unsigned frame, channel;
+    float step, g, x, p;
+
+    step = 1.0f / (float)(fadeBlocks * frames);
+    g = (float)(pos * frames) * step;
+
+    for (frame = 0; frame < frames; frame++) {
+        g += step;
+#if defined(__ADSP21000__)
+#pragma SIMD_for
+#endif
+        for (channel = 0; channel < channels; channel++) {
+            p = (float)prev[channel];
+            x = p + g * ((float)out[channel] - p);
+            x = fminf(fmaxf(x, -SCENE_CLIP), SCENE_CLIP);
+            out[channel] = (int32_t)x;
+        }
+        out += channels;
+        prev += channels;
+    }
+}
+
+void scene_fade_post(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain)
+{
+    IPC_MSG_AUDIO *audio;
+    unsigned offset, words;
+    bool done;
+    unsigned i;
+
+    if (!fadeActive || (clockDomain >= SCENE_DOMAINS) ||
+        !(fadeStarted & (1u << clockDomain)) ||
+        (fadePos[clockDomain] >= fadeBlocks)) {
+        return;
+    }
+
+    offset = 0;
+    for (i = 0; i < IPC_STREAM_ID_MAX; i++) {
+        audio = streamInfo[i];
+        words = scene_sink_words(audio, i, clockDomain);
+        if ((words == 0) || ((offset + words) > SCENE_FADE_WORDS)) {
+            continue;
+        }
+        scene_blend(audio->data, &fadeSave[offset], audio->numChannels,
+            audio->numFrames, fadePos[clockDomain]);
+        offset += words;
+    }
+
+    /* Done once every clock domain that joined has faded all the way */
+    fadePos[clockDomain]++;
+    done = true;
+    for (i = 0; i < SCENE_DOMAINS; i++) {
+        if ((fadeStarted & (1u << i)) && (fadePos[i] < fadeBlocks)) {
+            done = false;
+        }
+    }
+    if (done) {
+        fadeActive = false;
+        fadeRoutes = NULL;
+        fadeMatrix = NULL;
+    }
+}
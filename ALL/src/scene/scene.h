@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Routing and mixer scenes
+ *
+ *   A scene is a snapshot of the routing table and the crosspoint
+ *   mixer matrix.  Scene files hold a SCENE_HEADER followed by
+ *   'numRoutes' SCENE_ROUTE and 'numPoints' MIXER_POINT records.
+ *
+ *   The ARM preloads a scene into a single IPC_TYPE_SCENE message in
+ *   SAE shared memory, so recalling it is one message no matter how
+ *   large the scene is.  SHARC0 switches its routes and matrix to the
+ *   scene at once and crossfades every sink from the previous state
+ *   to the new one, running both for the length of the fade.  The
+ *   fade is linear and sample accurate, every frame of every block
+ *   advances the gain.
+ *
+ * @file      scene.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _scene_h
+#define _scene_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ipc.h"
+#include "mixer.h"
+
+/*!****************************************************************
+ * @brief  Sink words saved per block during a fade (SHARC0)
+ * Sinks that do not fit switch without fading.
+ ******************************************************************/
+#ifndef SCENE_FADE_WORDS
+#define SCENE_FADE_WORDS         (8192)
+#endif
+
+/*!****************************************************************
+ * @brief  Default fade length in blocks
+ ******************************************************************/
+#ifndef SCENE_FADE_BLOCKS
+#define SCENE_FADE_BLOCKS        (48)
+#endif
+
+/*!****************************************************************
+ * @brief  Longest fade in blocks, what the scene file and message hold
+ ******************************************************************/
+#define SCENE_FADE_MAX           (UINT16_MAX)
+
+#define SCENE_MAGIC    (0x454E4353)
+#define SCENE_VERSION  (1)
+
+/*!****************************************************************
+ * @brief  Scene file header
+ ******************************************************************/
+#pragma pack(1)
+typedef struct _SCENE_HEADER {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t numRoutes;
+    uint16_t numPoints;
+    uint16_t fadeBlocks;
+} SCENE_HEADER;
+#pragma pack()
+
+/*!****************************************************************
+ * @brief  One used routing table entry
+ ******************************************************************/
+#pragma pack(1)
+typedef struct _SCENE_ROUTE {
+    uint8_t index;
+    ROUTE_INFO route;
+} SCENE_ROUTE;
+#pragma pack()
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!****************************************************************
+ * @brief  Start fading from a previous state (SHARC0)
+ *
+ * Call right after switching to the new routes and matrix.  A fade
+ * already in progress is abandoned.
+ *
+ * @param [in]  routes  Previous routing table, may be NULL
+ * @param [in]  mm      Previous mixer matrix, may be NULL
+ * @param [in]  blocks  Fade length, zero to switch at once
+ ******************************************************************/
+void scene_fade_start(IPC_MSG_ROUTING *routes, const MIXER_MATRIX *mm,
+    unsigned blocks);
+
+/*!****************************************************************
+ * @brief  Returns true while the previous state is still in use
+ ******************************************************************/
+bool scene_fading(void);
+
+/*!****************************************************************
+ * @brief  Runs the previous state for one clock domain (SHARC0)
+ *
+ * Call after the sources have been registered and before the clock
+ * domain is routed.  Routes and mixes the previous state into the
+ * sinks, saves them and clears them again for the new state.
+ *
+ * @param [in]  streamInfo   Stream table indexed by stream ID
+ * @param [in]  clockDomain  Clock domain about to be routed
+ ******************************************************************/
+void scene_fade_pre(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain);
+
+/*!****************************************************************
+ * @brief  Crossfades the sinks of one clock domain (SHARC0)
+ *
+ * Call once the clock domain has been routed and mixed.
+ *
+ * @param [in]  streamInfo   Stream table indexed by stream ID
+ * @param [in]  clockDomain  Clock domain just routed
+ ******************************************************************/
+void scene_fade_post(IPC_MSG_AUDIO **streamInfo, uint8_t clockDomain);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
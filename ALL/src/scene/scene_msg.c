@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "scene_msg.h"
+#include "scene.h"
+#include "mixer.h"
+
+static SAE_CONTEXT *msgContext = NULL;
+
+static IPC_MSG_ROUTING *routeInfo = NULL;
+
+/* Messages in use */
+static SAE_MSG_BUFFER *routingMsg = NULL;
+static SAE_MSG_BUFFER *mixerMsg = NULL;
+
+/* Messages the running fade started from */
+static SAE_MSG_BUFFER *fadeRoutingMsg = NULL;
+static SAE_MSG_BUFFER *fadeMixerMsg = NULL;
+
+/* Scene held until the running fade ends and what was sent after it */
+static SAE_MSG_BUFFER *scenePendingMsg = NULL;
+static SAE_MSG_BUFFER *routingPendingMsg = NULL;
+static SAE_MSG_BUFFER *mixerPendingMsg = NULL;
+
+/* Keeps a reference to 'buffer' in 'held', NULL just releases it */
+static void sceneHold(SAE_MSG_BUFFER **held, SAE_MSG_BUFFER *buffer)
+{
+    if (buffer) {
+        sae_refMsgBuffer(msgContext, buffer);
+    }
+    if (*held) {
+        sae_unRefMsgBuffer(msgContext, *held);
+    }
+    *held = buffer;
+}
+
+/* Releases the routes and matrix a scene fade started from */
+static void sceneFadeRelease(void)
+{
+    sceneHold(&fadeRoutingMsg, NULL);
+    sceneHold(&fadeMixerMsg, NULL);
+}
+
+static void routingSwitch(SAE_MSG_BUFFER *buffer)
+{
+    IPC_MSG *msg = (IPC_MSG *)sae_getMsgBufferPayload(buffer);
+
+    sceneHold(&routingMsg, buffer);
+    routeInfo = &msg->routes;
+    routeInfo->ack = routeInfo->generation;
+}
+
+static void mixerSwitch(SAE_MSG_BUFFER *buffer)
+{
+    IPC_MSG *msg = (IPC_MSG *)sae_getMsgBufferPayload(buffer);
+
+    if (mixer_attach((MIXER_MATRIX *)msg->mixer.matrix)) {
+        sceneHold(&mixerMsg, buffer);
+    }
+}
+
+/*
+ * The message holds a reference for the routes and one for the
+ * matrix, the ones it replaces are kept for the fade
+ */
+static void sceneSwitch(SAE_MSG_BUFFER *buffer)
+{
+    IPC_MSG *msg = (IPC_MSG *)sae_getMsgBufferPayload(buffer);
+    IPC_MSG_ROUTING *prevRoutes;
+    MIXER_MATRIX *prevMatrix;
+
+    prevRoutes = routeInfo;
+    prevMatrix = mixer_get();
+    if (!mixer_attach((MIXER_MATRIX *)((uint8_t *)msg + msg->scene.matrix))) {
+        return;
+    }
+    sceneFadeRelease();
+    fadeRoutingMsg = routingMsg;
+    fadeMixerMsg = mixerMsg;
+    sae_refMsgBuffer(msgContext, buffer);
+    sae_refMsgBuffer(msgContext, buffer);
+    routingMsg = buffer;
+    mixerMsg = buffer;
+    routeInfo = &msg->scene.routes;
+    routeInfo->ack = routeInfo->generation;
+    scene_fade_start(prevRoutes, prevMatrix, msg->scene.fadeBlocks);
+    if (!scene_fading()) {
+        sceneFadeRelease();
+    }
+}
+
+void scene_msg_init(SAE_CONTEXT *saeContext)
+{
+    msgContext = saeContext;
+}
+
+IPC_MSG_ROUTING *scene_msg_routes(void)
+{
+    return(routeInfo);
+}
+
+void scene_msg_routing(SAE_MSG_BUFFER *buffer)
+{
+    if (scenePendingMsg) {
+        sceneHold(&routingPendingMsg, buffer);
+    } else {
+        routingSwitch(buffer);
+    }
+}
+
+void scene_msg_mixer(SAE_MSG_BUFFER *buffer)
+{
+    if (scenePendingMsg) {
+        sceneHold(&mixerPendingMsg, buffer);
+    } else {
+        mixerSwitch(buffer);
+    }
+}
+
+void scene_msg_scene(SAE_MSG_BUFFER *buffer)
+{
+    /*
+     * Switching mid-fade would jump from the blend to the new fade's
+     * starting point and click
+     */
+    if (scene_fading()) {
+        sceneHold(&scenePendingMsg, buffer);
+        sceneHold(&routingPendingMsg, NULL);
+        sceneHold(&mixerPendingMsg, NULL);
+    } else {
+        sceneSwitch(buffer);
+    }
+}
+
+void scene_msg_block(void)
+{
+    if (scene_fading()) {
+        return;
+    }
+    sceneFadeRelease();
+
+    /* Then the routes and matrix sent after the held scene, in order */
+    if (scenePendingMsg) {
+        sceneSwitch(scenePendingMsg);
+        sceneHold(&scenePendingMsg, NULL);
+        if (routingPendingMsg) {
+            routingSwitch(routingPendingMsg);
+            sceneHold(&routingPendingMsg, NULL);
+        }
+        if (mixerPendingMsg) {
+            mixerSwitch(mixerPendingMsg);
+            sceneHold(&mixerPendingMsg, NULL);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Routing, mixer and scene message handling (SHARC0)
+ *
+ *   Keeps the IPC_TYPE_AUDIO_ROUTING, IPC_TYPE_MIXER and IPC_TYPE_SCENE
+ *   messages in use referenced and releases the ones they replace.
+ *   The routes and matrix a scene fades from stay referenced until the
+ *   fade ends.  A scene that arrives during a fade is held until it
+ *   ends, along with any routes and matrix sent after it, so a recall
+ *   never jumps from the blend.
+ *
+ *   Messages are handled between blocks so every switch is atomic.
+ *
+ * @file      scene_msg.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _scene_msg_h
+#define _scene_msg_h
+
+#include "ipc.h"
+#include "sae.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!****************************************************************
+ * @brief  Sets the SAE context the messages are referenced in
+ ******************************************************************/
+void scene_msg_init(SAE_CONTEXT *saeContext);
+
+/*!****************************************************************
+ * @brief  Routing table in use, NULL until the first one arrives
+ ******************************************************************/
+IPC_MSG_ROUTING *scene_msg_routes(void);
+
+/*!****************************************************************
+ * @brief  Handles an IPC_TYPE_AUDIO_ROUTING message
+ *
+ * Switches to the table and acknowledges it, or holds it behind a
+ * held scene.  Takes its own reference to 'buffer'.
+ ******************************************************************/
+void scene_msg_routing(SAE_MSG_BUFFER *buffer);
+
+/*!****************************************************************
+ * @brief  Handles an IPC_TYPE_MIXER message
+ *
+ * Switches to the matrix, or holds it behind a held scene.  Takes
+ * its own reference to 'buffer'.
+ ******************************************************************/
+void scene_msg_mixer(SAE_MSG_BUFFER *buffer);
+
+/*!****************************************************************
+ * @brief  Handles an IPC_TYPE_SCENE message
+ *
+ * Switches the routes and matrix together and starts the fade from
+ * the previous ones, or holds the scene until the running fade ends.
+ * A held scene replaces anything held before it.  Takes its own
+ * references to 'buffer'.
+ ******************************************************************/
+void scene_msg_scene(SAE_MSG_BUFFER *buffer);
+
+/*!****************************************************************
+ * @brief  Call after every routed block
+ *
+ * Once the fade has ended, releases the state it faded from and
+ * switches to a held scene.
+ ******************************************************************/
+void scene_msg_block(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
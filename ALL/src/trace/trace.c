@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Standard includes */
+#include <string.h>
+
+/* CCES includes */
+#include <sys/platform.h>
+
+/* Module includes */
+#include "trace.h"
+
+static TRACE_BUFFER * volatile traceBuffer = NULL;
+static unsigned traceCore = 0;
+
+static const char * const traceNames[TRACE_ID_MAX] = {
+    "none",
+    "sport_irq",
+    "sharc_audio",
+    "sae_send",
+    "sae_irq",
+    "route_audio",
+    "process_audio",
+    "task",
+    "user"
+};
+
+/*
+ * Reserve the next slot in this core's ring.  Each ring has a single
+ * writing core so this only needs to be atomic with respect to
+ * interrupts on the local core.
+ */
+static inline uint32_t trace_reserve(volatile uint32_t *head)
+{
+    uint32_t idx;
+#if defined(__ADSPARM__)
+    idx = __atomic_fetch_add(head, 1, __ATOMIC_RELAXED);
+#else
+    SAE_ENTER_CRITICAL();
+    idx = *head;
+    *head = idx + 1;
+    SAE_EXIT_CRITICAL();
+#endif
+    return(idx);
+}
+
+size_t trace_size(void)
+{
+    return(sizeof(TRACE_BUFFER) +
+        IPC_MAX_CORES * TRACE_EVENTS_PER_CORE * sizeof(TRACE_EVENT));
+}
+
+TRACE_BUFFER *trace_init(void *mem)
+{
+    TRACE_BUFFER *tb = (TRACE_BUFFER *)mem;
+
+    memset(tb, 0, sizeof(*tb));
+    tb->events = TRACE_EVENTS_PER_CORE;
+    tb->hz = TRACE_TIMESTAMP_HZ;
+    tb->magic = TRACE_MAGIC;
+
+    return(tb);
+}
+
+void trace_attach(TRACE_BUFFER *tb, unsigned coreIdx)
+{
+    if (tb && (tb->magic != TRACE_MAGIC)) {
+        return;
+    }
+    if (coreIdx >= IPC_MAX_CORES) {
+        return;
+    }
+    traceCore = coreIdx;
+    traceBuffer = tb;
+}
+
+TRACE_BUFFER *trace_buffer(void)
+{
+    return(traceBuffer);
+}
+
+void trace_start(void)
+{
+    TRACE_BUFFER *tb = traceBuffer;
+    unsigned i;
+
+    if (tb == NULL) {
+        return;
+    }
+
+    tb->enable = 0;
+    for (i = 0; i < IPC_MAX_CORES; i++) {
+        tb->head[i] = 0;
+    }
+    tb->enable = 1;
+}
+
+void trace_stop(void)
+{
+    TRACE_BUFFER *tb = traceBuffer;
+
+    if (tb) {
+        tb->enable = 0;
+    }
+}
+
+void trace_event(TRACE_ID id, TRACE_TYPE type, uint32_t arg)
+{
+    TRACE_BUFFER *tb = traceBuffer;
+    TRACE_EVENT *ev;
+    uint32_t idx;
+
+    if ((tb == NULL) || !tb->enable) {
+        return;
+    }
+
+    idx = trace_reserve(&tb->head[traceCore]);
+    idx &= TRACE_EVENTS_PER_CORE - 1;
+
+    ev = &tb->event[traceCore * TRACE_EVENTS_PER_CORE + idx];
+    ev->ts = TRACE_TIMESTAMP();
+    ev->id = id;
+    ev->type = type;
+    ev->arg = arg;
+}
+
+const char *trace_id_str(unsigned id)
+{
+    return((id < TRACE_ID_MAX) ? traceNames[id] : "unknown");
+}
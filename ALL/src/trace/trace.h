@@ -0,0 +1,189 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Cross-core event tracing
+ *
+ *   A single trace buffer is allocated by the ARM from the SAE shared
+ *   heap and handed to the SHARCs by IPC.  The buffer holds one event
+ *   ring per core.  Each core only ever writes its own ring so no
+ *   cross-core locking is required, and all events are stamped from
+ *   the common CGU timestamp counter so the rings can be merged into
+ *   a single timeline.
+ *
+ *   The rings wrap, always keeping the most recent events.  Capture is
+ *   started and stopped by the ARM through the shared 'enable' flag.
+ *
+ * @file      trace.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _trace_h
+#define _trace_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sae_cfg.h"
+#include "trace_cfg.h"
+
+/*!****************************************************************
+ * @brief  Set to 0 to compile out all trace points
+ ******************************************************************/
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE             (1)
+#endif
+
+/*!****************************************************************
+ * @brief  Number of events kept per core (power of 2)
+ ******************************************************************/
+#ifndef TRACE_EVENTS_PER_CORE
+#define TRACE_EVENTS_PER_CORE    (256)
+#endif
+
+/*!****************************************************************
+ * @brief  Event timestamp source and rate
+ ******************************************************************/
+#ifndef TRACE_TIMESTAMP
+#define TRACE_TIMESTAMP()        (0)
+#endif
+
+#ifndef TRACE_TIMESTAMP_HZ
+#define TRACE_TIMESTAMP_HZ       (1)
+#endif
+
+#if (TRACE_EVENTS_PER_CORE & (TRACE_EVENTS_PER_CORE - 1)) != 0
+#error "TRACE_EVENTS_PER_CORE must be a power of 2"
+#endif
+
+/*!****************************************************************
+ * @brief  Trace event identifiers
+ ******************************************************************/
+typedef enum _TRACE_ID {
+    TRACE_ID_NONE = 0,
+    TRACE_ID_SPORT_IRQ,         /**< SPORT DMA ISR, arg = IID */
+    TRACE_ID_SHARC_AUDIO,       /**< sharcAudio() dispatch, arg = domain mask */
+    TRACE_ID_SAE_SEND,          /**< SAE message send, arg = dest core */
+    TRACE_ID_SAE_IRQ,           /**< SAE IPC interrupt */
+    TRACE_ID_ROUTE_AUDIO,       /**< SHARC routeAudio(), arg = clock domain */
+    TRACE_ID_PROCESS_AUDIO,     /**< SHARC processAudio(), arg = stream ID */
+    TRACE_ID_TASK,              /**< Task switch, arg = task handle */
+    TRACE_ID_USER,              /**< Application defined */
+    TRACE_ID_MAX
+} TRACE_ID;
+
+/*!****************************************************************
+ * @brief  Trace event types
+ ******************************************************************/
+typedef enum _TRACE_TYPE {
+    TRACE_TYPE_INSTANT = 0,
+    TRACE_TYPE_BEGIN,
+    TRACE_TYPE_END
+} TRACE_TYPE;
+
+/*!****************************************************************
+ * @brief  Trace event (12 bytes, identical layout on all cores)
+ ******************************************************************/
+typedef struct _TRACE_EVENT {
+    uint32_t ts;
+    uint16_t id;
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t arg;
+} TRACE_EVENT;
+
+/*!****************************************************************
+ * @brief  Shared trace buffer
+ *
+ * 'head' counts every event ever reserved on a core, so the number
+ * of events overwritten is max(head - events, 0).
+ ******************************************************************/
+typedef struct _TRACE_BUFFER {
+    uint32_t magic;
+    volatile uint32_t enable;
+    uint32_t events;
+    uint32_t hz;
+    volatile uint32_t head[IPC_MAX_CORES];
+    TRACE_EVENT event[];
+} TRACE_BUFFER;
+
+#define TRACE_MAGIC  (0x54524345)
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!****************************************************************
+ * @brief  Returns the number of bytes required for a trace buffer
+ ******************************************************************/
+size_t trace_size(void);
+
+/*!****************************************************************
+ * @brief  Initialize a trace buffer (ARM only)
+ *
+ * @param [in]  mem   Shared memory of at least trace_size() bytes
+ *
+ * @return Initialized trace buffer
+ ******************************************************************/
+TRACE_BUFFER *trace_init(void *mem);
+
+/*!****************************************************************
+ * @brief  Attach this core to a trace buffer
+ *
+ * @param [in]  tb       Shared trace buffer or NULL to detach
+ * @param [in]  coreIdx  This core's SAE core index
+ ******************************************************************/
+void trace_attach(TRACE_BUFFER *tb, unsigned coreIdx);
+
+/*!****************************************************************
+ * @brief  Returns the trace buffer this core is attached to
+ ******************************************************************/
+TRACE_BUFFER *trace_buffer(void);
+
+/*!****************************************************************
+ * @brief  Discard all events and start capturing (ARM only)
+ ******************************************************************/
+void trace_start(void);
+
+/*!****************************************************************
+ * @brief  Stop capturing on all cores (ARM only)
+ ******************************************************************/
+void trace_stop(void);
+
+/*!****************************************************************
+ * @brief  Record an event.  Safe from any context.
+ ******************************************************************/
+void trace_event(TRACE_ID id, TRACE_TYPE type, uint32_t arg);
+
+/*!****************************************************************
+ * @brief  Returns the name of an event ID
+ ******************************************************************/
+const char *trace_id_str(unsigned id);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/*!****************************************************************
+ * @brief  Trace point macros
+ ******************************************************************/
+#if TRACE_ENABLE
+#define TRACE_BEGIN(id, arg)    trace_event(id, TRACE_TYPE_BEGIN, (uint32_t)(arg))
+#define TRACE_END(id, arg)      trace_event(id, TRACE_TYPE_END, (uint32_t)(arg))
+#define TRACE_INSTANT(id, arg)  trace_event(id, TRACE_TYPE_INSTANT, (uint32_t)(arg))
+#else
+#define TRACE_BEGIN(id, arg)    do { } while (0)
+#define TRACE_END(id, arg)      do { } while (0)
+#define TRACE_INSTANT(id, arg)  do { } while (0)
+#endif
+
+#endif
@@ -90,7 +90,7 @@ uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
 #define configMINIMAL_STACK_SIZE                ( ( unsigned short ) 512 )
 #define configTOTAL_HEAP_SIZE                   ( 256 * 1024 )
 #define configMAX_TASK_NAME_LEN                 ( 32 )
-#define configUSE_TRACE_FACILITY                0
+#define configUSE_TRACE_FACILITY                1
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
 #define configUSE_MUTEXES                       1
@@ -145,10 +145,13 @@ to exclude the API function. */
 #define INCLUDE_eTaskGetState                   1
 #define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
 
-/* Task switch hook for idle time calculations */
+/* Task switch/delete hooks for CPU load accounting */
 void taskSwitchHook(void *taskHandle);
+void taskDeleteHook(void *taskHandle);
 #define traceTASK_SWITCHED_IN()  taskSwitchHook(pxCurrentTCB)
+#define traceTASK_DELETE(pxTCB)  taskDeleteHook(pxTCB)
 
 /* Enable FPU context support in all tasks.  This also config option also
  * enables FPU context support in the ISRs if configUSE_TASK_FPU_SUPPORT > 0.
@@ -161,10 +164,17 @@ readable ASCII form.  See the notes in the implementation of vTaskList() within
 FreeRTOS/Source/tasks.c for limitations. */
 #define configUSE_STATS_FORMATTING_FUNCTIONS    1
 
-/* Run time stats related definitions. */
-#define configGENERATE_RUN_TIME_STATS 0
+/* Run time stats related definitions.  Uses the same CGU timestamp
+counter as the CPU load module, which is started in init.c before the
+scheduler runs.  The kernel keeps 32-bit run times, which would wrap
+every 275 seconds at CGU_TS_CLK, so the full 64-bit count is scaled
+down to 61 kHz first and wraps after about 19 hours. */
+uint64_t getTimeStamp64(void);
+#define RUN_TIME_STATS_SHIFT  8
+#define configGENERATE_RUN_TIME_STATS 1
 #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
-#define portGET_RUN_TIME_COUNTER_VALUE()  ( ( uint32_t ) ( alt_globaltmr_get64() >> ( uint64_t ) 16 ) )
+#define portGET_RUN_TIME_COUNTER_VALUE()  \
+    ((uint32_t)(getTimeStamp64() >> RUN_TIME_STATS_SHIFT))
 
 
 /* The size of the global output buffer that is available for use when there
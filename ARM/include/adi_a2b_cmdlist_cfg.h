@@ -22,5 +22,8 @@
 //#define ADI_A2B_CMDLIST_MEMCPY    memcpy
 //#define ADI_A2B_CMDLIST_MEMCPY    memcpy
 //#define ADI_A2B_CMDLIST_FORCE_FULL_LINE_DIAGNOSTICS
+//#define ADI_A2B_CMDLIST_OPTIMIZE     1
+//#define ADI_A2B_CMDLIST_QUEUE_BYTES  512
+//#define ADI_A2B_CMDLIST_QUEUE_XFERS  32
 
 #endif
@@ -31,6 +31,7 @@
 #include "uac2_soundcard.h"
 #include "sae.h"
 #include "ipc.h"
+#include "mixer.h"
 #include "wav_file.h"
 #include "clock_domain_defs.h"
 #include "spiffs.h"
@@ -58,6 +59,8 @@
 /*
  * WARNING: Do not change SYSTEM_AUDIO_TYPE from int32_t
  *
+ * SYSTEM_SAMPLE_RATE is the power-up rate.  The USB host may select any
+ * other rate in the clock plan (see init.c) at runtime.
  */
 #define SYSTEM_MCLK_RATE               (24576000)
 #define SYSTEM_SAMPLE_RATE             (48000)
@@ -93,6 +96,22 @@
 #define SPDIF_DMA_CHANNELS             (2)
 #define SPDIF_BLOCK_SIZE               (SYSTEM_BLOCK_SIZE)
 
+/*
+ * Set to 1 to clock SPDIF RX data straight into SPORT2B and run SPDIF in
+ * as its own CLOCK_DOMAIN_SPDIF instead of through ASRC0 in the system
+ * clock domain.  Saves the ASRC group delay but only routes within the
+ * SPDIF domain reach it.
+ */
+#ifndef SPDIF_IN_ASRC_BYPASS
+#define SPDIF_IN_ASRC_BYPASS           (0)
+#endif
+
+#if SPDIF_IN_ASRC_BYPASS
+#define SPDIF_IN_CLOCK_DOMAIN          (CLOCK_DOMAIN_SPDIF)
+#else
+#define SPDIF_IN_CLOCK_DOMAIN          (CLOCK_DOMAIN_SYSTEM)
+#endif
+
 #define A2B_AUDIO_CHANNELS             (32)
 #define A2B_DMA_CHANNELS               (32)
 #define A2B_BLOCK_SIZE                 (SYSTEM_BLOCK_SIZE)
@@ -119,6 +138,7 @@ typedef enum A2B_BUS_MODE {
 enum {
     UAC2_TASK_NO_ACTION,
     UAC2_TASK_AUDIO_DATA_READY,
+    UAC2_TASK_SAMPLE_RATE_CHANGE,
 };
 
 /* USB Audio OUT (Rx) endpoint stats */
@@ -198,6 +218,10 @@ struct _APP_CONTEXT {
     bool uac2TxEnabled;
     USB_AUDIO_STATS uac2stats;
     UAC2_APP_CONFIG uac2cfg;
+    volatile uint32_t uac2SampleRate;
+
+    /* Current system sample rate */
+    uint32_t sampleRate;
 
     /* SHARC Audio Engine context */
     SAE_CONTEXT *saeContext;
@@ -255,9 +279,29 @@ struct _APP_CONTEXT {
     SAE_MSG_BUFFER *wavMsgSrc[1];
     SAE_MSG_BUFFER *wavMsgSink[1];
 
-    /* Audio routing table */
+    /*
+     * Audio routing table, published and next (route_control.h).  The
+     * published table is inside routingMsgBuffer's message, which is
+     * a routing or a scene message.
+     */
     SAE_MSG_BUFFER *routingMsgBuffer;
-    IPC_MSG *routingMsg;
+    IPC_MSG_ROUTING *routing;
+    SAE_MSG_BUFFER *routingNextMsgBuffer;
+    IPC_MSG *routingNextMsg;
+
+    /* Event trace buffer */
+    SAE_MSG_BUFFER *traceMsgBuffer;
+
+    /* Level meter table */
+    SAE_MSG_BUFFER *meterMsgBuffer;
+
+    /* Latency probe table */
+    SAE_MSG_BUFFER *latencyMsgBuffer;
+
+    /* Crosspoint mixer matrix, working copy and last one sent */
+    MIXER_POINT *mixerPoints;
+    unsigned mixerNumPoints;
+    SAE_MSG_BUFFER *mixerMsgBuffer;
 
     /* Not used */
     APP_CFG cfg;
@@ -267,6 +311,7 @@ struct _APP_CONTEXT {
 
     /* SHARC Cycles */
     uint32_t sharc0Cycles[CLOCK_DOMAIN_MAX];
+    uint32_t sharc0CoreCycles[CLOCK_DOMAIN_MAX];
     uint32_t sharc1Cycles[CLOCK_DOMAIN_MAX];
 
     /* WAV file related variables and settings */
@@ -281,9 +326,15 @@ struct _APP_CONTEXT {
     A2B_BUS_MODE a2bmode;
     bool a2bSlaveActive;
 
+    /* A2B slave discovery stats.  Latency is from IRQ (or poll)
+     * detection to SPORT start in CGU_TS_CLK ticks.
+     */
+    volatile uint32_t a2bSlaveIrqs;
+    uint32_t a2bSlaveStarts;
+    uint32_t a2bSlaveLatency;
+
     /* Clock domain management */
-    uint32_t clockDomainMask[CLOCK_DOMAIN_MAX];
-    uint32_t clockDomainActive[CLOCK_DOMAIN_MAX];
+    CLOCK_DOMAIN_STATE clockDomain[CLOCK_DOMAIN_MAX];
 
 };
 typedef struct _APP_CONTEXT APP_CONTEXT;
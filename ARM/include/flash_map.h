@@ -37,6 +37,10 @@
 #define SPIFFS_OFFSET (APP_OFFSET + APP_SIZE)
 #define SPIFFS_SIZE   (0x00800000)
 
+/* SPIFFS mount index snapshot (8k reserved, two 4k slots) */
+#define SPIFFS_INDEX_OFFSET (SPIFFS_OFFSET + SPIFFS_SIZE)
+#define SPIFFS_INDEX_SIZE   (0x00002000)
+
 /* Erase block and page sizes, good for all SAM flash devices */
 #define ERASE_BLOCK_SIZE (4*1024)
 #define FLASH_PAGE_SIZE  (256)
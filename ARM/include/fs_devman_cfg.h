@@ -21,4 +21,14 @@
 #define FS_DEVMAN_ENABLE_FATFS
 #define FS_DEVMAN_ENABLE_SPIFFS
 
+/* Read-ahead / write-behind for files opened with fs_devio_fopen() */
+#define FS_DEVIO_ENABLE_STREAMS
+#define FS_DEVIO_STREAM_BUF_SIZE  (4 * 1024)
+#define FS_DEVIO_STREAM_BUFS      (4)
+
+#include "clocks.h"
+#include "cpu_load.h"
+#define FS_DEVIO_TIMESTAMP()      cpuLoadGetTimeStamp()
+#define FS_DEVIO_TIMESTAMP_HZ     (CGU_TS_CLK)
+
 #endif
@@ -13,6 +13,8 @@
 #define _SYSLOG_CFG_H
 
 #include "umm_malloc.h"
+#include "clocks.h"
+#include "util.h"
 
 /*! @cond */
 
@@ -23,7 +25,10 @@
 #define SYSLOG_FREE(x)     umm_free_heap(SYSLOG_HEAP, x)
 
 #define SYSLOG_LINE_MAX    (128)
-#define SYSLOG_MAX_LINES   (4096)
+#define SYSLOG_MAX_LINES   (8192)
+
+#define SYSLOG_TIMESTAMP()   getTimeStamp()
+#define SYSLOG_TIMESTAMP_HZ  CGU_TS_CLK
 
 /*! @endcond example-config */
 
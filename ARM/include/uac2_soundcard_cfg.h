@@ -14,9 +14,6 @@
 
 #include "umm_malloc.h"
 
-/* Sizes */
-#define UAC2_SYSLOG_DEPTH  8
-
 /* Use std memset */
 #define UAC2_MEMSET   memset
 #define UAC2_MEMCPY   memcpy
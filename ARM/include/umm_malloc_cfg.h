@@ -16,9 +16,22 @@
 
 #include "umm_malloc_heaps.h"
 
+/*
+ * Use the TLSF backend, bounded-time malloc and free.  Heap integrity
+ * and poison checks are then switched on at runtime with
+ * umm_set_checks() instead of being compiled in.  Defining UMM_LEGACY
+ * builds the original block allocator instead.
+ */
+#ifndef UMM_LEGACY
+#define UMM_TLSF
+#endif
+#define UMM_CHECKS_DEFAULT (0)
+
 #define UMM_INFO
+#ifndef UMM_TLSF
 #define UMM_INTEGRITY_CHECK
 #define UMM_POISON_CHECK
+#endif
 
 #define UMM_BLOCK_SIZE    64
 
@@ -154,7 +167,7 @@
  * for corruption.
  */
 
-#ifdef UMM_INTEGRITY_CHECK
+#if defined(UMM_INTEGRITY_CHECK) || defined(UMM_TLSF)
    int umm_integrity_check( umm_heap_t heap );
 #  define INTEGRITY_CHECK(x) umm_integrity_check(x)
    extern void umm_corruption(void);
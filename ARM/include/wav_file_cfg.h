@@ -17,6 +17,14 @@
 #define WAVE_FILE_CALLOC          umm_calloc
 #define WAVE_FILE_FREE            umm_free
 
-#define WAVE_FILE_BUF_SIZE       (16 * 1024)
+#if defined(__ADSPARM__)
+/* Stream through the fs_devio read-ahead / write-behind buffers */
+#include "fs_devio.h"
+#define WAVE_FILE_FOPEN(n, m)     fs_devio_fopen(n, m, 0, 0)
+#define WAVE_FILE_READY(f, s)     fs_devio_ready(f, s)
+#define WAVE_FILE_BUF_SIZE        (0)
+#else
+#define WAVE_FILE_BUF_SIZE        (16 * 1024)
+#endif
 
 #endif
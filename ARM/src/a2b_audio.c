@@ -24,7 +24,7 @@ void a2bAudioOut(void *buffer, uint32_t size, void *usrPtr)
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     SAE_MSG_BUFFER *msg = NULL;
     uint32_t inCycles, outCycles;
-    bool clockSource;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -37,12 +37,11 @@ void a2bAudioOut(void *buffer, uint32_t size, void *usrPtr)
     }
 
     /* This is the CLOCK_DOMAIN_A2B "out" clock source in slave mode */
-    clockSource = (context->a2bmode == A2B_BUS_MODE_SLAVE);
-    sharcAudio(context, CLOCK_DOMAIN_BITM_A2B_OUT, msg, clockSource, false);
+    sharcAudio(context, CLOCK_DOMAIN_BITM_A2B_OUT, msg, false);
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "a2bAudioOut", outCycles - inCycles);
 }
 
 void a2bAudioIn(void *buffer, uint32_t size, void *usrPtr)
@@ -50,7 +49,7 @@ void a2bAudioIn(void *buffer, uint32_t size, void *usrPtr)
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     SAE_MSG_BUFFER *msg = NULL;
     uint32_t inCycles, outCycles;
-    bool clockSource;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -63,10 +62,9 @@ void a2bAudioIn(void *buffer, uint32_t size, void *usrPtr)
     }
 
     /* This is the CLOCK_DOMAIN_A2B "in" clock source in slave mode */
-    clockSource = (context->a2bmode == A2B_BUS_MODE_SLAVE);
-    sharcAudio(context, CLOCK_DOMAIN_BITM_A2B_IN, msg, clockSource, true);
+    sharcAudio(context, CLOCK_DOMAIN_BITM_A2B_IN, msg, true);
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "a2bAudioIn", outCycles - inCycles);
 }
@@ -11,6 +11,9 @@
 /* Standard libary includes */
 #include <stdint.h>
 
+/* CCES includes */
+#include <services/gpio/adi_gpio.h>
+
 /* Kernel includes. */
 #include "FreeRTOS.h"
 #include "task.h"
@@ -18,64 +21,271 @@
 /* Simple driver includes */
 #include "twi_simple.h"
 
+/* Simple service includes */
+#include "cpu_load.h"
+
 /* Application includes */
 #include "context.h"
 #include "syslog.h"
 #include "init.h"
+#include "a2b_slave.h"
 
+#define AD242X_INTSRC           0x16u
+#define AD242X_INTPND0          0x18u
+#define AD242X_INTPND_REGS      3u
 #define AD242X_I2SGCFG          0x41u
 #define AD242X_NODE             0x29u
 #define AD242X_NODE_DISCVD      0x20u
 
 #define AD242X_I2SCFG_DATA_EN   0x33u
 
-/* A2B slave mode management task */
-portTASK_FUNCTION(a2bSlaveTask, pvParameters)
+/*
+ * AD2425 IRQ input.  Only define these for a board that wires the
+ * transceiver's IRQ output to a pin interrupt capable GPIO, i.e.
+ *
+ *   -DA2B_SLAVE_IRQ_PORT=ADI_GPIO_PORT_B -DA2B_SLAVE_IRQ_PIN=ADI_GPIO_PIN_1
+ *   -DA2B_SLAVE_IRQ_PINT=ADI_GPIO_PIN_INTERRUPT_1
+ *   -DA2B_SLAVE_IRQ_PINT_BYTE=ADI_GPIO_PIN_ASSIGN_BYTE_0
+ *   -DA2B_SLAVE_IRQ_PINT_ASSIGN=ADI_GPIO_PIN_ASSIGN_PBL_PINT1
+ *   -DA2B_SLAVE_IRQ_PINT_PIN=ADI_GPIO_PIN_1
+ *
+ * The rising edge then wakes the slave task, which clears the pending
+ * interrupts and checks the discovery state.  Without them the slave
+ * task polls.
+ */
+
+/*
+ * Slave mode poll period when there is no working IRQ.  Master mode
+ * never polls.
+ */
+#ifndef A2B_SLAVE_POLL_MS
+#define A2B_SLAVE_POLL_MS           100
+#endif
+
+/*
+ * Slave mode backstop poll with a working IRQ, in case an edge is
+ * missed or the bus master did not enable the slave's IRQ output.
+ */
+#ifndef A2B_SLAVE_IRQ_POLL_MS
+#define A2B_SLAVE_IRQ_POLL_MS       1000
+#endif
+
+/*
+ * Passes over the pending interrupts before giving the line back to
+ * the edge interrupt, in case new events keep it asserted
+ */
+#ifndef A2B_SLAVE_IRQ_PASSES
+#define A2B_SLAVE_IRQ_PASSES        4
+#endif
+
+/* Time of the last IRQ edge */
+static volatile uint32_t a2bSlaveIrqTime;
+
+#ifdef A2B_SLAVE_IRQ_PORT
+
+static void a2bSlaveIrq(ADI_GPIO_PIN_INTERRUPT pint, uint32_t event, void *usr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usr;
+    BaseType_t contextSwitch = pdFALSE;
+
+    a2bSlaveIrqTime = cpuLoadGetTimeStamp();
+    context->a2bSlaveIrqs++;
+
+    if (context->a2bSlaveTaskHandle) {
+        vTaskNotifyGiveFromISR(context->a2bSlaveTaskHandle, &contextSwitch);
+    }
+    portYIELD_FROM_ISR(contextSwitch);
+}
+
+static bool a2bSlaveIrqInit(APP_CONTEXT *context)
+{
+    ADI_GPIO_RESULT result;
+
+    result = adi_gpio_SetDirection(A2B_SLAVE_IRQ_PORT,
+        A2B_SLAVE_IRQ_PIN, ADI_GPIO_DIRECTION_INPUT);
+    if (result == ADI_GPIO_SUCCESS) {
+        result = adi_gpio_PinInterruptAssignment(A2B_SLAVE_IRQ_PINT,
+            A2B_SLAVE_IRQ_PINT_BYTE, A2B_SLAVE_IRQ_PINT_ASSIGN);
+    }
+    if (result == ADI_GPIO_SUCCESS) {
+        result = adi_gpio_SetPinIntEdgeSense(A2B_SLAVE_IRQ_PINT,
+            A2B_SLAVE_IRQ_PINT_PIN, ADI_GPIO_SENSE_RISING_EDGE);
+    }
+    if (result == ADI_GPIO_SUCCESS) {
+        result = adi_gpio_RegisterCallback(A2B_SLAVE_IRQ_PINT,
+            A2B_SLAVE_IRQ_PINT_PIN, a2bSlaveIrq, context);
+    }
+    if (result == ADI_GPIO_SUCCESS) {
+        result = adi_gpio_EnablePinInterruptMask(A2B_SLAVE_IRQ_PINT,
+            A2B_SLAVE_IRQ_PINT_PIN, true);
+    }
+
+    if (result != ADI_GPIO_SUCCESS) {
+        syslog_print("A2B Slave IRQ init failed, polling only");
+    }
+
+    return(result == ADI_GPIO_SUCCESS);
+}
+
+/*
+ * The IRQ output is a level that stays asserted while any unmasked
+ * interrupt is pending, so no further edge arrives until INTPND0/1/2
+ * are cleared (write 1 to clear).
+ */
+static void a2bSlaveIrqAck(APP_CONTEXT *context)
+{
+    TWI_SIMPLE_RESULT result;
+    uint8_t pending[AD242X_INTPND_REGS];
+    uint8_t wbuf[2];
+    uint8_t intSrc;
+    uint8_t reg;
+    unsigned i;
+
+    reg = AD242X_INTSRC;
+    result = twi_writeRead(context->ad2425TwiHandle, AD2425W_SAM_I2C_ADDR,
+        &reg, sizeof(reg), &intSrc, sizeof(intSrc));
+    if (result != TWI_SIMPLE_SUCCESS) {
+        return;
+    }
+
+    reg = AD242X_INTPND0;
+    result = twi_writeRead(context->ad2425TwiHandle, AD2425W_SAM_I2C_ADDR,
+        &reg, sizeof(reg), pending, sizeof(pending));
+    if (result != TWI_SIMPLE_SUCCESS) {
+        return;
+    }
+
+    for (i = 0; i < AD242X_INTPND_REGS; i++) {
+        if (pending[i]) {
+            wbuf[0] = AD242X_INTPND0 + i;
+            wbuf[1] = pending[i];
+            twi_write(context->ad2425TwiHandle, AD2425W_SAM_I2C_ADDR,
+                wbuf, sizeof(wbuf));
+        }
+    }
+}
+
+/* Returns true while the IRQ line is still asserted */
+static bool a2bSlaveIrqAsserted(void)
+{
+    ADI_GPIO_RESULT result;
+    uint32_t data;
+
+    result = adi_gpio_GetData(A2B_SLAVE_IRQ_PORT, &data);
+    return((result == ADI_GPIO_SUCCESS) && (data & A2B_SLAVE_IRQ_PIN));
+}
+
+#else
+
+static bool a2bSlaveIrqInit(APP_CONTEXT *context)
+{
+    return(false);
+}
+
+static void a2bSlaveIrqAck(APP_CONTEXT *context)
+{
+}
+
+static bool a2bSlaveIrqAsserted(void)
+{
+    return(false);
+}
+
+#endif
+
+/*
+ * Checks the transceiver discovery state and starts or stops the
+ * slave SPORTs.  'detectTime' is when the state change was first
+ * noticed.
+ */
+static void a2bSlaveCheck(APP_CONTEXT *context, uint32_t detectTime)
 {
-    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
     TWI_SIMPLE_RESULT result;
     uint8_t A2B_NODE_REG;
     uint8_t A2B_REG;
     uint8_t rbuf[2];
     bool ok;
 
-    while (1) {
-        if (context->a2bmode == A2B_BUS_MODE_SLAVE) {
-            A2B_REG = AD242X_NODE;
+    A2B_REG = AD242X_NODE;
+    result = twi_writeRead(context->ad2425TwiHandle, AD2425W_SAM_I2C_ADDR,
+        &A2B_REG, sizeof(A2B_REG),
+        &A2B_NODE_REG, sizeof(A2B_NODE_REG)
+    );
+    if (result != TWI_SIMPLE_SUCCESS) {
+        return;
+    }
+
+    if (A2B_NODE_REG & AD242X_NODE_DISCVD) {
+        if (!context->a2bSlaveActive) {
+            /* I2SGCFG and I2SCFG in one transaction */
+            A2B_REG = AD242X_I2SGCFG;
             result = twi_writeRead(context->ad2425TwiHandle, AD2425W_SAM_I2C_ADDR,
                 &A2B_REG, sizeof(A2B_REG),
-                &A2B_NODE_REG, sizeof(A2B_NODE_REG)
+                rbuf, sizeof(rbuf)
             );
             if (result != TWI_SIMPLE_SUCCESS) {
-                continue;
+                return;
             }
-            if (A2B_NODE_REG & AD242X_NODE_DISCVD) {
-                if (!context->a2bSlaveActive) {
-                    A2B_REG = AD242X_I2SGCFG;
-                    result = twi_writeRead(context->ad2425TwiHandle, AD2425W_SAM_I2C_ADDR,
-                        &A2B_REG, sizeof(A2B_REG),
-                        rbuf, sizeof(rbuf)
-                    );
-                    if (result != TWI_SIMPLE_SUCCESS) {
-                        continue;
-                    }
-                    if (rbuf[1] & AD242X_I2SCFG_DATA_EN) {
-                        syslog_printf("A2B Slave SPORT Start (%02x:%02x)", rbuf[0], rbuf[1]);
-                        ok = ad2425_sport_start(context, rbuf[0], rbuf[1]);
-                        if (!ok) {
-                            syslog_printf("A2B Slave SPORT Start Failed");
-                        }
-                        context->a2bSlaveActive = true;
-                    }
-                }
-            } else {
-                if (context->a2bSlaveActive) {
-                    syslog_printf("Slave SPORT Stop");
-                    ad2425_sport_stop(context);
-                    context->a2bSlaveActive = false;
+            if (rbuf[1] & AD242X_I2SCFG_DATA_EN) {
+                ok = ad2425_sport_start(context, rbuf[0], rbuf[1]);
+                context->a2bSlaveLatency = cpuLoadGetTimeStamp() - detectTime;
+                context->a2bSlaveStarts++;
+                syslog_printf("A2B Slave SPORT Start (%02x:%02x)", rbuf[0], rbuf[1]);
+                if (!ok) {
+                    syslog_printf("A2B Slave SPORT Start Failed");
                 }
+                context->a2bSlaveActive = true;
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(100));
+    } else {
+        if (context->a2bSlaveActive) {
+            syslog_printf("Slave SPORT Stop");
+            ad2425_sport_stop(context);
+            context->a2bSlaveActive = false;
+        }
+    }
+}
+
+/* A2B slave mode management task */
+portTASK_FUNCTION(a2bSlaveTask, pvParameters)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
+    TickType_t timeout;
+    uint32_t detectTime;
+    uint32_t pollMs;
+    uint32_t irqs;
+    unsigned pass;
+
+    pollMs = a2bSlaveIrqInit(context) ?
+        A2B_SLAVE_IRQ_POLL_MS : A2B_SLAVE_POLL_MS;
+
+    while (1) {
+        if (context->a2bmode == A2B_BUS_MODE_SLAVE) {
+            timeout = pdMS_TO_TICKS(pollMs);
+        } else {
+            timeout = portMAX_DELAY;
+        }
+
+        irqs = ulTaskNotifyTake(pdTRUE, timeout);
+
+        if (context->a2bmode == A2B_BUS_MODE_SLAVE) {
+            detectTime = irqs ? a2bSlaveIrqTime : cpuLoadGetTimeStamp();
+            pass = 0;
+            do {
+                a2bSlaveIrqAck(context);
+                a2bSlaveCheck(context, detectTime);
+            } while (a2bSlaveIrqAsserted() && (++pass < A2B_SLAVE_IRQ_PASSES));
+            if (pass == A2B_SLAVE_IRQ_PASSES) {
+                syslog_print("A2B Slave IRQ stuck, relying on the poll");
+            }
+        }
+    }
+}
+
+void a2bSlaveNotify(APP_CONTEXT *context)
+{
+    if (context->a2bSlaveTaskHandle) {
+        a2bSlaveIrqTime = cpuLoadGetTimeStamp();
+        xTaskNotifyGive(context->a2bSlaveTaskHandle);
     }
 }
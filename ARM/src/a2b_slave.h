@@ -14,6 +14,11 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
+#include "context.h"
+
 portTASK_FUNCTION(a2bSlaveTask, pvParameters);
 
+/* Wakes the slave task to re-check the bus mode and discovery state */
+void a2bSlaveNotify(APP_CONTEXT *context);
+
 #endif
@@ -0,0 +1,580 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * On-target micro-benchmarks for the primitives the audio path depends
+ * on.  Each benchmark times a single operation with the CGU timestamp
+ * counter (cpuLoadGetTimeStamp()) over a number of iterations after a
+ * short warmup and reports min/median/p99/max.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "context.h"
+#include "bench.h"
+#include "clocks.h"
+#include "cpu_load.h"
+#include "util.h"
+#include "sae.h"
+#include "ipc.h"
+#include "flash.h"
+#include "umm_malloc.h"
+#include "pa_ringbuffer.h"
+
+/* Wait this long for a SHARC ping reply */
+#define BENCH_PING_TIMEOUT_MS  (100)
+
+/* Flash read benchmarks cycle through this much of the flash */
+#define BENCH_FLASH_SPAN       (1024 * 1024)
+
+typedef struct BENCH_STATE {
+    APP_CONTEXT *context;
+    unsigned param;
+    unsigned iter;
+    uint8_t *src;
+    uint8_t *dst;
+    PaUtilRingBuffer ring;
+    void *ringData;
+    FILE *f;
+} BENCH_STATE;
+
+/*
+ * A benchmark times one operation per call and returns the elapsed
+ * timestamp ticks in 'elapsed'.  Untimed per-iteration setup and
+ * cleanup happen inside the call, outside of the timed region.
+ */
+typedef bool (*BENCH_FUNC)(BENCH_STATE *s, uint32_t *elapsed);
+typedef bool (*BENCH_SETUP)(BENCH_STATE *s);
+typedef void (*BENCH_TEARDOWN)(BENCH_STATE *s);
+
+typedef struct BENCH_ITEM {
+    const char *name;
+    BENCH_FUNC run;
+    BENCH_SETUP setup;
+    BENCH_TEARDOWN teardown;
+    unsigned param;
+    unsigned bytes;
+    unsigned maxIters;
+} BENCH_ITEM;
+
+#define BENCH_START(t)    (t) = cpuLoadGetTimeStamp()
+#define BENCH_STOP(t, e)  *(e) = cpuLoadGetTimeStamp() - (t)
+
+/***********************************************************************
+ * Audio buffer helpers
+ **********************************************************************/
+#define BENCH_AUDIO_BYTES \
+    (SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE * sizeof(SYSTEM_AUDIO_TYPE))
+
+static bool bench_audio_setup(BENCH_STATE *s)
+{
+    s->src = umm_calloc(1, BENCH_AUDIO_BYTES);
+    s->dst = umm_calloc(1, BENCH_AUDIO_BYTES);
+    return((s->src != NULL) && (s->dst != NULL));
+}
+
+static void bench_audio_teardown(BENCH_STATE *s)
+{
+    umm_free(s->src); s->src = NULL;
+    umm_free(s->dst); s->dst = NULL;
+}
+
+/***********************************************************************
+ * copyAndConvert(): param = (srcBytes << 16) | (dstBytes << 8) | channels
+ **********************************************************************/
+#define COPY_PARAM(s, d, c)  (((s) << 16) | ((d) << 8) | (c))
+
+static bool bench_copy(BENCH_STATE *s, uint32_t *elapsed)
+{
+    unsigned srcBytes = (s->param >> 16) & 0xFF;
+    unsigned dstBytes = (s->param >> 8) & 0xFF;
+    unsigned channels = s->param & 0xFF;
+    uint32_t t;
+
+    BENCH_START(t);
+    copyAndConvert(s->src, srcBytes, channels, s->dst, dstBytes, channels,
+        SYSTEM_BLOCK_SIZE, false);
+    BENCH_STOP(t, elapsed);
+
+    return(true);
+}
+
+/***********************************************************************
+ * PaUtil ring buffer: param = channels
+ **********************************************************************/
+static bool bench_ring_setup(BENCH_STATE *s)
+{
+    unsigned size;
+
+    if (!bench_audio_setup(s)) {
+        return(false);
+    }
+    size = roundUpPow2(USB_OUT_RING_BUFF_FRAMES * s->param);
+    s->ringData = umm_calloc(size, sizeof(SYSTEM_AUDIO_TYPE));
+    if (s->ringData == NULL) {
+        return(false);
+    }
+    PaUtil_InitializeRingBuffer(&s->ring, sizeof(SYSTEM_AUDIO_TYPE),
+        size, s->ringData);
+
+    return(true);
+}
+
+static void bench_ring_teardown(BENCH_STATE *s)
+{
+    umm_free(s->ringData); s->ringData = NULL;
+    bench_audio_teardown(s);
+}
+
+static bool bench_ring_write(BENCH_STATE *s, uint32_t *elapsed)
+{
+    unsigned samples = s->param * SYSTEM_BLOCK_SIZE;
+    uint32_t t;
+
+    if (PaUtil_GetRingBufferWriteAvailable(&s->ring) < samples) {
+        PaUtil_FlushRingBuffer(&s->ring);
+    }
+
+    BENCH_START(t);
+    PaUtil_WriteRingBuffer(&s->ring, s->src, samples);
+    BENCH_STOP(t, elapsed);
+
+    return(true);
+}
+
+static bool bench_ring_read(BENCH_STATE *s, uint32_t *elapsed)
+{
+    unsigned samples = s->param * SYSTEM_BLOCK_SIZE;
+    uint32_t t;
+
+    if (PaUtil_GetRingBufferReadAvailable(&s->ring) < samples) {
+        PaUtil_WriteRingBuffer(&s->ring, s->src, samples);
+    }
+
+    BENCH_START(t);
+    PaUtil_ReadRingBuffer(&s->ring, s->dst, samples);
+    BENCH_STOP(t, elapsed);
+
+    return(true);
+}
+
+/***********************************************************************
+ * SAE message buffers: param = SAE_ALLOC_POLICY
+ **********************************************************************/
+static bool bench_sae_create(BENCH_STATE *s, uint32_t *elapsed)
+{
+    SAE_CONTEXT *saeContext = s->context->saeContext;
+    SAE_MSG_BUFFER *msg;
+    IPC_MSG *payload;
+    uint32_t t;
+
+    BENCH_START(t);
+    msg = sae_createMsgBuffer(saeContext, sizeof(*payload),
+        (SAE_ALLOC_POLICY)s->param, (void **)&payload);
+    BENCH_STOP(t, elapsed);
+
+    if (msg == NULL) {
+        return(false);
+    }
+    sae_unRefMsgBuffer(saeContext, msg);
+
+    return(true);
+}
+
+static bool bench_sae_unref(BENCH_STATE *s, uint32_t *elapsed)
+{
+    SAE_CONTEXT *saeContext = s->context->saeContext;
+    SAE_MSG_BUFFER *msg;
+    IPC_MSG *payload;
+    uint32_t t;
+
+    msg = sae_createMsgBuffer(saeContext, sizeof(*payload),
+        (SAE_ALLOC_POLICY)s->param, (void **)&payload);
+    if (msg == NULL) {
+        return(false);
+    }
+
+    BENCH_START(t);
+    sae_unRefMsgBuffer(saeContext, msg);
+    BENCH_STOP(t, elapsed);
+
+    return(true);
+}
+
+/***********************************************************************
+ * SAE round trip: param = SHARC core index
+ **********************************************************************/
+static SemaphoreHandle_t pingSem;
+static volatile uint32_t pingSeq;
+
+void bench_ping_rx(IPC_MSG_PING *ping)
+{
+    BaseType_t contextSwitch = pdFALSE;
+
+    if (pingSem && ping->seq && (ping->seq == pingSeq)) {
+        pingSeq = 0;
+        xSemaphoreGiveFromISR(pingSem, &contextSwitch);
+        portYIELD_FROM_ISR(contextSwitch);
+    }
+}
+
+static bool bench_sae_rtt_setup(BENCH_STATE *s)
+{
+    if (pingSem == NULL) {
+        pingSem = xSemaphoreCreateBinary();
+    }
+    return(pingSem != NULL);
+}
+
+static bool bench_sae_rtt(BENCH_STATE *s, uint32_t *elapsed)
+{
+    static uint32_t seq;
+    SAE_CONTEXT *saeContext = s->context->saeContext;
+    SAE_MSG_BUFFER *msg;
+    IPC_MSG *payload;
+    SAE_RESULT result;
+    BaseType_t ok = pdFALSE;
+    uint32_t t;
+
+    msg = sae_createMsgBuffer(saeContext, sizeof(*payload),
+        SAE_ALLOC_BULK, (void **)&payload);
+    if (msg == NULL) {
+        return(false);
+    }
+    if (++seq == 0) {
+        seq = 1;
+    }
+    payload->type = IPC_TYPE_PING;
+    payload->ping.seq = seq;
+    xSemaphoreTake(pingSem, 0);
+    pingSeq = seq;
+
+    BENCH_START(t);
+    result = sae_sendMsgBuffer(saeContext, msg, (SAE_CORE_IDX)s->param, true);
+    if (result == SAE_RESULT_OK) {
+        ok = xSemaphoreTake(pingSem, pdMS_TO_TICKS(BENCH_PING_TIMEOUT_MS));
+    }
+    BENCH_STOP(t, elapsed);
+
+    if (result != SAE_RESULT_OK) {
+        sae_unRefMsgBuffer(saeContext, msg);
+        return(false);
+    }
+
+    return(ok == pdTRUE);
+}
+
+/***********************************************************************
+ * umm_malloc: param = (heap << 16) | size
+ **********************************************************************/
+static bool bench_umm(BENCH_STATE *s, uint32_t *elapsed)
+{
+    umm_heap_t heap = (umm_heap_t)(s->param >> 16);
+    size_t size = s->param & 0xFFFF;
+    void *ptr;
+    uint32_t t;
+
+    BENCH_START(t);
+    ptr = umm_malloc_heap(heap, size);
+    umm_free_heap(heap, ptr);
+    BENCH_STOP(t, elapsed);
+
+    return(ptr != NULL);
+}
+
+/***********************************************************************
+ * Flash: param = read size
+ **********************************************************************/
+static bool bench_flash_setup(BENCH_STATE *s)
+{
+    if (s->context->flashHandle == NULL) {
+        return(false);
+    }
+    s->dst = umm_malloc(s->param);
+    return(s->dst != NULL);
+}
+
+static void bench_flash_teardown(BENCH_STATE *s)
+{
+    umm_free(s->dst); s->dst = NULL;
+}
+
+static bool bench_flash_read(BENCH_STATE *s, uint32_t *elapsed)
+{
+    uint32_t addr;
+    uint32_t t;
+    int ok;
+
+    addr = (s->iter * s->param) % BENCH_FLASH_SPAN;
+
+    BENCH_START(t);
+    ok = flash_read(s->context->flashHandle, addr, s->dst, s->param);
+    BENCH_STOP(t, elapsed);
+
+    return(ok == FLASH_OK);
+}
+
+/***********************************************************************
+ * Files: param = index into benchVolumes[]
+ **********************************************************************/
+static const char * const benchVolumes[] = {
+    SPIFFS_VOL_NAME "bench.bin",
+    "sd:bench.bin"
+};
+
+static bool bench_file_setup(BENCH_STATE *s, const char *mode)
+{
+    s->src = umm_calloc(1, BENCH_FILE_BLOCK);
+    if (s->src == NULL) {
+        return(false);
+    }
+    s->f = fopen(benchVolumes[s->param], mode);
+    return(s->f != NULL);
+}
+
+/* Each benchmark leaves the volume as it found it */
+static void bench_file_teardown(BENCH_STATE *s)
+{
+    if (s->f) {
+        fclose(s->f); s->f = NULL;
+    }
+    umm_free(s->src); s->src = NULL;
+    remove(benchVolumes[s->param]);
+}
+
+static bool bench_file_write_setup(BENCH_STATE *s)
+{
+    return(bench_file_setup(s, "wb"));
+}
+
+static bool bench_file_write(BENCH_STATE *s, uint32_t *elapsed)
+{
+    size_t len;
+    uint32_t t;
+
+    BENCH_START(t);
+    len = fwrite(s->src, 1, BENCH_FILE_BLOCK, s->f);
+    BENCH_STOP(t, elapsed);
+
+    return(len == BENCH_FILE_BLOCK);
+}
+
+/*
+ * Writes its own file, as many blocks as the write benchmark at most
+ * does, so the read benchmark runs on its own
+ */
+static bool bench_file_read_setup(BENCH_STATE *s)
+{
+    unsigned i;
+    bool ok;
+
+    ok = bench_file_setup(s, "wb");
+    for (i = 0; ok && (i < BENCH_FILE_MAX_ITERS); i++) {
+        memset(s->src, i, BENCH_FILE_BLOCK);
+        ok = (fwrite(s->src, 1, BENCH_FILE_BLOCK, s->f) == BENCH_FILE_BLOCK);
+    }
+    if (s->f) {
+        fclose(s->f);
+    }
+    s->f = ok ? fopen(benchVolumes[s->param], "rb") : NULL;
+    return(s->f != NULL);
+}
+
+static bool bench_file_read(BENCH_STATE *s, uint32_t *elapsed)
+{
+    size_t len;
+    uint32_t t;
+
+    BENCH_START(t);
+    len = fread(s->src, 1, BENCH_FILE_BLOCK, s->f);
+    BENCH_STOP(t, elapsed);
+
+    /* Wrap around at the end of the file */
+    if (len != BENCH_FILE_BLOCK) {
+        fseek(s->f, 0, SEEK_SET);
+    }
+
+    return(true);
+}
+
+/***********************************************************************
+ * Benchmark table
+ **********************************************************************/
+#define BENCH_COPY(name, sb, db, ch) \
+    { name, bench_copy, bench_audio_setup, bench_audio_teardown, \
+      COPY_PARAM(sb, db, ch), (ch) * SYSTEM_BLOCK_SIZE * (db), 0 }
+
+#define BENCH_UMM(name, heap, size) \
+    { name, bench_umm, NULL, NULL, ((heap) << 16) | (size), 0, 0 }
+
+static const BENCH_ITEM benchItems[] = {
+    BENCH_COPY("copy_s16_s32_2ch",   2, 4, 2),
+    BENCH_COPY("copy_s16_s32_8ch",   2, 4, 8),
+    BENCH_COPY("copy_s16_s32_32ch",  2, 4, 32),
+    BENCH_COPY("copy_s32_s16_2ch",   4, 2, 2),
+    BENCH_COPY("copy_s32_s16_8ch",   4, 2, 8),
+    BENCH_COPY("copy_s32_s16_32ch",  4, 2, 32),
+    BENCH_COPY("copy_s32_s32_2ch",   4, 4, 2),
+    BENCH_COPY("copy_s32_s32_8ch",   4, 4, 8),
+    BENCH_COPY("copy_s32_s32_32ch",  4, 4, 32),
+    { "ring_write_2ch", bench_ring_write, bench_ring_setup, bench_ring_teardown,
+      2, 2 * SYSTEM_BLOCK_SIZE * sizeof(SYSTEM_AUDIO_TYPE), 0 },
+    { "ring_read_2ch", bench_ring_read, bench_ring_setup, bench_ring_teardown,
+      2, 2 * SYSTEM_BLOCK_SIZE * sizeof(SYSTEM_AUDIO_TYPE), 0 },
+    { "ring_write_32ch", bench_ring_write, bench_ring_setup, bench_ring_teardown,
+      32, 32 * SYSTEM_BLOCK_SIZE * sizeof(SYSTEM_AUDIO_TYPE), 0 },
+    { "ring_read_32ch", bench_ring_read, bench_ring_setup, bench_ring_teardown,
+      32, 32 * SYSTEM_BLOCK_SIZE * sizeof(SYSTEM_AUDIO_TYPE), 0 },
+    { "sae_create_fast", bench_sae_create, NULL, NULL, SAE_ALLOC_FAST, 0, 0 },
+    { "sae_create_bulk", bench_sae_create, NULL, NULL, SAE_ALLOC_BULK, 0, 0 },
+    { "sae_unref_fast", bench_sae_unref, NULL, NULL, SAE_ALLOC_FAST, 0, 0 },
+    { "sae_unref_bulk", bench_sae_unref, NULL, NULL, SAE_ALLOC_BULK, 0, 0 },
+    { "sae_rtt_sharc0", bench_sae_rtt, bench_sae_rtt_setup, NULL,
+      IPC_CORE_SHARC0, 0, 0 },
+    { "sae_rtt_sharc1", bench_sae_rtt, bench_sae_rtt_setup, NULL,
+      IPC_CORE_SHARC1, 0, 0 },
+    BENCH_UMM("umm_sdram_64",           UMM_SDRAM_HEAP, 64),
+    BENCH_UMM("umm_sdram_1k",           UMM_SDRAM_HEAP, 1024),
+    BENCH_UMM("umm_sdram_uncached_64",  UMM_SDRAM_UNCACHED_HEAP, 64),
+    BENCH_UMM("umm_sdram_uncached_1k",  UMM_SDRAM_UNCACHED_HEAP, 1024),
+    BENCH_UMM("umm_l2_64",              UMM_L2_CACHED_HEAP, 64),
+    BENCH_UMM("umm_l2_1k",              UMM_L2_CACHED_HEAP, 1024),
+    BENCH_UMM("umm_l2_uncached_64",     UMM_L2_UNCACHED_HEAP, 64),
+    BENCH_UMM("umm_l2_uncached_1k",     UMM_L2_UNCACHED_HEAP, 1024),
+    { "flash_read_256", bench_flash_read, bench_flash_setup, bench_flash_teardown,
+      256, 256, 0 },
+    { "flash_read_4k", bench_flash_read, bench_flash_setup, bench_flash_teardown,
+      4096, 4096, 0 },
+    { "spiffs_write_4k", bench_file_write, bench_file_write_setup,
+      bench_file_teardown, 0, BENCH_FILE_BLOCK, BENCH_FILE_MAX_ITERS },
+    { "spiffs_read_4k", bench_file_read, bench_file_read_setup,
+      bench_file_teardown, 0, BENCH_FILE_BLOCK, BENCH_FILE_MAX_ITERS },
+    { "fatfs_write_4k", bench_file_write, bench_file_write_setup,
+      bench_file_teardown, 1, BENCH_FILE_BLOCK, BENCH_FILE_MAX_ITERS },
+    { "fatfs_read_4k", bench_file_read, bench_file_read_setup,
+      bench_file_teardown, 1, BENCH_FILE_BLOCK, BENCH_FILE_MAX_ITERS },
+};
+
+#define BENCH_ITEMS  (sizeof(benchItems) / sizeof(benchItems[0]))
+
+/***********************************************************************
+ * Runner
+ **********************************************************************/
+static int bench_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return((x > y) - (x < y));
+}
+
+static uint32_t bench_ns(uint32_t ticks)
+{
+    return((uint32_t)(((uint64_t)ticks * 1000000000ULL) / CGU_TS_CLK));
+}
+
+void bench_list(FILE *f)
+{
+    unsigned i;
+    for (i = 0; i < BENCH_ITEMS; i++) {
+        fprintf(f, "%s\n", benchItems[i].name);
+    }
+}
+
+unsigned bench_run(APP_CONTEXT *context, const char *filter, unsigned iters,
+    FILE *f)
+{
+    const BENCH_ITEM *item;
+    BENCH_STATE state;
+    uint32_t *samples;
+    uint32_t median, p99;
+    unsigned total;
+    unsigned n;
+    unsigned i;
+    bool ok;
+
+    if (iters == 0) {
+        iters = BENCH_DEFAULT_ITERS;
+    }
+    if (iters > BENCH_MAX_ITERS) {
+        iters = BENCH_MAX_ITERS;
+    }
+
+    samples = umm_malloc(iters * sizeof(*samples));
+    if (samples == NULL) {
+        return(0);
+    }
+
+    fprintf(f, "bench,name,iters,min_ns,median_ns,p99_ns,max_ns,bytes,kBps\n");
+
+    total = 0;
+    for (i = 0; i < BENCH_ITEMS; i++) {
+
+        item = &benchItems[i];
+        if (filter && (strstr(item->name, filter) == NULL)) {
+            continue;
+        }
+
+        n = iters;
+        if (item->maxIters && (n > item->maxIters)) {
+            n = item->maxIters;
+        }
+
+        memset(&state, 0, sizeof(state));
+        state.context = context;
+        state.param = item->param;
+
+        ok = item->setup ? item->setup(&state) : true;
+
+        /* Warmup, then the timed iterations.  File benchmarks skip the
+         * warmup to keep the flash writes bounded.
+         */
+        if (ok && (item->maxIters == 0)) {
+            for (state.iter = 0; ok && (state.iter < BENCH_WARMUP_ITERS); state.iter++) {
+                ok = item->run(&state, &samples[0]);
+            }
+        }
+        for (state.iter = 0; ok && (state.iter < n); state.iter++) {
+            ok = item->run(&state, &samples[state.iter]);
+        }
+
+        if (item->teardown) {
+            item->teardown(&state);
+        }
+
+        if (!ok) {
+            fprintf(f, "bench,%s,0,,,,,,\n", item->name);
+            continue;
+        }
+
+        qsort(samples, n, sizeof(*samples), bench_cmp);
+        median = bench_ns(samples[n / 2]);
+        p99 = bench_ns(samples[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1]);
+
+        fprintf(f, "bench,%s,%u,%u,%u,%u,%u,%u,%u\n", item->name, n,
+            (unsigned)bench_ns(samples[0]), (unsigned)median, (unsigned)p99,
+            (unsigned)bench_ns(samples[n - 1]), item->bytes,
+            (item->bytes && median) ?
+                (unsigned)(((uint64_t)item->bytes * 1000000ULL) / median) : 0);
+
+        total++;
+    }
+
+    umm_free(samples);
+
+    return(total);
+}
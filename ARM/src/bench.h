@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+#ifndef _bench_h
+#define _bench_h
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "context.h"
+#include "ipc.h"
+
+/* Default number of timed iterations per benchmark */
+#define BENCH_DEFAULT_ITERS  (1000)
+
+/* Max timed iterations per benchmark */
+#define BENCH_MAX_ITERS      (10000)
+
+/* Untimed iterations run before each benchmark */
+#define BENCH_WARMUP_ITERS   (10)
+
+/* File benchmarks write BENCH_FILE_BLOCK sized blocks, at most
+ * BENCH_FILE_MAX_ITERS of them, to limit flash wear.
+ */
+#define BENCH_FILE_BLOCK     (4096)
+#define BENCH_FILE_MAX_ITERS (64)
+
+/* Lists the available benchmarks */
+void bench_list(FILE *f);
+
+/*
+ * Runs every benchmark whose name contains 'filter' (all if NULL) for
+ * 'iters' timed iterations and writes one CSV line of results per
+ * benchmark to 'f'.  Returns the number of benchmarks run.
+ */
+unsigned bench_run(APP_CONTEXT *context, const char *filter, unsigned iters,
+    FILE *f);
+
+/* Ping reply hook for the SAE round trip benchmarks (ISR context) */
+void bench_ping_rx(IPC_MSG_PING *ping);
+
+#endif
@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Dependency driven boot sequencer.
+ *
+ * Each stage declares the stages it depends on.  The calling task
+ * and a few worker tasks repeatedly claim the first unstarted stage
+ * whose dependencies are done, run it, and post its completion bit
+ * to an event group.  A task with nothing runnable sleeps on the
+ * event group until another stage finishes.
+ *
+ * Every stage is timestamped with the CGU timestamp counter, which
+ * starts in main() shortly after reset, so the timeline shows time
+ * since reset.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
+
+#include "context.h"
+#include "clocks.h"
+#include "cpu_load.h"
+#include "boot.h"
+
+/* Width of the timeline bar graph */
+#define BOOT_BAR_WIDTH  (40)
+
+typedef struct BOOT_RECORD {
+    uint32_t start;
+    uint32_t end;
+    uint8_t worker;
+    bool ok;
+    bool skipped;
+} BOOT_RECORD;
+
+typedef struct BOOT_STATE {
+    APP_CONTEXT *context;
+    const BOOT_STAGE *stages;
+    unsigned numStages;
+    uint32_t all;
+    uint32_t started;
+    volatile uint32_t failed;
+    EventGroupHandle_t done;
+    uint32_t start;
+    uint32_t end;
+    unsigned workers;
+    BOOT_RECORD record[BOOT_MAX_STAGES];
+} BOOT_STATE;
+
+static BOOT_STATE bootState;
+
+static uint32_t boot_us(uint32_t ticks)
+{
+    return((uint32_t)(((uint64_t)ticks * 1000000ULL) / CGU_TS_CLK));
+}
+
+/* mS with one decimal place for "%u.%u" */
+#define BOOT_MS(t)  (unsigned)(boot_us(t) / 1000), \
+                    (unsigned)((boot_us(t) / 100) % 10)
+
+static void boot_stage(BOOT_STATE *boot, unsigned idx, unsigned worker)
+{
+    const BOOT_STAGE *stage = &boot->stages[idx];
+    BOOT_RECORD *rec = &boot->record[idx];
+
+    rec->worker = worker;
+    rec->start = cpuLoadGetTimeStamp();
+    if (stage->deps & boot->failed) {
+        rec->skipped = true;
+        rec->ok = false;
+    } else {
+        rec->ok = stage->func(boot->context);
+    }
+    rec->end = cpuLoadGetTimeStamp();
+
+    if (!rec->ok) {
+        taskENTER_CRITICAL();
+        boot->failed |= BOOT_DEP(idx);
+        taskEXIT_CRITICAL();
+    }
+
+    if (boot->done) {
+        xEventGroupSetBits(boot->done, BOOT_DEP(idx));
+    }
+}
+
+/*
+ * Claims and runs one stage, sleeping first if none is runnable.
+ * Returns false once every stage has been claimed.
+ */
+static bool boot_next(BOOT_STATE *boot, unsigned worker)
+{
+    const BOOT_STAGE *stage;
+    uint32_t done;
+    int next;
+    unsigned i;
+
+    done = xEventGroupGetBits(boot->done) & boot->all;
+
+    next = -1;
+    taskENTER_CRITICAL();
+    for (i = 0; i < boot->numStages; i++) {
+        stage = &boot->stages[i];
+        if (!(boot->started & BOOT_DEP(i)) &&
+            ((stage->deps & done) == stage->deps)) {
+            boot->started |= BOOT_DEP(i);
+            next = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (next >= 0) {
+        boot_stage(boot, next, worker);
+        return(true);
+    }
+
+    if (boot->started == boot->all) {
+        return(false);
+    }
+
+    /* Wait for any stage not yet done to finish */
+    xEventGroupWaitBits(boot->done, boot->all & ~done,
+        pdFALSE, pdFALSE, portMAX_DELAY);
+
+    return(true);
+}
+
+static portTASK_FUNCTION(bootWorkerTask, pvParameters)
+{
+    unsigned worker = (unsigned)(uintptr_t)pvParameters;
+
+    while (boot_next(&bootState, worker));
+
+    vTaskDelete(NULL);
+}
+
+bool boot_run(APP_CONTEXT *context, const BOOT_STAGE *stages,
+    unsigned numStages)
+{
+    BOOT_STATE *boot = &bootState;
+    BaseType_t ok;
+    unsigned i;
+
+    if ((numStages == 0) || (numStages > BOOT_MAX_STAGES)) {
+        return(false);
+    }
+
+    memset(boot, 0, sizeof(*boot));
+    boot->context = context;
+    boot->stages = stages;
+    boot->numStages = numStages;
+    boot->all = BOOT_DEP(numStages) - 1;
+    boot->start = cpuLoadGetTimeStamp();
+
+    /* Not deleted since a worker may still be returning from a wait */
+    boot->done = xEventGroupCreate();
+    if (boot->done == NULL) {
+        /* Run serially in table order */
+        for (i = 0; i < numStages; i++) {
+            boot_stage(boot, i, 0);
+        }
+        boot->end = cpuLoadGetTimeStamp();
+        return(boot->failed == 0);
+    }
+
+    for (i = 0; i < BOOT_WORKERS; i++) {
+        ok = xTaskCreate(bootWorkerTask, "BootWorker", BOOT_WORKER_STACK_SIZE,
+            (void *)(uintptr_t)(i + 1), uxTaskPriorityGet(NULL), NULL);
+        if (ok == pdPASS) {
+            boot->workers++;
+        }
+    }
+
+    while (boot_next(boot, 0));
+
+    xEventGroupWaitBits(boot->done, boot->all, pdFALSE, pdTRUE, portMAX_DELAY);
+    boot->end = cpuLoadGetTimeStamp();
+
+    return(boot->failed == 0);
+}
+
+void boot_timeline(FILE *f)
+{
+    BOOT_STATE *boot = &bootState;
+    const BOOT_STAGE *stage;
+    BOOT_RECORD *rec;
+    char bar[BOOT_BAR_WIDTH + 1];
+    uint32_t span, start, end, busy;
+    unsigned i, b0, b1;
+
+    if (boot->numStages == 0) {
+        fprintf(f, "No boot timeline recorded\n");
+        return;
+    }
+
+    span = boot->end - boot->start;
+    if (span == 0) {
+        span = 1;
+    }
+
+    fprintf(f, "Boot timeline (%u workers), mS since reset\n", boot->workers);
+    fprintf(f, "%-10s %1s %8s %8s %8s\n", "Stage", "W", "Start", "End", "Time");
+
+    busy = 0;
+    for (i = 0; i < boot->numStages; i++) {
+        stage = &boot->stages[i];
+        rec = &boot->record[i];
+        start = rec->start - boot->start;
+        end = rec->end - boot->start;
+        busy += rec->end - rec->start;
+
+        b0 = ((uint64_t)start * BOOT_BAR_WIDTH) / span;
+        b1 = ((uint64_t)end * BOOT_BAR_WIDTH) / span;
+        if (b1 <= b0) {
+            b1 = b0 + 1;
+        }
+        if (b1 > BOOT_BAR_WIDTH) {
+            b1 = BOOT_BAR_WIDTH;
+        }
+        memset(bar, ' ', BOOT_BAR_WIDTH);
+        memset(bar + b0, rec->ok ? '#' : 'x', b1 - b0);
+        bar[b1] = '\0';
+
+        fprintf(f, "%-10s %1u %6u.%u %6u.%u %6u.%u |%s%s\n",
+            stage->name, (unsigned)rec->worker,
+            BOOT_MS(rec->start), BOOT_MS(rec->end),
+            BOOT_MS(rec->end - rec->start),
+            bar, rec->skipped ? " skipped" : (rec->ok ? "" : " failed"));
+    }
+
+    fprintf(f, "Boot done at %u.%u mS, %u.%u mS in stages (%u.%u mS if serial)\n",
+        BOOT_MS(boot->end), BOOT_MS(boot->end - boot->start), BOOT_MS(busy));
+}
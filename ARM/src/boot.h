@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+#ifndef _boot_h
+#define _boot_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "context.h"
+
+/* Worker tasks started in addition to the calling task.  Zero runs
+ * every stage serially in table order in the calling task.
+ */
+#ifndef BOOT_WORKERS
+#define BOOT_WORKERS           (2)
+#endif
+
+#ifndef BOOT_WORKER_STACK_SIZE
+#define BOOT_WORKER_STACK_SIZE (configMINIMAL_STACK_SIZE + 4096)
+#endif
+
+/* Limited by the FreeRTOS event group width */
+#define BOOT_MAX_STAGES        (24)
+
+/* Stage dependency mask */
+#define BOOT_DEP(x)            (1UL << (x))
+
+/* Stage function.  Returns false on failure. */
+typedef bool (BOOT_STAGE_FUNC)(APP_CONTEXT *context);
+
+/*
+ * A boot stage.  A stage starts once every stage in 'deps' has
+ * finished.  It is skipped (and counts as failed) if any of them
+ * failed.
+ */
+typedef struct BOOT_STAGE {
+    const char *name;
+    BOOT_STAGE_FUNC *func;
+    uint32_t deps;
+} BOOT_STAGE;
+
+/*
+ * Runs the boot stages on the calling task plus BOOT_WORKERS worker
+ * tasks at the caller's priority and returns once all stages are
+ * done.  Independent stages run concurrently.  Must only be called
+ * once.  Returns false if any stage failed.
+ */
+bool boot_run(APP_CONTEXT *context, const BOOT_STAGE *stages,
+    unsigned numStages);
+
+/* Writes the timeline of the last boot_run() to 'f' */
+void boot_timeline(FILE *f);
+
+#endif
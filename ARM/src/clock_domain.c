@@ -8,73 +8,245 @@
  * otherwise using the software constitutes acceptance of the license. The
  * software may not be used except as expressly authorized under the license.
  */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
 #include "context.h"
 #include "clock_domain_defs.h"
 #include "clock_domain.h"
+#include "cpu_load.h"
+#include "clocks.h"
+
+static const struct {
+    char *str;
+    char *name;
+} clockDomainNames[CLOCK_DOMAIN_MAX] = {
+    [CLOCK_DOMAIN_SYSTEM] = { "CLOCK_DOMAIN_SYSTEM", "system" },
+    [CLOCK_DOMAIN_A2B]    = { "CLOCK_DOMAIN_A2B",    "a2b" },
+    [CLOCK_DOMAIN_SPDIF]  = { "CLOCK_DOMAIN_SPDIF",  "spdif" },
+};
 
 char *clock_domain_str(CLOCK_DOMAIN domain)
 {
     char *str = "CLOCK_DOMAIN_UNKNOWN";
 
-    switch (domain) {
-        case CLOCK_DOMAIN_A2B:
-            str = "CLOCK_DOMAIN_A2B";
-            break;
-        case CLOCK_DOMAIN_SYSTEM:
-            str = "CLOCK_DOMAIN_SYSTEM";
-            break;
-        default:
-            break;
+    if ((domain < CLOCK_DOMAIN_MAX) && clockDomainNames[domain].str) {
+        str = clockDomainNames[domain].str;
     }
 
     return(str);
 }
 
-void clock_domain_set(APP_CONTEXT *context, CLOCK_DOMAIN domain, unsigned mask)
+CLOCK_DOMAIN clock_domain_from_str(const char *name)
 {
     int i;
+
     for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
+        if (clockDomainNames[i].name &&
+            (strcmp(name, clockDomainNames[i].name) == 0)) {
+            break;
+        }
+    }
+
+    return(i);
+}
+
+/*
+ * Moves the members in 'mask' into 'domain' and out of every other
+ * domain.  CLOCK_DOMAIN_MAX removes them from all domains.  Members that
+ * move start with no pending blocks.  Runs in task context while the
+ * member ISRs are live so the update is done in a critical section.
+ */
+void clock_domain_set(APP_CONTEXT *context, CLOCK_DOMAIN domain, unsigned mask)
+{
+    CLOCK_DOMAIN_STATE *cd;
+    int i, m;
+
+    taskENTER_CRITICAL();
+    for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
+        cd = &context->clockDomain[i];
         if (i == domain) {
-            context->clockDomainMask[i] |= mask;
+            cd->mask |= mask;
         } else {
-            context->clockDomainMask[i] &= ~mask;
-            context->clockDomainActive[i] &= ~mask;
+            cd->mask &= ~mask;
+            cd->stalled &= ~mask;
+            for (m = 0; m < CLOCK_DOMAIN_MAX_MEMBERS; m++) {
+                if (mask & (1u << m)) {
+                    cd->pending[m] = 0;
+                }
+            }
         }
     }
+    taskEXIT_CRITICAL();
 }
 
 CLOCK_DOMAIN clock_domain_get(APP_CONTEXT *context, unsigned mask)
 {
     int i;
     for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
-        if (context->clockDomainMask[i] & mask) {
+        if (context->clockDomain[i].mask & mask) {
             break;
         }
     }
     return(i);
 }
 
+/*
+ * Declares the members in 'mask' as clock sources of 'domain'.  Source
+ * members transfer the clock-less members (USB, WAV) of their domain
+ * when they execute.  The declaration persists across membership changes
+ * and only takes effect while the member is in the domain.
+ */
+void clock_domain_set_source(APP_CONTEXT *context, CLOCK_DOMAIN domain, unsigned mask)
+{
+    if (domain < CLOCK_DOMAIN_MAX) {
+        context->clockDomain[domain].source |= mask;
+    }
+}
+
+unsigned clock_domain_get_source(APP_CONTEXT *context, CLOCK_DOMAIN domain)
+{
+    CLOCK_DOMAIN_STATE *cd;
+
+    if (domain >= CLOCK_DOMAIN_MAX) {
+        return(0);
+    }
+    cd = &context->clockDomain[domain];
+
+    return(cd->source & cd->mask);
+}
+
+/*
+ * Records one block from each member in 'mask' (ISR context).  The
+ * domain's lowest numbered live member is its timing reference and
+ * updates the block period estimate.
+ */
 void clock_domain_set_active(APP_CONTEXT *context, CLOCK_DOMAIN domain, unsigned mask)
 {
-    context->clockDomainActive[domain] |= mask;
+    CLOCK_DOMAIN_STATE *cd;
+    uint32_t live, ref;
+    uint32_t now, delta;
+    int m;
+
+    if (domain >= CLOCK_DOMAIN_MAX) {
+        return;
+    }
+    cd = &context->clockDomain[domain];
+
+    mask &= cd->mask;
+    if (mask == 0) {
+        return;
+    }
+
+    for (m = 0; m < CLOCK_DOMAIN_MAX_MEMBERS; m++) {
+        if ((mask & (1u << m)) && (cd->pending[m] < UINT8_MAX)) {
+            cd->pending[m]++;
+        }
+    }
+    cd->stalled &= ~mask;
+
+    live = cd->mask & ~cd->stalled;
+    ref = live & -live;
+    if (mask & ref) {
+        now = cpuLoadGetTimeStamp();
+        delta = now - cd->lastTime;
+        /* Skip the first block and restarts after long gaps */
+        if (cd->lastTime && (delta < (1u << 23))) {
+            if (cd->period == 0) {
+                cd->period = delta << 8;
+            } else {
+                cd->period += (int32_t)((delta << 8) - cd->period) >>
+                    CLOCK_DOMAIN_RATE_SHIFT;
+            }
+        }
+        cd->lastTime = now;
+    }
 }
 
+/*
+ * Returns true, and consumes one block from every member, when all live
+ * members of the domain have a pending block (ISR context).  A member
+ * that is CLOCK_DOMAIN_STALL_BLOCKS behind another one is marked stalled
+ * so the rest of the domain keeps running.
+ */
 bool clock_domain_ready(APP_CONTEXT *context, CLOCK_DOMAIN domain)
 {
-    bool ready =
-        (context->clockDomainMask[domain] &
-         context->clockDomainActive[domain]) == context->clockDomainMask[domain];
+    CLOCK_DOMAIN_STATE *cd;
+    uint32_t live, behind;
+    uint8_t maxPending;
+    bool ready;
+    int m;
+
+    if (domain >= CLOCK_DOMAIN_MAX) {
+        return(false);
+    }
+    cd = &context->clockDomain[domain];
+
+    live = cd->mask & ~cd->stalled;
+    if (live == 0) {
+        return(false);
+    }
+
+    behind = 0;
+    maxPending = 0;
+    for (m = 0; m < CLOCK_DOMAIN_MAX_MEMBERS; m++) {
+        if (live & (1u << m)) {
+            if (cd->pending[m] == 0) {
+                behind |= (1u << m);
+            } else if (cd->pending[m] > maxPending) {
+                maxPending = cd->pending[m];
+            }
+        }
+    }
+
+    ready = (behind == 0);
+    if (!ready && (maxPending >= CLOCK_DOMAIN_STALL_BLOCKS)) {
+        cd->stalled |= behind;
+        cd->stalls++;
+        ready = true;
+    }
+
     if (ready) {
-        context->clockDomainActive[domain] = 0x00000000;
+        for (m = 0; m < CLOCK_DOMAIN_MAX_MEMBERS; m++) {
+            if (cd->pending[m]) {
+                cd->pending[m]--;
+            }
+        }
+        cd->blocks++;
     }
+
     return(ready);
 }
 
+/*
+ * Returns the measured sample rate of the domain in Hz, 0 if the domain
+ * has not run yet.
+ */
+uint32_t clock_domain_rate(APP_CONTEXT *context, CLOCK_DOMAIN domain)
+{
+    uint32_t period;
+
+    if (domain >= CLOCK_DOMAIN_MAX) {
+        return(0);
+    }
+    period = context->clockDomain[domain].period;
+    if (period == 0) {
+        return(0);
+    }
+
+    return((uint32_t)(((uint64_t)SYSTEM_BLOCK_SIZE * CGU_TS_CLK * 256 +
+        period / 2) / period));
+}
+
 void clock_domain_init(APP_CONTEXT *context)
 {
+    memset(context->clockDomain, 0, sizeof(context->clockDomain));
+
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_CODEC_IN);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_CODEC_OUT);
-    clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_SPDIF_IN);
+    clock_domain_set(context, SPDIF_IN_CLOCK_DOMAIN, CLOCK_DOMAIN_BITM_SPDIF_IN);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_SPDIF_OUT);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_USB_RX);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_USB_TX);
@@ -83,4 +255,12 @@ void clock_domain_init(APP_CONTEXT *context)
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_WAV_SRC);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_WAV_SINK);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_MIC_IN);
+
+    /* The SPORTs that can clock each domain */
+    clock_domain_set_source(context, CLOCK_DOMAIN_SYSTEM,
+        CLOCK_DOMAIN_BITM_CODEC_IN | CLOCK_DOMAIN_BITM_CODEC_OUT);
+    clock_domain_set_source(context, CLOCK_DOMAIN_A2B,
+        CLOCK_DOMAIN_BITM_A2B_IN | CLOCK_DOMAIN_BITM_A2B_OUT);
+    clock_domain_set_source(context, CLOCK_DOMAIN_SPDIF,
+        CLOCK_DOMAIN_BITM_SPDIF_IN);
 }
@@ -17,8 +17,12 @@
 void clock_domain_init(APP_CONTEXT *context);
 void clock_domain_set(APP_CONTEXT *context, CLOCK_DOMAIN domain, unsigned mask);
 CLOCK_DOMAIN clock_domain_get(APP_CONTEXT *context, unsigned mask);
+void clock_domain_set_source(APP_CONTEXT *context, CLOCK_DOMAIN domain, unsigned mask);
+unsigned clock_domain_get_source(APP_CONTEXT *context, CLOCK_DOMAIN domain);
 void clock_domain_set_active(APP_CONTEXT *context, CLOCK_DOMAIN domain, unsigned mask);
 bool clock_domain_ready(APP_CONTEXT *context, CLOCK_DOMAIN domain);
+uint32_t clock_domain_rate(APP_CONTEXT *context, CLOCK_DOMAIN domain);
 char *clock_domain_str(CLOCK_DOMAIN domain);
+CLOCK_DOMAIN clock_domain_from_str(const char *name);
 
 #endif
@@ -11,9 +11,17 @@
 #ifndef _clock_domain_defs_h
 #define _clock_domain_defs_h
 
+#include <stdint.h>
+
+/*
+ * Adding a clock domain only requires a new entry here (before
+ * CLOCK_DOMAIN_MAX) and a name in clock_domain.c.  The SHARC cycle
+ * reports carry at most IPC_CYCLE_DOMAIN_MAX domains.
+ */
 typedef enum CLOCK_DOMAIN {
     CLOCK_DOMAIN_SYSTEM = 0,
     CLOCK_DOMAIN_A2B,
+    CLOCK_DOMAIN_SPDIF,
     CLOCK_DOMAIN_MAX
 } CLOCK_DOMAIN;
 
@@ -31,4 +39,32 @@ enum {
     CLOCK_DOMAIN_BITM_MIC_IN     = 0x00010000u,
 };
 
+/* One member per bit of a clock domain mask */
+#define CLOCK_DOMAIN_MAX_MEMBERS     (32)
+
+/*
+ * A domain member that falls this many blocks behind the others is
+ * marked stalled and the domain keeps running without it until it
+ * reports again.
+ */
+#ifndef CLOCK_DOMAIN_STALL_BLOCKS
+#define CLOCK_DOMAIN_STALL_BLOCKS    (2)
+#endif
+
+/* Block period filter time constant (1 << CLOCK_DOMAIN_RATE_SHIFT blocks) */
+#ifndef CLOCK_DOMAIN_RATE_SHIFT
+#define CLOCK_DOMAIN_RATE_SHIFT      (4)
+#endif
+
+typedef struct _CLOCK_DOMAIN_STATE {
+    uint32_t mask;         /* Members of the domain */
+    uint32_t source;       /* Members that clock the clock-less members */
+    uint32_t stalled;      /* Members excluded from readiness */
+    uint8_t pending[CLOCK_DOMAIN_MAX_MEMBERS];  /* Unprocessed blocks */
+    uint32_t blocks;       /* Blocks sent for processing */
+    uint32_t stalls;       /* Members marked stalled */
+    uint32_t lastTime;     /* CGU_TS of the last reference member block */
+    uint32_t period;       /* Filtered block period, Q8 CGU_TS ticks */
+} CLOCK_DOMAIN_STATE;
+
 #endif
@@ -25,6 +25,7 @@ void dacAudioOut(void *buffer, uint32_t maxSize, void *usrPtr)
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     SAE_MSG_BUFFER *msg = NULL;
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -37,11 +38,11 @@ void dacAudioOut(void *buffer, uint32_t maxSize, void *usrPtr)
     }
 
     /* This is the CLOCK_DOMAIN_SYSTEM "out" clock source */
-    sharcAudio(context, CLOCK_DOMAIN_BITM_CODEC_OUT, msg, true, false);
+    sharcAudio(context, CLOCK_DOMAIN_BITM_CODEC_OUT, msg, false);
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "dacAudioOut", outCycles - inCycles);
 }
 
 void adcAudioIn(void *buffer, uint32_t size, void *usrPtr)
@@ -49,6 +50,7 @@ void adcAudioIn(void *buffer, uint32_t size, void *usrPtr)
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     SAE_MSG_BUFFER *msg = NULL;
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -61,9 +63,9 @@ void adcAudioIn(void *buffer, uint32_t size, void *usrPtr)
     }
 
     /* This is the CLOCK_DOMAIN_SYSTEM "in" clock source */
-    sharcAudio(context, CLOCK_DOMAIN_BITM_CODEC_IN, msg, true, true);
+    sharcAudio(context, CLOCK_DOMAIN_BITM_CODEC_IN, msg, true);
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "adcAudioIn", outCycles - inCycles);
 }
@@ -50,11 +50,15 @@
 #include "codec_audio.h"
 #include "spdif_audio.h"
 #include "a2b_audio.h"
+#include "a2b_slave.h"
 #include "mic_audio.h"
 #include "util.h"
 #include "sae_irq.h"
 #include "flash_map.h"
 #include "clock_domain.h"
+#include "spiffs_fs.h"
+#include "route_control.h"
+#include "meter_capture.h"
 
 /***********************************************************************
  * Audio Clock Initialization
@@ -171,6 +175,55 @@ void mclk_init(APP_CONTEXT *context)
     pcg_init_dai1_tdm8_bclk();
 }
 
+/***********************************************************************
+ * System sample rate clock plan
+ *
+ * MCLK comes from a fixed 24.576MHz clock generator.  Rather than
+ * changing MCLK, every rate keeps the DAC BCLK at MCLK (24.576MHz) and
+ * the ADC BCLK at PCG D (12.288MHz) and trades TDM slots for rate.
+ * The SPDIF PCGs are re-divided per rate.  The SPDIF TX HFCLK cannot
+ * reach 256fs at 192kHz and the A2B bus only runs at 48kHz so those
+ * interfaces are stopped at the higher rates.
+ **********************************************************************/
+typedef struct SAMPLE_RATE_PLAN {
+    uint32_t rate;
+    SPORT_SIMPLE_TDM dacSlots;
+    SPORT_SIMPLE_TDM adcSlots;
+    bool spdif;
+    bool a2b;
+} SAMPLE_RATE_PLAN;
+
+static const SAMPLE_RATE_PLAN sampleRatePlan[] = {
+    { 48000,  SPORT_SIMPLE_TDM_16, SPORT_SIMPLE_TDM_8, true,  true  },
+    { 96000,  SPORT_SIMPLE_TDM_8,  SPORT_SIMPLE_TDM_4, true,  false },
+    { 192000, SPORT_SIMPLE_TDM_4,  SPORT_SIMPLE_TDM_2, false, false },
+};
+
+static const uint32_t sampleRates[] = { 48000, 96000, 192000 };
+
+#define SAMPLE_RATE_PLANS (sizeof(sampleRatePlan) / sizeof(sampleRatePlan[0]))
+
+static const SAMPLE_RATE_PLAN *sample_rate_plan(uint32_t rate)
+{
+    unsigned i;
+    for (i = 0; i < SAMPLE_RATE_PLANS; i++) {
+        if (sampleRatePlan[i].rate == rate) {
+            /* DAC BCLK is always MCLK with 32-bit slots */
+            assert(sampleRatePlan[i].dacSlots * 32 * rate == SYSTEM_MCLK_RATE);
+            return(&sampleRatePlan[i]);
+        }
+    }
+    return(NULL);
+}
+
+unsigned system_sample_rates(const uint32_t **rates)
+{
+    if (rates) {
+        *rates = sampleRates;
+    }
+    return(SAMPLE_RATE_PLANS);
+}
+
 
 /***********************************************************************
  * GPIO / Pin MUX / SRU Initialization
@@ -433,6 +486,11 @@ void flash_init(APP_CONTEXT *context)
      * SC584 EZLIT uses the W25Q128 Flash Chip
      */
     context->flashHandle = w25q128fv_open(context->spiFlashHandle);
+
+    /* Serve flash reads from the SPI2 memory-mapped window */
+    if (context->flashHandle) {
+        flash_mmap(context->flashHandle, true);
+    }
 }
 
 /***********************************************************************
@@ -504,6 +562,28 @@ static sSPORT *single_sport_init(SPORT_SIMPLE_PORT sport,
     return(sportHandle);
 }
 
+void sportCfg2ipcMsg(SPORT_SIMPLE_CONFIG *sportCfg, unsigned dataLen, IPC_MSG *msg)
+{
+    msg->audio.wordSize = sportCfg->wordSize / 8;
+    msg->audio.numChannels = dataLen / (sportCfg->frames * msg->audio.wordSize);
+}
+
+/*
+ * The codec message buffers are sized for the most TDM slots.  Fewer
+ * slots are used at higher sample rates so update the channel count.
+ */
+static void codecMsgChannels(SAE_MSG_BUFFER *msgBuffer[2],
+    SPORT_SIMPLE_CONFIG *sportCfg, unsigned dataLen)
+{
+    IPC_MSG *msg;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        msg = (IPC_MSG *)sae_getMsgBufferPayload(msgBuffer[i]);
+        sportCfg2ipcMsg(sportCfg, dataLen, msg);
+    }
+}
+
 /***********************************************************************
  * Simple SPORT driver 8/16-ch packed I2S settings
  * Compatible A2B I2S Register settings:
@@ -576,8 +656,9 @@ static void adau1962_sport_init(APP_CONTEXT *context)
     SPORT_SIMPLE_RESULT sportResult;
     unsigned len;
 
-    /* SPORT4A: DAC 16-ch packed I2S data out */
+    /* SPORT4A: DAC 16-ch packed I2S data out (fewer slots above 48kHz) */
     sportCfg = cfg16chPackedI2S;
+    sportCfg.tdmSlots = sample_rate_plan(context->sampleRate)->dacSlots;
     sportCfg.dataDir = SPORT_SIMPLE_DATA_DIR_TX;
     sportCfg.dataEnable = SPORT_SIMPLE_ENABLE_PRIMARY;
     sportCfg.fsDir = SPORT_SIMPLE_FS_DIR_MASTER;
@@ -586,7 +667,8 @@ static void adau1962_sport_init(APP_CONTEXT *context)
         SPORT4A, &sportCfg, dacAudioOut,
         NULL, &len, context, false, NULL
     );
-    assert(context->codecAudioOutLen == len);
+    assert(len <= context->codecAudioOutLen);
+    codecMsgChannels(context->codecMsgOut, &sportCfg, len);
 
     if (context->dacSportOutHandle) {
         sportResult = sport_start(context->dacSportOutHandle, true);
@@ -601,7 +683,7 @@ static void adau1962_sport_deinit(APP_CONTEXT *context)
     }
 }
 
-void adau1962_init(APP_CONTEXT *context)
+void adau1962_init_hw(APP_CONTEXT *context)
 {
     /* Take the ADC and DAC out of reset */
     adi_gpio_Set(ADI_GPIO_PORT_A, ADI_GPIO_PIN_14);
@@ -611,12 +693,23 @@ void adau1962_init(APP_CONTEXT *context)
 
     /* Configure the SPORT */
     adau1962_sport_init(context);
-    
+}
+
+void adau1962_init_codec(APP_CONTEXT *context)
+{
     /* Wait for reset stability */
     delay(300);
 
     /* Initialize the DAC */
     init_adau1962(context->adau1962TwiHandle, ADAU1962_I2C_ADDR);
+    adau1962_set_sample_rate(context->adau1962TwiHandle, ADAU1962_I2C_ADDR,
+        context->sampleRate, sample_rate_plan(context->sampleRate)->dacSlots);
+}
+
+void adau1962_init(APP_CONTEXT *context)
+{
+    adau1962_init_hw(context);
+    adau1962_init_codec(context);
 }
 
 /***********************************************************************
@@ -652,8 +745,9 @@ static void adau1979_sport_init(APP_CONTEXT *context)
     SPORT_SIMPLE_RESULT sportResult;
     unsigned len;
 
-    /* SPORT6A: ADC 8-ch packed I2S data in */
+    /* SPORT6A: ADC 8-ch packed I2S data in (fewer slots above 48kHz) */
     sportCfg = cfg8chPackedI2S;
+    sportCfg.tdmSlots = sample_rate_plan(context->sampleRate)->adcSlots;
     sportCfg.dataDir = SPORT_SIMPLE_DATA_DIR_RX;
     sportCfg.dataEnable = SPORT_SIMPLE_ENABLE_PRIMARY;
     sportCfg.fsDir = SPORT_SIMPLE_FS_DIR_MASTER;
@@ -662,7 +756,8 @@ static void adau1979_sport_init(APP_CONTEXT *context)
         SPORT6A, &sportCfg, adcAudioIn,
         NULL, &len, context, true, NULL
     );
-    assert(context->codecAudioInLen == len);
+    assert(len <= context->codecAudioInLen);
+    codecMsgChannels(context->codecMsgIn, &sportCfg, len);
 
     if (context->adcSportInHandle) {
         sportResult = sport_start(context->adcSportInHandle, true);
@@ -677,7 +772,7 @@ static void adau1979_sport_deinit(APP_CONTEXT *context)
     }
 }
 
-void adau1979_init(APP_CONTEXT *context)
+void adau1979_init_hw(APP_CONTEXT *context)
 {
     /* Take the ADC and DAC out of reset */
     adi_gpio_Set(ADI_GPIO_PORT_A, ADI_GPIO_PIN_14);
@@ -687,12 +782,23 @@ void adau1979_init(APP_CONTEXT *context)
 
     /* Configure the SPORT */
     adau1979_sport_init(context);
-    
+}
+
+void adau1979_init_codec(APP_CONTEXT *context)
+{
     /* Wait for reset stability */
     delay(40);
 
     /* Initialize the ADC */
     init_adau1979(context->adau1962TwiHandle, ADAU1979_I2C_ADDR);
+    adau1979_set_sample_rate(context->adau1962TwiHandle, ADAU1979_I2C_ADDR,
+        context->sampleRate, sample_rate_plan(context->sampleRate)->adcSlots);
+}
+
+void adau1979_init(APP_CONTEXT *context)
+{
+    adau1979_init_hw(context);
+    adau1979_init_codec(context);
 }
 
 /***********************************************************************
@@ -726,8 +832,9 @@ static void adau1977_sport_init(APP_CONTEXT *context)
     SPORT_SIMPLE_RESULT sportResult;
     unsigned len;
 
-    /* SPORT6B: ADC 8-ch packed I2S data in */
+    /* SPORT6B: ADC 8-ch packed I2S data in (fewer slots above 48kHz) */
     sportCfg = cfg8chPackedI2S;
+    sportCfg.tdmSlots = sample_rate_plan(context->sampleRate)->adcSlots;
     sportCfg.dataDir = SPORT_SIMPLE_DATA_DIR_RX;
     sportCfg.dataEnable = SPORT_SIMPLE_ENABLE_PRIMARY;
     sportCfg.fsDir = SPORT_SIMPLE_FS_DIR_MASTER;
@@ -736,7 +843,8 @@ static void adau1977_sport_init(APP_CONTEXT *context)
         SPORT6B, &sportCfg, micAudioIn,
         NULL, &len, context, true, NULL
     );
-    assert(context->micAudioInLen == len);
+    assert(len <= context->micAudioInLen);
+    codecMsgChannels(context->micMsgIn, &sportCfg, len);
 
     if (context->micSportInHandle) {
         sportResult = sport_start(context->micSportInHandle, true);
@@ -751,7 +859,7 @@ static void adau1977_sport_deinit(APP_CONTEXT *context)
     }
 }
 
-void adau1977_init(APP_CONTEXT *context)
+void adau1977_init_hw(APP_CONTEXT *context)
 {
     /* Take the ADC and DAC out of reset */
     adi_gpio_Set(ADI_GPIO_PORT_A, ADI_GPIO_PIN_15);
@@ -761,12 +869,23 @@ void adau1977_init(APP_CONTEXT *context)
 
     /* Configure the SPORT */
     adau1977_sport_init(context);
-    
+}
+
+void adau1977_init_codec(APP_CONTEXT *context)
+{
     /* Wait for reset stability */
     delay(40);
 
     /* Initialize the ADC */
     init_adau1977(context->adau1977TwiHandle, ADAU1977_I2C_ADDR);
+    adau1977_set_sample_rate(context->adau1977TwiHandle, ADAU1977_I2C_ADDR,
+        context->sampleRate, sample_rate_plan(context->sampleRate)->adcSlots);
+}
+
+void adau1977_init(APP_CONTEXT *context)
+{
+    adau1977_init_hw(context);
+    adau1977_init_codec(context);
 }
 
 /**************************************************************************
@@ -785,10 +904,10 @@ SPORT_SIMPLE_CONFIG cfgI2Sx1 = {
     .frames = SYSTEM_BLOCK_SIZE,
 };
 
-/* PCGB generates 3.072 MHz I2S BCLK from 24.576 MCLK/BCLK 
- * and PCGA generates a 12.288MHz from CRS PIN03
+/* PCGB generates a 64fs I2S BCLK (3.072 MHz @ 48kHz) from 24.576 MCLK/BCLK
+ * and PCGA generates a 256fs HFCLK (12.288MHz @ 48kHz) from CRS PIN03
  */
-void spdif_cfg_pcg(void)
+void spdif_cfg_pcg(uint32_t fs)
 {
     /* Configure static PCG B parameters */
     PCG_SIMPLE_CONFIG pcg_b = {
@@ -801,7 +920,7 @@ void spdif_cfg_pcg(void)
 
     /* Configure the PCG BCLK depending on the cfgI2Sx1 SPORT config */
     pcg_b.bitclk_div =
-        SYSTEM_MCLK_RATE / (cfgI2Sx1.wordSize * cfgI2Sx1.tdmSlots * SYSTEM_SAMPLE_RATE);
+        SYSTEM_MCLK_RATE / (cfgI2Sx1.wordSize * cfgI2Sx1.tdmSlots * fs);
     assert(pcg_b.bitclk_div > 0);
 
     /* This sets everything up */
@@ -817,8 +936,11 @@ void spdif_cfg_pcg(void)
         .sync_to_fs = false
     };
 
-    /* Configure the PCG BCLK depending on the cfgI2Sx1 SPORT config */
-    pcg_a.bitclk_div = 2;
+    /* Configure the PCG HFCLK for 256fs */
+    pcg_a.bitclk_div = SYSTEM_MCLK_RATE / (256 * fs);
+    if (pcg_a.bitclk_div == 0) {
+        pcg_a.bitclk_div = 1;
+    }
 
     /* This sets everything up */
     pcg_open(&pcg_a);
@@ -842,8 +964,15 @@ static void spdif_sru_config(void)
     SRU(DAI0_PB19_O, SPDIF0_RX_I);  // route DAI0_PB19 to SPDIF RX
     SRU(SPDIF0_TX_O, DAI0_PB20_I);  // route SPDIF TX to DAI0_PB20
 
-    // Connect 64Fs BCLK to SPORT2A/B
+    // Connect 64Fs BCLK to SPORT2A
     SRU(PCG0_CLKB_O, SPT2_ACLK_I);     // route PCG 64fs BCLK signal to SPORT2A BCLK
+
+#if SPDIF_IN_ASRC_BYPASS
+    // Clock SPORT2B directly from the SPDIF receiver (CLOCK_DOMAIN_SPDIF)
+    SRU(SPDIF0_RX_CLK_O, SPT2_BCLK_I);   // route SPDIF RX BCLK to SPORT2B BCLK
+    SRU(SPDIF0_RX_FS_O,  SPT2_BFS_I);    // route SPDIF RX FS to SPORT2B FS
+    SRU(SPDIF0_RX_DAT_O, SPT2_BD0_I);    // route SPDIF RX Data to SPORT2B data
+#else
     SRU(PCG0_CLKB_O, SPT2_BCLK_I);     // route PCG 64fs BCLK signal to SPORT2B BCLK
 
     // Connect SPDIF RX to SRC 0 "IP" side
@@ -855,6 +984,7 @@ static void spdif_sru_config(void)
     SRU(PCG0_CLKB_O,   SRC0_CLK_OP_I);     // route PCG 64fs BCLK signal to SRC OP BCLK
     SRU(SPT2_BFS_O,    SRC0_FS_OP_I);      // route PCG FS signal to SRC OP FS
     SRU(SRC0_DAT_OP_O, SPT2_BD0_I);        // route SRC0 OP Data output to SPORT 2B data
+#endif
 
     // Connect 256Fs MCLK to SPDIF TX
     SRU(PCG0_CLKA_O, SPDIF0_TX_HFCLK_I);   // route PCGA_CLK to SPDIF TX HFCLK
@@ -896,6 +1026,9 @@ void spdif_sport_init(APP_CONTEXT *context)
     /* SPORT2B: SPDIF data in */
     sportCfg = cfgI2Sx1;
     sportCfg.dataDir = SPORT_SIMPLE_DATA_DIR_RX;
+#if SPDIF_IN_ASRC_BYPASS
+    sportCfg.fsDir = SPORT_SIMPLE_FS_DIR_SLAVE;
+#endif
     sportCfg.dataBuffersCached = false;
     memcpy(sportCfg.dataBuffers, context->spdifAudioIn, sizeof(sportCfg.dataBuffers));
     context->spdifSportInHandle = single_sport_init(
@@ -911,12 +1044,14 @@ void spdif_sport_init(APP_CONTEXT *context)
 
 void spdif_asrc_init(void)
 {
+#if !SPDIF_IN_ASRC_BYPASS
     // Configure and enable SRC 0/1
     *pREG_ASRC0_CTL01 =
         BITM_ASRC_CTL01_EN0 |                // Enable SRC0
         (0x1 << BITP_ASRC_CTL01_SMODEIN0) |  // Input mode = I2S
         (0x1 << BITP_ASRC_CTL01_SMODEOUT0) | // Output mode = I2S
         0;
+#endif
 
     // Configure and enable SPDIF RX
     *pREG_SPDIF0_RX_CTL =
@@ -943,7 +1078,7 @@ void spdif_init(APP_CONTEXT *context)
     spdif_sru_config();
 
     /* Initialize the SPDIF HFCLK PCG */
-    spdif_cfg_pcg();
+    spdif_cfg_pcg(context->sampleRate);
 
     /* Initialize the SPDIF and ASRC modules */
     spdif_asrc_init();
@@ -1272,12 +1407,6 @@ void ad2425_reset(APP_CONTEXT *context)
 #endif
 }
 
-void sportCfg2ipcMsg(SPORT_SIMPLE_CONFIG *sportCfg, unsigned dataLen, IPC_MSG *msg)
-{
-    msg->audio.wordSize = sportCfg->wordSize / 8;
-    msg->audio.numChannels = dataLen / (sportCfg->frames * msg->audio.wordSize);
-}
-
 bool ad2425_sport_init(APP_CONTEXT *context,
     bool master, CLOCK_DOMAIN clockDomain, uint8_t I2SGCFG, uint8_t I2SCFG,
     bool verbose)
@@ -1303,7 +1432,7 @@ bool ad2425_sport_init(APP_CONTEXT *context,
         sportCfg.fsDir = SPORT_SIMPLE_FS_DIR_SLAVE;
     }
     sportCfg.frames = SYSTEM_BLOCK_SIZE;
-    sportCfg.fs = SYSTEM_SAMPLE_RATE;
+    sportCfg.fs = context->sampleRate;
     sportCfg.dataBuffersCached = false;
     memcpy(sportCfg.dataBuffers, context->a2bAudioOut, sizeof(sportCfg.dataBuffers));
     context->a2bSportOutHandle = single_sport_init(
@@ -1334,7 +1463,7 @@ bool ad2425_sport_init(APP_CONTEXT *context,
     sportCfg.clkDir = SPORT_SIMPLE_CLK_DIR_SLAVE;
     sportCfg.fsDir = SPORT_SIMPLE_FS_DIR_SLAVE;
     sportCfg.frames = SYSTEM_BLOCK_SIZE;
-    sportCfg.fs = SYSTEM_SAMPLE_RATE;
+    sportCfg.fs = context->sampleRate;
     sportCfg.dataBuffersCached = false;
     memcpy(sportCfg.dataBuffers, context->a2bAudioIn, sizeof(sportCfg.dataBuffers));
     context->a2bSportInHandle = single_sport_init(
@@ -1374,6 +1503,11 @@ bool ad2425_init_master(APP_CONTEXT *context)
 {
     bool ok;
 
+    /* The A2B bus only runs in the 48kHz superframe */
+    if (!sample_rate_plan(context->sampleRate)->a2b) {
+        return(false);
+    }
+
     sru_config_a2b_master();
 
     ok = ad2425_sport_init(context, true, CLOCK_DOMAIN_SYSTEM,
@@ -1426,6 +1560,9 @@ bool ad2425_set_mode(APP_CONTEXT *context, A2B_BUS_MODE mode)
 
     ad2425_restart(context);
 
+    /* Let the slave task pick up the new mode */
+    a2bSlaveNotify(context);
+
     return(true);
 }
 
@@ -1443,17 +1580,120 @@ bool ad2425_sport_stop(APP_CONTEXT *context)
     bool ok;
     ok = ad2425_sport_deinit(context);
     ad2425_disconnect_slave_clocks();
+    clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_A2B_IN);
+    clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_A2B_OUT);
     return(ok);
 }
 
+/*
+ * Moves the whole system clock domain to a new sample rate.  All SPORTs
+ * are stopped and restarted together behind the MCLK gate so they stay
+ * frame aligned.  Runs in task context (codec TWI writes).
+ */
+bool system_set_sample_rate(APP_CONTEXT *context, uint32_t rate)
+{
+    const SAMPLE_RATE_PLAN *plan;
+    bool a2bMaster;
+
+    plan = sample_rate_plan(rate);
+    if (plan == NULL) {
+        return(false);
+    }
+    if (rate == context->sampleRate) {
+        return(true);
+    }
+
+    a2bMaster = (context->a2bmode == A2B_BUS_MODE_MASTER);
+
+    /* Stop everything in the system clock domain */
+    disable_sport_mclk(context);
+    adau1962_sport_deinit(context);
+    adau1979_sport_deinit(context);
+    adau1977_sport_deinit(context);
+    spdif_sport_deinit(context);
+    if (a2bMaster) {
+        ad2425_sport_deinit(context);
+        ad2425_disconnect_master_clocks();
+    }
+
+    context->sampleRate = rate;
+    meter_capture_rate(context);
+
+    /* Reprogram the codecs and the SPDIF clocks */
+    adau1962_set_sample_rate(context->adau1962TwiHandle, ADAU1962_I2C_ADDR,
+        rate, plan->dacSlots);
+    adau1979_set_sample_rate(context->adau1962TwiHandle, ADAU1979_I2C_ADDR,
+        rate, plan->adcSlots);
+    adau1977_set_sample_rate(context->adau1977TwiHandle, ADAU1977_I2C_ADDR,
+        rate, plan->adcSlots);
+    spdif_cfg_pcg(rate);
+
+    /* Restart the SPORTs supported at this rate */
+    adau1962_sport_init(context);
+    adau1979_sport_init(context);
+    adau1977_sport_init(context);
+    if (plan->spdif) {
+        spdif_sport_init(context);
+        clock_domain_set(context, SPDIF_IN_CLOCK_DOMAIN, CLOCK_DOMAIN_BITM_SPDIF_IN);
+        clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_SPDIF_OUT);
+    } else {
+        clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_SPDIF_IN);
+        clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_SPDIF_OUT);
+    }
+    if (a2bMaster) {
+        if (plan->a2b) {
+            ad2425_init_master(context);
+        } else {
+            clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_A2B_IN);
+            clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_A2B_OUT);
+        }
+    }
+    enable_sport_mclk(context);
+
+    if (a2bMaster && plan->a2b) {
+        ad2425_restart(context);
+    }
+
+    return(true);
+}
+
 void system_reset(APP_CONTEXT *context)
 {
+    if (context->spiffsHandle) {
+        spiffs_index_save(context->spiffsHandle);
+    }
     w25q128fv_close(context->flashHandle);
     taskENTER_CRITICAL();
     *pREG_RCU0_CTL = BITM_RCU_CTL_SYSRST | BITM_RCU_CTL_RSTOUTASRT;
     while(1);
 }
 
+/***********************************************************************
+ * SHARC Audio Engine (SAE) SDRAM pool
+ **********************************************************************/
+#ifndef SAE_SDRAM_POOL_SIZE
+#define SAE_SDRAM_POOL_SIZE (512 * 1024)
+#endif
+
+__attribute__ ((section(".l3_uncached_data")))
+    static uint8_t sae_sdram_pool[SAE_SDRAM_POOL_SIZE];
+
+/*
+ * Adds an uncached SDRAM pool to the SAE heap for bulk and control
+ * messages so the shared L2 pool is kept for audio.  Must be called
+ * before the SHARCs are started.
+ */
+void sae_pool_init(APP_CONTEXT *context)
+{
+    SAE_RESULT result;
+
+    result = sae_addPool(context->saeContext, SAE_POOL_SDRAM,
+        sae_sdram_pool, sizeof(sae_sdram_pool));
+    if (result != SAE_RESULT_OK) {
+        syslog_print("SAE SDRAM pool init failed\n");
+    }
+}
+
 /***********************************************************************
  * SHARC Audio Engine (SAE) Audio IPC buffer configuration
  **********************************************************************/
@@ -1481,7 +1721,8 @@ static SAE_MSG_BUFFER *allocateIpcAudioMsg(APP_CONTEXT *context,
     /* Allocate a message buffer and initialize both the USB_IPC_SRC_MSG's
      * 'msgBuffer' and 'msg' members.
      */
-    msgBuffer = sae_createMsgBuffer(saeContext, msgSize, (void **)&msg);
+    msgBuffer = sae_createMsgBuffer(saeContext, msgSize,
+        SAE_ALLOC_FAST, (void **)&msg);
     assert(msgBuffer);
 
     /* Set fixed 'IPC_MSG_AUDIO' parameters */
@@ -1645,22 +1886,9 @@ void sae_buffer_init(APP_CONTEXT *context)
  */
 void audio_routing_init(APP_CONTEXT *context)
 {
-    SAE_CONTEXT *saeContext = context->saeContext;
-    IPC_MSG *msg;
-    unsigned msgSize;
-
-    /* Create an IPC message large enough to hold the routing table */
-    msgSize = sizeof(*msg) +
-        (MAX_AUDIO_ROUTES - 1) * sizeof(ROUTE_INFO);
-
-    /* Allocate a message buffer */
-    context->routingMsgBuffer = sae_createMsgBuffer(
-        saeContext, msgSize, (void **)&context->routingMsg
-    );
-    assert(context->routingMsgBuffer);
+    IPC_MSG_ROUTING *routes;
 
-    /* Initialize the message and routing table */
-    memset(context->routingMsg, 0 , msgSize);
-    context->routingMsg->type = IPC_TYPE_AUDIO_ROUTING;
-    context->routingMsg->routes.numRoutes = MAX_AUDIO_ROUTES;
+    /* Start with an empty table, published once SHARC0 is up */
+    routes = route_control_begin(context, true);
+    assert(routes);
 }
@@ -25,6 +25,19 @@ void flash_init(APP_CONTEXT *context);
 void adau1977_init(APP_CONTEXT *context);
 void adau1962_init(APP_CONTEXT *context);
 void adau1979_init(APP_CONTEXT *context);
+
+/*
+ * Split codec init for the boot sequencer.  The _hw() half releases
+ * reset and does the SRU/SPORT setup and must run serialized with all
+ * other SRU users.  The _codec() half waits out the reset time and
+ * programs the codec over I2C and may run concurrently.
+ */
+void adau1977_init_hw(APP_CONTEXT *context);
+void adau1977_init_codec(APP_CONTEXT *context);
+void adau1962_init_hw(APP_CONTEXT *context);
+void adau1962_init_codec(APP_CONTEXT *context);
+void adau1979_init_hw(APP_CONTEXT *context);
+void adau1979_init_codec(APP_CONTEXT *context);
 void spdif_init(APP_CONTEXT *context);
 bool ad2425_init_master(APP_CONTEXT *context);
 void ad2425_reset(APP_CONTEXT *context);
@@ -37,6 +50,10 @@ void mclk_init(APP_CONTEXT *context);
 void disable_sport_mclk(APP_CONTEXT *context);
 void enable_sport_mclk(APP_CONTEXT *context);
 
+unsigned system_sample_rates(const uint32_t **rates);
+bool system_set_sample_rate(APP_CONTEXT *context, uint32_t rate);
+
+void sae_pool_init(APP_CONTEXT *context);
 void sae_buffer_init(APP_CONTEXT *context);
 void audio_routing_init(APP_CONTEXT *context);
 
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "context.h"
+#include "latency_probe.h"
+#include "latency.h"
+#include "ipc.h"
+#include "sae.h"
+
+LATENCY_PROBE *latency_probe_open(APP_CONTEXT *context)
+{
+    SAE_CONTEXT *saeContext = context->saeContext;
+    LATENCY_PROBE *lp;
+    SAE_RESULT result;
+    IPC_MSG *msg;
+
+    if (context->latencyMsgBuffer == NULL) {
+        context->latencyMsgBuffer = sae_createMsgBuffer(saeContext,
+            sizeof(*msg) + latency_size(), SAE_ALLOC_BULK, (void **)&msg);
+        if (context->latencyMsgBuffer == NULL) {
+            return(NULL);
+        }
+        msg->type = IPC_TYPE_LATENCY;
+        lp = latency_init(msg->latency.probe);
+        latency_attach(lp);
+
+        /* The ARM keeps its own reference so the table is never freed */
+        sae_refMsgBuffer(saeContext, context->latencyMsgBuffer);
+        result = sae_sendMsgBuffer(saeContext, context->latencyMsgBuffer,
+            IPC_CORE_SHARC0, true);
+        if (result != SAE_RESULT_OK) {
+            sae_unRefMsgBuffer(saeContext, context->latencyMsgBuffer);
+        }
+    }
+
+    return(latency_get());
+}
+
+bool latency_probe_trial(APP_CONTEXT *context, const LATENCY_PROBE_CFG *cfg,
+    LATENCY_RESULT *result)
+{
+    LATENCY_PROBE *lp;
+    TickType_t start, timeout;
+    int32_t level;
+    bool ok;
+
+    lp = latency_probe_open(context);
+    if (lp == NULL) {
+        return(false);
+    }
+
+    level = (int32_t)(2147483647.0f * powf(10.0f, (float)cfg->levelDb / 20.0f));
+    ok = latency_arm(lp, cfg->srcID, cfg->srcChannel,
+        cfg->sinkID, cfg->sinkChannel, cfg->signal, level, cfg->captureLen);
+    if (!ok) {
+        return(false);
+    }
+
+    timeout = pdMS_TO_TICKS(LATENCY_PROBE_TIMEOUT_MS +
+        (cfg->captureLen * 1000) / context->sampleRate);
+    start = xTaskGetTickCount();
+    while ((lp->state == LATENCY_STATE_ARMED) ||
+           (lp->state == LATENCY_STATE_RUNNING)) {
+        if ((xTaskGetTickCount() - start) > timeout) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LATENCY_PROBE_POLL_MS));
+    }
+
+    ok = latency_analyze(lp, result);
+    if (!ok) {
+        latency_abort(lp);
+    }
+
+    return(ok);
+}
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _latency_probe_h
+#define _latency_probe_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "context.h"
+#include "latency.h"
+
+/* How often a trial in progress is checked */
+#ifndef LATENCY_PROBE_POLL_MS
+#define LATENCY_PROBE_POLL_MS      (10)
+#endif
+
+/* Extra time allowed beyond the capture length */
+#ifndef LATENCY_PROBE_TIMEOUT_MS
+#define LATENCY_PROBE_TIMEOUT_MS   (500)
+#endif
+
+typedef struct _LATENCY_PROBE_CFG {
+    uint8_t srcID;
+    uint8_t srcChannel;
+    uint8_t sinkID;
+    uint8_t sinkChannel;
+    LATENCY_SIGNAL signal;
+    int levelDb;
+    unsigned captureLen;
+} LATENCY_PROBE_CFG;
+
+/*
+ * Allocate the shared probe table and hand it to SHARC0 (first time
+ * only)
+ */
+LATENCY_PROBE *latency_probe_open(APP_CONTEXT *context);
+
+/*
+ * Run one trial and analyze the capture.  Returns false if the probe
+ * is busy, the streams or channels are invalid or the detect stream
+ * never produced a full capture.
+ */
+bool latency_probe_trial(APP_CONTEXT *context, const LATENCY_PROBE_CFG *cfg,
+    LATENCY_RESULT *result);
+
+#endif
@@ -58,10 +58,19 @@
 #include "a2b_slave.h"
 #include "clock_domain.h"
 #include "ss_init.h"
+#include "trace_capture.h"
+#include "bench.h"
+#include "boot.h"
+#include "route_control.h"
 
 /* Application context */
 APP_CONTEXT mainAppContext;
 
+/* SPIFFS mount index snapshot check interval */
+#ifndef SPIFFS_INDEX_SYNC_MS
+#define SPIFFS_INDEX_SYNC_MS  (10000)
+#endif
+
 /* Select proper driver API for stdio operations */
 #ifdef USB_CDC_STDIO
 #define uart_open uart_cdc_open
@@ -111,9 +120,28 @@ uint32_t getTimeStamp(void)
     return timeStamp;
 }
 
+/* Full 64-bit count, re-reading the high word if the low one wrapped */
+uint64_t getTimeStamp64(void)
+{
+    uint32_t hi, lo;
+
+    do {
+        hi = *pREG_CGU0_TSCOUNT1;
+        lo = *pREG_CGU0_TSCOUNT0;
+    } while (hi != *pREG_CGU0_TSCOUNT1);
+
+    return(((uint64_t)hi << 32) | lo);
+}
+
 void taskSwitchHook(void *taskHandle)
 {
     cpuLoadtaskSwitchHook(taskHandle);
+    trace_task_switch(taskHandle);
+}
+
+void taskDeleteHook(void *taskHandle)
+{
+    cpuLoadtaskDeleteHook(taskHandle);
 }
 
 uint32_t elapsedTimeMs(uint32_t elapsed)
@@ -175,7 +203,8 @@ SAE_RESULT quickIpcToCore(APP_CONTEXT *context, enum IPC_TYPE type, SAE_CORE_IDX
     SAE_RESULT result;
     IPC_MSG *msg;
 
-    ipcBuffer = sae_createMsgBuffer(saeContext, sizeof(*msg), (void **)&msg);
+    ipcBuffer = sae_createMsgBuffer(saeContext, sizeof(*msg),
+        SAE_ALLOC_BULK, (void **)&msg);
     msg->type = type;
 
     result = ipcToCore(saeContext, ipcBuffer, core);
@@ -198,7 +227,7 @@ static void ipcMsgHandler(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
     /* Process the message */
     switch (msg->type) {
         case IPC_TYPE_PING:
-            /* Do nothing */
+            bench_ping_rx(&msg->ping);
             break;
         case IPC_TYPE_SHARC0_READY:
             context->sharc0Ready = true;
@@ -213,6 +242,7 @@ static void ipcMsgHandler(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
             for (i = 0; i < max; i++) {
                 if (cycles->core == IPC_CORE_SHARC0) {
                         context->sharc0Cycles[i] = cycles->cycles[i];
+                        context->sharc0CoreCycles[i] = cycles->coreCycles[i];
                 } else if (cycles->core == IPC_CORE_SHARC1) {
                         context->sharc1Cycles[i] = cycles->cycles[i];
                 }
@@ -236,7 +266,7 @@ static portTASK_FUNCTION( houseKeepingTask, pvParameters )
     APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
     SAE_CONTEXT *saeContext = context->saeContext;
     SAE_MSG_BUFFER *msgBuffer;
-    TickType_t flashRate, lastFlashTime, clk, lastClk;
+    TickType_t flashRate, lastFlashTime, clk, lastClk, lastSync;
     bool calcLoad;
     IPC_MSG *msg;
 
@@ -244,6 +274,7 @@ static portTASK_FUNCTION( houseKeepingTask, pvParameters )
     flashRate = pdMS_TO_TICKS(500);
     lastFlashTime = xTaskGetTickCount();
     lastClk = xTaskGetTickCount();
+    lastSync = lastClk;
 
     /* Calculate the system load every other cycle */
     calcLoad = false;
@@ -263,16 +294,19 @@ static portTASK_FUNCTION( houseKeepingTask, pvParameters )
         adi_gpio_Toggle(ADI_GPIO_PORT_E, ADI_GPIO_PIN_1);
 
         /* Ping both SHARCs with the same message */
-        msgBuffer = sae_createMsgBuffer(saeContext, sizeof(*msg), (void **)&msg);
+        msgBuffer = sae_createMsgBuffer(saeContext, sizeof(*msg),
+            SAE_ALLOC_BULK, (void **)&msg);
         if (msgBuffer) {
             msg->type = IPC_TYPE_PING;
+            msg->ping.seq = 0;
             sae_refMsgBuffer(saeContext, msgBuffer);
             ipcToCore(saeContext, msgBuffer, IPC_CORE_SHARC0);
             ipcToCore(saeContext, msgBuffer, IPC_CORE_SHARC1);
         }
 
         /* Get cycles from both SHARCs */
-        msgBuffer = sae_createMsgBuffer(saeContext, sizeof(*msg), (void **)&msg);
+        msgBuffer = sae_createMsgBuffer(saeContext, sizeof(*msg),
+            SAE_ALLOC_BULK, (void **)&msg);
         if (msgBuffer) {
             msg->type = IPC_TYPE_CYCLES;
             sae_refMsgBuffer(saeContext, msgBuffer);
@@ -284,6 +318,14 @@ static portTASK_FUNCTION( houseKeepingTask, pvParameters )
         context->now += (uint64_t)(clk - lastClk);
         lastClk = clk;
 
+        /* Snapshot the SPIFFS mount index once the filesystem is idle */
+        if ((clk - lastSync) >= pdMS_TO_TICKS(SPIFFS_INDEX_SYNC_MS)) {
+            if (context->spiffsHandle) {
+                spiffs_index_sync(context->spiffsHandle);
+            }
+            lastSync = clk;
+        }
+
         /* Sleep for a while */
         vTaskDelayUntil( &lastFlashTime, flashRate );
 
@@ -316,48 +358,51 @@ static void execShellCmdFile(SHELL_CONTEXT *context)
 }
 
 
-/* System startup task -> background shell task */
-static portTASK_FUNCTION( startupTask, pvParameters )
+/***********************************************************************
+ * Boot stages
+ *
+ * Stages touching the SRU or the SPORT configuration are chained
+ * through their dependencies so they never run concurrently.  The
+ * codec reset waits and I2C setup, the A2B discovery and the SPIFFS
+ * mount are free to overlap.
+ *
+ * The soft switches set up in the TWI stage gate the SPI2 flash chip
+ * select and the codec, SPDIF and A2B enables, so everything touching
+ * that hardware depends on the TWI stage.
+ **********************************************************************/
+enum {
+    BOOT_TWI = 0,
+    BOOT_SAE,
+    BOOT_FLASH,
+    BOOT_SPIFFS,
+    BOOT_BUFFERS,
+    BOOT_MCLK,
+    BOOT_CODEC_HW,
+    BOOT_SPDIF,
+    BOOT_A2B,
+    BOOT_DAC,
+    BOOT_ADC,
+    BOOT_MIC,
+    BOOT_AUDIO
+};
+
+static bool boot_twi(APP_CONTEXT *context)
 {
-    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
-    SPI_SIMPLE_RESULT spiResult;
     TWI_SIMPLE_RESULT twiResult;
-    SPORT_SIMPLE_RESULT sportResult;
-    FS_DEVMAN_DEVICE *device;
-    FS_DEVMAN_RESULT fsdResult;
-    s32_t spiffsResult;
-
-    /* Initialize the CPU load module. */
-    cpuLoadInit(getTimeStamp, CGU_TS_CLK);
-
-    /* Initialize the simple SPI driver */
-    spiResult = spi_init();
-
-    /* Initialize the simple TWI driver */
-    twiResult = twi_init();
-
-    /* Initialize the simple SPORT driver */
-    sportResult = sport_init();
-
-    /* Intialize the filesystem device manager */
-    fs_devman_init();
-
-    /* Intialize the filesystem device I/O layer */
-    fs_devio_init();
 
     /* Open up a global device handle for TWI0 @ 400KHz */
     twiResult = twi_open(TWI0, &context->twi0Handle);
     if (twiResult != TWI_SIMPLE_SUCCESS) {
         syslog_print("Could not open TWI0 device handle!");
-        return;
+        return(false);
     }
     twi_setSpeed(context->twi0Handle, TWI_SIMPLE_SPEED_400);
-    
+
     /* Open up a global device handle for TWI2 @ 400KHz */
     twiResult = twi_open(TWI2, &context->twi2Handle);
     if (twiResult != TWI_SIMPLE_SUCCESS) {
         syslog_print("Could not open TWI2 device handle!");
-        return;
+        return(false);
     }
     twi_setSpeed(context->twi2Handle, TWI_SIMPLE_SPEED_400);
 
@@ -368,16 +413,24 @@ static portTASK_FUNCTION( startupTask, pvParameters )
     context->adau1962TwiHandle = context->twi0Handle;
     context->softSwitchHandle = context->twi0Handle;
     context->adau1977TwiHandle = context->twi0Handle;
-    
+
     /* Initialize the soft switches */
     ss_init(context);
 
+    return(true);
+}
+
+static bool boot_sae(APP_CONTEXT *context)
+{
     /* Init the SHARC Audio Engine.  This core is configured to be the
      * IPC master so this function must run to completion before any
      * other core calls sae_initialize().
      */
     sae_initialize(&context->saeContext, SAE_CORE_IDX_0, true);
 
+    /* Add the SDRAM pool to the SAE heap */
+    sae_pool_init(context);
+
     /* Register an IPC message callback */
     sae_registerMsgReceivedCallback(context->saeContext,
         ipcMsgHandler, context);
@@ -386,8 +439,21 @@ static portTASK_FUNCTION( startupTask, pvParameters )
     adi_core_enable(ADI_CORE_SHARC0);
     adi_core_enable(ADI_CORE_SHARC1);
 
+    return(true);
+}
+
+static bool boot_flash(APP_CONTEXT *context)
+{
     /* Initialize the flash */
     flash_init(context);
+    return(context->flashHandle != NULL);
+}
+
+static bool boot_spiffs(APP_CONTEXT *context)
+{
+    FS_DEVMAN_DEVICE *device;
+    FS_DEVMAN_RESULT fsdResult;
+    s32_t spiffsResult;
 
     /* Initialize the SPIFFS filesystem */
     context->spiffsHandle = umm_calloc(1, sizeof(*context->spiffsHandle));
@@ -398,10 +464,17 @@ static portTASK_FUNCTION( startupTask, pvParameters )
         fsdResult = fs_devman_set_default(SPIFFS_VOL_NAME);
     } else {
         syslog_print("SPIFFS mount error, reformat via command line and reset\n");
+        return(false);
     }
 
+    return(fsdResult == FS_DEVMAN_OK);
+}
+
+static bool boot_buffers(APP_CONTEXT *context)
+{
     /* Load configuration */
     setAppDefaults(&context->cfg);
+    context->sampleRate = SYSTEM_SAMPLE_RATE;
 
     /* Initialize the IPC audio buffers in shared L2 SAE memory */
     sae_buffer_init(context);
@@ -412,40 +485,137 @@ static portTASK_FUNCTION( startupTask, pvParameters )
     /* Initialize the wave audio module */
     wav_audio_init(context);
 
-    /* Tell SHARC0 where to find the routing table.  Add a reference to
-     * so it doesn't get destroyed upon receipt.
-     */
-    sae_refMsgBuffer(context->saeContext, context->routingMsgBuffer);
-    ipcToCore(context->saeContext, context->routingMsgBuffer, IPC_CORE_SHARC0);
+    /* Hand SHARC0 its first routing table */
+    if (!route_control_publish(context)) {
+        syslog_print("Could not publish the routing table!");
+        return(false);
+    }
+
+    return(true);
+}
 
+static bool boot_mclk(APP_CONTEXT *context)
+{
     /* Disable main MCLK/BCLK */
     disable_sport_mclk(context);
-    
+
     /* Initialize main MCLK/BCLK */
     mclk_init(context);
-    
-    /* Initialize the ADAU1962 DAC */
-    adau1962_init(context);
-    
-    /* Initialize the ADAU1977 ADC */
-    adau1977_init(context);
-    
-    /* Initialize the ADAU1979 ADC */
-    adau1979_init(context);
-    
+
+    return(true);
+}
+
+static bool boot_codec_hw(APP_CONTEXT *context)
+{
+    /* Release resets and set up the codec SRU routes and SPORTs */
+    adau1962_init_hw(context);
+    adau1977_init_hw(context);
+    adau1979_init_hw(context);
+    return(true);
+}
+
+static bool boot_spdif(APP_CONTEXT *context)
+{
     /* Initialize the SPDIF I/O */
     spdif_init(context);
-    
-    /* Initialize the AD2425 in master mode */
+    return(true);
+}
+
+static bool boot_a2b(APP_CONTEXT *context)
+{
+    /* Initialize the AD2425 in master mode.  A failed discovery
+     * still leaves the local audio usable so never fail the stage.
+     */
     ad2425_init_master(context);
     ad2425_restart(context);
-    
+
+    return(true);
+}
+
+static bool boot_dac(APP_CONTEXT *context)
+{
+    /* Initialize the ADAU1962 DAC */
+    adau1962_init_codec(context);
+    return(true);
+}
+
+static bool boot_adc(APP_CONTEXT *context)
+{
+    /* Initialize the ADAU1979 ADC */
+    adau1979_init_codec(context);
+    return(true);
+}
+
+static bool boot_mic(APP_CONTEXT *context)
+{
+    /* Initialize the ADAU1977 ADC */
+    adau1977_init_codec(context);
+    return(true);
+}
+
+static bool boot_audio(APP_CONTEXT *context)
+{
     /* Initialize the A2B, WAV, and UAC2 audio clock domains */
     clock_domain_init(context);
 
     /* Enable all SPORT clocks for a synchronous start */
     enable_sport_mclk(context);
 
+    return(true);
+}
+
+static const BOOT_STAGE bootStages[] = {
+    [BOOT_TWI] = { "twi", boot_twi, 0 },
+    [BOOT_SAE] = { "sae", boot_sae, 0 },
+    [BOOT_FLASH] = { "flash", boot_flash, BOOT_DEP(BOOT_TWI) },
+    [BOOT_SPIFFS] = { "spiffs", boot_spiffs, BOOT_DEP(BOOT_FLASH) },
+    [BOOT_BUFFERS] = { "buffers", boot_buffers, BOOT_DEP(BOOT_SAE) },
+    [BOOT_MCLK] = { "mclk", boot_mclk, 0 },
+    [BOOT_CODEC_HW] = { "codec_hw", boot_codec_hw,
+        BOOT_DEP(BOOT_TWI) | BOOT_DEP(BOOT_MCLK) | BOOT_DEP(BOOT_BUFFERS) },
+    [BOOT_SPDIF] = { "spdif", boot_spdif, BOOT_DEP(BOOT_CODEC_HW) },
+    [BOOT_A2B] = { "a2b", boot_a2b,
+        BOOT_DEP(BOOT_TWI) | BOOT_DEP(BOOT_SPDIF) },
+    [BOOT_DAC] = { "dac", boot_dac,
+        BOOT_DEP(BOOT_TWI) | BOOT_DEP(BOOT_CODEC_HW) },
+    [BOOT_ADC] = { "adc", boot_adc,
+        BOOT_DEP(BOOT_TWI) | BOOT_DEP(BOOT_CODEC_HW) },
+    [BOOT_MIC] = { "mic", boot_mic,
+        BOOT_DEP(BOOT_TWI) | BOOT_DEP(BOOT_CODEC_HW) },
+    [BOOT_AUDIO] = { "audio", boot_audio,
+        BOOT_DEP(BOOT_DAC) | BOOT_DEP(BOOT_ADC) | BOOT_DEP(BOOT_MIC) |
+        BOOT_DEP(BOOT_SPDIF) | BOOT_DEP(BOOT_A2B) },
+};
+
+/* System startup task -> background shell task */
+static portTASK_FUNCTION( startupTask, pvParameters )
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
+    SPI_SIMPLE_RESULT spiResult;
+    TWI_SIMPLE_RESULT twiResult;
+    SPORT_SIMPLE_RESULT sportResult;
+
+    /* Initialize the CPU load module. */
+    cpuLoadInit(getTimeStamp, CGU_TS_CLK);
+
+    /* Initialize the simple SPI driver */
+    spiResult = spi_init();
+
+    /* Initialize the simple TWI driver */
+    twiResult = twi_init();
+
+    /* Initialize the simple SPORT driver */
+    sportResult = sport_init();
+
+    /* Intialize the filesystem device manager */
+    fs_devman_init();
+
+    /* Intialize the filesystem device I/O layer */
+    fs_devio_init();
+
+    /* Run the remaining hardware and audio initialization */
+    boot_run(context, bootStages, sizeof(bootStages) / sizeof(bootStages[0]));
+
     /* Get the idle task handle */
     context->idleTaskHandle = xTaskGetIdleTaskHandle();
 
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "context.h"
+#include "meter_capture.h"
+#include "meter.h"
+#include "ipc.h"
+#include "sae.h"
+
+static unsigned meterBlockHz(APP_CONTEXT *context)
+{
+    return(context->sampleRate / SYSTEM_BLOCK_SIZE);
+}
+
+bool meter_capture_start(APP_CONTEXT *context, unsigned rmsMs,
+    unsigned decayDb)
+{
+    SAE_CONTEXT *saeContext = context->saeContext;
+    METER_TABLE *mt;
+    SAE_RESULT result;
+    IPC_MSG *msg;
+
+    if (context->meterMsgBuffer == NULL) {
+        context->meterMsgBuffer = sae_createMsgBuffer(saeContext,
+            sizeof(*msg) + meter_size(), SAE_ALLOC_BULK, (void **)&msg);
+        if (context->meterMsgBuffer == NULL) {
+            return(false);
+        }
+        msg->type = IPC_TYPE_METER;
+        mt = meter_init(msg->meter.table, meterBlockHz(context));
+        meter_attach(mt);
+
+        /* The ARM keeps its own reference so the table is never freed */
+        sae_refMsgBuffer(saeContext, context->meterMsgBuffer);
+        result = sae_sendMsgBuffer(saeContext, context->meterMsgBuffer,
+            IPC_CORE_SHARC0, true);
+        if (result != SAE_RESULT_OK) {
+            sae_unRefMsgBuffer(saeContext, context->meterMsgBuffer);
+        }
+    }
+
+    mt = meter_table();
+    meter_ballistics(mt, rmsMs, decayDb, meterBlockHz(context));
+    mt->enable = 1;
+
+    return(true);
+}
+
+void meter_capture_stop(APP_CONTEXT *context)
+{
+    METER_TABLE *mt = meter_table();
+
+    UNUSED(context);
+    if (mt) {
+        mt->enable = 0;
+    }
+}
+
+void meter_capture_reset(APP_CONTEXT *context)
+{
+    METER_TABLE *mt = meter_table();
+
+    UNUSED(context);
+    if (mt) {
+        memset(mt->maxCycles, 0, sizeof(mt->maxCycles));
+    }
+}
+
+void meter_capture_select(APP_CONTEXT *context, uint32_t streams)
+{
+    METER_TABLE *mt = meter_table();
+
+    UNUSED(context);
+    if (mt) {
+        mt->streams = streams;
+    }
+}
+
+void meter_capture_rate(APP_CONTEXT *context)
+{
+    METER_TABLE *mt = meter_table();
+
+    if (mt) {
+        meter_rate(mt, meterBlockHz(context));
+    }
+}
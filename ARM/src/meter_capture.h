@@ -0,0 +1,40 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _meter_capture_h
+#define _meter_capture_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "context.h"
+#include "meter.h"
+
+/*
+ * Allocate the shared meter table (first time only), set the
+ * ballistics and start metering on SHARC0
+ */
+bool meter_capture_start(APP_CONTEXT *context, unsigned rmsMs,
+    unsigned decayDb);
+
+/* Stop metering on SHARC0 */
+void meter_capture_stop(APP_CONTEXT *context);
+
+/* Clear the max cycle counts */
+void meter_capture_reset(APP_CONTEXT *context);
+
+/* Select the streams to meter (METER_STREAM() mask) */
+void meter_capture_select(APP_CONTEXT *context, uint32_t streams);
+
+/* Recompute the ballistics after a sample rate change */
+void meter_capture_rate(APP_CONTEXT *context);
+
+#endif
@@ -25,6 +25,7 @@ void micAudioIn(void *buffer, uint32_t size, void *usrPtr)
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     SAE_MSG_BUFFER *msg = NULL;
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -37,9 +38,9 @@ void micAudioIn(void *buffer, uint32_t size, void *usrPtr)
     }
 
     /* Indicate mic "in" audio ready */
-    sharcAudio(context, CLOCK_DOMAIN_BITM_MIC_IN, msg, false, true);
+    sharcAudio(context, CLOCK_DOMAIN_BITM_MIC_IN, msg, true);
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "micAudioIn", outCycles - inCycles);
 }
@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "context.h"
+#include "umm_malloc.h"
+#include "mixer_control.h"
+#include "mixer.h"
+#include "ipc.h"
+#include "sae.h"
+
+#define MIXER_LINE_LEN  (80)
+
+static MIXER_POINT *mixerAlloc(void)
+{
+    return((MIXER_POINT *)umm_malloc(MIXER_MAX_POINTS * sizeof(MIXER_POINT)));
+}
+
+static bool mixerPoints(APP_CONTEXT *context)
+{
+    if (context->mixerPoints == NULL) {
+        context->mixerPoints = mixerAlloc();
+        context->mixerNumPoints = 0;
+    }
+    return(context->mixerPoints != NULL);
+}
+
+static bool mixerSet(MIXER_POINT *points, unsigned *numPoints,
+    const MIXER_POINT *point)
+{
+    unsigned i;
+
+    for (i = 0; i < *numPoints; i++) {
+        if ((points[i].sinkID == point->sinkID) &&
+            (points[i].sinkChannel == point->sinkChannel) &&
+            (points[i].srcID == point->srcID) &&
+            (points[i].srcChannel == point->srcChannel)) {
+            break;
+        }
+    }
+
+    if (point->gain == 0.0f) {
+        if (i < *numPoints) {
+            points[i] = points[--(*numPoints)];
+        }
+        return(true);
+    }
+
+    if (i == *numPoints) {
+        if (*numPoints >= MIXER_MAX_POINTS) {
+            return(false);
+        }
+        (*numPoints)++;
+    }
+    points[i] = *point;
+
+    return(true);
+}
+
+bool mixer_control_set(APP_CONTEXT *context, const MIXER_POINT *point)
+{
+    if (!mixerPoints(context)) {
+        return(false);
+    }
+    return(mixerSet(context->mixerPoints, &context->mixerNumPoints, point));
+}
+
+void mixer_control_clear(APP_CONTEXT *context)
+{
+    context->mixerNumPoints = 0;
+}
+
+bool mixer_control_commit(APP_CONTEXT *context)
+{
+    SAE_CONTEXT *saeContext = context->saeContext;
+    SAE_MSG_BUFFER *msgBuffer;
+    SAE_RESULT result;
+    unsigned numPoints;
+    unsigned numRows;
+    IPC_MSG *msg;
+
+    if (!mixerPoints(context)) {
+        return(false);
+    }
+
+    numPoints = context->mixerNumPoints;
+    mixer_sort(context->mixerPoints, numPoints);
+    numRows = mixer_rows(context->mixerPoints, numPoints);
+
+    msgBuffer = sae_createMsgBuffer(saeContext,
+        sizeof(*msg) + mixer_size(numRows, numPoints), SAE_ALLOC_BULK,
+        (void **)&msg);
+    if (msgBuffer == NULL) {
+        return(false);
+    }
+    msg->type = IPC_TYPE_MIXER;
+    mixer_build(msg->mixer.matrix, context->mixerPoints, numPoints);
+
+    /*
+     * The ARM keeps a reference to the matrix it last sent, SHARC0
+     * drops its own reference to the old matrix once it has switched.
+     */
+    sae_refMsgBuffer(saeContext, msgBuffer);
+    result = sae_sendMsgBuffer(saeContext, msgBuffer, IPC_CORE_SHARC0, true);
+    if (result != SAE_RESULT_OK) {
+        /* Drop both the send's and the ARM's reference */
+        sae_unRefMsgBuffer(saeContext, msgBuffer);
+        sae_unRefMsgBuffer(saeContext, msgBuffer);
+        return(false);
+    }
+    if (context->mixerMsgBuffer) {
+        sae_unRefMsgBuffer(saeContext, context->mixerMsgBuffer);
+    }
+    context->mixerMsgBuffer = msgBuffer;
+
+    return(true);
+}
+
+bool mixer_control_adopt(APP_CONTEXT *context, SAE_MSG_BUFFER *msgBuffer,
+    const MIXER_POINT *points, unsigned numPoints)
+{
+    if (!mixerPoints(context) || (numPoints > MIXER_MAX_POINTS)) {
+        return(false);
+    }
+
+    memcpy(context->mixerPoints, points, numPoints * sizeof(*points));
+    context->mixerNumPoints = numPoints;
+
+    sae_refMsgBuffer(context->saeContext, msgBuffer);
+    if (context->mixerMsgBuffer) {
+        sae_unRefMsgBuffer(context->saeContext, context->mixerMsgBuffer);
+    }
+    context->mixerMsgBuffer = msgBuffer;
+
+    return(true);
+}
+
+bool mixer_control_load(APP_CONTEXT *context, const char *fname,
+    unsigned *errLine)
+{
+    char line[MIXER_LINE_LEN];
+    MIXER_POINT *points;
+    MIXER_POINT point;
+    MIXER_PARSE parse;
+    unsigned numPoints;
+    unsigned lineNum;
+    bool ok;
+    FILE *f;
+
+    *errLine = 0;
+
+    f = fopen(fname, "r");
+    if (f == NULL) {
+        return(false);
+    }
+
+    points = mixerAlloc();
+    if (points == NULL) {
+        fclose(f);
+        return(false);
+    }
+
+    ok = true;
+    numPoints = 0;
+    lineNum = 0;
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineNum++;
+        parse = mixer_parse(line, &point);
+        if (parse == MIXER_PARSE_POINT) {
+            ok = mixerSet(points, &numPoints, &point);
+        } else if (parse == MIXER_PARSE_ERROR) {
+            ok = false;
+        }
+        if (!ok) {
+            *errLine = lineNum;
+        }
+    }
+    fclose(f);
+
+    if (!ok) {
+        umm_free(points);
+        return(false);
+    }
+
+    if (context->mixerPoints) {
+        umm_free(context->mixerPoints);
+    }
+    context->mixerPoints = points;
+    context->mixerNumPoints = numPoints;
+
+    return(true);
+}
+
+bool mixer_control_save(APP_CONTEXT *context, const char *fname)
+{
+    char line[MIXER_LINE_LEN];
+    unsigned i;
+    bool ok;
+    FILE *f;
+
+    if (!mixerPoints(context)) {
+        return(false);
+    }
+
+    f = fopen(fname, "w");
+    if (f == NULL) {
+        return(false);
+    }
+
+    mixer_sort(context->mixerPoints, context->mixerNumPoints);
+    ok = (fprintf(f, "# <sink>:<ch> <source>:<ch> <gain dB>\n") > 0);
+    for (i = 0; ok && (i < context->mixerNumPoints); i++) {
+        mixer_format(&context->mixerPoints[i], line, sizeof(line));
+        ok = (fprintf(f, "%s\n", line) > 0);
+    }
+    fclose(f);
+
+    return(ok);
+}
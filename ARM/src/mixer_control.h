@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _mixer_control_h
+#define _mixer_control_h
+
+#include <stdbool.h>
+
+#include "context.h"
+#include "mixer.h"
+#include "sae.h"
+
+/*
+ * Add, change or remove (zero gain) one crosspoint of the working
+ * matrix.  Nothing changes on SHARC0 until mixer_control_commit().
+ */
+bool mixer_control_set(APP_CONTEXT *context, const MIXER_POINT *point);
+
+/* Remove every crosspoint from the working matrix */
+void mixer_control_clear(APP_CONTEXT *context);
+
+/*
+ * Build the CSR form of the working matrix and send it to SHARC0,
+ * which swaps it in between blocks
+ */
+bool mixer_control_commit(APP_CONTEXT *context);
+
+/*
+ * Make 'points' the working matrix and the matrix SHARC0 got in
+ * another message (IPC_TYPE_SCENE) the last one sent.  Takes a
+ * reference to the message.
+ */
+bool mixer_control_adopt(APP_CONTEXT *context, SAE_MSG_BUFFER *msgBuffer,
+    const MIXER_POINT *points, unsigned numPoints);
+
+/*
+ * Replace the working matrix with a matrix file.  On a parse error
+ * the working matrix is left alone and 'errLine' is the bad line.
+ */
+bool mixer_control_load(APP_CONTEXT *context, const char *fname,
+    unsigned *errLine);
+
+/* Write the working matrix to a matrix file */
+bool mixer_control_save(APP_CONTEXT *context, const char *fname);
+
+#endif
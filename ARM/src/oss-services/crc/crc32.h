@@ -0,0 +1,23 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _CRC32_H_
+#define _CRC32_H_
+
+#include <stdint.h>
+
+/* IEEE 802.3 CRC32 (reflected, poly 0x04C11DB7, as used by zlib) */
+uint32_t crc32(const void *buf, unsigned len);
+
+/* Continue a running CRC32 (start with crc = 0) */
+uint32_t crc32_x(const void *buf, unsigned len, uint32_t crc);
+
+#endif /* _CRC32_H_ */
@@ -66,6 +66,25 @@ static u32 romfsh_read( u32 addr, void *data, u32 len, const FSDATA *pfs )
   return(len);
 }
 
+// Helper function: pin the memory-mapped flash window and return a pointer
+// to the FS base in it, or NULL if the FS is not reachable that way
+static const u8 *romfsh_map( const FSDATA *pfs )
+{
+  const u8 *map;
+  if( pfs->flags & ROMFS_FS_FLAG_DIRECT )
+    return pfs->pbase;
+  map = platform_flash_map_acquire();
+  if( map )
+    map += ( u32 )pfs->pbase;
+  return map;
+}
+
+static void romfsh_unmap( const FSDATA *pfs )
+{
+  if( ( pfs->flags & ROMFS_FS_FLAG_DIRECT ) == 0 )
+    platform_flash_map_release();
+}
+
 // Helper function: return 1 if PFS reffers to a WOFS, 0 otherwise
 static int romfsh_is_wofs( const FSDATA* pfs )
 {
@@ -308,6 +327,9 @@ static int romfs_close_r( struct _reent *r, int fd, void *pdata )
   FSDATA *pfsdata = ( FSDATA* )pdata;
   u8 temp[ ROMFS_SIZE_LEN ];
 
+  if( pfd->flags & ROMFS_FILE_FLAG_MAPPED )
+    romfsh_unmap( pfsdata );
+
   if( pfd->flags & ( ROMFS_FILE_FLAG_WRITE | ROMFS_FILE_FLAG_APPEND ) )
   {
     // Write back the size
@@ -513,6 +535,51 @@ static const char* romfs_getaddr_r( struct _reent *r, int fd, void *pdata )
     return NULL;
 }
 
+// map
+static const void* romfs_map_r( struct _reent *r, int fd, u32 *size, void *pdata )
+{
+  FD* pfd = fd_table + fd;
+  FSDATA *pfsdata = ( FSDATA* )pdata;
+  const u8 *map;
+
+  // Files still being written have no stable size
+  if( ( pfd->flags & ROMFS_FILE_FLAG_READ ) == 0 ||
+      ( pfd->flags & ( ROMFS_FILE_FLAG_WRITE | ROMFS_FILE_FLAG_APPEND ) ) )
+  {
+    r->_errno = EBADF;
+    return NULL;
+  }
+  map = romfsh_map( pfsdata );
+  if( map == NULL )
+  {
+    r->_errno = ENOTSUP;
+    return NULL;
+  }
+  // Hold a single window reference per mapped file
+  if( pfd->flags & ROMFS_FILE_FLAG_MAPPED )
+    romfsh_unmap( pfsdata );
+  pfd->flags |= ROMFS_FILE_FLAG_MAPPED;
+  if( size )
+    *size = pfd->size;
+  return map + pfd->baseaddr;
+}
+
+// unmap
+static int romfs_unmap_r( struct _reent *r, int fd, void *pdata )
+{
+  FD* pfd = fd_table + fd;
+  FSDATA *pfsdata = ( FSDATA* )pdata;
+
+  if( ( pfd->flags & ROMFS_FILE_FLAG_MAPPED ) == 0 )
+  {
+    r->_errno = EINVAL;
+    return -1;
+  }
+  pfd->flags &= ~ROMFS_FILE_FLAG_MAPPED;
+  romfsh_unmap( pfsdata );
+  return 0;
+}
+
 // ****************************************************************************
 // Our ROMFS device descriptor structure
 // These functions apply to both ROMFS and WOFS
@@ -531,7 +598,9 @@ static const DM_DEVICE romfs_device =
   NULL,                 // mkdir
   romfs_unlink_r,       // unlink
   NULL,                 // rmdir
-  NULL                  // rename
+  NULL,                 // rename
+  romfs_map_r,          // map
+  romfs_unmap_r         // unmap
 };
 
 // ****************************************************************************
@@ -72,6 +72,7 @@ typedef u32 ( *p_fs_write )( const void *from, u32 toaddr, u32 size, const void
 #define ROMFS_FILE_FLAG_READ      0x01
 #define ROMFS_FILE_FLAG_WRITE     0x02
 #define ROMFS_FILE_FLAG_APPEND    0x04
+#define ROMFS_FILE_FLAG_MAPPED    0x08
 
 // A small "FILE" structure
 typedef struct
@@ -93,3 +93,21 @@ long fs_seek(int fd, long offset, int whence)
    offset = romfs.pdev->p_lseek_r(&reent, fd - FD_OFFSET, offset, whence, romfs.pdata);
    return(offset);
 }
+
+const void *fs_map(int fd, u32 *size)
+{
+   const void *addr = NULL;
+   if (romfs.pdev->p_map_r) {
+      addr = romfs.pdev->p_map_r(&reent, fd - FD_OFFSET, size, romfs.pdata);
+   }
+   return(addr);
+}
+
+int fs_unmap(int fd)
+{
+   int ret = -1;
+   if (romfs.pdev->p_unmap_r) {
+      ret = romfs.pdev->p_unmap_r(&reent, fd - FD_OFFSET, romfs.pdata);
+   }
+   return(ret);
+}
@@ -64,6 +64,8 @@ typedef struct
   int ( *p_unlink_r )( struct _reent *r, const char *fname, void *pdata );
   int ( *p_rmdir_r )( struct _reent *r, const char *fname, void *pdata );
   int ( *p_rename_r )( struct _reent *r, const char *oldname, const char *newname, void *pdata );
+  const void* ( *p_map_r )( struct _reent *r, int fd, u32 *size, void *pdata );
+  int ( *p_unmap_r )( struct _reent *r, int fd, void *pdata );
 } DM_DEVICE;
 
 // Additional registration data for each FS (per FS instance)
@@ -119,4 +121,11 @@ int fs_read(int fd, unsigned char *buf, int size);
 int fs_write(int fd, unsigned char *buf, int size);
 long fs_seek(int fd, long offset, int whence);
 
+// Zero-copy access to the data of a file opened for reading.  Only
+// available when the flash is memory-mapped.  The returned pointer is
+// valid until fs_unmap() or fs_close().  Flash erase/program operations
+// are held off while a file is mapped so keep the mapping short lived.
+const void *fs_map(int fd, u32 *size);
+int fs_unmap(int fd);
+
 #endif
@@ -29,6 +29,16 @@ u32 platform_flash_read( u32 fromaddr, void *toaddr, u32 size )
     return(result);
 }
 
+const u8 *platform_flash_map_acquire( void )
+{
+    return(flash_mmap_acquire(flashHandle));
+}
+
+void platform_flash_map_release( void )
+{
+    flash_mmap_release(flashHandle);
+}
+
 u32 platform_flash_get_first_free_block_address( u32 *psect )
 {
     u32 address;
@@ -48,4 +48,9 @@ u32 platform_flash_get_num_sectors(void);
 int platform_flash_erase_sector( u32 sector_id );
 u32 platform_flash_read( u32 fromaddr, void *toaddr, u32 size );
 
+// Memory-mapped flash access.  platform_flash_map_acquire() returns a
+// pointer to flash address zero or NULL if the flash is not mapped.
+const u8 *platform_flash_map_acquire( void );
+void platform_flash_map_release( void );
+
 #endif
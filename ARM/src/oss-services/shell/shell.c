@@ -58,6 +58,7 @@ SHELL_FUNC( shell_cat );
 SHELL_FUNC( shell_cp );
 SHELL_FUNC( shell_stacks );
 SHELL_FUNC( shell_cpu );
+SHELL_FUNC( shell_top );
 SHELL_FUNC( shell_usb );
 SHELL_FUNC( shell_recv );
 SHELL_FUNC( shell_fsck );
@@ -72,6 +73,15 @@ SHELL_FUNC( shell_a2b );
 SHELL_FUNC( shell_adc );
 SHELL_FUNC( shell_drive );
 SHELL_FUNC( shell_mic );
+SHELL_FUNC( shell_trace );
+SHELL_FUNC( shell_bench );
+SHELL_FUNC( shell_domain );
+SHELL_FUNC( shell_boot );
+SHELL_FUNC( shell_fsio );
+SHELL_FUNC( shell_meter );
+SHELL_FUNC( shell_latency );
+SHELL_FUNC( shell_mixer );
+SHELL_FUNC( shell_scene );
 
 SHELL_HELP( help );
 SHELL_HELP( ver );
@@ -87,6 +97,7 @@ SHELL_HELP( cat );
 SHELL_HELP( cp );
 SHELL_HELP( stacks );
 SHELL_HELP( cpu );
+SHELL_HELP( top );
 SHELL_HELP( usb );
 SHELL_HELP( recv );
 SHELL_HELP( fsck );
@@ -101,6 +112,15 @@ SHELL_HELP( a2b );
 SHELL_HELP( adc );
 SHELL_HELP( drive );
 SHELL_HELP( mic );
+SHELL_HELP( trace );
+SHELL_HELP( bench );
+SHELL_HELP( domain );
+SHELL_HELP( boot );
+SHELL_HELP( fsio );
+SHELL_HELP( meter );
+SHELL_HELP( latency );
+SHELL_HELP( mixer );
+SHELL_HELP( scene );
 
 //static const SHELL_COMMAND shell_commands[] =
 const SHELL_COMMAND shell_commands[] =
@@ -123,6 +143,7 @@ const SHELL_COMMAND shell_commands[] =
   { "copy", shell_cp },
   { "stacks", shell_stacks },
   { "cpu", shell_cpu },
+  { "top", shell_top },
   { "uac", shell_usb },
   { "usb", shell_usb },
   { "recv", shell_recv },
@@ -138,6 +159,15 @@ const SHELL_COMMAND shell_commands[] =
   { "adc", shell_adc },
   { "drive", shell_drive },
   { "mic", shell_mic },
+  { "trace", shell_trace },
+  { "bench", shell_bench },
+  { "domain", shell_domain },
+  { "boot", shell_boot },
+  { "fsio", shell_fsio },
+  { "meter", shell_meter },
+  { "latency", shell_latency },
+  { "mixer", shell_mixer },
+  { "scene", shell_scene },
   { "exit", NULL },
   { NULL, NULL }
 };
@@ -158,6 +188,7 @@ static const SHELL_HELP_DATA shell_help_data[] =
   SHELL_INFO( cp ),
   SHELL_INFO( stacks ),
   SHELL_INFO( cpu ),
+  SHELL_INFO( top ),
   SHELL_INFO( usb ),
   SHELL_INFO( recv ),
   SHELL_INFO( fsck ),
@@ -172,6 +203,15 @@ static const SHELL_HELP_DATA shell_help_data[] =
   SHELL_INFO( adc ),
   SHELL_INFO( drive ),
   SHELL_INFO( mic ),
+  SHELL_INFO( trace ),
+  SHELL_INFO( bench ),
+  SHELL_INFO( domain ),
+  SHELL_INFO( boot ),
+  SHELL_INFO( fsio ),
+  SHELL_INFO( meter ),
+  SHELL_INFO( latency ),
+  SHELL_INFO( mixer ),
+  SHELL_INFO( scene ),
   { NULL, NULL, NULL }
 };
 
@@ -19,9 +19,11 @@
 #include "shell.h"
 #include "term.h"
 #include "xmodem.h"
+#include "sxfer.h"
 #include "util.h"
 #include "uart_stdio.h"
 #include "adau1977.h"
+#include "fs_devio.h"
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -112,6 +114,200 @@ int fileDataWrite(unsigned char *data, unsigned size, bool final, void *usr)
     return(XMODEM_ERROR_NONE);
 }
 
+/***********************************************************************
+ * Streaming transfer helper functions
+ **********************************************************************/
+#ifdef USB_CDC_STDIO
+#define shell_uart_read        uart_cdc_read
+#define shell_uart_write       uart_cdc_write
+#define shell_uart_setTimeouts uart_cdc_setTimeouts
+#else
+#define shell_uart_read        uart_read
+#define shell_uart_write       uart_write
+#define shell_uart_setTimeouts uart_setTimeouts
+#endif
+
+/* Erase granularity used when erasing ahead of the data */
+#define FLASH_STREAM_ERASE_AHEAD  (64 * 1024)
+
+/*
+ * The console port is used directly rather than through stdio so
+ * that binary frames are not subject to newline translation.
+ */
+static int shell_sxfer_read(uint8_t *data, unsigned len, unsigned timeout,
+    void *usr)
+{
+#ifdef USB_CDC_STDIO
+    uint32_t readLen;
+#else
+    uint8_t readLen;
+#endif
+
+    shell_uart_setTimeouts(context->stdioHandle, timeout,
+        UART_SIMPLE_TIMEOUT_NO_CHANGE);
+
+#ifdef USB_CDC_STDIO
+    /* The CDC driver fills the whole frame in one call */
+    readLen = len;
+    uart_cdc_readBuf(context->stdioHandle, data, &readLen);
+#else
+    readLen = (len > 255) ? 255 : len;
+    shell_uart_read(context->stdioHandle, data, &readLen);
+#endif
+
+    return(readLen);
+}
+
+static int shell_sxfer_send(const uint8_t *data, unsigned len, void *usr)
+{
+    UART_SIMPLE_RESULT uartResult;
+#ifdef USB_CDC_STDIO
+    uint32_t writeLen;
+
+    /* The CDC driver takes the whole frame in one call */
+    writeLen = len;
+    uartResult = uart_cdc_writeBuf(context->stdioHandle, data, &writeLen);
+    if ((uartResult != UART_SIMPLE_SUCCESS) || (writeLen != len)) {
+        return(-1);
+    }
+#else
+    uint8_t writeLen;
+
+    while (len) {
+        writeLen = (len > 255) ? 255 : len;
+        uartResult = shell_uart_write(context->stdioHandle,
+            (uint8_t *)data, &writeLen);
+        if (uartResult != UART_SIMPLE_SUCCESS) {
+            return(-1);
+        }
+        data += writeLen;
+        len -= writeLen;
+    }
+#endif
+
+    return(0);
+}
+
+typedef struct FLASH_STREAM_STATE {
+    const FLASH_INFO *flash;
+    unsigned baseAddr;
+    unsigned maxAddr;
+    unsigned eraseAddr;
+    unsigned eraseBlockSize;
+    uint32_t resumeOffset;
+} FLASH_STREAM_STATE;
+
+static int flashStreamStart(uint32_t offset, uint32_t size, void *usr)
+{
+    FLASH_STREAM_STATE *state = (FLASH_STREAM_STATE *)usr;
+
+    if ((state->baseAddr + size) > state->maxAddr) {
+        return(-1);
+    }
+
+    /* Everything past the committed data is still erased */
+    state->eraseAddr = state->baseAddr + offset;
+    state->eraseAddr += state->eraseBlockSize - 1;
+    state->eraseAddr -= state->eraseAddr % state->eraseBlockSize;
+    state->resumeOffset = offset;
+
+    return(0);
+}
+
+static int flashStreamWrite(uint32_t offset, const uint8_t *data,
+    unsigned len, void *usr)
+{
+    FLASH_STREAM_STATE *state = (FLASH_STREAM_STATE *)usr;
+    unsigned addr = state->baseAddr + offset;
+    int err;
+
+    if ((addr + len) > state->maxAddr) {
+        return(-1);
+    }
+
+    /* Catch up if the data overtook the erase-ahead */
+    while (state->eraseAddr < (addr + len)) {
+        err = flash_erase(state->flash, state->eraseAddr, state->eraseBlockSize);
+        if (err != FLASH_OK) {
+            return(-1);
+        }
+        state->eraseAddr += state->eraseBlockSize;
+    }
+
+    err = flash_program(state->flash, addr, data, len);
+    if (err != FLASH_OK) {
+        return(-1);
+    }
+
+    return(0);
+}
+
+static int flashStreamIdle(void *usr)
+{
+    FLASH_STREAM_STATE *state = (FLASH_STREAM_STATE *)usr;
+    unsigned size;
+    int err;
+
+    if (state->eraseAddr >= state->maxAddr) {
+        return(0);
+    }
+
+    if (((state->eraseAddr % FLASH_STREAM_ERASE_AHEAD) == 0) &&
+        ((state->eraseAddr + FLASH_STREAM_ERASE_AHEAD) <= state->maxAddr)) {
+        size = FLASH_STREAM_ERASE_AHEAD;
+    } else {
+        size = state->eraseBlockSize;
+    }
+
+    err = flash_erase(state->flash, state->eraseAddr, size);
+    if (err != FLASH_OK) {
+        return(0);
+    }
+    state->eraseAddr += size;
+
+    return(1);
+}
+
+typedef struct FILE_STREAM_STATE {
+    const char *fname;
+    FILE *f;
+    uint32_t resumeOffset;
+} FILE_STREAM_STATE;
+
+static int fileStreamStart(uint32_t offset, uint32_t size, void *usr)
+{
+    FILE_STREAM_STATE *state = (FILE_STREAM_STATE *)usr;
+
+    if (state->f) {
+        fclose(state->f);
+    }
+
+    state->f = fs_devio_fopen(state->fname, (offset > 0) ? "r+b" : "wb", 0, 0);
+    if (state->f == NULL) {
+        return(-1);
+    }
+    if ((offset > 0) && (fseek(state->f, offset, SEEK_SET) != 0)) {
+        return(-1);
+    }
+    state->resumeOffset = offset;
+
+    return(0);
+}
+
+static int fileStreamWrite(uint32_t offset, const uint8_t *data,
+    unsigned len, void *usr)
+{
+    FILE_STREAM_STATE *state = (FILE_STREAM_STATE *)usr;
+    size_t wsize;
+
+    wsize = fwrite(data, sizeof(*data), len, state->f);
+    if (wsize != len) {
+        return(-1);
+    }
+
+    return(0);
+}
+
 int confirmDanger(SHELL_CONTEXT *ctx, char *warnStr)
 {
     char c;
@@ -186,23 +382,73 @@ void shell_mic( SHELL_CONTEXT *ctx, int argc, char **argv )
 /***********************************************************************
  * CMD: recv
  **********************************************************************/
-const char shell_help_recv[] = "<file>\n"
-    "  Transfer and save to file\n";
+const char shell_help_recv[] = "[-s] <file>\n"
+    "  Transfer and save to file\n"
+    "  -s  Use the resumable streaming protocol instead of XMODEM\n";
 const char shell_help_summary_recv[] = "Receive a file via XMODEM";
 
+static SXFER_SESSION recvSession;
+static char recvSessionFile[256];
+
+static void shell_recv_stream(const char *fname)
+{
+    FILE_STREAM_STATE fileState;
+    SXFER_CONFIG cfg;
+    long size;
+
+    /* Only resume into the same file */
+    if (strcmp(recvSessionFile, fname) != 0) {
+        memset(&recvSession, 0, sizeof(recvSession));
+        strncpy(recvSessionFile, fname, sizeof(recvSessionFile) - 1);
+    }
+
+    memset(&fileState, 0, sizeof(fileState));
+    fileState.fname = fname;
+
+    cfg.read = shell_sxfer_read;
+    cfg.send = shell_sxfer_send;
+    cfg.start = fileStreamStart;
+    cfg.write = fileStreamWrite;
+    cfg.idle = NULL;
+    cfg.usr = &fileState;
+    cfg.maxSize = UINT32_MAX;
+    cfg.session = &recvSession;
+
+    printf( "Waiting for stream ... " );
+    size = sxfer_receive(&cfg);
+
+    if (fileState.f) {
+        fclose(fileState.f);
+    }
+
+    if (size < 0) {
+        printf( "Stream Error: %ld (%u bytes saved, resumable)\n",
+            size, (unsigned)recvSession.offset );
+    } else {
+        printf( "received %ld bytes (resumed at %u) and saved as %s\n",
+            size, (unsigned)fileState.resumeOffset, fname );
+        memset(&recvSession, 0, sizeof(recvSession));
+    }
+}
+
 void shell_recv( SHELL_CONTEXT *ctx, int argc, char **argv )
 {
     FILE_WRITE_STATE fileState;
     long size;
 
+    if ( (argc == 3) && (strcmp(argv[1], "-s") == 0) ) {
+        shell_recv_stream(argv[2]);
+        return;
+    }
+
     if( argc != 2 ) {
-        printf( "Usage: recv <file>\n" );
+        printf( "Usage: recv [-s] <file>\n" );
         return;
     }
 
     fileState.xmodem.ctx = ctx;
 
-    fileState.f = fopen( argv[ 1 ], "wb");
+    fileState.f = fs_devio_fopen( argv[ 1 ], "wb", 0, 0);
     if( fileState.f == NULL) {
         printf( "unable to open file %s\n", argv[ 1 ] );
         return;
@@ -595,10 +841,13 @@ void shell_format(SHELL_CONTEXT *ctx, int argc, char **argv)
  **********************************************************************/
 #include "init.h"
 #include "a2b_xml.h"
+#include "a2b_bin.h"
 #include "adi_a2b_cmdlist.h"
 
 const char shell_help_discover[] = "<a2b.xml> <verbose> <i2c_port> <i2c_addr> <reset>\n"
-  "  a2b.xml  - A SigmaStudio A2B XML config export file\n"
+  "  a2b.xml  - A SigmaStudio A2B XML config export file or a binary\n"
+  "             converted from one.  XML files are cached in binary\n"
+  "             form next to the XML file ('a2b.a2b').\n"
   "             default 'a2b.xml'\n"
   "  verbose  - Print out results to 0:none, 1:stdout, 2:syslog\n"
   "             default: 1\n"
@@ -640,6 +889,34 @@ static ADI_A2B_CMDLIST_RESULT shell_discover_twi_write_write(
         ADI_A2B_CMDLIST_SUCCESS : ADI_A2B_CMDLIST_A2B_I2C_WRITE_ERROR);
 }
 
+#define SHELL_DISCOVER_XFERS  16
+
+static ADI_A2B_CMDLIST_RESULT shell_discover_twi_write_list(
+    void *twiHandle, ADI_A2B_CMDLIST_TWI_XFER *xfers, uint16_t count,
+    void *usr)
+{
+    TWI_SIMPLE_XFER twiXfers[SHELL_DISCOVER_XFERS];
+    TWI_SIMPLE_RESULT twiResult;
+    uint16_t i, n;
+
+    twiResult = TWI_SIMPLE_SUCCESS;
+    while (count && (twiResult == TWI_SIMPLE_SUCCESS)) {
+        n = (count > SHELL_DISCOVER_XFERS) ? SHELL_DISCOVER_XFERS : count;
+        for (i = 0; i < n; i++) {
+            twiXfers[i].address = xfers[i].address;
+            twiXfers[i].type = TWI_SIMPLE_WRITE;
+            twiXfers[i].out = xfers[i].out;
+            twiXfers[i].outLen = xfers[i].outLen;
+            twiXfers[i].in = NULL;
+            twiXfers[i].inLen = 0;
+        }
+        twiResult = twi_xferList(twiHandle, twiXfers, n, NULL);
+        xfers += n; count -= n;
+    }
+    return (twiResult == TWI_SIMPLE_SUCCESS ?
+        ADI_A2B_CMDLIST_SUCCESS : ADI_A2B_CMDLIST_A2B_I2C_WRITE_ERROR);
+}
+
 static ADI_A2B_CMDLIST_RESULT shell_discover_twi_write_read(
     void *twiHandle, uint8_t address,
     void *out, uint16_t outLen, void *in, uint16_t inLen, void *usr)
@@ -672,6 +949,50 @@ static void shell_discover_free_buffer(void *buffer, void *usr)
 
 typedef int (*PF)(const char *restrict format, ...);
 
+/*
+ * Loads an A2B command list.  'fileName' may be a binary itself.
+ * Otherwise the binary cache of the XML file is used if it was made
+ * from the same XML contents, else the XML file is parsed and the
+ * cache rewritten.  Returns the length of the command list, and in
+ * '*cached' if it must be freed with a2b_bin_free().
+ */
+static uint32_t shell_discover_load(const char *fileName, void **cfg,
+    A2B_CMD_TYPE *type, bool *cached, PF pf)
+{
+    char binName[64];
+    uint32_t xmlHash;
+    uint32_t len;
+
+    *cached = true;
+
+    len = a2b_bin_load(fileName, A2B_BIN_ANY_XML, cfg, type);
+    if (len) {
+        return(len);
+    }
+
+    if (!a2b_bin_file_hash(fileName, &xmlHash)) {
+        return(0);
+    }
+
+    a2b_bin_name(fileName, binName, sizeof(binName));
+    if (binName[0]) {
+        len = a2b_bin_load(binName, xmlHash, cfg, type);
+        if (len) {
+            return(len);
+        }
+    }
+
+    *cached = false;
+    len = a2b_xml_load(fileName, cfg, type);
+    if (len && binName[0]) {
+        if (a2b_bin_save(binName, xmlHash, *cfg, len, *type) && pf) {
+            pf("A2B config cached in '%s'\n", binName);
+        }
+    }
+
+    return(len);
+}
+
 void shell_discover(SHELL_CONTEXT *ctx, int argc, char **argv)
 {
     const char *fileName = "a2b.xml";
@@ -686,6 +1007,8 @@ void shell_discover(SHELL_CONTEXT *ctx, int argc, char **argv)
     uint8_t ad2425I2CAddr;
     bool reset;
     A2B_CMD_TYPE a2bCmdType;
+    bool a2bCached;
+    TickType_t loadTicks;
     ADI_A2B_CMDLIST *list;
     ADI_A2B_CMDLIST_EXECUTE_INFO execInfo;
     ADI_A2B_CMDLIST_SCAN_INFO scanInfo;
@@ -697,6 +1020,7 @@ void shell_discover(SHELL_CONTEXT *ctx, int argc, char **argv)
         .twiWrite = shell_discover_twi_write,
         .twiWriteRead = shell_discover_twi_write_read,
         .twiWriteWrite = shell_discover_twi_write_write,
+        .twiWriteList = shell_discover_twi_write_list,
         .delay = shell_discover_delay,
         .getTime = shell_discover_get_time,
         .getBuffer = shell_discover_get_buffer,
@@ -776,7 +1100,15 @@ void shell_discover(SHELL_CONTEXT *ctx, int argc, char **argv)
     }
 
     /* Load the A2B network init */
-    a2bIinitLength = a2b_xml_load(fileName, &a2bInitSequence, &a2bCmdType);
+    loadTicks = xTaskGetTickCount();
+    a2bIinitLength = shell_discover_load(fileName, &a2bInitSequence,
+        &a2bCmdType, &a2bCached, pf);
+    loadTicks = xTaskGetTickCount() - loadTicks;
+    if (pf && a2bIinitLength) {
+        pf("A2B config load: %lu mS (%s)\n",
+            (unsigned long)(loadTicks * (1000 / configTICK_RATE_HZ)),
+            a2bCached ? "binary" : "xml");
+    }
 
     /* If successful, play out the binary init sequence */
     if (a2bIinitLength && a2bInitSequence) {
@@ -823,10 +1155,18 @@ void shell_discover(SHELL_CONTEXT *ctx, int argc, char **argv)
         cmdListResult = adi_a2b_cmdlist_override(list, &overrideInfo);
 
         /* Run the command list */
+        loadTicks = xTaskGetTickCount();
         cmdListResult = adi_a2b_cmdlist_execute(list, &execInfo);
+        loadTicks = xTaskGetTickCount() - loadTicks;
 
         if (pf) {
             pf("A2B config lines processed: %lu\n", execInfo.linesProcessed);
+            pf("A2B I2C writes: %lu (%lu merged, %lu removed)\n",
+                (unsigned long)execInfo.twiWrites,
+                (unsigned long)execInfo.writesMerged,
+                (unsigned long)execInfo.writesDropped);
+            pf("A2B discovery time: %lu mS\n",
+                (unsigned long)(loadTicks * (1000 / configTICK_RATE_HZ)));
             pf("A2B discovery result: %s\n", execInfo.resultStr);
             pf("A2B nodes discovered: %d\n", execInfo.nodesDiscovered);
         }
@@ -835,7 +1175,11 @@ void shell_discover(SHELL_CONTEXT *ctx, int argc, char **argv)
         cmdListResult = adi_a2b_cmdlist_close(&list);
 
         /* Free the network config */
-        a2b_xml_free(a2bInitSequence, a2bIinitLength, a2bCmdType);
+        if (a2bCached) {
+            a2b_bin_free(a2bInitSequence);
+        } else {
+            a2b_xml_free(a2bInitSequence, a2bIinitLength, a2bCmdType);
+        }
 
     } else {
         if (pf) {
@@ -886,11 +1230,20 @@ void shell_df( SHELL_CONTEXT *ctx, int argc, char **argv )
     if (sf) {
         if (context->spiffsHandle) {
             s32_t serr;
+            SPIFFS_INDEX_INFO info;
             serr = SPIFFS_info(context->spiffsHandle, &size, &used);
             if (serr == SPIFFS_OK) {
                   printf("%-10s %10u %10u %10u %5u\n", SPIFFS_VOL_NAME,
                     (unsigned)size, (unsigned)used, (unsigned)(size - used),
                     (unsigned)((100 * used) / size));
+                  spiffs_index_info(context->spiffsHandle, &info);
+                  printf("Index: mounted by %s, gen %u, %u files%s%s\n",
+                    info.mounted ? "index" : "scan", (unsigned)info.generation,
+                    (unsigned)info.files, info.complete ? "" : " (partial)",
+                    info.live ? ", saved" : "");
+                  printf("Lookups: %u hit, %u miss, %u scan\n",
+                    (unsigned)info.hits, (unsigned)info.misses,
+                    (unsigned)info.scans);
             }
         }
     }
@@ -930,17 +1283,18 @@ void shell_cat( SHELL_CONTEXT *ctx, int argc, char **argv )
 {
     FILE *handle;
     unsigned i;
-    unsigned char c;
+    char buf[64];
+    size_t len;
 
     if( argc < 2 ) {
         printf( "Usage: cat <filename1> [<filename2> ...]\n" );
         return;
     }
     for( i = 1; i < argc; i ++ ) {
-        if( ( handle = fopen( argv[ i ], "r" ) ) > 0 )
+        if( ( handle = fs_devio_fopen( argv[ i ], "r", 0, 0 ) ) != NULL )
         {
-            while (fread(&c, sizeof(c), 1, handle) > 0) {
-                printf("%c", c);
+            while ((len = fread(buf, sizeof(buf[0]), sizeof(buf), handle)) > 0) {
+                fwrite(buf, sizeof(buf[0]), len, stdout);
             }
             fclose(handle);
         } else {
@@ -968,10 +1322,10 @@ void shell_cp( SHELL_CONTEXT *ctx, int argc, char **argv )
       return;
    }
 
-   if( ( fps = fopen( argv[ 1 ], "r" ) ) == NULL ) {
+   if( ( fps = fs_devio_fopen( argv[ 1 ], "r", 0, 0 ) ) == NULL ) {
       printf( "Unable to open %s for reading\n", argv[ 1 ] );
    } else {
-      if( ( fpd = fopen( argv[ 2 ], "w" ) ) == NULL ) {
+      if( ( fpd = fs_devio_fopen( argv[ 2 ], "w", 0, 0 ) ) == NULL ) {
          printf( "Unable to open %s for writing\n", argv[ 2 ] );
       } else {
          if( ( buf = SHELL_MALLOC( SHELL_COPY_BUFSIZE ) ) == NULL ) {
@@ -1117,7 +1471,14 @@ void shell_cpu( SHELL_CONTEXT *ctx, int argc, char **argv )
         (unsigned)percentCpuLoad, (unsigned)maxCpuLoad);
     printf("SHARC0 Load:\n");
     for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
-        printf(" %s: %lu\n", clock_domain_str(i), context->sharc0Cycles[i]);
+        printf(" %s: %lu", clock_domain_str(i), context->sharc0Cycles[i]);
+        if (context->sharc0CoreCycles[i]) {
+            printf(" (%lu without MDMA, %ld saved)",
+                context->sharc0CoreCycles[i],
+                (long)context->sharc0CoreCycles[i] -
+                    (long)context->sharc0Cycles[i]);
+        }
+        printf("\n");
     }
     printf("SHARC1 Load:\n");
     for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
@@ -1125,6 +1486,167 @@ void shell_cpu( SHELL_CONTEXT *ctx, int argc, char **argv )
     }
 }
 
+/***********************************************************************
+ * CMD: domain
+ **********************************************************************/
+const char shell_help_domain[] = "[<member> <domain|none>]\n"
+  "  member - codec_in, codec_out, a2b_in, a2b_out, usb_rx, usb_tx,\n"
+  "           wav_src, wav_sink, spdif_in, spdif_out, mic_in\n"
+  "  domain - system, a2b, spdif\n"
+  "Without arguments shows the clock domains\n";
+const char shell_help_summary_domain[] = "Shows and manages audio clock domains";
+
+static const struct {
+    char *name;
+    unsigned mask;
+} domainMembers[] = {
+    { "codec_in",  CLOCK_DOMAIN_BITM_CODEC_IN },
+    { "codec_out", CLOCK_DOMAIN_BITM_CODEC_OUT },
+    { "a2b_in",    CLOCK_DOMAIN_BITM_A2B_IN },
+    { "a2b_out",   CLOCK_DOMAIN_BITM_A2B_OUT },
+    { "usb_rx",    CLOCK_DOMAIN_BITM_USB_RX },
+    { "usb_tx",    CLOCK_DOMAIN_BITM_USB_TX },
+    { "wav_src",   CLOCK_DOMAIN_BITM_WAV_SRC },
+    { "wav_sink",  CLOCK_DOMAIN_BITM_WAV_SINK },
+    { "spdif_in",  CLOCK_DOMAIN_BITM_SPDIF_IN },
+    { "spdif_out", CLOCK_DOMAIN_BITM_SPDIF_OUT },
+    { "mic_in",    CLOCK_DOMAIN_BITM_MIC_IN },
+};
+
+#define DOMAIN_MEMBERS (sizeof(domainMembers) / sizeof(domainMembers[0]))
+
+void shell_domain(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    CLOCK_DOMAIN_STATE *cd;
+    CLOCK_DOMAIN domain;
+    unsigned mask;
+    unsigned i, j;
+
+    if (argc == 1) {
+        for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
+            cd = &context->clockDomain[i];
+            printf("%s: %luHz, %lu blocks, %lu stalls\n",
+                clock_domain_str(i),
+                (unsigned long)clock_domain_rate(context, i),
+                (unsigned long)cd->blocks, (unsigned long)cd->stalls);
+            printf(" ");
+            for (j = 0; j < DOMAIN_MEMBERS; j++) {
+                mask = domainMembers[j].mask;
+                if (cd->mask & mask) {
+                    printf(" %s%s%s", domainMembers[j].name,
+                        (cd->source & mask) ? "*" : "",
+                        (cd->stalled & mask) ? "(stalled)" : "");
+                }
+            }
+            printf("\n");
+        }
+        return;
+    }
+
+    if (argc != 3) {
+        printf("Invalid arguments\n");
+        return;
+    }
+
+    mask = 0;
+    for (j = 0; j < DOMAIN_MEMBERS; j++) {
+        if (strcmp(argv[1], domainMembers[j].name) == 0) {
+            mask = domainMembers[j].mask;
+            break;
+        }
+    }
+    if (mask == 0) {
+        printf("Bad member\n");
+        return;
+    }
+
+    if (strcmp(argv[2], "none") == 0) {
+        domain = CLOCK_DOMAIN_MAX;
+    } else {
+        domain = clock_domain_from_str(argv[2]);
+        if (domain == CLOCK_DOMAIN_MAX) {
+            printf("Bad domain\n");
+            return;
+        }
+    }
+
+    clock_domain_set(context, domain, mask);
+}
+
+/***********************************************************************
+ * CMD: top
+ **********************************************************************/
+const char shell_help_top[] = "[-c] [-r]\n"
+  "  -c - Continuously update until a key is pressed\n"
+  "  -r - Reset the max loads\n"
+  "Loads are over the last second, ISR loads include nested callbacks\n";
+const char shell_help_summary_top[] = "Report per-task and per-ISR cpu usage";
+
+#define SHELL_TOP_MAX (CPU_LOAD_MAX_TASKS + CPU_LOAD_MAX_ISRS)
+
+static void shell_top_print(CPU_LOAD_STATS *stats, bool clearMax)
+{
+    CPU_LOAD_STATS tmp;
+    uint32_t percentCpuLoad, maxCpuLoad;
+    unsigned n, i, j;
+
+    n = cpuLoadGetStats(stats, SHELL_TOP_MAX, clearMax);
+
+    /* Sort by average load, busiest first */
+    for (i = 1; i < n; i++) {
+        tmp = stats[i];
+        for (j = i; (j > 0) && (stats[j-1].avgLoad < tmp.avgLoad); j--) {
+            stats[j] = stats[j-1];
+        }
+        stats[j] = tmp;
+    }
+
+    percentCpuLoad = cpuLoadGetLoad(&maxCpuLoad, false);
+    printf("ARM CPU Load: %u%% (%u%% peak)\n",
+        (unsigned)percentCpuLoad, (unsigned)maxCpuLoad);
+    printf("%-16s %-4s %7s %7s %7s\n", "Name", "Type", "Load", "Avg", "Max");
+    for (i = 0; i < n; i++) {
+        printf("%-16s %-4s %5u.%u%% %5u.%u%% %5u.%u%%\n",
+            stats[i].name, stats[i].isr ? "isr" : "task",
+            (unsigned)(stats[i].load / 10), (unsigned)(stats[i].load % 10),
+            (unsigned)(stats[i].avgLoad / 10), (unsigned)(stats[i].avgLoad % 10),
+            (unsigned)(stats[i].maxLoad / 10), (unsigned)(stats[i].maxLoad % 10));
+    }
+}
+
+void shell_top(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    CPU_LOAD_STATS *stats;
+    bool continuous = false;
+    bool clearMax = false;
+    int i, c;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            continuous = true;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            clearMax = true;
+        }
+    }
+
+    stats = SHELL_MALLOC(SHELL_TOP_MAX * sizeof(*stats));
+    if (stats == NULL) {
+        return;
+    }
+
+    shell_top_print(stats, clearMax);
+    if (continuous) {
+        do {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            printf("\n");
+            shell_top_print(stats, false);
+            c = term_getch(&ctx->t, TERM_INPUT_DONT_WAIT);
+        } while (c < 0);
+    }
+
+    SHELL_FREE(stats);
+}
+
 /***********************************************************************
  * CMD: usb
  **********************************************************************/
@@ -1133,7 +1655,7 @@ void shell_cpu( SHELL_CONTEXT *ctx, int argc, char **argv )
 #include "clocks.h"
 #include "clock_domain.h"
 
-const char shell_help_usb[] = "[in|out|domain] [a2b|system]\n";
+const char shell_help_usb[] = "[in|out] [domain <system|a2b|spdif>]\n";
 const char shell_help_summary_usb[] = "Displays USB performance tracking metrics";
 
 void shell_usb( SHELL_CONTEXT *ctx, int argc, char **argv )
@@ -1141,6 +1663,7 @@ void shell_usb( SHELL_CONTEXT *ctx, int argc, char **argv )
     bool showIn = true;
     bool showOut = true;
     int clockDomainMask;
+    CLOCK_DOMAIN domain;
 
     if (argc >= 2) {
         if (strcmp(argv[1], "out") == 0) {
@@ -1155,10 +1678,9 @@ void shell_usb( SHELL_CONTEXT *ctx, int argc, char **argv )
     if (argc >= 3) {
         if (strcmp(argv[2], "domain") == 0) {
             if (argc >= 4) {
-                if (strcmp(argv[3], "a2b") == 0) {
-                    clock_domain_set(context, CLOCK_DOMAIN_A2B, clockDomainMask);
-                } else if (strcmp(argv[3], "system") == 0) {
-                    clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, clockDomainMask);
+                domain = clock_domain_from_str(argv[3]);
+                if (domain < CLOCK_DOMAIN_MAX) {
+                    clock_domain_set(context, domain, clockDomainMask);
                 } else {
                     printf("Bad domain\n");
                 }
@@ -1170,6 +1692,8 @@ void shell_usb( SHELL_CONTEXT *ctx, int argc, char **argv )
         }
     }
 
+    printf("Sample Rate: %u Hz\n", (unsigned)context->sampleRate);
+
     /* USB OUT Stats */
     if (showOut) {
         printf("USB OUT (Rx):\n");
@@ -1255,7 +1779,7 @@ void shell_fsck(SHELL_CONTEXT *ctx, int argc, char **argv)
     if (sf) {
         printf("Be patient, this may take a while.\n");
         s32_t ok;
-        ok = SPIFFS_check(context->spiffsHandle);
+        ok = spiffs_check(context->spiffsHandle);
         if (ok == SPIFFS_OK) {
             printf(SPIFFS_VOL_NAME " OK\n");
         } else {
@@ -1264,14 +1788,117 @@ void shell_fsck(SHELL_CONTEXT *ctx, int argc, char **argv)
     }
 }
 
+/***********************************************************************
+ * CMD: fsio
+ **********************************************************************/
+const char shell_help_fsio[] = "\n"
+  "  Shows the open and recently closed streaming files.  Rate is the\n"
+  "  user's average rate, Media the rate of the media I/O alone.  Also\n"
+  "  shows the least stack the I/O task has had left\n";
+const char shell_help_summary_fsio[] = "Shows streaming file statistics";
+
+#define SHELL_FSIO_MAX_STREAMS  8
+
+void shell_fsio(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    FS_DEVIO_STREAM_INFO *info;
+    FS_DEVIO_STREAM_INFO *i;
+    unsigned rate, media;
+    int n, j, stackFree;
+
+    info = SHELL_MALLOC(SHELL_FSIO_MAX_STREAMS * sizeof(*info));
+    if (info == NULL) {
+        printf("Not enough memory\n");
+        return;
+    }
+
+    n = fs_devio_stream_info(info, SHELL_FSIO_MAX_STREAMS);
+
+    printf("%-20s %-6s %5s %10s %8s %8s %6s %8s %8s\n",
+        "File", "State", "Dir", "Bytes", "Rate", "Media",
+        "Stalls", "Stall ms", "Max us");
+    for (j = 0; j < n; j++) {
+        i = &info[j];
+        rate = i->elapsedMs ? (unsigned)((uint64_t)i->bytes / i->elapsedMs) : 0;
+        media = i->ioMs ? (unsigned)((uint64_t)i->bytes / i->ioMs) : 0;
+        printf("%-20.20s %-6s %5s %10u %5uKBs %5uKBs %6u %8u %8u%s\n",
+            i->name, i->open ? "open" : "closed", i->write ? "write" : "read",
+            (unsigned)i->bytes, rate, media, (unsigned)i->stalls,
+            (unsigned)i->stallMs, (unsigned)i->maxStallUs,
+            i->error ? " ERROR" : "");
+        if (i->open) {
+            printf("%-20s %u x %u buffers, %u bytes buffered\n", "",
+                i->numBufs, i->bufSize, i->buffered);
+        }
+    }
+
+    stackFree = fs_devio_task_stack_free();
+    if (stackFree >= 0) {
+        printf("I/O task stack: %d bytes free at worst\n", stackFree);
+    }
+
+    SHELL_FREE(info);
+}
+
 /***********************************************************************
  * CMD: update
  **********************************************************************/
 #include "flash_map.h"
 
-const char shell_help_update[] = "<app,fs>\n";
+const char shell_help_update[] = "[app,fs] [-s]\n"
+    "  -s  Use the resumable streaming protocol instead of XMODEM\n";
 const char shell_help_summary_update[] = "Updates the firmware via xmodem";
 
+static SXFER_SESSION appUpdateSession;
+static SXFER_SESSION fsUpdateSession;
+
+static long shell_update_stream(const FLASH_INFO *flash,
+    uint32_t flashBaseAddr, uint32_t flashSize, SXFER_SESSION *session)
+{
+    FLASH_STREAM_STATE state;
+    SXFER_CONFIG cfg;
+    long size;
+
+    state.flash = flash;
+    state.baseAddr = flashBaseAddr;
+    state.maxAddr = flashBaseAddr + flashSize;
+    state.eraseAddr = flashBaseAddr;
+    state.eraseBlockSize = ERASE_BLOCK_SIZE;
+    state.resumeOffset = 0;
+
+    cfg.read = shell_sxfer_read;
+    cfg.send = shell_sxfer_send;
+    cfg.start = flashStreamStart;
+    cfg.write = flashStreamWrite;
+    cfg.idle = flashStreamIdle;
+    cfg.usr = &state;
+    cfg.maxSize = flashSize;
+    cfg.session = session;
+
+    /* Start the update */
+    printf( "Start streaming transfer now... ");
+    size = sxfer_receive(&cfg);
+
+    /* Wait a bit */
+    delay(100);
+
+    if (size < 0) {
+       printf( "Stream Error: %ld (%u bytes written, resumable)\n",
+          size, (unsigned)session->offset);
+    } else {
+       printf("Received %ld bytes (resumed at %u).\n",
+          size, (unsigned)state.resumeOffset);
+       memset(session, 0, sizeof(*session));
+       if (state.eraseAddr < state.maxAddr) {
+          printf("Erasing remaining sectors...\n");
+          flash_erase(state.flash, state.eraseAddr,
+             state.maxAddr - state.eraseAddr);
+       }
+    }
+
+    return(size);
+}
+
 void shell_update(SHELL_CONTEXT *ctx, int argc, char **argv)
 {
     char *warn = "Updating the firmware is DANGEROUS - DO NOT REMOVE POWER!";
@@ -1280,27 +1907,36 @@ void shell_update(SHELL_CONTEXT *ctx, int argc, char **argv)
     long size;
     FLASH_WRITE_STATE state;
     const FLASH_INFO *flash;
+    SXFER_SESSION *session;
     bool checkFs;
+    bool stream;
     p_xm_data_func dataWriteFunc;
+    int i;
 
     checkFs = false;
+    stream = false;
     dataWriteFunc = flashDataWrite;
 
-    if (argc > 1) {
-        if ((argc == 2) && (strcmp(argv[1], "app") == 0)) {
+    flashBaseAddr = APP_OFFSET;
+    flashSize = APP_SIZE;
+    session = &appUpdateSession;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "app") == 0) {
            flashBaseAddr = APP_OFFSET;
            flashSize = APP_SIZE;
-        } else if ((argc == 2) && (strcmp(argv[1], "fs") == 0)) {
+           session = &appUpdateSession;
+        } else if (strcmp(argv[i], "fs") == 0) {
            flashBaseAddr = SPIFFS_OFFSET;
            flashSize = SPIFFS_SIZE;
+           session = &fsUpdateSession;
            checkFs = true;
-        }  else {
+        } else if (strcmp(argv[i], "-s") == 0) {
+           stream = true;
+        } else {
            printf( "Usage: %s %s", argv[0], shell_help_update);
            return;
         }
-    } else {
-        flashBaseAddr = APP_OFFSET;
-        flashSize = APP_SIZE;
     }
 
     /* Confirm action */
@@ -1315,6 +1951,23 @@ void shell_update(SHELL_CONTEXT *ctx, int argc, char **argv)
         return;
     }
 
+    /* The mount index no longer describes the new image */
+    if (checkFs && context->spiffsHandle) {
+        spiffs_index_discard(context->spiffsHandle);
+    }
+
+    if (stream) {
+        shell_update_stream(flash, flashBaseAddr, flashSize, session);
+        if (checkFs) {
+           shell_fsck(ctx, 0, NULL);
+        }
+        printf("Done.\n");
+        return;
+    }
+
+    /* XMODEM rewrites the region, so nothing can be resumed */
+    memset(session, 0, sizeof(*session));
+
     /* Configure the update */
     state.flash = flash;
     state.addr = flashBaseAddr;
@@ -1355,20 +2008,53 @@ void shell_update(SHELL_CONTEXT *ctx, int argc, char **argv)
 /***********************************************************************
  * CMD: meminfo
  **********************************************************************/
-const char shell_help_meminfo[] = "\n";
-const char shell_help_summary_meminfo[] = "Displays UMM_MALLOC heap statistics";
+const char shell_help_meminfo[] = "[-i on|off] [-p on|off]\n"
+  "  -i  - Heap integrity check before every heap operation\n"
+  "  -p  - Poison guard new allocations, verified when freed\n"
+  "  Check settings apply to all heaps\n";
+const char shell_help_summary_meminfo[] = "Displays UMM_MALLOC and SAE heap statistics";
 
+#include "umm_malloc.h"
 #include "umm_malloc_cfg.h"
 #include "umm_malloc_heaps.h"
 const static char *heapNames[] = UMM_HEAP_NAMES;
+const static char *saePoolNames[SAE_POOL_MAX] = { "L2", "SDRAM" };
 
 void shell_meminfo(SHELL_CONTEXT *ctx, int argc, char **argv )
 {
     UMM_HEAP_INFO ummHeapInfo;
+    SAE_HEAP_INFO saeHeapInfo;
+    SAE_RESULT result;
+    unsigned int set = 0;
+    unsigned int clr = 0;
+    unsigned int flag;
+    unsigned int checks;
     int i;
     int ok;
 
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0) {
+            flag = UMM_CHECK_INTEGRITY;
+        } else if (strcmp(argv[i], "-p") == 0) {
+            flag = UMM_CHECK_POISON;
+        } else {
+            printf("Invalid option %s\n", argv[i]);
+            return;
+        }
+        if ((i + 1 < argc) && (strcmp(argv[i + 1], "on") == 0)) {
+            set |= flag;
+        } else if ((i + 1 < argc) && (strcmp(argv[i + 1], "off") == 0)) {
+            clr |= flag;
+        } else {
+            printf("Missing on|off for %s\n", argv[i]);
+            return;
+        }
+        i++;
+    }
+
     for (i = 0; i < UMM_NUM_HEAPS; i++) {
+        checks = (umm_get_checks((umm_heap_t)i) | set) & ~clr;
+        umm_set_checks((umm_heap_t)i, checks);
         printf("Heap %s Info:\n", heapNames[i]);
         ok = umm_integrity_check((umm_heap_t)i);
         if (ok) {
@@ -1389,6 +2075,31 @@ void shell_meminfo(SHELL_CONTEXT *ctx, int argc, char **argv )
             );
         }
         printf("  Heap Integrity: %s\n", ok ? "OK" : "Corrupt");
+        printf("  Heap Checks: Integrity %s, Poison %s\n",
+            (checks & UMM_CHECK_INTEGRITY) ? "on" : "off",
+            (checks & UMM_CHECK_POISON) ? "on" : "off");
+    }
+
+    for (i = 0; i < SAE_POOL_MAX; i++) {
+        result = sae_heapInfo(context->saeContext, (SAE_POOL)i, &saeHeapInfo);
+        if (result == SAE_RESULT_ERROR) {
+            continue;
+        }
+        printf("SAE Pool %s Info:\n", saePoolNames[i]);
+        if (result == SAE_RESULT_OK) {
+            printf("  Blocks: Total  %8u, Allocated %8u, Free %8u\n",
+                saeHeapInfo.totalBlocks,
+                saeHeapInfo.allocBlocks,
+                saeHeapInfo.freeBlocks
+            );
+            printf("   Bytes: Allocated %8u, Free %8u, Contig %8u\n",
+                (unsigned)saeHeapInfo.allocSize,
+                (unsigned)saeHeapInfo.freeSize,
+                (unsigned)saeHeapInfo.maxContigFreeSize
+            );
+        }
+        printf("  Heap Integrity: %s\n",
+            (result == SAE_RESULT_OK) ? "OK" : "Corrupt");
     }
 }
 
@@ -1476,6 +2187,8 @@ const char shell_help_route[] =
     "  Clear routing table\n";
 const char shell_help_summary_route[] = "Configures the audio routing table";
 
+#include "route_control.h"
+
 static char *stream2str(int streamID)
 {
     char *str = "NONE";
@@ -1546,16 +2259,39 @@ int str2stream(char *stream, bool src)
     return(IPC_STREAM_ID_MAX);
 }
 
+/* Give SHARC0 a moment to acknowledge a new routing table */
+static void shell_route_publish(void)
+{
+    unsigned i;
+
+    if (!route_control_publish(context)) {
+        printf("Unable to send the routing table\n");
+        return;
+    }
+    for (i = 0; (i < 10) && !route_control_applied(context); i++) {
+        delay(10);
+    }
+    if (!route_control_applied(context)) {
+        printf("Routing table %u pending\n",
+            (unsigned)context->routing->generation);
+    }
+}
+
 void shell_route(SHELL_CONTEXT *ctx, int argc, char **argv)
 {
-    IPC_MSG_ROUTING *routeInfo = (IPC_MSG_ROUTING *)&context->routingMsg->routes;
+    IPC_MSG_ROUTING *routeInfo = context->routing;
     ROUTE_INFO *route;
     unsigned i;
     unsigned idx, srcOffset, sinkOffset, channels, attenuation;
     int srcID, sinkID;
 
     if (argc == 1) {
-        printf("Audio Routing\n");
+        if (routeInfo == NULL) {
+            printf("No routing table\n");
+            return;
+        }
+        printf("Audio Routing (table %u%s)\n", (unsigned)routeInfo->generation,
+            route_control_applied(context) ? "" : ", pending");
         for (i = 0; i < routeInfo->numRoutes; i++) {
             route = &routeInfo->routes[i];
             printf(" [%02d]: %s[%u] -> %s[%u], CHANNELS: %u, %s%udB\n",
@@ -1570,24 +2306,22 @@ void shell_route(SHELL_CONTEXT *ctx, int argc, char **argv)
         return;
     } else if (argc == 2) {
         if (strcmp(argv[1], "clear") == 0) {
-            for (i = 0; i < routeInfo->numRoutes; i++) {
-                route = &routeInfo->routes[i];
-                /* Configure the route atomically in a critical section */
-                taskENTER_CRITICAL();
-                route->srcID = IPC_STREAMID_UNKNOWN;
-                route->srcOffset = 0;
-                route->sinkID = IPC_STREAMID_UNKNOWN;
-                route->sinkOffset = 0;
-                route->channels = 0;
-                route->attenuation = 0;
-                taskEXIT_CRITICAL();
+            if (route_control_begin(context, true) == NULL) {
+                printf("Out of memory\n");
+                return;
             }
+            shell_route_publish();
+            return;
         }
     }
 
     /* Confirm a valid route index */
+    if (routeInfo == NULL) {
+        printf("No routing table\n");
+        return;
+    }
     idx = atoi(argv[1]);
-    if (idx > routeInfo->numRoutes) {
+    if (idx >= routeInfo->numRoutes) {
         printf("Invalid idx\n");
         return;
     }
@@ -1637,15 +2371,21 @@ void shell_route(SHELL_CONTEXT *ctx, int argc, char **argv)
         attenuation = 0;
     }
 
-    /* Configure the route atomically in a critical section */
-    taskENTER_CRITICAL();
+    /* Change the route in a copy of the table and swap it in */
+    routeInfo = route_control_begin(context, false);
+    if (routeInfo == NULL) {
+        printf("Out of memory\n");
+        return;
+    }
+    route = &routeInfo->routes[idx];
     route->srcID = srcID;
     route->srcOffset = srcOffset;
     route->sinkID = sinkID;
     route->sinkOffset = sinkOffset;
     route->channels = channels;
     route->attenuation = attenuation;
-    taskEXIT_CRITICAL();
+
+    shell_route_publish();
 }
 
 
@@ -1680,6 +2420,7 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
     bool isSrc;
     bool ok = true;
     int clockDomainMask;
+    CLOCK_DOMAIN domain;
     bool channelsSpecified = false;
 
     if (argc == 1) {
@@ -1725,10 +2466,9 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
             on = false;
         } else if (strcmp(argv[2], "domain") == 0) {
             if (argc >= 4) {
-                if (strcmp(argv[3], "a2b") == 0) {
-                    clock_domain_set(context, CLOCK_DOMAIN_A2B, clockDomainMask);
-                } else if (strcmp(argv[3], "system") == 0) {
-                    clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, clockDomainMask);
+                domain = clock_domain_from_str(argv[3]);
+                if (domain < CLOCK_DOMAIN_MAX) {
+                    clock_domain_set(context, domain, clockDomainMask);
                 } else {
                     printf("Bad domain\n");
                 }
@@ -1775,7 +2515,7 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
     if (on) {
         if (!isSrc) {
             wf->channels = channels;
-            wf->sampleRate = SYSTEM_SAMPLE_RATE;
+            wf->sampleRate = context->sampleRate;
             wf->wordSizeBytes = wordSizeBytes;
             wf->frameSizeBytes = SYSTEM_BLOCK_SIZE * wf->wordSizeBytes;
         }
@@ -1801,7 +2541,7 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
                     printf("Must be S16_LE or S32_LE format\n");
                     closeWave(wf);
                 }
-                if (wf->waveInfo.sampleRate != SYSTEM_SAMPLE_RATE) {
+                if (wf->waveInfo.sampleRate != context->sampleRate) {
                     syslog_printf("WAV file sample rate mismatch: %d\n",
                         wf->waveInfo.sampleRate);
                     if (channelsSpecified) {
@@ -1836,6 +2576,17 @@ void shell_a2b( SHELL_CONTEXT *ctx, int argc, char **argv )
     if (argc == 1) {
         printf("A2B Mode: %s\n",
             context->a2bmode == A2B_BUS_MODE_MASTER ? "master" : "slave");
+        if (context->a2bmode == A2B_BUS_MODE_SLAVE) {
+            printf("A2B Slave: %s, %u IRQs, %u starts\n",
+                context->a2bSlaveActive ? "active" : "idle",
+                (unsigned)context->a2bSlaveIrqs,
+                (unsigned)context->a2bSlaveStarts);
+            if (context->a2bSlaveStarts) {
+                printf("A2B Slave start latency: %u uS\n",
+                    (unsigned)(((uint64_t)context->a2bSlaveLatency * 1000000ULL) /
+                        CGU_TS_CLK));
+            }
+        }
         return;
     }
 
@@ -1860,4 +2611,639 @@ void shell_a2b( SHELL_CONTEXT *ctx, int argc, char **argv )
         }
     }
 
-}
\ No newline at end of file
+}
+
+/***********************************************************************
+ * CMD: trace
+ **********************************************************************/
+#include "trace_capture.h"
+
+const char shell_help_trace[] = "<start|stop|status|dump|save <file>>\n"
+  "  start - Discard old events and start capturing on all cores\n"
+  "  stop - Stop capturing\n"
+  "  status - Show capture state and event counts\n"
+  "  dump - Write the merged capture to the console\n"
+  "  save - Write the merged capture to a file (i.e. sd:trace.json)\n"
+  "Captures are written in Chrome/Perfetto JSON format\n";
+const char shell_help_summary_trace[] = "Captures a cross-core event trace";
+
+void shell_trace(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    TRACE_BUFFER *tb;
+    unsigned events;
+    uint32_t head;
+    FILE *f;
+    int i;
+
+    if (argc < 2) {
+        printf("Invalid arguments. Type help [<command>] for usage.\n");
+        return;
+    }
+
+    if (strcmp(argv[1], "start") == 0) {
+        if (trace_capture_start(context)) {
+            printf("Trace started\n");
+        } else {
+            printf("Unable to allocate trace buffer!\n");
+        }
+    } else if (strcmp(argv[1], "stop") == 0) {
+        trace_capture_stop(context);
+        printf("Trace stopped\n");
+    } else if (strcmp(argv[1], "status") == 0) {
+        tb = trace_buffer();
+        if (tb == NULL) {
+            printf("No trace buffer\n");
+            return;
+        }
+        printf("Trace %s\n", tb->enable ? "running" : "stopped");
+        for (i = 0; i < IPC_MAX_CORES; i++) {
+            head = tb->head[i];
+            printf(" Core %d: %lu events, %lu overwritten\n", i,
+                (unsigned long)(head > tb->events ? tb->events : head),
+                (unsigned long)(head > tb->events ? head - tb->events : 0));
+        }
+    } else if (strcmp(argv[1], "dump") == 0) {
+        trace_capture_export(context, stdout);
+    } else if ((strcmp(argv[1], "save") == 0) && (argc > 2)) {
+        f = fopen(argv[2], "w");
+        if (f == NULL) {
+            printf("Unable to open %s\n", argv[2]);
+            return;
+        }
+        events = trace_capture_export(context, f);
+        fclose(f);
+        printf("Saved %u events to %s\n", events, argv[2]);
+    } else {
+        printf("Invalid arguments. Type help [<command>] for usage.\n");
+    }
+}
+
+/***********************************************************************
+ * CMD: bench
+ **********************************************************************/
+#include "bench.h"
+
+const char shell_help_bench[] = "[list] [-n <iters>] [filter]\n"
+  "  list - List the available benchmarks\n"
+  "  -n - Timed iterations per benchmark (default 1000)\n"
+  "  filter - Only run benchmarks whose name contains this string\n"
+  "Results are printed one CSV line per benchmark in nanoseconds\n"
+  "spiffs/fatfs benchmarks write to sf:bench.bin and sd:bench.bin\n";
+const char shell_help_summary_bench[] = "Runs on-target micro-benchmarks";
+
+void shell_bench(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    const char *filter = NULL;
+    unsigned iters = BENCH_DEFAULT_ITERS;
+    unsigned ran;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "list") == 0) {
+            bench_list(stdout);
+            return;
+        } else if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            iters = strtoul(argv[++i], NULL, 0);
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    ran = bench_run(context, filter, iters, stdout);
+    printf("# %u benchmarks\n", ran);
+}
+
+/***********************************************************************
+ * CMD: boot
+ **********************************************************************/
+#include "boot.h"
+
+const char shell_help_boot[] = "\n"
+  "  Shows the start and end time of each boot stage, the worker\n"
+  "  that ran it, and the total boot time since reset.\n"
+  "  Build with BOOT_WORKERS=0 for a serial boot baseline\n";
+const char shell_help_summary_boot[] = "Shows the boot timeline";
+
+void shell_boot(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    boot_timeline(stdout);
+}
+
+/***********************************************************************
+ * CMD: meter
+ **********************************************************************/
+#include "meter_capture.h"
+#include "clock_domain.h"
+#include "mixer.h"
+
+const char shell_help_meter[] = "[off] [-c] [-r <ms>] [-d <dB/s>] [-z] [stream]\n"
+  "  off - Stop metering\n"
+  "  -c - Continuously update until a key is pressed\n"
+  "  -r - RMS averaging time constant in mS (300 default)\n"
+  "  -d - Peak decay in dB per second (20 default)\n"
+  "  -z - Reset the max metering cycles\n"
+  "  stream - Show each channel of one stream (i.e. usb_rx)\n"
+  "Levels are in dBFS, peak and RMS are the loudest channel when\n"
+  "no stream is given.  Metering starts on first use and only covers\n"
+  "the stream asked for, or all of them for the summary\n";
+const char shell_help_summary_meter[] = "Shows per-stream audio levels";
+
+#define SHELL_METER_BAR      (30)
+#define SHELL_METER_BAR_DB   (60)
+
+static char *shell_meter_db(char *buf, float level)
+{
+    int db10 = meter_db10(level);
+
+    sprintf(buf, "%s%d.%d", db10 < 0 ? "-" : "",
+        abs(db10) / 10, abs(db10) % 10);
+
+    return(buf);
+}
+
+static void shell_meter_print(METER_TABLE *mt, METER_LEVELS *lv, int streamID)
+{
+    char pk[8], rms[8];
+    float maxPeak, maxRms;
+    unsigned i, ch, bar;
+    int db10;
+
+    if (streamID != IPC_STREAMID_UNKNOWN) {
+        if (!meter_read(mt, streamID, lv) || (lv->numChannels == 0)) {
+            printf("%s: no audio\n", stream2str(streamID));
+            return;
+        }
+        printf("%s (%s, %u blocks)\n", stream2str(streamID),
+            clock_domain_str(lv->clockDomain), (unsigned)lv->blocks);
+        printf("%-4s %7s %7s\n", "Ch", "Peak", "RMS");
+        for (ch = 0; ch < lv->numChannels; ch++) {
+            db10 = meter_db10(lv->peak[ch]);
+            bar = 0;
+            if (db10 > -SHELL_METER_BAR_DB * 10) {
+                bar = ((db10 + SHELL_METER_BAR_DB * 10) * SHELL_METER_BAR) /
+                    (SHELL_METER_BAR_DB * 10);
+            }
+            printf("%-4u %7s %7s |", ch, shell_meter_db(pk, lv->peak[ch]),
+                shell_meter_db(rms, lv->rms[ch]));
+            for (i = 0; i < SHELL_METER_BAR; i++) {
+                putchar(i < bar ? '#' : ' ');
+            }
+            printf("|\n");
+        }
+        return;
+    }
+
+    printf("%-10s %3s %-12s %7s %7s %10s\n",
+        "Stream", "Ch", "Domain", "Peak", "RMS", "Blocks");
+    for (i = IPC_STREAMID_UNKNOWN + 1; i < IPC_STREAM_ID_MAX; i++) {
+        if (!meter_read(mt, i, lv) || (lv->numChannels == 0)) {
+            continue;
+        }
+        maxPeak = 0.0f; maxRms = 0.0f;
+        for (ch = 0; ch < lv->numChannels; ch++) {
+            if (lv->peak[ch] > maxPeak) {
+                maxPeak = lv->peak[ch];
+            }
+            if (lv->rms[ch] > maxRms) {
+                maxRms = lv->rms[ch];
+            }
+        }
+        printf("%-10s %3u %-12s %7s %7s %10u\n", stream2str(i),
+            lv->numChannels, clock_domain_str(lv->clockDomain),
+            shell_meter_db(pk, maxPeak), shell_meter_db(rms, maxRms),
+            (unsigned)lv->blocks);
+    }
+
+    printf("SHARC0 metering cost per block\n");
+    for (i = 0; i < IPC_CYCLE_DOMAIN_MAX; i++) {
+        if (mt->channels[i] == 0) {
+            continue;
+        }
+        printf(" %-12s %3u ch: %6u cycles (%u max), %u cycles/ch\n",
+            clock_domain_str(i), (unsigned)mt->channels[i],
+            (unsigned)mt->cycles[i], (unsigned)mt->maxCycles[i],
+            (unsigned)(mt->cycles[i] / mt->channels[i]));
+    }
+}
+
+void shell_meter(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    METER_LEVELS *lv;
+    METER_TABLE *mt;
+    unsigned rmsMs = METER_RMS_MS;
+    unsigned decayDb = METER_PEAK_DECAY_DB;
+    bool continuous = false;
+    bool reset = false;
+    int streamID = IPC_STREAMID_UNKNOWN;
+    uint32_t streams;
+    int i, c;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "off") == 0) {
+            meter_capture_stop(context);
+            printf("Metering stopped\n");
+            return;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            continuous = true;
+        } else if (strcmp(argv[i], "-z") == 0) {
+            reset = true;
+        } else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) {
+            rmsMs = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-d") == 0) && (i + 1 < argc)) {
+            decayDb = atoi(argv[++i]);
+        } else {
+            streamID = mixer_stream_id(argv[i]);
+            if (streamID == IPC_STREAMID_UNKNOWN) {
+                printf("Invalid stream '%s'\n", argv[i]);
+                return;
+            }
+        }
+    }
+
+    streams = (streamID == IPC_STREAMID_UNKNOWN) ?
+        METER_ALL_STREAMS : METER_STREAM(streamID);
+
+    mt = meter_table();
+    if ((mt == NULL) || !mt->enable || (mt->streams != streams) ||
+        (rmsMs != METER_RMS_MS) || (decayDb != METER_PEAK_DECAY_DB)) {
+        if (!meter_capture_start(context, rmsMs, decayDb)) {
+            printf("Unable to allocate meter table!\n");
+            return;
+        }
+        meter_capture_select(context, streams);
+        mt = meter_table();
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    if (reset) {
+        meter_capture_reset(context);
+    }
+
+    lv = SHELL_MALLOC(sizeof(*lv));
+    if (lv == NULL) {
+        return;
+    }
+
+    shell_meter_print(mt, lv, streamID);
+    if (continuous) {
+        do {
+            vTaskDelay(pdMS_TO_TICKS(250));
+            printf("\n");
+            shell_meter_print(mt, lv, streamID);
+            c = term_getch(&ctx->t, TERM_INPUT_DONT_WAIT);
+        } while (c < 0);
+    }
+
+    SHELL_FREE(lv);
+}
+
+/***********************************************************************
+ * CMD: latency
+ **********************************************************************/
+#include <math.h>
+
+#include "latency_probe.h"
+
+const char shell_help_latency[] = "[-m] [-n <trials>] [-l <dBFS>] [-c <frames>] <inject>[:ch] <detect>[:ch]\n"
+  "  -m - Send a maximum length sequence instead of an impulse\n"
+  "  -n - Number of trials (10 default)\n"
+  "  -l - Marker level in dBFS (-6 impulse, -20 MLS default)\n"
+  "  -c - Frames to capture per trial including the lead (4096 default)\n"
+  "  inject - Stream and channel carrying the marker (i.e. codec_out:0)\n"
+  "  detect - Stream and channel the marker is found on (i.e. codec_in:0)\n"
+  "Inject a sink and detect a source to measure an external loopback,\n"
+  "inject a source and detect a sink to measure an internal route.\n"
+  "The inject channel is muted for the duration of each trial\n";
+const char shell_help_summary_latency[] = "Measures audio path latency";
+
+#define SHELL_LATENCY_TRIALS   (10)
+#define SHELL_LATENCY_CAPTURE  (4096)
+#define SHELL_LATENCY_GAP_MS   (50)
+
+static bool shell_latency_endpoint(const char *arg, uint8_t *streamID,
+    uint8_t *channel)
+{
+    char name[16];
+    const char *colon;
+    size_t len;
+    int id;
+
+    colon = strchr(arg, ':');
+    len = colon ? (size_t)(colon - arg) : strlen(arg);
+    if (len >= sizeof(name)) {
+        return(false);
+    }
+    memcpy(name, arg, len);
+    name[len] = '\0';
+
+    id = mixer_stream_id(name);
+    if (id == IPC_STREAMID_UNKNOWN) {
+        return(false);
+    }
+    *streamID = id;
+    *channel = colon ? atoi(colon + 1) : 0;
+
+    return(true);
+}
+
+/* Samples in tenths */
+static char *shell_latency_samples(char *buf, float samples)
+{
+    long x10 = lrintf(samples * 10.0f);
+
+    sprintf(buf, "%s%ld.%ld", x10 < 0 ? "-" : "", labs(x10) / 10, labs(x10) % 10);
+
+    return(buf);
+}
+
+static unsigned shell_latency_us(float samples)
+{
+    return((unsigned)lrintf(samples * 1000000.0f / (float)context->sampleRate));
+}
+
+void shell_latency(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    LATENCY_PROBE_CFG cfg;
+    LATENCY_RESULT result;
+    LATENCY_STATS stats;
+    unsigned trials = SHELL_LATENCY_TRIALS;
+    unsigned endpoints = 0;
+    unsigned minCapture;
+    bool levelSet = false;
+    char s1[16], s2[16], s3[16];
+    float mean, jitter;
+    unsigned t;
+    int i, c;
+    bool ok;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.signal = LATENCY_SIGNAL_IMPULSE;
+    cfg.captureLen = SHELL_LATENCY_CAPTURE;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0) {
+            cfg.signal = LATENCY_SIGNAL_MLS;
+        } else if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            trials = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-l") == 0) && (i + 1 < argc)) {
+            cfg.levelDb = atoi(argv[++i]);
+            levelSet = true;
+        } else if ((strcmp(argv[i], "-c") == 0) && (i + 1 < argc)) {
+            cfg.captureLen = atoi(argv[++i]);
+        } else if (endpoints == 0) {
+            ok = shell_latency_endpoint(argv[i], &cfg.srcID, &cfg.srcChannel);
+            if (!ok) {
+                printf("Invalid stream '%s'\n", argv[i]);
+                return;
+            }
+            endpoints++;
+        } else if (endpoints == 1) {
+            ok = shell_latency_endpoint(argv[i], &cfg.sinkID, &cfg.sinkChannel);
+            if (!ok) {
+                printf("Invalid stream '%s'\n", argv[i]);
+                return;
+            }
+            endpoints++;
+        } else {
+            printf("Invalid argument '%s'\n", argv[i]);
+            return;
+        }
+    }
+
+    if (endpoints != 2) {
+        printf("Need an inject and a detect stream\n");
+        return;
+    }
+    if (!levelSet) {
+        cfg.levelDb = (cfg.signal == LATENCY_SIGNAL_MLS) ? -20 : -6;
+    }
+    if (cfg.levelDb > 0) {
+        cfg.levelDb = 0;
+    }
+    if ((cfg.captureLen == 0) || (cfg.captureLen > LATENCY_CAPTURE_MAX)) {
+        cfg.captureLen = LATENCY_CAPTURE_MAX;
+    }
+    minCapture = LATENCY_LEAD_FRAMES +
+        ((cfg.signal == LATENCY_SIGNAL_MLS) ? LATENCY_MLS_LEN : 1);
+    if (cfg.captureLen <= minCapture) {
+        printf("Capture must be longer than %u frames\n", minCapture);
+        return;
+    }
+
+    printf("%s:%u -> %s:%u, %s at %d dBFS, %u frame capture\n",
+        stream2str(cfg.srcID), cfg.srcChannel,
+        stream2str(cfg.sinkID), cfg.sinkChannel,
+        cfg.signal == LATENCY_SIGNAL_MLS ? "MLS" : "impulse",
+        cfg.levelDb, cfg.captureLen);
+    printf("%5s %9s %8s %8s\n", "Trial", "Samples", "uS", "Gain");
+
+    latency_stats_reset(&stats);
+    for (t = 0; t < trials; t++) {
+        ok = latency_probe_trial(context, &cfg, &result);
+        if (!ok) {
+            printf("Probe failed, check the streams and channels\n");
+            break;
+        }
+        latency_stats_add(&stats, &result);
+        if (result.found) {
+            printf("%5u %9s %8u %8s%s\n", t + 1,
+                shell_latency_samples(s1, result.samples),
+                shell_latency_us(result.samples),
+                shell_meter_db(s2, result.gain),
+                result.inverted ? " inverted" : "");
+        } else {
+            printf("%5u %9s\n", t + 1, "-");
+        }
+
+        /* Vary the injection phase against the other clocks */
+        vTaskDelay(pdMS_TO_TICKS(SHELL_LATENCY_GAP_MS + (t * 7) % 11));
+        c = term_getch(&ctx->t, TERM_INPUT_DONT_WAIT);
+        if (c >= 0) {
+            break;
+        }
+    }
+
+    if (stats.found == 0) {
+        printf("Marker not found in %u trials\n", stats.missed);
+        return;
+    }
+
+    latency_stats_get(&stats, &mean, &jitter);
+    printf("Latency min/mean/max: %s/%s/%s samples",
+        shell_latency_samples(s1, stats.min),
+        shell_latency_samples(s2, mean),
+        shell_latency_samples(s3, stats.max));
+    printf(" (%u/%u/%u uS)\n", shell_latency_us(stats.min),
+        shell_latency_us(mean), shell_latency_us(stats.max));
+    printf("Jitter: %s samples std dev (%u uS), %s samples peak to peak\n",
+        shell_latency_samples(s1, jitter), shell_latency_us(jitter),
+        shell_latency_samples(s2, stats.max - stats.min));
+    if (stats.missed) {
+        printf("Missed: %u of %u\n", stats.missed, stats.found + stats.missed);
+    }
+}
+
+/***********************************************************************
+ * CMD: mixer
+ **********************************************************************/
+#include "mixer_control.h"
+
+const char shell_help_mixer[] = "[set <sink>:<ch> <src>:<ch> <dB|off>] [clear] [load <file>] [save <file>]\n"
+  "  set - Set one crosspoint gain (i.e. set codec_out:0 usb_rx:1 -6)\n"
+  "  clear - Remove all crosspoints\n"
+  "  load - Replace the matrix with a matrix file\n"
+  "  save - Save the matrix to a matrix file\n"
+  "  No arguments lists the crosspoints\n"
+  "Matrix file lines are '<sink>:<ch> <src>:<ch> <dB|off>', '#' starts\n"
+  "a comment.  Output channels with crosspoints override the routes\n";
+const char shell_help_summary_mixer[] = "Manages the crosspoint mixer matrix";
+
+static void shell_mixer_list(void)
+{
+    char line[80];
+    unsigned i;
+
+    if ((context->mixerPoints == NULL) || (context->mixerNumPoints == 0)) {
+        printf("No crosspoints\n");
+        return;
+    }
+
+    mixer_sort(context->mixerPoints, context->mixerNumPoints);
+    for (i = 0; i < context->mixerNumPoints; i++) {
+        mixer_format(&context->mixerPoints[i], line, sizeof(line));
+        printf("%s\n", line);
+    }
+    printf("%u crosspoints, %u outputs\n", context->mixerNumPoints,
+        mixer_rows(context->mixerPoints, context->mixerNumPoints));
+}
+
+void shell_mixer(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    MIXER_POINT point;
+    char line[80];
+    unsigned errLine;
+    bool ok;
+
+    if (argc < 2) {
+        shell_mixer_list();
+        return;
+    }
+
+    if ((strcmp(argv[1], "set") == 0) && (argc == 5)) {
+        snprintf(line, sizeof(line), "%s %s %s", argv[2], argv[3], argv[4]);
+        if (mixer_parse(line, &point) != MIXER_PARSE_POINT) {
+            printf("Invalid crosspoint '%s'\n", line);
+            return;
+        }
+        ok = mixer_control_set(context, &point);
+        if (!ok) {
+            printf("Matrix full\n");
+            return;
+        }
+    } else if (strcmp(argv[1], "clear") == 0) {
+        mixer_control_clear(context);
+    } else if ((strcmp(argv[1], "load") == 0) && (argc == 3)) {
+        ok = mixer_control_load(context, argv[2], &errLine);
+        if (!ok) {
+            if (errLine) {
+                printf("%s: error on line %u\n", argv[2], errLine);
+            } else {
+                printf("Unable to read %s\n", argv[2]);
+            }
+            return;
+        }
+    } else if ((strcmp(argv[1], "save") == 0) && (argc == 3)) {
+        ok = mixer_control_save(context, argv[2]);
+        if (!ok) {
+            printf("Unable to write %s\n", argv[2]);
+        }
+        return;
+    } else {
+        printf("Invalid arguments\n");
+        return;
+    }
+
+    ok = mixer_control_commit(context);
+    if (!ok) {
+        printf("Unable to send the matrix\n");
+    }
+}
+
+/***********************************************************************
+ * CMD: scene
+ **********************************************************************/
+#include "scene_control.h"
+
+const char shell_help_scene[] = "[save <file> [blocks]] [load <file>] [recall <file> [blocks]] [drop [file]]\n"
+  "  save - Save the routes and the mixer matrix to a scene file\n"
+  "  load - Preload a scene file\n"
+  "  recall - Switch to a scene, crossfading over 'blocks' blocks\n"
+  "           (default: the scene's own fade, 0 switches at once)\n"
+  "  drop - Forget one or all preloaded scenes\n"
+  "  No arguments lists the preloaded scenes\n";
+const char shell_help_summary_scene[] = "Saves, preloads and recalls routing and mixer scenes";
+
+static void shell_scene_list(void)
+{
+    unsigned numRoutes, numPoints, fadeBlocks;
+    const char *name;
+    unsigned i, n;
+
+    n = 0;
+    for (i = 0; i < SCENE_MAX_LOADED; i++) {
+        if (scene_control_info(i, &name, &numRoutes, &numPoints, &fadeBlocks)) {
+            printf("%s: %u routes, %u crosspoints, %u block fade\n",
+                name, numRoutes, numPoints, fadeBlocks);
+            n++;
+        }
+    }
+    if (n == 0) {
+        printf("No scenes loaded\n");
+    }
+}
+
+void shell_scene(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    unsigned i;
+    int blocks;
+    bool ok;
+
+    if (argc < 2) {
+        shell_scene_list();
+        return;
+    }
+
+    blocks = (argc == 4) ? atoi(argv[3]) : -1;
+    if (blocks > SCENE_FADE_MAX) {
+        printf("Fade must be at most %u blocks\n", (unsigned)SCENE_FADE_MAX);
+        return;
+    }
+
+    if ((strcmp(argv[1], "save") == 0) && ((argc == 3) || (argc == 4))) {
+        ok = scene_control_save(context, argv[2],
+            (blocks < 0) ? SCENE_FADE_BLOCKS : (unsigned)blocks);
+        if (!ok) {
+            printf("Unable to write %s\n", argv[2]);
+        }
+    } else if ((strcmp(argv[1], "load") == 0) && (argc == 3)) {
+        ok = scene_control_load(context, argv[2]);
+        if (!ok) {
+            printf("Unable to load %s\n", argv[2]);
+        }
+    } else if ((strcmp(argv[1], "recall") == 0) && ((argc == 3) || (argc == 4))) {
+        ok = scene_control_recall(context, argv[2], blocks);
+        if (!ok) {
+            printf("Unable to recall %s\n", argv[2]);
+            return;
+        }
+        for (i = 0; (i < 10) && !route_control_applied(context); i++) {
+            delay(10);
+        }
+        if (!route_control_applied(context)) {
+            printf("Scene %s pending\n", argv[2]);
+        }
+    } else if ((strcmp(argv[1], "drop") == 0) && (argc <= 3)) {
+        scene_control_drop(context, (argc == 3) ? argv[2] : NULL);
+    } else {
+        printf("Invalid arguments\n");
+    }
+}
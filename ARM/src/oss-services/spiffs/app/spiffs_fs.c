@@ -10,6 +10,8 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <stddef.h>
 
 #ifdef FREE_RTOS
 #include "FreeRTOS.h"
@@ -17,10 +19,12 @@
 #endif
 
 #include "spiffs.h"
+#include "spiffs_nucleus.h"
 #include "spiffs_fs.h"
 #include "spiffs_fs_cfg.h"
 
 #include "spi_simple.h"
+#include "crc32.h"
 
 #ifndef SPIFFS_FS_CALLOC
 #define SPIFFS_FS_CALLOC calloc
@@ -46,6 +50,76 @@
 #error Must define SPIFFS_FS_FLASH_PAGE_SIZE
 #endif
 
+/*
+ * Mount index
+ *
+ * The object lookup scan results and a table of every file's object
+ * id, object index header page and name hash are kept in RAM and
+ * snapshotted to one of two flash slots outside of the filesystem.
+ * The table is kept current by the SPIFFS file callback.
+ *
+ * A snapshot is live until the first flash write or erase after it
+ * was taken or loaded.  At that point the 'stale' word of every live
+ * slot is programmed to zero, which needs no erase.  Mount uses the
+ * newest slot that is not stale and passes its CRC, otherwise it
+ * falls back to the full scan.  The snapshot also holds a CRC of every
+ * block's magic and erase count so a partition erased or rewritten
+ * behind SPIFFS' back (i.e. by a flash programmer) is not trusted.
+ *
+ * Define SPIFFS_FS_INDEX_OFFSET and SPIFFS_FS_INDEX_SIZE to enable.
+ */
+#if defined(SPIFFS_FS_INDEX_OFFSET) && SPIFFS_MOUNT_INDEX
+#define SPIFFS_FS_INDEX
+
+#ifndef SPIFFS_FS_INDEX_SIZE
+#error Must define SPIFFS_FS_INDEX_SIZE
+#endif
+
+#ifndef SPIFFS_FS_INDEX_FILES
+#define SPIFFS_FS_INDEX_FILES       (256)
+#endif
+
+#define SPIFFS_FS_INDEX_SLOTS       (2)
+#define SPIFFS_FS_INDEX_SLOT_SIZE   (SPIFFS_FS_INDEX_SIZE / SPIFFS_FS_INDEX_SLOTS)
+#define SPIFFS_FS_INDEX_MAGIC       (0x58495353)  /* 'SSIX' */
+#define SPIFFS_FS_INDEX_VERSION     (2)
+#define SPIFFS_FS_INDEX_LIVE        (0xFFFFFFFF)
+
+typedef struct SPIFFS_INDEX_ENTRY {
+    spiffs_obj_id obj_id;
+    spiffs_page_ix pix;
+    u32_t hash;
+} SPIFFS_INDEX_ENTRY;
+
+/* Snapshot slot header, followed by 'files' entries */
+typedef struct SPIFFS_INDEX_HDR {
+    u32_t magic;
+    u32_t stale;
+    u32_t crc;              /* CRC32 of everything after this field */
+    u32_t generation;
+    u32_t version;
+    u32_t phys_addr;
+    u32_t phys_size;
+    u32_t log_block_size;
+    u32_t log_page_size;
+    u32_t free_blocks;
+    u32_t stats_p_allocated;
+    u32_t stats_p_deleted;
+    u32_t max_erase_count;
+    u32_t free_cursor_block_ix;
+    u32_t free_cursor_obj_lu_entry;
+    u32_t complete;
+    u32_t blocks_crc;       /* CRC32 of every block's magic and erase count */
+    u32_t files;
+} SPIFFS_INDEX_HDR;
+
+/* Fails to compile if a slot can't hold SPIFFS_FS_INDEX_FILES */
+typedef char SPIFFS_INDEX_SLOT_CHECK[(SPIFFS_FS_INDEX_SLOT_SIZE >=
+    (sizeof(SPIFFS_INDEX_HDR) +
+     SPIFFS_FS_INDEX_FILES * sizeof(SPIFFS_INDEX_ENTRY))) ? 1 : -1];
+
+#endif
+
 typedef struct SPIFFS_FS {
     FLASH_INFO *fi;
 #ifdef FREE_RTOS
@@ -56,8 +130,27 @@ typedef struct SPIFFS_FS {
     u8_t *spiffs_work_buf;
     u8_t *spiffs_fds;
     u32_t filedescs_size;
+#ifdef SPIFFS_FS_INDEX
+    SPIFFS_INDEX_ENTRY files[SPIFFS_FS_INDEX_FILES];
+    u32_t numFiles;
+    bool complete;          /* Every file is in 'files' */
+    bool mountedFromIndex;
+    bool discarded;         /* No snapshots until remounted */
+    u8_t live;              /* Mask of live snapshot slots */
+    u8_t slot;              /* Slot of the newest snapshot */
+    u32_t generation;
+    u32_t changes;          /* Flash writes and erases since mount */
+    u32_t syncChanges;      /* 'changes' at the last sync */
+    u32_t hits;
+    u32_t misses;
+    u32_t scans;
+#endif
 } SPIFFS_FS;
 
+#ifdef SPIFFS_FS_INDEX
+static void spiffs_index_changed(SPIFFS_FS *FS);
+#endif
+
 static s32_t my_spiffs_read(spiffs *fs, u32_t addr, u32_t size, u8_t *dst) {
     SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
     int ok = flash_read(FS->fi, addr, dst, size);
@@ -66,16 +159,479 @@ static s32_t my_spiffs_read(spiffs *fs, u32_t addr, u32_t size, u8_t *dst) {
 
 static s32_t my_spiffs_write(spiffs *fs, u32_t addr, u32_t size, u8_t *src) {
     SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+#ifdef SPIFFS_FS_INDEX
+    spiffs_index_changed(FS);
+#endif
     int ok = flash_program(FS->fi, addr, src, size);
     return(ok == FLASH_OK ? SPIFFS_OK : -1);
 }
 
 static s32_t my_spiffs_erase(spiffs *fs, u32_t addr, u32_t size) {
     SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+#ifdef SPIFFS_FS_INDEX
+    spiffs_index_changed(FS);
+#endif
     int ok = flash_erase(FS->fi, addr, size);
     return(ok == FLASH_OK ? SPIFFS_OK : -1);
 }
 
+#ifdef SPIFFS_FS_INDEX
+
+/***********************************************************************
+ * Mount index
+ **********************************************************************/
+static u32_t spiffs_index_hash(const u8_t *name)
+{
+    u32_t hash = 5381;
+    int i;
+
+    /* djb2, same as the SPIFFS temporal fd cache */
+    for (i = 0; (i < SPIFFS_OBJ_NAME_LEN) && name[i]; i++) {
+        hash = (hash * 33) ^ name[i];
+    }
+
+    return(hash);
+}
+
+static u32_t spiffs_index_slot_addr(unsigned slot)
+{
+    return(SPIFFS_FS_INDEX_OFFSET + slot * SPIFFS_FS_INDEX_SLOT_SIZE);
+}
+
+/* Reads an object index header and returns true if it is a live file */
+static bool spiffs_index_read_hdr(spiffs *fs, spiffs_page_ix pix,
+    spiffs_page_object_ix_header *objix_hdr)
+{
+    s32_t res;
+
+    res = my_spiffs_read(fs, SPIFFS_PAGE_TO_PADDR(fs, pix),
+        sizeof(*objix_hdr), (u8_t *)objix_hdr);
+    if (res != SPIFFS_OK) {
+        return(false);
+    }
+
+    return((objix_hdr->p_hdr.obj_id & SPIFFS_OBJ_ID_IX_FLAG) &&
+        (objix_hdr->p_hdr.span_ix == 0) &&
+        ((objix_hdr->p_hdr.flags &
+            (SPIFFS_PH_FLAG_DELET | SPIFFS_PH_FLAG_FINAL | SPIFFS_PH_FLAG_IXDELE)) ==
+            (SPIFFS_PH_FLAG_DELET | SPIFFS_PH_FLAG_IXDELE)));
+}
+
+static SPIFFS_INDEX_ENTRY *spiffs_index_entry(SPIFFS_FS *FS, spiffs_obj_id obj_id)
+{
+    u32_t i;
+
+    for (i = 0; i < FS->numFiles; i++) {
+        if (FS->files[i].obj_id == obj_id) {
+            return(&FS->files[i]);
+        }
+    }
+
+    return(NULL);
+}
+
+static void spiffs_index_add(SPIFFS_FS *FS, spiffs_obj_id obj_id,
+    spiffs_page_ix pix, const u8_t *name)
+{
+    SPIFFS_INDEX_ENTRY *entry;
+
+    entry = spiffs_index_entry(FS, obj_id);
+    if (entry == NULL) {
+        if (FS->numFiles == SPIFFS_FS_INDEX_FILES) {
+            FS->complete = false;
+            return;
+        }
+        entry = &FS->files[FS->numFiles++];
+        entry->obj_id = obj_id;
+    }
+    entry->pix = pix;
+    entry->hash = spiffs_index_hash(name);
+}
+
+static void spiffs_index_remove(SPIFFS_FS *FS, spiffs_obj_id obj_id)
+{
+    SPIFFS_INDEX_ENTRY *entry;
+
+    entry = spiffs_index_entry(FS, obj_id);
+    if (entry) {
+        *entry = FS->files[--FS->numFiles];
+    }
+}
+
+/* SPIFFS file callback, keeps the table current.  Called locked. */
+static void spiffs_index_event(spiffs *fs, spiffs_fileop_type op,
+    spiffs_obj_id obj_id, spiffs_page_ix pix)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+    spiffs_page_object_ix_header objix_hdr;
+
+    if (op == SPIFFS_CB_DELETED) {
+        spiffs_index_remove(FS, obj_id);
+    } else if (spiffs_index_read_hdr(fs, pix, &objix_hdr)) {
+        spiffs_index_add(FS, obj_id, pix, objix_hdr.name);
+    } else {
+        spiffs_index_remove(FS, obj_id);
+        FS->complete = false;
+    }
+}
+
+/* SPIFFS name lookup hook.  Called locked. */
+static s32_t spiffs_index_find(spiffs *fs, const u8_t *name, spiffs_page_ix *pix)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+    spiffs_page_object_ix_header objix_hdr;
+    SPIFFS_INDEX_ENTRY *entry;
+    u32_t hash;
+    u32_t i;
+
+    hash = spiffs_index_hash(name);
+
+    for (i = 0; i < FS->numFiles; i++) {
+        entry = &FS->files[i];
+        if (entry->hash != hash) {
+            continue;
+        }
+        if (!spiffs_index_read_hdr(fs, entry->pix, &objix_hdr) ||
+            ((objix_hdr.p_hdr.obj_id & ~SPIFFS_OBJ_ID_IX_FLAG) != entry->obj_id)) {
+            /* Out of sync, stop trusting misses until rebuilt */
+            FS->complete = false;
+            continue;
+        }
+        if (strcmp((const char *)name, (const char *)objix_hdr.name) == 0) {
+            *pix = entry->pix;
+            FS->hits++;
+            return(SPIFFS_OK);
+        }
+    }
+
+    if (FS->complete) {
+        FS->misses++;
+        return(SPIFFS_ERR_NOT_FOUND);
+    }
+
+    FS->scans++;
+    return(SPIFFS_VIS_COUNTINUE);
+}
+
+static s32_t spiffs_index_build_v(spiffs *fs, spiffs_obj_id obj_id,
+    spiffs_block_ix bix, int ix_entry, const void *user_const_p,
+    void *user_var_p)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+    spiffs_page_object_ix_header objix_hdr;
+    spiffs_page_ix pix;
+
+    if ((obj_id == SPIFFS_OBJ_ID_FREE) || (obj_id == SPIFFS_OBJ_ID_DELETED) ||
+        ((obj_id & SPIFFS_OBJ_ID_IX_FLAG) == 0)) {
+        return(SPIFFS_VIS_COUNTINUE);
+    }
+
+    pix = SPIFFS_OBJ_LOOKUP_ENTRY_TO_PIX(fs, bix, ix_entry);
+    if (spiffs_index_read_hdr(fs, pix, &objix_hdr)) {
+        if (FS->numFiles == SPIFFS_FS_INDEX_FILES) {
+            return(SPIFFS_OK);
+        }
+        spiffs_index_add(FS, obj_id & ~SPIFFS_OBJ_ID_IX_FLAG, pix,
+            objix_hdr.name);
+    }
+
+    return(SPIFFS_VIS_COUNTINUE);
+}
+
+/* Rebuilds the table with one scan.  Called locked. */
+static s32_t spiffs_index_build(spiffs *fs)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+    spiffs_block_ix bix;
+    int entry;
+    s32_t res;
+
+    FS->numFiles = 0;
+    FS->complete = false;
+
+    res = spiffs_obj_lu_find_entry_visitor(fs, 0, 0, 0, 0,
+        spiffs_index_build_v, 0, 0, &bix, &entry);
+    if (res == SPIFFS_VIS_END) {
+        FS->complete = true;
+        res = SPIFFS_OK;
+    }
+
+    return(res);
+}
+
+/* Marks every live snapshot stale ahead of a flash change */
+static void spiffs_index_changed(SPIFFS_FS *FS)
+{
+    u32_t stale = 0;
+    unsigned slot;
+
+    FS->changes++;
+    if (FS->live) {
+        for (slot = 0; slot < SPIFFS_FS_INDEX_SLOTS; slot++) {
+            if (FS->live & (1 << slot)) {
+                flash_program(FS->fi, spiffs_index_slot_addr(slot) +
+                    offsetof(SPIFFS_INDEX_HDR, stale),
+                    (const uint8_t *)&stale, sizeof(stale));
+            }
+        }
+        FS->live = 0;
+    }
+}
+
+static u32_t spiffs_index_crc(const SPIFFS_INDEX_HDR *hdr,
+    const SPIFFS_INDEX_ENTRY *files)
+{
+    u32_t crc;
+
+    crc = crc32_x(&hdr->generation,
+        sizeof(*hdr) - offsetof(SPIFFS_INDEX_HDR, generation), 0);
+    crc = crc32_x(files, hdr->files * sizeof(*files), crc);
+
+    return(crc);
+}
+
+/* CRC32 of the magic and erase count words at the end of each block's
+ * object lookup pages.  Any erase or reformat changes them.
+ */
+static bool spiffs_index_blocks_crc(spiffs *fs, u32_t *crc)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+    spiffs_obj_id words[2];
+    spiffs_block_ix bix;
+    int ok;
+
+    *crc = 0;
+    for (bix = 0; bix < fs->block_count; bix++) {
+        ok = flash_read(FS->fi, SPIFFS_MAGIC_PADDR(fs, bix),
+            (uint8_t *)words, sizeof(words));
+        if (ok != FLASH_OK) {
+            return(false);
+        }
+        *crc = crc32_x(words, sizeof(words), *crc);
+    }
+
+    return(true);
+}
+
+static bool spiffs_index_geometry(spiffs *fs, const SPIFFS_INDEX_HDR *hdr)
+{
+    return((hdr->magic == SPIFFS_FS_INDEX_MAGIC) &&
+        (hdr->version == SPIFFS_FS_INDEX_VERSION) &&
+        (hdr->phys_addr == SPIFFS_CFG_PHYS_ADDR(fs)) &&
+        (hdr->phys_size == SPIFFS_CFG_PHYS_SZ(fs)) &&
+        (hdr->log_block_size == SPIFFS_CFG_LOG_BLOCK_SZ(fs)) &&
+        (hdr->log_page_size == SPIFFS_CFG_LOG_PAGE_SZ(fs)) &&
+        (hdr->files <= SPIFFS_FS_INDEX_FILES));
+}
+
+/* SPIFFS mount hook, replaces the object lookup scan.  Called locked. */
+static s32_t spiffs_index_load(spiffs *fs)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+    SPIFFS_INDEX_HDR hdr[SPIFFS_FS_INDEX_SLOTS];
+    unsigned slot, newest;
+    u32_t blocksCrc;
+    bool found;
+    int ok;
+
+    /* Find the newest snapshot and every slot that might be live */
+    found = false;
+    newest = 0;
+    for (slot = 0; slot < SPIFFS_FS_INDEX_SLOTS; slot++) {
+        ok = flash_read(FS->fi, spiffs_index_slot_addr(slot),
+            (uint8_t *)&hdr[slot], sizeof(hdr[slot]));
+        if ((ok != FLASH_OK) || !spiffs_index_geometry(fs, &hdr[slot])) {
+            continue;
+        }
+        if (hdr[slot].stale == SPIFFS_FS_INDEX_LIVE) {
+            FS->live |= (1 << slot);
+        }
+        if (!found || ((s32_t)(hdr[slot].generation - FS->generation) > 0)) {
+            FS->generation = hdr[slot].generation;
+            newest = slot;
+            found = true;
+        }
+    }
+    FS->slot = newest;
+
+    if (!found || (hdr[newest].stale != SPIFFS_FS_INDEX_LIVE)) {
+        return(SPIFFS_ERR_NOT_FOUND);
+    }
+
+    ok = flash_read(FS->fi, spiffs_index_slot_addr(newest) + sizeof(hdr[newest]),
+        (uint8_t *)FS->files, hdr[newest].files * sizeof(FS->files[0]));
+    if ((ok != FLASH_OK) ||
+        (spiffs_index_crc(&hdr[newest], FS->files) != hdr[newest].crc)) {
+        return(SPIFFS_ERR_NOT_FOUND);
+    }
+
+    /* The snapshot must belong to what is on the partition now */
+    if (!spiffs_index_blocks_crc(fs, &blocksCrc) ||
+        (blocksCrc != hdr[newest].blocks_crc)) {
+        return(SPIFFS_ERR_NOT_FOUND);
+    }
+
+    FS->numFiles = hdr[newest].files;
+    FS->complete = hdr[newest].complete;
+    FS->mountedFromIndex = true;
+
+    fs->free_blocks = hdr[newest].free_blocks;
+    fs->stats_p_allocated = hdr[newest].stats_p_allocated;
+    fs->stats_p_deleted = hdr[newest].stats_p_deleted;
+    fs->max_erase_count = hdr[newest].max_erase_count;
+    fs->free_cursor_block_ix = hdr[newest].free_cursor_block_ix;
+    fs->free_cursor_obj_lu_entry = hdr[newest].free_cursor_obj_lu_entry;
+
+    return(SPIFFS_OK);
+}
+
+/* Writes a new snapshot if the filesystem changed.  Called locked. */
+static s32_t spiffs_index_write(spiffs *fs)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+    SPIFFS_INDEX_HDR hdr;
+    unsigned slot;
+    u32_t addr;
+    int ok;
+
+    if (!SPIFFS_mounted(fs)) {
+        return(SPIFFS_ERR_NOT_MOUNTED);
+    }
+
+    if (FS->discarded) {
+        return(SPIFFS_OK);
+    }
+
+    /* Nothing changed since the last snapshot */
+    if (FS->live) {
+        return(SPIFFS_OK);
+    }
+
+    if (!FS->complete) {
+        spiffs_index_build(fs);
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    if (!spiffs_index_blocks_crc(fs, &hdr.blocks_crc)) {
+        return(SPIFFS_ERR_INTERNAL);
+    }
+    hdr.magic = SPIFFS_FS_INDEX_MAGIC;
+    hdr.stale = SPIFFS_FS_INDEX_LIVE;
+    hdr.generation = FS->generation + 1;
+    hdr.version = SPIFFS_FS_INDEX_VERSION;
+    hdr.phys_addr = SPIFFS_CFG_PHYS_ADDR(fs);
+    hdr.phys_size = SPIFFS_CFG_PHYS_SZ(fs);
+    hdr.log_block_size = SPIFFS_CFG_LOG_BLOCK_SZ(fs);
+    hdr.log_page_size = SPIFFS_CFG_LOG_PAGE_SZ(fs);
+    hdr.free_blocks = fs->free_blocks;
+    hdr.stats_p_allocated = fs->stats_p_allocated;
+    hdr.stats_p_deleted = fs->stats_p_deleted;
+    hdr.max_erase_count = fs->max_erase_count;
+    hdr.free_cursor_block_ix = fs->free_cursor_block_ix;
+    hdr.free_cursor_obj_lu_entry = fs->free_cursor_obj_lu_entry;
+    hdr.complete = FS->complete;
+    hdr.files = FS->numFiles;
+    hdr.crc = spiffs_index_crc(&hdr, FS->files);
+
+    /* Alternate slots so the previous snapshot survives a torn write */
+    slot = (FS->slot + 1) % SPIFFS_FS_INDEX_SLOTS;
+    addr = spiffs_index_slot_addr(slot);
+
+    ok = flash_erase(FS->fi, addr, SPIFFS_FS_INDEX_SLOT_SIZE);
+    if ((ok == FLASH_OK) && hdr.files) {
+        ok = flash_program(FS->fi, addr + sizeof(hdr),
+            (const uint8_t *)FS->files, hdr.files * sizeof(FS->files[0]));
+    }
+    if (ok == FLASH_OK) {
+        ok = flash_program(FS->fi, addr, (const uint8_t *)&hdr, sizeof(hdr));
+    }
+    if (ok != FLASH_OK) {
+        return(SPIFFS_ERR_INTERNAL);
+    }
+
+    FS->generation = hdr.generation;
+    FS->slot = slot;
+    FS->live = (1 << slot);
+
+    return(SPIFFS_OK);
+}
+
+s32_t spiffs_index_save(spiffs *fs)
+{
+    s32_t res;
+
+    spiffs_lock(fs);
+    res = spiffs_index_write(fs);
+    spiffs_unlock(fs);
+
+    return(res);
+}
+
+s32_t spiffs_index_sync(spiffs *fs)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+    bool quiet;
+
+    /* Wait for the filesystem to settle before taking a snapshot */
+    quiet = (FS->changes == FS->syncChanges);
+    FS->syncChanges = FS->changes;
+    if (!quiet) {
+        return(SPIFFS_OK);
+    }
+
+    return(spiffs_index_save(fs));
+}
+
+void spiffs_index_discard(spiffs *fs)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+
+    spiffs_lock(fs);
+    flash_erase(FS->fi, SPIFFS_FS_INDEX_OFFSET, SPIFFS_FS_INDEX_SIZE);
+    FS->live = 0;
+    FS->discarded = true;
+    spiffs_unlock(fs);
+}
+
+void spiffs_index_info(spiffs *fs, SPIFFS_INDEX_INFO *info)
+{
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+
+    spiffs_lock(fs);
+    info->mounted = FS->mountedFromIndex;
+    info->live = (FS->live != 0);
+    info->complete = FS->complete;
+    info->files = FS->numFiles;
+    info->generation = FS->generation;
+    info->hits = FS->hits;
+    info->misses = FS->misses;
+    info->scans = FS->scans;
+    spiffs_unlock(fs);
+}
+
+#else
+
+s32_t spiffs_index_save(spiffs *fs)
+{
+    return(SPIFFS_OK);
+}
+
+s32_t spiffs_index_sync(spiffs *fs)
+{
+    return(SPIFFS_OK);
+}
+
+void spiffs_index_discard(spiffs *fs)
+{
+}
+
+void spiffs_index_info(spiffs *fs, SPIFFS_INDEX_INFO *info)
+{
+    memset(info, 0, sizeof(*info));
+}
+
+#endif
+
 void spiffs_lock(spiffs *fs)
 {
 #ifdef FREE_RTOS
@@ -117,6 +673,7 @@ s32_t spiffs_mount(spiffs *fs, FLASH_INFO *fi)
     FS->fi = fi;
     fs->user_data = FS;
 
+    memset(&cfg, 0, sizeof(cfg));
     cfg.phys_size = SPIFFS_FS_SIZE;
     cfg.phys_addr = SPIFFS_FS_OFFSET;
     cfg.phys_erase_block = SPIFFS_FS_ERASE_BLOCK_SIZE;
@@ -126,6 +683,10 @@ s32_t spiffs_mount(spiffs *fs, FLASH_INFO *fi)
     cfg.hal_read_f = my_spiffs_read;
     cfg.hal_write_f = my_spiffs_write;
     cfg.hal_erase_f = my_spiffs_erase;
+#ifdef SPIFFS_FS_INDEX
+    cfg.index_load_f = spiffs_index_load;
+    cfg.index_find_f = spiffs_index_find;
+#endif
 
     int res = SPIFFS_mount(fs,
         &cfg,
@@ -137,6 +698,12 @@ s32_t spiffs_mount(spiffs *fs, FLASH_INFO *fi)
         0
     );
 
+#ifdef SPIFFS_FS_INDEX
+    if (res == SPIFFS_OK) {
+        SPIFFS_set_file_callback_func(fs, spiffs_index_event);
+    }
+#endif
+
     return(res);
 }
 
@@ -145,6 +712,7 @@ void spiffs_unmount(spiffs *fs, FLASH_INFO **fi)
     SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
 
     if (SPIFFS_mounted(fs)) {
+        spiffs_index_save(fs);
         SPIFFS_unmount(fs);
     }
 
@@ -171,6 +739,26 @@ void spiffs_unmount(spiffs *fs, FLASH_INFO **fi)
     SPIFFS_FS_FREE(FS);
 }
 
+s32_t spiffs_check(spiffs *fs)
+{
+#ifdef SPIFFS_FS_INDEX
+    SPIFFS_FS *FS = (SPIFFS_FS *)fs->user_data;
+#endif
+    s32_t res;
+
+    res = SPIFFS_check(fs);
+
+#ifdef SPIFFS_FS_INDEX
+    /* Repairs bypass the file callback so rebuild the table */
+    spiffs_lock(fs);
+    FS->numFiles = 0;
+    FS->complete = false;
+    spiffs_unlock(fs);
+#endif
+
+    return(res);
+}
+
 s32_t spiffs_format(spiffs *fs)
 {
     FLASH_INFO *fi;
@@ -15,8 +15,38 @@
 #include "spiffs.h"
 #include "flash.h"
 
+#include <stdbool.h>
+
+/* Mount index status, see spiffs_index_info() */
+typedef struct SPIFFS_INDEX_INFO {
+    bool mounted;           /* Last mount used the snapshot */
+    bool live;              /* Flash snapshot matches the filesystem */
+    bool complete;          /* Every file is indexed */
+    u32_t files;
+    u32_t generation;
+    u32_t hits;             /* Name lookups found in the index */
+    u32_t misses;           /* Name lookups known not to exist */
+    u32_t scans;            /* Name lookups that needed a scan */
+} SPIFFS_INDEX_INFO;
+
 s32_t spiffs_mount(spiffs *fs, FLASH_INFO *f);
+void spiffs_unmount(spiffs *fs, FLASH_INFO **fi);
 s32_t spiffs_format(spiffs *fs);
+s32_t spiffs_check(spiffs *fs);
+
+/*
+ * Mount index snapshot.  spiffs_index_save() writes a snapshot if the
+ * filesystem changed since the last one.  spiffs_index_sync() is meant
+ * to be called periodically and only saves once no flash changes
+ * happened since the previous call.  spiffs_index_discard() erases
+ * the snapshot and stops saving until the next mount, for when the
+ * filesystem area is rewritten behind SPIFFS' back.  All are no-ops
+ * when the index is not configured.
+ */
+s32_t spiffs_index_save(spiffs *fs);
+s32_t spiffs_index_sync(spiffs *fs);
+void spiffs_index_discard(spiffs *fs);
+void spiffs_index_info(spiffs *fs, SPIFFS_INDEX_INFO *info);
 
 void spiffs_lock(spiffs *fs);
 void spiffs_unlock(spiffs *fs);
@@ -45,6 +45,7 @@ extern void spiffs_unlock(struct spiffs_t *fs);
 #define SPIFFS_USE_MAGIC_LENGTH         (1)
 #define SPIFFS_HAL_CALLBACK_EXTRA       (1)
 #define SPIFFS_CACHE                    (0)
+#define SPIFFS_MOUNT_INDEX              (1)
 
 #define SPIFFS_LOCK(fs)       spiffs_lock(fs)
 #define SPIFFS_UNLOCK(fs)     spiffs_unlock(fs)
@@ -236,6 +237,14 @@ typedef u32_t spiffs_span_ix;
 #endif
 #endif
 
+// Enable this to allow an external index to replace the object lookup
+// scan on mount and the name lookup scan on open. See index_load_f and
+// index_find_f in spiffs_config.
+// Added for SHARC Reusable Component
+#ifndef SPIFFS_MOUNT_INDEX
+#define SPIFFS_MOUNT_INDEX              (0)
+#endif
+
 // SPIFFS_LOCK and SPIFFS_UNLOCK protects spiffs from reentrancy on api level
 // These should be defined on a multithreaded system
 
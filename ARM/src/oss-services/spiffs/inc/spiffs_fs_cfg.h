@@ -21,6 +21,8 @@
 #define SPIFFS_FS_OFFSET            SPIFFS_OFFSET
 #define SPIFFS_FS_ERASE_BLOCK_SIZE  ERASE_BLOCK_SIZE
 #define SPIFFS_FS_FLASH_PAGE_SIZE   FLASH_PAGE_SIZE
+#define SPIFFS_FS_INDEX_OFFSET      SPIFFS_INDEX_OFFSET
+#define SPIFFS_FS_INDEX_SIZE        SPIFFS_INDEX_SIZE
 
 
 #endif
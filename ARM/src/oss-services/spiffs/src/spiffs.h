@@ -138,6 +138,18 @@ typedef enum {
 /* file system listener callback function */
 typedef void (*spiffs_file_callback)(struct spiffs_t *fs, spiffs_fileop_type op, spiffs_obj_id obj_id, spiffs_page_ix pix);
 
+#if SPIFFS_MOUNT_INDEX
+/* mount index load function, restores the object lookup scan results
+ * (free_blocks, stats_p_allocated, stats_p_deleted, max_erase_count).
+ * Returns SPIFFS_OK to skip the scan. */
+typedef s32_t (*spiffs_index_load_callback)(struct spiffs_t *fs);
+/* mount index name lookup function. Returns SPIFFS_OK and the object
+ * index header page if found, SPIFFS_ERR_NOT_FOUND if known not to
+ * exist, or any other value to fall back to a scan. */
+typedef s32_t (*spiffs_index_find_callback)(struct spiffs_t *fs, const u8_t *name,
+    spiffs_page_ix *pix);
+#endif
+
 #ifndef SPIFFS_DBG
 #define SPIFFS_DBG(...) \
     printf(__VA_ARGS__)
@@ -226,6 +238,12 @@ typedef struct {
   // an integer offset added to each file handle
   u16_t fh_ix_offset;
 #endif
+#if SPIFFS_MOUNT_INDEX
+  // optional mount index load function, may be NULL
+  spiffs_index_load_callback index_load_f;
+  // optional mount index name lookup function, may be NULL
+  spiffs_index_find_callback index_find_f;
+#endif
 } spiffs_config;
 
 typedef struct spiffs_t {
@@ -129,7 +129,17 @@ s32_t SPIFFS_mount(spiffs *fs, spiffs_config *config, u8_t *work,
 
   fs->config_magic = SPIFFS_CONFIG_MAGIC;
 
+#if SPIFFS_MOUNT_INDEX
+  res = SPIFFS_ERR_NOT_FOUND;
+  if (fs->cfg.index_load_f) {
+    res = fs->cfg.index_load_f(fs);
+  }
+  if (res != SPIFFS_OK) {
+    res = spiffs_obj_lu_scan(fs);
+  }
+#else
   res = spiffs_obj_lu_scan(fs);
+#endif
   SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
 
   SPIFFS_DBG("page index byte len:         "_SPIPRIi"\n", (u32_t)SPIFFS_CFG_LOG_PAGE_SZ(fs));
@@ -1682,6 +1682,19 @@ s32_t spiffs_object_find_object_index_header_by_name(
   spiffs_block_ix bix;
   int entry;
 
+#if SPIFFS_MOUNT_INDEX
+  if (fs->cfg.index_find_f) {
+    spiffs_page_ix index_pix;
+    res = fs->cfg.index_find_f(fs, name, &index_pix);
+    if (res == SPIFFS_OK && pix) {
+      *pix = index_pix;
+    }
+    if (res == SPIFFS_OK || res == SPIFFS_ERR_NOT_FOUND) {
+      return res;
+    }
+  }
+#endif
+
   res = spiffs_obj_lu_find_entry_visitor(fs,
       fs->cursor_block_ix,
       fs->cursor_obj_lu_entry,
@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 
 
 #include "umm_malloc.h"
@@ -41,6 +42,19 @@
 
 /* ------------------------------------------------------------------------- */
 
+#ifdef FREE_RTOS
+SemaphoreHandle_t umm_heap_locks[UMM_NUM_HEAPS];
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef UMM_TLSF
+
+#include <stdint.h>
+#include "umm_tlsf.c_"
+
+#else
+
 UMM_H_ATTPACKPRE typedef struct umm_ptr_t {
   unsigned int next;
   unsigned int prev;
@@ -59,9 +73,6 @@ UMM_H_ATTPACKPRE typedef struct umm_block_t {
 
 /* ------------------------------------------------------------------------- */
 
-#ifdef FREE_RTOS
-SemaphoreHandle_t umm_heap_locks[UMM_NUM_HEAPS];
-#endif
 umm_block *umm_heaps[UMM_NUM_HEAPS];
 unsigned umm_heap_blocks[UMM_NUM_HEAPS];
 
@@ -651,6 +662,25 @@ void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t item_size ) {
 
 /* ------------------------------------------------------------------------ */
 
+/*
+ * The block allocator only supports the compile time UMM_INTEGRITY_CHECK
+ * and UMM_POISON_CHECK options.  The runtime setting is kept so callers
+ * see what they set.
+ */
+static unsigned int umm_heap_checks[UMM_NUM_HEAPS];
+
+void umm_set_checks( umm_heap_t heap, unsigned int checks ) {
+  umm_heap_checks[heap] = checks;
+}
+
+unsigned int umm_get_checks( umm_heap_t heap ) {
+  return( umm_heap_checks[heap] );
+}
+
+#endif /* UMM_TLSF */
+
+/* ------------------------------------------------------------------------ */
+
 void umm_free( void *ptr ) {
   umm_free_heap( UMM_DEFAULT_HEAP, ptr );
 }
@@ -679,7 +709,7 @@ void *umm_malloc_heap_aligned(umm_heap_t heap, size_t size, size_t alignment)
 {
     void *buf;
     ALIGNED *aligned;
-    unsigned ptr;
+    uintptr_t ptr;
 
     size = ((size - 1)/alignment + 1) * alignment;
 
@@ -688,7 +718,7 @@ void *umm_malloc_heap_aligned(umm_heap_t heap, size_t size, size_t alignment)
         return(buf);
     }
 
-    ptr = (unsigned)buf;
+    ptr = (uintptr_t)buf;
     ptr = ((ptr + alignment) & ~(alignment - 1));
 
     aligned = (ALIGNED *)(ptr - sizeof(ALIGNED));
@@ -705,7 +735,7 @@ void *umm_malloc_aligned( size_t size, size_t alignment )
 void umm_free_heap_aligned( umm_heap_t heap, void *ptr )
 {
     ALIGNED *aligned;
-    aligned = (ALIGNED *)((unsigned)ptr - sizeof(ALIGNED));
+    aligned = (ALIGNED *)((uintptr_t)ptr - sizeof(ALIGNED));
     umm_free_heap(heap, aligned->basePtr);
 }
 
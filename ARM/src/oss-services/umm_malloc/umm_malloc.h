@@ -24,6 +24,16 @@ typedef struct ALIGNED {
 } ALIGNED;
 
 
+/*
+ * Runtime heap checks (see umm_set_checks()).
+ *
+ * UMM_CHECK_INTEGRITY validates the heap before every operation.
+ * UMM_CHECK_POISON guards new allocations with poison bytes which are
+ * verified when the allocation is freed.
+ */
+#define UMM_CHECK_INTEGRITY  (1 << 0)
+#define UMM_CHECK_POISON     (1 << 1)
+
 /* ------------------------------------------------------------------------ */
 
 void  umm_init( umm_heap_t HEAP_TYPE, void *addr, unsigned int size );
@@ -44,6 +54,9 @@ void *umm_malloc_heap_aligned( umm_heap_t heap, size_t size, size_t alignment );
 void  umm_free_aligned( void *ptr );
 void  umm_free_heap_aligned( umm_heap_t heap, void *ptr );
 
+void  umm_set_checks( umm_heap_t heap, unsigned int checks );
+unsigned int umm_get_checks( umm_heap_t heap );
+
 
 /* ------------------------------------------------------------------------ */
 
@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Read-copy-update of the SHARC0 routing table.  Tables are never
+ * edited after they are sent.  A change is made to a copy which is
+ * published as a whole, so SHARC0 routes every block with either the
+ * old or the new table and never a mix of both.  The ARM and SHARC0
+ * each hold a reference to the tables they use, so a replaced table
+ * is reclaimed by whichever lets go of it last.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "context.h"
+#include "route_control.h"
+#include "ipc.h"
+#include "sae.h"
+
+IPC_MSG_ROUTING *route_control_begin(APP_CONTEXT *context, bool clear)
+{
+    SAE_CONTEXT *saeContext = context->saeContext;
+    unsigned msgSize;
+    IPC_MSG *msg;
+
+    route_control_abort(context);
+
+    msgSize = sizeof(*msg) + (MAX_AUDIO_ROUTES - 1) * sizeof(ROUTE_INFO);
+    context->routingNextMsgBuffer = sae_createMsgBuffer(saeContext,
+        msgSize, SAE_ALLOC_FAST, (void **)&msg);
+    if (context->routingNextMsgBuffer == NULL) {
+        return(NULL);
+    }
+    context->routingNextMsg = msg;
+
+    memset(msg, 0, msgSize);
+    msg->type = IPC_TYPE_AUDIO_ROUTING;
+    if (clear || (context->routing == NULL)) {
+        msg->routes.numRoutes = MAX_AUDIO_ROUTES;
+    } else {
+        memcpy(&msg->routes, context->routing, ROUTE_CONTROL_TABLE_SIZE);
+    }
+    msg->routes.ack = 0;
+
+    return(&msg->routes);
+}
+
+void route_control_abort(APP_CONTEXT *context)
+{
+    if (context->routingNextMsgBuffer) {
+        sae_unRefMsgBuffer(context->saeContext, context->routingNextMsgBuffer);
+        context->routingNextMsgBuffer = NULL;
+        context->routingNextMsg = NULL;
+    }
+}
+
+bool route_control_publish(APP_CONTEXT *context)
+{
+    SAE_MSG_BUFFER *msgBuffer;
+    bool ok;
+
+    msgBuffer = context->routingNextMsgBuffer;
+    if (msgBuffer == NULL) {
+        return(false);
+    }
+    context->routingNextMsgBuffer = NULL;
+    context->routingNextMsg = NULL;
+
+    ok = route_control_publish_msg(context, msgBuffer);
+    sae_unRefMsgBuffer(context->saeContext, msgBuffer);
+
+    return(ok);
+}
+
+bool route_control_publish_msg(APP_CONTEXT *context, SAE_MSG_BUFFER *msgBuffer)
+{
+    SAE_CONTEXT *saeContext = context->saeContext;
+    IPC_MSG_ROUTING *routes;
+    SAE_RESULT result;
+    IPC_MSG *msg;
+
+    msg = sae_getMsgBufferPayload(msgBuffer);
+    if (msg->type == IPC_TYPE_AUDIO_ROUTING) {
+        routes = &msg->routes;
+    } else if (msg->type == IPC_TYPE_SCENE) {
+        routes = &msg->scene.routes;
+    } else {
+        return(false);
+    }
+
+    routes->generation = context->routing ?
+        context->routing->generation + 1 : 1;
+    routes->ack = 0;
+
+    /* One reference for the ARM and one for the send to SHARC0 */
+    sae_refMsgBuffer(saeContext, msgBuffer);
+    sae_refMsgBuffer(saeContext, msgBuffer);
+    result = sae_sendMsgBuffer(saeContext, msgBuffer, IPC_CORE_SHARC0, true);
+    if (result != SAE_RESULT_OK) {
+        sae_unRefMsgBuffer(saeContext, msgBuffer);
+        sae_unRefMsgBuffer(saeContext, msgBuffer);
+        return(false);
+    }
+
+    if (context->routingMsgBuffer) {
+        sae_unRefMsgBuffer(saeContext, context->routingMsgBuffer);
+    }
+    context->routingMsgBuffer = msgBuffer;
+    context->routing = routes;
+
+    return(true);
+}
+
+bool route_control_applied(APP_CONTEXT *context)
+{
+    IPC_MSG_ROUTING *routes = context->routing;
+
+    if (routes == NULL) {
+        return(false);
+    }
+
+    return(routes->ack == routes->generation);
+}
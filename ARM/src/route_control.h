@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _route_control_h
+#define _route_control_h
+
+#include <stdbool.h>
+
+#include "context.h"
+#include "ipc.h"
+#include "sae.h"
+
+/* Bytes of a full IPC_MSG_ROUTING table */
+#define ROUTE_CONTROL_TABLE_SIZE \
+    (sizeof(IPC_MSG_ROUTING) + (MAX_AUDIO_ROUTES - 1) * sizeof(ROUTE_INFO))
+
+/*
+ * Start the next routing table as a copy of the published one, or
+ * empty if 'clear' is set.  Edit the returned table freely, SHARC0
+ * does not see it until route_control_publish().  Returns NULL if
+ * out of memory.
+ */
+IPC_MSG_ROUTING *route_control_begin(APP_CONTEXT *context, bool clear);
+
+/* Throw away the next routing table */
+void route_control_abort(APP_CONTEXT *context);
+
+/*
+ * Send the next routing table to SHARC0, which switches to it between
+ * two blocks.  The table becomes the published one and must not be
+ * modified anymore.
+ */
+bool route_control_publish(APP_CONTEXT *context);
+
+/*
+ * Publish the table of a routing or scene message built elsewhere.
+ * The table must hold MAX_AUDIO_ROUTES entries.  The caller keeps its
+ * own reference to the message.
+ */
+bool route_control_publish_msg(APP_CONTEXT *context, SAE_MSG_BUFFER *msgBuffer);
+
+/* Returns true once SHARC0 routes with the published table */
+bool route_control_applied(APP_CONTEXT *context);
+
+#endif
@@ -0,0 +1,316 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Scene files are parsed and built into IPC_TYPE_SCENE messages when
+ * they are loaded, so a recall is just a send no matter how many
+ * routes and crosspoints it changes.  A loaded scene's message is
+ * never modified except for the 'fadeBlocks', 'generation' and 'ack'
+ * fields, which SHARC0 only looks at when it switches to it.  The
+ * slot keeps the scene's own fade so a one-off override does not
+ * stick.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "context.h"
+#include "umm_malloc.h"
+#include "scene_control.h"
+#include "route_control.h"
+#include "mixer_control.h"
+#include "scene.h"
+#include "mixer.h"
+#include "ipc.h"
+#include "sae.h"
+
+typedef struct _SCENE_SLOT {
+    char name[SCENE_NAME_LEN];
+    SAE_MSG_BUFFER *msgBuffer;
+    MIXER_POINT *points;
+    unsigned numPoints;
+    unsigned numRoutes;
+    unsigned fadeBlocks;
+} SCENE_SLOT;
+
+static SCENE_SLOT sceneSlot[SCENE_MAX_LOADED];
+
+/* The matrix follows a full routing table, word aligned */
+#define SCENE_MATRIX_OFFSET \
+    ((offsetof(IPC_MSG, scene.routes.routes) + \
+      MAX_AUDIO_ROUTES * sizeof(ROUTE_INFO) + 3) & ~3u)
+
+static SCENE_SLOT *sceneFind(const char *fname)
+{
+    unsigned i;
+
+    for (i = 0; i < SCENE_MAX_LOADED; i++) {
+        if (sceneSlot[i].msgBuffer &&
+            (strcmp(sceneSlot[i].name, fname) == 0)) {
+            return(&sceneSlot[i]);
+        }
+    }
+    return(NULL);
+}
+
+static void sceneRelease(APP_CONTEXT *context, SCENE_SLOT *slot)
+{
+    if (slot->msgBuffer) {
+        sae_unRefMsgBuffer(context->saeContext, slot->msgBuffer);
+        slot->msgBuffer = NULL;
+    }
+    if (slot->points) {
+        umm_free(slot->points);
+        slot->points = NULL;
+    }
+    slot->name[0] = '\0';
+}
+
+static bool sceneRead(FILE *f, SCENE_HEADER *hdr, SCENE_ROUTE *routes,
+    MIXER_POINT **points)
+{
+    MIXER_POINT *p;
+    unsigned i;
+
+    if (fread(hdr, sizeof(*hdr), 1, f) != 1) {
+        return(false);
+    }
+    if ((hdr->magic != SCENE_MAGIC) || (hdr->version != SCENE_VERSION) ||
+        (hdr->numRoutes > MAX_AUDIO_ROUTES) ||
+        (hdr->numPoints > MIXER_MAX_POINTS)) {
+        return(false);
+    }
+
+    if (fread(routes, sizeof(*routes), hdr->numRoutes, f) != hdr->numRoutes) {
+        return(false);
+    }
+    for (i = 0; i < hdr->numRoutes; i++) {
+        if ((routes[i].index >= MAX_AUDIO_ROUTES) ||
+            (routes[i].route.srcID >= IPC_STREAM_ID_MAX) ||
+            (routes[i].route.sinkID >= IPC_STREAM_ID_MAX)) {
+            return(false);
+        }
+    }
+
+    /* Always allocate something so an empty matrix is not an error */
+    p = (MIXER_POINT *)umm_malloc((hdr->numPoints + 1) * sizeof(*p));
+    if (p == NULL) {
+        return(false);
+    }
+    if (fread(p, sizeof(*p), hdr->numPoints, f) != hdr->numPoints) {
+        umm_free(p);
+        return(false);
+    }
+    for (i = 0; i < hdr->numPoints; i++) {
+        if ((p[i].sinkID >= IPC_STREAM_ID_MAX) ||
+            (p[i].srcID >= IPC_STREAM_ID_MAX)) {
+            umm_free(p);
+            return(false);
+        }
+    }
+    *points = p;
+
+    return(true);
+}
+
+bool scene_control_save(APP_CONTEXT *context, const char *fname,
+    unsigned fadeBlocks)
+{
+    IPC_MSG_ROUTING *routing = context->routing;
+    SCENE_HEADER hdr;
+    SCENE_ROUTE route;
+    unsigned numPoints;
+    unsigned i;
+    bool ok;
+    FILE *f;
+
+    if (fadeBlocks > SCENE_FADE_MAX) {
+        return(false);
+    }
+
+    numPoints = context->mixerPoints ? context->mixerNumPoints : 0;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SCENE_MAGIC;
+    hdr.version = SCENE_VERSION;
+    hdr.numPoints = numPoints;
+    hdr.fadeBlocks = fadeBlocks;
+    for (i = 0; routing && (i < routing->numRoutes); i++) {
+        if ((routing->routes[i].srcID != IPC_STREAMID_UNKNOWN) &&
+            (routing->routes[i].sinkID != IPC_STREAMID_UNKNOWN)) {
+            hdr.numRoutes++;
+        }
+    }
+
+    f = fopen(fname, "wb");
+    if (f == NULL) {
+        return(false);
+    }
+
+    ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1);
+    for (i = 0; ok && routing && (i < routing->numRoutes); i++) {
+        if ((routing->routes[i].srcID != IPC_STREAMID_UNKNOWN) &&
+            (routing->routes[i].sinkID != IPC_STREAMID_UNKNOWN)) {
+            route.index = i;
+            route.route = routing->routes[i];
+            ok = (fwrite(&route, sizeof(route), 1, f) == 1);
+        }
+    }
+    if (ok && numPoints) {
+        mixer_sort(context->mixerPoints, numPoints);
+        ok = (fwrite(context->mixerPoints, sizeof(MIXER_POINT), numPoints, f) ==
+            numPoints);
+    }
+    fclose(f);
+
+    return(ok);
+}
+
+bool scene_control_load(APP_CONTEXT *context, const char *fname)
+{
+    SCENE_ROUTE routes[MAX_AUDIO_ROUTES];
+    SAE_MSG_BUFFER *msgBuffer;
+    MIXER_POINT *points;
+    SCENE_HEADER hdr;
+    SCENE_SLOT *slot;
+    unsigned numRows;
+    unsigned i;
+    IPC_MSG *msg;
+    bool ok;
+    FILE *f;
+
+    if (strlen(fname) >= SCENE_NAME_LEN) {
+        return(false);
+    }
+
+    /* Reuse the scene's own slot or else the first free one */
+    slot = sceneFind(fname);
+    for (i = 0; (slot == NULL) && (i < SCENE_MAX_LOADED); i++) {
+        if (sceneSlot[i].msgBuffer == NULL) {
+            slot = &sceneSlot[i];
+        }
+    }
+    if (slot == NULL) {
+        return(false);
+    }
+
+    f = fopen(fname, "rb");
+    if (f == NULL) {
+        return(false);
+    }
+    ok = sceneRead(f, &hdr, routes, &points);
+    fclose(f);
+    if (!ok) {
+        return(false);
+    }
+
+    mixer_sort(points, hdr.numPoints);
+    numRows = mixer_rows(points, hdr.numPoints);
+
+    msgBuffer = sae_createMsgBuffer(context->saeContext,
+        SCENE_MATRIX_OFFSET + mixer_size(numRows, hdr.numPoints),
+        SAE_ALLOC_BULK, (void **)&msg);
+    if (msgBuffer == NULL) {
+        umm_free(points);
+        return(false);
+    }
+
+    memset(msg, 0, SCENE_MATRIX_OFFSET);
+    msg->type = IPC_TYPE_SCENE;
+    msg->scene.fadeBlocks = hdr.fadeBlocks;
+    msg->scene.matrix = SCENE_MATRIX_OFFSET;
+    msg->scene.routes.numRoutes = MAX_AUDIO_ROUTES;
+    for (i = 0; i < hdr.numRoutes; i++) {
+        msg->scene.routes.routes[routes[i].index] = routes[i].route;
+    }
+    mixer_build((uint8_t *)msg + SCENE_MATRIX_OFFSET, points, hdr.numPoints);
+
+    sceneRelease(context, slot);
+    strcpy(slot->name, fname);
+    slot->msgBuffer = msgBuffer;
+    slot->points = points;
+    slot->numPoints = hdr.numPoints;
+    slot->numRoutes = hdr.numRoutes;
+    slot->fadeBlocks = hdr.fadeBlocks;
+
+    return(true);
+}
+
+bool scene_control_recall(APP_CONTEXT *context, const char *fname,
+    int fadeBlocks)
+{
+    SCENE_SLOT *slot;
+    IPC_MSG *msg;
+
+    if (fadeBlocks > SCENE_FADE_MAX) {
+        return(false);
+    }
+
+    slot = sceneFind(fname);
+    if (slot == NULL) {
+        if (!scene_control_load(context, fname)) {
+            return(false);
+        }
+        slot = sceneFind(fname);
+    }
+
+    /* An override only lasts for this recall */
+    if (fadeBlocks < 0) {
+        fadeBlocks = slot->fadeBlocks;
+    }
+    msg = (IPC_MSG *)sae_getMsgBufferPayload(slot->msgBuffer);
+    msg->scene.fadeBlocks = fadeBlocks;
+
+    if (!route_control_publish_msg(context, slot->msgBuffer)) {
+        return(false);
+    }
+
+    return(mixer_control_adopt(context, slot->msgBuffer, slot->points,
+        slot->numPoints));
+}
+
+void scene_control_drop(APP_CONTEXT *context, const char *fname)
+{
+    SCENE_SLOT *slot;
+    unsigned i;
+
+    if (fname == NULL) {
+        for (i = 0; i < SCENE_MAX_LOADED; i++) {
+            sceneRelease(context, &sceneSlot[i]);
+        }
+        return;
+    }
+
+    slot = sceneFind(fname);
+    if (slot) {
+        sceneRelease(context, slot);
+    }
+}
+
+bool scene_control_info(unsigned idx, const char **name,
+    unsigned *numRoutes, unsigned *numPoints, unsigned *fadeBlocks)
+{
+    SCENE_SLOT *slot;
+
+    if ((idx >= SCENE_MAX_LOADED) || (sceneSlot[idx].msgBuffer == NULL)) {
+        return(false);
+    }
+    slot = &sceneSlot[idx];
+
+    *name = slot->name;
+    *numRoutes = slot->numRoutes;
+    *numPoints = slot->numPoints;
+    *fadeBlocks = slot->fadeBlocks;
+
+    return(true);
+}
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _scene_control_h
+#define _scene_control_h
+
+#include <stdbool.h>
+
+#include "context.h"
+#include "scene.h"
+
+/* Max number of preloaded scenes */
+#ifndef SCENE_MAX_LOADED
+#define SCENE_MAX_LOADED  (8)
+#endif
+
+/* Max scene file name length, including the terminator */
+#define SCENE_NAME_LEN    (32)
+
+/*
+ * Write the published routing table and the working mixer matrix to
+ * a scene file with a default fade of 'fadeBlocks', at most
+ * SCENE_FADE_MAX
+ */
+bool scene_control_save(APP_CONTEXT *context, const char *fname,
+    unsigned fadeBlocks);
+
+/*
+ * Preload a scene file into a ready to send message, replacing a
+ * scene already loaded from the same file
+ */
+bool scene_control_load(APP_CONTEXT *context, const char *fname);
+
+/*
+ * Switch to a scene, loading it first if need be.  A negative
+ * 'fadeBlocks' uses the scene's own fade, anything else overrides it
+ * for this recall only and must be at most SCENE_FADE_MAX.  The
+ * scene's routes become the published routing table and its
+ * crosspoints the working matrix.  SHARC0 holds a scene recalled
+ * during a fade until that fade ends.
+ */
+bool scene_control_recall(APP_CONTEXT *context, const char *fname,
+    int fadeBlocks);
+
+/* Forget a preloaded scene, or all of them if 'fname' is NULL */
+void scene_control_drop(APP_CONTEXT *context, const char *fname);
+
+/*
+ * Describe preloaded scene 'idx' (0 to SCENE_MAX_LOADED - 1).
+ * Returns false for an empty slot.
+ */
+bool scene_control_info(unsigned idx, const char **name,
+    unsigned *numRoutes, unsigned *numPoints, unsigned *fadeBlocks);
+
+#endif
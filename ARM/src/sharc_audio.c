@@ -17,6 +17,7 @@
 #include "wav_audio.h"
 #include "sharc_audio.h"
 #include "sae.h"
+#include "trace.h"
 
 /*
  *  Send audio messages by IPC to both SHARCs in parallel.  Add a
@@ -41,25 +42,30 @@ static void sendMsg(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *msg)
 
 /*
  * This function processes and sends audio messages that are ready in
- * the various clock domains.  'clockSource' is true for audio sources
- * and sinks that drive a clock domain.  'source' is true for clock domain
- * sources and false for clock domain sinks.
+ * the various clock domains.  'source' is true for clock domain sources
+ * and false for clock domain sinks.
  *
  * Audio sources/sinks that don't have an inherent clock are executed
- * when their associated clock source/sink executes.
+ * when their associated clock source/sink executes.  The clock sources
+ * of each domain are set with clock_domain_set_source().  A domain with
+ * a single clock source executes both from that source.
  *
  * When all source/sinks associated with a clock domain have executed, a
  * message is sent to the SHARCs to route that clock domain audio.
  *
  */
 void sharcAudio(APP_CONTEXT *context, unsigned mask, SAE_MSG_BUFFER *msg,
-    bool clockSource, bool source)
+    bool source)
 {
     SAE_CONTEXT *sae = context->saeContext;
     CLOCK_DOMAIN cd;
     IPC_MSG *ipcMsg;
+    unsigned clockSources;
+    bool single;
     bool ready;
 
+    TRACE_BEGIN(TRACE_ID_SHARC_AUDIO, mask);
+
     /*
      * Only audio sources/sinks with inherent clocks call this function so
      * always update the clock domain and send the associated message.
@@ -74,8 +80,10 @@ void sharcAudio(APP_CONTEXT *context, unsigned mask, SAE_MSG_BUFFER *msg,
      * Process clock-less sinks when the source clock domain executes and clock-less
      * sources when sink clock domain executes.
      */
-    if (clockSource) {
-        if (source) {
+    clockSources = clock_domain_get_source(context, cd);
+    if (clockSources & mask) {
+        single = (clockSources == mask);
+        if (source || single) {
             msg = xferUsbTxAudio(context, context->usbMsgTx[0], cd);
             if (msg) {
                 sendMsg(sae, msg);
@@ -84,7 +92,8 @@ void sharcAudio(APP_CONTEXT *context, unsigned mask, SAE_MSG_BUFFER *msg,
             if (msg) {
                 sendMsg(sae, msg);
             }
-        } else {
+        }
+        if (!source || single) {
             msg = xferUsbRxAudio(context, context->usbMsgRx[0], cd);
             if (msg) {
                 sendMsg(sae, msg);
@@ -103,11 +112,14 @@ void sharcAudio(APP_CONTEXT *context, unsigned mask, SAE_MSG_BUFFER *msg,
      */
     ready = clock_domain_ready(context, cd);
     if (ready) {
-        msg = sae_createMsgBuffer(sae, sizeof(*ipcMsg), (void **)&ipcMsg);
+        msg = sae_createMsgBuffer(sae, sizeof(*ipcMsg),
+            SAE_ALLOC_BULK, (void **)&ipcMsg);
         ipcMsg->type = IPC_TYPE_PROCESS_AUDIO;
         ipcMsg->process.clockDomain = cd;
         sendMsg(sae, msg);
         sae_unRefMsgBuffer(sae, msg);
     }
+
+    TRACE_END(TRACE_ID_SHARC_AUDIO, mask);
 }
 
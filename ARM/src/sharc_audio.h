@@ -17,6 +17,6 @@
 #include "sae.h"
 
 void sharcAudio(APP_CONTEXT *context, unsigned mask, SAE_MSG_BUFFER *msg,
-    bool clockSource, bool in);
+    bool source);
 
 #endif
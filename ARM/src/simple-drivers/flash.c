@@ -32,3 +32,28 @@ int flash_program(const FLASH_INFO *fi, uint32_t addr, const uint8_t *buf, int s
     result = fi->flash_program(fi, addr, buf, size);
     return result;
 }
+
+int flash_mmap(const FLASH_INFO *fi, bool enable)
+{
+    int result = FLASH_ERROR;
+    if (fi->flash_mmap) {
+        result = fi->flash_mmap(fi, enable);
+    }
+    return result;
+}
+
+const uint8_t *flash_mmap_acquire(const FLASH_INFO *fi)
+{
+    const uint8_t *base = NULL;
+    if (fi->flash_mmap_acquire) {
+        base = fi->flash_mmap_acquire(fi);
+    }
+    return base;
+}
+
+void flash_mmap_release(const FLASH_INFO *fi)
+{
+    if (fi->flash_mmap_release) {
+        fi->flash_mmap_release(fi);
+    }
+}
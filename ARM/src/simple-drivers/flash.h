@@ -23,6 +23,7 @@
 #define FLASH_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "spi_simple.h"
 
@@ -88,6 +89,55 @@ int flash_erase(const FLASH_INFO *fi, uint32_t addr, int size);
  ******************************************************************/
 int flash_program(const FLASH_INFO *fi, uint32_t addr, const uint8_t *buf, int size);
 
+/*!****************************************************************
+ * @brief  Simple flash memory-mapped mode.
+ *
+ * This function enables or disables memory-mapped (execute in
+ * place) reads of a flash device.  While enabled, erase and program
+ * operations remain available and are arbitrated against readers
+ * of the memory-mapped window by the device driver.
+ *
+ * This function is thread safe.
+ *
+ * @param [in]   fi      A handle to the flash device
+ * @param [in]   enable  true = memory-mapped, false = command mode
+ *
+ * @return Returns FLASH_OK if successful, otherwise
+ *         an error.  Devices without memory-mapped support
+ *         return an error.
+ ******************************************************************/
+int flash_mmap(const FLASH_INFO *fi, bool enable);
+
+/*!****************************************************************
+ * @brief  Simple flash memory-mapped window acquire.
+ *
+ * This function returns a pointer to flash address zero in the
+ * memory-mapped window.  The window remains valid until
+ * flash_mmap_release() is called.  Flash erase and program
+ * operations are held off while any reader holds the window so the
+ * hold time must be kept short, and the caller must not erase or
+ * program the flash itself while holding the window.
+ *
+ * This function is thread safe.
+ *
+ * @param [in]   fi      A handle to the flash device
+ *
+ * @return Returns a pointer to the window or NULL if the flash is
+ *         not memory-mapped.  NULL must not be released.
+ ******************************************************************/
+const uint8_t *flash_mmap_acquire(const FLASH_INFO *fi);
+
+/*!****************************************************************
+ * @brief  Simple flash memory-mapped window release.
+ *
+ * This function releases a window obtained by flash_mmap_acquire().
+ *
+ * This function is thread safe.
+ *
+ * @param [in]   fi      A handle to the flash device
+ ******************************************************************/
+void flash_mmap_release(const FLASH_INFO *fi);
+
 /*!****************************************************************
  * @brief   Flash handle (flash info)
  *
@@ -107,6 +157,12 @@ struct _FLASH_INFO {
     int (*flash_erase)(const FLASH_INFO *fi, uint32_t addr, int size);
     /** Flash device driver program function */
     int (*flash_program)(const FLASH_INFO *fi, uint32_t addr, const uint8_t *buf, int size);
+    /** Flash device driver memory-mapped mode function (optional) */
+    int (*flash_mmap)(const FLASH_INFO *fi, bool enable);
+    /** Flash device driver memory-mapped acquire function (optional) */
+    const uint8_t *(*flash_mmap_acquire)(const FLASH_INFO *fi);
+    /** Flash device driver memory-mapped release function (optional) */
+    void (*flash_mmap_release)(const FLASH_INFO *fi);
 };
 
 #endif /* FLASH_H */
@@ -22,6 +22,8 @@
  *  - Standard, Dual, or Quad I/O device transfers
  *  - Multiple transfers within a single atomic slave select
  *  - Blocking transfers
+ *  - Memory-mapped (XIP) read mode with transparent command mode
+ *    arbitration (SPI2 only)
  *
  */
 
@@ -42,15 +44,22 @@
     #include "task.h"
     #define SPI_ENTER_CRITICAL()  taskENTER_CRITICAL()
     #define SPI_EXIT_CRITICAL()   taskEXIT_CRITICAL()
+    #define SPI_MMAP_LOCK(s)      xSemaphoreTakeRecursive((s)->mmapLock, portMAX_DELAY)
+    #define SPI_MMAP_UNLOCK(s)    xSemaphoreGiveRecursive((s)->mmapLock)
 #else
     #define SPI_ENTER_CRITICAL()
     #define SPI_EXIT_CRITICAL()
+    #define SPI_MMAP_LOCK(s)
+    #define SPI_MMAP_UNLOCK(s)
 #endif
 
 #include "spi_simple.h"
 
 #define SPI_SLVSEL_DEFAULT (0x0000FE00u)
 
+/* SPI2 memory-mapped window */
+#define SPI2_MMAP_BASE     (0x60000000u)
+
 /* SHARC L1 Slave 1 port addresses and offsets */
 #if !defined(__ADSPARM__)
     #define SHARC_L1_ADDR_START   0x00240000u
@@ -88,6 +97,9 @@ struct sSPI {
     volatile uint32_t * pREG_SPI_TWC;
     volatile uint32_t * pREG_SPI_TWCR;
 
+    volatile uint32_t * pREG_SPI_MMRDH;
+    volatile uint32_t * pREG_SPI_MMTOP;
+
     ///< Memory mapped control registers for the SPI DMA channel
     volatile uint32_t * pREG_RX_DMA_CFG;
     volatile uint32_t * pREG_RX_DMA_ADDRSTART;
@@ -115,9 +127,21 @@ struct sSPI {
     ///< Reference to the active device
     sSPIPeriph *device;
 
+    ///< Memory-mapped mode state
+    uint8_t *mmapBase;
+    sSPIPeriph *mmapDevice;
+    uint32_t mmapReadHdr;
+    uint32_t mmapFlags;
+    uint32_t mmapSize;
+    uint32_t mmapSuspend;
+    volatile uint32_t mmapReaders;
+    volatile bool mmapDrain;
+
 #ifdef FREE_RTOS
     SemaphoreHandle_t portLock;
     SemaphoreHandle_t portBlock;
+    SemaphoreHandle_t mmapLock;
+    SemaphoreHandle_t mmapIdle;
 #else
     volatile bool spiDone;
 #endif
@@ -572,6 +596,9 @@ SPI_SIMPLE_RESULT spi_init(void)
             spi->pREG_SPI_IMSK_CLR = pREG_SPI2_IMSK_CLR;
             spi->pREG_SPI_IMSK_SET = pREG_SPI2_IMSK_SET;
             spi->pREG_SPI_ILAT_CLR = pREG_SPI2_ILAT_CLR;
+            spi->pREG_SPI_MMRDH    = pREG_SPI2_MMRDH;
+            spi->pREG_SPI_MMTOP    = pREG_SPI2_MMTOP;
+            spi->mmapBase          = (uint8_t *)SPI2_MMAP_BASE;
 
             spi->SPI_STAT_IRQ_ID   = INTR_SPI2_STAT;
 
@@ -667,6 +694,16 @@ SPI_SIMPLE_RESULT spi_init(void)
         if (spi->portBlock == NULL) {
             result = SPI_SIMPLE_ERROR;
         }
+
+        spi->mmapLock = xSemaphoreCreateRecursiveMutex();
+        if (spi->mmapLock == NULL) {
+            result = SPI_SIMPLE_ERROR;
+        }
+
+        spi->mmapIdle = xSemaphoreCreateCounting(1, 0);
+        if (spi->mmapIdle == NULL) {
+            result = SPI_SIMPLE_ERROR;
+        }
 #endif
 
         spi->open = false;
@@ -687,6 +724,16 @@ SPI_SIMPLE_RESULT spi_deinit(void)
         spi = &spiContext[port];
 
 #ifdef FREE_RTOS
+        if (spi->mmapIdle) {
+            vSemaphoreDelete(spi->mmapIdle);
+            spi->mmapIdle = NULL;
+        }
+
+        if (spi->mmapLock) {
+            vSemaphoreDelete(spi->mmapLock);
+            spi->mmapLock = NULL;
+        }
+
         if (spi->portBlock) {
             vSemaphoreDelete(spi->portBlock);
             spi->portBlock = NULL;
@@ -999,6 +1046,252 @@ static void spi_stat_irq(uint32_t id, void *usrPtr)
     }
 }
 
+/**************************************************************************
+ * Memory-mapped mode functions
+ *
+ * Readers of the memory-mapped window are counted in 'mmapReaders'.
+ * Anything needing command mode first suspends memory-mapped mode
+ * which takes the recursive 'mmapLock' (holding off new readers),
+ * waits for the reader count to drain to zero and then disables the
+ * memory-mapped hardware.  The lock ordering is always 'mmapLock'
+ * followed by 'portLock'.
+ **************************************************************************/
+static void spi_mmapStart(sSPI *spi)
+{
+    sSPIPeriph *device = spi->mmapDevice;
+    uint32_t reg;
+
+    /* Configure device SPI_CLK and the hardware read command */
+    *spi->pREG_SPI_CLK   = device->SPI_CLK;
+    *spi->pREG_SPI_MMRDH = spi->mmapReadHdr;
+    *spi->pREG_SPI_MMTOP = (uint32_t)spi->mmapBase + spi->mmapSize;
+
+    /* Let the hardware manage the slave select */
+    *spi->pREG_SPI_SLVSEL = device->SPI_SLVSEL_DEASSERT;
+
+    /* Rx and Tx must be enabled for memory-mapped reads */
+    *spi->pREG_SPI_RXCTL = ENUM_SPI_RXCTL_RX_EN;
+    *spi->pREG_SPI_TXCTL = ENUM_SPI_TXCTL_TX_EN | ENUM_SPI_TXCTL_TTI_EN;
+
+    /* Configure device SPI_CTL and the data phase IO mode */
+    reg = *spi->pREG_SPI_CTL & ~(device->SPI_CTL_MASK);
+    reg |= device->SPI_CTL;
+    spi_apply_flags(&reg, spi->mmapFlags);
+
+    *spi->pREG_SPI_CTL = reg | BITM_SPI_CTL_ASSEL | BITM_SPI_CTL_MMSE | ENUM_SPI_CTL_EN;
+}
+
+static void spi_mmapStop(sSPI *spi)
+{
+    *spi->pREG_SPI_CTL &= ~(BITM_SPI_CTL_MMSE | BITM_SPI_CTL_ASSEL | ENUM_SPI_CTL_EN);
+    *spi->pREG_SPI_RXCTL = 0x00000000u;
+    *spi->pREG_SPI_TXCTL = 0x00000000u;
+    *spi->pREG_SPI_SLVSEL = SPI_SLVSEL_DEFAULT;
+}
+
+static void spi_mmapStartLocked(sSPI *spi, bool start)
+{
+#ifdef FREE_RTOS
+    xSemaphoreTake(spi->portLock, portMAX_DELAY);
+#endif
+    if (start) {
+        spi_mmapStart(spi);
+    } else {
+        spi_mmapStop(spi);
+    }
+#ifdef FREE_RTOS
+    xSemaphoreGive(spi->portLock);
+#endif
+}
+
+static void spi_mmapSuspendPort(sSPI *spi)
+{
+    /* Hold off new readers until the matching resume */
+    SPI_MMAP_LOCK(spi);
+
+    spi->mmapSuspend++;
+    if ((spi->mmapSuspend == 1) && (spi->mmapDevice != NULL)) {
+
+        /* Wait for the outstanding readers to drain */
+        SPI_ENTER_CRITICAL();
+        while (spi->mmapReaders > 0) {
+            spi->mmapDrain = true;
+            SPI_EXIT_CRITICAL();
+#ifdef FREE_RTOS
+            xSemaphoreTake(spi->mmapIdle, portMAX_DELAY);
+#endif
+            SPI_ENTER_CRITICAL();
+        }
+        spi->mmapDrain = false;
+        SPI_EXIT_CRITICAL();
+
+        /* Return the port to command mode */
+        spi_mmapStartLocked(spi, false);
+    }
+}
+
+static void spi_mmapResumePort(sSPI *spi)
+{
+    spi->mmapSuspend--;
+    if ((spi->mmapSuspend == 0) && (spi->mmapDevice != NULL)) {
+        spi_mmapStartLocked(spi, true);
+    }
+
+    SPI_MMAP_UNLOCK(spi);
+}
+
+SPI_SIMPLE_RESULT spi_mmapEnable(sSPIPeriph *device, const sSPIMmapConfig *cfg)
+{
+    SPI_SIMPLE_RESULT result = SPI_SIMPLE_SUCCESS;
+    sSPI *spi = device->spiHandle;
+    uint32_t readHdr;
+
+    if ((spi->pREG_SPI_MMRDH == NULL) || (cfg == NULL)) {
+        return(SPI_SIMPLE_ERROR);
+    }
+
+    if ((cfg->addrBytes < 1) || (cfg->addrBytes > 4) ||
+        (cfg->dummyBytes > 7) || (cfg->size == 0)) {
+        return(SPI_SIMPLE_ERROR);
+    }
+
+    /* Build the hardware read command header */
+    readHdr  = ((uint32_t)cfg->opcode << BITP_SPI_MMRDH_OPCODE);
+    readHdr |= ((uint32_t)cfg->addrBytes << BITP_SPI_MMRDH_ADRSIZE);
+    readHdr |= ((uint32_t)cfg->dummyBytes << BITP_SPI_MMRDH_DMYSIZE);
+    readHdr |= BITM_SPI_MMRDH_MERGE;
+
+    SPI_MMAP_LOCK(spi);
+
+    if ((spi->mmapDevice != NULL) &&
+        ((spi->mmapDevice != device) || (spi->mmapReaders > 0))) {
+        result = SPI_SIMPLE_PORT_BUSY;
+    }
+
+    if (result == SPI_SIMPLE_SUCCESS) {
+        spi->mmapReadHdr = readHdr;
+        spi->mmapFlags = cfg->flags;
+        spi->mmapSize = cfg->size;
+        spi->mmapDevice = device;
+        if (spi->mmapSuspend == 0) {
+            spi_mmapStartLocked(spi, true);
+        }
+    }
+
+    SPI_MMAP_UNLOCK(spi);
+
+    return(result);
+}
+
+SPI_SIMPLE_RESULT spi_mmapDisable(sSPIPeriph *device)
+{
+    SPI_SIMPLE_RESULT result = SPI_SIMPLE_SUCCESS;
+    sSPI *spi = device->spiHandle;
+
+    spi_mmapSuspendPort(spi);
+
+    if (spi->mmapDevice == device) {
+        spi->mmapDevice = NULL;
+    } else {
+        result = SPI_SIMPLE_ERROR;
+    }
+
+    spi_mmapResumePort(spi);
+
+    return(result);
+}
+
+void *spi_mmapAcquire(sSPIPeriph *device)
+{
+    sSPI *spi = device->spiHandle;
+    void *base = NULL;
+
+    /*
+     * Fast path: join readers already holding the window.  This never
+     * blocks so a reader can safely nest acquisitions even while a
+     * command mode transfer is waiting for the window to drain.
+     */
+    SPI_ENTER_CRITICAL();
+    if ((spi->mmapReaders > 0) && (spi->mmapDevice == device)) {
+        spi->mmapReaders++;
+        base = spi->mmapBase;
+    }
+    SPI_EXIT_CRITICAL();
+
+    /* Slow path: wait out any command mode transfer in progress */
+    if (base == NULL) {
+        SPI_MMAP_LOCK(spi);
+        SPI_ENTER_CRITICAL();
+        if ((spi->mmapDevice == device) && (spi->mmapSuspend == 0)) {
+            spi->mmapReaders++;
+            base = spi->mmapBase;
+        }
+        SPI_EXIT_CRITICAL();
+        SPI_MMAP_UNLOCK(spi);
+    }
+
+    return(base);
+}
+
+SPI_SIMPLE_RESULT spi_mmapRelease(sSPIPeriph *device)
+{
+    SPI_SIMPLE_RESULT result = SPI_SIMPLE_SUCCESS;
+    sSPI *spi = device->spiHandle;
+    bool wake = false;
+
+    SPI_ENTER_CRITICAL();
+    if (spi->mmapReaders > 0) {
+        spi->mmapReaders--;
+        wake = (spi->mmapReaders == 0) && spi->mmapDrain;
+    } else {
+        result = SPI_SIMPLE_ERROR;
+    }
+    SPI_EXIT_CRITICAL();
+
+#ifdef FREE_RTOS
+    if (wake) {
+        xSemaphoreGive(spi->mmapIdle);
+    }
+#endif
+
+    return(result);
+}
+
+SPI_SIMPLE_RESULT spi_mmapSuspend(sSPIPeriph *device)
+{
+    spi_mmapSuspendPort(device->spiHandle);
+    return(SPI_SIMPLE_SUCCESS);
+}
+
+SPI_SIMPLE_RESULT spi_mmapResume(sSPIPeriph *device)
+{
+    spi_mmapResumePort(device->spiHandle);
+    return(SPI_SIMPLE_SUCCESS);
+}
+
+SPI_SIMPLE_RESULT spi_mmapInvalidate(sSPIPeriph *device, uint32_t offset, uint32_t len)
+{
+    sSPI *spi = device->spiHandle;
+    uint8_t *flushStart, *flushEnd;
+
+    if ((spi->mmapBase == NULL) || (len == 0)) {
+        return(SPI_SIMPLE_ERROR);
+    }
+
+#if defined(__ADSPARM__)
+    flushStart = spi->mmapBase + offset;  flushEnd = flushStart + len;
+    flush_data_buffer(flushStart, flushEnd, ADI_FLUSH_DATA_INV);
+#else
+    /* See the comment in spi_setup_dma() */
+    dcache_invalidate_both(ADI_DCACHE_INV_WB);
+#endif
+
+    return(SPI_SIMPLE_SUCCESS);
+}
+
+/**************************************************************************
+ * SPI transfer functions
+ **************************************************************************/
 SPI_SIMPLE_RESULT spi_batch_xfer(sSPIPeriph *deviceHandle, uint16_t numXfers, sSPIXfer *xfers)
 {
     SPI_SIMPLE_RESULT result = SPI_SIMPLE_SUCCESS;
@@ -1010,15 +1303,25 @@ SPI_SIMPLE_RESULT spi_batch_xfer(sSPIPeriph *deviceHandle, uint16_t numXfers, sS
     void *rx;
     void *tx;
     uint16_t len;
+    bool mmapSuspended;
 
     if (numXfers == 0) {
         return(SPI_SIMPLE_ERROR);
     }
 
+    /* Drop out of memory-mapped mode for the duration of the transfer */
+    mmapSuspended = (spi->mmapDevice != NULL);
+    if (mmapSuspended) {
+        spi_mmapSuspendPort(spi);
+    }
+
     /* Lock the SPI port */
 #ifdef FREE_RTOS
     rtosResult = xSemaphoreTake(spi->portLock, portMAX_DELAY);
     if (rtosResult != pdTRUE) {
+        if (mmapSuspended) {
+            spi_mmapResumePort(spi);
+        }
         return(SPI_SIMPLE_ERROR);
     }
 #endif
@@ -1092,6 +1395,11 @@ SPI_SIMPLE_RESULT spi_batch_xfer(sSPIPeriph *deviceHandle, uint16_t numXfers, sS
     }
 #endif
 
+    /* Return to memory-mapped mode if it was active */
+    if (mmapSuspended) {
+        spi_mmapResumePort(spi);
+    }
+
     return(result);
 }
 
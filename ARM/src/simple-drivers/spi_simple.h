@@ -22,6 +22,8 @@
  *     - Standard, Dual, or Quad I/O device transfers
  *     - Multiple transfers within a single atomic slave select
  *     - Blocking transfers
+ *     - Memory-mapped (XIP) read mode with transparent command mode
+ *       arbitration (SPI2 only)
  *
  * @file      spi_simple.h
  * @version   1.0.0
@@ -153,6 +155,23 @@ typedef struct sSPIXfer {
     uint32_t flags;    /**< Logical OR of SPI_SIMPLE_XFER_FLAGS */
 } sSPIXfer;
 
+/*!****************************************************************
+ * @brief Memory-mapped read mode configuration.
+ *
+ * Describes the read command the SPI hardware issues on behalf of
+ * the core when the memory-mapped window is accessed.
+ *
+ * For further details, refer to the "Memory-Mapped Mode" section
+ * of the ADSP-SC58x SHARC+ Processor Hardware Manual, Rev 1.0.
+ ******************************************************************/
+typedef struct sSPIMmapConfig {
+    uint8_t opcode;      /**< Read command opcode */
+    uint8_t addrBytes;   /**< Number of address bytes (1-4) */
+    uint8_t dummyBytes;  /**< Number of dummy bytes (0-7) */
+    uint32_t flags;      /**< Data phase SPI_SIMPLE_XFER_FLAGS */
+    uint32_t size;       /**< Size of the mapped device in bytes */
+} sSPIMmapConfig;
+
 /*!****************************************************************
  * @brief Opaque Simple SPI peripheral device handle type.
  ******************************************************************/
@@ -524,6 +543,148 @@ SPI_SIMPLE_RESULT spi_xfer(sSPIPeriph *deviceHandle, uint16_t len, void *rx, voi
  ******************************************************************/
 SPI_SIMPLE_RESULT spi_batch_xfer(sSPIPeriph *deviceHandle, uint16_t numXfers, sSPIXfer *xfers);
 
+/*!****************************************************************
+ * @brief Simple SPI memory-mapped mode enable.
+ *
+ * This function places the SPI port into memory-mapped mode on
+ * behalf of the device.  Core reads from the port's memory-mapped
+ * window are then converted into device read commands by the SPI
+ * hardware.  Only one device per port can be memory-mapped.
+ *
+ * While memory-mapped mode is enabled, spi_xfer() and
+ * spi_batch_xfer() remain available to all devices on the port.
+ * They wait for outstanding readers (see spi_mmapAcquire()) to
+ * finish, drop the port back into command mode for the duration
+ * of the transfer and restore memory-mapped mode afterwards.
+ *
+ * If using the SPI driver under FreeRTOS, this function must be
+ * called after the RTOS has been started.
+ *
+ * This function is thread safe.
+ *
+ * @param [in] deviceHandle  A handle to a SPI device
+ * @param [in] cfg           Memory-mapped read configuration
+ *
+ * @return Returns SPI_SIMPLE_SUCCESS if successful, otherwise
+ *         an error.
+ ******************************************************************/
+SPI_SIMPLE_RESULT spi_mmapEnable(sSPIPeriph *deviceHandle,
+    const sSPIMmapConfig *cfg);
+
+/*!****************************************************************
+ * @brief Simple SPI memory-mapped mode disable.
+ *
+ * This function waits for all outstanding readers to release the
+ * memory-mapped window and returns the port to command mode.
+ *
+ * If using the SPI driver under FreeRTOS, this function must be
+ * called after the RTOS has been started.
+ *
+ * This function is thread safe.
+ *
+ * @param [in] deviceHandle  A handle to a SPI device
+ *
+ * @return Returns SPI_SIMPLE_SUCCESS if successful, otherwise
+ *         an error.
+ ******************************************************************/
+SPI_SIMPLE_RESULT spi_mmapDisable(sSPIPeriph *deviceHandle);
+
+/*!****************************************************************
+ * @brief Simple SPI memory-mapped window acquire.
+ *
+ * This function pins the port in memory-mapped mode and returns
+ * the start of the memory-mapped window (device address zero).
+ * The window may be read directly until spi_mmapRelease() is
+ * called.  Calls may nest.
+ *
+ * Command mode transfers on the port are held off while any
+ * reader holds the window so keep the hold time short and never
+ * call spi_xfer() or spi_batch_xfer() while holding the window.
+ *
+ * If using the SPI driver under FreeRTOS, this function must be
+ * called after the RTOS has been started.
+ *
+ * This function is thread safe.
+ *
+ * @param [in] deviceHandle  A handle to a memory-mapped SPI device
+ *
+ * @return Returns a pointer to the memory-mapped window or NULL
+ *         if the device is not memory-mapped.
+ ******************************************************************/
+void *spi_mmapAcquire(sSPIPeriph *deviceHandle);
+
+/*!****************************************************************
+ * @brief Simple SPI memory-mapped window release.
+ *
+ * This function releases a reference obtained with
+ * spi_mmapAcquire().
+ *
+ * This function is thread safe.
+ *
+ * @param [in] deviceHandle  A handle to a memory-mapped SPI device
+ *
+ * @return Returns SPI_SIMPLE_SUCCESS if successful, otherwise
+ *         an error.
+ ******************************************************************/
+SPI_SIMPLE_RESULT spi_mmapRelease(sSPIPeriph *deviceHandle);
+
+/*!****************************************************************
+ * @brief Simple SPI memory-mapped mode suspend.
+ *
+ * This function waits for all outstanding readers to release the
+ * memory-mapped window and switches the port into command mode
+ * until spi_mmapResume() is called.  New readers block in
+ * spi_mmapAcquire() until then.  Calls may nest.
+ *
+ * Use this to keep readers off the window across multi-transfer
+ * device operations such as a flash erase or program followed by
+ * busy polling.
+ *
+ * If using the SPI driver under FreeRTOS, this function must be
+ * called after the RTOS has been started.
+ *
+ * This function is thread safe.
+ *
+ * @param [in] deviceHandle  A handle to a SPI device
+ *
+ * @return Returns SPI_SIMPLE_SUCCESS if successful, otherwise
+ *         an error.
+ ******************************************************************/
+SPI_SIMPLE_RESULT spi_mmapSuspend(sSPIPeriph *deviceHandle);
+
+/*!****************************************************************
+ * @brief Simple SPI memory-mapped mode resume.
+ *
+ * This function undoes a spi_mmapSuspend().
+ *
+ * This function is thread safe.
+ *
+ * @param [in] deviceHandle  A handle to a SPI device
+ *
+ * @return Returns SPI_SIMPLE_SUCCESS if successful, otherwise
+ *         an error.
+ ******************************************************************/
+SPI_SIMPLE_RESULT spi_mmapResume(sSPIPeriph *deviceHandle);
+
+/*!****************************************************************
+ * @brief Simple SPI memory-mapped window invalidate.
+ *
+ * This function discards any cached copies of a region of the
+ * memory-mapped window.  It must be called after the underlying
+ * device contents have been modified through command mode.
+ *
+ * This function is thread safe.
+ *
+ * @param [in] deviceHandle  A handle to a memory-mapped SPI device
+ * @param [in] offset        Device address of the modified region
+ * @param [in] len           Length of the modified region in bytes
+ *
+ * @return Returns SPI_SIMPLE_SUCCESS if successful, otherwise
+ *         an error.
+ ******************************************************************/
+SPI_SIMPLE_RESULT spi_mmapInvalidate(sSPIPeriph *deviceHandle,
+    uint32_t offset, uint32_t len);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -50,6 +50,7 @@
 
 #include "clocks.h"
 #include "sport_simple.h"
+#include "trace.h"
 
 /* SHARC L1 Slave 1 port addresses and offsets */
 #if !defined(__ADSPARM__)
@@ -947,6 +948,8 @@ static void sport_dma_irq(uint32_t id, void *usrPtr)
     sSPORT *sport = (sSPORT *)usrPtr;
     uint8_t *dataAddr;
 
+    TRACE_BEGIN(TRACE_ID_SPORT_IRQ, id);
+
     /* Clear the interrupt */
     *sport->pREG_DMA_STAT |= ENUM_DMA_STAT_IRQDONE;
 
@@ -988,4 +991,6 @@ static void sport_dma_irq(uint32_t id, void *usrPtr)
         sport->pp = (*sport->pREG_DMA_ADDRSTART == sport->dmaDescriptors[0].start) ?
             0 : 1;
     }
+
+    TRACE_END(TRACE_ID_SPORT_IRQ, id);
 }
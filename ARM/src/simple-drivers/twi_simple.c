@@ -17,6 +17,7 @@
  *  - Fully protected multi-threaded TWI transfers
  *  - Up to 64k read and write transfers
  *  - Blocking transfers
+ *  - Transfer lists chained from the completion interrupt
  *
  */
 #include <string.h>
@@ -68,13 +69,6 @@
 
 #define TWI_MAX_DCNT              (0xFF - 1)
 
-typedef enum TWI_SIMPLE_XFER_TYPE {
-   TWI_SIMPLE_READ,
-   TWI_SIMPLE_WRITE,
-   TWI_SIMPLE_WRITEREAD,
-   TWI_SIMPLE_WRITEWRITE,
-} TWI_SIMPLE_XFER_TYPE;
-
 struct sTWI {
 
     // Memory-mapped control registers used to program TWI peripheral
@@ -107,6 +101,11 @@ struct sTWI {
     TWI_SIMPLE_XFER_TYPE xferType;
     TWI_SIMPLE_XFER_TYPE xferState;
 
+    /* Transfer list chained from the ISR */
+    TWI_SIMPLE_XFER *xferList;
+    uint16_t xferCount;
+    volatile uint16_t xferIdx;
+
 #ifdef FREE_RTOS
     SemaphoreHandle_t portLock;
     SemaphoreHandle_t portBlock;
@@ -257,18 +256,139 @@ static void twi_empty_fifo(sTWI *twi)
 }
 
 
-static TWI_SIMPLE_RESULT twi_xfer(sTWI *twi, uint8_t address,
+/*
+ * Validates a transfer and converts write/reads and write/writes
+ * with an empty half into simple reads or writes.
+ */
+static TWI_SIMPLE_RESULT twi_xfer_type(TWI_SIMPLE_XFER_TYPE *xferType,
+    uint8_t *out, uint16_t outLen, uint8_t *in, uint16_t inLen)
+{
+    TWI_SIMPLE_RESULT result = TWI_SIMPLE_SUCCESS;
+
+    /* Convert write/reads if necessary */
+    if (*xferType == TWI_SIMPLE_WRITEREAD) {
+        if (outLen > TWI_MAX_DCNT) {
+            result = TWI_SIMPLE_BAD_LENGTH;
+        }
+        if ((outLen == 0) && (inLen == 0)) {
+            result = TWI_SIMPLE_BAD_LENGTH;
+        } else if (outLen == 0) {
+            *xferType = TWI_SIMPLE_READ;
+        } else if (inLen == 0) {
+            *xferType = TWI_SIMPLE_WRITE;
+        }
+    }
+
+    /* Convert write/writes if necessary */
+    if (*xferType == TWI_SIMPLE_WRITEWRITE) {
+        if ((outLen == 0) && (inLen == 0)) {
+            result = TWI_SIMPLE_BAD_LENGTH;
+        } else if ((in == NULL) || (inLen == 0)) {
+            *xferType = TWI_SIMPLE_WRITE;
+        }
+    }
+
+    /* Don't allow zero byte reads.  Confuses some devices */
+    if ((*xferType == TWI_SIMPLE_READ) && (inLen == 0)) {
+        result = TWI_SIMPLE_BAD_LENGTH;
+    }
+
+    return(result);
+}
+
+/*
+ * Loads and starts a transfer.  Called from task level for the first
+ * transfer and from the ISR for each following transfer of a list.
+ */
+static void twi_start(sTWI *twi, uint8_t address,
     TWI_SIMPLE_XFER_TYPE xferType,
     uint8_t *out, uint16_t outLen,
     uint8_t *in, uint16_t inLen )
 {
-    TWI_SIMPLE_RESULT result;
     uint16_t mstrctrl;
+
+    /* Save the transfer info */
+    twi->address = address;
+    twi->sdata = out;
+    twi->slen = outLen;
+    twi->xferType = xferType;
+    twi->rdata = in;
+    twi->rlen = inLen;
+
+    /* Setup the transfer */
+    mstrctrl = twi_begin(twi);
+
+    /* Prefill the FIFO */
+    if (twi->xferType != TWI_SIMPLE_READ) {
+        twi_fill_fifo(twi);
+    }
+
+    /* Start the transfer */
+    *twi->pREG_TWI_MSTRCTL = mstrctrl | ENUM_TWI_MSTRCTL_EN;
+}
+
+/*
+ * Starts the next transfer of a list from the ISR.  Returns false
+ * if the list is complete.
+ */
+static bool twi_start_next(sTWI *twi)
+{
+    TWI_SIMPLE_XFER *x;
+    TWI_SIMPLE_XFER_TYPE xferType;
+
+    if ((twi->xferList == NULL) || (twi->xferIdx + 1 >= twi->xferCount)) {
+        return(false);
+    }
+
+    /* Clear the previous transfer's status */
+    twi_end(twi);
+
+    twi->xferIdx++;
+    x = &twi->xferList[twi->xferIdx];
+    xferType = x->type;
+    twi_xfer_type(&xferType, x->out, x->outLen, x->in, x->inLen);
+    twi_start(twi, x->address, xferType, x->out, x->outLen, x->in, x->inLen);
+
+    return(true);
+}
+
+static TWI_SIMPLE_RESULT twi_wait(sTWI *twi)
+{
+    TWI_SIMPLE_RESULT result = TWI_SIMPLE_SUCCESS;
     uint16_t twiErrors;
 #ifdef FREE_RTOS
     BaseType_t rtosResult;
 #endif
 
+    /* Block until complete */
+#ifdef FREE_RTOS
+    rtosResult = xSemaphoreTake(twi->portBlock, portMAX_DELAY);
+    if (rtosResult != pdTRUE) {
+        result = TWI_SIMPLE_ERROR;
+    }
+#else
+    while (twi->twiDone == false);
+#endif
+
+    /* Complete the transfer */
+    twiErrors = twi_end(twi);
+    if (twiErrors) {
+        result = TWI_SIMPLE_ERROR;
+    }
+
+    return(result);
+}
+
+static TWI_SIMPLE_RESULT twi_xfer(sTWI *twi, uint8_t address,
+    TWI_SIMPLE_XFER_TYPE xferType,
+    uint8_t *out, uint16_t outLen,
+    uint8_t *in, uint16_t inLen )
+{
+    TWI_SIMPLE_RESULT result;
+#ifdef FREE_RTOS
+    BaseType_t rtosResult;
+#endif
+
     if (twi == NULL) {
         return(TWI_SIMPLE_ERROR);
     }
@@ -283,77 +403,90 @@ static TWI_SIMPLE_RESULT twi_xfer(sTWI *twi, uint8_t address,
     }
 #endif
 
-    /* Convert write/reads if necessary */
-    if (xferType == TWI_SIMPLE_WRITEREAD) {
-        if (outLen > TWI_MAX_DCNT) {
-            result = TWI_SIMPLE_BAD_LENGTH;
-        }
-        if ((outLen == 0) && (inLen == 0)) {
-            result = TWI_SIMPLE_BAD_LENGTH;
-        } else if (outLen == 0) {
-            xferType = TWI_SIMPLE_READ;
-        } else if (inLen == 0) {
-            xferType = TWI_SIMPLE_WRITE;
-        }
-    }
+    result = twi_xfer_type(&xferType, out, outLen, in, inLen);
 
-    /* Convert write/writes if necessary */
-    if (xferType == TWI_SIMPLE_WRITEWRITE) {
-        if ((outLen == 0) && (inLen == 0)) {
-            result = TWI_SIMPLE_BAD_LENGTH;
-        } else if ((in == NULL) || (inLen == 0)) {
-            xferType = TWI_SIMPLE_WRITE;
-        }
+    if (result == TWI_SIMPLE_SUCCESS) {
+        twi->xferList = NULL;
+#ifndef FREE_RTOS
+        twi->twiDone = false;
+#endif
+        twi_start(twi, address, xferType, out, outLen, in, inLen);
+        result = twi_wait(twi);
     }
 
-    /* Don't allow zero byte reads.  Confuses some devices */
-    if ((xferType == TWI_SIMPLE_READ) && (inLen == 0)) {
-        result = TWI_SIMPLE_BAD_LENGTH;
+#ifdef FREE_RTOS
+    rtosResult = xSemaphoreGive(twi->portLock);
+    if (rtosResult != pdTRUE) {
+        result = TWI_SIMPLE_ERROR;
     }
+#endif
 
-    if (result == TWI_SIMPLE_SUCCESS) {
+    return(result);
+}
 
-        /* Save the transfer info */
-        twi->address = address;
-        twi->sdata = out;
-        twi->slen = outLen;
-        twi->xferType = xferType;
-        twi->rdata = in;
-        twi->rlen = inLen;
+TWI_SIMPLE_RESULT twi_xferList(sTWI *twiHandle, TWI_SIMPLE_XFER *xfers,
+    uint16_t count, uint16_t *done)
+{
+    sTWI *twi = twiHandle;
+    TWI_SIMPLE_RESULT result;
+    TWI_SIMPLE_XFER_TYPE xferType;
+    TWI_SIMPLE_XFER *x;
+    uint16_t i;
+#ifdef FREE_RTOS
+    BaseType_t rtosResult;
+#endif
 
-        /* Setup the transfer */
-        mstrctrl = twi_begin(twi);
+    if (done) {
+        *done = 0;
+    }
 
-        /* Prefill the FIFO */
-        if (twi->xferType != TWI_SIMPLE_READ) {
-            twi_fill_fifo(twi);
-        }
+    if ((twi == NULL) || (xfers == NULL)) {
+        return(TWI_SIMPLE_ERROR);
+    }
 
-#ifndef FREE_RTOS
-        twi->twiDone = false;
-#endif
+    if (count == 0) {
+        return(TWI_SIMPLE_SUCCESS);
+    }
 
-        /* Start the transfer */
-        *twi->pREG_TWI_MSTRCTL = mstrctrl | ENUM_TWI_MSTRCTL_EN;
+    /* Validate the whole list up front so the ISR never has to fail */
+    for (i = 0; i < count; i++) {
+        x = &xfers[i];
+        xferType = x->type;
+        result = twi_xfer_type(&xferType, x->out, x->outLen, x->in, x->inLen);
+        if (result != TWI_SIMPLE_SUCCESS) {
+            return(result);
+        }
+    }
 
-        /* Block until complete */
 #ifdef FREE_RTOS
-        rtosResult = xSemaphoreTake(twi->portBlock, portMAX_DELAY);
-        if (rtosResult != pdTRUE) {
-            result = TWI_SIMPLE_ERROR;
-        }
-#else
-        while (twi->twiDone == false);
+    rtosResult = xSemaphoreTake(twi->portLock, portMAX_DELAY);
+    if (rtosResult != pdTRUE) {
+        result = TWI_SIMPLE_ERROR;
+        return(result);
+    }
 #endif
 
-        /* Complete the transfer */
-        twiErrors = twi_end(twi);
-        if (twiErrors) {
-            result = TWI_SIMPLE_ERROR;
-        }
+    twi->xferList = xfers;
+    twi->xferCount = count;
+    twi->xferIdx = 0;
+#ifndef FREE_RTOS
+    twi->twiDone = false;
+#endif
+
+    x = &xfers[0];
+    xferType = x->type;
+    twi_xfer_type(&xferType, x->out, x->outLen, x->in, x->inLen);
+    twi_start(twi, x->address, xferType, x->out, x->outLen, x->in, x->inLen);
 
+    /* The ISR chains the remaining transfers */
+    result = twi_wait(twi);
+
+    if (done) {
+        *done = (result == TWI_SIMPLE_SUCCESS) ? count : twi->xferIdx;
     }
 
+    twi->xferList = NULL;
+
 #ifdef FREE_RTOS
     rtosResult = xSemaphoreGive(twi->portLock);
     if (rtosResult != pdTRUE) {
@@ -364,7 +497,6 @@ static TWI_SIMPLE_RESULT twi_xfer(sTWI *twi, uint8_t address,
     return(result);
 }
 
-
 TWI_SIMPLE_RESULT twi_write(sTWI *twiHandle, uint8_t address,
     uint8_t *out, uint16_t outLen)
 {
@@ -755,6 +887,13 @@ static void twi_data_irq(uint32_t id, void *usrPtr)
                 twi->xferType = TWI_SIMPLE_READ;
             }
 
+            /* Chain the next transfer of a list if no errors */
+            if (xferDone && !(mstrstat & TWI_SIMPLE_ERRORS)) {
+                if (twi_start_next(twi)) {
+                    xferDone = false;
+                }
+            }
+
             if (xferDone) {
 #ifdef FREE_RTOS
                 rtosResult = xSemaphoreGiveFromISR(twi->portBlock, &contextSwitch);
@@ -16,6 +16,7 @@
  *     - FreeRTOS or no RTOS main-loop modes
  *     - Fully protected multi-threaded device transfers
  *     - Blocking transfers
+ *     - Interrupt chained transfer lists
  *
  * @file      twi_simple.h
  * @version   1.0.0
@@ -72,6 +73,30 @@ typedef enum TWI_SIMPLE_RESULT {
     TWI_SIMPLE_BAD_LENGTH        /**< Transfer length is too long (>254) */
 } TWI_SIMPLE_RESULT;
 
+/*!****************************************************************
+ * @brief Simple TWI driver transfer types.
+ ******************************************************************/
+typedef enum TWI_SIMPLE_XFER_TYPE {
+   TWI_SIMPLE_READ,         /**< Read 'in' */
+   TWI_SIMPLE_WRITE,        /**< Write 'out' */
+   TWI_SIMPLE_WRITEREAD,    /**< Write 'out', repeated start, read 'in' */
+   TWI_SIMPLE_WRITEWRITE,   /**< Write 'out' then 'in' atomically */
+} TWI_SIMPLE_XFER_TYPE;
+
+/*!****************************************************************
+ * @brief Simple TWI driver transfer list entry.
+ *
+ * @sa twi_xferList
+ ******************************************************************/
+typedef struct TWI_SIMPLE_XFER {
+    uint8_t address;             /**< Device address */
+    TWI_SIMPLE_XFER_TYPE type;   /**< Transfer type */
+    uint8_t *out;                /**< Write data */
+    uint16_t outLen;             /**< Write data length */
+    uint8_t *in;                 /**< Read data (or second write buffer) */
+    uint16_t inLen;              /**< Read data length */
+} TWI_SIMPLE_XFER;
+
 /*!****************************************************************
  * @brief Opaque Simple TWI driver handle type.
  ******************************************************************/
@@ -262,6 +287,33 @@ TWI_SIMPLE_RESULT twi_writeRead(sTWI *twiHandle, uint8_t address,
 TWI_SIMPLE_RESULT twi_writeWrite(sTWI *twiHandle, uint8_t address,
     uint8_t *out, uint16_t outLen, uint8_t *out2, uint16_t out2Len);
 
+/*!****************************************************************
+ * @brief Simple TWI transfer list.
+ *
+ * This function performs a list of TWI transfers back-to-back.  Each
+ * transfer is started from the completion interrupt of the previous
+ * one so the calling task is only woken once at the end of the list
+ * or at the first failing transfer.  The port is held for the whole
+ * list.
+ *
+ * If using the TWI driver under FreeRTOS, this function must be
+ * called after the RTOS has been started.
+ *
+ * This function is thread safe.
+ *
+ * @param [in]  twiHandle  A handle to a TWI port
+ * @param [in]  xfers      Array of transfers.  Must remain valid
+ *                         until this function returns.
+ * @param [in]  count      Number of transfers in the array
+ * @param [out] done       Optional pointer to the number of transfers
+ *                         completed successfully
+ *
+ * @return Returns TWI_SIMPLE_SUCCESS if all transfers were
+ *         successful, otherwise an error.
+ ******************************************************************/
+TWI_SIMPLE_RESULT twi_xferList(sTWI *twiHandle, TWI_SIMPLE_XFER *xfers,
+    uint16_t count, uint16_t *done);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -17,6 +17,7 @@
  *     - FreeRTOS or no RTOS main-loop modes
  *     - Fully protected multi-threaded device transfers
  *     - Blocking transfers
+ *     - Coalesced bulk IN transfers out of a large transmit ring
  *
  * Copyright 2020 Analog Devices, Inc.  All rights reserved.
  *
@@ -27,6 +28,7 @@
     #include "FreeRTOS.h"
     #include "semphr.h"
     #include "task.h"
+    #include "timers.h"
     #define UART_ENTER_CRITICAL()  taskENTER_CRITICAL()
     #define UART_EXIT_CRITICAL()   taskEXIT_CRITICAL()
 #else
@@ -38,8 +40,32 @@
 #include "cdc.h"
 
 #define UART_BUFFER_SIZE        (1024)
+#define UART_RX_RESUME_LEVEL    (512)
 #define UART_END_CDC            (UART1)
 
+/*
+ * Transmit data is coalesced in a large ring and sent as the biggest
+ * contiguous bulk IN transfer available.  An idle port starts a transfer
+ * once UART_CDC_TX_FLUSH_THRESHOLD bytes are queued or after
+ * UART_CDC_TX_FLUSH_MS, whichever comes first.  Data queued while a
+ * transfer is in flight goes out as soon as it completes.
+ */
+#ifndef UART_CDC_TX_BUFFER_SIZE
+#define UART_CDC_TX_BUFFER_SIZE      (32 * 1024)
+#endif
+#ifndef UART_CDC_TX_MAX_XFER
+#define UART_CDC_TX_MAX_XFER         (16 * 1024)
+#endif
+#ifndef UART_CDC_TX_FLUSH_THRESHOLD
+#define UART_CDC_TX_FLUSH_THRESHOLD  (512)
+#endif
+#ifndef UART_CDC_TX_FLUSH_MS
+#define UART_CDC_TX_FLUSH_MS         (1)
+#endif
+#ifndef UART_CDC_TX_TIMEOUT_MS
+#define UART_CDC_TX_TIMEOUT_MS       (100)
+#endif
+
 typedef enum UART_SIMPLE_INT_RESULT
 {
     UART_SIMPLE_TX_OK,
@@ -57,9 +83,10 @@ struct sUART {
     volatile uint16_t rx_buffer_writeptr;
 
     // UART transmit buffer
-    uint8_t tx_buffer[UART_BUFFER_SIZE];
-    volatile uint16_t tx_buffer_readptr;
-    uint16_t tx_buffer_writeptr;
+    uint8_t tx_buffer[UART_CDC_TX_BUFFER_SIZE];
+    volatile uint32_t tx_buffer_readptr;
+    volatile uint32_t tx_buffer_writeptr;
+    uint32_t tx_inflight;
 
     // read/write timeouts mode
     int32_t readTimeout;
@@ -70,6 +97,7 @@ struct sUART {
     bool open;
     bool rxSleeping;
     bool txSleeping;
+    volatile bool rxPaused;
 
 #ifdef FREE_RTOS
     SemaphoreHandle_t portLock;
@@ -79,6 +107,7 @@ struct sUART {
     SemaphoreHandle_t portTxBlock;
     TickType_t rtosReadTimeout;
     TickType_t rtosWriteTimeout;
+    TimerHandle_t txFlushTimer;
 #else
     volatile bool uartDone;
 #endif
@@ -95,6 +124,29 @@ __attribute__ ((section(".l3_uncached_data")))
 
 static bool uart_cdc_initialized = false;
 
+static uint16_t _uart_cdc_rxFree(sUART *uart)
+{
+    return (uart->rx_buffer_readptr + UART_BUFFER_SIZE -
+        uart->rx_buffer_writeptr - 1) % UART_BUFFER_SIZE;
+}
+
+/*
+ * Called by the CDC layer before accepting a bulk OUT transfer.  Returning
+ * false pauses (NAKs) the endpoint until a read frees enough
+ * room, so a slow reader throttles the host instead of losing data.
+ */
+static bool _uart_cdc_rx_space(unsigned short length, void *usrPtr)
+{
+    sUART *uart = (sUART *)usrPtr;
+
+    if (_uart_cdc_rxFree(uart) < length) {
+        uart->rxPaused = true;
+        return(false);
+    }
+
+    return(true);
+}
+
 static UART_SIMPLE_INT_RESULT _uart_cdc_isr_writeToRXBuffer(sUART *uart, uint8_t val)
 {
     // First check if RX buffer is full
@@ -114,31 +166,105 @@ static UART_SIMPLE_INT_RESULT _uart_cdc_isr_writeToRXBuffer(sUART *uart, uint8_t
     return UART_SIMPLE_RX_OK;
 }
 
+static uint32_t _uart_cdc_txUsed(sUART *uart)
+{
+    return (uart->tx_buffer_writeptr + UART_CDC_TX_BUFFER_SIZE -
+        uart->tx_buffer_readptr) % UART_CDC_TX_BUFFER_SIZE;
+}
+
+static uint32_t _uart_cdc_txFree(sUART *uart)
+{
+    return (UART_CDC_TX_BUFFER_SIZE - 1 - _uart_cdc_txUsed(uart));
+}
+
 /*
- * FIXME: Send out chunks of data instead of char by char
+ * Send everything queued up to the end of the ring in a single bulk
+ * transfer.  Must be called from the tx complete ISR or inside a
+ * critical section.
  */
-UART_SIMPLE_INT_RESULT _uart_cdc_isr_readFromTXBuffer(sUART *uart, uint8_t *val)
+static UART_SIMPLE_INT_RESULT _uart_cdc_isr_readFromTXBuffer(sUART *uart)
 {
-    uint8_t *c;
+    uint32_t readptr;
+    uint32_t writeptr;
+    uint32_t len;
     CLD_USB_Data_Transmit_Return_Type ok;
-    UART_SIMPLE_INT_RESULT ret;
+
+    readptr = uart->tx_buffer_readptr;
+    writeptr = uart->tx_buffer_writeptr;
 
     // First check if write buffer is empty
-    if (uart->tx_buffer_writeptr == uart->tx_buffer_readptr) {
+    if (writeptr == readptr) {
         return UART_SIMPLE_TX_FIFO_EMPTY;
     }
 
-    // fetch latest value from TX buffer
-    c = &uart->tx_buffer[uart->tx_buffer_readptr];
+    // Largest contiguous run
+    len = (writeptr > readptr) ?
+        (writeptr - readptr) : (UART_CDC_TX_BUFFER_SIZE - readptr);
+    if (len > UART_CDC_TX_MAX_XFER) {
+        len = UART_CDC_TX_MAX_XFER;
+    }
+
+    uart->tx_inflight = len;
+    ok = cdc_tx_serial_data(len, &uart->tx_buffer[readptr],
+        UART_CDC_TX_TIMEOUT_MS);
+    if (ok != CLD_USB_TRANSMIT_SUCCESSFUL) {
+        uart->tx_inflight = 0;
+        return UART_SIMPLE_TX_ERROR;
+    }
+
+    return UART_SIMPLE_TX_OK;
+}
+
+/* Start a transfer if the port is idle */
+static bool _uart_cdc_txStart(sUART *uart)
+{
+    UART_SIMPLE_INT_RESULT intResult;
+    bool ok = true;
+
+    UART_ENTER_CRITICAL();
+    if (!uart->transmitting) {
+        intResult = _uart_cdc_isr_readFromTXBuffer(uart);
+        if (intResult == UART_SIMPLE_TX_OK) {
+            uart->transmitting = true;
+        } else if (intResult == UART_SIMPLE_TX_ERROR) {
+            ok = false;
+        }
+    }
+    UART_EXIT_CRITICAL();
+
+    return(ok);
+}
 
-    /* Send out the byte */
-    ok = cdc_tx_serial_data(1, c, 10);
+#ifdef FREE_RTOS
+static void _uart_cdc_txFlushTimer(TimerHandle_t xTimer)
+{
+    sUART *uart = (sUART *)pvTimerGetTimerID(xTimer);
+    _uart_cdc_txStart(uart);
+}
+#endif
 
-    /* Return the result */
-    ret = (ok == CLD_USB_TRANSMIT_SUCCESSFUL) ?
-        UART_SIMPLE_TX_OK : UART_SIMPLE_TX_ERROR;
+/*
+ * Apply the flush policy to an idle port: send now once the threshold
+ * is reached, otherwise let the flush timer pick up small writes.
+ */
+static bool _uart_cdc_txFlush(sUART *uart)
+{
+    bool ok = true;
 
-    return ret;
+    if (uart->transmitting) {
+        return(ok);
+    }
+#ifdef FREE_RTOS
+    if (_uart_cdc_txUsed(uart) < UART_CDC_TX_FLUSH_THRESHOLD) {
+        if (xTimerIsTimerActive(uart->txFlushTimer) == pdFALSE) {
+            xTimerStart(uart->txFlushTimer, 0);
+        }
+        return(ok);
+    }
+#endif
+    ok = _uart_cdc_txStart(uart);
+
+    return(ok);
 }
 
 void _uart_cdc_tx_complete(CDC_TX_STATUS status, void *usrPtr)
@@ -150,15 +276,17 @@ void _uart_cdc_tx_complete(CDC_TX_STATUS status, void *usrPtr)
     BaseType_t contextSwitch = pdFALSE;
 #endif
 
-    /* Increment the TX read pointer upon completion */
-    uart->tx_buffer_readptr++;
-    if (uart->tx_buffer_readptr >= UART_BUFFER_SIZE) {
-        uart->tx_buffer_readptr = 0;
-    }
+    /*
+     * Release the completed transfer.  Timed out data is dropped so
+     * writers never block on a host that is not reading.
+     */
+    uart->tx_buffer_readptr = (uart->tx_buffer_readptr + uart->tx_inflight) %
+        UART_CDC_TX_BUFFER_SIZE;
+    uart->tx_inflight = 0;
 
-    /* Send the next chunk and update the transmitting status */
-    result = _uart_cdc_isr_readFromTXBuffer(uart, NULL);
-    if (result == UART_SIMPLE_TX_FIFO_EMPTY) {
+    /* Send everything queued in the meantime */
+    result = _uart_cdc_isr_readFromTXBuffer(uart);
+    if (result != UART_SIMPLE_TX_OK) {
         uart->transmitting = false;
     }
 
@@ -202,24 +330,17 @@ void _uart_cdc_rx_complete(unsigned char *buffer,
 
 }
 
-UART_SIMPLE_RESULT uart_cdc_read(sUART *uart, uint8_t *in, uint8_t *inLen)
+/*
+ * Waits up to the read timeout for receive data, returns false if
+ * there still is none
+ */
+static bool _uart_cdc_rxWait(sUART *uart)
 {
-    UART_SIMPLE_RESULT result = UART_SIMPLE_SUCCESS;
     bool empty;
-    int i;
 
 #ifdef FREE_RTOS
     BaseType_t rtosResult;
-#endif
 
-#ifdef FREE_RTOS
-    rtosResult = xSemaphoreTake(uart->portRxLock, portMAX_DELAY);
-    if (rtosResult != pdTRUE) {
-        result = UART_SIMPLE_ERROR;
-    }
-#endif
-
-#ifdef FREE_RTOS
     UART_ENTER_CRITICAL();
     empty = (uart->rx_buffer_writeptr == uart->rx_buffer_readptr);
     if (empty) {
@@ -244,15 +365,70 @@ UART_SIMPLE_RESULT uart_cdc_read(sUART *uart, uint8_t *in, uint8_t *inLen)
     }
 #endif
 
-    empty = (uart->rx_buffer_writeptr == uart->rx_buffer_readptr);
-    for (i = 0; (i < *inLen) && !empty; i++) {
-        in[i] = uart->rx_buffer[uart->rx_buffer_readptr++];
-        if (uart->rx_buffer_readptr >= UART_BUFFER_SIZE) {
-            uart->rx_buffer_readptr = 0;
+    return(uart->rx_buffer_writeptr != uart->rx_buffer_readptr);
+}
+
+/*
+ * Copies out up to 'len' received bytes a contiguous run at a time
+ * and lets the host send again once there is room for a full packet.
+ * Returns the number of bytes copied.
+ */
+static uint32_t _uart_cdc_rxCopy(sUART *uart, uint8_t *in, uint32_t len)
+{
+    uint32_t copied;
+    uint32_t run;
+    uint16_t writeptr;
+    uint16_t readptr;
+    bool resume;
+
+    copied = 0;
+    writeptr = uart->rx_buffer_writeptr;
+    readptr = uart->rx_buffer_readptr;
+    while ((copied < len) && (readptr != writeptr)) {
+        run = (writeptr > readptr) ? (writeptr - readptr) :
+            (UART_BUFFER_SIZE - readptr);
+        if (run > (len - copied)) {
+            run = len - copied;
         }
-        empty = (uart->rx_buffer_writeptr == uart->rx_buffer_readptr);
+        memcpy(in + copied, &uart->rx_buffer[readptr], run);
+        copied += run;
+        readptr = (readptr + run) % UART_BUFFER_SIZE;
+    }
+    uart->rx_buffer_readptr = readptr;
+
+    UART_ENTER_CRITICAL();
+    resume = uart->rxPaused &&
+        (_uart_cdc_rxFree(uart) >= UART_RX_RESUME_LEVEL);
+    if (resume) {
+        uart->rxPaused = false;
+    }
+    UART_EXIT_CRITICAL();
+    if (resume) {
+        cdc_rx_resume();
     }
 
+    return(copied);
+}
+
+UART_SIMPLE_RESULT uart_cdc_read(sUART *uart, uint8_t *in, uint8_t *inLen)
+{
+    UART_SIMPLE_RESULT result = UART_SIMPLE_SUCCESS;
+    uint32_t len;
+
+#ifdef FREE_RTOS
+    BaseType_t rtosResult;
+#endif
+
+#ifdef FREE_RTOS
+    rtosResult = xSemaphoreTake(uart->portRxLock, portMAX_DELAY);
+    if (rtosResult != pdTRUE) {
+        result = UART_SIMPLE_ERROR;
+    }
+#endif
+
+    _uart_cdc_rxWait(uart);
+    len = _uart_cdc_rxCopy(uart, in, *inLen);
+
 #ifdef FREE_RTOS
     rtosResult = xSemaphoreGive(uart->portRxLock);
     if (rtosResult != pdTRUE) {
@@ -260,21 +436,59 @@ UART_SIMPLE_RESULT uart_cdc_read(sUART *uart, uint8_t *in, uint8_t *inLen)
     }
 #endif
 
-    *inLen = i;
+    *inLen = len;
 
     return(result);
 }
 
+UART_SIMPLE_RESULT uart_cdc_readBuf(sUART *uart, uint8_t *in, uint32_t *inLen)
+{
+    UART_SIMPLE_RESULT result = UART_SIMPLE_SUCCESS;
+    uint32_t len;
+    uint32_t read;
+
+#ifdef FREE_RTOS
+    BaseType_t rtosResult;
+#endif
 
-UART_SIMPLE_RESULT uart_cdc_write(sUART *uart, uint8_t *out, uint8_t *outLen)
+#ifdef FREE_RTOS
+    rtosResult = xSemaphoreTake(uart->portRxLock, portMAX_DELAY);
+    if (rtosResult != pdTRUE) {
+        result = UART_SIMPLE_ERROR;
+    }
+#endif
+
+    /* Keep draining the ring until the buffer is full or data stops */
+    len = *inLen;
+    read = 0;
+    while ((read < len) && _uart_cdc_rxWait(uart)) {
+        read += _uart_cdc_rxCopy(uart, in + read, len - read);
+    }
+
+#ifdef FREE_RTOS
+    rtosResult = xSemaphoreGive(uart->portRxLock);
+    if (rtosResult != pdTRUE) {
+        result = UART_SIMPLE_ERROR;
+    }
+#endif
+
+    *inLen = read;
+
+    return(result);
+}
+
+UART_SIMPLE_RESULT uart_cdc_writeBuf(sUART *uart, const uint8_t *out,
+    uint32_t *outLen)
 {
     UART_SIMPLE_RESULT result = UART_SIMPLE_SUCCESS;
-    UART_SIMPLE_INT_RESULT intResult;
-    int i;
-    bool full;
-    bool goToSleep;
+    uint32_t len;
+    uint32_t written;
+    uint32_t space;
+    uint32_t writeptr;
+    uint32_t run;
     bool transmitting;
 #ifdef FREE_RTOS
+    bool goToSleep;
     BaseType_t rtosResult;
 #endif
 
@@ -285,56 +499,66 @@ UART_SIMPLE_RESULT uart_cdc_write(sUART *uart, uint8_t *out, uint8_t *outLen)
     }
 #endif
 
-    for (i = 0; i < *outLen; i++) {
+    len = *outLen;
+    written = 0;
+
+    while (written < len) {
 
-#ifdef FREE_RTOS
         UART_ENTER_CRITICAL();
-        full = ((uart->tx_buffer_writeptr+1) % UART_BUFFER_SIZE) == uart->tx_buffer_readptr;
+        space = _uart_cdc_txFree(uart);
         transmitting = uart->transmitting;
-        goToSleep = full & transmitting;
+#ifdef FREE_RTOS
+        goToSleep = (space == 0) && transmitting;
         if (goToSleep) {
             uart->txSleeping = true;
         }
+#endif
         UART_EXIT_CRITICAL();
-        if (goToSleep) {
-            rtosResult = xSemaphoreTake(uart->portTxBlock, portMAX_DELAY);
-            if (rtosResult != pdTRUE) {
-                result = UART_SIMPLE_ERROR;
+
+        if (space == 0) {
+            /* Full and idle means the host is not taking data */
+            if (!transmitting) {
+                if (!_uart_cdc_txStart(uart)) {
+                    break;
+                }
             }
-        } else {
-            if (full & !transmitting) {
-                break;
+#ifdef FREE_RTOS
+            if (goToSleep) {
+                rtosResult = xSemaphoreTake(uart->portTxBlock, portMAX_DELAY);
+                if (rtosResult != pdTRUE) {
+                    result = UART_SIMPLE_ERROR;
+                }
             }
-        }
-#else
-        do {
-            full = ((uart->tx_buffer_writeptr+1) % UART_BUFFER_SIZE) == uart->tx_buffer_readptr;
-        } while (full);
 #endif
+            continue;
+        }
 
-        uart->tx_buffer[uart->tx_buffer_writeptr++] = out[i];
+        /* Copy in the largest contiguous run that fits */
+        writeptr = uart->tx_buffer_writeptr;
+        run = UART_CDC_TX_BUFFER_SIZE - writeptr;
+        if (run > space) {
+            run = space;
+        }
+        if (run > (len - written)) {
+            run = len - written;
+        }
+        memcpy(&uart->tx_buffer[writeptr], out + written, run);
+        uart->tx_buffer_writeptr = (writeptr + run) % UART_CDC_TX_BUFFER_SIZE;
+        written += run;
 
-        if (uart->tx_buffer_writeptr >= UART_BUFFER_SIZE) {
-            uart->tx_buffer_writeptr = 0;
+        /* Stream large writes out while the rest is copied in */
+        if (_uart_cdc_txUsed(uart) >= UART_CDC_TX_FLUSH_THRESHOLD) {
+            _uart_cdc_txStart(uart);
         }
     }
 
     /* Report back the bytes written */
-    *outLen = i;
+    *outLen = written;
 
-    /*
-     * Kick off a write if needed
-     */
-     UART_ENTER_CRITICAL();
-     if (!uart->transmitting) {
-        intResult = _uart_cdc_isr_readFromTXBuffer(uart, NULL);
-        if (intResult == UART_SIMPLE_TX_OK) {
-            uart->transmitting = true;
-        } else {
-            result = UART_SIMPLE_ERROR;
-        }
-     }
-     UART_EXIT_CRITICAL();
+    /* Kick off a write if needed */
+    if (!_uart_cdc_txFlush(uart)) {
+        result = UART_SIMPLE_ERROR;
+    }
 
 #ifdef FREE_RTOS
     rtosResult = xSemaphoreGive(uart->portTxLock);
@@ -346,6 +570,17 @@ UART_SIMPLE_RESULT uart_cdc_write(sUART *uart, uint8_t *out, uint8_t *outLen)
     return(result);
 }
 
+UART_SIMPLE_RESULT uart_cdc_write(sUART *uart, uint8_t *out, uint8_t *outLen)
+{
+    UART_SIMPLE_RESULT result;
+    uint32_t len = *outLen;
+
+    result = uart_cdc_writeBuf(uart, out, &len);
+    *outLen = len;
+
+    return(result);
+}
+
 UART_SIMPLE_RESULT uart_cdc_setProtocol(sUART *uartHandle,
     UART_SIMPLE_SPEED speed, UART_SIMPLE_WORD_LENGTH length,
     UART_SIMPLE_PARITY parity, UART_SIMPLE_STOP_BITS stop)
@@ -437,14 +672,16 @@ UART_SIMPLE_RESULT uart_cdc_open(UART_SIMPLE_PORT port, sUART **uartHandle)
 
         cdc_register_tx_callback(_uart_cdc_tx_complete, uart);
         cdc_register_rx_callback(_uart_cdc_rx_complete, uart);
+        cdc_register_rx_space_callback(_uart_cdc_rx_space);
 
         memset(uart->rx_buffer, 0, sizeof(uart->rx_buffer));
         uart->rx_buffer_readptr = 0;
         uart->rx_buffer_writeptr = 0;
+        uart->rxPaused = false;
 
-        memset(uart->tx_buffer, 0, sizeof(uart->tx_buffer));
         uart->tx_buffer_readptr = 0;
         uart->tx_buffer_writeptr = 0;
+        uart->tx_inflight = 0;
 
         uart->readTimeout = UART_SIMPLE_TIMEOUT_INF;
         uart->writeTimeout = UART_SIMPLE_TIMEOUT_INF;
@@ -496,6 +733,7 @@ UART_SIMPLE_RESULT uart_cdc_close(sUART **uartHandle)
 
     cdc_register_tx_callback(NULL, NULL);
     cdc_register_rx_callback(NULL, NULL);
+    cdc_register_rx_space_callback(NULL);
 
     *uartHandle = NULL;
 
@@ -551,6 +789,14 @@ UART_SIMPLE_RESULT uart_cdc_init(void)
         if (uart->portTxBlock == NULL) {
             result = UART_SIMPLE_ERROR;
         }
+
+        uart->txFlushTimer = xTimerCreate("cdcTxFlush",
+            pdMS_TO_TICKS(UART_CDC_TX_FLUSH_MS) ?
+                pdMS_TO_TICKS(UART_CDC_TX_FLUSH_MS) : 1,
+            pdFALSE, uart, _uart_cdc_txFlushTimer);
+        if (uart->txFlushTimer == NULL) {
+            result = UART_SIMPLE_ERROR;
+        }
 #endif
         uart->open = false;
 
@@ -573,6 +819,11 @@ UART_SIMPLE_RESULT uart_cdc_deinit(void)
         uart = &uartContext[port];
 
 #ifdef FREE_RTOS
+        if (uart->txFlushTimer) {
+            xTimerDelete(uart->txFlushTimer, portMAX_DELAY);
+            uart->txFlushTimer = NULL;
+        }
+
         if (uart->portRxBlock) {
             vSemaphoreDelete(uart->portRxBlock);
             uart->portRxBlock = NULL;
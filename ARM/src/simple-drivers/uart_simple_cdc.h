@@ -184,6 +184,26 @@ UART_SIMPLE_RESULT uart_cdc_setTimeouts(sUART *uartHandle,
 UART_SIMPLE_RESULT uart_cdc_read(sUART *uartHandle, uint8_t *in,
     uint8_t *inLen);
 
+/*!****************************************************************
+ * @brief Simple UART large buffer read.
+ *
+ * Same as uart_cdc_read() but without the 255 byte limit.  Reads
+ * larger than what has been received keep waiting, up to the read
+ * timeout each time, until the buffer is full or the data stops.
+ *
+ * This function is thread safe.
+ *
+ * @param [in]     uartHandle  A handle to a UART port
+ * @param [out]    in          Pointer to buffer to receive data
+ * @param [in,out] inLen       Number of bytes to read (in).
+ *                             Number of bytes actually read (out)
+ *
+ * @return Returns UART_SIMPLE_SUCCESS if successful, otherwise
+ *         an error.
+ ******************************************************************/
+UART_SIMPLE_RESULT uart_cdc_readBuf(sUART *uartHandle, uint8_t *in,
+    uint32_t *inLen);
+
 /*!****************************************************************
  * @brief Simple UART write.
  *
@@ -207,6 +227,27 @@ UART_SIMPLE_RESULT uart_cdc_read(sUART *uartHandle, uint8_t *in,
 UART_SIMPLE_RESULT uart_cdc_write(sUART *uartHandle, uint8_t *out,
     uint8_t *outLen);
 
+/*!****************************************************************
+ * @brief Simple UART large buffer write.
+ *
+ * Same as uart_cdc_write() but without the 255 byte limit.  The data
+ * is coalesced into the transmit ring and streamed to the host in
+ * large bulk transfers.  Writes larger than the ring block until
+ * enough has been sent.
+ *
+ * This function is thread safe.
+ *
+ * @param [in] uartHandle  A handle to a UART port
+ * @param [in] out         Pointer to buffer containing write data
+ * @param [in,out] outLen  Number of bytes to write (in).
+ *                         Number of bytes actually written (out)
+ *
+ * @return Returns UART_SIMPLE_SUCCESS if successful, otherwise
+ *         an error.
+ ******************************************************************/
+UART_SIMPLE_RESULT uart_cdc_writeBuf(sUART *uartHandle, const uint8_t *out,
+    uint32_t *outLen);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -52,30 +52,52 @@ static int uart_stdio_dev_close(int fh)
     return(0);
 }
 
-static int uart_stdio_dev_write(int fh, unsigned char *ptr, int len)
+/*
+ * Write a run of bytes straight from the caller's buffer.  The CDC
+ * driver takes the whole run at once, the hardware UART 255 bytes
+ * at a time.
+ */
+static void uart_stdio_write_run(unsigned char *ptr, unsigned len)
 {
-    UART_SIMPLE_RESULT uartResult;
-    unsigned char buf[20];
+#ifdef USB_CDC_STDIO
+    uint32_t l = len;
+    uart_cdc_writeBuf(stdioUartHandle, ptr, &l);
+#else
     uint8_t b;
+    while (len) {
+        b = (len > 255) ? 255 : len;
+        uart_write(stdioUartHandle, ptr, &b);
+        if (b == 0) {
+            break;
+        }
+        ptr += b; len -= b;
+    }
+#endif
+}
+
+static int uart_stdio_dev_write(int fh, unsigned char *ptr, int len)
+{
+    static unsigned char crlf[] = { '\r', '\n' };
+    int start;
     int i;
 
     if (!stdioUartHandle) {
         return(-1);
     }
 
-    b = 0;
+    /* Send everything between newlines in one go */
+    start = 0;
     for (i = 0; i < len; i++) {
         if (ptr[i] == '\n') {
-            buf[b++] = '\r';
-        }
-        buf[b++] = *(ptr+i);
-        if (b >= 16) {
-            uartResult = uart_write(stdioUartHandle, buf, &b);
-            b = 0;
+            if (i > start) {
+                uart_stdio_write_run(ptr + start, i - start);
+            }
+            uart_stdio_write_run(crlf, sizeof(crlf));
+            start = i + 1;
         }
     }
-    if (b) {
-        uartResult = uart_write(stdioUartHandle, buf, &b);
+    if (len > start) {
+        uart_stdio_write_run(ptr + start, len - start);
     }
 
 #if defined(__ADSPARM__)
@@ -11,6 +11,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <runtime/int/interrupt.h>
 
@@ -33,6 +34,33 @@ static uint32_t cyclesTotal = 0;
 static uint32_t cpuLoad = 0;
 static uint32_t maxCpuLoad = 0;
 
+/* Per-source accounting */
+typedef struct CPU_LOAD_SOURCE {
+    void *handle;
+    char name[CPU_LOAD_NAME_LEN];
+    uint32_t cycles;
+    uint32_t load;
+    uint32_t avgLoad;
+    uint32_t maxLoad;
+} CPU_LOAD_SOURCE;
+
+static CPU_LOAD_SOURCE isrSources[CPU_LOAD_MAX_ISRS];
+static CPU_LOAD_SOURCE taskSources[CPU_LOAD_MAX_TASKS];
+static unsigned numIsrSources = 0;
+static CPU_LOAD_SOURCE *curTask = NULL;
+static uint32_t curTaskInCycles = 0;
+static uint32_t curTaskIsrCycles = 0;
+
+/* Recently completed ISRs, most recent on top */
+typedef struct CPU_LOAD_ISR_DONE {
+    uint32_t end;
+    uint32_t cycles;
+} CPU_LOAD_ISR_DONE;
+
+static CPU_LOAD_ISR_DONE isrDone[CPU_LOAD_ISR_NESTING];
+static unsigned isrDoneTop = 0;
+static unsigned isrDoneCount = 0;
+
 void cpuLoadInit(CPU_LOAD_GET_TIME _getTime, uint32_t _ticksPerSecond)
 {
     /* Get the idle task handle */
@@ -50,10 +78,58 @@ void cpuLoadBackgroundTask(void *taskHandle)
     backgroundTaskHandle = (TaskHandle_t)taskHandle;
 }
 
+static CPU_LOAD_SOURCE *findTask(void *taskHandle)
+{
+    CPU_LOAD_SOURCE *slot = NULL;
+    unsigned i;
+
+    for (i = 0; i < CPU_LOAD_MAX_TASKS; i++) {
+        if (taskSources[i].handle == taskHandle) {
+            return(&taskSources[i]);
+        }
+        if ((slot == NULL) && (taskSources[i].handle == NULL)) {
+            slot = &taskSources[i];
+        }
+    }
+
+    if (slot) {
+        memset(slot, 0, sizeof(*slot));
+        strncpy(slot->name, pcTaskGetName((TaskHandle_t)taskHandle),
+            sizeof(slot->name) - 1);
+        slot->handle = taskHandle;
+    }
+
+    return(slot);
+}
+
+/*
+ * Charge the outgoing task with the time since it was switched in,
+ * less any ISR time reported while it was running.
+ */
+static void taskRunTime(void *taskHandle)
+{
+    uint32_t now, run;
+
+    now = getTime();
+    if (curTask) {
+        run = now - curTaskInCycles;
+        curTask->cycles += (run > curTaskIsrCycles) ? run - curTaskIsrCycles : 0;
+    }
+    curTaskInCycles = now;
+    curTaskIsrCycles = 0;
+    curTask = taskHandle ? findTask(taskHandle) : NULL;
+}
+
 void cpuLoadtaskSwitchHook(void *taskHandle)
 {
     static uint32_t idleInCycles;
 
+    if (getTime == NULL) {
+        return;
+    }
+
+    taskRunTime(taskHandle);
+
     if ( (taskHandle == idleTaskHandle) ||
          (taskHandle == backgroundTaskHandle) ) {
         idleInCycles = getTime();
@@ -66,17 +142,136 @@ void cpuLoadtaskSwitchHook(void *taskHandle)
     }
 }
 
-void cpuLoadIsrCycles(uint32_t isrCycles)
+void cpuLoadtaskDeleteHook(void *taskHandle)
+{
+    unsigned i;
+
+    for (i = 0; i < CPU_LOAD_MAX_TASKS; i++) {
+        if (taskSources[i].handle == taskHandle) {
+            if (curTask == &taskSources[i]) {
+                curTask = NULL;
+            }
+            taskSources[i].handle = NULL;
+            break;
+        }
+    }
+}
+
+/*
+ * Nested ISRs report before the ISR they interrupted, and that ISR's
+ * gross time includes theirs.  Any completed ISR that ended after this
+ * one started was nested in it, so its gross time is taken out here
+ * and this one's gross time is kept for whatever it interrupted in
+ * turn.  Entries that are not nested in anything stay below the top
+ * until they are pushed out or cleared by cpuLoadCalculateLoad().
+ */
+static uint32_t isrNetCycles(uint32_t isrCycles)
+{
+    UBaseType_t state;
+    uint32_t now, start, net;
+
+    if (getTime == NULL) {
+        return(isrCycles);
+    }
+
+    state = taskENTER_CRITICAL_FROM_ISR();
+
+    now = getTime();
+    start = now - isrCycles;
+    net = isrCycles;
+    while (isrDoneCount &&
+           ((int32_t)(isrDone[isrDoneTop].end - start) >= 0)) {
+        net = (net > isrDone[isrDoneTop].cycles) ?
+            net - isrDone[isrDoneTop].cycles : 0;
+        isrDoneTop = (isrDoneTop + CPU_LOAD_ISR_NESTING - 1) %
+            CPU_LOAD_ISR_NESTING;
+        isrDoneCount--;
+    }
+
+    isrDoneTop = (isrDoneTop + 1) % CPU_LOAD_ISR_NESTING;
+    isrDone[isrDoneTop].end = now;
+    isrDone[isrDoneTop].cycles = isrCycles;
+    if (isrDoneCount < CPU_LOAD_ISR_NESTING) {
+        isrDoneCount++;
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(state);
+
+    return(net);
+}
+
+static void isrCharge(uint32_t isrCycles)
 {
     /* Only accumulate ISR cycles in the idle task */
     if (inIdleTask) {
         isrCyclesTotal += isrCycles;
     }
+
+    /* Don't charge the interrupted task */
+    curTaskIsrCycles += isrCycles;
+}
+
+void cpuLoadIsrCycles(uint32_t isrCycles)
+{
+    isrCharge(isrNetCycles(isrCycles));
+}
+
+int cpuLoadRegisterIsr(const char *name)
+{
+    UBaseType_t state;
+    int id = CPU_LOAD_ISR_ID_NONE;
+    unsigned i;
+
+    state = taskENTER_CRITICAL_FROM_ISR();
+
+    for (i = 0; i < numIsrSources; i++) {
+        if (strcmp(isrSources[i].name, name) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if ((id == CPU_LOAD_ISR_ID_NONE) && (numIsrSources < CPU_LOAD_MAX_ISRS)) {
+        id = numIsrSources;
+        strncpy(isrSources[id].name, name, sizeof(isrSources[id].name) - 1);
+        numIsrSources++;
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(state);
+
+    return(id);
+}
+
+void cpuLoadIsrSourceCycles(int *id, const char *name, uint32_t isrCycles)
+{
+    if (*id == CPU_LOAD_ISR_ID_NONE) {
+        *id = cpuLoadRegisterIsr(name);
+    }
+    isrCycles = isrNetCycles(isrCycles);
+    if ((*id >= 0) && (*id < (int)numIsrSources)) {
+        isrSources[*id].cycles += isrCycles;
+    }
+    isrCharge(isrCycles);
+}
+
+/*
+ * Convert the cycles accumulated by a source over the last window
+ * into a load in tenths of a percent and update its statistics.
+ */
+static void sourceLoad(CPU_LOAD_SOURCE *src, uint32_t windowCycles)
+{
+    src->load = (uint32_t)((1000ULL * src->cycles) / windowCycles);
+    src->avgLoad = src->avgLoad +
+        ((int32_t)(src->load - src->avgLoad) >> CPU_LOAD_AVG_SHIFT);
+    if (src->load > src->maxLoad) {
+        src->maxLoad = src->load;
+    }
+    src->cycles = 0;
 }
 
 uint32_t cpuLoadCalculateLoad(uint32_t *maxLoad)
 {
     uint32_t now;
+    unsigned i;
 
     taskENTER_CRITICAL();
 
@@ -95,9 +290,23 @@ uint32_t cpuLoadCalculateLoad(uint32_t *maxLoad)
         maxCpuLoad = cpuLoad;
     }
 
-    /* Reset all counters */
+    /* Charge the running task up to now and compute per-source loads */
+    taskRunTime(curTask ? curTask->handle : NULL);
+    for (i = 0; i < CPU_LOAD_MAX_TASKS; i++) {
+        if (taskSources[i].handle) {
+            sourceLoad(&taskSources[i], cyclesTotal);
+        }
+    }
+    for (i = 0; i < numIsrSources; i++) {
+        sourceLoad(&isrSources[i], cyclesTotal);
+    }
+
+    /* Reset all counters.  No ISR is running at task level, so none of
+     * the completed ones can be nested in a later one.
+     */
     idleCyclesTotal = 0;
     isrCyclesTotal = 0;
+    isrDoneCount = 0;
     lastCycles = now;
 
     taskEXIT_CRITICAL();
@@ -121,6 +330,40 @@ uint32_t cpuLoadGetLoad(uint32_t *maxLoad, bool clearMax)
     return(cpuLoad);
 }
 
+static void sourceStats(CPU_LOAD_STATS *stats, CPU_LOAD_SOURCE *src,
+    bool isr, bool clearMax)
+{
+    memcpy(stats->name, src->name, sizeof(stats->name));
+    stats->isr = isr;
+    stats->load = src->load;
+    stats->avgLoad = src->avgLoad;
+    stats->maxLoad = src->maxLoad;
+    if (clearMax) {
+        src->maxLoad = src->load;
+    }
+}
+
+unsigned cpuLoadGetStats(CPU_LOAD_STATS *stats, unsigned max, bool clearMax)
+{
+    unsigned n = 0;
+    unsigned i;
+
+    taskENTER_CRITICAL();
+
+    for (i = 0; (i < CPU_LOAD_MAX_TASKS) && (n < max); i++) {
+        if (taskSources[i].handle) {
+            sourceStats(&stats[n++], &taskSources[i], false, clearMax);
+        }
+    }
+    for (i = 0; (i < numIsrSources) && (n < max); i++) {
+        sourceStats(&stats[n++], &isrSources[i], true, clearMax);
+    }
+
+    taskEXIT_CRITICAL();
+
+    return(n);
+}
+
 uint32_t cpuLoadGetTimeStamp(void)
 {
     return(getTime());
@@ -13,7 +13,9 @@
  * @brief  A crude FreeRTOS CPU load tracker
  *
  * This module tracks a rough estimate of the CPU load of a FreeRTOS
- * project.
+ * project.  It also breaks the load down per task (from the task
+ * switch hook) and per registered interrupt source.  Time spent in
+ * reported ISRs is not charged to the interrupted task.
  *
  * @file      cpu_load.h
  * @version   1.0.0
@@ -27,6 +29,61 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/*!****************************************************************
+ * @brief  Max number of tasks tracked individually
+ ******************************************************************/
+#ifndef CPU_LOAD_MAX_TASKS
+#define CPU_LOAD_MAX_TASKS     (24)
+#endif
+
+/*!****************************************************************
+ * @brief  Max number of registered interrupt sources
+ ******************************************************************/
+#ifndef CPU_LOAD_MAX_ISRS
+#define CPU_LOAD_MAX_ISRS      (16)
+#endif
+
+/*!****************************************************************
+ * @brief  Max length of a task or interrupt source name
+ ******************************************************************/
+#ifndef CPU_LOAD_NAME_LEN
+#define CPU_LOAD_NAME_LEN      (16)
+#endif
+
+/*!****************************************************************
+ * @brief  Per-source average weight (avg += (load - avg) >> shift)
+ ******************************************************************/
+#ifndef CPU_LOAD_AVG_SHIFT
+#define CPU_LOAD_AVG_SHIFT     (3)
+#endif
+
+/*!****************************************************************
+ * @brief  Max depth of nested ISRs whose time is taken out of the
+ *         ISR they interrupted
+ ******************************************************************/
+#ifndef CPU_LOAD_ISR_NESTING
+#define CPU_LOAD_ISR_NESTING   (8)
+#endif
+
+/*!****************************************************************
+ * @brief  Unregistered interrupt source ID
+ ******************************************************************/
+#define CPU_LOAD_ISR_ID_NONE   (-1)
+
+/*!****************************************************************
+ * @brief  Per-source CPU load statistics
+ *
+ * Loads are in tenths of a percent over the last
+ * cpuLoadCalculateLoad() window.
+ ******************************************************************/
+typedef struct CPU_LOAD_STATS {
+    char name[CPU_LOAD_NAME_LEN];
+    bool isr;
+    uint32_t load;
+    uint32_t avgLoad;
+    uint32_t maxLoad;
+} CPU_LOAD_STATS;
+
 /*!****************************************************************
  * @brief  Function called to track time
  *
@@ -77,12 +134,51 @@ void cpuLoadtaskSwitchHook(void *taskHandle);
  *
  * The cycles passed in through 'isrCycles' must be the same unit of
  * measure as the CPU_LOAD_GET_TIME routine passed into cpuLoadInit().
+ * They are the ISR's gross time from entry to this call; the time of
+ * any ISR that nested inside it and reported first is taken out so
+ * it is only counted once.
  *
  * @param [in]  isrCycles  Task handle as given by the FreeRTOS task
  *                          switch hook.
  ******************************************************************/
 void cpuLoadIsrCycles(uint32_t isrCycles);
 
+/*!****************************************************************
+ * @brief  FreeRTOS task delete hook
+ *
+ * This function must be called from the FreeRTOS traceTASK_DELETE
+ * hook so the task's accounting slot can be reused.
+ *
+ * @param [in]  taskHandle  Handle of the task being deleted
+ ******************************************************************/
+void cpuLoadtaskDeleteHook(void *taskHandle);
+
+/*!****************************************************************
+ * @brief  Registers a named interrupt source
+ *
+ * Registering the same name again returns the same ID.  This
+ * function is safe to call from an ISR.
+ *
+ * @param [in]  name  Interrupt source name
+ *
+ * @return  Source ID or CPU_LOAD_ISR_ID_NONE if the table is full
+ ******************************************************************/
+int cpuLoadRegisterIsr(const char *name);
+
+/*!****************************************************************
+ * @brief  Accumulates CPU cycles for an interrupt source
+ *
+ * Same as cpuLoadIsrCycles() but also charges the cycles to the
+ * given source.  If '*id' is CPU_LOAD_ISR_ID_NONE the source is
+ * registered under 'name' first and '*id' updated, so ISRs can keep
+ * their ID in a static initialized to CPU_LOAD_ISR_ID_NONE.
+ *
+ * @param [in,out]  id         Source ID
+ * @param [in]      name       Source name used for registration
+ * @param [in]      isrCycles  Cycles spent in the ISR
+ ******************************************************************/
+void cpuLoadIsrSourceCycles(int *id, const char *name, uint32_t isrCycles);
+
 /*!****************************************************************
  * @brief  Assign a background task
  *
@@ -117,6 +213,19 @@ uint32_t cpuLoadCalculateLoad(uint32_t *maxLoad);
  ******************************************************************/
 uint32_t cpuLoadGetLoad(uint32_t *maxLoad, bool clearMax);
 
+/*!****************************************************************
+ * @brief  Return the per-task and per-interrupt source loads
+ *
+ * Tasks are reported first followed by interrupt sources.
+ *
+ * @param [out]  stats     Array to fill in
+ * @param [in]   max       Number of entries in 'stats'
+ * @param [in]   clearMax  Clear the max loads
+ *
+ * @return  Number of entries filled in
+ ******************************************************************/
+unsigned cpuLoadGetStats(CPU_LOAD_STATS *stats, unsigned max, bool clearMax);
+
 /*!****************************************************************
  * @brief  Return a CPU timestamp suitable for use in
  *         cpuLoadIsrCycles()
@@ -0,0 +1,392 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "a2b_bin_cfg.h"
+#include "a2b_bin.h"
+#include "adi_a2b_commandlist.h"
+#include "crc32.h"
+
+#ifdef A2B_BIN_USE_SYSLOG
+#include "syslog.h"
+#endif
+
+/*!****************************************************************
+ * @brief  The size of the file hashing buffer.
+ ******************************************************************/
+#ifndef A2B_BIN_BUFSIZE
+#define A2B_BIN_BUFSIZE       1024
+#endif
+
+/*!****************************************************************
+ * @brief  The largest binary payload accepted by a2b_bin_load().
+ ******************************************************************/
+#ifndef A2B_BIN_MAX_SIZE
+#define A2B_BIN_MAX_SIZE      (256 * 1024)
+#endif
+
+/*!****************************************************************
+ * @brief  The function used to allocate memory for the module.
+ *
+ * This defaults to the standard C library malloc if not defined.
+ ******************************************************************/
+#ifndef A2B_BIN_MALLOC
+#define A2B_BIN_MALLOC        malloc
+#endif
+
+/*!****************************************************************
+ * @brief  The function used to free memory for the module.
+ *
+ * This defaults to the standard C library free if not defined
+ ******************************************************************/
+#ifndef A2B_BIN_FREE
+#define A2B_BIN_FREE          free
+#endif
+
+/*****************************************************************************
+ * Little endian field access
+ ****************************************************************************/
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v; p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return((uint16_t)(p[0] | (p[1] << 8)));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+        ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/*****************************************************************************
+ * cmdToSpi() / spiToCmd()
+ *
+ * Both command list types are handled in the A2B_CMD_SPI superset.
+ ****************************************************************************/
+static void cmdToSpi(const void *cfg, uint32_t i, A2B_CMD_TYPE type,
+    A2B_CMD_SPI *spi)
+{
+    const A2B_CMD *cmd;
+
+    if (type == A2B_CMD_TYPE_I2C) {
+        cmd = (const A2B_CMD *)cfg + i;
+        memset(spi, 0, sizeof(*spi));
+        spi->nDeviceAddr = cmd->nDeviceAddr;
+        spi->eOpCode = cmd->eOpCode;
+        spi->nAddrWidth = cmd->nAddrWidth;
+        spi->nAddr = cmd->nAddr;
+        spi->nDataWidth = cmd->nDataWidth;
+        spi->nDataCount = cmd->nDataCount;
+        spi->paConfigData = cmd->paConfigData;
+        spi->eProtocol = A2B_CMD_PROTO_I2C;
+    } else {
+        *spi = *((const A2B_CMD_SPI *)cfg + i);
+    }
+}
+
+static void spiToCmd(const A2B_CMD_SPI *spi, void *cfg, uint32_t i,
+    A2B_CMD_TYPE type)
+{
+    A2B_CMD *cmd;
+
+    if (type == A2B_CMD_TYPE_I2C) {
+        cmd = (A2B_CMD *)cfg + i;
+        cmd->nDeviceAddr = spi->nDeviceAddr;
+        cmd->eOpCode = spi->eOpCode;
+        cmd->nAddrWidth = spi->nAddrWidth;
+        cmd->nAddr = spi->nAddr;
+        cmd->nDataWidth = spi->nDataWidth;
+        cmd->nDataCount = spi->nDataCount;
+        cmd->paConfigData = spi->paConfigData;
+    } else {
+        *((A2B_CMD_SPI *)cfg + i) = *spi;
+    }
+}
+
+static uint32_t cmdSize(A2B_CMD_TYPE type)
+{
+    if (type == A2B_CMD_TYPE_I2C) {
+        return(sizeof(A2B_CMD));
+    } else if (type == A2B_CMD_TYPE_SPI) {
+        return(sizeof(A2B_CMD_SPI));
+    }
+    return(0);
+}
+
+/*****************************************************************************
+ * a2b_bin_file_hash()
+ ****************************************************************************/
+bool a2b_bin_file_hash(const char *filename, uint32_t *hash)
+{
+    FILE *handle;
+    uint8_t *buf;
+    uint32_t crc;
+    size_t len;
+
+    handle = fopen(filename, "rb");
+    if (!handle) {
+        return(false);
+    }
+
+    buf = A2B_BIN_MALLOC(A2B_BIN_BUFSIZE);
+    if (buf == NULL) {
+        fclose(handle);
+        return(false);
+    }
+
+    crc = 0;
+    while ((len = fread(buf, 1, A2B_BIN_BUFSIZE, handle)) > 0) {
+        crc = crc32_x(buf, len, crc);
+    }
+
+    A2B_BIN_FREE(buf);
+    fclose(handle);
+
+    /* Keep zero free for A2B_BIN_ANY_XML */
+    *hash = crc ? crc : 1;
+
+    return(true);
+}
+
+/*****************************************************************************
+ * a2b_bin_name()
+ ****************************************************************************/
+void a2b_bin_name(const char *xmlName, char *binName, unsigned size)
+{
+    unsigned len;
+
+    if (size == 0) {
+        return;
+    }
+
+    len = strlen(xmlName);
+    if ((len >= 4) && ((strcmp(xmlName + len - 4, ".xml") == 0) ||
+                       (strcmp(xmlName + len - 4, ".XML") == 0))) {
+        len -= 4;
+    }
+    if (len + 5 > size) {
+        binName[0] = '\0';
+        return;
+    }
+
+    memcpy(binName, xmlName, len);
+    strcpy(binName + len, ".a2b");
+}
+
+/*****************************************************************************
+ * a2b_bin_save()
+ ****************************************************************************/
+bool a2b_bin_save(const char *filename, uint32_t xmlHash,
+    const void *cfg, uint32_t cfgLen, A2B_CMD_TYPE type)
+{
+    uint8_t header[A2B_BIN_HEADER_SIZE];
+    uint32_t numCmds, payloadLen, i;
+    uint8_t *payload, *p;
+    A2B_CMD_SPI spi;
+    FILE *handle;
+    bool ok;
+
+    if ((cfg == NULL) || (cmdSize(type) == 0)) {
+        return(false);
+    }
+    numCmds = cfgLen / cmdSize(type);
+
+    /* Size and fill the payload */
+    payloadLen = 0;
+    for (i = 0; i < numCmds; i++) {
+        cmdToSpi(cfg, i, type, &spi);
+        payloadLen += A2B_BIN_RECORD_SIZE;
+        if (spi.paConfigData) {
+            payloadLen += spi.nDataCount;
+        }
+    }
+
+    payload = A2B_BIN_MALLOC(payloadLen ? payloadLen : 1);
+    if (payload == NULL) {
+        return(false);
+    }
+
+    p = payload;
+    for (i = 0; i < numCmds; i++) {
+        cmdToSpi(cfg, i, type, &spi);
+        if (spi.paConfigData == NULL) {
+            spi.nDataCount = 0;
+        }
+        p[0] = spi.nDeviceAddr;
+        p[1] = spi.eOpCode;
+        p[2] = spi.nAddrWidth;
+        p[3] = spi.nDataWidth;
+        put32(p + 4, spi.nAddr);
+        put16(p + 8, spi.nDataCount);
+        p[10] = spi.eProtocol;
+        p[11] = spi.nSpiCmdWidth;
+        put32(p + 12, spi.nSpiCmd);
+        p += A2B_BIN_RECORD_SIZE;
+        if (spi.nDataCount) {
+            memcpy(p, spi.paConfigData, spi.nDataCount);
+            p += spi.nDataCount;
+        }
+    }
+
+    memset(header, 0, sizeof(header));
+    put32(header + 0, A2B_BIN_MAGIC);
+    put16(header + 4, A2B_BIN_VERSION);
+    header[6] = type;
+    put32(header + 8, xmlHash);
+    put32(header + 12, numCmds);
+    put32(header + 16, payloadLen);
+    put32(header + 20, crc32(payload, payloadLen));
+    put32(header + 28, crc32(header, 28));
+
+    ok = false;
+    handle = fopen(filename, "wb");
+    if (handle) {
+        ok = (fwrite(header, 1, sizeof(header), handle) == sizeof(header)) &&
+             (fwrite(payload, 1, payloadLen, handle) == payloadLen);
+        ok = (fclose(handle) == 0) && ok;
+    }
+
+    A2B_BIN_FREE(payload);
+
+#ifdef A2B_BIN_USE_SYSLOG
+    if (!ok) {
+        syslog_printf("Unable to write \"%s\" A2B binary", filename);
+    }
+#endif
+
+    return(ok);
+}
+
+/*****************************************************************************
+ * a2b_bin_load()
+ *
+ * The command array and the payload share one allocation.  The payload
+ * is read straight into the tail of it and the commands point into the
+ * payload for their data.
+ ****************************************************************************/
+uint32_t a2b_bin_load(const char *filename, uint32_t xmlHash,
+    void **c, A2B_CMD_TYPE *type)
+{
+    uint8_t header[A2B_BIN_HEADER_SIZE];
+    uint32_t numCmds, payloadLen, cfgLen, i;
+    A2B_CMD_TYPE cfgType;
+    uint8_t *payload, *p, *end;
+    A2B_CMD_SPI spi;
+    FILE *handle;
+    void *cfg;
+
+    *c = NULL;
+
+    handle = fopen(filename, "rb");
+    if (!handle) {
+        return(0);
+    }
+
+    /* Validate the header */
+    if (fread(header, 1, sizeof(header), handle) != sizeof(header)) {
+        goto abort;
+    }
+    if ((get32(header + 0) != A2B_BIN_MAGIC) ||
+        (get16(header + 4) != A2B_BIN_VERSION) ||
+        (get32(header + 28) != crc32(header, 28))) {
+        goto abort;
+    }
+    if ((xmlHash != A2B_BIN_ANY_XML) && (get32(header + 8) != xmlHash)) {
+        goto abort;
+    }
+    cfgType = header[6];
+    numCmds = get32(header + 12);
+    payloadLen = get32(header + 16);
+    if ((cmdSize(cfgType) == 0) || (payloadLen > A2B_BIN_MAX_SIZE) ||
+        (numCmds > payloadLen / A2B_BIN_RECORD_SIZE)) {
+        goto abort;
+    }
+
+    /* Read the payload in one go */
+    cfgLen = numCmds * cmdSize(cfgType);
+    cfg = A2B_BIN_MALLOC(cfgLen + payloadLen);
+    if (cfg == NULL) {
+        goto abort;
+    }
+    payload = (uint8_t *)cfg + cfgLen;
+    if ((fread(payload, 1, payloadLen, handle) != payloadLen) ||
+        (crc32(payload, payloadLen) != get32(header + 20))) {
+        A2B_BIN_FREE(cfg);
+        goto abort;
+    }
+    fclose(handle);
+
+    /* Build the command list */
+    p = payload;
+    end = payload + payloadLen;
+    for (i = 0; i < numCmds; i++) {
+        if (p + A2B_BIN_RECORD_SIZE > end) {
+            break;
+        }
+        memset(&spi, 0, sizeof(spi));
+        spi.nDeviceAddr = p[0];
+        spi.eOpCode = p[1];
+        spi.nAddrWidth = p[2];
+        spi.nDataWidth = p[3];
+        spi.nAddr = get32(p + 4);
+        spi.nDataCount = get16(p + 8);
+        spi.eProtocol = p[10];
+        spi.nSpiCmdWidth = p[11];
+        spi.nSpiCmd = get32(p + 12);
+        p += A2B_BIN_RECORD_SIZE;
+        if (p + spi.nDataCount > end) {
+            break;
+        }
+        spi.paConfigData = spi.nDataCount ? p : NULL;
+        p += spi.nDataCount;
+        spiToCmd(&spi, cfg, i, cfgType);
+    }
+    if ((i != numCmds) || (p != end)) {
+#ifdef A2B_BIN_USE_SYSLOG
+        syslog_printf("Corrupt \"%s\" A2B binary", filename);
+#endif
+        A2B_BIN_FREE(cfg);
+        return(0);
+    }
+
+    if (type) {
+        *type = cfgType;
+    }
+    *c = cfg;
+    return(cfgLen);
+
+abort:
+    fclose(handle);
+    return(0);
+}
+
+/*****************************************************************************
+ * a2b_bin_free()
+ ****************************************************************************/
+void a2b_bin_free(void *cfg)
+{
+    if (cfg) {
+        A2B_BIN_FREE(cfg);
+    }
+}
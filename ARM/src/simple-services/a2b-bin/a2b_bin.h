@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Binary A2B command list cache
+ *
+ * This module saves and loads A2B command lists, as produced by
+ * 'a2b_xml_load()', in a compact, versioned and CRC protected binary
+ * file.  Each file is keyed on the CRC32 of the XML file it was
+ * converted from so a stale cache is never played out.
+ *
+ * A binary loads with one read into a single allocation and needs no
+ * parsing, string handling or per-command allocations.
+ *
+ * All multi-byte fields are little endian.  The file is a 32 byte
+ * header followed by one record per command:
+ *
+ *   Header                        Command record
+ *   0  magic 'A2BB'   u32         0  nDeviceAddr    u8
+ *   4  version        u16         1  eOpCode        u8
+ *   6  type           u8          2  nAddrWidth     u8
+ *   7  reserved       u8          3  nDataWidth     u8
+ *   8  XML CRC32      u32         4  nAddr          u32
+ *   12 commands       u32         8  nDataCount     u16
+ *   16 payload bytes  u32         10 eProtocol      u8
+ *   20 payload CRC32  u32         11 nSpiCmdWidth   u8
+ *   24 reserved       u32         12 nSpiCmd        u32
+ *   28 header CRC32   u32         16 data[nDataCount]
+ *
+ * @file      a2b_bin.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _a2b_bin_h
+#define _a2b_bin_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "adi_a2b_commandlist.h"
+
+#define A2B_BIN_MAGIC         (0x42423241u)  /* 'A2BB' */
+#define A2B_BIN_VERSION       (1)
+#define A2B_BIN_HEADER_SIZE   (32)
+#define A2B_BIN_RECORD_SIZE   (16)
+
+/* Pass as 'xmlHash' to load a binary regardless of its XML source */
+#define A2B_BIN_ANY_XML       (0)
+
+/*!****************************************************************
+ *  @brief Computes the key of an A2B XML file.
+ *
+ * @param [in]  filename   A2B XML file
+ * @param [out] hash       CRC32 of the file contents
+ *
+ * @return Returns true if the file could be read.
+ ******************************************************************/
+bool a2b_bin_file_hash(const char *filename, uint32_t *hash);
+
+/*!****************************************************************
+ *  @brief Derives the binary cache file name of an A2B XML file.
+ *
+ * Replaces a trailing ".xml" with ".a2b", or appends ".a2b".
+ *
+ * @param [in]  xmlName    A2B XML file name
+ * @param [out] binName    Binary file name
+ * @param [in]  size       Size of 'binName' in bytes
+ ******************************************************************/
+void a2b_bin_name(const char *xmlName, char *binName, unsigned size);
+
+/*!****************************************************************
+ *  @brief Loads a binary A2B command list.
+ *
+ * The returned command list has the same layout as the one returned
+ * by 'a2b_xml_load()' and must be freed with 'a2b_bin_free()'.
+ *
+ * @param [in]  filename   Binary file to load
+ * @param [in]  xmlHash    Required XML key, or A2B_BIN_ANY_XML
+ * @param [out] cfg        Pointer to the command list in memory
+ * @param [out] type       Command list protocol type
+ *
+ * @return Returns size of the command list in bytes if successful,
+ *         otherwise zero.
+ ******************************************************************/
+uint32_t a2b_bin_load(const char *filename, uint32_t xmlHash,
+    void **cfg, A2B_CMD_TYPE *type);
+
+/*!****************************************************************
+ *  @brief Saves a command list in the binary format.
+ *
+ * @param [in]  filename   Binary file to write
+ * @param [in]  xmlHash    Key of the XML source file
+ * @param [in]  cfg        Command list
+ * @param [in]  cfgLen     Size of the command list in bytes
+ * @param [in]  type       Command list protocol type
+ *
+ * @return Returns true if successful.
+ ******************************************************************/
+bool a2b_bin_save(const char *filename, uint32_t xmlHash,
+    const void *cfg, uint32_t cfgLen, A2B_CMD_TYPE type);
+
+/*!****************************************************************
+ *  @brief Frees a command list returned by 'a2b_bin_load()'.
+ *
+ * @param [in]  cfg     Command list
+ ******************************************************************/
+void a2b_bin_free(void *cfg);
+
+#endif
@@ -132,3 +132,42 @@ ADAU1962_RESULT init_adau1962(sTWI *twi, uint8_t adau_address)
 
     return(result);
 }
+
+/*
+ * Reprograms the sample rate and TDM slot count.  MCLK is unchanged so
+ * the PLL stays locked.  The DAC is left unmuted.
+ */
+ADAU1962_RESULT adau1962_set_sample_rate(sTWI *twi, uint8_t adau_address,
+    uint32_t fs, uint8_t tdmSlots)
+{
+    TWI_SIMPLE_RESULT twiResult;
+    uint8_t buf[2];
+    uint8_t sai;
+    uint8_t rate;
+
+    switch (tdmSlots) {
+        case 2:  sai = 0x0; break;
+        case 4:  sai = 0x2; break;
+        case 8:  sai = 0x3; break;
+        case 16: sai = 0x4; break;
+        default: return(ADAU1962_ERROR);
+    }
+
+    if (fs <= 48000) {
+        rate = 0x0;
+    } else if (fs <= 96000) {
+        rate = 0x1;
+    } else if (fs <= 192000) {
+        rate = 0x2;
+    } else {
+        return(ADAU1962_ERROR);
+    }
+
+    buf[0] = ADAU1962_DAC_CTRL0; buf[1] = (sai << 3) | (rate << 1);
+    twiResult = twi_write(twi, adau_address, buf, sizeof(buf));
+    if (twiResult != TWI_SIMPLE_SUCCESS) {
+        return(ADAU1962_ERROR);
+    }
+
+    return(ADAU1962_SUCCESS);
+}
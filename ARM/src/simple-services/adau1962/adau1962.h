@@ -24,5 +24,7 @@ typedef enum
 } ADAU1962_RESULT;
 
 ADAU1962_RESULT init_adau1962(sTWI *twi, uint8_t adau_address);
+ADAU1962_RESULT adau1962_set_sample_rate(sTWI *twi, uint8_t adau_address,
+    uint32_t fs, uint8_t tdmSlots);
 
 #endif
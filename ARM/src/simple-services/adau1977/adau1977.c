@@ -190,3 +190,42 @@ ADAU1977_RESULT write_adau1977(sTWI *twi, uint8_t adau_address, uint8_t * pu8Buf
     
     return(eResult);
 }
+
+/*
+ * Reprograms the sample rate and TDM slot count.  MCLK is unchanged so
+ * the PLL stays locked.
+ */
+ADAU1977_RESULT adau1977_set_sample_rate(sTWI *twi, uint8_t adau_address,
+    uint32_t fs, uint8_t tdmSlots)
+{
+    TWI_SIMPLE_RESULT twiResult;
+    uint8_t buf[2];
+    uint8_t sai;
+    uint8_t rate;
+
+    switch (tdmSlots) {
+        case 2:  sai = 0x0; break;
+        case 4:  sai = 0x2; break;
+        case 8:  sai = 0x3; break;
+        case 16: sai = 0x4; break;
+        default: return(ADAU1977_ERROR);
+    }
+
+    if (fs <= 48000) {
+        rate = 0x2;
+    } else if (fs <= 96000) {
+        rate = 0x3;
+    } else if (fs <= 192000) {
+        rate = 0x4;
+    } else {
+        return(ADAU1977_ERROR);
+    }
+
+    buf[0] = ADAU1977_REG_SAI_CTRL0; buf[1] = (sai << 3) | rate;
+    twiResult = twi_write(twi, adau_address, buf, sizeof(buf));
+    if (twiResult != TWI_SIMPLE_SUCCESS) {
+        return(ADAU1977_ERROR);
+    }
+
+    return(ADAU1977_SUCCESS);
+}
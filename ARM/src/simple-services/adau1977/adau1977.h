@@ -23,6 +23,8 @@ typedef enum
 } ADAU1977_RESULT;
 
 ADAU1977_RESULT init_adau1977(sTWI *twi, uint8_t adau_address);
+ADAU1977_RESULT adau1977_set_sample_rate(sTWI *twi, uint8_t adau_address,
+    uint32_t fs, uint8_t tdmSlots);
 ADAU1977_RESULT write_adau1977(sTWI *twi, uint8_t adau_address, uint8_t * pu8Buffer, uint8_t u8Length);
 ADAU1977_RESULT read_adau1977(sTWI *twi, uint8_t adau_address, uint8_t adau_register, uint8_t * pu8Buffer, uint8_t u8Length);
 
@@ -23,5 +23,7 @@ typedef enum
 } ADAU1979_RESULT;
 
 ADAU1979_RESULT init_adau1979(sTWI *twi, uint8_t adau_address);
+ADAU1979_RESULT adau1979_set_sample_rate(sTWI *twi, uint8_t adau_address,
+    uint32_t fs, uint8_t tdmSlots);
 
 #endif
@@ -45,6 +45,21 @@
 #define ADI_A2B_CMDLIST_READBUF_LEN 16
 #endif
 
+/* Coalesce register writes into batched block writes */
+#ifndef ADI_A2B_CMDLIST_OPTIMIZE
+#define ADI_A2B_CMDLIST_OPTIMIZE 1
+#endif
+
+/* Write queue data bytes (addresses included) */
+#ifndef ADI_A2B_CMDLIST_QUEUE_BYTES
+#define ADI_A2B_CMDLIST_QUEUE_BYTES 512
+#endif
+
+/* Write queue transactions */
+#ifndef ADI_A2B_CMDLIST_QUEUE_XFERS
+#define ADI_A2B_CMDLIST_QUEUE_XFERS 32
+#endif
+
 #define     AD24xx_REG_CHIP                    0x00
 #define     AD24xx_REG_NODEADR                 0x01
 #define     AD24xx_REG_VENDOR                  0x02
@@ -112,6 +127,19 @@ struct _ADI_A2B_CMDLIST {
     uint8_t faultNode;
     ADI_A2B_CMDLIST_NODE_INFO nodeInfo[ADI_A2B_CMDLIST_MAX_NODES];
     ADI_A2B_CMDLIST_OVERRIDE_INFO oi;
+
+    /* Pending register write queue */
+    ADI_A2B_CMDLIST_TWI_XFER qXfer[ADI_A2B_CMDLIST_QUEUE_XFERS];
+    uint16_t qCount;
+    uint8_t qBuf[ADI_A2B_CMDLIST_QUEUE_BYTES];
+    uint16_t qLen;
+    uint8_t qMasterAddr;
+    bool qMerge;
+    uint32_t qNextReg;
+    int16_t qNodeAdr;
+    uint32_t twiWrites;
+    uint32_t writesMerged;
+    uint32_t writesDropped;
 };
 
 /* ADI Command-list independent command data structure */
@@ -259,6 +287,172 @@ static ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_write_ctrl_reg_block(
     return (result);
 }
 
+/*
+ * Resets the write queue.  'masterAddr' is the TWI address the
+ * queued commands use for the master transceiver.
+ */
+static void adi_a2b_cmdlist_queue_reset(ADI_A2B_CMDLIST *list,
+    uint8_t masterAddr)
+{
+    list->qCount = 0;
+    list->qLen = 0;
+    list->qMerge = false;
+    list->qNodeAdr = -1;
+    list->qMasterAddr = masterAddr;
+    list->twiWrites = 0;
+    list->writesMerged = 0;
+    list->writesDropped = 0;
+}
+
+/*
+ * Issues all queued writes in order.
+ */
+static ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_queue_flush(
+    ADI_A2B_CMDLIST *list)
+{
+    ADI_A2B_CMDLIST_RESULT result = ADI_A2B_CMDLIST_SUCCESS;
+    ADI_A2B_CMDLIST_CFG *cfg = list->cfg;
+    ADI_A2B_CMDLIST_TWI_XFER *x;
+    uint16_t i;
+
+    if (list->qCount == 0) {
+        return(result);
+    }
+
+    if (cfg->twiWriteList) {
+        result = cfg->twiWriteList(
+            cfg->handle, list->qXfer, list->qCount, cfg->usr
+        );
+    } else {
+        for (i = 0; i < list->qCount; i++) {
+            x = &list->qXfer[i];
+            result = cfg->twiWrite(
+                cfg->handle, x->address, x->out, x->outLen, cfg->usr
+            );
+            if (result != ADI_A2B_CMDLIST_SUCCESS) {
+                break;
+            }
+        }
+    }
+
+    list->twiWrites += list->qCount;
+    list->qCount = 0;
+    list->qLen = 0;
+    list->qMerge = false;
+
+    return(result);
+}
+
+/*
+ * Queues a register write.  Writes to contiguous AD24xx registers
+ * of the same device are merged since the transceiver
+ * auto-increments the register address.  Remote peripherals are
+ * never merged since they may not.  Master NODEADR writes that
+ * would not change its value are dropped.
+ */
+static ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_queue_write(
+    ADI_A2B_CMDLIST *list,
+    uint32_t addr, uint8_t addrBytes,
+    uint16_t len, uint8_t *values, uint8_t i2cAddr)
+{
+    ADI_A2B_CMDLIST_RESULT result;
+    ADI_A2B_CMDLIST_TWI_XFER *x;
+    uint8_t *adr;
+    bool regAccess;
+
+    if (!ADI_A2B_CMDLIST_OPTIMIZE) {
+        list->twiWrites++;
+        return(adi_a2b_cmdlist_write_ctrl_reg_block(
+            list, addr, addrBytes, len, values, i2cAddr
+        ));
+    }
+
+    if ((addrBytes != 1) && (addrBytes != 2) && (addrBytes != 4)) {
+        return(ADI_A2B_CMDLIST_UNSUPPORTED_ADDR_BYTES);
+    }
+
+    /* Track the master NODEADR register */
+    if ((i2cAddr == list->qMasterAddr) && (addrBytes == 1)) {
+        if ((addr <= AD24xx_REG_NODEADR) &&
+            (addr + len > AD24xx_REG_NODEADR)) {
+            if ((len == 1) && (list->qNodeAdr == values[0])) {
+                list->writesDropped++;
+                return(ADI_A2B_CMDLIST_SUCCESS);
+            }
+            list->qNodeAdr = values[AD24xx_REG_NODEADR - addr];
+        }
+        if ((addr <= AD24xx_REG_CONTROL) &&
+            (addr + len > AD24xx_REG_CONTROL)) {
+            list->qNodeAdr = -1;
+        }
+    }
+
+    /* Only AD24xx register accesses can be merged */
+    regAccess = (addrBytes == 1) && (
+        (i2cAddr == list->qMasterAddr) ||
+        ((i2cAddr == list->qMasterAddr + 1) && (list->qNodeAdr >= 0) &&
+         !(list->qNodeAdr & AD24xx_BITM_NODEADR_PERI))
+    );
+
+    /* Append to the previous write if contiguous */
+    if (list->qMerge && regAccess &&
+        (list->qXfer[list->qCount - 1].address == i2cAddr) &&
+        (list->qNextReg == addr) && (addr + len <= 0x100) &&
+        (list->qLen + len <= ADI_A2B_CMDLIST_QUEUE_BYTES)) {
+        x = &list->qXfer[list->qCount - 1];
+        ADI_A2B_CMDLIST_MEMCPY(list->qBuf + list->qLen, values, len);
+        list->qLen += len;
+        x->outLen += len;
+        list->qNextReg += len;
+        list->writesMerged++;
+        return(ADI_A2B_CMDLIST_SUCCESS);
+    }
+
+    /* Make room */
+    if ((list->qCount == ADI_A2B_CMDLIST_QUEUE_XFERS) ||
+        (list->qLen + addrBytes + len > ADI_A2B_CMDLIST_QUEUE_BYTES)) {
+        result = adi_a2b_cmdlist_queue_flush(list);
+        if (result != ADI_A2B_CMDLIST_SUCCESS) {
+            return(result);
+        }
+    }
+
+    /* Too big to queue, write it directly */
+    if (addrBytes + len > ADI_A2B_CMDLIST_QUEUE_BYTES) {
+        list->twiWrites++;
+        return(adi_a2b_cmdlist_write_ctrl_reg_block(
+            list, addr, addrBytes, len, values, i2cAddr
+        ));
+    }
+
+    /* Queue a new write with the address in front of the data */
+    adr = list->qBuf + list->qLen;
+    if (addrBytes == 1) {
+        adr[0] = addr & 0xFF;
+    } else if (addrBytes == 2) {
+        adr[0] = ((addr >> 8) & 0xFF);
+        adr[1] = addr & 0xFF;
+    } else {
+        adr[0] = ((addr >> 24) & 0xFF);
+        adr[1] = ((addr >> 16) & 0xFF);
+        adr[2] = ((addr >> 8) & 0xFF);
+        adr[3] = addr & 0xFF;
+    }
+    ADI_A2B_CMDLIST_MEMCPY(adr + addrBytes, values, len);
+
+    x = &list->qXfer[list->qCount];
+    x->address = i2cAddr;
+    x->out = adr;
+    x->outLen = addrBytes + len;
+
+    list->qCount++;
+    list->qLen += addrBytes + len;
+    list->qMerge = regAccess;
+    list->qNextReg = addr + len;
+
+    return(ADI_A2B_CMDLIST_SUCCESS);
+}
+
 static ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_read_ctrl_reg(
     ADI_A2B_CMDLIST *list,
     uint8_t reg, uint8_t *value, uint8_t i2cAddr)
@@ -731,6 +925,7 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_play(ADI_A2B_CMDLIST *list)
     }
 
     adi_a2b_cmdlist_reset(list);
+    adi_a2b_cmdlist_queue_reset(list, list->cmdListMasterAddr);
 
     while (1) {
         result = adi_a2b_cmdlist_next_cmd(list, &cmd);
@@ -738,6 +933,14 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_play(ADI_A2B_CMDLIST *list)
             break;
         }
 
+        /* Issue queued writes before anything but another write */
+        if (cmd.opCode != A2B_CMD_OP_WRITE) {
+            result = adi_a2b_cmdlist_queue_flush(list);
+            if (result != ADI_A2B_CMDLIST_SUCCESS) {
+                break;
+            }
+        }
+
         /* Process command */
         switch (cmd.opCode) {
 
@@ -745,7 +948,7 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_play(ADI_A2B_CMDLIST *list)
              * Write command
              ********************************************************************/
             case A2B_CMD_OP_WRITE:
-                result = adi_a2b_cmdlist_write_ctrl_reg_block(list,
+                result = adi_a2b_cmdlist_queue_write(list,
                     cmd.addr, cmd.addrWidth,
                     cmd.dataCount, cmd.configData, cmd.deviceAddr
                 );
@@ -780,6 +983,7 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_play(ADI_A2B_CMDLIST *list)
                 }
 
                 list->cfg->delay(delayMs, list->cfg->usr);
+                list->qNodeAdr = -1;
                 break;
 
             default:
@@ -793,7 +997,7 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_play(ADI_A2B_CMDLIST *list)
     }
 
     if (result == ADI_A2B_CMDLIST_END) {
-        result = ADI_A2B_CMDLIST_SUCCESS;
+        result = adi_a2b_cmdlist_queue_flush(list);
     }
 
     return(result);
@@ -854,6 +1058,7 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_node_twi_transfer(
     }
 
     /* Set the master NODEADR register for this transaction */
+    list->qNodeAdr = -1;
     value = node & AD24xx_BITM_NODEADR_NODE;
     value |= peripheral ? AD24xx_BITM_NODEADR_PERI : 0x00;
     value |= broadcast ? AD24xx_BITM_NODEADR_BRCST : 0x00;
@@ -942,6 +1147,7 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_execute(
     list->faultDetected = false;
     list->faultNode = 0;
     ADI_A2B_CMDLIST_MEMSET(list->nodeInfo, 0, sizeof(list->nodeInfo));
+    adi_a2b_cmdlist_queue_reset(list, adi_a2b_cmdlist_master_address(list));
     result = ADI_A2B_CMDLIST_SUCCESS;
 
     while (result == ADI_A2B_CMDLIST_SUCCESS) {
@@ -955,6 +1161,19 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_execute(
             continue;
         }
 
+        /*
+         * Issue queued writes before anything but another write.  The
+         * discovery IRQ setup below also talks to the transceiver.
+         */
+        if ( (cmd.opCode != A2B_CMD_OP_WRITE) ||
+             ((singleReg) && (mode == ADI_A2B_CMDLIST_MASTER_ACCESS) &&
+              (reg == AD24xx_REG_DISCVRY)) ) {
+            result = adi_a2b_cmdlist_queue_flush(list);
+            if (result != ADI_A2B_CMDLIST_SUCCESS) {
+                break;
+            }
+        }
+
         /*
          * Track the state of a select set of master register writes
          * for limited error detection and IRQ handling during the next
@@ -1006,12 +1225,12 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_execute(
              ********************************************************************/
             case A2B_CMD_OP_WRITE:
                 if (singleReg) {
-                    result = adi_a2b_cmdlist_write_ctrl_reg(list,
-                        reg, val, cmd.deviceAddr
+                    result = adi_a2b_cmdlist_queue_write(list,
+                        reg, 1, 1, &val, cmd.deviceAddr
                     );
                 }
                 else {
-                    result = adi_a2b_cmdlist_write_ctrl_reg_block(list,
+                    result = adi_a2b_cmdlist_queue_write(list,
                         cmd.addr, cmd.addrWidth,
                         cmd.dataCount, cmd.configData, cmd.deviceAddr
                     );
@@ -1059,6 +1278,7 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_execute(
                 if (irqPending == ADI_A2B_CMDLIST_IRQ_NONE) {
                     list->cfg->delay(delayMs, list->cfg->usr);
                 }
+                list->qNodeAdr = -1;
                 break;
 
         }
@@ -1107,9 +1327,9 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_execute(
         }
     }
 
-    /* Reaching the end is success */
+    /* Reaching the end is success once the last writes are out */
     if (result == ADI_A2B_CMDLIST_END) {
-        result = ADI_A2B_CMDLIST_SUCCESS;
+        result = adi_a2b_cmdlist_queue_flush(list);
     }
 
     /* Pass along the results */
@@ -1118,6 +1338,9 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_execute(
         results->linesProcessed = list->cmdLine;
         results->faultDetected = list->faultDetected;
         results->faultNode = list->faultNode;
+        results->twiWrites = list->twiWrites;
+        results->writesMerged = list->writesMerged;
+        results->writesDropped = list->writesDropped;
         results->resultStr = adi_a2b_cmdlist_result_str(result);
     }
 
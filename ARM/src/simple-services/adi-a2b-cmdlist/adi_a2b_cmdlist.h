@@ -152,6 +152,41 @@ typedef ADI_A2B_CMDLIST_RESULT (ADI_A2B_CMDLIST_TWI_WRITE_WRITE) (
     void *out, uint16_t outLen, void *out2, uint16_t out2Len, void *usr
 );
 
+/*!****************************************************************
+ * @brief TWI write list entry.
+ *
+ * @sa ADI_A2B_CMDLIST_TWI_WRITE_LIST
+ ******************************************************************/
+typedef struct _ADI_A2B_CMDLIST_TWI_XFER {
+    uint8_t address;     /**< TWI address of the device */
+    void *out;           /**< Data out buffer pointer */
+    uint16_t outLen;     /**< Data out buffer length */
+} ADI_A2B_CMDLIST_TWI_XFER;
+
+/*!****************************************************************
+ * @brief TWI write list call-back.
+ *
+ * This user defined application function is used to perform a
+ * list of independent TWI writes back-to-back, ideally without
+ * returning to the calling task between writes.  This function
+ * callback is optional.  If not provided the writes are issued
+ * one at a time through the TWI write call-back.
+ *
+ * @param [in] twiHandle    User supplied TWI device driver handle
+ * @param [in] xfers        Array of writes to perform in order
+ * @param [in] count        Number of writes in the array
+ * @param [in] usr          User supplied data pointer
+ *
+ * @return Returns ADI_A2B_CMDLIST_SUCCESS if all writes were
+ *          successful, otherwise an error.
+ *
+ * @sa ADI_A2B_CMDLIST_CFG
+ ******************************************************************/
+typedef ADI_A2B_CMDLIST_RESULT (ADI_A2B_CMDLIST_TWI_WRITE_LIST) (
+    void *twiHandle, ADI_A2B_CMDLIST_TWI_XFER *xfers, uint16_t count,
+    void *usr
+);
+
 /*!****************************************************************
  * @brief Delay function.
  *
@@ -238,6 +273,9 @@ typedef struct _ADI_A2B_CMDLIST_CFG {
     /** Optional pointer to an application TWI write/write function.
      * This pointer can be NULL  */
     ADI_A2B_CMDLIST_TWI_WRITE_WRITE *twiWriteWrite;
+    /** Optional pointer to an application TWI write list function.
+     * This pointer can be NULL  */
+    ADI_A2B_CMDLIST_TWI_WRITE_LIST *twiWriteList;
     /** Pointer to an application delay function */
     ADI_A2B_CMDLIST_DELAY *delay;
     /** Pointer to an application current time function */
@@ -343,6 +381,12 @@ typedef struct _ADI_A2B_CMDLIST_EXECUTE_INFO {
     int8_t faultNode;
     /** Number of command list lines processed */
     uint32_t linesProcessed;
+    /** Number of TWI write transactions issued */
+    uint32_t twiWrites;
+    /** Number of register writes merged into a previous write */
+    uint32_t writesMerged;
+    /** Number of redundant register writes removed */
+    uint32_t writesDropped;
 } ADI_A2B_CMDLIST_EXECUTE_INFO;
 
 /*!****************************************************************
@@ -429,6 +473,12 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_set(
  * This function intelligently executes an A2B discovery
  * command list.
  *
+ * Register writes are queued and issued in batches between reads
+ * and delays.  Consecutive writes to contiguous AD24xx registers
+ * are merged into single block writes and master NODEADR writes
+ * that would not change its value are removed.  Writes to remote
+ * peripherals are never merged.
+ *
  * This function is not thread safe.
  *
  * @param [in]  list    Pointer to a ADI_A2B_CMDLIST handle.
@@ -447,9 +497,10 @@ ADI_A2B_CMDLIST_RESULT adi_a2b_cmdlist_execute(
 /*!****************************************************************
  * @brief Command list play.
  *
- * This function plays a command list.  The list is played exactly
- * as-is with no processing.  Meant to be used in place of
- * adi_a2b_cmdlist_execute().
+ * This function plays a command list.  The list is played as-is
+ * with no overrides or IRQ handling.  Register writes are coalesced
+ * the same as adi_a2b_cmdlist_execute().  Meant to be used in place
+ * of adi_a2b_cmdlist_execute().
  *
  * USE WITH CAUTION!
  *
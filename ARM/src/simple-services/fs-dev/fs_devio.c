@@ -27,6 +27,13 @@
 #include "fs_devman_cfg.h"
 #include "fs_devman_priv.h"
 #include "fs_devman.h"
+#include "fs_devio.h"
+
+#ifdef FS_DEVIO_ENABLE_STREAMS
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#endif
 
 #ifndef FS_DEVIO_DEVICE
 #define FS_DEVIO_DEVICE     2000
@@ -40,14 +47,604 @@
 #define FS_DEVIO_FD_OFFSET  100
 #endif
 
+#ifdef FS_DEVIO_ENABLE_STREAMS
+
+/* Default streaming buffer size and count (read-ahead / write-behind) */
+#ifndef FS_DEVIO_STREAM_BUF_SIZE
+#define FS_DEVIO_STREAM_BUF_SIZE    (4 * 1024)
+#endif
+
+#ifndef FS_DEVIO_STREAM_BUFS
+#define FS_DEVIO_STREAM_BUFS        (4)
+#endif
+
+/* Number of closed streams kept for 'fs_devio_stream_info()' */
+#ifndef FS_DEVIO_STREAM_HISTORY
+#define FS_DEVIO_STREAM_HISTORY     (4)
+#endif
+
+#ifndef FS_DEVIO_TASK_PRIORITY
+#define FS_DEVIO_TASK_PRIORITY      (tskIDLE_PRIORITY + 3)
+#endif
+
+/* The I/O task runs the full fread()/fwrite() path down through the
+ * filesystem and the media driver.  Check 'fsio' for the headroom.
+ */
+#ifndef FS_DEVIO_TASK_STACK_SIZE
+#define FS_DEVIO_TASK_STACK_SIZE    (configMINIMAL_STACK_SIZE + 512)
+#endif
+
+/*
+ * Time stamp used to measure media I/O and stall times.  Override
+ * with a finer grained counter in fs_devman_cfg.h.
+ */
+#ifndef FS_DEVIO_TIMESTAMP
+#define FS_DEVIO_TIMESTAMP()        xTaskGetTickCount()
+#define FS_DEVIO_TIMESTAMP_HZ       configTICK_RATE_HZ
+#endif
+
+typedef struct _FS_DEVIO_BUF {
+    uint8_t *data;
+    unsigned len;
+} FS_DEVIO_BUF;
+
+/*
+ * A streaming file is a ring of 'numBufs' buffers shared between the
+ * file's user and the I/O task.  For reads the I/O task fills buffers
+ * at 'tail' and the user drains them from 'head'.  For writes the user
+ * fills the buffer at 'tail' and the I/O task writes them out from
+ * 'head'.  'count' is the number of full buffers.
+ */
+typedef struct _FS_DEVIO_STREAM {
+    FILE *f;
+    bool write;
+    unsigned bufSize;
+    unsigned numBufs;
+    FS_DEVIO_BUF *bufs;
+    unsigned head;
+    unsigned tail;
+    unsigned count;
+    unsigned offset;
+    bool busy;
+    bool hold;
+    bool eof;
+    bool error;
+    long pos;
+    long filePos;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t done;
+    char name[FS_DEVIO_STREAM_NAME_LEN];
+    TickType_t openTicks;
+    uint32_t bytes;
+    uint64_t ioTime;
+    uint32_t stalls;
+    uint64_t stallTime;
+    uint32_t maxStall;
+} FS_DEVIO_STREAM;
+
+#endif
+
 typedef struct _FS_DEVIO_FD {
     bool open;
     int baseFd;
     FS_DEVMAN_DEVICE_INFO *devInfo;
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    FS_DEVIO_STREAM *stream;
+#endif
 } FS_DEVIO_FD;
 
 static FS_DEVIO_FD DEVIO_FD[FS_DEVIO_MAX_FDS];
 
+#ifdef FS_DEVIO_ENABLE_STREAMS
+
+static TaskHandle_t ioTaskHandle;
+
+/* Protects DEVIO_FD[].stream and the stream history */
+static SemaphoreHandle_t streamLock;
+
+/* Serializes fs_devio_fopen() and hands its request to _fs_devio_open() */
+static SemaphoreHandle_t openLock;
+static TaskHandle_t pendingOwner;
+static unsigned pendingBufSize;
+static unsigned pendingNumBufs;
+static FS_DEVIO_STREAM *pendingStream;
+
+static FS_DEVIO_STREAM_INFO streamHistory[FS_DEVIO_STREAM_HISTORY];
+static unsigned streamHistoryIdx;
+
+/***********************************************************************
+ * Streaming files
+ ***********************************************************************/
+static FS_DEVIO_STREAM *streamCreate(const char *name, int mode,
+    unsigned bufSize, unsigned numBufs)
+{
+    FS_DEVIO_STREAM *s;
+    uint8_t *data;
+    unsigned i;
+
+    s = FS_DEVMAN_CALLOC(1, sizeof(*s));
+    if (s == NULL) {
+        return(NULL);
+    }
+
+    s->bufs = FS_DEVMAN_CALLOC(numBufs, sizeof(*s->bufs));
+    data = FS_DEVMAN_CALLOC(numBufs, bufSize);
+    s->lock = xSemaphoreCreateMutex();
+    s->done = xSemaphoreCreateBinary();
+
+    if (!s->bufs || !data || !s->lock || !s->done) {
+        if (s->lock) {
+            vSemaphoreDelete(s->lock);
+        }
+        if (s->done) {
+            vSemaphoreDelete(s->done);
+        }
+        if (data) {
+            FS_DEVMAN_FREE(data);
+        }
+        if (s->bufs) {
+            FS_DEVMAN_FREE(s->bufs);
+        }
+        FS_DEVMAN_FREE(s);
+        return(NULL);
+    }
+
+    for (i = 0; i < numBufs; i++) {
+        s->bufs[i].data = data + i * bufSize;
+    }
+
+    s->write = (mode & ADI_WRITE) || (mode & ADI_APPEND) ||
+        ((mode & ADI_RW) == ADI_RW);
+    s->bufSize = bufSize;
+    s->numBufs = numBufs;
+    strncpy(s->name, name, sizeof(s->name) - 1);
+    s->openTicks = xTaskGetTickCount();
+
+    return(s);
+}
+
+static void streamDestroy(FS_DEVIO_STREAM *s)
+{
+    vSemaphoreDelete(s->lock);
+    vSemaphoreDelete(s->done);
+    FS_DEVMAN_FREE(s->bufs[0].data);
+    FS_DEVMAN_FREE(s->bufs);
+    FS_DEVMAN_FREE(s);
+}
+
+static void streamKick(void)
+{
+    if (ioTaskHandle) {
+        xTaskNotifyGive(ioTaskHandle);
+    }
+}
+
+/*
+ * Waits for the I/O task to complete an operation on the stream.
+ * Called and returns with the stream locked.
+ */
+static uint32_t streamWait(FS_DEVIO_STREAM *s)
+{
+    uint32_t t;
+
+    t = FS_DEVIO_TIMESTAMP();
+    xSemaphoreGive(s->lock);
+    streamKick();
+    xSemaphoreTake(s->done, portMAX_DELAY);
+    xSemaphoreTake(s->lock, portMAX_DELAY);
+
+    return(FS_DEVIO_TIMESTAMP() - t);
+}
+
+static void streamStall(FS_DEVIO_STREAM *s, uint32_t stall)
+{
+    s->stalls++;
+    s->stallTime += stall;
+    if (stall > s->maxStall) {
+        s->maxStall = stall;
+    }
+}
+
+static unsigned streamAvailable(FS_DEVIO_STREAM *s)
+{
+    unsigned avail;
+    unsigned i;
+
+    if (s->write) {
+        if (s->count == s->numBufs) {
+            return(0);
+        }
+        avail = (s->numBufs - s->count) * s->bufSize;
+        return(avail - s->bufs[s->tail].len);
+    }
+
+    avail = 0;
+    for (i = 0; i < s->count; i++) {
+        avail += s->bufs[(s->head + i) % s->numBufs].len;
+    }
+
+    return(avail - s->offset);
+}
+
+/*
+ * Takes the stream away from the I/O task.  Pending writes are flushed,
+ * read-ahead is discarded and the media position is returned to the
+ * user's position.  Called with the stream locked, release with
+ * streamRelease().
+ */
+static bool streamHold(FS_DEVIO_FD *fdf)
+{
+    FS_DEVMAN_DEVICE_INFO *devInfo = fdf->devInfo;
+    FS_DEVIO_STREAM *s = fdf->stream;
+    unsigned i;
+
+    if (s->write) {
+        if ((s->count < s->numBufs) && (s->bufs[s->tail].len > 0)) {
+            s->tail = (s->tail + 1) % s->numBufs;
+            s->count++;
+        }
+        while ((s->count > 0) && !s->error) {
+            streamWait(s);
+        }
+    }
+
+    s->hold = true;
+    while (s->busy) {
+        streamWait(s);
+    }
+
+    if (!s->write || s->error) {
+        for (i = 0; i < s->numBufs; i++) {
+            s->bufs[i].len = 0;
+        }
+        s->head = s->tail = s->count = s->offset = 0;
+        s->eof = false;
+    }
+
+    if ((s->filePos != s->pos) && devInfo->dev->fsd_lseek) {
+        s->filePos = devInfo->dev->fsd_lseek(fdf->baseFd, s->pos,
+            SEEK_SET, devInfo);
+    }
+
+    return(!s->error && (s->filePos == s->pos));
+}
+
+static void streamRelease(FS_DEVIO_STREAM *s)
+{
+    s->hold = false;
+}
+
+/*
+ * Reads or writes against the direction of the stream bypass the
+ * buffers.
+ */
+static int streamDirect(FS_DEVIO_FD *fdf, unsigned char *buf, int size,
+    bool write)
+{
+    FS_DEVMAN_DEVICE_INFO *devInfo = fdf->devInfo;
+    FS_DEVIO_STREAM *s = fdf->stream;
+    int n;
+
+    n = 0;
+    if (streamHold(fdf)) {
+        if (write) {
+            n = devInfo->dev->fsd_write(fdf->baseFd, buf, size, devInfo);
+        } else {
+            n = devInfo->dev->fsd_read(fdf->baseFd, buf, size, devInfo);
+        }
+        if (n > 0) {
+            s->pos += n;
+            s->filePos += n;
+        } else {
+            n = 0;
+        }
+    }
+    streamRelease(s);
+
+    return(n);
+}
+
+static int streamRead(FS_DEVIO_FD *fdf, unsigned char *buf, int size)
+{
+    FS_DEVIO_STREAM *s = fdf->stream;
+    FS_DEVIO_BUF *b;
+    uint32_t stall;
+    bool kick;
+    int total;
+    int n;
+
+    xSemaphoreTake(s->lock, portMAX_DELAY);
+
+    if (s->write) {
+        n = streamDirect(fdf, buf, size, false);
+        xSemaphoreGive(s->lock);
+        streamKick();
+        return(n);
+    }
+
+    total = 0; stall = 0; kick = false;
+
+    while (total < size) {
+        if (s->count > 0) {
+            b = &s->bufs[s->head];
+            n = b->len - s->offset;
+            if (n > (size - total)) {
+                n = size - total;
+            }
+            memcpy(buf + total, b->data + s->offset, n);
+            s->offset += n;
+            total += n;
+            if (s->offset == b->len) {
+                b->len = 0;
+                s->offset = 0;
+                s->head = (s->head + 1) % s->numBufs;
+                s->count--;
+                kick = true;
+            }
+        } else if (s->eof || s->error) {
+            break;
+        } else {
+            stall += streamWait(s);
+        }
+    }
+
+    if (stall) {
+        streamStall(s, stall);
+    }
+    s->pos += total;
+    s->bytes += total;
+
+    xSemaphoreGive(s->lock);
+
+    if (kick) {
+        streamKick();
+    }
+
+    return(total);
+}
+
+static int streamWrite(FS_DEVIO_FD *fdf, unsigned char *buf, int size)
+{
+    FS_DEVIO_STREAM *s = fdf->stream;
+    FS_DEVIO_BUF *b;
+    uint32_t stall;
+    bool kick;
+    int total;
+    int n;
+
+    xSemaphoreTake(s->lock, portMAX_DELAY);
+
+    if (!s->write) {
+        n = streamDirect(fdf, buf, size, true);
+        xSemaphoreGive(s->lock);
+        streamKick();
+        return(n);
+    }
+
+    total = 0; stall = 0; kick = false;
+
+    while ((total < size) && !s->error) {
+        if (s->count < s->numBufs) {
+            b = &s->bufs[s->tail];
+            n = s->bufSize - b->len;
+            if (n > (size - total)) {
+                n = size - total;
+            }
+            memcpy(b->data + b->len, buf + total, n);
+            b->len += n;
+            total += n;
+            if (b->len == s->bufSize) {
+                s->tail = (s->tail + 1) % s->numBufs;
+                s->count++;
+                kick = true;
+            }
+        } else {
+            stall += streamWait(s);
+        }
+    }
+
+    if (stall) {
+        streamStall(s, stall);
+    }
+    s->pos += total;
+    s->bytes += total;
+
+    xSemaphoreGive(s->lock);
+
+    if (kick) {
+        streamKick();
+    }
+
+    return(total);
+}
+
+static long streamSeek(FS_DEVIO_FD *fdf, long offset, int whence)
+{
+    FS_DEVMAN_DEVICE_INFO *devInfo = fdf->devInfo;
+    FS_DEVIO_STREAM *s = fdf->stream;
+
+    xSemaphoreTake(s->lock, portMAX_DELAY);
+
+    if (whence == SEEK_CUR) {
+        offset += s->pos;
+        whence = SEEK_SET;
+    }
+
+    /* ftell() and seeks to the current position keep the buffers */
+    if ((whence == SEEK_SET) && (offset == s->pos)) {
+        xSemaphoreGive(s->lock);
+        return(offset);
+    }
+
+    if (streamHold(fdf)) {
+        offset = devInfo->dev->fsd_lseek(fdf->baseFd, offset, whence, devInfo);
+        if (offset >= 0) {
+            s->pos = s->filePos = offset;
+        }
+    } else {
+        offset = -1;
+    }
+    streamRelease(s);
+
+    xSemaphoreGive(s->lock);
+
+    streamKick();
+
+    return(offset);
+}
+
+static void streamGetInfo(FS_DEVIO_STREAM *s, FS_DEVIO_STREAM_INFO *info)
+{
+    memcpy(info->name, s->name, sizeof(info->name));
+    info->write = s->write;
+    info->bufSize = s->bufSize;
+    info->numBufs = s->numBufs;
+    info->buffered = s->write ?
+        (s->numBufs * s->bufSize) - streamAvailable(s) : streamAvailable(s);
+    info->bytes = s->bytes;
+    info->elapsedMs = (uint64_t)(xTaskGetTickCount() - s->openTicks) *
+        1000 / configTICK_RATE_HZ;
+    info->ioMs = s->ioTime * 1000 / FS_DEVIO_TIMESTAMP_HZ;
+    info->stalls = s->stalls;
+    info->stallMs = s->stallTime * 1000 / FS_DEVIO_TIMESTAMP_HZ;
+    info->maxStallUs = (uint64_t)s->maxStall * 1000000 / FS_DEVIO_TIMESTAMP_HZ;
+    info->error = s->error;
+}
+
+static int streamClose(FS_DEVIO_FD *fdf)
+{
+    FS_DEVIO_STREAM *s = fdf->stream;
+    FS_DEVIO_STREAM_INFO *info;
+    bool ok;
+
+    xSemaphoreTake(s->lock, portMAX_DELAY);
+    ok = streamHold(fdf);
+    xSemaphoreGive(s->lock);
+
+    xSemaphoreTake(streamLock, portMAX_DELAY);
+    fdf->stream = NULL;
+    info = &streamHistory[streamHistoryIdx];
+    streamGetInfo(s, info);
+    info->open = false;
+    streamHistoryIdx = (streamHistoryIdx + 1) % FS_DEVIO_STREAM_HISTORY;
+    xSemaphoreGive(streamLock);
+
+    streamDestroy(s);
+
+    return(ok ? 0 : -1);
+}
+
+/*
+ * Runs one read-ahead or write-behind operation on a stream.  Returns
+ * true if there was work to do.
+ */
+static bool streamService(FS_DEVIO_FD *fdf)
+{
+    FS_DEVMAN_DEVICE_INFO *devInfo;
+    FS_DEVIO_STREAM *s;
+    FS_DEVIO_BUF *b;
+    uint32_t t;
+    int n;
+
+    b = NULL;
+
+    xSemaphoreTake(streamLock, portMAX_DELAY);
+    s = fdf->stream;
+    if (s) {
+        xSemaphoreTake(s->lock, portMAX_DELAY);
+        if (!s->busy && !s->hold && !s->error) {
+            if (s->write) {
+                if (s->count > 0) {
+                    b = &s->bufs[s->head];
+                }
+            } else {
+                if (!s->eof && (s->count < s->numBufs)) {
+                    b = &s->bufs[s->tail];
+                }
+            }
+            s->busy = (b != NULL);
+        }
+        xSemaphoreGive(s->lock);
+    }
+    xSemaphoreGive(streamLock);
+
+    if (b == NULL) {
+        return(false);
+    }
+
+    /* The buffer belongs to this task until 'busy' is cleared */
+    devInfo = fdf->devInfo;
+    t = FS_DEVIO_TIMESTAMP();
+    if (s->write) {
+        n = devInfo->dev->fsd_write(fdf->baseFd, b->data, b->len, devInfo);
+    } else {
+        n = devInfo->dev->fsd_read(fdf->baseFd, b->data, s->bufSize, devInfo);
+    }
+    t = FS_DEVIO_TIMESTAMP() - t;
+
+    xSemaphoreTake(s->lock, portMAX_DELAY);
+    s->ioTime += t;
+    if (s->write) {
+        if (n == (int)b->len) {
+            s->filePos += n;
+        } else {
+            s->error = true;
+        }
+        b->len = 0;
+        s->head = (s->head + 1) % s->numBufs;
+        s->count--;
+    } else {
+        if (n > 0) {
+            b->len = n;
+            s->filePos += n;
+            s->tail = (s->tail + 1) % s->numBufs;
+            s->count++;
+        }
+        if (n < (int)s->bufSize) {
+            s->eof = true;
+        }
+    }
+    s->busy = false;
+    /* Give 'done' before unlocking, the stream may be freed after */
+    xSemaphoreGive(s->done);
+    xSemaphoreGive(s->lock);
+
+    return(true);
+}
+
+static portTASK_FUNCTION(fsDevioTask, pvParameters)
+{
+    bool work;
+    int i;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        do {
+            work = false;
+            for (i = 0; i < FS_DEVIO_MAX_FDS; i++) {
+                work |= streamService(&DEVIO_FD[i]);
+            }
+        } while (work);
+    }
+}
+
+static FS_DEVIO_STREAM *streamFind(FILE *f)
+{
+    FS_DEVIO_STREAM *s;
+    int i;
+
+    for (i = 0; i < FS_DEVIO_MAX_FDS; i++) {
+        s = DEVIO_FD[i].stream;
+        if (s && (s->f == f)) {
+            return(s);
+        }
+    }
+
+    return(NULL);
+}
+
+#endif
+
 /***********************************************************************
  * Init
  ***********************************************************************/
@@ -95,6 +692,20 @@ static int _fs_devio_open(const char *name, int mode)
     fdf->baseFd = baseFd;
     fdf->devInfo = devInfo;
 
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    /* Opened through fs_devio_fopen(), stream the file if possible */
+    if (pendingOwner && (pendingOwner == xTaskGetCurrentTaskHandle())) {
+        pendingStream = streamCreate(name, mode, pendingBufSize, pendingNumBufs);
+        if (pendingStream && devInfo->dev->fsd_lseek) {
+            pendingStream->pos = devInfo->dev->fsd_lseek(baseFd, 0, SEEK_CUR, devInfo);
+            pendingStream->filePos = pendingStream->pos;
+        }
+        xSemaphoreTake(streamLock, portMAX_DELAY);
+        fdf->stream = pendingStream;
+        xSemaphoreGive(streamLock);
+    }
+#endif
+
     return(fd + FS_DEVIO_FD_OFFSET);
 }
 
@@ -105,6 +716,7 @@ static int _fs_devio_close(int fd)
 {
     FS_DEVIO_FD *fdf;
     FS_DEVMAN_DEVICE_INFO *devInfo;
+    int result;
 
     fd -= FS_DEVIO_FD_OFFSET;
 
@@ -118,11 +730,19 @@ static int _fs_devio_close(int fd)
         return(-1);
     }
 
+    result = 0;
+
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    if (fdf->stream) {
+        result = streamClose(fdf);
+    }
+#endif
+
     fdf->open = false;
 
     devInfo->dev->fsd_close(fdf->baseFd, devInfo);
 
-    return(0);
+    return(result);
 }
 
 /***********************************************************************
@@ -146,6 +766,11 @@ static int _fs_devio_read(int fd, unsigned char *buf, int size)
         return(-1);
     }
 
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    if (fdf->stream) {
+        readSize = streamRead(fdf, buf, size);
+    } else
+#endif
     readSize = devInfo->dev->fsd_read(fdf->baseFd, buf, size, devInfo);
 #if defined(__ADSPARM__)
     readSize = size - readSize;
@@ -172,6 +797,11 @@ static int _fs_devio_write(int fd, unsigned char *buf, int size)
         return(-1);
     }
 
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    if (fdf->stream) {
+        writeSize = streamWrite(fdf, buf, size);
+    } else
+#endif
     writeSize = devInfo->dev->fsd_write(fdf->baseFd, buf, size, devInfo);
 #if defined(__ADSPARM__)
     writeSize = size - writeSize;
@@ -200,6 +830,12 @@ static long _fs_devio_seek(int fd, long offset, int whence)
         return(-1);
     }
 
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    if (fdf->stream) {
+        return(streamSeek(fdf, offset, whence));
+    }
+#endif
+
     offset = devInfo->dev->fsd_lseek(fdf->baseFd, offset, whence, devInfo);
 
     return(offset);
@@ -348,6 +984,13 @@ void fs_devio_init(void)
 {
     int result;
 
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    streamLock = xSemaphoreCreateMutex();
+    openLock = xSemaphoreCreateMutex();
+    xTaskCreate(fsDevioTask, "FsDevioTask", FS_DEVIO_TASK_STACK_SIZE,
+        NULL, FS_DEVIO_TASK_PRIORITY, &ioTaskHandle);
+#endif
+
     result = add_devtab_entry(&fs_devio_deventry);
 
     if (result == FS_DEVIO_DEVICE) {
@@ -355,3 +998,135 @@ void fs_devio_init(void)
     }
 }
 
+
+FILE *fs_devio_fopen(const char *name, const char *mode,
+    unsigned bufSize, unsigned numBufs)
+{
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    FS_DEVIO_STREAM *s;
+    FILE *f;
+
+    if ((openLock == NULL) || (ioTaskHandle == NULL)) {
+        return(fopen(name, mode));
+    }
+
+    xSemaphoreTake(openLock, portMAX_DELAY);
+    pendingBufSize = bufSize ? bufSize : FS_DEVIO_STREAM_BUF_SIZE;
+    pendingNumBufs = numBufs ? numBufs : FS_DEVIO_STREAM_BUFS;
+    pendingStream = NULL;
+    pendingOwner = xTaskGetCurrentTaskHandle();
+    f = fopen(name, mode);
+    pendingOwner = NULL;
+    s = pendingStream;
+    xSemaphoreGive(openLock);
+
+    if (f && s) {
+        /* The stream buffers replace the stdio buffer */
+        setvbuf(f, NULL, _IONBF, 0);
+        xSemaphoreTake(s->lock, portMAX_DELAY);
+        s->f = f;
+        xSemaphoreGive(s->lock);
+        if (!s->write) {
+            streamKick();
+        }
+    }
+
+    return(f);
+#else
+    return(fopen(name, mode));
+#endif
+}
+
+int fs_devio_available(FILE *f)
+{
+    int avail = -1;
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    FS_DEVIO_STREAM *s;
+
+    if (streamLock == NULL) {
+        return(-1);
+    }
+
+    xSemaphoreTake(streamLock, portMAX_DELAY);
+    s = streamFind(f);
+    if (s) {
+        xSemaphoreTake(s->lock, portMAX_DELAY);
+        avail = streamAvailable(s);
+        xSemaphoreGive(s->lock);
+    }
+    xSemaphoreGive(streamLock);
+#endif
+    return(avail);
+}
+
+bool fs_devio_ready(FILE *f, size_t size)
+{
+    bool ready = true;
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    FS_DEVIO_STREAM *s;
+
+    if (streamLock == NULL) {
+        return(true);
+    }
+
+    xSemaphoreTake(streamLock, portMAX_DELAY);
+    s = streamFind(f);
+    if (s) {
+        xSemaphoreTake(s->lock, portMAX_DELAY);
+        ready = (streamAvailable(s) >= size) || s->error ||
+            (!s->write && s->eof);
+        xSemaphoreGive(s->lock);
+    }
+    xSemaphoreGive(streamLock);
+#endif
+    return(ready);
+}
+
+int fs_devio_task_stack_free(void)
+{
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    if (ioTaskHandle) {
+        return(uxTaskGetStackHighWaterMark(ioTaskHandle) * sizeof(StackType_t));
+    }
+#endif
+    return(-1);
+}
+
+int fs_devio_stream_info(FS_DEVIO_STREAM_INFO *info, int max)
+{
+    int n = 0;
+#ifdef FS_DEVIO_ENABLE_STREAMS
+    FS_DEVIO_STREAM *s;
+    unsigned idx;
+    int i;
+
+    if (streamLock == NULL) {
+        return(0);
+    }
+
+    xSemaphoreTake(streamLock, portMAX_DELAY);
+
+    for (i = 0; (i < FS_DEVIO_MAX_FDS) && (n < max); i++) {
+        s = DEVIO_FD[i].stream;
+        if (s) {
+            xSemaphoreTake(s->lock, portMAX_DELAY);
+            streamGetInfo(s, &info[n]);
+            info[n].open = true;
+            xSemaphoreGive(s->lock);
+            n++;
+        }
+    }
+
+    /* Most recently closed first */
+    idx = streamHistoryIdx;
+    for (i = 0; (i < FS_DEVIO_STREAM_HISTORY) && (n < max); i++) {
+        idx = (idx + FS_DEVIO_STREAM_HISTORY - 1) % FS_DEVIO_STREAM_HISTORY;
+        if (streamHistory[idx].name[0]) {
+            info[n++] = streamHistory[idx];
+        }
+    }
+
+    xSemaphoreGive(streamLock);
+#endif
+    return(n);
+}
@@ -12,6 +12,70 @@
 #ifndef _fs_devio_h
 #define _fs_devio_h
 
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef FS_DEVIO_STREAM_NAME_LEN
+#define FS_DEVIO_STREAM_NAME_LEN  (32)
+#endif
+
+/*
+ * Streaming file statistics.  'bytes' is the data moved by the
+ * file's user, 'ioMs' the time the I/O task spent on the media and
+ * 'stalls' the number of reads or writes that had to wait for it.
+ */
+typedef struct FS_DEVIO_STREAM_INFO {
+    char name[FS_DEVIO_STREAM_NAME_LEN];
+    bool open;
+    bool write;
+    bool error;
+    unsigned bufSize;
+    unsigned numBufs;
+    unsigned buffered;
+    uint32_t bytes;
+    uint32_t elapsedMs;
+    uint32_t ioMs;
+    uint32_t stalls;
+    uint32_t stallMs;
+    uint32_t maxStallUs;
+} FS_DEVIO_STREAM_INFO;
+
 void fs_devio_init(void);
 
+/*
+ * Opens a file like fopen() in streaming mode.  Read-only files are
+ * read ahead and all others are written behind by the fs_devio I/O
+ * task using 'numBufs' buffers of 'bufSize' bytes (0 selects the
+ * defaults).  The stdio buffer is disabled.  Falls back to a plain
+ * fopen() if streaming is unavailable.
+ */
+FILE *fs_devio_fopen(const char *name, const char *mode,
+    unsigned bufSize, unsigned numBufs);
+
+/*
+ * Returns the number of bytes that can be read from (or written to)
+ * a streaming file without waiting on the media, or -1 if 'f' is not
+ * streaming.
+ */
+int fs_devio_available(FILE *f);
+
+/*
+ * Returns true if reading or writing 'size' bytes will not wait on
+ * the media.  Always true for files that are not streaming.
+ */
+bool fs_devio_ready(FILE *f, size_t size);
+
+/*
+ * Fills in up to 'max' entries for the open streams followed by the
+ * most recently closed ones.  Returns the number of entries.
+ */
+int fs_devio_stream_info(FS_DEVIO_STREAM_INFO *info, int max);
+
+/*
+ * Returns the smallest amount of stack, in bytes, the I/O task has
+ * had left so far, or -1 if streaming is unavailable.
+ */
+int fs_devio_task_stack_free(void);
+
 #endif
@@ -0,0 +1,544 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "sxfer.h"
+#include "crc32.h"
+
+#ifdef FREE_RTOS
+    #include "FreeRTOS.h"
+    #include "semphr.h"
+    #include "queue.h"
+    #include "task.h"
+#endif
+
+#ifndef SXFER_WRITER_PRIORITY
+#define SXFER_WRITER_PRIORITY    (tskIDLE_PRIORITY + 2)
+#endif
+
+#ifndef SXFER_WRITER_STACK_SIZE
+#define SXFER_WRITER_STACK_SIZE  (configMINIMAL_STACK_SIZE + 512)
+#endif
+
+#define SXFER_HDR_SIZE   (16)
+#define SXFER_CRC_SIZE   (4)
+#define SXFER_START_LEN  (8)
+
+static const uint8_t sxferMagic[4] = { 'S', 'X', 'F', 'R' };
+
+typedef struct SXFER_HDR {
+    uint8_t type;
+    uint8_t status;
+    uint16_t window;
+    uint32_t offset;
+    uint32_t length;
+} SXFER_HDR;
+
+typedef struct SXFER_BUFFER {
+    uint32_t offset;
+    uint32_t length;
+    uint8_t *data;
+} SXFER_BUFFER;
+
+typedef struct SXFER_STATE {
+    const SXFER_CONFIG *cfg;
+    SXFER_BUFFER buf[SXFER_WINDOW];
+    volatile int error;
+#ifdef FREE_RTOS
+    QueueHandle_t freeQ;
+    QueueHandle_t fullQ;
+    SemaphoreHandle_t writerDone;
+#endif
+} SXFER_STATE;
+
+typedef enum SXFER_FRAME_RESULT {
+    SXFER_FRAME_OK,
+    SXFER_FRAME_TIMEOUT,
+    SXFER_FRAME_BAD
+} SXFER_FRAME_RESULT;
+
+/***********************************************************************
+ * Byte packing
+ **********************************************************************/
+static void sxfer_put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32_t sxfer_get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+        ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/***********************************************************************
+ * Link helpers
+ **********************************************************************/
+static bool sxfer_read(SXFER_STATE *sx, uint8_t *data, unsigned len)
+{
+    const SXFER_CONFIG *cfg = sx->cfg;
+    int n;
+
+    while (len) {
+        n = cfg->read(data, len, SXFER_TIMEOUT, cfg->usr);
+        if (n <= 0) {
+            return(false);
+        }
+        data += n;
+        len -= n;
+    }
+    return(true);
+}
+
+static void sxfer_send(SXFER_STATE *sx, uint8_t type, uint8_t status,
+    uint32_t offset, uint32_t length)
+{
+    const SXFER_CONFIG *cfg = sx->cfg;
+    uint8_t frame[SXFER_HDR_SIZE + SXFER_CRC_SIZE];
+
+    memcpy(frame, sxferMagic, sizeof(sxferMagic));
+    frame[4] = type;
+    frame[5] = status;
+    frame[6] = SXFER_WINDOW & 0xFF;
+    frame[7] = SXFER_WINDOW >> 8;
+    sxfer_put32(&frame[8], offset);
+    sxfer_put32(&frame[12], length);
+    sxfer_put32(&frame[SXFER_HDR_SIZE], crc32(frame, SXFER_HDR_SIZE));
+
+    cfg->send(frame, sizeof(frame), cfg->usr);
+}
+
+/*
+ * Reads one frame.  Data payloads land directly in 'buf', all others
+ * in 'small'.  Hunts byte by byte for the magic so a corrupted or
+ * truncated frame only costs the bytes up to the next header.
+ */
+static SXFER_FRAME_RESULT sxfer_get_frame(SXFER_STATE *sx, SXFER_HDR *hdr,
+    SXFER_BUFFER *buf, uint8_t *small)
+{
+    uint8_t raw[SXFER_HDR_SIZE];
+    uint8_t crcBytes[SXFER_CRC_SIZE];
+    uint8_t *payload;
+    uint32_t crc;
+    unsigned match;
+    uint8_t c;
+
+    match = 0;
+    while (match < sizeof(sxferMagic)) {
+        if (!sxfer_read(sx, &c, 1)) {
+            return(SXFER_FRAME_TIMEOUT);
+        }
+        if (c == sxferMagic[match]) {
+            match++;
+        } else {
+            match = (c == sxferMagic[0]) ? 1 : 0;
+        }
+    }
+    memcpy(raw, sxferMagic, sizeof(sxferMagic));
+
+    if (!sxfer_read(sx, &raw[4], SXFER_HDR_SIZE - 4)) {
+        return(SXFER_FRAME_TIMEOUT);
+    }
+
+    hdr->type = raw[4];
+    hdr->status = raw[5];
+    hdr->window = raw[6] | (raw[7] << 8);
+    hdr->offset = sxfer_get32(&raw[8]);
+    hdr->length = sxfer_get32(&raw[12]);
+
+    if (hdr->type == SXFER_TYPE_DATA) {
+        if ((hdr->length == 0) || (hdr->length > SXFER_FRAME_MAX)) {
+            return(SXFER_FRAME_BAD);
+        }
+        payload = buf->data;
+    } else {
+        if (hdr->length > SXFER_START_LEN) {
+            return(SXFER_FRAME_BAD);
+        }
+        payload = small;
+    }
+
+    if (!sxfer_read(sx, payload, hdr->length)) {
+        return(SXFER_FRAME_TIMEOUT);
+    }
+    if (!sxfer_read(sx, crcBytes, sizeof(crcBytes))) {
+        return(SXFER_FRAME_TIMEOUT);
+    }
+
+    crc = crc32(raw, SXFER_HDR_SIZE);
+    crc = crc32_x(payload, hdr->length, crc);
+    if (crc != sxfer_get32(crcBytes)) {
+        return(SXFER_FRAME_BAD);
+    }
+
+    buf->offset = hdr->offset;
+    buf->length = hdr->length;
+
+    return(SXFER_FRAME_OK);
+}
+
+/***********************************************************************
+ * Writer
+ **********************************************************************/
+static void sxfer_write(SXFER_STATE *sx, SXFER_BUFFER *buf)
+{
+    const SXFER_CONFIG *cfg = sx->cfg;
+    int err;
+
+    if (sx->error == SXFER_ERROR_NONE) {
+        err = cfg->write(buf->offset, buf->data, buf->length, cfg->usr);
+        if (err == 0) {
+            cfg->session->offset = buf->offset + buf->length;
+        } else {
+            sx->error = SXFER_ERROR_CALLBACK;
+        }
+    }
+}
+
+#ifdef FREE_RTOS
+
+static portTASK_FUNCTION(sxferWriterTask, pvParameters)
+{
+    SXFER_STATE *sx = (SXFER_STATE *)pvParameters;
+    const SXFER_CONFIG *cfg = sx->cfg;
+    SXFER_BUFFER *buf;
+    TickType_t wait;
+    bool idle;
+
+    idle = (cfg->idle != NULL);
+
+    while (1) {
+        wait = idle ? 0 : portMAX_DELAY;
+        if (xQueueReceive(sx->fullQ, &buf, wait) != pdTRUE) {
+            if (sx->error == SXFER_ERROR_NONE) {
+                idle = (cfg->idle(cfg->usr) != 0);
+            } else {
+                idle = false;
+            }
+            continue;
+        }
+        if (buf == NULL) {
+            break;
+        }
+        sxfer_write(sx, buf);
+        xQueueSend(sx->freeQ, &buf, portMAX_DELAY);
+        idle = (cfg->idle != NULL);
+    }
+
+    xSemaphoreGive(sx->writerDone);
+    vTaskDelete(NULL);
+}
+
+static bool sxfer_writer_start(SXFER_STATE *sx)
+{
+    SXFER_BUFFER *buf;
+    BaseType_t ok;
+    int i;
+
+    sx->freeQ = xQueueCreate(SXFER_WINDOW, sizeof(SXFER_BUFFER *));
+    sx->fullQ = xQueueCreate(SXFER_WINDOW + 1, sizeof(SXFER_BUFFER *));
+    sx->writerDone = xSemaphoreCreateBinary();
+    if (!sx->freeQ || !sx->fullQ || !sx->writerDone) {
+        return(false);
+    }
+
+    for (i = 0; i < SXFER_WINDOW; i++) {
+        buf = &sx->buf[i];
+        xQueueSend(sx->freeQ, &buf, 0);
+    }
+
+    ok = xTaskCreate(sxferWriterTask, "SxferWriter", SXFER_WRITER_STACK_SIZE,
+        sx, SXFER_WRITER_PRIORITY, NULL);
+
+    return(ok == pdPASS);
+}
+
+static void sxfer_writer_stop(SXFER_STATE *sx)
+{
+    SXFER_BUFFER *buf = NULL;
+
+    xQueueSend(sx->fullQ, &buf, portMAX_DELAY);
+    xSemaphoreTake(sx->writerDone, portMAX_DELAY);
+}
+
+static void sxfer_writer_free(SXFER_STATE *sx)
+{
+    if (sx->freeQ) {
+        vQueueDelete(sx->freeQ);
+    }
+    if (sx->fullQ) {
+        vQueueDelete(sx->fullQ);
+    }
+    if (sx->writerDone) {
+        vSemaphoreDelete(sx->writerDone);
+    }
+}
+
+static SXFER_BUFFER *sxfer_get_buffer(SXFER_STATE *sx)
+{
+    SXFER_BUFFER *buf;
+    xQueueReceive(sx->freeQ, &buf, portMAX_DELAY);
+    return(buf);
+}
+
+static void sxfer_put_buffer(SXFER_STATE *sx, SXFER_BUFFER *buf)
+{
+    xQueueSend(sx->freeQ, &buf, portMAX_DELAY);
+}
+
+static void sxfer_commit(SXFER_STATE *sx, SXFER_BUFFER *buf)
+{
+    xQueueSend(sx->fullQ, &buf, portMAX_DELAY);
+}
+
+/* Wait for the writer to finish everything queued so far */
+static void sxfer_flush(SXFER_STATE *sx)
+{
+    SXFER_BUFFER *bufs[SXFER_WINDOW];
+    int i;
+
+    for (i = 0; i < SXFER_WINDOW; i++) {
+        xQueueReceive(sx->freeQ, &bufs[i], portMAX_DELAY);
+    }
+    for (i = 0; i < SXFER_WINDOW; i++) {
+        xQueueSend(sx->freeQ, &bufs[i], portMAX_DELAY);
+    }
+}
+
+#else
+
+static bool sxfer_writer_start(SXFER_STATE *sx)
+{
+    return(true);
+}
+
+static void sxfer_writer_stop(SXFER_STATE *sx)
+{
+}
+
+static void sxfer_writer_free(SXFER_STATE *sx)
+{
+}
+
+static SXFER_BUFFER *sxfer_get_buffer(SXFER_STATE *sx)
+{
+    return(&sx->buf[0]);
+}
+
+static void sxfer_put_buffer(SXFER_STATE *sx, SXFER_BUFFER *buf)
+{
+}
+
+static void sxfer_commit(SXFER_STATE *sx, SXFER_BUFFER *buf)
+{
+    sxfer_write(sx, buf);
+}
+
+static void sxfer_flush(SXFER_STATE *sx)
+{
+}
+
+#endif
+
+/***********************************************************************
+ * Receiver
+ **********************************************************************/
+long sxfer_receive(const SXFER_CONFIG *cfg)
+{
+    SXFER_SESSION *session = cfg->session;
+    SXFER_STATE *sx;
+    SXFER_FRAME_RESULT fr;
+    SXFER_BUFFER *buf;
+    SXFER_HDR hdr;
+    uint8_t small[SXFER_START_LEN];
+    uint32_t expected;
+    uint32_t size, id;
+    unsigned retries;
+    bool started;
+    bool nakSent;
+    bool done;
+    long result;
+    int i;
+
+    sx = SXFER_MALLOC(sizeof(*sx));
+    if (sx == NULL) {
+        return(SXFER_ERROR_OUTOFMEM);
+    }
+    memset(sx, 0, sizeof(*sx));
+    sx->cfg = cfg;
+
+    result = SXFER_ERROR_NONE;
+    for (i = 0; i < SXFER_WINDOW; i++) {
+        sx->buf[i].data = SXFER_MALLOC(SXFER_FRAME_MAX);
+        if (sx->buf[i].data == NULL) {
+            result = SXFER_ERROR_OUTOFMEM;
+        }
+    }
+    if ((result == SXFER_ERROR_NONE) && !sxfer_writer_start(sx)) {
+        result = SXFER_ERROR_OUTOFMEM;
+    }
+    if (result != SXFER_ERROR_NONE) {
+        sxfer_writer_free(sx);
+        goto abort;
+    }
+
+    started = false;
+    nakSent = false;
+    done = false;
+    expected = 0;
+    retries = SXFER_RETRY_LIMIT;
+    result = SXFER_ERROR_RETRYEXCEED;
+
+    while (!done) {
+
+        buf = sxfer_get_buffer(sx);
+        fr = sxfer_get_frame(sx, &hdr, buf, small);
+
+        /* Writer failures end the transfer at the next frame boundary */
+        if (sx->error != SXFER_ERROR_NONE) {
+            sxfer_put_buffer(sx, buf);
+            sxfer_send(sx, SXFER_TYPE_ERROR, -sx->error, expected, 0);
+            result = sx->error;
+            break;
+        }
+
+        if (fr == SXFER_FRAME_TIMEOUT) {
+            sxfer_put_buffer(sx, buf);
+            if (--retries == 0) {
+                break;
+            }
+            if (started) {
+                sxfer_send(sx, SXFER_TYPE_NAK, 0, expected, 0);
+            }
+            continue;
+        }
+        retries = SXFER_RETRY_LIMIT;
+
+        if (fr == SXFER_FRAME_BAD) {
+            sxfer_put_buffer(sx, buf);
+            if (started && !nakSent) {
+                sxfer_send(sx, SXFER_TYPE_NAK, 0, expected, 0);
+                nakSent = true;
+            }
+            continue;
+        }
+
+        if (hdr.type == SXFER_TYPE_DATA) {
+            if (started && (hdr.offset == expected) &&
+                (hdr.offset + hdr.length <= session->size)) {
+                sxfer_commit(sx, buf);
+                expected += hdr.length;
+                nakSent = false;
+                sxfer_send(sx, SXFER_TYPE_ACK, 0, expected, 0);
+            } else {
+                sxfer_put_buffer(sx, buf);
+                if (started && (hdr.offset < expected)) {
+                    /* Go-back-N duplicate; re-ACK so the host advances */
+                    sxfer_send(sx, SXFER_TYPE_ACK, 0, expected, 0);
+                } else if (started && !nakSent) {
+                    sxfer_send(sx, SXFER_TYPE_NAK, 0, expected, 0);
+                    nakSent = true;
+                }
+            }
+            continue;
+        }
+
+        sxfer_put_buffer(sx, buf);
+
+        switch (hdr.type) {
+
+            case SXFER_TYPE_START:
+                if (hdr.length != SXFER_START_LEN) {
+                    break;
+                }
+                size = sxfer_get32(&small[0]);
+                id = sxfer_get32(&small[4]);
+
+                /* A restart mid-stream resumes from committed data only */
+                sxfer_flush(sx);
+                if (size > cfg->maxSize) {
+                    sxfer_send(sx, SXFER_TYPE_ERROR, -SXFER_ERROR_SIZE, 0, 0);
+                    started = false;
+                    break;
+                }
+                if ((session->id != id) || (session->size != size) ||
+                    (session->offset > size)) {
+                    session->id = id;
+                    session->size = size;
+                    session->offset = 0;
+                }
+                expected = session->offset;
+                if (cfg->start && cfg->start(expected, size, cfg->usr)) {
+                    sxfer_send(sx, SXFER_TYPE_ERROR,
+                        -SXFER_ERROR_CALLBACK, expected, 0);
+                    result = SXFER_ERROR_CALLBACK;
+                    done = true;
+                    break;
+                }
+                started = true;
+                nakSent = false;
+                sxfer_send(sx, SXFER_TYPE_READY, 0, expected, SXFER_FRAME_MAX);
+                break;
+
+            case SXFER_TYPE_END:
+                if (!started) {
+                    break;
+                }
+                if (hdr.offset != expected) {
+                    if (!nakSent) {
+                        sxfer_send(sx, SXFER_TYPE_NAK, 0, expected, 0);
+                        nakSent = true;
+                    }
+                    break;
+                }
+                sxfer_flush(sx);
+                if (sx->error != SXFER_ERROR_NONE) {
+                    result = sx->error;
+                } else if (session->offset != session->size) {
+                    result = SXFER_ERROR_SIZE;
+                } else {
+                    result = session->size;
+                }
+                if (result < 0) {
+                    sxfer_send(sx, SXFER_TYPE_ERROR, -result, expected, 0);
+                } else {
+                    sxfer_send(sx, SXFER_TYPE_DONE, 0, expected, 0);
+                }
+                done = true;
+                break;
+
+            case SXFER_TYPE_ABORT:
+                sxfer_send(sx, SXFER_TYPE_ACK, 0, expected, 0);
+                result = SXFER_ERROR_REMOTECANCEL;
+                done = true;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    sxfer_writer_stop(sx);
+    sxfer_writer_free(sx);
+
+abort:
+    for (i = 0; i < SXFER_WINDOW; i++) {
+        if (sx->buf[i].data) {
+            SXFER_FREE(sx->buf[i].data);
+        }
+    }
+    SXFER_FREE(sx);
+
+    return(result);
+}
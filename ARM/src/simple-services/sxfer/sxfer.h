@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Windowed streaming transfer receiver
+ *
+ * A replacement for XMODEM on fast links such as USB CDC.  Data is
+ * sent in large CRC32 checked frames with several frames in flight,
+ * so throughput is limited by the link rather than by round trips.
+ * Completed frames are handed to a writer task so that storage
+ * writes (and any erase-ahead done in the idle callback) overlap
+ * with reception.  An interrupted transfer can be resumed by
+ * restarting it with the same session id.
+ *
+ * All frames share the same little-endian layout:
+ *
+ *   | magic "SXFR" | type u8 | status u8 | window u16 |
+ *   | offset u32   | length u32 | payload[length] | crc32 u32 |
+ *
+ * The CRC32 (IEEE 802.3) covers the header and payload.
+ *
+ * Host to target:
+ *   - START: payload is { size u32, session id u32 }
+ *   - DATA:  payload of at most the advertised frame size at 'offset'
+ *   - END:   'offset' is the total image size
+ *   - ABORT: cancel the transfer
+ *
+ * Target to host (never carry a payload):
+ *   - READY: 'offset' is the resume point, 'length' the maximum DATA
+ *            payload and 'window' the number of unacknowledged DATA
+ *            frames the host may have outstanding
+ *   - ACK:   all data below 'offset' has been received
+ *   - NAK:   retransmit starting at 'offset' (go-back-N)
+ *   - DONE:  all 'offset' bytes have been committed
+ *   - ERROR: transfer failed, 'status' holds the SXFER_ERROR_* code
+ *
+ * @file      sxfer.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+
+#ifndef _SXFER_H
+#define _SXFER_H
+
+#include <stdint.h>
+
+#include "sxfer_cfg.h"
+
+/*!****************************************************************
+ * @brief  The maximum DATA frame payload in bytes
+ ******************************************************************/
+#ifndef SXFER_FRAME_MAX
+#define SXFER_FRAME_MAX       (16 * 1024)
+#endif
+
+/*!****************************************************************
+ * @brief  The number of frame buffers / frames in flight
+ ******************************************************************/
+#ifndef SXFER_WINDOW
+#define SXFER_WINDOW          (4)
+#endif
+
+/*!****************************************************************
+ * @brief  Receive inactivity timeout (ms) before a NAK is sent
+ ******************************************************************/
+#ifndef SXFER_TIMEOUT
+#define SXFER_TIMEOUT         (1000)
+#endif
+
+/*!****************************************************************
+ * @brief  Number of consecutive timeouts before giving up
+ ******************************************************************/
+#ifndef SXFER_RETRY_LIMIT
+#define SXFER_RETRY_LIMIT     (60)
+#endif
+
+/*!****************************************************************
+ * @brief  The function used to allocate frame buffers.
+ *
+ * This defaults to the standard C library malloc if not defined
+ * otherwise.
+ ******************************************************************/
+#ifndef SXFER_MALLOC
+#define SXFER_MALLOC(x)       malloc(x)
+#endif
+
+/*!****************************************************************
+ * @brief  The function used to free memory.
+ *
+ * This defaults to the standard C library free if not defined
+ * otherwise.
+ ******************************************************************/
+#ifndef SXFER_FREE
+#define SXFER_FREE(x)         free(x)
+#endif
+
+/* Frame types */
+#define SXFER_TYPE_START      (0x01)
+#define SXFER_TYPE_DATA       (0x02)
+#define SXFER_TYPE_END        (0x03)
+#define SXFER_TYPE_ABORT      (0x04)
+#define SXFER_TYPE_READY      (0x81)
+#define SXFER_TYPE_ACK        (0x82)
+#define SXFER_TYPE_NAK        (0x83)
+#define SXFER_TYPE_DONE       (0x84)
+#define SXFER_TYPE_ERROR      (0x85)
+
+/* Error return codes */
+#define SXFER_ERROR_NONE          (0)
+#define SXFER_ERROR_REMOTECANCEL  (-1)
+#define SXFER_ERROR_RETRYEXCEED   (-2)
+#define SXFER_ERROR_OUTOFMEM      (-3)
+#define SXFER_ERROR_CALLBACK      (-4)
+#define SXFER_ERROR_SIZE          (-5)
+#define SXFER_ERROR_GENERIC       (-6)
+
+/*!****************************************************************
+ * @brief  Link read function.
+ *
+ * Reads up to 'len' bytes, waiting at most 'timeout' ms for the
+ * first one.  Returns the number of bytes read (0 on timeout).
+ ******************************************************************/
+typedef int (*SXFER_READ_FUNC)(uint8_t *data, unsigned len,
+    unsigned timeout, void *usr);
+
+/*!****************************************************************
+ * @brief  Link send function.  Returns 0 on success.
+ ******************************************************************/
+typedef int (*SXFER_SEND_FUNC)(const uint8_t *data, unsigned len, void *usr);
+
+/*!****************************************************************
+ * @brief  Session start callback.
+ *
+ * Called from the receiving task once the host has started (or
+ * restarted) a session.  'offset' is where data will resume.
+ * Returns 0 to accept the session.
+ ******************************************************************/
+typedef int (*SXFER_START_FUNC)(uint32_t offset, uint32_t size, void *usr);
+
+/*!****************************************************************
+ * @brief  Data write callback.
+ *
+ * Called from the writer task, strictly in order.  Returns 0 on
+ * success.
+ ******************************************************************/
+typedef int (*SXFER_WRITE_FUNC)(uint32_t offset, const uint8_t *data,
+    unsigned len, void *usr);
+
+/*!****************************************************************
+ * @brief  Writer idle callback.
+ *
+ * Called from the writer task whenever no frames are waiting so
+ * that slow preparatory work (i.e. flash erase) can run ahead of
+ * the data.  Returns non-zero if it should be called again.
+ ******************************************************************/
+typedef int (*SXFER_IDLE_FUNC)(void *usr);
+
+/*!****************************************************************
+ * @brief  Resumable session state.
+ *
+ * Owned by the application and kept across sxfer_receive() calls.
+ * 'offset' is only advanced once data has been written.
+ ******************************************************************/
+typedef struct SXFER_SESSION {
+    uint32_t id;
+    uint32_t size;
+    uint32_t offset;
+} SXFER_SESSION;
+
+/*!****************************************************************
+ * @brief  Receiver configuration
+ ******************************************************************/
+typedef struct SXFER_CONFIG {
+    SXFER_READ_FUNC read;       /**< Link read */
+    SXFER_SEND_FUNC send;       /**< Link send */
+    SXFER_START_FUNC start;     /**< Session start (optional) */
+    SXFER_WRITE_FUNC write;     /**< Data write */
+    SXFER_IDLE_FUNC idle;       /**< Writer idle work (optional) */
+    void *usr;                  /**< Passed to all callbacks */
+    uint32_t maxSize;           /**< Largest accepted image */
+    SXFER_SESSION *session;     /**< Resume state */
+} SXFER_CONFIG;
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!****************************************************************
+ * @brief  Receive a streaming transfer
+ *
+ * Blocks until the host finishes, aborts or goes silent for
+ * SXFER_RETRY_LIMIT timeouts.
+ *
+ * @param [in]  cfg  Receiver configuration
+ *
+ * @return Total image size on success, SXFER_ERROR_* otherwise
+ ******************************************************************/
+long sxfer_receive(const SXFER_CONFIG *cfg);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
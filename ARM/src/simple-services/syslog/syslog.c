@@ -28,30 +28,72 @@
 
     #define SYSLOG_CRITICAL_EXIT(x) \
         xSemaphoreGive(x)
+
+    #define SYSLOG_TICK() \
+        ((uint32_t)xTaskGetTickCountFromISR())
 #else
     #define SYSLOG_CRITICAL_ENTRY(x)
     #define SYSLOG_CRITICAL_EXIT(x)
+    #define SYSLOG_TICK() (0)
 #endif
 
 /* TODO: abstract out mutex create/destroy/type */
 
+#define SYSLOG_MAX_ARGS     (4)
+#define SYSLOG_ENTRY_SIZE   (32)
+#define SYSLOG_MASK         (SYSLOG_MAX_LINES - 1)
+
+/* Text bytes held by the first and each following entry of a string */
+#define SYSLOG_TEXT_FIRST   ((SYSLOG_MAX_ARGS - 1) * sizeof(uint32_t))
+#define SYSLOG_TEXT_CONT    (SYSLOG_ENTRY_SIZE - 2 * sizeof(uint32_t))
+
+/*
+ * 'seq' holds the entry's ticket + 1 once it is committed.  Writers
+ * first set it to the ticket itself, which no committed entry of
+ * this slot can hold, and publish it again after the payload so a
+ * reader seeing the same committed 'seq' before and after copying an
+ * entry has a consistent copy.
+ *
+ * String entries place the length in args[0] and the text in the rest
+ * of the entry and in as many following continuation entries as
+ * needed.  Continuation entries are marked by their 'fmt' so a reader
+ * resyncing after lost entries never takes one for a record.
+ */
+typedef struct _SYSLOG_ENTRY {
+    volatile uint32_t seq;
+    union {
+        struct {
+            const char *fmt;
+            uint32_t ts;
+            uint32_t tick;
+            uint32_t args[SYSLOG_MAX_ARGS];
+        } e;
+        struct {
+            const char *fmt;
+            char text[SYSLOG_TEXT_CONT];
+        } c;
+    } u;
+} SYSLOG_ENTRY;
+
 typedef struct _SYSLOG_CONTEXT {
 #ifdef FREE_RTOS
     SemaphoreHandle_t lock;
 #endif
     char *name;
-    uint32_t headIdx;
-    uint32_t tailIdx;
-    uint32_t seq;
+    uint32_t head;
+    uint32_t tail;
     int32_t logDropped;
-    uint64_t *tsData;
-    char *logData;
+    SYSLOG_ENTRY *logData;
 } SYSLOG_CONTEXT;
 
 SYSLOG_CONTEXT consoleLog = {
     .name = SYSLOG_NAME
 };
 
+/* Format pointers marking the first and following entries of a string */
+static const char syslogTextFmt[] = "%s";
+static const char syslogContFmt[] = "";
+
 void syslog_init(void)
 {
     SYSLOG_CONTEXT *log = &consoleLog;
@@ -59,46 +101,109 @@ void syslog_init(void)
 #ifdef FREE_RTOS
     log->lock = xSemaphoreCreateMutex();
 #endif
-    log->headIdx = 0;
-    log->tailIdx = 0;
+    log->head = 0;
+    log->tail = 0;
     log->logDropped = 0;
-    log->seq = 0;
-    log->logData = SYSLOG_MALLOC(SYSLOG_MAX_LINES * SYSLOG_LINE_MAX);
-    log->tsData = SYSLOG_MALLOC(SYSLOG_MAX_LINES * sizeof(*(log->tsData)));
+    log->logData = SYSLOG_MALLOC(SYSLOG_MAX_LINES * sizeof(*log->logData));
+    memset(log->logData, 0, SYSLOG_MAX_LINES * sizeof(*log->logData));
+}
+
+/***********************************************************************
+ * Producer side (lock-free, ISR safe)
+ **********************************************************************/
+static inline uint32_t syslog_reserve(SYSLOG_CONTEXT *log, unsigned n)
+{
+    return __atomic_fetch_add(&log->head, n, __ATOMIC_RELAXED);
+}
+
+/* Mark an entry as being written before touching its payload */
+static inline void syslog_claim(SYSLOG_CONTEXT *log, uint32_t ticket)
+{
+    __atomic_store_n(&log->logData[ticket & SYSLOG_MASK].seq,
+        ticket, __ATOMIC_RELAXED);
+}
+
+static inline void syslog_commit(SYSLOG_CONTEXT *log, uint32_t ticket)
+{
+    __atomic_store_n(&log->logData[ticket & SYSLOG_MASK].seq,
+        ticket + 1, __ATOMIC_RELEASE);
+}
+
+void syslog_log_args(unsigned nargs, const char *fmt, ...)
+{
+    SYSLOG_CONTEXT *log = &consoleLog;
+    SYSLOG_ENTRY *entry;
+    uint32_t ticket;
+    va_list args;
+    unsigned i;
+
+    if (log->logData == NULL) {
+        return;
+    }
+
+    ticket = syslog_reserve(log, 1);
+    entry = &log->logData[ticket & SYSLOG_MASK];
+
+    syslog_claim(log, ticket);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    entry->u.e.fmt = fmt;
+    entry->u.e.ts = SYSLOG_TIMESTAMP();
+    entry->u.e.tick = SYSLOG_TICK();
+    va_start(args, fmt);
+    for (i = 0; i < SYSLOG_MAX_ARGS; i++) {
+        entry->u.e.args[i] = (i < nargs) ? va_arg(args, uint32_t) : 0;
+    }
+    va_end(args);
+
+    syslog_commit(log, ticket);
 }
 
 void syslog_print(char *msg)
 {
     SYSLOG_CONTEXT *log = &consoleLog;
-    char *start, *end;
+    SYSLOG_ENTRY *entry;
+    uint32_t ticket;
+    unsigned len, n, i, cnt;
 
-    SYSLOG_CRITICAL_ENTRY(log->lock);
+    if (log->logData == NULL) {
+        return;
+    }
 
-    log->headIdx++;
-    if (log->headIdx == SYSLOG_MAX_LINES) {
-        log->headIdx = 0;
+    len = strnlen(msg, SYSLOG_LINE_MAX - 1);
+    n = 1;
+    if (len > SYSLOG_TEXT_FIRST) {
+        n += (len - SYSLOG_TEXT_FIRST + SYSLOG_TEXT_CONT - 1) / SYSLOG_TEXT_CONT;
     }
 
-    if (log->headIdx == log->tailIdx) {
-        log->tailIdx++;
-        if (log->tailIdx == SYSLOG_MAX_LINES) {
-            log->tailIdx = 0;
-        }
-        log->logDropped++;
+    ticket = syslog_reserve(log, n);
+
+    for (i = 0; i < n; i++) {
+        syslog_claim(log, ticket + i);
     }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
 
-    start = &log->logData[log->headIdx * SYSLOG_LINE_MAX];
-    end = start + SYSLOG_LINE_MAX - 1;
-    strncpy(start, msg, SYSLOG_LINE_MAX); *end = 0;
-#ifdef FREE_RTOS
-    log->tsData[log->headIdx] = xTaskGetTickCount() / portTICK_PERIOD_MS;
-#else
-    log->tsData[log->headIdx] = log->seq;
-#endif
+    entry = &log->logData[ticket & SYSLOG_MASK];
+    entry->u.e.fmt = syslogTextFmt;
+    entry->u.e.ts = SYSLOG_TIMESTAMP();
+    entry->u.e.tick = SYSLOG_TICK();
+    entry->u.e.args[0] = len;
+    cnt = (len < SYSLOG_TEXT_FIRST) ? len : SYSLOG_TEXT_FIRST;
+    memcpy(&entry->u.e.args[1], msg, cnt);
+    msg += cnt; len -= cnt;
 
-    log->seq++;
+    for (i = 1; i < n; i++) {
+        entry = &log->logData[(ticket + i) & SYSLOG_MASK];
+        entry->u.c.fmt = syslogContFmt;
+        cnt = (len < SYSLOG_TEXT_CONT) ? len : SYSLOG_TEXT_CONT;
+        memcpy(entry->u.c.text, msg, cnt);
+        msg += cnt; len -= cnt;
+    }
 
-    SYSLOG_CRITICAL_EXIT(log->lock);
+    /* Commit the continuation entries first so the head is the gate */
+    for (i = n; i > 0; i--) {
+        syslog_commit(log, ticket + i - 1);
+    }
 }
 
 void syslog_printf(char *fmt, ...)
@@ -113,38 +218,188 @@ void syslog_printf(char *fmt, ...)
     syslog_print(line);
 }
 
+/***********************************************************************
+ * Consumer side
+ **********************************************************************/
+typedef enum _SYSLOG_READ {
+    SYSLOG_READ_OK,
+    SYSLOG_READ_BUSY,
+    SYSLOG_READ_LOST
+} SYSLOG_READ;
+
+/* Snapshot one committed entry, detecting concurrent overwrite */
+static SYSLOG_READ syslog_read_entry(SYSLOG_CONTEXT *log, uint32_t ticket,
+    SYSLOG_ENTRY *copy)
+{
+    SYSLOG_ENTRY *entry = &log->logData[ticket & SYSLOG_MASK];
+    uint32_t seq;
+
+    seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+    if (seq != ticket + 1) {
+        return (((int32_t)(seq - (ticket + 1))) > 0) ?
+            SYSLOG_READ_LOST : SYSLOG_READ_BUSY;
+    }
+    memcpy(copy, entry, sizeof(*copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (entry->seq != seq) {
+        return(SYSLOG_READ_LOST);
+    }
+
+    return(SYSLOG_READ_OK);
+}
+
+/*
+ * Reads the next record at log->tail into 'line'.  Returns the number
+ * of entries consumed, 0 if the next record is still being written.
+ */
+static unsigned syslog_read_record(SYSLOG_CONTEXT *log, char *line,
+    uint32_t *ts, uint32_t *tick, SYSLOG_READ *result)
+{
+    SYSLOG_ENTRY first, cont;
+    uint32_t ticket = log->tail;
+    unsigned len, n, i, cnt;
+    char *p;
+
+    *result = syslog_read_entry(log, ticket, &first);
+    if (*result != SYSLOG_READ_OK) {
+        return((*result == SYSLOG_READ_LOST) ? 1 : 0);
+    }
+
+    /* Resynced into the middle of a string, skip its remains */
+    if (first.u.e.fmt == syslogContFmt) {
+        *result = SYSLOG_READ_LOST;
+        return(1);
+    }
+
+    *ts = first.u.e.ts;
+    *tick = first.u.e.tick;
+
+    if (first.u.e.fmt != syslogTextFmt) {
+        snprintf(line, SYSLOG_LINE_MAX, first.u.e.fmt,
+            first.u.e.args[0], first.u.e.args[1],
+            first.u.e.args[2], first.u.e.args[3]);
+        return(1);
+    }
+
+    len = first.u.e.args[0];
+    if (len > SYSLOG_LINE_MAX - 1) {
+        *result = SYSLOG_READ_LOST;
+        return(1);
+    }
+    n = 1;
+    if (len > SYSLOG_TEXT_FIRST) {
+        n += (len - SYSLOG_TEXT_FIRST + SYSLOG_TEXT_CONT - 1) / SYSLOG_TEXT_CONT;
+    }
+
+    p = line;
+    cnt = (len < SYSLOG_TEXT_FIRST) ? len : SYSLOG_TEXT_FIRST;
+    memcpy(p, &first.u.e.args[1], cnt);
+    p += cnt; len -= cnt;
+
+    for (i = 1; i < n; i++) {
+        *result = syslog_read_entry(log, ticket + i, &cont);
+        if (*result == SYSLOG_READ_BUSY) {
+            return(0);
+        } else if (*result == SYSLOG_READ_LOST) {
+            return(i + 1);
+        }
+        if (cont.u.c.fmt != syslogContFmt) {
+            *result = SYSLOG_READ_LOST;
+            return(i);
+        }
+        cnt = (len < SYSLOG_TEXT_CONT) ? len : SYSLOG_TEXT_CONT;
+        memcpy(p, cont.u.c.text, cnt);
+        p += cnt; len -= cnt;
+    }
+    *p = 0;
+
+    return(n);
+}
+
+#if defined(FREE_RTOS) && SYSLOG_TIMESTAMP_HZ
+/* Extend the 32-bit timestamp to 64-bits using the coarse tick */
+static uint64_t syslog_timestamp(uint32_t ts, uint32_t tick)
+{
+    uint64_t approx;
+    int64_t diff;
+    uint64_t wraps;
+
+    approx = (uint64_t)tick * SYSLOG_TIMESTAMP_HZ / configTICK_RATE_HZ;
+    diff = (int64_t)approx - (int64_t)ts;
+    wraps = (diff > 0) ? ((uint64_t)diff + 0x80000000ULL) >> 32 : 0;
+
+    return((wraps << 32) | ts);
+}
+#endif
+
 void syslog_dump(unsigned max)
 {
     SYSLOG_CONTEXT *log = &consoleLog;
-    uint64_t ts;
-    char *start;
+    SYSLOG_READ result;
+    uint32_t head;
+    uint32_t ts, tick;
+    int32_t dropped;
+    unsigned used;
     char *end;
     char *line;
     unsigned count = 0;
 
+    if (log->logData == NULL) {
+        return;
+    }
+
     line = SYSLOG_MALLOC(SYSLOG_LINE_MAX);
     SYSLOG_CRITICAL_ENTRY(log->lock);
-    while ((log->tailIdx != log->headIdx) && (count < max)) {
-        log->tailIdx++;
-        if (log->tailIdx == SYSLOG_MAX_LINES) {
-            log->tailIdx = 0;
+    while (count < max) {
+
+        /* Skip whatever the producers have lapped */
+        head = __atomic_load_n(&log->head, __ATOMIC_ACQUIRE);
+        if ((head - log->tail) > SYSLOG_MAX_LINES) {
+            log->logDropped += head - log->tail - SYSLOG_MAX_LINES;
+            log->tail = head - SYSLOG_MAX_LINES;
+        }
+        if (log->tail == head) {
+            break;
+        }
+
+        used = syslog_read_record(log, line, &ts, &tick, &result);
+        if (used == 0) {
+            break;
+        }
+        log->tail += used;
+        if (result == SYSLOG_READ_LOST) {
+            log->logDropped += used;
+            continue;
         }
-        ts = log->tsData[log->tailIdx];
-        start = &log->logData[log->tailIdx * SYSLOG_LINE_MAX];
-        strncpy(line, start, SYSLOG_LINE_MAX);
+
+        dropped = log->logDropped;
+        log->logDropped = 0;
         SYSLOG_CRITICAL_EXIT(log->lock);
+
+        if (dropped) {
+            printf("[ %ld log entries dropped ]\n", (long)dropped);
+        }
         end = line + strlen(line) - 1;
-        while (isspace((int)(*end))) {
+        while ((end >= line) && isspace((int)(*end))) {
             *end = 0;
             end--;
         }
 #ifdef FREE_RTOS
-        uint64_t ts_sec, ts_ms;
-        ts_sec = ts / 1000;
-        ts_ms = ts - ts_sec * 1000;
-        printf("[%6llu.%03llu] ", ts_sec, ts_ms);
+        uint64_t ts_sec, ts_frac;
+#if SYSLOG_TIMESTAMP_HZ
+        uint64_t t = syslog_timestamp(ts, tick);
+        ts_sec = t / SYSLOG_TIMESTAMP_HZ;
+        ts_frac = ((t - ts_sec * SYSLOG_TIMESTAMP_HZ) * 1000000ULL) /
+            SYSLOG_TIMESTAMP_HZ;
+        printf("[%6llu.%06llu] ", ts_sec, ts_frac);
+#else
+        uint64_t ms = (uint64_t)tick * portTICK_PERIOD_MS;
+        ts_sec = ms / 1000;
+        ts_frac = ms - ts_sec * 1000;
+        printf("[%6llu.%03llu] ", ts_sec, ts_frac);
+#endif
 #else
-        printf("[%9llu] ", ts);
+        printf("[%9lu] ", (unsigned long)(log->tail - used));
 #endif
         puts(line);
         count++;
@@ -14,6 +14,11 @@
  *
  * This logger supports FreeRTOS and bare-metal projects.
  *
+ * Log entries are kept in a lock-free binary ring.  syslog_log()
+ * stores only a format string pointer, a timestamp and up to four
+ * raw 32-bit arguments, so it is safe and cheap to call from any
+ * task or ISR.  Formatting is deferred until syslog_dump().
+ *
  * @file      syslog.h
  * @version   1.0.0
  * @copyright 2018 Analog Devices, Inc.  All rights reserved.
@@ -26,10 +31,14 @@
 #define SYSLOG_H_
 
 /*!****************************************************************
- * @brief  The maximum number of entries in the syslog FIFO
+ * @brief  The number of 32 byte entries in the syslog ring.
+ *
+ * Must be a power of two.  A syslog_log() call uses one entry,
+ * syslog_print() / syslog_printf() text uses one entry plus one
+ * per 24 characters beyond the first 12.
  ******************************************************************/
 #ifndef SYSLOG_MAX_LINES
-#define SYSLOG_MAX_LINES   (1000)
+#define SYSLOG_MAX_LINES   (1024)
 #endif
 
 /*!****************************************************************
@@ -57,7 +66,19 @@
  * otherwise.
  ******************************************************************/
 #ifndef SYSLOG_FREE
-#define SYSLOG_FREE (x)    free(x)
+#define SYSLOG_FREE(x)     free(x)
+#endif
+
+/*!****************************************************************
+ * @brief  High resolution timestamp source and its rate in Hz.
+ *
+ * The 32-bit timestamp is extended to 64-bits on output using the
+ * RTOS tick, so it may wrap freely.  Leave undefined to log with
+ * tick (or sequence) resolution only.
+ ******************************************************************/
+#ifndef SYSLOG_TIMESTAMP
+#define SYSLOG_TIMESTAMP()   (0)
+#define SYSLOG_TIMESTAMP_HZ  (0)
 #endif
 
 /*!****************************************************************
@@ -79,13 +100,50 @@
  ******************************************************************/
 void syslog_init(void);
 
+/*!****************************************************************
+ * @brief  System log deferred print
+ *
+ * This macro records a format string and up to four integer or
+ * pointer arguments.  Formatting happens later in syslog_dump(),
+ * so 'fmt' and any "%s" arguments must point to memory which
+ * stays valid (i.e. string literals).  Floating point arguments
+ * are not supported; use syslog_printf() for those.
+ *
+ * This function is thread and ISR safe.
+ *
+ * @param [in]  fmt   Null-terminated format string
+ * @param [in]  ...   Up to four 32-bit arguments
+ *
+ ******************************************************************/
+#define syslog_log(...) \
+    syslog_log_args(SYSLOG_NARGS(__VA_ARGS__) + \
+        SYSLOG_NARGS_CHECK(__VA_ARGS__), __VA_ARGS__)
+
+/*! @cond */
+#define SYSLOG_NARGS(...) SYSLOG_NARGS_(__VA_ARGS__, \
+    16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+#define SYSLOG_NARGS_(fmt, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, \
+    _11, _12, _13, _14, _15, _16, n, ...) n
+
+/*
+ * Fails the build for five to sixteen arguments with a negative
+ * bit-field width.  Past sixteen the count is an argument, which
+ * fails as well unless it happens to be a small constant.
+ */
+#define SYSLOG_NARGS_CHECK(...) \
+    (0 * sizeof(struct { \
+        int syslog_log_takes_at_most_four_args : \
+            (SYSLOG_NARGS(__VA_ARGS__) <= 4) ? 1 : -1; }))
+void syslog_log_args(unsigned nargs, const char *fmt, ...);
+/*! @endcond */
+
 /*!****************************************************************
  * @brief  System log print
  *
- * This function prints a fixed string to the system log.  Strings
+ * This function copies a string into the system log.  Strings
  * which do not fit within the log line length will be truncated.
  *
- * This function is thread safe.
+ * This function is thread and ISR safe.
  *
  * @param [in]   msg     Null-terminated string to save in the log
  *
@@ -97,7 +155,8 @@ void syslog_print(char *msg);
  *
  * This function prints a variable argument string to the system
  * log.  Strings which do not fit within the log line length
- * will be truncated.
+ * will be truncated.  The string is formatted in the caller's
+ * context; prefer syslog_log() in time critical code.
  *
  * This function is thread safe.
  *
@@ -16,6 +16,7 @@ CDC_TX_COMPLETE_CALLBACK txCB = NULL;
 void *txUsrPtr = NULL;
 
 CDC_RX_COMPLETE_CALLBACK rxCB = NULL;
+CDC_RX_SPACE_CALLBACK rxSpaceCB = NULL;
 void *rxUsrPtr = NULL;
 unsigned short cdc_rx_bytes;
 
@@ -76,6 +77,12 @@ cdc_serial_data_rx_transfer_complete(void)
 CLD_USB_Transfer_Request_Return_Type
 cdc_serial_data_received(CLD_USB_Transfer_Params *p_transfer_data)
 {
+    /* NAK the host until the receiver has room for this transfer */
+    if (rxSpaceCB) {
+        if (!rxSpaceCB(p_transfer_data->num_bytes, rxUsrPtr)) {
+            return CLD_USB_TRANSFER_PAUSE;
+        }
+    }
     p_transfer_data->p_data_buffer = cdc_rx_buffer;
     p_transfer_data->callback.fp_usb_out_transfer_complete = cdc_serial_data_rx_transfer_complete;
     p_transfer_data->fp_transfer_aborted_callback = CLD_NULL;
@@ -164,3 +171,13 @@ void cdc_register_rx_callback(CDC_RX_COMPLETE_CALLBACK cb, void *usrPtr)
     rxCB = cb;
     rxUsrPtr = usrPtr;
 }
+
+void cdc_register_rx_space_callback(CDC_RX_SPACE_CALLBACK cb)
+{
+    rxSpaceCB = cb;
+}
+
+void cdc_rx_resume(void)
+{
+    cld_sc58x_audio_2_0_w_cdc_lib_resume_paused_serial_data_transfer();
+}
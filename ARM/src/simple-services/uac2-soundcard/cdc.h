@@ -12,6 +12,8 @@
 #ifndef _cdc_h
 #define _cdc_h
 
+#include <stdbool.h>
+
 #include "cld_lib.h"
 
 /***********************************************************************
@@ -69,12 +71,15 @@ typedef enum _CDC_TX_STATUS {
 typedef void (*CDC_TX_COMPLETE_CALLBACK)(CDC_TX_STATUS status, void *usrPtr);
 typedef void (*CDC_RX_COMPLETE_CALLBACK)(unsigned char *p_buffer,
     unsigned short length, void *usrPtr);
+typedef bool (*CDC_RX_SPACE_CALLBACK)(unsigned short length, void *usrPtr);
 
 CLD_USB_Data_Transmit_Return_Type cdc_tx_serial_data(unsigned short length,
     unsigned char *p_buffer, unsigned timeout);
 
 void cdc_register_tx_callback(CDC_TX_COMPLETE_CALLBACK cb, void *usrPtr);
 void cdc_register_rx_callback(CDC_RX_COMPLETE_CALLBACK cb, void *usrPtr);
+void cdc_register_rx_space_callback(CDC_RX_SPACE_CALLBACK cb);
+void cdc_rx_resume(void);
 
 #ifdef __cplusplus
 } // extern "C"
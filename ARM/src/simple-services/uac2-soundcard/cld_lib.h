@@ -54,6 +54,8 @@
         cld_sc57x_audio_2_0_w_cdc_lib_init
     #define cld_sc58x_audio_2_0_w_cdc_lib_main \
         cld_sc57x_audio_2_0_w_cdc_lib_main
+    #define cld_sc58x_audio_2_0_w_cdc_lib_resume_paused_serial_data_transfer \
+        cld_sc57x_audio_2_0_w_cdc_lib_resume_paused_serial_data_transfer
 
 #endif
 
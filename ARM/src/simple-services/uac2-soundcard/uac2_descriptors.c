@@ -95,7 +95,7 @@ uac2_feature_unit_descriptor *newFeatureUnitDescriptor (
 }
 
 uac2_clock_source_descriptor *newClockSourceDescriptor (
-    uint8_t bClockID
+    uint8_t bClockID, bool programmable
 )
 {
     uac2_clock_source_descriptor *cs;
@@ -107,9 +107,18 @@ uac2_clock_source_descriptor *newClockSourceDescriptor (
     cs->bDescriptorSubtype = UAC_CLOCK_SOURCE;
     cs->bClockID = bClockID;
 
+    /* Let the host select the sampling frequency if more than one
+     * rate is supported.
+     */
+    if (programmable) {
+        cs->bmAttributes = UAC_CLOCK_SOURCE_TYPE_INT_PROG;
+        cs->bmControls = UAC_CLOCK_SOURCE_CONTROL_PROG;
+    } else {
+        cs->bmAttributes = UAC_CLOCK_SOURCE_TYPE_INT_FIXED;
+        cs->bmControls = UAC_CLOCK_SOURCE_CONTROL_READ_ONLY;
+    }
+
     /* Fixed / Unsuported values */
-    cs->bmAttributes = UAC_CLOCK_SOURCE_TYPE_INT_FIXED;
-    cs->bmControls = UAC_CLOCK_SOURCE_CONTROL_READ_ONLY;
     cs->bAssocTerminal = 0;
     cs->iClockSource = 0;
 
@@ -237,6 +246,39 @@ uint16_t calcMaxPktSize(uint16_t maxPktSize, uint16_t pktRate,
     return(pktSize);
 }
 
+/* Returns the high-speed payload per service interval, or zero if it
+ * does not fit, along with the endpoint's bInterval and wMaxPacketSize.
+ * A single transaction per microframe is used whenever it is enough.
+ * Otherwise the packet goes out every microframe in up to
+ * UAC2_HS_MAX_TRANSACTIONS equal transactions.
+ */
+uint16_t calcMaxPktSizeHigh(uint32_t sampleRate, uint16_t frameSize,
+    bool lowLatency, uint8_t *bInterval, uint16_t *wMaxPacketSize)
+{
+    uint16_t pktSize;
+    uint16_t transactions;
+
+    pktSize = calcMaxPktSize(UAC2_HS_MAX_PKT_SIZE, 8000, sampleRate,
+        frameSize, lowLatency, bInterval);
+    if (pktSize) {
+        *wMaxPacketSize = pktSize;
+        return(pktSize);
+    }
+
+    pktSize = calcMaxPktSize(UAC2_HS_MAX_PAYLOAD, 8000, sampleRate,
+        frameSize, true, bInterval);
+    if (pktSize == 0) {
+        *wMaxPacketSize = 0;
+        return(0);
+    }
+
+    transactions = (pktSize + UAC2_HS_MAX_PKT_SIZE - 1) / UAC2_HS_MAX_PKT_SIZE;
+    *wMaxPacketSize = ((transactions - 1) << 11) |
+        ((pktSize + transactions - 1) / transactions);
+
+    return(pktSize);
+}
+
 CLD_SC58x_Audio_2_0_Stream_Interface_Params *newStreamInterfaceParams(
     uint8_t endpointNumber, uint8_t bTerminalID,
     uint16_t *minPacketSizeFull, uint16_t *maxPacketSizeFull,
@@ -247,6 +289,7 @@ CLD_SC58x_Audio_2_0_Stream_Interface_Params *newStreamInterfaceParams(
 )
 {
     CLD_SC58x_Audio_2_0_Stream_Interface_Params *i;
+    uint16_t maxPayloadHigh;
     uint16_t frameSize;
 
     i = UAC20_DESCRIPTORS_CALLOC(1, sizeof(*i));
@@ -259,9 +302,9 @@ CLD_SC58x_Audio_2_0_Stream_Interface_Params *newStreamInterfaceParams(
         1023, 1000, sampleRate, frameSize,
         lowLatency, &i->b_interval_full_speed
     );
-    i->max_packet_size_high_speed = calcMaxPktSize(
-        1024, 8000, sampleRate, frameSize,
-        lowLatency, &i->b_interval_high_speed
+    maxPayloadHigh = calcMaxPktSizeHigh(
+        sampleRate, frameSize, lowLatency,
+        &i->b_interval_high_speed, &i->max_packet_size_high_speed
     );
 
     /* Set members */
@@ -288,11 +331,11 @@ CLD_SC58x_Audio_2_0_Stream_Interface_Params *newStreamInterfaceParams(
         }
     }
     if (maxPacketSizeHigh) {
-        *maxPacketSizeHigh = i->max_packet_size_high_speed;
+        *maxPacketSizeHigh = maxPayloadHigh;
     }
     if (minPacketSizeHigh) {
-        if (i->max_packet_size_high_speed) {
-            *minPacketSizeHigh = i->max_packet_size_high_speed - 2 * frameSize;
+        if (maxPayloadHigh) {
+            *minPacketSizeHigh = maxPayloadHigh - 2 * frameSize;
         } else {
             *minPacketSizeHigh = 0;
         }
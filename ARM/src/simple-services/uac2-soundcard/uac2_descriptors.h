@@ -30,6 +30,15 @@
 #define UAC_CS_INTERFACE                    0x24
 #define UAC_CS_ENDPOINT                     0x25
 
+/* High-speed isochronous packets: up to three 1024 byte transactions
+ * per microframe (USB 2.0 Spec, 5.9.2 High Bandwidth Endpoints).
+ * wMaxPacketSize carries the extra transactions in bits 12..11.
+ */
+#define UAC2_HS_MAX_PKT_SIZE                1024
+#define UAC2_HS_MAX_TRANSACTIONS            3
+#define UAC2_HS_MAX_PAYLOAD \
+    (UAC2_HS_MAX_PKT_SIZE * UAC2_HS_MAX_TRANSACTIONS)
+
 /* Audio Class Specific Interface Descriptor Subtypes */
 #define UAC_INPUT_TERMINAL                  0x02
 #define UAC_OUTPUT_TERMINAL                 0x03
@@ -38,9 +47,19 @@
 
 /* Clock source types */
 #define UAC_CLOCK_SOURCE_TYPE_INT_FIXED     0x01
+#define UAC_CLOCK_SOURCE_TYPE_INT_PROG      0x03
 
 /* Clock source controls */
 #define UAC_CLOCK_SOURCE_CONTROL_READ_ONLY  0x01
+#define UAC_CLOCK_SOURCE_CONTROL_PROG       0x03
+
+/* Clock source control selectors */
+#define UAC_CS_SAM_FREQ_CONTROL             0x01
+
+/* Maximum number of discrete sample rates reported by a clock source */
+#ifndef UAC2_MAX_SAMPLE_RATES
+#define UAC2_MAX_SAMPLE_RATES               (4)
+#endif
 
 /* Audio Class Specific Interface Descriptor Subtypes */
 #define UAC_FORMAT_TYPE                     0x02
@@ -120,7 +139,7 @@ typedef struct {
         uint32_t   wMIN;
         uint32_t   wMAX;
         uint32_t   wRES;
-    } sub_ranges[1];
+    } sub_ranges[UAC2_MAX_SAMPLE_RATES];
 } uac2_4_byte_control_range_parameter_block;
 
 /* Structure used to report 16-bit USB Audio 2.0 range values */
@@ -169,7 +188,7 @@ uac2_feature_unit_descriptor *newFeatureUnitDescriptor (
 );
 
 uac2_clock_source_descriptor *newClockSourceDescriptor (
-    uint8_t bClockID
+    uint8_t bClockID, bool programmable
 );
 
 uac2_format_type_i_descriptor *newFormatTypeIDescriptor (
@@ -181,6 +200,13 @@ CLD_SC58x_Audio_2_0_Audio_Stream_Data_Endpoint_Descriptor
     uint8_t bLockDelayUnits, uint8_t wLockDelay
 );
 
+uint16_t calcMaxPktSize(uint16_t maxPktSize, uint16_t pktRate,
+    uint32_t sampleRate, uint16_t frameSize,
+    bool lowLatency, uint8_t *bInterval);
+
+uint16_t calcMaxPktSizeHigh(uint32_t sampleRate, uint16_t frameSize,
+    bool lowLatency, uint8_t *bInterval, uint16_t *wMaxPacketSize);
+
 CLD_SC58x_Audio_2_0_Stream_Interface_Params *newStreamInterfaceParams(
     uint8_t endpointNumber, uint8_t bTerminalID,
     uint16_t *minPacketSizeFull, uint16_t *maxPacketSizeFull,
@@ -62,7 +62,7 @@
 
 /* Basic settings (do not modify) */
 #define USB_RATE_FEEDBACK_RATE_MS  1      // Slowest high-speed rate Windows allows
-#define USB_MAX_PACKET_SIZE        1024   // Largest full/high speed packet
+#define USB_MAX_PACKET_SIZE        UAC2_HS_MAX_PAYLOAD  // Largest full/high speed payload
 
 /* USB IN Endpoint settings */
 #define USB_IN_ENDPOINT_ID         0x02
@@ -130,10 +130,10 @@ typedef struct
  */
 typedef struct
 {
-    uint32_t current;
-    uint32_t min;                 /*!< Clock source range minimum setting */
-    uint32_t max;                 /*!< Clock source range maximum setting */
-    uint32_t resolution;          /*!< Clock source range resolution */
+    uint32_t current;             /*!< Current sample rate */
+    uint32_t request;             /*!< Sample rate received from the host */
+    uint32_t rates[UAC2_MAX_SAMPLE_RATES]; /*!< Supported sample rates */
+    uint8_t numRates;             /*!< Number of supported sample rates */
 } UAC2_CLOCK_SOURCE;
 
 /**
@@ -146,6 +146,7 @@ typedef struct
     UAC2_VOLUME speaker_output_volume;
     UAC2_VOLUME mic_input_volume;
     UAC2_CLOCK_SOURCE clock_source;
+    CLD_Boolean highSpeed;
 
     CLD_Boolean in_enabled;
     CLD_Boolean in_idle;
@@ -159,6 +160,9 @@ typedef struct
     uint16_t maxInSizeFull;
     uint16_t minInSizeHigh;
     uint16_t maxInSizeHigh;
+    uint16_t inFrameSize;
+    uint8_t inIntervalFull;
+    uint8_t inIntervalHigh;
 
     CLD_Boolean inPktFirst;
     uint32_t inPktLastTime;
@@ -175,6 +179,9 @@ typedef struct
     uint16_t maxOutSizeFull;
     uint16_t minOutSizeHigh;
     uint16_t maxOutSizeHigh;
+    uint16_t outFrameSize;
+    uint8_t outIntervalFull;
+    uint8_t outIntervalHigh;
 
     CLD_Boolean outPktFirst;
     uint32_t outPktLastTime;
@@ -187,10 +194,6 @@ typedef struct
     UAC2_APP_CONFIG cfg;
     ADI_TMR_HANDLE periodic_timer_handle;
 
-    char *syslog[UAC2_SYSLOG_DEPTH];
-    uint8_t syslogHead;
-    uint8_t syslogTail;
-
 } UAC2_STATE;
 
 /*
@@ -216,6 +219,7 @@ static UAC2_STATE uac2_state;
 static void uac2_feedback_xfr_done (void)
 {
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -226,7 +230,7 @@ static void uac2_feedback_xfr_done (void)
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "usbFeedbackTx", outCycles - inCycles);
 }
 
 /**
@@ -248,7 +252,7 @@ static void uac2_tx_feedback_data ( void )
          uac2_state.rate_feedback_idle == CLD_TRUE) {
         if (uac2_state.first_feedback == CLD_TRUE) {
             feedback_transfer_data.desired_data_rate =
-                (float)uac2_state.cfg.usbSampleRate / 1000.0f;
+                (float)uac2_state.clock_source.current / 1000.0f;
         } else {
             if (uac2_state.cfg.rateFeedbackCallback) {
                 rate = uac2_state.cfg.rateFeedbackCallback(uac2_state.cfg.usrPtr);
@@ -276,6 +280,7 @@ static void uac2_tx_feedback_data ( void )
 static void uac2_audio_stream_data_transmitted (void)
 {
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -311,7 +316,7 @@ static void uac2_audio_stream_data_transmitted (void)
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "usbTxDone", outCycles - inCycles);
 }
 
 /**
@@ -322,6 +327,7 @@ static void uac2_audio_stream_data_transmitted (void)
 static void uac2_audio_stream_data_transmitted_X (void)
 {
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -346,7 +352,7 @@ static void uac2_audio_stream_data_transmitted_X (void)
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "usbTxDoneX", outCycles - inCycles);
 }
 
 /**
@@ -356,6 +362,7 @@ static void uac2_audio_stream_data_transmitted_X (void)
 static void uac2_audio_stream_data_transmit_aborted (void)
 {
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -382,7 +389,7 @@ static void uac2_audio_stream_data_transmit_aborted (void)
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "usbTxAbort", outCycles - inCycles);
 }
 
 /**
@@ -391,6 +398,7 @@ static void uac2_audio_stream_data_transmit_aborted (void)
 static void uac2_audio_stream_data_transmit_aborted_X (void)
 {
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -400,7 +408,7 @@ static void uac2_audio_stream_data_transmit_aborted_X (void)
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "usbTxAbortX", outCycles - inCycles);
 }
 
 /**
@@ -477,6 +485,7 @@ static void uac2_tx_audio_data (void)
 static CLD_USB_Data_Received_Return_Type uac2_stream_data_receive_complete (void)
 {
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
     void *nextData;
 
     /* Track ISR cycle count for CPU load */
@@ -518,7 +527,7 @@ static CLD_USB_Data_Received_Return_Type uac2_stream_data_receive_complete (void
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "usbRxDone", outCycles - inCycles);
 
     return CLD_USB_DATA_GOOD;
 }
@@ -568,6 +577,101 @@ static CLD_USB_Transfer_Request_Return_Type uac2_stream_data_received (CLD_USB_T
     return CLD_USB_TRANSFER_ACCEPT;
 }
 
+/*************************************************************************
+ * Clock source / sample rate functions
+ *************************************************************************/
+
+/**
+ * Calculates a +/- one frame packet size window for the current sample
+ * rate using the packet interval fixed in the endpoint descriptors.
+ */
+static void uac2_pkt_size(uint32_t rate, uint16_t frameSize, uint8_t bInterval,
+    uint16_t maxPktSize, uint16_t *minSize, uint16_t *maxSize)
+{
+    uint16_t pktRate;
+    uint16_t size;
+
+    if ((maxPktSize == 0) || (bInterval == 0)) {
+        *minSize = 0;
+        *maxSize = 0;
+        return;
+    }
+
+    pktRate = (uac2_state.highSpeed == CLD_TRUE) ? 8000 : 1000;
+    size = (rate / pktRate) * (1 << (bInterval - 1)) * frameSize;
+
+    *minSize = size - frameSize;
+    *maxSize = size + frameSize;
+}
+
+/**
+ * Updates the active IN/OUT packet size limits following a bus speed or
+ * sample rate change.
+ */
+static void uac2_update_pkt_sizes(void)
+{
+    uint32_t rate = uac2_state.clock_source.current;
+
+    if (uac2_state.highSpeed == CLD_TRUE) {
+        uac2_pkt_size(rate, uac2_state.inFrameSize, uac2_state.inIntervalHigh,
+            uac2_state.maxInSizeHigh, &uac2_state.minInSize, &uac2_state.maxInSize);
+        uac2_pkt_size(rate, uac2_state.outFrameSize, uac2_state.outIntervalHigh,
+            uac2_state.maxOutSizeHigh, &uac2_state.minOutSize, &uac2_state.maxOutSize);
+    } else {
+        uac2_pkt_size(rate, uac2_state.inFrameSize, uac2_state.inIntervalFull,
+            uac2_state.maxInSizeFull, &uac2_state.minInSize, &uac2_state.maxInSize);
+        uac2_pkt_size(rate, uac2_state.outFrameSize, uac2_state.outIntervalFull,
+            uac2_state.maxOutSizeFull, &uac2_state.minOutSize, &uac2_state.maxOutSize);
+    }
+}
+
+/**
+ * Returns CLD_TRUE if 'rate' is one of the configured sample rates.
+ */
+static CLD_Boolean uac2_rate_supported(uint32_t rate)
+{
+    uint8_t i;
+
+    for (i = 0; i < uac2_state.clock_source.numRates; i++) {
+        if (uac2_state.clock_source.rates[i] == rate) {
+            return(CLD_TRUE);
+        }
+    }
+    return(CLD_FALSE);
+}
+
+/**
+ * This function is called by the CLD Audio library when a Set Sampling
+ * Frequency request data has been completed.  Both clock sources share
+ * a single rate.
+ *
+ * @retval CLD_USB_DATA_GOOD - Received data is valid.
+ * @retval CLD_USB_DATA_BAD_STALL - Received data is invalid.
+ */
+static CLD_USB_Data_Received_Return_Type uac2_set_clock_req (void)
+{
+    UAC2_CLOCK_SOURCE *clockSource = &uac2_state.clock_source;
+    uint32_t rate = clockSource->request;
+
+    if (uac2_rate_supported(rate) == CLD_FALSE) {
+        return CLD_USB_DATA_BAD_STALL;
+    }
+
+    if (rate != clockSource->current) {
+        if (uac2_state.cfg.sampleRateCallback) {
+            if (!uac2_state.cfg.sampleRateCallback(rate, uac2_state.cfg.usrPtr)) {
+                return CLD_USB_DATA_BAD_STALL;
+            }
+        }
+        clockSource->current = rate;
+        uac2_state.cfg.usbSampleRate = rate;
+        uac2_state.first_feedback = CLD_TRUE;
+        uac2_update_pkt_sizes();
+    }
+
+    return CLD_USB_DATA_GOOD;
+}
+
 /*************************************************************************
  * Volume / Mute control functions
  *************************************************************************/
@@ -630,6 +734,7 @@ static CLD_USB_Transfer_Request_Return_Type uac2_set_req_cmd (CLD_SC58x_Audio_2_
     void *pDataBuffer;
     uint16_t numBytes;
     uint8_t maxChannels;
+    CLD_USB_Data_Received_Return_Type (*complete)(void);
 
     UAC2_VOLUME *featureUnit;
 
@@ -639,8 +744,9 @@ static CLD_USB_Transfer_Request_Return_Type uac2_set_req_cmd (CLD_SC58x_Audio_2_
     pDataBuffer = NULL;
     numBytes = 0;
     maxChannels = 0;
+    complete = uac2_set_volume_req;
 
-    /* Select to the correct Feature Unit */
+    /* Select to the correct Feature Unit or Clock Source */
     switch (p_req_params->entity_id) {
         case SPKR_FEATURE_UNIT_ID:
             featureUnit = &uac2_state.speaker_output_volume;
@@ -650,6 +756,17 @@ static CLD_USB_Transfer_Request_Return_Type uac2_set_req_cmd (CLD_SC58x_Audio_2_
             featureUnit = &uac2_state.mic_input_volume;
             maxChannels = uac2_state.cfg.usbInChannels + 1;
             break;
+        case MIC_CLOCK_SOURCE_ID:
+        case SPKR_CLOCK_SOURCE_ID:
+            controlSelector = (p_req_params->setup_packet_wValue >> 8) & 0xFF;
+            if ((p_req_params->req == CLD_REQ_CURRENT) &&
+                (controlSelector == UAC_CS_SAM_FREQ_CONTROL) &&
+                (uac2_state.clock_source.numRates > 1)) {
+                pDataBuffer = &uac2_state.clock_source.request;
+                numBytes = sizeof(uac2_state.clock_source.request);
+                complete = uac2_set_clock_req;
+            }
+            break;
         default:
             break;
     }
@@ -691,7 +808,7 @@ static CLD_USB_Transfer_Request_Return_Type uac2_set_req_cmd (CLD_SC58x_Audio_2_
         p_transfer_data->num_bytes = numBytes;
         p_transfer_data->transfer_timeout_ms = 0;
         p_transfer_data->fp_transfer_aborted_callback = CLD_NULL;
-        p_transfer_data->callback.fp_usb_out_transfer_complete = uac2_set_volume_req;
+        p_transfer_data->callback.fp_usb_out_transfer_complete = complete;
         rv = CLD_USB_TRANSFER_ACCEPT;
     }
 
@@ -749,6 +866,7 @@ static CLD_USB_Transfer_Request_Return_Type uac2_get_req_cmd (CLD_SC58x_Audio_2_
     void *pDataBuffer;
     uint16_t numBytes;
     uint8_t maxChannels;
+    uint8_t i;
 
     UAC2_VOLUME *featureUnit;
     UAC2_CLOCK_SOURCE *clockSource;
@@ -831,12 +949,15 @@ static CLD_USB_Transfer_Request_Return_Type uac2_get_req_cmd (CLD_SC58x_Audio_2_
 
         /* Clock Source range requests */
         if (p_req_params->req == CLD_REQ_RANGE) {
-            uac2_4_byte_range_resp.wNumSubRanges = 1;
-            uac2_4_byte_range_resp.sub_ranges[0].wMAX = clockSource->max;
-            uac2_4_byte_range_resp.sub_ranges[0].wMIN = clockSource->min;
-            uac2_4_byte_range_resp.sub_ranges[0].wRES = clockSource->resolution;
+            uac2_4_byte_range_resp.wNumSubRanges = clockSource->numRates;
+            for (i = 0; i < clockSource->numRates; i++) {
+                uac2_4_byte_range_resp.sub_ranges[i].wMAX = clockSource->rates[i];
+                uac2_4_byte_range_resp.sub_ranges[i].wMIN = clockSource->rates[i];
+                uac2_4_byte_range_resp.sub_ranges[i].wRES = 0;
+            }
             pDataBuffer = &uac2_4_byte_range_resp;
-            numBytes = sizeof(uac2_4_byte_range_resp);
+            numBytes = sizeof(uac2_4_byte_range_resp.wNumSubRanges) +
+                clockSource->numRates * sizeof(uac2_4_byte_range_resp.sub_ranges[0]);
 
         /* Clock Source current requests */
         } else if (p_req_params->req == CLD_REQ_CURRENT) {
@@ -976,17 +1097,11 @@ static void uac2_usb_event (CLD_USB_Event event)
         case CLD_USB_ENUMERATED_CONFIGURED:
             /* HACK: Get the speed directly from the peripheral */
             highSpeed = (*pREG_USB0_POWER & BITM_USB_POWER_HSEN);
+            uac2_state.highSpeed = highSpeed ? CLD_TRUE : CLD_FALSE;
+            uac2_update_pkt_sizes();
             if (highSpeed) {
-                uac2_state.minInSize = uac2_state.minInSizeHigh;
-                uac2_state.maxInSize = uac2_state.maxInSizeHigh;
-                uac2_state.minOutSize = uac2_state.minOutSizeHigh;
-                uac2_state.maxOutSize = uac2_state.maxOutSizeHigh;
                 uac2_syslog("UAC 2.0 High Speed Ready\n");
             } else {
-                uac2_state.minInSize = uac2_state.minInSizeFull;
-                uac2_state.maxInSize = uac2_state.maxInSizeFull;
-                uac2_state.minOutSize = uac2_state.minOutSizeFull;
-                uac2_state.maxOutSize = uac2_state.maxOutSizeFull;
                 uac2_syslog("UAC 2.0 Low Speed Ready\n");
             }
             break;
@@ -1007,10 +1122,7 @@ static void uac2_usb_event (CLD_USB_Event event)
 
 void uac2_syslog(char *log)
 {
-    uac2_state.syslog[uac2_state.syslogHead++] = log;
-    if (uac2_state.syslogHead == UAC2_SYSLOG_DEPTH) {
-        uac2_state.syslogHead = 0;
-    }
+    syslog_log("%s", log);
 }
 
 /**************************************************************************
@@ -1125,6 +1237,7 @@ static CLD_SC58x_Audio_2_0_w_CDC_Lib_Init_Params uac2_init_params =
 static void uac20_timer_handler(void *pCBParam, uint32_t Event, void *pArg)
 {
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     inCycles = cpuLoadGetTimeStamp();
 
@@ -1133,7 +1246,7 @@ static void uac20_timer_handler(void *pCBParam, uint32_t Event, void *pArg)
     }
 
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "usbTimer", outCycles - inCycles);
 }
 
 /**
@@ -1263,7 +1376,8 @@ unsigned char *createTerminalAndFeatureDescriptors(unsigned short *descriptorLen
     UAC20_DESCRIPTORS_FREE(micVolume);
 
     /* CLOCK SOURCE UNIT: cs1 */
-    cs1 = newClockSourceDescriptor(SPKR_CLOCK_SOURCE_ID);
+    cs1 = newClockSourceDescriptor(SPKR_CLOCK_SOURCE_ID,
+        uac2_state.clock_source.numRates > 1);
     length = cs1->bLength;
     descriptors = UAC20_DESCRIPTORS_REALLOC(descriptors, offset + length);
     UAC2_MEMCPY(descriptors + offset, cs1, length);
@@ -1271,7 +1385,8 @@ unsigned char *createTerminalAndFeatureDescriptors(unsigned short *descriptorLen
     UAC20_DESCRIPTORS_FREE(cs1);
 
     /* CLOCK SOURCE UNIT: cs2 */
-    cs2 = newClockSourceDescriptor(MIC_CLOCK_SOURCE_ID);
+    cs2 = newClockSourceDescriptor(MIC_CLOCK_SOURCE_ID,
+        uac2_state.clock_source.numRates > 1);
     length = cs2->bLength;
     descriptors = UAC20_DESCRIPTORS_REALLOC(descriptors, offset + length);
     UAC2_MEMCPY(descriptors + offset, cs2, length);
@@ -1319,9 +1434,7 @@ CLD_RV uac2_init(void)
     uac2_state.periodic_timer_handle = NULL;
     uac2_state.inPktFirst = CLD_TRUE;
     uac2_state.outPktFirst = CLD_TRUE;
-    memset(uac2_state.syslog, 0, sizeof(uac2_state.syslog));
-    uac2_state.syslogHead = 0;
-    uac2_state.syslogTail = 0;
+    uac2_state.highSpeed = CLD_FALSE;
 
     /* Initialize constant volume state:
      *
@@ -1343,21 +1456,82 @@ CLD_RV uac2_init(void)
     return(CLD_SUCCESS);
 }
 
+/**
+ * Returns true if a high-speed isochronous packet of 'frameSize' byte
+ * frames fits at 'rate', using high-bandwidth transactions if needed.
+ */
+static bool uac2_rate_fits(uint32_t rate, uint16_t frameSize, bool lowLatency)
+{
+    uint16_t wMaxPacketSize;
+    uint8_t bInterval;
+
+    return(calcMaxPktSizeHigh(rate, frameSize, lowLatency,
+        &bInterval, &wMaxPacketSize) != 0);
+}
+
+/**
+ * Returns the largest channel count (up to 'channels') whose high-speed
+ * isochronous packet fits at 'rate'.
+ */
+static uint8_t uac2_fit_channels(uint8_t channels, uint8_t subslotSize,
+    uint32_t rate, bool lowLatency)
+{
+    while ( (channels > 1) &&
+            !uac2_rate_fits(rate, subslotSize * channels, lowLatency) ) {
+        channels--;
+    }
+
+    return(channels);
+}
+
 /**
  * Configures the CLD SC58x USB Audio 2.0 library.
  */
 CLD_RV uac2_config(UAC2_APP_CONFIG *cfg)
 {
+    UAC2_CLOCK_SOURCE *clockSource = &uac2_state.clock_source;
+    uint32_t maxRate;
     uint8_t i;
 
     /* Copy in application configuration parameters */
     UAC2_MEMCPY(&uac2_state.cfg, cfg, sizeof(uac2_state.cfg));
 
-    /* Initialize clock source info */
-    uac2_state.clock_source.current = uac2_state.cfg.usbSampleRate;
-    uac2_state.clock_source.min = uac2_state.cfg.usbSampleRate;
-    uac2_state.clock_source.max = uac2_state.cfg.usbSampleRate;
-    uac2_state.clock_source.resolution = 0;
+    /* The format descriptors give the subslot sizes the channel counts
+     * are fitted with
+     */
+    uac2_format_type_i_descriptor *inFormatDescriptor =
+        newFormatTypeIDescriptor(cfg->usbInWordSizeBits);
+    uac2_format_type_i_descriptor *outFormatDescriptor =
+        newFormatTypeIDescriptor(cfg->usbOutWordSizeBits);
+
+    /* Initialize clock source info.  Fall back to the single fixed
+     * 'usbSampleRate' if no rate list is given.
+     */
+    clockSource->numRates = 0;
+    if (cfg->usbSampleRates) {
+        for (i = 0; i < cfg->usbNumSampleRates; i++) {
+            if (clockSource->numRates < UAC2_MAX_SAMPLE_RATES) {
+                clockSource->rates[clockSource->numRates++] =
+                    cfg->usbSampleRates[i];
+            }
+        }
+    }
+    if (clockSource->numRates == 0) {
+        clockSource->rates[clockSource->numRates++] = cfg->usbSampleRate;
+    }
+    if (uac2_rate_supported(cfg->usbSampleRate) == CLD_FALSE) {
+        uac2_state.cfg.usbSampleRate = clockSource->rates[0];
+    }
+    clockSource->current = uac2_state.cfg.usbSampleRate;
+    clockSource->request = clockSource->current;
+
+    /* Size the endpoints for the highest rate */
+    maxRate = 0;
+    for (i = 0; i < clockSource->numRates; i++) {
+        if (clockSource->rates[i] > maxRate) {
+            maxRate = clockSource->rates[i];
+        }
+    }
 
     /* Copy static parameters from app cfg to CLD init params */
 #if defined(__ADSPSC589_FAMILY__)
@@ -1384,6 +1558,31 @@ CLD_RV uac2_config(UAC2_APP_CONFIG *cfg)
     uac2_init_params.p_usb_string_serial_number = cfg->serialNumString;
 #endif
 
+    /* Every rate is advertised.  The library describes one alternate
+     * setting, so one channel cluster, per streaming interface and the
+     * channel counts have to fit the highest rate.  High-bandwidth
+     * packets keep that to the few channels that do not fit in three
+     * transactions.  Report the result back to the application.
+     */
+    uac2_state.cfg.usbInChannels = uac2_fit_channels(
+        uac2_state.cfg.usbInChannels, inFormatDescriptor->bSubslotSize,
+        maxRate, uac2_state.cfg.lowLatency
+    );
+    uac2_state.cfg.usbOutChannels = uac2_fit_channels(
+        uac2_state.cfg.usbOutChannels, outFormatDescriptor->bSubslotSize,
+        maxRate, uac2_state.cfg.lowLatency
+    );
+    if ( (uac2_state.cfg.usbInChannels != cfg->usbInChannels) ||
+         (uac2_state.cfg.usbOutChannels != cfg->usbOutChannels) ) {
+        uac2_syslog("UAC 2.0 channels reduced to fit USB bandwidth");
+    }
+    cfg->usbInChannels = uac2_state.cfg.usbInChannels;
+    cfg->usbOutChannels = uac2_state.cfg.usbOutChannels;
+    uac2_state.inFrameSize =
+        inFormatDescriptor->bSubslotSize * uac2_state.cfg.usbInChannels;
+    uac2_state.outFrameSize =
+        outFormatDescriptor->bSubslotSize * uac2_state.cfg.usbOutChannels;
+
     /* Create the Terminal and Feature Unit Descriptors for this
      * signal flow
      */
@@ -1393,8 +1592,6 @@ CLD_RV uac2_config(UAC2_APP_CONFIG *cfg)
         );
 
     /* Create and configure IN Endpoint Descriptors */
-    uac2_format_type_i_descriptor *inFormatDescriptor =
-        newFormatTypeIDescriptor(cfg->usbInWordSizeBits);
     CLD_SC58x_Audio_2_0_Audio_Stream_Data_Endpoint_Descriptor
         *inEndpointDescriptor = newAudioStreamEndpointDescriptor(0, 0);
     uac2_init_params.p_audio_streaming_tx_interface_params =
@@ -1402,14 +1599,16 @@ CLD_RV uac2_config(UAC2_APP_CONFIG *cfg)
             USB_IN_ENDPOINT_ID, USB_IN_OUTPUT_TERMINAL_ID,
             &uac2_state.minInSizeFull, &uac2_state.maxInSizeFull,
             &uac2_state.minInSizeHigh, &uac2_state.maxInSizeHigh,
-            uac2_state.cfg.usbSampleRate, uac2_state.cfg.usbInChannels,
+            maxRate, uac2_state.cfg.usbInChannels,
             uac2_state.cfg.lowLatency,
             inFormatDescriptor, inEndpointDescriptor
         );
+    uac2_state.inIntervalFull =
+        uac2_init_params.p_audio_streaming_tx_interface_params->b_interval_full_speed;
+    uac2_state.inIntervalHigh =
+        uac2_init_params.p_audio_streaming_tx_interface_params->b_interval_high_speed;
 
     /* Create and configure OUT Endpoint Descriptors */
-    uac2_format_type_i_descriptor *outFormatDescriptor =
-        newFormatTypeIDescriptor(cfg->usbOutWordSizeBits);
     CLD_SC58x_Audio_2_0_Audio_Stream_Data_Endpoint_Descriptor
         *outEndpointDescriptor = newAudioStreamEndpointDescriptor(2, 1);
     uac2_init_params.p_audio_streaming_rx_interface_params =
@@ -1417,10 +1616,14 @@ CLD_RV uac2_config(UAC2_APP_CONFIG *cfg)
             USB_OUT_ENDPOINT_ID, USB_OUT_INPUT_TERMINAL_ID,
             &uac2_state.minOutSizeFull, &uac2_state.maxOutSizeFull,
             &uac2_state.minOutSizeHigh, &uac2_state.maxOutSizeHigh,
-            uac2_state.cfg.usbSampleRate, uac2_state.cfg.usbOutChannels,
+            maxRate, uac2_state.cfg.usbOutChannels,
             uac2_state.cfg.lowLatency,
             outFormatDescriptor, outEndpointDescriptor
         );
+    uac2_state.outIntervalFull =
+        uac2_init_params.p_audio_streaming_rx_interface_params->b_interval_full_speed;
+    uac2_state.outIntervalHigh =
+        uac2_init_params.p_audio_streaming_rx_interface_params->b_interval_high_speed;
 
     /* Create and configure Rate Feedback parameters */
     uac2_init_params.p_audio_rate_feedback_rx_params =
@@ -1681,14 +1884,6 @@ CLD_RV uac2_run(void)
         main_time = cld_time_get();
     }
 
-    /* Primitive method to save ISR messages to the syslog */
-    while (uac2_state.syslogTail != uac2_state.syslogHead) {
-        syslog_print(uac2_state.syslog[uac2_state.syslogTail++]);
-        if (uac2_state.syslogTail == UAC2_SYSLOG_DEPTH) {
-            uac2_state.syslogTail = 0;
-        }
-    }
-
     /* Disable interrupts */
     adi_rtl_disable_interrupts();
 
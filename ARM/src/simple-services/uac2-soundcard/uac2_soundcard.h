@@ -30,6 +30,7 @@ typedef uint16_t (*UAC2_TX_CALLBACK)(void *data, void **nextData,
     uint16_t minSize, uint16_t maxSize, void *usrPtr);
 typedef uint32_t (*UAC2_RATE_FEEDBACK_CALLBACK)(void *usrPtr);
 typedef void (*UAC2_ENDPOINT_ENABLE_CALLBACK)(UAC2_DIR dir, bool enable, void *usrPtr);
+typedef bool (*UAC2_SAMPLE_RATE_CALLBACK)(uint32_t rate, void *usrPtr);
 
 /* USB Audio OUT (Rx) endpoint stats */
 typedef struct {
@@ -52,7 +53,9 @@ typedef struct {
     uint8_t usbInWordSizeBits;        /*!< USB IN (Tx) word size */
     uint8_t usbOutChannels;           /*!< USB OUT (Rx) channels */
     uint8_t usbOutWordSizeBits;       /*!< USB OUT (Rx) word size */
-    uint32_t usbSampleRate;           /*!< USB sample rate */
+    uint32_t usbSampleRate;           /*!< USB sample rate (initial rate if a list is given) */
+    const uint32_t *usbSampleRates;   /*!< Optional list of host selectable sample rates */
+    uint8_t usbNumSampleRates;        /*!< Number of entries in 'usbSampleRates' */
     uint32_t timerNum;                /*!< ADI Timer Service timer number */
     uint16_t vendorId;                /*!< USB Vendor ID */
     uint16_t productId;               /*!< USB Product ID */
@@ -66,6 +69,7 @@ typedef struct {
     UAC2_TX_CALLBACK txCallback;      /*!< UAC2 IN (Tx) callback */
     UAC2_RATE_FEEDBACK_CALLBACK rateFeedbackCallback;     /*!< UAC2 Rate Feedback callback */
     UAC2_ENDPOINT_ENABLE_CALLBACK endpointEnableCallback; /*!< UAC2 Endpoint enable callback */
+    UAC2_SAMPLE_RATE_CALLBACK sampleRateCallback;         /*!< UAC2 Sample rate change callback */
     void *usrPtr;
 } UAC2_APP_CONFIG;
 
@@ -74,6 +78,11 @@ extern "C"{
 #endif
 
 CLD_RV uac2_init(void);
+
+/* uac2_config() reduces 'usbInChannels' and 'usbOutChannels' in 'cfg'
+ * if required to fit the high-speed isochronous bandwidth at the highest
+ * supported sample rate.
+ */
 CLD_RV uac2_config(UAC2_APP_CONFIG *cfg);
 CLD_RV uac2_start(void);
 CLD_RV uac2_run(void);
@@ -25,6 +25,7 @@ void spdifAudioOut(void *buffer, uint32_t maxSize, void *usrPtr)
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     SAE_MSG_BUFFER *msg = NULL;
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -37,11 +38,11 @@ void spdifAudioOut(void *buffer, uint32_t maxSize, void *usrPtr)
     }
 
     /* Indicate SPDIF "out" audio ready */
-    sharcAudio(context, CLOCK_DOMAIN_BITM_SPDIF_OUT, msg, false, false);
+    sharcAudio(context, CLOCK_DOMAIN_BITM_SPDIF_OUT, msg, false);
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "spdifAudioOut", outCycles - inCycles);
 }
 
 void spdifAudioIn(void *buffer, uint32_t size, void *usrPtr)
@@ -49,6 +50,7 @@ void spdifAudioIn(void *buffer, uint32_t size, void *usrPtr)
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     SAE_MSG_BUFFER *msg = NULL;
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     /* Track ISR cycle count for CPU load */
     inCycles = cpuLoadGetTimeStamp();
@@ -60,10 +62,13 @@ void spdifAudioIn(void *buffer, uint32_t size, void *usrPtr)
         msg = context->spdifMsgIn[1];
     }
 
-    /* Indicate SPDIF "in" audio ready */
-    sharcAudio(context, CLOCK_DOMAIN_BITM_SPDIF_IN, msg, false, true);
+    /*
+     * Indicate SPDIF "in" audio ready.  This is the CLOCK_DOMAIN_SPDIF
+     * clock source when the ASRC is bypassed.
+     */
+    sharcAudio(context, CLOCK_DOMAIN_BITM_SPDIF_IN, msg, true);
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "spdifAudioIn", outCycles - inCycles);
 }
@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "context.h"
+#include "trace_capture.h"
+#include "trace.h"
+#include "ipc.h"
+#include "sae.h"
+
+typedef struct _TRACE_TASK_NAME {
+    uint32_t handle;
+    char name[configMAX_TASK_NAME_LEN];
+} TRACE_TASK_NAME;
+
+static TRACE_TASK_NAME taskNames[TRACE_TASK_NAMES_MAX];
+static unsigned numTaskNames;
+
+static const char * const coreNames[IPC_MAX_CORES] = {
+    "ARM", "SHARC0", "SHARC1"
+};
+
+/*
+ * Send the trace buffer message to a SHARC.  The ARM keeps its own
+ * reference so the buffer is never freed.
+ */
+static void sendTraceMsg(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *msg,
+    SAE_CORE_IDX core)
+{
+    SAE_RESULT result;
+
+    sae_refMsgBuffer(saeContext, msg);
+    result = sae_sendMsgBuffer(saeContext, msg, core, true);
+    if (result != SAE_RESULT_OK) {
+        sae_unRefMsgBuffer(saeContext, msg);
+    }
+}
+
+bool trace_capture_start(APP_CONTEXT *context)
+{
+    SAE_CONTEXT *saeContext = context->saeContext;
+    TRACE_BUFFER *tb;
+    IPC_MSG *msg;
+
+    if (context->traceMsgBuffer == NULL) {
+        context->traceMsgBuffer = sae_createMsgBuffer(saeContext,
+            sizeof(*msg) + trace_size(), SAE_ALLOC_BULK, (void **)&msg);
+        if (context->traceMsgBuffer == NULL) {
+            return(false);
+        }
+        msg->type = IPC_TYPE_TRACE;
+        tb = trace_init(msg->trace.buffer);
+        trace_attach(tb, IPC_CORE_ARM);
+        sendTraceMsg(saeContext, context->traceMsgBuffer, IPC_CORE_SHARC0);
+        sendTraceMsg(saeContext, context->traceMsgBuffer, IPC_CORE_SHARC1);
+    }
+
+    numTaskNames = 0;
+    trace_start();
+
+    return(true);
+}
+
+void trace_capture_stop(APP_CONTEXT *context)
+{
+    UNUSED(context);
+    trace_stop();
+}
+
+void trace_task_switch(void *taskHandle)
+{
+    TRACE_BUFFER *tb = trace_buffer();
+    uint32_t handle = (uint32_t)taskHandle;
+    unsigned i;
+
+    if ((tb == NULL) || !tb->enable) {
+        return;
+    }
+
+    TRACE_INSTANT(TRACE_ID_TASK, handle);
+
+    for (i = 0; i < numTaskNames; i++) {
+        if (taskNames[i].handle == handle) {
+            return;
+        }
+    }
+    if (numTaskNames < TRACE_TASK_NAMES_MAX) {
+        taskNames[numTaskNames].handle = handle;
+        strncpy(taskNames[numTaskNames].name, pcTaskGetName(taskHandle),
+            sizeof(taskNames[numTaskNames].name) - 1);
+        numTaskNames++;
+    }
+}
+
+static const char *taskName(uint32_t handle)
+{
+    unsigned i;
+    for (i = 0; i < numTaskNames; i++) {
+        if (taskNames[i].handle == handle) {
+            return(taskNames[i].name);
+        }
+    }
+    return("task");
+}
+
+/* Chrome trace timestamps are in uS */
+static void writeTs(FILE *f, uint32_t ticks, uint32_t hz)
+{
+    uint64_t ns = ((uint64_t)ticks * 1000000000ULL) / hz;
+    fprintf(f, "%lu.%03lu",
+        (unsigned long)(ns / 1000), (unsigned long)(ns % 1000));
+}
+
+static void writeEvent(FILE *f, const char *name, const char *ph,
+    unsigned pid, uint32_t tid, uint32_t ticks, uint32_t hz, uint32_t arg)
+{
+    fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":%u,\"tid\":%lu,\"ts\":",
+        name, ph, pid, (unsigned long)tid);
+    writeTs(f, ticks, hz);
+    if (ph[0] == 'i') {
+        fprintf(f, ",\"s\":\"t\"");
+    }
+    fprintf(f, ",\"args\":{\"arg\":%lu}}", (unsigned long)arg);
+}
+
+/*
+ * Merge the per-core rings oldest event first.  Each ring is already
+ * in time order so a simple k-way merge on the (wrapping) common
+ * timestamp is all that is required.
+ */
+unsigned trace_capture_export(APP_CONTEXT *context, FILE *f)
+{
+    TRACE_BUFFER *tb = trace_buffer();
+    uint32_t pos[IPC_MAX_CORES];
+    uint32_t head[IPC_MAX_CORES];
+    uint32_t curTask;
+    TRACE_EVENT *ev, *next;
+    uint32_t base;
+    unsigned total;
+    unsigned core;
+    unsigned i;
+    int c;
+
+    UNUSED(context);
+
+    if (tb == NULL) {
+        return(0);
+    }
+
+    /* Capture must be stopped for a consistent snapshot */
+    trace_stop();
+
+    for (i = 0; i < IPC_MAX_CORES; i++) {
+        head[i] = tb->head[i];
+        pos[i] = (head[i] > tb->events) ? head[i] - tb->events : 0;
+    }
+
+    /* Find the oldest event to use as time zero */
+    base = 0; c = -1;
+    for (i = 0; i < IPC_MAX_CORES; i++) {
+        if (pos[i] < head[i]) {
+            ev = &tb->event[i * tb->events + (pos[i] & (tb->events - 1))];
+            if ((c < 0) || ((int32_t)(ev->ts - base) < 0)) {
+                base = ev->ts; c = i;
+            }
+        }
+    }
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (i = 0; i < IPC_MAX_CORES; i++) {
+        fprintf(f, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+            "\"args\":{\"name\":\"%s\"}}", i ? ",\n" : "", i, coreNames[i]);
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,"
+            "\"tid\":0,\"args\":{\"name\":\"events\"}}", i);
+    }
+    for (i = 0; i < numTaskNames; i++) {
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+            "\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+            (unsigned long)taskNames[i].handle, taskNames[i].name);
+    }
+
+    total = 0;
+    curTask = 0;
+    while (1) {
+
+        /* Pick the oldest pending event across all cores */
+        next = NULL; core = 0;
+        for (i = 0; i < IPC_MAX_CORES; i++) {
+            if (pos[i] < head[i]) {
+                ev = &tb->event[i * tb->events + (pos[i] & (tb->events - 1))];
+                if ((next == NULL) || ((int32_t)(ev->ts - next->ts) < 0)) {
+                    next = ev; core = i;
+                }
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        pos[core]++;
+        total++;
+
+        if (next->id == TRACE_ID_TASK) {
+            if (curTask) {
+                writeEvent(f, taskName(curTask), "E", core, curTask,
+                    next->ts - base, tb->hz, curTask);
+            }
+            curTask = next->arg;
+            writeEvent(f, taskName(curTask), "B", core, curTask,
+                next->ts - base, tb->hz, curTask);
+        } else {
+            writeEvent(f, trace_id_str(next->id),
+                next->type == TRACE_TYPE_BEGIN ? "B" :
+                next->type == TRACE_TYPE_END ? "E" : "i",
+                core, 0, next->ts - base, tb->hz, next->arg);
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+
+    return(total);
+}
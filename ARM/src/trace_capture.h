@@ -0,0 +1,35 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+#ifndef _trace_capture_h
+#define _trace_capture_h
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "context.h"
+#include "trace.h"
+
+/* Max number of distinct task names remembered during a capture */
+#define TRACE_TASK_NAMES_MAX  (16)
+
+/* Allocate the shared trace buffer (first time only) and start capture */
+bool trace_capture_start(APP_CONTEXT *context);
+
+/* Stop capture on all cores */
+void trace_capture_stop(APP_CONTEXT *context);
+
+/* Record a FreeRTOS task switch (called from the task switch hook) */
+void trace_task_switch(void *taskHandle);
+
+/* Merge all per-core buffers and write them as Chrome/Perfetto JSON */
+unsigned trace_capture_export(APP_CONTEXT *context, FILE *f);
+
+#endif
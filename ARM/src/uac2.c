@@ -28,6 +28,10 @@
 #include "uac2.h"
 #include "util.h"
 #include "usb_audio.h"
+#include "init.h"
+#include "syslog.h"
+#include "sae.h"
+#include "ipc.h"
 
 /* UAC2 soundcard management task */
 portTASK_FUNCTION(uac2Task, pvParameters)
@@ -36,6 +40,46 @@ portTASK_FUNCTION(uac2Task, pvParameters)
     uint32_t whatToDo;
     CLD_RV ret;
     uint32_t dataSize;
+    IPC_MSG *msg;
+
+    /* Configure UAC2 application settings.  The host may select any
+     * rate supported by the system clock plan.
+     */
+    context->uac2cfg.port = CLD_USB_0;
+    context->uac2cfg.usbSampleRate = context->sampleRate;
+    context->uac2cfg.usbNumSampleRates =
+        system_sample_rates(&context->uac2cfg.usbSampleRates);
+    context->uac2cfg.usbInChannels = context->cfg.usbInChannels;
+    context->uac2cfg.usbInWordSizeBits = context->cfg.usbWordSizeBits;
+    context->uac2cfg.usbOutChannels = context->cfg.usbOutChannels;
+    context->uac2cfg.usbOutWordSizeBits = context->cfg.usbWordSizeBits;
+    context->uac2cfg.vendorId = USB_VENDOR_ID;
+    context->uac2cfg.productId = USB_PRODUCT_ID;
+    context->uac2cfg.mfgString = USB_MFG_STRING;
+    context->uac2cfg.productString = USB_PRODUCT_STRING;
+    context->uac2cfg.serialNumString = USB_SERIAL_NUMBER_STRING;
+    context->uac2cfg.lowLatency = false;
+    context->uac2cfg.usbOutStats = &context->uac2stats.rx.ep;
+    context->uac2cfg.usbInStats = &context->uac2stats.tx.ep;
+    context->uac2cfg.rxCallback = uac2Rx;
+    context->uac2cfg.txCallback = uac2Tx;
+    context->uac2cfg.rateFeedbackCallback = uac2RateFeedback;
+    context->uac2cfg.endpointEnableCallback = uac2EndpointEnabled;
+    context->uac2cfg.sampleRateCallback = uac2SampleRate;
+    context->uac2cfg.usrPtr = context;
+    context->uac2cfg.timerNum = USB_TIMER;
+    context->uac2SampleRate = context->sampleRate;
+
+    /* Initialize and configure the CLD UAC20 library */
+    ret = uac2_init();
+    ret = uac2_config(&context->uac2cfg);
+
+    /* Every rate is advertised.  The channel counts are reduced if the
+     * highest rate does not fit the USB bandwidth, even with
+     * high-bandwidth packets.
+     */
+    context->cfg.usbInChannels = context->uac2cfg.usbInChannels;
+    context->cfg.usbOutChannels = context->uac2cfg.usbOutChannels;
 
     /* Allocate and configure the ring buffer between the UAC2 Rx
      * (OUT endpoint) and the CODEC DAC.  The ring buffer unit
@@ -59,6 +103,12 @@ portTASK_FUNCTION(uac2Task, pvParameters)
     PaUtil_InitializeRingBuffer(context->uac2InTx,
         sizeof(SYSTEM_AUDIO_TYPE), dataSize, context->uac2InTxData);
 
+    /* Match the USB IPC audio messages to the final channel counts */
+    msg = (IPC_MSG *)sae_getMsgBufferPayload(context->usbMsgRx[0]);
+    msg->audio.numChannels = context->cfg.usbOutChannels;
+    msg = (IPC_MSG *)sae_getMsgBufferPayload(context->usbMsgTx[0]);
+    msg->audio.numChannels = context->cfg.usbInChannels;
+
     /* Initialize the buffer level tracking module for UAC2 rate feedback.
      * In this system, the CODEC is the clock master for everything.
      * Therefore, only the CODEC output buffer (uac2OutRxData)
@@ -66,31 +116,7 @@ portTASK_FUNCTION(uac2Task, pvParameters)
      */
     bufferTrackInit(getTimeStamp);
 
-    /* Configure UAC2 application settings */
-    context->uac2cfg.port = CLD_USB_0;
-    context->uac2cfg.usbSampleRate = SYSTEM_SAMPLE_RATE;
-    context->uac2cfg.usbInChannels = context->cfg.usbInChannels;
-    context->uac2cfg.usbInWordSizeBits = context->cfg.usbWordSizeBits;
-    context->uac2cfg.usbOutChannels = context->cfg.usbOutChannels;
-    context->uac2cfg.usbOutWordSizeBits = context->cfg.usbWordSizeBits;
-    context->uac2cfg.vendorId = USB_VENDOR_ID;
-    context->uac2cfg.productId = USB_PRODUCT_ID;
-    context->uac2cfg.mfgString = USB_MFG_STRING;
-    context->uac2cfg.productString = USB_PRODUCT_STRING;
-    context->uac2cfg.serialNumString = USB_SERIAL_NUMBER_STRING;
-    context->uac2cfg.lowLatency = false;
-    context->uac2cfg.usbOutStats = &context->uac2stats.rx.ep;
-    context->uac2cfg.usbInStats = &context->uac2stats.tx.ep;
-    context->uac2cfg.rxCallback = uac2Rx;
-    context->uac2cfg.txCallback = uac2Tx;
-    context->uac2cfg.rateFeedbackCallback = uac2RateFeedback;
-    context->uac2cfg.endpointEnableCallback = uac2EndpointEnabled;
-    context->uac2cfg.usrPtr = context;
-    context->uac2cfg.timerNum = USB_TIMER;
-
-    /* Initialize, configure, and start the CLD UAC20 library */
-    ret = uac2_init();
-    ret = uac2_config(&context->uac2cfg);
+    /* Start the CLD UAC20 library */
     ret = uac2_start();
 
     while (1) {
@@ -103,5 +129,17 @@ portTASK_FUNCTION(uac2Task, pvParameters)
          * triggered the notification, but we really don't care at this point.
          */
         whatToDo = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+
+        /* Apply a sample rate selected by the host.  Checking on every
+         * pass also catches a notification overwritten by audio data.
+         */
+        if (context->uac2SampleRate != context->sampleRate) {
+            if (system_set_sample_rate(context, context->uac2SampleRate)) {
+                syslog_printf("System sample rate %u Hz",
+                    (unsigned)context->sampleRate);
+            } else {
+                context->uac2SampleRate = context->sampleRate;
+            }
+        }
     }
 }
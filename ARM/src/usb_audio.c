@@ -14,6 +14,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* CCES includes */
+#include <adi/cortex-a5/runtime/cache/adi_cache.h>
+
 /* Simple service includes */
 #include "buffer_track.h"
 #include "cpu_load.h"
@@ -21,10 +24,77 @@
 #include "util.h"
 #include "clock_domain.h"
 
+/* Largest packet the soundcard service will ever hand to the callbacks */
+#define USB_MAX_PKT_SAMPLES  (1024 / sizeof(SYSTEM_AUDIO_TYPE))
+
 static bool txPreRoll = true;
 
-static SYSTEM_AUDIO_TYPE rxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE txBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+/*
+ * When the USB word size matches SYSTEM_AUDIO_TYPE, contiguous ring
+ * buffer regions are handed to the soundcard service through 'nextData'
+ * so the USB DMA moves packets directly in and out of the rings.  The
+ * soundcard's own packet buffers are remembered for the times the ring
+ * wraps inside a packet or a conversion is required.
+ */
+static void *rxPktBuffer;
+static void *rxRegion;
+static void *txPktBuffer;
+static void *txRegion;
+static unsigned txRegionSamples;
+
+static bool ringContains(PaUtilRingBuffer *rb, void *ptr)
+{
+    char *p = (char *)ptr;
+    return( (p >= rb->buffer) &&
+            (p < rb->buffer + rb->bufferSize * rb->elementSizeBytes) );
+}
+
+static void *ringWritePtr(PaUtilRingBuffer *rb)
+{
+    return(rb->buffer + (rb->writeIndex & rb->smallMask) * rb->elementSizeBytes);
+}
+
+static void copySamples(void *dst, unsigned dstWordSize,
+    void *src, unsigned srcWordSize, unsigned samples)
+{
+    if (dstWordSize == srcWordSize) {
+        memcpy(dst, src, samples * dstWordSize);
+    } else {
+        copyAndConvert(src, srcWordSize, 1, dst, dstWordSize, 1, samples, false);
+    }
+}
+
+/* Convert a USB packet straight into the ring buffer write regions */
+static void ringWritePkt(PaUtilRingBuffer *rb, void *src,
+    unsigned srcWordSize, unsigned samples)
+{
+    void *d1, *d2;
+    ring_buffer_size_t s1, s2;
+
+    PaUtil_GetRingBufferWriteRegions(rb, samples, &d1, &s1, &d2, &s2);
+    copySamples(d1, rb->elementSizeBytes, src, srcWordSize, s1);
+    if (s2) {
+        copySamples(d2, rb->elementSizeBytes,
+            (uint8_t *)src + s1 * srcWordSize, srcWordSize, s2);
+    }
+    PaUtil_AdvanceRingBufferWriteIndex(rb, s1 + s2);
+}
+
+/* Convert the ring buffer read regions straight into a USB packet */
+static void ringReadPkt(PaUtilRingBuffer *rb, void *dst,
+    unsigned dstWordSize, unsigned samples)
+{
+    void *d1, *d2;
+    ring_buffer_size_t s1, s2;
+
+    PaUtil_GetRingBufferReadRegions(rb, samples, &d1, &s1, &d2, &s2);
+    copySamples(dst, dstWordSize, d1, rb->elementSizeBytes, s1);
+    if (s2) {
+        copySamples((uint8_t *)dst + s1 * dstWordSize, dstWordSize,
+            d2, rb->elementSizeBytes, s2);
+    }
+    PaUtil_AdvanceRingBufferReadIndex(rb, s1 + s2);
+}
 
 unsigned usbBits2bytes(unsigned bits)
 {
@@ -52,6 +122,7 @@ uint16_t uac2Rx(void *data, void **nextData, uint16_t rxSize, void *usrPtr)
 {
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     UNUSED(context);
 
@@ -62,6 +133,13 @@ uint16_t uac2Rx(void *data, void **nextData, uint16_t rxSize, void *usrPtr)
     unsigned sampleSizeBytes;
     unsigned framesAvailable;
     unsigned frames;
+    void *d1, *d2;
+    ring_buffer_size_t s1, s2;
+
+    /* Remember the soundcard's packet buffer */
+    if (!ringContains(context->uac2OutRx, data)) {
+        rxPktBuffer = data;
+    }
 
     /* Accumulate the fill level of the USB receive ring buffer for
      * rate feedback calculation.
@@ -78,33 +156,50 @@ uint16_t uac2Rx(void *data, void **nextData, uint16_t rxSize, void *usrPtr)
     samples = PaUtil_GetRingBufferWriteAvailable(context->uac2OutRx);
     framesAvailable = samples / context->cfg.usbOutChannels;
 
-    /* Copy in the audio data if there is space */
-    if (framesAvailable >= frames ) {
-        if (sampleSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
-            /* 32-bit -> 32-bit or 16-bit -> 16-bit */
-            PaUtil_WriteRingBuffer(
-                context->uac2OutRx, data,
-                context->cfg.usbOutChannels * frames
-            );
+    samples = context->cfg.usbOutChannels * frames;
+
+    if (data == rxRegion) {
+        /* The packet was received directly into the ring.  It is only
+         * valid if the ring was not flushed while the packet was in flight.
+         */
+        if ((rxRegion == ringWritePtr(context->uac2OutRx)) &&
+            (framesAvailable >= frames)) {
+            flush_data_buffer(rxRegion,
+                (uint8_t *)rxRegion + samples * sizeof(SYSTEM_AUDIO_TYPE),
+                ADI_FLUSH_DATA_INV);
+            PaUtil_AdvanceRingBufferWriteIndex(context->uac2OutRx, samples);
         } else {
-            /* 16-bit -> 32-bit, 32-bit -> 16-bit */
-            copyAndConvert(
-                data, sampleSizeBytes, context->cfg.usbOutChannels,
-                rxBuffer, sizeof(SYSTEM_AUDIO_TYPE), context->cfg.usbOutChannels,
-                frames, false
-            );
-            PaUtil_WriteRingBuffer(
-                context->uac2OutRx, rxBuffer,
-                context->cfg.usbOutChannels * frames
-            );
+            context->uac2stats.rx.usbRxOverRun++;
         }
+    } else if (ringContains(context->uac2OutRx, data)) {
+        /* Stale ring region from before a flush, drop it */
+        context->uac2stats.rx.usbRxOverRun++;
+    } else if (framesAvailable >= frames) {
+        /* Copy/convert the packet into the ring */
+        ringWritePkt(context->uac2OutRx, data, sampleSizeBytes, samples);
     } else {
         context->uac2stats.rx.usbRxOverRun++;
     }
 
+    /* Receive the next packet directly into the ring if the formats
+     * match and a full packet fits without wrapping.
+     */
+    rxRegion = NULL;
+    if (sampleSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
+        PaUtil_GetRingBufferWriteRegions(context->uac2OutRx,
+            USB_MAX_PKT_SAMPLES, &d1, &s1, &d2, &s2);
+        if (s1 >= USB_MAX_PKT_SAMPLES) {
+            rxRegion = d1;
+            flush_data_buffer(rxRegion,
+                (uint8_t *)rxRegion + USB_MAX_PKT_SAMPLES * sizeof(SYSTEM_AUDIO_TYPE),
+                ADI_FLUSH_DATA_INV);
+        }
+    }
+    *nextData = rxRegion ? rxRegion : rxPktBuffer;
+
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "uac2Rx", outCycles - inCycles);
 
     return(rxSize);
 }
@@ -140,6 +235,7 @@ uint16_t uac2Tx(void *data, void **nextData,
 {
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     uint32_t inCycles, outCycles;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
 
     UNUSED(context);
 
@@ -154,12 +250,24 @@ uint16_t uac2Tx(void *data, void **nextData,
     unsigned targetRingFrames;
     int error;
     unsigned size;
+    void *d1, *d2;
+    ring_buffer_size_t s1, s2;
 
     /* Adjustment tracking variables */
     static unsigned adjustCountCurr;
     static unsigned adjustCountThresh;
     static int adjustValue;
 
+    /* The previous packet has gone out so release its ring region */
+    if (data == txRegion) {
+        PaUtil_AdvanceRingBufferReadIndex(context->uac2InTx, txRegionSamples);
+    } else if (!ringContains(context->uac2InTx, data)) {
+        txPktBuffer = data;
+    }
+    txRegion = NULL;
+    txRegionSamples = 0;
+    *nextData = txPktBuffer;
+
     /* Sanity check */
     if ((minSize == 0) || (maxSize == 0)) {
         return(0);
@@ -227,7 +335,7 @@ uint16_t uac2Tx(void *data, void **nextData,
          * a sample of adjustment.
          */
         if (error) {
-            adjustCountThresh = SYSTEM_SAMPLE_RATE / (uacFrames * abs(error));
+            adjustCountThresh = context->sampleRate / (uacFrames * abs(error));
             adjustValue = adjustCountThresh ? ((error < 0) ? -1 : 1) : 0;
         } else {
             adjustCountThresh = 0;
@@ -242,20 +350,26 @@ uint16_t uac2Tx(void *data, void **nextData,
         adjustCountCurr = 0;
     }
 
-    /* Copy the audio from the ring buffer */
+    /* Send straight from the ring if the formats match and the packet
+     * does not wrap.  The read index is advanced on the next callback
+     * once the packet has gone out.  Otherwise copy/convert into the
+     * soundcard's packet buffer.
+     */
+    samples = uacFrames * context->cfg.usbInChannels;
     if (sampleSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
-        PaUtil_ReadRingBuffer(
-            context->uac2InTx, data, uacFrames * context->cfg.usbInChannels
-        );
-    } else {
-        PaUtil_ReadRingBuffer(
-            context->uac2InTx, txBuffer, uacFrames * context->cfg.usbInChannels
-        );
-        copyAndConvert(
-            txBuffer, sizeof(SYSTEM_AUDIO_TYPE), context->cfg.usbInChannels,
-            data, sampleSizeBytes, context->cfg.usbInChannels,
-            uacFrames, false
-        );
+        PaUtil_GetRingBufferReadRegions(context->uac2InTx, samples,
+            &d1, &s1, &d2, &s2);
+        if (s1 >= samples) {
+            txRegion = d1;
+            txRegionSamples = samples;
+            flush_data_buffer(txRegion,
+                (uint8_t *)txRegion + samples * sizeof(SYSTEM_AUDIO_TYPE),
+                ADI_FLUSH_DATA_NOINV);
+            *nextData = txRegion;
+        }
+    }
+    if (txRegion == NULL) {
+        ringReadPkt(context->uac2InTx, txPktBuffer, sampleSizeBytes, samples);
     }
 
     /* Return the size in bytes to the soundcard service */
@@ -263,7 +377,7 @@ uint16_t uac2Tx(void *data, void **nextData,
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "uac2Tx", outCycles - inCycles);
 
     return(size);
 }
@@ -276,7 +390,8 @@ uint32_t uac2RateFeedback(void *usrPtr)
 {
     APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
     uint32_t inCycles, outCycles;
-    uint32_t rate = SYSTEM_SAMPLE_RATE;
+    static int isrId = CPU_LOAD_ISR_ID_NONE;
+    uint32_t rate;
 
     UNUSED(context);
 
@@ -285,7 +400,7 @@ uint32_t uac2RateFeedback(void *usrPtr)
 
     rate = bufferTrackGetSampleRate(UAC2_OUT_BUFFER_TRACK_IDX);
     if (rate == 0) {
-        rate = SYSTEM_SAMPLE_RATE;
+        rate = context->sampleRate;
     }
 
     /*
@@ -300,11 +415,29 @@ uint32_t uac2RateFeedback(void *usrPtr)
 
     /* Track ISR cycle count for CPU load */
     outCycles = cpuLoadGetTimeStamp();
-    cpuLoadIsrCycles(outCycles - inCycles);
+    cpuLoadIsrSourceCycles(&isrId, "uac2Feedback", outCycles - inCycles);
 
     return(rate);
 }
 
+/*
+ * This callback is called whenever the host selects a new sampling
+ * frequency.  This callback runs in an ISR context so the system clock
+ * change is deferred to the UAC2 task.
+ */
+bool uac2SampleRate(uint32_t rate, void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+
+    context->uac2SampleRate = rate;
+
+    xTaskNotifyFromISR(context->uac2TaskHandle,
+        UAC2_TASK_SAMPLE_RATE_CHANGE, eSetValueWithOverwrite, NULL
+    );
+
+    return(true);
+}
+
 /*
  * This callback is called whenever the IN or OUT endpoint is enabled
  * or disabled.  This callback runs in an ISR context.
@@ -327,6 +460,8 @@ void uac2EndpointEnabled(UAC2_DIR dir, bool enable, void *usrPtr)
         } else {
             PaUtil_FlushRingBuffer(context->uac2InTx);
         }
+        txRegion = NULL;
+        txRegionSamples = 0;
         context->uac2TxEnabled = enable;
     }
 }
@@ -363,7 +498,8 @@ SAE_MSG_BUFFER * xferUsbRxAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
 
 #if 1
     /* Sanity check the request */
-    if ( (audio->numChannels != USB_DEFAULT_OUT_AUDIO_CHANNELS) ||
+    if ( (context->uac2OutRx == NULL) ||
+         (audio->numChannels != context->cfg.usbOutChannels) ||
          (audio->wordSize != sizeof(SYSTEM_AUDIO_TYPE)) )
     {
         return(NULL);
@@ -371,7 +507,7 @@ SAE_MSG_BUFFER * xferUsbRxAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
 #endif
 
     samples = PaUtil_GetRingBufferReadAvailable(context->uac2OutRx);
-    frames = samples / USB_DEFAULT_OUT_AUDIO_CHANNELS;
+    frames = samples / context->cfg.usbOutChannels;
 
     if (rxPreRoll) {
         /* Must have at least USB_OUT_RING_BUFF_FILL of data waiting */
@@ -415,8 +551,8 @@ SAE_MSG_BUFFER * xferUsbRxAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
             bufferTrackCalculateSampleRate(
                 UAC2_OUT_BUFFER_TRACK_IDX,
                 USB_OUT_RING_BUFF_FILL,
-                USB_DEFAULT_OUT_AUDIO_CHANNELS,
-                SYSTEM_SAMPLE_RATE
+                context->cfg.usbOutChannels,
+                context->sampleRate
             );
         }
         taskEXIT_CRITICAL_FROM_ISR(isrStat);
@@ -469,7 +605,8 @@ SAE_MSG_BUFFER *xferUsbTxAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
 
 #if 1
     /* Sanity check the request */
-    if ( (audio->numChannels != USB_DEFAULT_IN_AUDIO_CHANNELS) ||
+    if ( (context->uac2InTx == NULL) ||
+         (audio->numChannels != context->cfg.usbInChannels) ||
          (audio->wordSize != sizeof(SYSTEM_AUDIO_TYPE)) )
     {
         return(NULL);
@@ -492,7 +629,7 @@ SAE_MSG_BUFFER *xferUsbTxAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
          * frames available in the ring buffer.
          */
         samples = PaUtil_GetRingBufferWriteAvailable(context->uac2InTx);
-        framesAvailable = samples / USB_DEFAULT_IN_AUDIO_CHANNELS;
+        framesAvailable = samples / context->cfg.usbInChannels;
 
         /* Put a block of USB IN (Tx) audio into the ring buffer */
         if (framesAvailable >= audio->numFrames ) {
@@ -26,6 +26,8 @@ uint16_t uac2Tx(void *data, void **nextData,
 
 uint32_t uac2RateFeedback(void *usrPtr);
 
+bool uac2SampleRate(uint32_t rate, void *usrPtr);
+
 SAE_MSG_BUFFER *xferUsbRxAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
     CLOCK_DOMAIN cd);
 SAE_MSG_BUFFER *xferUsbTxAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
@@ -33,5 +35,7 @@ SAE_MSG_BUFFER *xferUsbTxAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
 
 void uac2EndpointEnabled(UAC2_DIR dir, bool enable, void *usrPtr);
 
+unsigned usbBits2bytes(unsigned bits);
+
 #endif
 
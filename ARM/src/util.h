@@ -18,6 +18,7 @@
 
 /* Sprinkled throughout source */
 uint32_t getTimeStamp(void);
+uint64_t getTimeStamp64(void);
 void delay(unsigned ms);
 uint32_t elapsedTimeMs(uint32_t elapsed);
 time_t util_time(time_t *tloc);
@@ -39,82 +39,102 @@ static SYSTEM_AUDIO_TYPE srcBuffer2[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
 static SYSTEM_AUDIO_TYPE sinkBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
 static SYSTEM_AUDIO_TYPE sinkBuffer2[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
 
-/* This task keeps the wav src ring buffer full */
-portTASK_FUNCTION(wavSrcTask, pvParameters)
+/*
+ * Keeps the wav src ring buffer full.  Runs in task context.
+ */
+void wavSrcService(APP_CONTEXT *context)
 {
-    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
     WAV_FILE *wavSrc = &context->wavSrc;
     PaUtilRingBuffer *wavSrcRB = context->wavSrcRB;
-    uint32_t whatToDo;
     unsigned samplesIn;
     unsigned samplesOut;
     size_t rsize;
     bool ok;
 
-    while (1) {
-        xSemaphoreTake(wavSrc->lock, portMAX_DELAY);
-        if (wavSrc->enabled) {
-            samplesIn = SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE;
-            samplesOut = PaUtil_GetRingBufferWriteAvailable(wavSrcRB);
-            ok = true;
-            while (ok && (samplesOut >= samplesIn)) {
-                rsize = readWave(wavSrc, srcBuffer, samplesIn);
-                ok = (rsize >= 0);
-                if (ok) {
-                    if (wavSrc->wordSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
-                        PaUtil_WriteRingBuffer(wavSrcRB, srcBuffer, rsize);
-                    } else {
-                        copyAndConvert(
-                            srcBuffer, wavSrc->wordSizeBytes, wavSrc->channels,
-                            srcBuffer2, sizeof(SYSTEM_AUDIO_TYPE), wavSrc->channels,
-                            rsize / wavSrc->channels, true
-                        );
-                        PaUtil_WriteRingBuffer(wavSrcRB, srcBuffer2, rsize);
-                    }
-                    samplesOut = PaUtil_GetRingBufferWriteAvailable(wavSrcRB);
-                }
+    xSemaphoreTake(wavSrc->lock, portMAX_DELAY);
+    if (wavSrc->enabled) {
+        samplesIn = SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE;
+        samplesOut = PaUtil_GetRingBufferWriteAvailable(wavSrcRB);
+        ok = true;
+        while (ok && (samplesOut >= samplesIn)) {
+            /* Don't wait on the media, try again on the next service */
+            if (!readyWave(wavSrc, samplesIn)) {
+                break;
             }
-            if (!ok) {
-                wavSrc->enabled = false;
+            rsize = readWave(wavSrc, srcBuffer, samplesIn);
+            ok = (rsize >= 0);
+            if (ok) {
+                if (wavSrc->wordSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
+                    PaUtil_WriteRingBuffer(wavSrcRB, srcBuffer, rsize);
+                } else {
+                    copyAndConvert(
+                        srcBuffer, wavSrc->wordSizeBytes, wavSrc->channels,
+                        srcBuffer2, sizeof(SYSTEM_AUDIO_TYPE), wavSrc->channels,
+                        rsize / wavSrc->channels, true
+                    );
+                    PaUtil_WriteRingBuffer(wavSrcRB, srcBuffer2, rsize);
+                }
+                samplesOut = PaUtil_GetRingBufferWriteAvailable(wavSrcRB);
             }
-        } else {
-            PaUtil_FlushRingBuffer(wavSrcRB);
         }
-        xSemaphoreGive(wavSrc->lock);
-        whatToDo = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+        if (!ok) {
+            wavSrc->enabled = false;
+        }
+    } else {
+        PaUtil_FlushRingBuffer(wavSrcRB);
     }
+    xSemaphoreGive(wavSrc->lock);
 }
 
-/* This task keeps the wav sink ring buffer empty */
-portTASK_FUNCTION(wavSinkTask, pvParameters)
+/*
+ * Keeps the wav sink ring buffer empty.  Runs in task context.
+ */
+void wavSinkService(APP_CONTEXT *context)
 {
-    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
     WAV_FILE *wavSink = &context->wavSink;
     PaUtilRingBuffer *wavSinkRB = context->wavSinkRB;
-    uint32_t whatToDo;
     unsigned samplesIn;
     unsigned samplesOut;
-    size_t wsize;
-    bool ok;
 
-    while (1) {
-        xSemaphoreTake(wavSink->lock, portMAX_DELAY);
-        if (wavSink->enabled) {
-            samplesIn = PaUtil_GetRingBufferReadAvailable(wavSinkRB);
-            samplesOut = wavSink->channels * SYSTEM_BLOCK_SIZE;
-            ok = true;
-            while (ok && (samplesIn >= samplesOut)) {
-                PaUtil_ReadRingBuffer(
-                    wavSinkRB, sinkBuffer2, samplesOut
-                );
-                wsize = writeWave(wavSink, sinkBuffer2, samplesOut);
-                samplesIn = PaUtil_GetRingBufferReadAvailable(wavSinkRB);
+    xSemaphoreTake(wavSink->lock, portMAX_DELAY);
+    if (wavSink->enabled) {
+        samplesIn = PaUtil_GetRingBufferReadAvailable(wavSinkRB);
+        samplesOut = wavSink->channels * SYSTEM_BLOCK_SIZE;
+        while (samplesIn >= samplesOut) {
+            if (!readyWave(wavSink, samplesOut)) {
+                break;
             }
-        } else {
-            PaUtil_FlushRingBuffer(wavSinkRB);
+            PaUtil_ReadRingBuffer(
+                wavSinkRB, sinkBuffer2, samplesOut
+            );
+            writeWave(wavSink, sinkBuffer2, samplesOut);
+            samplesIn = PaUtil_GetRingBufferReadAvailable(wavSinkRB);
         }
-        xSemaphoreGive(wavSink->lock);
-        whatToDo = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+    } else {
+        PaUtil_FlushRingBuffer(wavSinkRB);
+    }
+    xSemaphoreGive(wavSink->lock);
+}
+
+/* This task keeps the wav src ring buffer full */
+portTASK_FUNCTION(wavSrcTask, pvParameters)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
+
+    while (1) {
+        wavSrcService(context);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+    }
+}
+
+/* This task keeps the wav sink ring buffer empty */
+portTASK_FUNCTION(wavSinkTask, pvParameters)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
+
+    while (1) {
+        wavSinkService(context);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
     }
 }
 
@@ -18,6 +18,10 @@
 
 void wav_audio_init(APP_CONTEXT *context);
 
+/* Ring buffer / file servicing, called from the wav tasks */
+void wavSrcService(APP_CONTEXT *context);
+void wavSinkService(APP_CONTEXT *context);
+
 SAE_MSG_BUFFER *xferWavSinkAudio(APP_CONTEXT *context, SAE_MSG_BUFFER *msg,
     CLOCK_DOMAIN cd);
 
@@ -28,6 +28,15 @@
 #define WAVE_FILE_FREE free
 #endif
 
+#ifndef WAVE_FILE_FOPEN
+#define WAVE_FILE_FOPEN fopen
+#endif
+
+/* Returns true if 'size' bytes can be transferred without blocking */
+#ifndef WAVE_FILE_READY
+#define WAVE_FILE_READY(f, size) (true)
+#endif
+
 /***********************************************************************
  * WAVE helper functions, typedefs and defines
  **********************************************************************/
@@ -310,9 +319,9 @@ bool openWave(WAV_FILE *wf)
 {
     bool ok = false;
 
-    wf->f = fopen(wf->fname, wf->isSrc ? "rb" : "wb");
+    wf->f = WAVE_FILE_FOPEN(wf->fname, wf->isSrc ? "rb" : "wb");
     if (wf->f) {
-#ifdef WAVE_FILE_BUF_SIZE
+#if WAVE_FILE_BUF_SIZE > 0
         wf->fileBuf = (char *)WAVE_FILE_CALLOC(WAVE_FILE_BUF_SIZE, 1);
         setvbuf(wf->f, wf->fileBuf, _IOFBF, WAVE_FILE_BUF_SIZE);
 #else
@@ -400,6 +409,20 @@ size_t readWave(WAV_FILE *wf, void *buf, size_t samples)
     return(ok ? rsize : -1);
 }
 
+bool readyWave(WAV_FILE *wf, size_t samples)
+{
+    size_t remaining;
+
+    if (wf->isSrc) {
+        remaining = wf->dataSize - wf->dataOffset;
+        if (samples > remaining) {
+            samples = remaining;
+        }
+    }
+
+    return(WAVE_FILE_READY(wf->f, samples * wf->wordSizeBytes));
+}
+
 size_t writeWave(WAV_FILE *wf, void *buf, size_t samples)
 {
     size_t wsize;
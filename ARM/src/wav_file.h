@@ -76,6 +76,7 @@ bool openWave(WAV_FILE *wf);
 void closeWave(WAV_FILE *wf);
 size_t readWave(WAV_FILE *wf, void *buf, size_t samples);
 size_t writeWave(WAV_FILE *wf, void *buf, size_t samples);
+bool readyWave(WAV_FILE *wf, size_t samples);
 void overrideWave(WAV_FILE *wf, unsigned channels);
 
 #endif
@@ -0,0 +1,233 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * MDMA copy backend of the audio router (route_copy.h).
+ *
+ * Every queued copy becomes one 2D descriptor on each side of an MDMA
+ * stream: XCNT walks the route's channels in a frame, YCNT the frames
+ * and YMOD skips the remaining channels of the stream.  The
+ * descriptors of a clock domain are chained in descriptor list mode
+ * and started with a single write per channel.  The last destination
+ * descriptor stops the chain and raises IRQDONE, which is polled since
+ * the router is already done with its own routes by then.
+ *
+ * The audio stream buffers are in SAE shared memory which SHARC0 does
+ * not cache, so no flushing is required.  The descriptors are in L1
+ * and are handed to the DMA by their system (slave port) address.
+ *
+ * If the engine reports an error or does not finish within
+ * ROUTE_MDMA_TIMEOUT_CYCLES the block's copies are redone by the core
+ * and all later copies stay on the core.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <sys/platform.h>
+#include <cycle_count.h>
+
+#include "route_copy.h"
+#include "clocks.h"
+
+/* SHARC L1 Slave 1 port addresses and offsets */
+#define SHARC_L1_ADDR_START   0x00240000u
+#define SHARC_L1_ADDR_END     0x0039FFFFu
+#define SHARC_L1_ADDR_OFFSET  0x28000000u
+
+/*
+ * MDMA1 stream registers (source and destination channels)
+ */
+#define MDMA_SRC_DSCPTR_NXT   pREG_DMA18_DSCPTR_NXT
+#define MDMA_SRC_CFG          pREG_DMA18_CFG
+#define MDMA_SRC_STAT         pREG_DMA18_STAT
+#define MDMA_DST_DSCPTR_NXT   pREG_DMA19_DSCPTR_NXT
+#define MDMA_DST_CFG          pREG_DMA19_CFG
+#define MDMA_DST_STAT         pREG_DMA19_STAT
+
+/* Max number of copies per clock domain */
+#ifndef ROUTE_MDMA_MAX_COPIES
+#define ROUTE_MDMA_MAX_COPIES (32)
+#endif
+
+/* Completion timeout, longer than a full block at the highest rate */
+#ifndef ROUTE_MDMA_TIMEOUT_CYCLES
+#define ROUTE_MDMA_TIMEOUT_CYCLES (CCLK / 5000)   /* 200 uS */
+#endif
+
+#define MDMA_CFG_COMMON \
+    (ENUM_DMA_CFG_MSIZE04 | ENUM_DMA_CFG_PSIZE04 | ENUM_DMA_CFG_ADDR2D | \
+     ENUM_DMA_CFG_FETCH07 | ENUM_DMA_CFG_EN)
+
+/* Descriptor list mode descriptor, fetched as 7 words */
+typedef struct _ROUTE_MDMA_DESC {
+    void *next;
+    void *start;
+    uint32_t cfg;
+    uint32_t xCount;
+    int32_t xModify;
+    uint32_t yCount;
+    int32_t yModify;
+} ROUTE_MDMA_DESC;
+
+/* The queued copies, kept for the core fallback */
+typedef struct _ROUTE_MDMA_COPY {
+    int32_t *out;
+    const int32_t *in;
+    unsigned outStride;
+    unsigned inStride;
+    unsigned channels;
+    unsigned frames;
+} ROUTE_MDMA_COPY;
+
+static ROUTE_MDMA_DESC srcDesc[ROUTE_MDMA_MAX_COPIES];
+static ROUTE_MDMA_DESC dstDesc[ROUTE_MDMA_MAX_COPIES];
+static ROUTE_MDMA_COPY copies[ROUTE_MDMA_MAX_COPIES];
+static unsigned numCopies = 0;
+static bool running = false;
+static bool failed = false;
+
+static inline void *local_to_system_addr(void *x)
+{
+    if (((uint32_t)x >= SHARC_L1_ADDR_START) && ((uint32_t)x <= SHARC_L1_ADDR_END)) {
+        x = (void *)((uint32_t)x + SHARC_L1_ADDR_OFFSET);
+    }
+    return(x);
+}
+
+static void mdma_desc(ROUTE_MDMA_DESC *desc, void *start, unsigned stride,
+    unsigned channels, unsigned frames, uint32_t cfg)
+{
+    desc->next = NULL;
+    desc->start = local_to_system_addr(start);
+    desc->cfg = cfg;
+    desc->xCount = channels;
+    desc->xModify = sizeof(int32_t);
+    desc->yCount = frames;
+    desc->yModify = (int32_t)((stride - channels + 1) * sizeof(int32_t));
+}
+
+/* Does the queued copies with the core */
+static void mdma_core_copy(void)
+{
+    ROUTE_MDMA_COPY *copy;
+    const int32_t *in;
+    int32_t *out;
+    unsigned i, frame;
+
+    for (i = 0; i < numCopies; i++) {
+        copy = &copies[i];
+        in = copy->in;
+        out = copy->out;
+        for (frame = 0; frame < copy->frames; frame++) {
+            memcpy(out, in, copy->channels * sizeof(*out));
+            in += copy->inStride;
+            out += copy->outStride;
+        }
+    }
+}
+
+bool route_copy_add(int32_t *out, unsigned outStride, const int32_t *in,
+    unsigned inStride, unsigned channels, unsigned frames)
+{
+    ROUTE_MDMA_COPY *copy;
+    unsigned i;
+
+    if (failed || running || (numCopies >= ROUTE_MDMA_MAX_COPIES)) {
+        return(false);
+    }
+
+    i = numCopies;
+
+    copy = &copies[i];
+    copy->out = out;
+    copy->outStride = outStride;
+    copy->in = in;
+    copy->inStride = inStride;
+    copy->channels = channels;
+    copy->frames = frames;
+
+    mdma_desc(&srcDesc[i], (void *)in, inStride, channels, frames,
+        MDMA_CFG_COMMON | ENUM_DMA_CFG_READ | ENUM_DMA_CFG_DSCLIST);
+    mdma_desc(&dstDesc[i], out, outStride, channels, frames,
+        MDMA_CFG_COMMON | ENUM_DMA_CFG_WRITE | ENUM_DMA_CFG_DSCLIST);
+
+    if (i > 0) {
+        srcDesc[i - 1].next = local_to_system_addr(&srcDesc[i]);
+        dstDesc[i - 1].next = local_to_system_addr(&dstDesc[i]);
+    }
+
+    numCopies++;
+
+    return(true);
+}
+
+void route_copy_start(void)
+{
+    unsigned last;
+
+    if ((numCopies == 0) || running) {
+        return;
+    }
+
+    /* Stop after the last copy, flag completion on the destination */
+    last = numCopies - 1;
+    srcDesc[last].cfg = MDMA_CFG_COMMON | ENUM_DMA_CFG_READ | ENUM_DMA_CFG_STOP;
+    dstDesc[last].cfg = MDMA_CFG_COMMON | ENUM_DMA_CFG_WRITE | ENUM_DMA_CFG_STOP |
+        ENUM_DMA_CFG_YCNT_INT;
+
+    *MDMA_DST_STAT = *MDMA_DST_STAT;
+    *MDMA_SRC_STAT = *MDMA_SRC_STAT;
+
+    /* Destination first so it is ready when the source starts */
+    *MDMA_DST_DSCPTR_NXT = local_to_system_addr(&dstDesc[0]);
+    *MDMA_DST_CFG = ENUM_DMA_CFG_WRITE | ENUM_DMA_CFG_FETCH07 |
+        ENUM_DMA_CFG_DSCLIST | ENUM_DMA_CFG_EN;
+    *MDMA_SRC_DSCPTR_NXT = local_to_system_addr(&srcDesc[0]);
+    *MDMA_SRC_CFG = ENUM_DMA_CFG_READ | ENUM_DMA_CFG_FETCH07 |
+        ENUM_DMA_CFG_DSCLIST | ENUM_DMA_CFG_EN;
+
+    running = true;
+}
+
+void route_copy_wait(void)
+{
+    cycle_t startCycles;
+    cycle_t cycles;
+    uint32_t stat;
+    bool done;
+
+    if (running) {
+        START_CYCLE_COUNT(startCycles);
+        do {
+            stat = *MDMA_DST_STAT | *MDMA_SRC_STAT;
+            done = (stat & (ENUM_DMA_STAT_IRQDONE | ENUM_DMA_STAT_IRQERR)) != 0;
+            STOP_CYCLE_COUNT(cycles, startCycles);
+        } while (!done && (cycles < ROUTE_MDMA_TIMEOUT_CYCLES));
+
+        *MDMA_SRC_CFG = 0;
+        *MDMA_DST_CFG = 0;
+        *MDMA_DST_STAT = *MDMA_DST_STAT;
+        *MDMA_SRC_STAT = *MDMA_SRC_STAT;
+
+        /* Leave bulk copies to the core from now on if the engine
+         * faults or hangs, and redo this block's copies.
+         */
+        if (!done || (stat & ENUM_DMA_STAT_IRQERR)) {
+            failed = true;
+            mdma_core_copy();
+        }
+
+        running = false;
+    }
+
+    numCopies = 0;
+}
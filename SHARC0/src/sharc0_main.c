@@ -11,6 +11,7 @@
 
 /* Standard includes. */
 #include <assert.h>
+#include <string.h>
 
 #define DO_CYCLE_COUNTS
 
@@ -25,185 +26,100 @@
 /* IPC includes */
 #include "ipc.h"
 
+/* Trace includes */
+#include "trace.h"
+
+/* Router includes */
+#include "route.h"
+
+/* Meter includes */
+#include "meter.h"
+
+/* Latency probe includes */
+#include "latency.h"
+
+/* Mixer includes */
+#include "mixer.h"
+
+/* Scene includes */
+#include "scene.h"
+#include "scene_msg.h"
+
 SAE_CONTEXT *saeContext = NULL;
 SAE_MSG_BUFFER *cyclesMsg = NULL;
 
-IPC_MSG_ROUTING *routeInfo = NULL;
 IPC_MSG_AUDIO *streamInfo[IPC_STREAM_ID_MAX];
+unsigned routeBlocks[IPC_CYCLE_DOMAIN_MAX];
 
-#pragma optimize_for_speed
 static void routeAudio(uint8_t clockDomain)
 {
-    ROUTE_INFO *route;
-    IPC_MSG_AUDIO *src, *sink, *stream;
-    uint8_t channels;
-    int32_t *in, *out;
-    uint8_t inChannel, outChannel;
-    unsigned frame;
-    unsigned channel;
-    int32_t sample;
-    unsigned i;
+    IPC_MSG_AUDIO *domainStreams[IPC_STREAM_ID_MAX];
+    IPC_MSG_ROUTING *routeInfo;
     cycle_t startCycles;
     cycle_t finalCycles;
-    uint8_t attenuationShift;
+    bool calibrate = false;
 
     /* Toggle LED 11 for measurement */
     adi_gpio_Toggle(ADI_GPIO_PORT_D, ADI_GPIO_PIN_2);
 
+    routeInfo = scene_msg_routes();
     if (routeInfo == NULL) {
         return;
     }
 
-    START_CYCLE_COUNT(startCycles);
+    TRACE_BEGIN(TRACE_ID_ROUTE_AUDIO, clockDomain);
 
-    /* Run all routes associated with this clock domain */
-    for (i = 0; i < routeInfo->numRoutes; i++) {
+    /*
+     * route_audio() releases the domain's streams, keep them for the
+     * mixer, the latency probe and metering
+     */
+    memcpy(domainStreams, streamInfo, sizeof(domainStreams));
 
-        route = &routeInfo->routes[i];
+    latency_pre_route(streamInfo, clockDomain);
 
-        if (route->srcID == IPC_STREAMID_UNKNOWN) {
-            continue;
-        }
-        if (route->sinkID == IPC_STREAMID_UNKNOWN) {
-            continue;
+    if (clockDomain < IPC_CYCLE_DOMAIN_MAX) {
+        if (++routeBlocks[clockDomain] >= ROUTE_CALIBRATE_BLOCKS) {
+            routeBlocks[clockDomain] = 0;
+            calibrate = true;
         }
+    }
+    route_offload(!calibrate);
 
-        src = streamInfo[route->srcID];
-        sink = streamInfo[route->sinkID];
+    START_CYCLE_COUNT(startCycles);
 
-        if ((src == NULL) || (sink == NULL)) {
-            continue;
-        }
+    scene_fade_pre(domainStreams, clockDomain);
+    route_audio(routeInfo, streamInfo, clockDomain);
+    mixer_audio(domainStreams, clockDomain);
+    scene_fade_post(domainStreams, clockDomain);
 
-        if (src->clockDomain != clockDomain) {
-            continue;
-        }
-        if (sink->clockDomain != clockDomain) {
-            continue;
-        }
+    STOP_CYCLE_COUNT(finalCycles, startCycles);
 
-#if 1
-        if (src->numFrames != sink->numFrames) {
-            continue;
-        }
-        if (src->wordSize != sink->wordSize) {
-            continue;
-        }
-        if (src->wordSize != sizeof(int32_t)) {
-            continue;
-        }
-        if (route->srcOffset >= src->numChannels) {
-            continue;
-        }
-        if (route->sinkOffset >= sink->numChannels) {
-            continue;
-        }
-#endif
-
-        inChannel = route->srcOffset;
-        outChannel = route->sinkOffset;
-
-        channels = route->channels;
-        in = src->data + inChannel;
-        out = sink->data + outChannel;
-
-        attenuationShift = route->attenuation / 6;
-
-        for (frame = 0; frame < src->numFrames; frame++) {
-            for (channel = 0; channel < channels; channel++) {
-                if ((outChannel + channel) < sink->numChannels) {
-                    if ((inChannel + channel) < src->numChannels) {
-                        sample = *(in + channel);
-                    } else {
-                        sample = 0;
-                    }
-                    *(out + channel) = sample >> attenuationShift;
-                }
-            }
-            in += src->numChannels;
-            out += sink->numChannels;
-        }
+    route_offload(true);
 
-    }
+    scene_msg_block();
 
-    /* Invalidate all streams associated with this clock domain */
-    for (i = 0; i < IPC_STREAM_ID_MAX; i++) {
-        stream = streamInfo[i];
-        if (stream && (stream->clockDomain == clockDomain)) {
-            streamInfo[i] = NULL;
+    if (clockDomain < IPC_CYCLE_DOMAIN_MAX) {
+        IPC_MSG *msg = sae_getMsgBufferPayload(cyclesMsg);
+        if (calibrate) {
+            msg->cycles.coreCycles[clockDomain] = finalCycles;
+        } else {
+            msg->cycles.cycles[clockDomain] = finalCycles;
         }
     }
 
-    STOP_CYCLE_COUNT(finalCycles, startCycles);
+    latency_post_route(domainStreams, clockDomain);
 
-    if (clockDomain < IPC_CYCLE_DOMAIN_MAX) {
-        IPC_MSG *msg = sae_getMsgBufferPayload(cyclesMsg);
-        msg->cycles.cycles[clockDomain] = finalCycles;
-    }
+    /* Meter the sources and the routed sinks */
+    START_CYCLE_COUNT(startCycles);
 
-}
+    meter_audio(domainStreams, clockDomain);
 
-/*
- * All audio SPORT interrupts (CODEC, SPDIF, A2B) have been hardware aligned
- * at startup by gating their respective bit clocks until all
- * SPORTs have been configured then turning on all clocks at once.  The
- * SPORTs count down exactly 1 frame of bit clocks before starting. This
- * is initiated on the ARM side in init.c -> enable_sport_mclk()
- *
- * The USB RX/TX, WAV src/sink, and RTP sink piggy-back off of their
- * associated clock domain to function like time aligned SPORTs.
- *
- */
-static void newAudio(IPC_MSG_AUDIO *audio)
-{
-    bool clear = false;
-    bool unknown = false;
+    STOP_CYCLE_COUNT(finalCycles, startCycles);
 
-    switch (audio->streamID) {
-        case IPC_STREAMID_CODEC_IN:
-            break;
-        case IPC_STREAMID_CODEC_OUT:
-            clear = true;
-            break;
-        case IPC_STREAMID_SPDIF_IN:
-            break;
-        case IPC_STREAMID_SPDIF_OUT:
-            clear = true;
-            break;
-        case IPC_STREAMID_A2B_IN:
-            break;
-        case IPC_STREAMID_A2B_OUT:
-            clear = true;
-            break;
-        case IPC_STREAMID_MIC_IN:
-            break;
-        case IPC_STREAMID_USB_RX:
-            break;
-        case IPC_STREAMID_USB_TX:
-            clear = true;
-            break;
-        case IPC_STREAM_ID_WAVE_SRC:
-            break;
-        case IPC_STREAM_ID_WAVE_SINK:
-            clear = true;
-            break;
-        case IPC_STREAM_ID_RTP_IN:
-            break;
-        case IPC_STREAM_ID_RTP_OUT:
-            clear = true;
-            break;
-        default:
-            unknown = true;
-            break;
-    }
+    meter_cycles(clockDomain, finalCycles);
+
+    TRACE_END(TRACE_ID_ROUTE_AUDIO, clockDomain);
 
-    if (!unknown) {
-        streamInfo[audio->streamID] = audio;
-        if (clear) {
-            memset(audio->data, 0,
-                audio->numChannels * audio->numFrames * audio->wordSize);
-        }
-    }
 }
 
 static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
@@ -219,8 +135,11 @@ static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
     /* Process the message */
     switch (msg->type) {
         case IPC_TYPE_PING:
-            ipcBuffer = sae_createMsgBuffer(saeContext, sizeof(*replyMsg), (void **)&replyMsg);
+            ipcBuffer = sae_createMsgBuffer(saeContext, sizeof(*replyMsg),
+                SAE_ALLOC_BULK, (void **)&replyMsg);
             replyMsg->type = IPC_TYPE_PING;
+            replyMsg->ping.core = IPC_CORE_SHARC0;
+            replyMsg->ping.seq = msg->ping.seq;
             result = sae_sendMsgBuffer(saeContext, ipcBuffer, IPC_CORE_ARM, true);
             if (result != SAE_RESULT_OK) {
                 sae_unRefMsgBuffer(saeContext, ipcBuffer);
@@ -228,10 +147,10 @@ static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
             break;
         case IPC_TYPE_AUDIO:
             audio = (IPC_MSG_AUDIO *)&msg->audio;
-            newAudio(audio);
+            route_new_audio(streamInfo, audio);
             break;
         case IPC_TYPE_AUDIO_ROUTING:
-            routeInfo = (IPC_MSG_ROUTING *)&msg->routes;
+            scene_msg_routing(buffer);
             break;
         case IPC_TYPE_CYCLES:
             if (cyclesMsg) {
@@ -246,6 +165,21 @@ static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
             process = (IPC_MSG_PROCESS_AUDIO *)&msg->process;
             routeAudio(process->clockDomain);
             break;
+        case IPC_TYPE_TRACE:
+            trace_attach((TRACE_BUFFER *)msg->trace.buffer, IPC_CORE_SHARC0);
+            break;
+        case IPC_TYPE_METER:
+            meter_attach((METER_TABLE *)msg->meter.table);
+            break;
+        case IPC_TYPE_LATENCY:
+            latency_attach((LATENCY_PROBE *)msg->latency.probe);
+            break;
+        case IPC_TYPE_MIXER:
+            scene_msg_mixer(buffer);
+            break;
+        case IPC_TYPE_SCENE:
+            scene_msg_scene(buffer);
+            break;
         default:
             break;
     }
@@ -268,12 +202,15 @@ int main(int argc, char **argv)
 
     /* Initialize the SHARC Audio Engine */
     sae_initialize(&saeContext, SAE_CORE_IDX_1, false);
+    scene_msg_init(saeContext);
 
     /* Create a persistent message for cycle counts */
-    cyclesMsg = sae_createMsgBuffer(saeContext, sizeof(*msg), (void **)&msg);
+    cyclesMsg = sae_createMsgBuffer(saeContext, sizeof(*msg),
+        SAE_ALLOC_BULK, (void **)&msg);
     msg->type = IPC_TYPE_CYCLES;
     msg->cycles.core = IPC_CORE_SHARC0;
     msg->cycles.max = IPC_CYCLE_DOMAIN_MAX;
+    memset(msg->cycles.coreCycles, 0, sizeof(msg->cycles.coreCycles));
 
     /* Register an IPC message Rx callback */
     sae_registerMsgReceivedCallback(saeContext, ipcMsgRx, NULL);
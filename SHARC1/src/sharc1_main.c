@@ -20,6 +20,9 @@
 /* IPC includes */
 #include "ipc.h"
 
+/* Trace includes */
+#include "trace.h"
+
 SAE_CONTEXT *saeContext;
 
 static void processAudio(IPC_MSG_AUDIO *audio)
@@ -30,6 +33,8 @@ static void processAudio(IPC_MSG_AUDIO *audio)
     uint8_t wordSize = audio->wordSize;
     int32_t *data = audio->data;
 
+    TRACE_BEGIN(TRACE_ID_PROCESS_AUDIO, streamID);
+
     switch (audio->streamID) {
         case IPC_STREAMID_CODEC_IN:
             asm("nop;");
@@ -67,6 +72,8 @@ static void processAudio(IPC_MSG_AUDIO *audio)
         default:
             break;
     }
+
+    TRACE_END(TRACE_ID_PROCESS_AUDIO, streamID);
 }
 
 static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
@@ -81,8 +88,11 @@ static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
     /* Process the message */
     switch (msg->type) {
         case IPC_TYPE_PING:
-            ipcBuffer = sae_createMsgBuffer(saeContext, sizeof(*replyMsg), (void **)&replyMsg);
+            ipcBuffer = sae_createMsgBuffer(saeContext, sizeof(*replyMsg),
+                SAE_ALLOC_BULK, (void **)&replyMsg);
             replyMsg->type = IPC_TYPE_PING;
+            replyMsg->ping.core = IPC_CORE_SHARC1;
+            replyMsg->ping.seq = msg->ping.seq;
             result = sae_sendMsgBuffer(saeContext, ipcBuffer, SAE_CORE_IDX_0, true);
             if (result != SAE_RESULT_OK) {
                 sae_unRefMsgBuffer(saeContext, ipcBuffer);
@@ -92,6 +102,9 @@ static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
             audio = (IPC_MSG_AUDIO *)&msg->audio;
             processAudio(audio);
             break;
+        case IPC_TYPE_TRACE:
+            trace_attach((TRACE_BUFFER *)msg->trace.buffer, IPC_CORE_SHARC1);
+            break;
         default:
             break;
     }
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host simulation stand-in for the handful of FreeRTOS services used by
+ * the audio path.  All ARM side code runs on the single simulation
+ * scheduler thread so critical sections and mutexes reduce to no-ops
+ * and tasks are replaced by service functions called between
+ * interrupts.
+ */
+#ifndef _sim_FreeRTOS_h
+#define _sim_FreeRTOS_h
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void *QueueHandle_t;
+typedef void *EventGroupHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+#define pdFALSE                  ((BaseType_t)0)
+#define pdTRUE                   ((BaseType_t)1)
+#define pdPASS                   (pdTRUE)
+#define pdFAIL                   (pdFALSE)
+
+#define portMAX_DELAY            ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ       (1000)
+#define configMAX_TASK_NAME_LEN  (16)
+#define configMINIMAL_STACK_SIZE (256)
+#define tskIDLE_PRIORITY         ((UBaseType_t)0)
+#define pdMS_TO_TICKS(ms)        ((TickType_t)(ms))
+
+#define portTASK_FUNCTION(vFunction, pvParameters) \
+    void vFunction(void *pvParameters)
+
+#define taskENTER_CRITICAL()               do { } while (0)
+#define taskEXIT_CRITICAL()                do { } while (0)
+#define taskENTER_CRITICAL_FROM_ISR()      (0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)      do { (void)(x); } while (0)
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName,
+    uint32_t usStackDepth, void *pvParameters, UBaseType_t uxPriority,
+    TaskHandle_t *pxCreatedTask);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue,
+    eNotifyAction eAction, BaseType_t *pxHigherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+void vTaskDelay(TickType_t xTicksToDelay);
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore);
+
+#endif
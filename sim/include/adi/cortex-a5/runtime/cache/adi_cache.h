@@ -0,0 +1,22 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Host simulation stand-in for the CCES cache API.  The host is coherent. */
+#ifndef _sim_adi_cache_h
+#define _sim_adi_cache_h
+
+#define ADI_FLUSH_DATA_NOINV  (0)
+#define ADI_FLUSH_DATA_INV    (1)
+
+#define flush_data_buffer(start, end, inv) \
+    do { (void)(start); (void)(end); (void)(inv); } while (0)
+
+#endif
@@ -0,0 +1,16 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Host simulation stand-in, no processor definitions are needed */
+#ifndef _sim_ADSP_SC589_cdef_h
+#define _sim_ADSP_SC589_cdef_h
+
+#endif
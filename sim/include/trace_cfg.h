@@ -0,0 +1,24 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host simulation trace configuration.  Shadows ALL/include/trace_cfg.h
+ * since there is no CGU timestamp counter to sample on the host.
+ */
+#ifndef _trace_cfg_h
+#define _trace_cfg_h
+
+#define TRACE_ENABLE             (0)
+#define TRACE_EVENTS_PER_CORE    (256)
+#define TRACE_TIMESTAMP()        (0)
+#define TRACE_TIMESTAMP_HZ       (1)
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Host simulation of the audio clock domain pipeline
+ *
+ *   The ARM side audio sources (SPORT callbacks, USB endpoint
+ *   callbacks, wav servicing) all run on a single discrete event
+ *   scheduler thread.  SHARC0's router runs on its own thread behind
+ *   an emulated SAE message queue.
+ *
+ * @file      sim.h
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#ifndef _sim_h
+#define _sim_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <stdio.h>
+
+#include "sae.h"
+#include "clock_domain_defs.h"
+#include "latency.h"
+
+/*!****************************************************************
+ * @brief  Processing time statistics (host nS per call)
+ ******************************************************************/
+typedef struct _SIM_STAT {
+    const char *name;
+    uint32_t *ns;
+    unsigned count;
+    unsigned size;
+} SIM_STAT;
+
+/*!****************************************************************
+ * @brief  Current simulation time in nS
+ ******************************************************************/
+uint64_t sim_now_ns(void);
+
+/*!****************************************************************
+ * @brief  Host monotonic clock in nS
+ ******************************************************************/
+uint64_t sim_host_ns(void);
+
+/*!****************************************************************
+ * @brief  Records one processing time sample
+ ******************************************************************/
+void sim_stat_add(SIM_STAT *stat, uint64_t ns);
+
+/*!****************************************************************
+ * @brief  Writes one CSV line of statistics
+ *
+ * Columns are name, count, min, mean, p99 and max in nS.  Nothing
+ * is written for an empty statistic.
+ ******************************************************************/
+void sim_stat_report(FILE *f, SIM_STAT *stat);
+
+/*!****************************************************************
+ * @brief  Frees the recorded samples
+ ******************************************************************/
+void sim_stat_free(SIM_STAT *stat);
+
+/*!****************************************************************
+ * @brief  Starts the SHARC0 router thread
+ ******************************************************************/
+bool sim_sharc0_start(void);
+
+/*!****************************************************************
+ * @brief  Waits for the router to go idle then stops it
+ ******************************************************************/
+void sim_sharc0_stop(void);
+
+/*!****************************************************************
+ * @brief  Per clock domain router processing time
+ ******************************************************************/
+SIM_STAT *sim_sharc0_route_stat(CLOCK_DOMAIN cd);
+
+/*!****************************************************************
+ * @brief  Per clock domain router processing time of the calibration
+ *         blocks routed without the copy engine
+ ******************************************************************/
+SIM_STAT *sim_sharc0_route_core_stat(CLOCK_DOMAIN cd);
+
+/*!****************************************************************
+ * @brief  Emulated copy engine time over all clock domains
+ ******************************************************************/
+SIM_STAT *sim_sharc0_mdma_stat(void);
+
+/*!****************************************************************
+ * @brief  Meter processing time over all clock domains
+ ******************************************************************/
+SIM_STAT *sim_sharc0_meter_stat(void);
+
+/*!****************************************************************
+ * @brief  Writes the loudest channel of each metered stream
+ ******************************************************************/
+void sim_sharc0_meter_report(FILE *f);
+
+/*!****************************************************************
+ * @brief  Sets the meter block rate and the metered streams
+ *         (METER_STREAM() mask)
+ ******************************************************************/
+void sim_sharc0_meter_config(unsigned blockHz, uint32_t streams);
+
+/*!****************************************************************
+ * @brief  Latency probe table SHARC0 is attached to
+ ******************************************************************/
+LATENCY_PROBE *sim_sharc0_latency(void);
+
+/*!****************************************************************
+ * @brief  Enables or disables the emulated MDMA copy engine
+ ******************************************************************/
+void sim_mdma_enable(bool enable);
+
+/*!****************************************************************
+ * @brief  Returns and clears the host time spent in the emulated
+ *         copy engine
+ ******************************************************************/
+uint64_t sim_mdma_take_ns(void);
+
+/*!****************************************************************
+ * @brief  Runs one received message through the core's callback.
+ *
+ * Blocks until a message arrives or sim_sae_shutdown() is called.
+ *
+ * @return Returns false on shutdown.
+ ******************************************************************/
+bool sim_sae_dispatch(SAE_CONTEXT *context);
+
+/*!****************************************************************
+ * @brief  Blocks until a core has drained its message queue
+ ******************************************************************/
+void sim_sae_wait_idle(SAE_CORE_IDX core);
+
+/*!****************************************************************
+ * @brief  Releases every core blocked in sim_sae_dispatch()
+ ******************************************************************/
+void sim_sae_shutdown(void);
+
+/*!****************************************************************
+ * @brief  Number of message buffers currently allocated
+ ******************************************************************/
+unsigned sim_sae_live_buffers(void);
+
+#endif
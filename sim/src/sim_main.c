@@ -0,0 +1,1599 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host simulation of the audio clock domain pipeline.
+ *
+ * A discrete event scheduler stands in for the SPORT DMA and USB
+ * interrupts and calls the unmodified ARM callbacks (dacAudioOut(),
+ * adcAudioIn(), ...), which in turn drive sharcAudio(), the clock
+ * domain helpers and the USB/WAV transfer functions.  SHARC0's router
+ * runs on its own thread behind an emulated SAE.
+ *
+ * SPORT inputs carry a deterministic pseudo-random pattern unless they
+ * are looped back from an output.  Every output stream is hashed,
+ * optionally dumped raw, and can be recorded to or checked against a
+ * golden vector file.  The latency probe can be run against any pair
+ * of streams in place of the 'latency' shell command.
+ *
+ * By default the scheduler waits for the router to finish after every
+ * interrupt (lockstep) so the outputs are bit-exact across runs and
+ * hosts.  '-t' paces the interrupts to the host clock instead.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "context.h"
+#include "clock_domain.h"
+#include "codec_audio.h"
+#include "spdif_audio.h"
+#include "a2b_audio.h"
+#include "mic_audio.h"
+#include "usb_audio.h"
+#include "wav_audio.h"
+#include "wav_file.h"
+#include "mixer_control.h"
+#include "route_control.h"
+#include "scene_control.h"
+#include "meter.h"
+#include "buffer_track.h"
+#include "cpu_load.h"
+#include "util.h"
+#include "ipc.h"
+#include "sae.h"
+
+#include "sim.h"
+
+/* Default number of DAC blocks to run */
+#define SIM_DEFAULT_BLOCKS   (1000)
+
+/* USB high speed microframe period */
+#define SIM_USB_UFRAME_NS    (125000)
+
+/* Largest USB isochronous packet */
+#define SIM_USB_MAX_PKT      (1024)
+
+APP_CONTEXT mainAppContext;
+
+typedef void (*SIM_SPORT_CALLBACK)(void *buffer, uint32_t size, void *usrPtr);
+
+/*
+ * An output stream capture.  Everything written is folded into a
+ * 64-bit FNV-1a hash and optionally dumped to a raw file.
+ */
+typedef struct _SIM_OUTPUT {
+    const char *name;
+    uint64_t hash;
+    uint64_t bytes;
+    FILE *raw;
+} SIM_OUTPUT;
+
+/*
+ * An output wired back into an input like a cable.  The output keeps
+ * the last two blocks it started sending along with their start times.
+ */
+typedef struct _SIM_LOOP {
+    int32_t *data[2];
+    uint64_t time[2];
+    bool valid[2];
+    unsigned channels;
+    unsigned frames;
+    unsigned next;
+} SIM_LOOP;
+
+typedef struct _SIM_PORT {
+    const char *name;
+    const char *isrName;
+    SIM_SPORT_CALLBACK cb;
+    bool input;
+    void **buffers;
+    unsigned *len;
+    SAE_MSG_BUFFER **msgs;
+    bool enabled;
+    int32_t ppm;
+    uint64_t block;
+    uint64_t time;
+    uint64_t rng;
+    uint64_t stallAt;
+    uint64_t stallBlocks;
+    struct _SIM_PORT *loopSrc;
+    SIM_LOOP *loop;
+    SIM_STAT isr;
+    SIM_OUTPUT out;
+} SIM_PORT;
+
+enum {
+    SIM_PORT_DAC = 0,
+    SIM_PORT_ADC,
+    SIM_PORT_SPDIF_OUT,
+    SIM_PORT_SPDIF_IN,
+    SIM_PORT_A2B_OUT,
+    SIM_PORT_A2B_IN,
+    SIM_PORT_MIC,
+    SIM_PORT_MAX
+};
+
+static SIM_PORT ports[SIM_PORT_MAX] = {
+    [SIM_PORT_DAC] = {
+        .name = "dac", .isrName = "dacAudioOut", .cb = dacAudioOut
+    },
+    [SIM_PORT_ADC] = {
+        .name = "adc", .isrName = "adcAudioIn", .cb = adcAudioIn, .input = true
+    },
+    [SIM_PORT_SPDIF_OUT] = {
+        .name = "spdif_out", .isrName = "spdifAudioOut", .cb = spdifAudioOut
+    },
+    [SIM_PORT_SPDIF_IN] = {
+        .name = "spdif_in", .isrName = "spdifAudioIn", .cb = spdifAudioIn,
+        .input = true
+    },
+    [SIM_PORT_A2B_OUT] = {
+        .name = "a2b_out", .isrName = "a2bAudioOut", .cb = a2bAudioOut
+    },
+    [SIM_PORT_A2B_IN] = {
+        .name = "a2b_in", .isrName = "a2bAudioIn", .cb = a2bAudioIn,
+        .input = true
+    },
+    [SIM_PORT_MIC] = {
+        .name = "mic", .isrName = "micAudioIn", .cb = micAudioIn, .input = true
+    },
+};
+
+/*
+ * Mirrors the SAMPLE_RATE_PLAN in init.c.  MCLK is fixed so the codecs
+ * trade TDM slots for rate and SPDIF/A2B drop out at the higher rates.
+ */
+typedef struct _SIM_RATE_PLAN {
+    uint32_t rate;
+    uint8_t dacSlots;
+    uint8_t adcSlots;
+    bool spdif;
+    bool a2b;
+} SIM_RATE_PLAN;
+
+static const SIM_RATE_PLAN SIM_RATE_PLANS[] = {
+    {  48000, 16, 8, true,  true  },
+    {  96000,  8, 4, true,  false },
+    { 192000,  4, 2, false, false },
+};
+
+typedef struct _SIM_USB {
+    bool playEnabled;
+    bool recordEnabled;
+    WAV_FILE play;
+    WAV_FILE record;
+    int32_t ppm;
+    uint64_t uframe;
+    uint64_t time;
+    uint8_t rxPkt[SIM_USB_MAX_PKT];
+    uint8_t txPkt[SIM_USB_MAX_PKT];
+    void *rxData;
+    void *txData;
+    SIM_STAT rxIsr;
+    SIM_STAT txIsr;
+    SIM_OUTPUT out;
+} SIM_USB;
+
+static SIM_USB usb = {
+    .rxIsr = { .name = "uac2Rx" },
+    .txIsr = { .name = "uac2Tx" },
+    .out = { .name = "usb_in" },
+};
+
+static SIM_OUTPUT wavSinkOut = { .name = "wav_sink" };
+
+/* Latency probe trials, the sim's stand-in for the 'latency' command */
+typedef struct _SIM_LATENCY {
+    bool enabled;
+    const char *spec;
+    uint8_t srcID;
+    uint8_t srcChannel;
+    uint8_t sinkID;
+    uint8_t sinkChannel;
+    LATENCY_SIGNAL signal;
+    int32_t level;
+    unsigned trials;
+    unsigned started;
+    uint64_t armTime;
+    uint64_t nextTime;
+    bool failed;
+    LATENCY_STATS stats;
+} SIM_LATENCY;
+
+static SIM_LATENCY simLatency = {
+    .trials = 10,
+};
+
+static uint64_t simNow;
+static uint32_t simRate = SYSTEM_SAMPLE_RATE;
+static uint64_t simSeed = 1;
+static uint32_t simJitterNs;
+static bool simRealtime;
+
+uint64_t sim_now_ns(void)
+{
+    return(simNow);
+}
+
+uint64_t sim_host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/***********************************************************************
+ * Output capture
+ **********************************************************************/
+#define FNV_OFFSET  (0xcbf29ce484222325ULL)
+#define FNV_PRIME   (0x100000001b3ULL)
+
+static void outputInit(SIM_OUTPUT *out, const char *dir)
+{
+    char path[512];
+
+    out->hash = FNV_OFFSET;
+    out->bytes = 0;
+    out->raw = NULL;
+    if (dir) {
+        snprintf(path, sizeof(path), "%s/%s.raw", dir, out->name);
+        out->raw = fopen(path, "wb");
+        if (out->raw == NULL) {
+            fprintf(stderr, "sim: cannot create %s\n", path);
+        }
+    }
+}
+
+static void outputWrite(SIM_OUTPUT *out, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        out->hash = (out->hash ^ p[i]) * FNV_PRIME;
+    }
+    out->bytes += size;
+    if (out->raw) {
+        fwrite(data, 1, size, out->raw);
+    }
+}
+
+static void outputClose(SIM_OUTPUT *out)
+{
+    if (out->raw) {
+        fclose(out->raw);
+        out->raw = NULL;
+    }
+}
+
+/***********************************************************************
+ * Synthetic SPORT data and jitter
+ **********************************************************************/
+static uint64_t xorshift64(uint64_t *s)
+{
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *s = x;
+    return(x);
+}
+
+static int32_t synthSample(unsigned stream, unsigned channel, uint64_t n)
+{
+    uint32_t x;
+
+    x = (uint32_t)n * 2654435761u;
+    x ^= (channel << 24) ^ (stream << 16);
+    x ^= x >> 15;
+    x *= 0x2c1b3c6du;
+    x ^= x >> 12;
+
+    return((int32_t)x);
+}
+
+static void synthBlock(IPC_MSG_AUDIO *audio, uint64_t block)
+{
+    unsigned frame, channel;
+    int32_t *p = audio->data;
+    uint64_t n;
+
+    for (frame = 0; frame < audio->numFrames; frame++) {
+        n = block * audio->numFrames + frame;
+        for (channel = 0; channel < audio->numChannels; channel++) {
+            *p++ = synthSample(audio->streamID, channel, n);
+        }
+    }
+}
+
+/*
+ * Loopback.  An output interrupt at time T starts sending the block
+ * it saves here, an input interrupt at time T hands over what was
+ * recorded since about one period before.
+ */
+static void loopSave(SIM_PORT *port, IPC_MSG_AUDIO *audio)
+{
+    SIM_LOOP *loop = port->loop;
+    unsigned i = loop->next;
+
+    memcpy(loop->data[i], audio->data,
+        loop->channels * loop->frames * sizeof(int32_t));
+    loop->time[i] = simNow;
+    loop->valid[i] = true;
+    loop->next = i ^ 1;
+}
+
+static void loopBlock(SIM_PORT *port, IPC_MSG_AUDIO *audio)
+{
+    SIM_LOOP *loop = port->loopSrc->loop;
+    uint64_t start, d, best;
+    unsigned frame, channel, channels, frames;
+    int32_t *src, *dst;
+    int i, pick;
+
+    memset(audio->data, 0,
+        audio->numChannels * audio->numFrames * audio->wordSize);
+
+    start = simNow - (uint64_t)((1e9 * SYSTEM_BLOCK_SIZE) / simRate);
+    pick = -1;
+    best = UINT64_MAX;
+    for (i = 0; i < 2; i++) {
+        if (!loop->valid[i]) {
+            continue;
+        }
+        d = (loop->time[i] > start) ?
+            loop->time[i] - start : start - loop->time[i];
+        if (d < best) {
+            best = d;
+            pick = i;
+        }
+    }
+    if (pick < 0) {
+        return;
+    }
+
+    channels = (loop->channels < audio->numChannels) ?
+        loop->channels : audio->numChannels;
+    frames = (loop->frames < audio->numFrames) ?
+        loop->frames : audio->numFrames;
+    for (frame = 0; frame < frames; frame++) {
+        src = loop->data[pick] + frame * loop->channels;
+        dst = audio->data + frame * audio->numChannels;
+        for (channel = 0; channel < channels; channel++) {
+            dst[channel] = src[channel];
+        }
+    }
+}
+
+/* Nominal time of a port's next interrupt with its clock offset applied */
+static uint64_t portTime(SIM_PORT *port)
+{
+    double period;
+    int64_t jitter;
+    uint64_t t;
+
+    period = (1e9 * SYSTEM_BLOCK_SIZE) /
+        ((double)simRate * (1.0 + port->ppm * 1e-6));
+    t = (uint64_t)((port->block + 1) * period);
+
+    if (simJitterNs) {
+        jitter = (int64_t)(xorshift64(&port->rng) % (2 * simJitterNs + 1)) -
+            (int64_t)simJitterNs;
+        t += jitter;
+    }
+
+    return(t);
+}
+
+static uint64_t usbTime(void)
+{
+    return((uint64_t)((usb.uframe + 1) *
+        (SIM_USB_UFRAME_NS / (1.0 + usb.ppm * 1e-6))));
+}
+
+/***********************************************************************
+ * Interrupt sources
+ **********************************************************************/
+static IPC_MSG_AUDIO *portAudio(SIM_PORT *port, unsigned idx)
+{
+    IPC_MSG *msg = sae_getMsgBufferPayload(port->msgs[idx]);
+    return(&msg->audio);
+}
+
+/*
+ * Emulates the SPORT ping/pong DMA.  An input interrupt hands over the
+ * buffer just filled.  An output interrupt hands over the buffer just
+ * sent while DMA moves on to the other one, which is captured since
+ * its contents are now final.
+ */
+static void portIsr(APP_CONTEXT *context, SIM_PORT *port)
+{
+    unsigned idx = port->block & 1;
+    IPC_MSG_AUDIO *audio;
+    uint64_t start;
+
+    /* A stalled port misses its interrupts */
+    if ((port->block >= port->stallAt) &&
+        (port->block < port->stallAt + port->stallBlocks)) {
+        port->block++;
+        return;
+    }
+
+    if (port->input) {
+        if (port->loopSrc) {
+            loopBlock(port, portAudio(port, idx));
+        } else {
+            synthBlock(portAudio(port, idx), port->block);
+        }
+    } else {
+        audio = portAudio(port, idx ^ 1);
+        outputWrite(&port->out, audio->data,
+            audio->numChannels * audio->numFrames * audio->wordSize);
+        if (port->loop) {
+            loopSave(port, audio);
+        }
+    }
+
+    start = sim_host_ns();
+    port->cb(port->buffers[idx], *port->len, context);
+    sim_stat_add(&port->isr, sim_host_ns() - start);
+
+    port->block++;
+}
+
+/*
+ * One high speed microframe.  The host sends the next OUT packet into
+ * the buffer the device last asked for through 'nextData' and then
+ * collects an IN packet.
+ */
+static void usbIsr(APP_CONTEXT *context)
+{
+    unsigned frames = simRate / 8000;
+    unsigned wordSize = usbBits2bytes(context->cfg.usbWordSizeBits);
+    unsigned outFrameSize = context->cfg.usbOutChannels * wordSize;
+    unsigned inFrameSize = context->cfg.usbInChannels * wordSize;
+    SYSTEM_AUDIO_TYPE buf[SYSTEM_MAX_CHANNELS * (192000 / 8000)];
+    size_t samples, rsize;
+    void *next;
+    uint16_t size;
+    uint64_t start;
+
+    if (usb.playEnabled) {
+        /* The file loops, keep reading across the wrap */
+        samples = 0; rsize = 0;
+        while ((samples < frames * usb.play.channels) && (rsize != (size_t)-1)) {
+            rsize = readWave(&usb.play,
+                (uint8_t *)buf + samples * usb.play.wordSizeBytes,
+                frames * usb.play.channels - samples);
+            if (rsize != (size_t)-1) {
+                samples += rsize;
+            }
+        }
+        if (samples == frames * usb.play.channels) {
+            copyAndConvert(buf, usb.play.wordSizeBytes, usb.play.channels,
+                usb.rxData, wordSize, context->cfg.usbOutChannels,
+                frames, true);
+            start = sim_host_ns();
+            next = usb.rxData;
+            uac2Rx(usb.rxData, &next, frames * outFrameSize, context);
+            sim_stat_add(&usb.rxIsr, sim_host_ns() - start);
+            usb.rxData = next;
+        }
+    }
+
+    if (usb.recordEnabled) {
+        start = sim_host_ns();
+        next = usb.txData;
+        size = uac2Tx(usb.txData, &next,
+            (frames - 1) * inFrameSize, (frames + 1) * inFrameSize, context);
+        sim_stat_add(&usb.txIsr, sim_host_ns() - start);
+        usb.txData = next;
+        if (size) {
+            outputWrite(&usb.out, usb.txData, size);
+            writeWave(&usb.record, usb.txData, size / usb.record.wordSizeBytes);
+        }
+    }
+
+    usb.uframe++;
+}
+
+/***********************************************************************
+ * System setup, mirrors sae_buffer_init() / uac2_init() on the target
+ **********************************************************************/
+static SAE_MSG_BUFFER *allocateIpcAudioMsg(APP_CONTEXT *context,
+    uint16_t size, uint8_t streamID, uint8_t numChannels, void **audioPtr)
+{
+    SAE_MSG_BUFFER *msgBuffer;
+    IPC_MSG *msg;
+
+    msgBuffer = sae_createMsgBuffer(context->saeContext, sizeof(*msg) + size,
+        SAE_ALLOC_FAST, (void **)&msg);
+    if (msgBuffer == NULL) {
+        return(NULL);
+    }
+
+    msg->type = IPC_TYPE_AUDIO;
+    msg->audio.streamID = streamID;
+    msg->audio.numChannels = numChannels;
+    msg->audio.wordSize = sizeof(SYSTEM_AUDIO_TYPE);
+    msg->audio.numFrames = size / (numChannels * sizeof(SYSTEM_AUDIO_TYPE));
+    *audioPtr = msg->audio.data;
+
+    return(msgBuffer);
+}
+
+static void simBufferInit(APP_CONTEXT *context, const SIM_RATE_PLAN *plan)
+{
+    IPC_MSG *msg;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        context->codecAudioInLen =
+            ADC_DMA_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+        context->codecMsgIn[i] = allocateIpcAudioMsg(context,
+            context->codecAudioInLen, IPC_STREAMID_CODEC_IN,
+            ADC_DMA_CHANNELS, &context->codecAudioIn[i]);
+        context->codecAudioOutLen =
+            DAC_DMA_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+        context->codecMsgOut[i] = allocateIpcAudioMsg(context,
+            context->codecAudioOutLen, IPC_STREAMID_CODEC_OUT,
+            DAC_DMA_CHANNELS, &context->codecAudioOut[i]);
+        context->spdifAudioInLen =
+            SPDIF_DMA_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+        context->spdifMsgIn[i] = allocateIpcAudioMsg(context,
+            context->spdifAudioInLen, IPC_STREAMID_SPDIF_IN,
+            SPDIF_DMA_CHANNELS, &context->spdifAudioIn[i]);
+        context->spdifAudioOutLen =
+            SPDIF_DMA_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+        context->spdifMsgOut[i] = allocateIpcAudioMsg(context,
+            context->spdifAudioOutLen, IPC_STREAMID_SPDIF_OUT,
+            SPDIF_DMA_CHANNELS, &context->spdifAudioOut[i]);
+        context->a2bAudioInLen =
+            A2B_DMA_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+        context->a2bMsgIn[i] = allocateIpcAudioMsg(context,
+            context->a2bAudioInLen, IPC_STREAMID_A2B_IN,
+            A2B_DMA_CHANNELS, &context->a2bAudioIn[i]);
+        context->a2bAudioOutLen =
+            A2B_DMA_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+        context->a2bMsgOut[i] = allocateIpcAudioMsg(context,
+            context->a2bAudioOutLen, IPC_STREAMID_A2B_OUT,
+            A2B_DMA_CHANNELS, &context->a2bAudioOut[i]);
+        context->micAudioInLen =
+            MIC_DMA_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+        context->micMsgIn[i] = allocateIpcAudioMsg(context,
+            context->micAudioInLen, IPC_STREAMID_MIC_IN,
+            MIC_DMA_CHANNELS, &context->micAudioIn[i]);
+
+        /* Codec TDM slots follow the sample rate plan */
+        msg = sae_getMsgBufferPayload(context->codecMsgOut[i]);
+        msg->audio.numChannels = plan->dacSlots;
+        msg = sae_getMsgBufferPayload(context->codecMsgIn[i]);
+        msg->audio.numChannels = plan->adcSlots;
+    }
+
+    context->usbAudioRxLen = context->cfg.usbOutChannels *
+        sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+    context->usbMsgRx[0] = allocateIpcAudioMsg(context,
+        context->usbAudioRxLen, IPC_STREAMID_USB_RX,
+        context->cfg.usbOutChannels, &context->usbAudioRx[0]);
+    context->usbAudioTxLen = context->cfg.usbInChannels *
+        sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+    context->usbMsgTx[0] = allocateIpcAudioMsg(context,
+        context->usbAudioTxLen, IPC_STREAMID_USB_TX,
+        context->cfg.usbInChannels, &context->usbAudioTx[0]);
+    context->wavAudioSrcLen =
+        SYSTEM_MAX_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+    context->wavMsgSrc[0] = allocateIpcAudioMsg(context,
+        context->wavAudioSrcLen, IPC_STREAM_ID_WAVE_SRC,
+        SYSTEM_MAX_CHANNELS, &context->wavAudioSrc[0]);
+    context->wavAudioSinkLen =
+        SYSTEM_MAX_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+    context->wavMsgSink[0] = allocateIpcAudioMsg(context,
+        context->wavAudioSinkLen, IPC_STREAM_ID_WAVE_SINK,
+        SYSTEM_MAX_CHANNELS, &context->wavAudioSink[0]);
+
+    ports[SIM_PORT_DAC].buffers = context->codecAudioOut;
+    ports[SIM_PORT_DAC].len = &context->codecAudioOutLen;
+    ports[SIM_PORT_DAC].msgs = context->codecMsgOut;
+    ports[SIM_PORT_ADC].buffers = context->codecAudioIn;
+    ports[SIM_PORT_ADC].len = &context->codecAudioInLen;
+    ports[SIM_PORT_ADC].msgs = context->codecMsgIn;
+    ports[SIM_PORT_SPDIF_OUT].buffers = context->spdifAudioOut;
+    ports[SIM_PORT_SPDIF_OUT].len = &context->spdifAudioOutLen;
+    ports[SIM_PORT_SPDIF_OUT].msgs = context->spdifMsgOut;
+    ports[SIM_PORT_SPDIF_IN].buffers = context->spdifAudioIn;
+    ports[SIM_PORT_SPDIF_IN].len = &context->spdifAudioInLen;
+    ports[SIM_PORT_SPDIF_IN].msgs = context->spdifMsgIn;
+    ports[SIM_PORT_A2B_OUT].buffers = context->a2bAudioOut;
+    ports[SIM_PORT_A2B_OUT].len = &context->a2bAudioOutLen;
+    ports[SIM_PORT_A2B_OUT].msgs = context->a2bMsgOut;
+    ports[SIM_PORT_A2B_IN].buffers = context->a2bAudioIn;
+    ports[SIM_PORT_A2B_IN].len = &context->a2bAudioInLen;
+    ports[SIM_PORT_A2B_IN].msgs = context->a2bMsgIn;
+    ports[SIM_PORT_MIC].buffers = context->micAudioIn;
+    ports[SIM_PORT_MIC].len = &context->micAudioInLen;
+    ports[SIM_PORT_MIC].msgs = context->micMsgIn;
+}
+
+/* Largest channel count whose +1 frame microframe packet fits */
+static int usbFitChannels(int channels, unsigned wordSize)
+{
+    unsigned frames = simRate / 8000 + 1;
+    while ((channels > 1) && (frames * channels * wordSize > SIM_USB_MAX_PKT)) {
+        channels--;
+    }
+    return(channels);
+}
+
+static PaUtilRingBuffer *usbRing(unsigned channels, void **data)
+{
+    PaUtilRingBuffer *rb;
+    uint32_t dataSize;
+
+    rb = umm_malloc(sizeof(*rb));
+    dataSize = roundUpPow2(USB_OUT_RING_BUFF_FRAMES * channels);
+    *data = umm_calloc(dataSize, sizeof(SYSTEM_AUDIO_TYPE));
+    PaUtil_InitializeRingBuffer(rb, sizeof(SYSTEM_AUDIO_TYPE), dataSize, *data);
+
+    return(rb);
+}
+
+static void simUsbInit(APP_CONTEXT *context)
+{
+    context->uac2OutRx = usbRing(context->cfg.usbOutChannels,
+        &context->uac2OutRxData);
+    context->uac2InTx = usbRing(context->cfg.usbInChannels,
+        &context->uac2InTxData);
+    bufferTrackInit(cpuLoadGetTimeStamp);
+
+    usb.rxData = usb.rxPkt;
+    usb.txData = usb.txPkt;
+    if (usb.playEnabled) {
+        uac2EndpointEnabled(UAC2_DIR_OUT, true, context);
+    }
+    if (usb.recordEnabled) {
+        uac2EndpointEnabled(UAC2_DIR_IN, true, context);
+    }
+}
+
+static int str2stream(const char *stream, bool src)
+{
+    if (strcmp(stream, "usb") == 0) {
+        return(src ? IPC_STREAMID_USB_RX : IPC_STREAMID_USB_TX);
+    } else if (strcmp(stream, "codec") == 0) {
+        return(src ? IPC_STREAMID_CODEC_IN : IPC_STREAMID_CODEC_OUT);
+    } else if (strcmp(stream, "mic") == 0) {
+        return(src ? IPC_STREAMID_MIC_IN : IPC_STREAM_ID_MAX);
+    } else if (strcmp(stream, "spdif") == 0) {
+        return(src ? IPC_STREAMID_SPDIF_IN : IPC_STREAMID_SPDIF_OUT);
+    } else if (strcmp(stream, "a2b") == 0) {
+        return(src ? IPC_STREAMID_A2B_IN : IPC_STREAMID_A2B_OUT);
+    } else if (strcmp(stream, "wav") == 0) {
+        return(src ? IPC_STREAM_ID_WAVE_SRC : IPC_STREAM_ID_WAVE_SINK);
+    }
+    return(IPC_STREAM_ID_MAX);
+}
+
+/* "src:offset:sink:offset:channels[:attenuation]", same as 'route' */
+static bool parseRoute(const char *spec, ROUTE_INFO *route)
+{
+    char src[16], sink[16];
+    unsigned srcOffset, sinkOffset, channels, attenuation;
+    int srcID, sinkID;
+    int n;
+
+    attenuation = 0;
+    n = sscanf(spec, "%15[^:]:%u:%15[^:]:%u:%u:%u", src, &srcOffset,
+        sink, &sinkOffset, &channels, &attenuation);
+    if (n < 5) {
+        return(false);
+    }
+    srcID = str2stream(src, true);
+    sinkID = str2stream(sink, false);
+    if ((srcID == IPC_STREAM_ID_MAX) || (sinkID == IPC_STREAM_ID_MAX)) {
+        return(false);
+    }
+
+    route->srcID = srcID;
+    route->srcOffset = srcOffset;
+    route->sinkID = sinkID;
+    route->sinkOffset = sinkOffset;
+    route->channels = channels;
+    route->attenuation = (attenuation > 120) ? 120 : attenuation;
+
+    return(true);
+}
+
+/* Exercises every stream type when no routes are given */
+static const char * const SIM_DEFAULT_ROUTES[] = {
+    "codec:0:usb:0:8",
+    "usb:0:codec:0:8",
+    "spdif:0:a2b:0:2",
+    "a2b:0:spdif:0:2",
+    "mic:0:usb:8:8",
+    "wav:0:a2b:2:2:6",
+    "codec:0:wav:0:2",
+    "a2b:4:codec:8:8:12",
+};
+
+static void simRoutingInit(APP_CONTEXT *context, const char **routes,
+    unsigned numRoutes)
+{
+    IPC_MSG_ROUTING *table;
+    unsigned i;
+
+    table = route_control_begin(context, true);
+    if (table == NULL) {
+        return;
+    }
+
+    if (routes == NULL) {
+        routes = (const char **)SIM_DEFAULT_ROUTES;
+        numRoutes = sizeof(SIM_DEFAULT_ROUTES) / sizeof(SIM_DEFAULT_ROUTES[0]);
+    }
+    for (i = 0; (i < numRoutes) && (i < MAX_AUDIO_ROUTES); i++) {
+        if (!parseRoute(routes[i], &table->routes[i])) {
+            fprintf(stderr, "sim: bad route '%s'\n", routes[i]);
+        }
+    }
+
+    route_control_publish(context);
+}
+
+/*
+ * Republishes an unchanged copy of the routing table every
+ * 'simRepublish' DAC blocks to exercise table switching
+ */
+static unsigned simRepublish;
+static unsigned simRepublished;
+
+static void simRepublishService(APP_CONTEXT *context)
+{
+    uint64_t block = ports[SIM_PORT_DAC].block;
+
+    if ((simRepublish == 0) || (block / simRepublish) <= simRepublished) {
+        return;
+    }
+    simRepublished = block / simRepublish;
+    if (route_control_begin(context, false)) {
+        route_control_publish(context);
+    }
+}
+
+/*
+ * Scenes: '--scene-save' writes the initial routes and matrix to a
+ * scene file, each '--scene-recall' switches to a scene file at a DAC
+ * block
+ */
+#define SIM_SCENE_RECALLS  (4)
+
+typedef struct _SIM_SCENE_RECALL {
+    char fname[256];
+    uint64_t block;
+    int fadeBlocks;
+    bool pending;
+    bool failed;
+} SIM_SCENE_RECALL;
+
+typedef struct _SIM_SCENE {
+    const char *save;
+    SIM_SCENE_RECALL recalls[SIM_SCENE_RECALLS];
+    unsigned numRecalls;
+} SIM_SCENE;
+
+static SIM_SCENE simScene;
+
+static bool setSceneRecall(const char *arg)
+{
+    SIM_SCENE_RECALL *sr;
+    unsigned long long block;
+    int n;
+
+    if (simScene.numRecalls >= SIM_SCENE_RECALLS) {
+        return(false);
+    }
+    sr = &simScene.recalls[simScene.numRecalls];
+    sr->fadeBlocks = -1;
+    n = sscanf(arg, "%255[^:]:%llu:%d", sr->fname, &block, &sr->fadeBlocks);
+    if (n < 2) {
+        return(false);
+    }
+    sr->block = block;
+    sr->pending = true;
+    simScene.numRecalls++;
+    return(true);
+}
+
+static void simSceneService(APP_CONTEXT *context)
+{
+    SIM_SCENE_RECALL *sr;
+    unsigned i;
+
+    for (i = 0; i < simScene.numRecalls; i++) {
+        sr = &simScene.recalls[i];
+        if (sr->pending && (ports[SIM_PORT_DAC].block >= sr->block)) {
+            sr->pending = false;
+            sr->failed = !scene_control_recall(context, sr->fname,
+                sr->fadeBlocks);
+        }
+    }
+}
+
+static bool simWavOpen(WAV_FILE *wf, char *fname, bool isSrc,
+    unsigned channels, unsigned wordSizeBytes)
+{
+    wf->fname = fname;
+    wf->isSrc = isSrc;
+    if (!isSrc) {
+        wf->channels = channels;
+        wf->sampleRate = simRate;
+        wf->wordSizeBytes = wordSizeBytes;
+        wf->frameSizeBytes = SYSTEM_BLOCK_SIZE * wordSizeBytes;
+    }
+    if (!openWave(wf)) {
+        fprintf(stderr, "sim: cannot open %s\n", fname);
+        return(false);
+    }
+    if (isSrc && (wf->channels > SYSTEM_MAX_CHANNELS)) {
+        fprintf(stderr, "sim: %s has too many channels\n", fname);
+        closeWave(wf);
+        return(false);
+    }
+    return(true);
+}
+
+/***********************************************************************
+ * Golden vectors
+ **********************************************************************/
+static SIM_OUTPUT *simOutputs[SIM_PORT_MAX + 2];
+static unsigned numSimOutputs;
+
+static void goldenWrite(const char *fname, int argc, char **argv)
+{
+    FILE *f;
+    unsigned i;
+    int a;
+
+    f = fopen(fname, "w");
+    if (f == NULL) {
+        fprintf(stderr, "sim: cannot create %s\n", fname);
+        return;
+    }
+    fprintf(f, "# sim");
+    for (a = 1; a < argc; a++) {
+        fprintf(f, " %s", argv[a]);
+    }
+    fprintf(f, "\n");
+    for (i = 0; i < numSimOutputs; i++) {
+        fprintf(f, "%s %llu %016llx\n", simOutputs[i]->name,
+            (unsigned long long)simOutputs[i]->bytes,
+            (unsigned long long)simOutputs[i]->hash);
+    }
+    fclose(f);
+}
+
+static bool goldenCheck(const char *fname)
+{
+    char line[256];
+    char name[64];
+    unsigned long long bytes, hash;
+    SIM_OUTPUT *out;
+    bool ok = true;
+    unsigned i;
+    FILE *f;
+
+    f = fopen(fname, "r");
+    if (f == NULL) {
+        fprintf(stderr, "sim: cannot open %s\n", fname);
+        return(false);
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if ((line[0] == '#') ||
+            (sscanf(line, "%63s %llu %llx", name, &bytes, &hash) != 3)) {
+            continue;
+        }
+        out = NULL;
+        for (i = 0; i < numSimOutputs; i++) {
+            if (strcmp(simOutputs[i]->name, name) == 0) {
+                out = simOutputs[i];
+            }
+        }
+        if (out == NULL) {
+            printf("golden,%s,missing\n", name);
+            ok = false;
+        } else if ((out->bytes != bytes) || (out->hash != hash)) {
+            printf("golden,%s,mismatch\n", name);
+            ok = false;
+        } else {
+            printf("golden,%s,ok\n", name);
+        }
+    }
+    fclose(f);
+
+    return(ok);
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+static void usage(void)
+{
+    printf(
+        "usage: sim-audio [options]\n"
+        "  -r, --rate <hz>          Sample rate 48000/96000/192000 (48000)\n"
+        "  -n, --blocks <n>         DAC blocks to run (%u)\n"
+        "  -j, --jitter <ns>        +/- interrupt jitter (0)\n"
+        "  -p, --ppm <port>=<ppm>   Clock offset of a port or 'usb'\n"
+        "  -s, --seed <n>           Jitter seed (1)\n"
+        "  -t, --realtime           Pace interrupts to the host clock\n"
+        "  -a, --a2b-slave          A2B in its own clock domain\n"
+        "  -S, --spdif-domain       SPDIF in its own clock domain\n"
+        "      --stall <port>=<block>:<n>  Drop n interrupts of a port\n"
+        "  -R, --route <spec>       src:off:sink:off:ch[:atten], repeatable\n"
+        "      --usb-play <wav>     Host playback into the USB OUT endpoint\n"
+        "      --usb-record <wav>   Host capture from the USB IN endpoint\n"
+        "      --usb-bits <n>       USB word size 16/24/32 (32)\n"
+        "      --wav-src <wav>      WAV file source\n"
+        "      --wav-sink <wav>     WAV file sink\n"
+        "      --loopback <out>=<in>  Wire an output port into an input port\n"
+        "      --latency <spec>     inject:ch:detect:ch[:mls] latency probe\n"
+        "      --latency-trials <n> Latency probe trials (10)\n"
+        "      --mixer <file>       Load a crosspoint mixer matrix file\n"
+        "      --no-mdma            Route everything on the core\n"
+        "      --republish <n>      Republish the routing table every n blocks\n"
+        "      --scene-save <file>  Save the initial routes and matrix as a scene\n"
+        "      --scene-recall <file>:<block>[:<blocks>]  Recall a scene at a block,\n"
+        "                           repeatable\n"
+        "      --meter <id>         Meter only this stream ID, repeatable (all)\n"
+        "  -o, --out <dir>          Dump raw outputs to <dir>\n"
+        "  -g, --golden <file>      Check outputs against golden vectors\n"
+        "  -G, --golden-write <f>   Write golden vectors\n",
+        SIM_DEFAULT_BLOCKS
+    );
+}
+
+enum {
+    OPT_USB_PLAY = 256,
+    OPT_USB_RECORD,
+    OPT_USB_BITS,
+    OPT_WAV_SRC,
+    OPT_WAV_SINK,
+    OPT_STALL,
+    OPT_LOOPBACK,
+    OPT_LATENCY,
+    OPT_LATENCY_TRIALS,
+    OPT_MIXER,
+    OPT_NO_MDMA,
+    OPT_REPUBLISH,
+    OPT_SCENE_SAVE,
+    OPT_SCENE_RECALL,
+    OPT_METER,
+};
+
+static const struct option longOptions[] = {
+    { "rate",         required_argument, NULL, 'r' },
+    { "blocks",       required_argument, NULL, 'n' },
+    { "jitter",       required_argument, NULL, 'j' },
+    { "ppm",          required_argument, NULL, 'p' },
+    { "seed",         required_argument, NULL, 's' },
+    { "realtime",     no_argument,       NULL, 't' },
+    { "a2b-slave",    no_argument,       NULL, 'a' },
+    { "spdif-domain", no_argument,       NULL, 'S' },
+    { "stall",        required_argument, NULL, OPT_STALL },
+    { "route",        required_argument, NULL, 'R' },
+    { "usb-play",     required_argument, NULL, OPT_USB_PLAY },
+    { "usb-record",   required_argument, NULL, OPT_USB_RECORD },
+    { "usb-bits",     required_argument, NULL, OPT_USB_BITS },
+    { "wav-src",      required_argument, NULL, OPT_WAV_SRC },
+    { "wav-sink",     required_argument, NULL, OPT_WAV_SINK },
+    { "loopback",     required_argument, NULL, OPT_LOOPBACK },
+    { "latency",      required_argument, NULL, OPT_LATENCY },
+    { "latency-trials", required_argument, NULL, OPT_LATENCY_TRIALS },
+    { "mixer",        required_argument, NULL, OPT_MIXER },
+    { "no-mdma",      no_argument,       NULL, OPT_NO_MDMA },
+    { "republish",    required_argument, NULL, OPT_REPUBLISH },
+    { "scene-save",   required_argument, NULL, OPT_SCENE_SAVE },
+    { "scene-recall", required_argument, NULL, OPT_SCENE_RECALL },
+    { "meter",        required_argument, NULL, OPT_METER },
+    { "out",          required_argument, NULL, 'o' },
+    { "golden",       required_argument, NULL, 'g' },
+    { "golden-write", required_argument, NULL, 'G' },
+    { "help",         no_argument,       NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+};
+
+static bool setPpm(const char *arg)
+{
+    char name[16];
+    int ppm;
+    unsigned i;
+
+    if (sscanf(arg, "%15[^=]=%d", name, &ppm) != 2) {
+        return(false);
+    }
+    if (strcmp(name, "usb") == 0) {
+        usb.ppm = ppm;
+        return(true);
+    }
+    for (i = 0; i < SIM_PORT_MAX; i++) {
+        if (strcmp(name, ports[i].name) == 0) {
+            ports[i].ppm = ppm;
+            return(true);
+        }
+    }
+    return(false);
+}
+
+static bool setStall(const char *arg)
+{
+    char name[16];
+    unsigned long long at, n;
+    unsigned i;
+
+    if (sscanf(arg, "%15[^=]=%llu:%llu", name, &at, &n) != 3) {
+        return(false);
+    }
+    for (i = 0; i < SIM_PORT_MAX; i++) {
+        if (strcmp(name, ports[i].name) == 0) {
+            ports[i].stallAt = at;
+            ports[i].stallBlocks = n;
+            return(true);
+        }
+    }
+    return(false);
+}
+
+static SIM_PORT *findPort(const char *name)
+{
+    unsigned i;
+
+    for (i = 0; i < SIM_PORT_MAX; i++) {
+        if (strcmp(name, ports[i].name) == 0) {
+            return(&ports[i]);
+        }
+    }
+    return(NULL);
+}
+
+static bool setLoopback(const char *arg)
+{
+    char out[16], in[16];
+    SIM_PORT *src, *dst;
+
+    if (sscanf(arg, "%15[^=]=%15s", out, in) != 2) {
+        return(false);
+    }
+    src = findPort(out);
+    dst = findPort(in);
+    if ((src == NULL) || (dst == NULL) || src->input || !dst->input) {
+        return(false);
+    }
+    dst->loopSrc = src;
+    return(true);
+}
+
+static void loopbackInit(void)
+{
+    IPC_MSG_AUDIO *audio;
+    SIM_LOOP *loop;
+    SIM_PORT *src;
+    unsigned i, j;
+
+    for (i = 0; i < SIM_PORT_MAX; i++) {
+        src = ports[i].loopSrc;
+        if ((src == NULL) || src->loop) {
+            continue;
+        }
+        audio = portAudio(src, 0);
+        loop = calloc(1, sizeof(*loop));
+        loop->channels = audio->numChannels;
+        loop->frames = audio->numFrames;
+        for (j = 0; j < 2; j++) {
+            loop->data[j] = calloc(loop->channels * loop->frames,
+                sizeof(int32_t));
+        }
+        src->loop = loop;
+    }
+}
+
+/* Probe endpoints go by port name, the rest by stream */
+static int str2probe(const char *name)
+{
+    static const struct {
+        const char *name;
+        int streamID;
+    } probeStreams[] = {
+        { "dac",       IPC_STREAMID_CODEC_OUT },
+        { "adc",       IPC_STREAMID_CODEC_IN },
+        { "spdif_out", IPC_STREAMID_SPDIF_OUT },
+        { "spdif_in",  IPC_STREAMID_SPDIF_IN },
+        { "a2b_out",   IPC_STREAMID_A2B_OUT },
+        { "a2b_in",    IPC_STREAMID_A2B_IN },
+        { "mic",       IPC_STREAMID_MIC_IN },
+        { "usb_rx",    IPC_STREAMID_USB_RX },
+        { "usb_tx",    IPC_STREAMID_USB_TX },
+        { "wav_src",   IPC_STREAM_ID_WAVE_SRC },
+        { "wav_sink",  IPC_STREAM_ID_WAVE_SINK },
+    };
+    unsigned i;
+
+    for (i = 0; i < sizeof(probeStreams) / sizeof(probeStreams[0]); i++) {
+        if (strcmp(name, probeStreams[i].name) == 0) {
+            return(probeStreams[i].streamID);
+        }
+    }
+    return(IPC_STREAM_ID_MAX);
+}
+
+static bool setLatency(const char *arg)
+{
+    char src[16], sink[16], signal[8];
+    unsigned srcChannel, sinkChannel;
+    int srcID, sinkID;
+    int n;
+
+    signal[0] = '\0';
+    n = sscanf(arg, "%15[^:]:%u:%15[^:]:%u:%7s", src, &srcChannel,
+        sink, &sinkChannel, signal);
+    if (n < 4) {
+        return(false);
+    }
+    srcID = str2probe(src);
+    sinkID = str2probe(sink);
+    if ((srcID == IPC_STREAM_ID_MAX) || (sinkID == IPC_STREAM_ID_MAX)) {
+        return(false);
+    }
+
+    simLatency.enabled = true;
+    simLatency.spec = arg;
+    simLatency.srcID = srcID;
+    simLatency.srcChannel = srcChannel;
+    simLatency.sinkID = sinkID;
+    simLatency.sinkChannel = sinkChannel;
+    if (strcmp(signal, "mls") == 0) {
+        simLatency.signal = LATENCY_SIGNAL_MLS;
+        simLatency.level = 214748365;       /* -20 dBFS */
+    } else if (signal[0] == '\0') {
+        simLatency.signal = LATENCY_SIGNAL_IMPULSE;
+        simLatency.level = 1073741824;      /* -6 dBFS */
+    } else {
+        return(false);
+    }
+    return(true);
+}
+
+/*
+ * Runs the probe trials between interrupts like the 'latency' shell
+ * command does between task delays.  Trials are spaced irregularly so
+ * they land at different phases of the other clocks.
+ */
+#define SIM_LATENCY_CAPTURE  (4096)
+
+static void latencyService(void)
+{
+    SIM_LATENCY *sl = &simLatency;
+    LATENCY_PROBE *lp = sim_sharc0_latency();
+    LATENCY_RESULT result;
+    uint64_t timeout;
+
+    if (!sl->enabled || sl->failed) {
+        return;
+    }
+
+    switch (lp->state) {
+        case LATENCY_STATE_IDLE:
+            if ((sl->started < sl->trials) && (simNow >= sl->nextTime)) {
+                latency_arm(lp, sl->srcID, sl->srcChannel,
+                    sl->sinkID, sl->sinkChannel, sl->signal, sl->level,
+                    SIM_LATENCY_CAPTURE);
+                sl->armTime = simNow;
+                sl->started++;
+            }
+            break;
+        case LATENCY_STATE_ARMED:
+        case LATENCY_STATE_RUNNING:
+            timeout = 500000000ULL +
+                (1000000000ULL * SIM_LATENCY_CAPTURE) / simRate;
+            if (simNow - sl->armTime > timeout) {
+                latency_abort(lp);
+                sl->stats.missed++;
+                sl->nextTime = simNow;
+            }
+            break;
+        case LATENCY_STATE_DONE:
+            latency_analyze(lp, &result);
+            latency_stats_add(&sl->stats, &result);
+            sl->nextTime = simNow + 20000000ULL +
+                (sl->started * 7 % 11) * 1000000ULL;
+            break;
+        default:
+            sl->failed = true;
+            break;
+    }
+}
+
+static void latencyReport(FILE *f)
+{
+    SIM_LATENCY *sl = &simLatency;
+    float mean, jitter;
+
+    if (!sl->enabled) {
+        return;
+    }
+    if (sl->failed) {
+        fprintf(f, "latency,%s,error\n", sl->spec);
+        return;
+    }
+    latency_stats_get(&sl->stats, &mean, &jitter);
+    fprintf(f, "latency,%s,found,%u,missed,%u", sl->spec,
+        sl->stats.found, sl->stats.missed);
+    if (sl->stats.found) {
+        fprintf(f, ",min,%.1f,mean,%.1f,max,%.1f,jitter,%.2f,mean_us,%.1f",
+            sl->stats.min, mean, sl->stats.max, jitter,
+            mean * 1e6 / simRate);
+    }
+    fprintf(f, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    APP_CONTEXT *context = &mainAppContext;
+    const SIM_RATE_PLAN *plan = NULL;
+    const char *routes[MAX_AUDIO_ROUTES];
+    unsigned numRoutes = 0;
+    uint64_t blocks = SIM_DEFAULT_BLOCKS;
+    char *usbPlay = NULL, *usbRecord = NULL;
+    char *wavSrc = NULL, *wavSink = NULL;
+    const char *outDir = NULL;
+    const char *golden = NULL, *goldenOut = NULL;
+    const char *mixer = NULL;
+    unsigned mixerLine;
+    unsigned usbBits = USB_DEFAULT_WORD_SIZE_BITS;
+    bool a2bSlave = false;
+    bool spdifDomain = false;
+    uint32_t meterStreams = 0;
+    uint64_t hostStart, wall, elapsed;
+    SIM_PORT *port, *next;
+    SIM_SCENE_RECALL *sr;
+    bool usbNext;
+    bool ok = true;
+    unsigned i;
+    int c;
+
+    while ((c = getopt_long(argc, argv, "r:n:j:p:s:taSR:o:g:G:h",
+            longOptions, NULL)) != -1) {
+        switch (c) {
+            case 'r': simRate = strtoul(optarg, NULL, 0); break;
+            case 'n': blocks = strtoull(optarg, NULL, 0); break;
+            case 'j': simJitterNs = strtoul(optarg, NULL, 0); break;
+            case 'p':
+                if (!setPpm(optarg)) {
+                    fprintf(stderr, "sim: bad ppm '%s'\n", optarg);
+                    return(1);
+                }
+                break;
+            case 's': simSeed = strtoull(optarg, NULL, 0); break;
+            case 't': simRealtime = true; break;
+            case 'a': a2bSlave = true; break;
+            case 'S': spdifDomain = true; break;
+            case OPT_STALL:
+                if (!setStall(optarg)) {
+                    fprintf(stderr, "sim: bad stall '%s'\n", optarg);
+                    return(1);
+                }
+                break;
+            case 'R':
+                if (numRoutes < MAX_AUDIO_ROUTES) {
+                    routes[numRoutes++] = optarg;
+                }
+                break;
+            case OPT_USB_PLAY: usbPlay = optarg; break;
+            case OPT_USB_RECORD: usbRecord = optarg; break;
+            case OPT_USB_BITS: usbBits = strtoul(optarg, NULL, 0); break;
+            case OPT_WAV_SRC: wavSrc = optarg; break;
+            case OPT_WAV_SINK: wavSink = optarg; break;
+            case OPT_LOOPBACK:
+                if (!setLoopback(optarg)) {
+                    fprintf(stderr, "sim: bad loopback '%s'\n", optarg);
+                    return(1);
+                }
+                break;
+            case OPT_LATENCY:
+                if (!setLatency(optarg)) {
+                    fprintf(stderr, "sim: bad latency probe '%s'\n", optarg);
+                    return(1);
+                }
+                break;
+            case OPT_LATENCY_TRIALS:
+                simLatency.trials = strtoul(optarg, NULL, 0);
+                break;
+            case OPT_MIXER: mixer = optarg; break;
+            case OPT_NO_MDMA: sim_mdma_enable(false); break;
+            case OPT_REPUBLISH: simRepublish = strtoul(optarg, NULL, 0); break;
+            case OPT_SCENE_SAVE: simScene.save = optarg; break;
+            case OPT_SCENE_RECALL:
+                if (!setSceneRecall(optarg)) {
+                    fprintf(stderr, "sim: bad scene recall '%s'\n", optarg);
+                    return(1);
+                }
+                break;
+            case OPT_METER:
+                meterStreams |= METER_STREAM(strtoul(optarg, NULL, 0));
+                break;
+            case 'o': outDir = optarg; break;
+            case 'g': golden = optarg; break;
+            case 'G': goldenOut = optarg; break;
+            default:
+                usage();
+                return(c == 'h' ? 0 : 1);
+        }
+    }
+
+    for (i = 0; i < sizeof(SIM_RATE_PLANS) / sizeof(SIM_RATE_PLANS[0]); i++) {
+        if (SIM_RATE_PLANS[i].rate == simRate) {
+            plan = &SIM_RATE_PLANS[i];
+        }
+    }
+    if (plan == NULL) {
+        fprintf(stderr, "sim: unsupported rate %u\n", (unsigned)simRate);
+        return(1);
+    }
+    if (a2bSlave && !plan->a2b) {
+        fprintf(stderr, "sim: no A2B at %u Hz\n", (unsigned)simRate);
+        return(1);
+    }
+    /* Jitter must never reorder a port's own interrupts */
+    if (simJitterNs > (500000000ULL * SYSTEM_BLOCK_SIZE) / simRate) {
+        simJitterNs = (500000000ULL * SYSTEM_BLOCK_SIZE) / simRate;
+    }
+
+    /* Application context */
+    context->sampleRate = simRate;
+    context->cfg.usbWordSizeBits = usbBits;
+    context->cfg.usbOutChannels = usbFitChannels(
+        USB_DEFAULT_OUT_AUDIO_CHANNELS, usbBits2bytes(usbBits));
+    context->cfg.usbInChannels = usbFitChannels(
+        USB_DEFAULT_IN_AUDIO_CHANNELS, usbBits2bytes(usbBits));
+    context->a2bmode = a2bSlave ? A2B_BUS_MODE_SLAVE : A2B_BUS_MODE_MASTER;
+
+    /* SAE, SHARC0 and audio buffers */
+    sae_initialize(&context->saeContext, SAE_CORE_IDX_0, true);
+    if (!sim_sharc0_start()) {
+        fprintf(stderr, "sim: cannot start SHARC0\n");
+        return(1);
+    }
+    sim_sharc0_meter_config(simRate / SYSTEM_BLOCK_SIZE,
+        meterStreams ? meterStreams : METER_ALL_STREAMS);
+    simBufferInit(context, plan);
+    loopbackInit();
+    latency_stats_reset(&simLatency.stats);
+    simRoutingInit(context, numRoutes ? routes : NULL, numRoutes);
+    if (mixer) {
+        if (!mixer_control_load(context, mixer, &mixerLine) ||
+            !mixer_control_commit(context)) {
+            fprintf(stderr, "sim: bad mixer matrix '%s' line %u\n",
+                mixer, mixerLine);
+            return(1);
+        }
+    }
+    if (simScene.save &&
+        !scene_control_save(context, simScene.save, SCENE_FADE_BLOCKS)) {
+        fprintf(stderr, "sim: cannot write scene '%s'\n", simScene.save);
+        return(1);
+    }
+    for (i = 0; i < simScene.numRecalls; i++) {
+        if (!scene_control_load(context, simScene.recalls[i].fname)) {
+            fprintf(stderr, "sim: bad scene '%s'\n",
+                simScene.recalls[i].fname);
+            return(1);
+        }
+    }
+
+    /* Clock domains, following system_set_sample_rate() */
+    clock_domain_init(context);
+    if (!plan->spdif) {
+        clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_SPDIF_IN);
+        clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_SPDIF_OUT);
+    } else if (spdifDomain) {
+        clock_domain_set(context, CLOCK_DOMAIN_SPDIF, CLOCK_DOMAIN_BITM_SPDIF_IN);
+    }
+    if (!plan->a2b) {
+        clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_A2B_IN);
+        clock_domain_set(context, CLOCK_DOMAIN_MAX, CLOCK_DOMAIN_BITM_A2B_OUT);
+    } else if (a2bSlave) {
+        clock_domain_set(context, CLOCK_DOMAIN_A2B, CLOCK_DOMAIN_BITM_A2B_IN);
+        clock_domain_set(context, CLOCK_DOMAIN_A2B, CLOCK_DOMAIN_BITM_A2B_OUT);
+    }
+
+    /* SPORTs */
+    for (i = 0; i < SIM_PORT_MAX; i++) {
+        port = &ports[i];
+        port->enabled = true;
+        if (!plan->spdif &&
+            ((i == SIM_PORT_SPDIF_IN) || (i == SIM_PORT_SPDIF_OUT))) {
+            port->enabled = false;
+        }
+        if (!plan->a2b && ((i == SIM_PORT_A2B_IN) || (i == SIM_PORT_A2B_OUT))) {
+            port->enabled = false;
+        }
+        port->rng = simSeed * 0x9e3779b97f4a7c15ULL + i + 1;
+        port->isr.name = port->isrName;
+        port->out.name = port->name;
+        if (port->enabled) {
+            port->time = portTime(port);
+            if (!port->input) {
+                outputInit(&port->out, outDir);
+                simOutputs[numSimOutputs++] = &port->out;
+            }
+        }
+    }
+
+    /* USB host */
+    if (usbPlay) {
+        usb.playEnabled = simWavOpen(&usb.play, usbPlay, true, 0, 0);
+        ok = ok && usb.playEnabled;
+    }
+    if (usbRecord) {
+        usb.recordEnabled = simWavOpen(&usb.record, usbRecord, false,
+            context->cfg.usbInChannels, usbBits2bytes(usbBits));
+        ok = ok && usb.recordEnabled;
+        outputInit(&usb.out, outDir);
+        simOutputs[numSimOutputs++] = &usb.out;
+    }
+    simUsbInit(context);
+    usb.time = usbTime();
+
+    /* WAV files, serviced between interrupts in place of the wav tasks */
+    wav_audio_init(context);
+    if (wavSrc) {
+        ok = ok && simWavOpen(&context->wavSrc, wavSrc, true, 0, 0);
+        wavSrcService(context);
+    }
+    if (wavSink) {
+        ok = ok && simWavOpen(&context->wavSink, wavSink, false,
+            2, sizeof(int16_t));
+        simOutputs[numSimOutputs++] = &wavSinkOut;
+    }
+    if (!ok) {
+        return(1);
+    }
+
+    printf("sim,rate,%u,block,%u,blocks,%llu,jitter_ns,%u,mode,%s\n",
+        (unsigned)simRate, SYSTEM_BLOCK_SIZE, (unsigned long long)blocks,
+        (unsigned)simJitterNs, simRealtime ? "realtime" : "lockstep");
+
+    /* Discrete event loop, earliest interrupt first */
+    hostStart = sim_host_ns();
+    while (ports[SIM_PORT_DAC].block < blocks) {
+
+        next = NULL;
+        for (i = 0; i < SIM_PORT_MAX; i++) {
+            port = &ports[i];
+            if (port->enabled && ((next == NULL) || (port->time < next->time))) {
+                next = port;
+            }
+        }
+        usbNext = (usb.playEnabled || usb.recordEnabled) &&
+            (usb.time < next->time);
+        simNow = usbNext ? usb.time : next->time;
+
+        if (simRealtime) {
+            do {
+                wall = sim_host_ns() - hostStart;
+            } while (wall < simNow);
+        }
+
+        if (usbNext) {
+            usbIsr(context);
+            usb.time = usbTime();
+        } else {
+            portIsr(context, next);
+            next->time = portTime(next);
+        }
+
+        if (!simRealtime) {
+            sim_sae_wait_idle(IPC_CORE_SHARC0);
+        }
+
+        wavSrcService(context);
+        wavSinkService(context);
+        latencyService();
+        simRepublishService(context);
+        simSceneService(context);
+    }
+    elapsed = sim_host_ns() - hostStart;
+
+    sim_sharc0_stop();
+
+    /* Wrap up the files */
+    if (usb.playEnabled) {
+        closeWave(&usb.play);
+    }
+    if (usb.recordEnabled) {
+        closeWave(&usb.record);
+    }
+    if (wavSrc) {
+        closeWave(&context->wavSrc);
+    }
+    if (wavSink) {
+        FILE *f;
+        uint8_t buf[4096];
+        size_t n;
+        closeWave(&context->wavSink);
+        outputInit(&wavSinkOut, NULL);
+        f = fopen(wavSink, "rb");
+        while (f && ((n = fread(buf, 1, sizeof(buf), f)) > 0)) {
+            outputWrite(&wavSinkOut, buf, n);
+        }
+        if (f) {
+            fclose(f);
+        }
+    }
+
+    /* Report */
+    for (i = 0; i < numSimOutputs; i++) {
+        outputClose(simOutputs[i]);
+        printf("out,%s,%llu,%016llx\n", simOutputs[i]->name,
+            (unsigned long long)simOutputs[i]->bytes,
+            (unsigned long long)simOutputs[i]->hash);
+    }
+    printf("time,name,count,min_ns,mean_ns,p99_ns,max_ns\n");
+    for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
+        sim_stat_report(stdout, sim_sharc0_route_stat(i));
+        sim_stat_report(stdout, sim_sharc0_route_core_stat(i));
+    }
+    sim_stat_report(stdout, sim_sharc0_mdma_stat());
+    sim_stat_report(stdout, sim_sharc0_meter_stat());
+    for (i = 0; i < SIM_PORT_MAX; i++) {
+        sim_stat_report(stdout, &ports[i].isr);
+    }
+    sim_stat_report(stdout, &usb.rxIsr);
+    sim_stat_report(stdout, &usb.txIsr);
+    for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
+        printf("domain,%s,rate_hz,%u,blocks,%u,stalls,%u\n",
+            clock_domain_str(i), (unsigned)clock_domain_rate(context, i),
+            (unsigned)context->clockDomain[i].blocks,
+            (unsigned)context->clockDomain[i].stalls);
+    }
+    sim_sharc0_meter_report(stdout);
+    latencyReport(stdout);
+    printf("usb,rx_overrun,%u,rx_underrun,%u,tx_overrun,%u,tx_underrun,%u\n",
+        (unsigned)context->uac2stats.rx.usbRxOverRun,
+        (unsigned)context->uac2stats.rx.usbRxUnderRun,
+        (unsigned)context->uac2stats.tx.usbTxOverRun,
+        (unsigned)context->uac2stats.tx.usbTxUnderRun);
+    for (i = 0; i < simScene.numRecalls; i++) {
+        sr = &simScene.recalls[i];
+        printf("scene,%s,block,%llu,%s\n", sr->fname,
+            (unsigned long long)sr->block,
+            sr->pending ? "pending" : sr->failed ? "failed" : "recalled");
+    }
+    printf("routing,generation,%u,applied,%u\n",
+        (unsigned)context->routing->generation,
+        (unsigned)route_control_applied(context));
+    printf("sim,simulated_ms,%llu,host_ms,%llu\n",
+        (unsigned long long)(simNow / 1000000),
+        (unsigned long long)(elapsed / 1000000));
+
+    if (goldenOut) {
+        goldenWrite(goldenOut, argc, argv);
+    }
+    if (golden) {
+        ok = goldenCheck(golden);
+    }
+
+    return(ok ? 0 : 1);
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * MDMA stand-in for the router's bulk copy backend (route_copy.h).
+ * Copies are queued like descriptors and only carried out in
+ * route_copy_wait(), so a router that touches a sink before waiting
+ * shows up as a golden mismatch.  The host time spent copying belongs
+ * to the engine, not the core, and is handed out separately by
+ * sim_mdma_take_ns().
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "route_copy.h"
+
+#include "sim.h"
+
+#define SIM_MDMA_MAX_COPIES  (32)
+
+typedef struct _SIM_MDMA_COPY {
+    int32_t *out;
+    const int32_t *in;
+    unsigned outStride;
+    unsigned inStride;
+    unsigned channels;
+    unsigned frames;
+} SIM_MDMA_COPY;
+
+static SIM_MDMA_COPY copies[SIM_MDMA_MAX_COPIES];
+static unsigned numCopies;
+static bool running;
+static bool enabled = true;
+static uint64_t engineNs;
+
+bool route_copy_add(int32_t *out, unsigned outStride, const int32_t *in,
+    unsigned inStride, unsigned channels, unsigned frames)
+{
+    SIM_MDMA_COPY *copy;
+
+    if (!enabled || running || (numCopies >= SIM_MDMA_MAX_COPIES)) {
+        return(false);
+    }
+
+    copy = &copies[numCopies++];
+    copy->out = out;
+    copy->outStride = outStride;
+    copy->in = in;
+    copy->inStride = inStride;
+    copy->channels = channels;
+    copy->frames = frames;
+
+    return(true);
+}
+
+void route_copy_start(void)
+{
+    running = (numCopies > 0);
+}
+
+void route_copy_wait(void)
+{
+    SIM_MDMA_COPY *copy;
+    const int32_t *in;
+    int32_t *out;
+    uint64_t start;
+    unsigned i, frame;
+
+    if (running) {
+        start = sim_host_ns();
+        for (i = 0; i < numCopies; i++) {
+            copy = &copies[i];
+            in = copy->in;
+            out = copy->out;
+            for (frame = 0; frame < copy->frames; frame++) {
+                memcpy(out, in, copy->channels * sizeof(*out));
+                in += copy->inStride;
+                out += copy->outStride;
+            }
+        }
+        engineNs += sim_host_ns() - start;
+        running = false;
+    }
+
+    numCopies = 0;
+}
+
+void sim_mdma_enable(bool enable)
+{
+    enabled = enable;
+}
+
+uint64_t sim_mdma_take_ns(void)
+{
+    uint64_t ns = engineNs;
+
+    engineNs = 0;
+
+    return(ns);
+}
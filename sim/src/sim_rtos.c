@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host stand-ins for the FreeRTOS, heap and CPU load services used by
+ * the ARM audio path.  See FreeRTOS.h for the threading model.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "umm_malloc.h"
+#include "cpu_load.h"
+#include "clocks.h"
+
+#include "sim.h"
+
+/*
+ * Tasks are never started.  The scheduler calls the equivalent service
+ * functions directly so the handle only needs to be unique.
+ */
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName,
+    uint32_t usStackDepth, void *pvParameters, UBaseType_t uxPriority,
+    TaskHandle_t *pxCreatedTask)
+{
+    (void)pxTaskCode; (void)usStackDepth; (void)pvParameters; (void)uxPriority;
+    if (pxCreatedTask) {
+        *pxCreatedTask = (TaskHandle_t)pcName;
+    }
+    return(pdPASS);
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue,
+    eNotifyAction eAction, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify; (void)ulValue; (void)eAction;
+    if (pxHigherPriorityTaskWoken) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return(pdPASS);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    (void)xClearCountOnExit; (void)xTicksToWait;
+    return(0);
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    (void)xTicksToDelay;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static int mutex;
+    return(&mutex);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    (void)xSemaphore; (void)xBlockTime;
+    return(pdTRUE);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    (void)xSemaphore;
+    return(pdTRUE);
+}
+
+void *umm_malloc(size_t size)
+{
+    return(malloc(size));
+}
+
+void *umm_calloc(size_t num, size_t size)
+{
+    return(calloc(num, size));
+}
+
+void umm_free(void *ptr)
+{
+    free(ptr);
+}
+
+/*
+ * Timestamps follow simulation time at the CGU_TS_CLK rate so the
+ * buffer trackers and rate feedback see the simulated clocks.
+ */
+uint32_t cpuLoadGetTimeStamp(void)
+{
+    return((uint32_t)((sim_now_ns() * (uint64_t)(CGU_TS_CLK / 1000)) / 1000000));
+}
+
+void cpuLoadIsrSourceCycles(int *id, const char *name, uint32_t isrCycles)
+{
+    (void)id; (void)name; (void)isrCycles;
+}
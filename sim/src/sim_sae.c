@@ -0,0 +1,256 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host emulation of the SHARC Audio Engine message API.  Message
+ * buffers come from the host heap and each core has a FIFO of
+ * received messages that is drained by that core's simulation thread.
+ * Messages sent to a core with no registered context (SHARC1 in this
+ * simulation) are refused with SAE_RESULT_CORE_NOT_READY, which the
+ * senders already handle by dropping their reference.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "sae.h"
+#include "sim.h"
+
+#define SIM_SAE_MAX_CORES  (3)
+
+struct _SAE_MSG_BUFFER {
+    atomic_int ref;
+    size_t size;
+    SAE_MSG_BUFFER *next;
+    void *payload;
+};
+
+struct _SAE_CONTEXT {
+    SAE_CORE_IDX idx;
+    SAE_MSG_RECEIVED_CALLBACK msgRxCb;
+    void *msgRxUsrPtr;
+};
+
+typedef struct _SIM_SAE_QUEUE {
+    SAE_MSG_BUFFER *head;
+    SAE_MSG_BUFFER *tail;
+    bool busy;
+    SAE_CONTEXT *context;
+} SIM_SAE_QUEUE;
+
+static SIM_SAE_QUEUE queues[SIM_SAE_MAX_CORES];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rxCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idleCond = PTHREAD_COND_INITIALIZER;
+static bool shutdown;
+static atomic_uint liveBuffers;
+
+SAE_RESULT sae_initialize(SAE_CONTEXT **context, SAE_CORE_IDX saeIdx,
+    bool saeMaster)
+{
+    SAE_CONTEXT *c;
+
+    (void)saeMaster;
+
+    if ((saeIdx < 0) || (saeIdx >= SIM_SAE_MAX_CORES)) {
+        return(SAE_RESULT_ERROR);
+    }
+
+    c = calloc(1, sizeof(*c));
+    if (c == NULL) {
+        return(SAE_RESULT_NO_MEM);
+    }
+    c->idx = saeIdx;
+
+    pthread_mutex_lock(&lock);
+    queues[saeIdx].context = c;
+    pthread_mutex_unlock(&lock);
+
+    *context = c;
+
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_unInitialize(SAE_CONTEXT **contextPtr)
+{
+    SAE_CONTEXT *c = *contextPtr;
+
+    pthread_mutex_lock(&lock);
+    queues[c->idx].context = NULL;
+    pthread_mutex_unlock(&lock);
+
+    free(c);
+    *contextPtr = NULL;
+
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_addPool(SAE_CONTEXT *context, SAE_POOL pool,
+    void *memory, size_t size)
+{
+    (void)context; (void)pool; (void)memory; (void)size;
+    return(SAE_RESULT_OK);
+}
+
+SAE_MSG_BUFFER *sae_createMsgBuffer(SAE_CONTEXT *context, size_t size,
+    SAE_ALLOC_POLICY policy, void **payload)
+{
+    SAE_MSG_BUFFER *msg;
+
+    (void)context; (void)policy;
+
+    msg = calloc(1, sizeof(*msg) + size);
+    if (msg == NULL) {
+        return(NULL);
+    }
+    atomic_init(&msg->ref, 1);
+    msg->size = size;
+    msg->payload = msg + 1;
+    if (payload) {
+        *payload = msg->payload;
+    }
+    atomic_fetch_add(&liveBuffers, 1);
+
+    return(msg);
+}
+
+size_t sae_getMsgBufferSize(SAE_MSG_BUFFER *msg)
+{
+    return(msg->size);
+}
+
+void *sae_getMsgBufferPayload(SAE_MSG_BUFFER *msg)
+{
+    return(msg ? msg->payload : NULL);
+}
+
+SAE_RESULT sae_refMsgBuffer(SAE_CONTEXT *context, SAE_MSG_BUFFER *msg)
+{
+    (void)context;
+    if (msg == NULL) {
+        return(SAE_RESULT_ERROR);
+    }
+    atomic_fetch_add(&msg->ref, 1);
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_unRefMsgBuffer(SAE_CONTEXT *context, SAE_MSG_BUFFER *msg)
+{
+    int ref;
+
+    (void)context;
+    if (msg == NULL) {
+        return(SAE_RESULT_ERROR);
+    }
+    ref = atomic_fetch_sub(&msg->ref, 1);
+    if (ref <= 0) {
+        return(SAE_RESULT_REFERENCE_ERROR);
+    }
+    if (ref == 1) {
+        free(msg);
+        atomic_fetch_sub(&liveBuffers, 1);
+    }
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_sendMsgBuffer(SAE_CONTEXT *context, SAE_MSG_BUFFER *msg,
+    uint8_t core, bool ipi)
+{
+    SIM_SAE_QUEUE *q;
+
+    (void)context; (void)ipi;
+
+    if ((core < 0) || (core >= SIM_SAE_MAX_CORES)) {
+        return(SAE_RESULT_ERROR);
+    }
+
+    pthread_mutex_lock(&lock);
+    q = &queues[core];
+    if ((q->context == NULL) || (q->context->msgRxCb == NULL)) {
+        pthread_mutex_unlock(&lock);
+        return(SAE_RESULT_CORE_NOT_READY);
+    }
+    msg->next = NULL;
+    if (q->tail) {
+        q->tail->next = msg;
+    } else {
+        q->head = msg;
+    }
+    q->tail = msg;
+    pthread_cond_broadcast(&rxCond);
+    pthread_mutex_unlock(&lock);
+
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_registerMsgReceivedCallback(SAE_CONTEXT *context,
+    SAE_MSG_RECEIVED_CALLBACK cb, void *usrPtr)
+{
+    pthread_mutex_lock(&lock);
+    context->msgRxCb = cb;
+    context->msgRxUsrPtr = usrPtr;
+    pthread_mutex_unlock(&lock);
+    return(SAE_RESULT_OK);
+}
+
+bool sim_sae_dispatch(SAE_CONTEXT *context)
+{
+    SIM_SAE_QUEUE *q = &queues[context->idx];
+    SAE_MSG_BUFFER *msg;
+
+    pthread_mutex_lock(&lock);
+    q->busy = false;
+    pthread_cond_broadcast(&idleCond);
+    while ((q->head == NULL) && !shutdown) {
+        pthread_cond_wait(&rxCond, &lock);
+    }
+    if (shutdown) {
+        pthread_mutex_unlock(&lock);
+        return(false);
+    }
+    msg = q->head;
+    q->head = msg->next;
+    if (q->head == NULL) {
+        q->tail = NULL;
+    }
+    q->busy = true;
+    pthread_mutex_unlock(&lock);
+
+    context->msgRxCb(context, msg, msg->payload, context->msgRxUsrPtr);
+
+    return(true);
+}
+
+void sim_sae_wait_idle(SAE_CORE_IDX core)
+{
+    SIM_SAE_QUEUE *q = &queues[core];
+
+    pthread_mutex_lock(&lock);
+    while ((q->head != NULL) || q->busy) {
+        pthread_cond_wait(&idleCond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void sim_sae_shutdown(void)
+{
+    pthread_mutex_lock(&lock);
+    shutdown = true;
+    pthread_cond_broadcast(&rxCond);
+    pthread_cond_broadcast(&idleCond);
+    pthread_mutex_unlock(&lock);
+}
+
+unsigned sim_sae_live_buffers(void)
+{
+    return(atomic_load(&liveBuffers));
+}
@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * SHARC0 stand-in.  Mirrors the message handling in sharc0_main.c
+ * around the shared router, mixer, scene fade, latency probe and meter
+ * cores, timing the routing (route_audio() and mixer_audio()) and
+ * metering of each block with the host clock in place of the SHARC
+ * cycle counter.
+ * Route times exclude the emulated copy engine, which is timed on its
+ * own.  The meter and probe tables are owned here instead of the ARM.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "sae.h"
+#include "ipc.h"
+#include "route.h"
+#include "meter.h"
+#include "latency.h"
+#include "mixer.h"
+#include "scene.h"
+#include "scene_msg.h"
+#include "context.h"
+
+#include "sim.h"
+
+static SAE_CONTEXT *saeContext;
+static pthread_t thread;
+
+static IPC_MSG_AUDIO *streamInfo[IPC_STREAM_ID_MAX];
+
+static SIM_STAT routeStat[CLOCK_DOMAIN_MAX] = {
+    [CLOCK_DOMAIN_SYSTEM] = { .name = "route_system" },
+    [CLOCK_DOMAIN_A2B] = { .name = "route_a2b" },
+    [CLOCK_DOMAIN_SPDIF] = { .name = "route_spdif" },
+};
+
+static SIM_STAT routeCoreStat[CLOCK_DOMAIN_MAX] = {
+    [CLOCK_DOMAIN_SYSTEM] = { .name = "route_system_core" },
+    [CLOCK_DOMAIN_A2B] = { .name = "route_a2b_core" },
+    [CLOCK_DOMAIN_SPDIF] = { .name = "route_spdif_core" },
+};
+static unsigned routeBlocks[CLOCK_DOMAIN_MAX];
+
+static SIM_STAT mdmaStat = { .name = "mdma" };
+static SIM_STAT meterStat = { .name = "meter" };
+static METER_TABLE *meterTable;
+static LATENCY_PROBE *latencyProbe;
+
+static void routeAudio(uint8_t clockDomain)
+{
+    IPC_MSG_AUDIO *domainStreams[IPC_STREAM_ID_MAX];
+    IPC_MSG_ROUTING *routeInfo;
+    uint64_t start, ns, engineNs;
+    bool calibrate = false;
+
+    routeInfo = scene_msg_routes();
+    if (routeInfo == NULL) {
+        return;
+    }
+
+    memcpy(domainStreams, streamInfo, sizeof(domainStreams));
+
+    latency_pre_route(streamInfo, clockDomain);
+
+    if (clockDomain < CLOCK_DOMAIN_MAX) {
+        if (++routeBlocks[clockDomain] >= ROUTE_CALIBRATE_BLOCKS) {
+            routeBlocks[clockDomain] = 0;
+            calibrate = true;
+        }
+    }
+    route_offload(!calibrate);
+
+    start = sim_host_ns();
+    scene_fade_pre(domainStreams, clockDomain);
+    route_audio(routeInfo, streamInfo, clockDomain);
+    mixer_audio(domainStreams, clockDomain);
+    scene_fade_post(domainStreams, clockDomain);
+    ns = sim_host_ns() - start;
+
+    route_offload(true);
+
+    scene_msg_block();
+
+    engineNs = sim_mdma_take_ns();
+    if (engineNs) {
+        sim_stat_add(&mdmaStat, engineNs);
+    }
+    if (clockDomain < CLOCK_DOMAIN_MAX) {
+        sim_stat_add(calibrate ? &routeCoreStat[clockDomain] :
+            &routeStat[clockDomain], ns - engineNs);
+    }
+
+    latency_post_route(domainStreams, clockDomain);
+
+    start = sim_host_ns();
+    meter_audio(domainStreams, clockDomain);
+    sim_stat_add(&meterStat, sim_host_ns() - start);
+}
+
+static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
+    void *payload, void *usrPtr)
+{
+    IPC_MSG *msg = (IPC_MSG *)payload;
+
+    switch (msg->type) {
+        case IPC_TYPE_AUDIO:
+            route_new_audio(streamInfo, &msg->audio);
+            break;
+        case IPC_TYPE_AUDIO_ROUTING:
+            scene_msg_routing(buffer);
+            break;
+        case IPC_TYPE_PROCESS_AUDIO:
+            routeAudio(msg->process.clockDomain);
+            break;
+        case IPC_TYPE_MIXER:
+            scene_msg_mixer(buffer);
+            break;
+        case IPC_TYPE_SCENE:
+            scene_msg_scene(buffer);
+            break;
+        default:
+            break;
+    }
+
+    sae_unRefMsgBuffer(saeContext, buffer);
+}
+
+static void *sharc0Thread(void *arg)
+{
+    (void)arg;
+    while (sim_sae_dispatch(saeContext)) {
+    }
+    return(NULL);
+}
+
+bool sim_sharc0_start(void)
+{
+    SAE_RESULT result;
+
+    result = sae_initialize(&saeContext, SAE_CORE_IDX_1, false);
+    if (result != SAE_RESULT_OK) {
+        return(false);
+    }
+    scene_msg_init(saeContext);
+
+    meterTable = meter_init(calloc(1, meter_size()),
+        SYSTEM_SAMPLE_RATE / SYSTEM_BLOCK_SIZE);
+    meterTable->enable = 1;
+    meter_attach(meterTable);
+    latencyProbe = latency_init(calloc(1, latency_size()));
+    latency_attach(latencyProbe);
+    sae_registerMsgReceivedCallback(saeContext, ipcMsgRx, NULL);
+
+    return(pthread_create(&thread, NULL, sharc0Thread, NULL) == 0);
+}
+
+void sim_sharc0_stop(void)
+{
+    sim_sae_wait_idle(SAE_CORE_IDX_1);
+    sim_sae_shutdown();
+    pthread_join(thread, NULL);
+    sae_unInitialize(&saeContext);
+}
+
+SIM_STAT *sim_sharc0_route_stat(CLOCK_DOMAIN cd)
+{
+    return(&routeStat[cd]);
+}
+
+SIM_STAT *sim_sharc0_route_core_stat(CLOCK_DOMAIN cd)
+{
+    return(&routeCoreStat[cd]);
+}
+
+SIM_STAT *sim_sharc0_mdma_stat(void)
+{
+    return(&mdmaStat);
+}
+
+LATENCY_PROBE *sim_sharc0_latency(void)
+{
+    return(latencyProbe);
+}
+
+void sim_sharc0_meter_config(unsigned blockHz, uint32_t streams)
+{
+    meter_rate(meterTable, blockHz);
+    meterTable->streams = streams;
+}
+
+SIM_STAT *sim_sharc0_meter_stat(void)
+{
+    return(&meterStat);
+}
+
+void sim_sharc0_meter_report(FILE *f)
+{
+    METER_LEVELS levels;
+    float peak, rms;
+    unsigned id, ch;
+
+    for (id = 0; id < IPC_STREAM_ID_MAX; id++) {
+        if (!meter_read(meterTable, id, &levels) || (levels.numChannels == 0)) {
+            continue;
+        }
+        peak = 0.0f; rms = 0.0f;
+        for (ch = 0; ch < levels.numChannels; ch++) {
+            if (levels.peak[ch] > peak) {
+                peak = levels.peak[ch];
+            }
+            if (levels.rms[ch] > rms) {
+                rms = levels.rms[ch];
+            }
+        }
+        fprintf(f, "meter,%u,channels,%u,blocks,%u,peak_db10,%d,rms_db10,%d\n",
+            id, levels.numChannels, (unsigned)levels.blocks,
+            meter_db10(peak), meter_db10(rms));
+    }
+}
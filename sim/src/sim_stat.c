@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+void sim_stat_add(SIM_STAT *stat, uint64_t ns)
+{
+    uint32_t *p;
+    unsigned size;
+
+    if (stat->count == stat->size) {
+        size = stat->size ? stat->size * 2 : 1024;
+        p = realloc(stat->ns, size * sizeof(*p));
+        if (p == NULL) {
+            return;
+        }
+        stat->ns = p;
+        stat->size = size;
+    }
+    stat->ns[stat->count++] = (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+static int cmpU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return((x > y) - (x < y));
+}
+
+void sim_stat_report(FILE *f, SIM_STAT *stat)
+{
+    uint64_t sum;
+    unsigned i;
+
+    if (stat->count == 0) {
+        return;
+    }
+
+    qsort(stat->ns, stat->count, sizeof(*stat->ns), cmpU32);
+    sum = 0;
+    for (i = 0; i < stat->count; i++) {
+        sum += stat->ns[i];
+    }
+
+    fprintf(f, "time,%s,%u,%lu,%lu,%lu,%lu\n",
+        stat->name, stat->count,
+        (unsigned long)stat->ns[0],
+        (unsigned long)(sum / stat->count),
+        (unsigned long)stat->ns[(stat->count * 99) / 100],
+        (unsigned long)stat->ns[stat->count - 1]);
+}
+
+void sim_stat_free(SIM_STAT *stat)
+{
+    free(stat->ns);
+    stat->ns = NULL;
+    stat->count = stat->size = 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Host side A2B command list converter
+ *
+ * Converts SigmaStudio A2B XML exports into the binary format loaded
+ * by the 'discover' shell command and checks that both formats play
+ * out the same command list.
+ *
+ * @file      a2bconv.c
+ * @version   1.0.0
+ * @copyright 2021 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "a2b_xml.h"
+#include "a2b_bin.h"
+#include "adi_a2b_commandlist.h"
+
+static void usage(void)
+{
+    printf(
+        "usage: a2bconv [-c | -d] <file> [out.a2b]\n"
+        "  <a2b.xml> [out.a2b]     Convert an XML export to binary\n"
+        "  -c <a2b.xml> [in.a2b]   Check a binary against its XML source\n"
+        "  -d <in.a2b>             Dump a binary\n"
+        "The binary name defaults to the XML name with a '.a2b' extension\n"
+    );
+}
+
+/* Command 'i' of a command list in the A2B_CMD_SPI superset */
+static A2B_CMD_SPI getCmd(const void *cfg, uint32_t i, A2B_CMD_TYPE type)
+{
+    A2B_CMD_SPI spi;
+    const A2B_CMD *cmd;
+
+    memset(&spi, 0, sizeof(spi));
+    if (type == A2B_CMD_TYPE_I2C) {
+        cmd = (const A2B_CMD *)cfg + i;
+        spi.nDeviceAddr = cmd->nDeviceAddr;
+        spi.eOpCode = cmd->eOpCode;
+        spi.nAddrWidth = cmd->nAddrWidth;
+        spi.nAddr = cmd->nAddr;
+        spi.nDataWidth = cmd->nDataWidth;
+        spi.nDataCount = cmd->nDataCount;
+        spi.paConfigData = cmd->paConfigData;
+    } else {
+        spi = *((const A2B_CMD_SPI *)cfg + i);
+    }
+    if (spi.paConfigData == NULL) {
+        spi.nDataCount = 0;
+    }
+
+    return(spi);
+}
+
+static uint32_t numCmds(uint32_t cfgLen, A2B_CMD_TYPE type)
+{
+    return(cfgLen / (type == A2B_CMD_TYPE_I2C ?
+        sizeof(A2B_CMD) : sizeof(A2B_CMD_SPI)));
+}
+
+static void dump(const void *cfg, uint32_t cfgLen, A2B_CMD_TYPE type)
+{
+    A2B_CMD_SPI cmd;
+    uint32_t i;
+    unsigned j;
+
+    printf("type %s, %u commands\n",
+        type == A2B_CMD_TYPE_I2C ? "i2c" : "spi",
+        (unsigned)numCmds(cfgLen, type));
+    for (i = 0; i < numCmds(cfgLen, type); i++) {
+        cmd = getCmd(cfg, i, type);
+        printf("%4u: dev 0x%02x op %u addr 0x%0*x len %u",
+            (unsigned)i, cmd.nDeviceAddr, cmd.eOpCode,
+            cmd.nAddrWidth * 2, cmd.nAddr, cmd.nDataCount);
+        if (type == A2B_CMD_TYPE_SPI) {
+            printf(" proto %u spi 0x%x/%u", cmd.eProtocol, cmd.nSpiCmd,
+                cmd.nSpiCmdWidth);
+        }
+        for (j = 0; j < cmd.nDataCount; j++) {
+            printf("%s%02x", j ? " " : " :", cmd.paConfigData[j]);
+        }
+        printf("\n");
+    }
+}
+
+/* Compares every command field and data byte of two command lists */
+static bool compare(const void *a, uint32_t aLen, const void *b,
+    uint32_t bLen, A2B_CMD_TYPE type)
+{
+    A2B_CMD_SPI ca, cb;
+    uint32_t i;
+
+    if (aLen != bLen) {
+        printf("length mismatch: %u vs %u\n", (unsigned)aLen, (unsigned)bLen);
+        return(false);
+    }
+    for (i = 0; i < numCmds(aLen, type); i++) {
+        ca = getCmd(a, i, type);
+        cb = getCmd(b, i, type);
+        if ((ca.nDeviceAddr != cb.nDeviceAddr) ||
+            (ca.eOpCode != cb.eOpCode) ||
+            (ca.nAddrWidth != cb.nAddrWidth) ||
+            (ca.nAddr != cb.nAddr) ||
+            (ca.nDataWidth != cb.nDataWidth) ||
+            (ca.nDataCount != cb.nDataCount) ||
+            (ca.nSpiCmdWidth != cb.nSpiCmdWidth) ||
+            (ca.nSpiCmd != cb.nSpiCmd) ||
+            (ca.eProtocol != cb.eProtocol) ||
+            (ca.nDataCount &&
+             memcmp(ca.paConfigData, cb.paConfigData, ca.nDataCount))) {
+            printf("command %u mismatch\n", (unsigned)i);
+            return(false);
+        }
+    }
+    return(true);
+}
+
+int main(int argc, char **argv)
+{
+    char binName[1024];
+    const char *xmlName;
+    bool check = false;
+    bool dumpOnly = false;
+    void *xmlCfg, *binCfg;
+    uint32_t xmlLen, binLen;
+    A2B_CMD_TYPE xmlType, binType;
+    uint32_t xmlHash;
+    bool ok;
+    int arg = 1;
+
+    if ((argc > 1) && (strcmp(argv[1], "-c") == 0)) {
+        check = true;
+        arg++;
+    } else if ((argc > 1) && (strcmp(argv[1], "-d") == 0)) {
+        dumpOnly = true;
+        arg++;
+    }
+    if ((arg >= argc) || (argc > arg + 2) ||
+        (strcmp(argv[arg], "-h") == 0)) {
+        usage();
+        return(1);
+    }
+    xmlName = argv[arg];
+
+    if (dumpOnly) {
+        binLen = a2b_bin_load(xmlName, A2B_BIN_ANY_XML, &binCfg, &binType);
+        if (binLen == 0) {
+            fprintf(stderr, "a2bconv: '%s' is not a valid binary\n", xmlName);
+            return(1);
+        }
+        dump(binCfg, binLen, binType);
+        a2b_bin_free(binCfg);
+        return(0);
+    }
+
+    if (arg + 1 < argc) {
+        snprintf(binName, sizeof(binName), "%s", argv[arg + 1]);
+    } else {
+        a2b_bin_name(xmlName, binName, sizeof(binName));
+    }
+
+    if (!a2b_bin_file_hash(xmlName, &xmlHash)) {
+        fprintf(stderr, "a2bconv: cannot read '%s'\n", xmlName);
+        return(1);
+    }
+    xmlLen = a2b_xml_load(xmlName, &xmlCfg, &xmlType);
+    if (xmlLen == 0) {
+        fprintf(stderr, "a2bconv: cannot parse '%s'\n", xmlName);
+        return(1);
+    }
+
+    if (!check) {
+        ok = a2b_bin_save(binName, xmlHash, xmlCfg, xmlLen, xmlType);
+        if (ok) {
+            printf("%s: %u commands -> %s\n", xmlName,
+                (unsigned)numCmds(xmlLen, xmlType), binName);
+        } else {
+            fprintf(stderr, "a2bconv: cannot write '%s'\n", binName);
+        }
+        a2b_xml_free(xmlCfg, xmlLen, xmlType);
+        return(ok ? 0 : 1);
+    }
+
+    /* Parity check, the binary must be keyed on this XML file */
+    binLen = a2b_bin_load(binName, xmlHash, &binCfg, &binType);
+    if (binLen == 0) {
+        printf("%s: missing, stale or corrupt\n", binName);
+        ok = false;
+    } else {
+        ok = (binType == xmlType) &&
+            compare(xmlCfg, xmlLen, binCfg, binLen, xmlType);
+        printf("%s: %s (%u commands)\n", binName, ok ? "ok" : "MISMATCH",
+            (unsigned)numCmds(xmlLen, xmlType));
+        a2b_bin_free(binCfg);
+    }
+    a2b_xml_free(xmlCfg, xmlLen, xmlType);
+
+    return(ok ? 0 : 1);
+}
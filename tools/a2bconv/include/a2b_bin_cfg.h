@@ -0,0 +1,22 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host build configuration of the A2B binary module.  Shadows
+ * ARM/include/a2b_bin_cfg.h.
+ */
+#ifndef _a2b_bin_cfg_h
+#define _a2b_bin_cfg_h
+
+#define A2B_BIN_BUFSIZE       4096
+#define A2B_BIN_MAX_SIZE      (16 * 1024 * 1024)
+
+#endif
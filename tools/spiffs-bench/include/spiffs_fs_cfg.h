@@ -0,0 +1,33 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host build configuration of the SPIFFS application layer.  Shadows
+ * ARM/src/oss-services/spiffs/inc/spiffs_fs_cfg.h with the same flash
+ * layout but the C library heap.
+ */
+#ifndef _spiffs_fs_cfg_h
+#define _spiffs_fs_cfg_h
+
+#include <stdlib.h>
+
+#include "flash_map.h"
+
+#define SPIFFS_FS_CALLOC            calloc
+#define SPIFFS_FS_FREE              free
+#define SPIFFS_FS_SIZE              SPIFFS_SIZE
+#define SPIFFS_FS_OFFSET            SPIFFS_OFFSET
+#define SPIFFS_FS_ERASE_BLOCK_SIZE  ERASE_BLOCK_SIZE
+#define SPIFFS_FS_FLASH_PAGE_SIZE   FLASH_PAGE_SIZE
+#define SPIFFS_FS_INDEX_OFFSET      SPIFFS_INDEX_OFFSET
+#define SPIFFS_FS_INDEX_SIZE        SPIFFS_INDEX_SIZE
+
+#endif
@@ -0,0 +1,339 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Host side SPIFFS mount index benchmark
+ *
+ * Fills a RAM backed flash to several levels and compares the flash
+ * traffic of a scan mount against a mount index mount, along with the
+ * first open of an existing and of a missing file.
+ *
+ * @file      spiffs_bench.c
+ * @version   1.0.0
+ * @copyright 2022 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "flash.h"
+#include "flash_map.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+#include "spiffs_fs.h"
+
+#define RAM_FLASH_SIZE  (SPIFFS_INDEX_OFFSET + SPIFFS_INDEX_SIZE)
+
+typedef struct RAM_FLASH_STATS {
+    unsigned reads;
+    unsigned readBytes;
+    unsigned programs;
+    unsigned erases;
+} RAM_FLASH_STATS;
+
+typedef struct BENCH_RESULT {
+    RAM_FLASH_STATS io;
+    unsigned us;
+} BENCH_RESULT;
+
+static uint8_t *ramFlash;
+static RAM_FLASH_STATS ramStats;
+
+/***********************************************************************
+ * RAM flash, NOR semantics
+ **********************************************************************/
+static int ram_flash_read(const FLASH_INFO *fi, uint32_t addr, uint8_t *buf, int size)
+{
+    if ((addr + size) > RAM_FLASH_SIZE) {
+        return(FLASH_ERROR);
+    }
+    memcpy(buf, ramFlash + addr, size);
+    ramStats.reads++;
+    ramStats.readBytes += size;
+    return(FLASH_OK);
+}
+
+static int ram_flash_erase(const FLASH_INFO *fi, uint32_t addr, int size)
+{
+    uint32_t start, end;
+
+    start = addr & ~(ERASE_BLOCK_SIZE - 1);
+    end = (addr + size + ERASE_BLOCK_SIZE - 1) & ~(ERASE_BLOCK_SIZE - 1);
+    if (end > RAM_FLASH_SIZE) {
+        return(FLASH_ERROR);
+    }
+    memset(ramFlash + start, 0xFF, end - start);
+    ramStats.erases += (end - start) / ERASE_BLOCK_SIZE;
+    return(FLASH_OK);
+}
+
+static int ram_flash_program(const FLASH_INFO *fi, uint32_t addr, const uint8_t *buf, int size)
+{
+    int i;
+
+    if ((addr + size) > RAM_FLASH_SIZE) {
+        return(FLASH_ERROR);
+    }
+    for (i = 0; i < size; i++) {
+        ramFlash[addr + i] &= buf[i];
+    }
+    ramStats.programs++;
+    return(FLASH_OK);
+}
+
+static FLASH_INFO ramFlashInfo = {
+    .flash_read = ram_flash_read,
+    .flash_erase = ram_flash_erase,
+    .flash_program = ram_flash_program,
+};
+
+/***********************************************************************
+ * Helpers
+ **********************************************************************/
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static uint64_t benchStart;
+
+static void bench_start(void)
+{
+    memset(&ramStats, 0, sizeof(ramStats));
+    benchStart = now_us();
+}
+
+static void bench_stop(BENCH_RESULT *r)
+{
+    r->us = (unsigned)(now_us() - benchStart);
+    r->io = ramStats;
+}
+
+static void file_name(char *name, unsigned i)
+{
+    sprintf(name, "rec%04u.wav", i);
+}
+
+static void file_fill(uint8_t *buf, unsigned size, unsigned seed)
+{
+    unsigned i;
+    for (i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(seed * 31 + i);
+    }
+}
+
+/* Opens a file and closes it again, returns the open result */
+static s32_t bench_open(spiffs *fs, const char *name, BENCH_RESULT *r)
+{
+    spiffs_file fd;
+
+    bench_start();
+    fd = SPIFFS_open(fs, name, SPIFFS_O_RDONLY, 0);
+    bench_stop(r);
+    if (fd >= 0) {
+        SPIFFS_close(fs, fd);
+    }
+    return(fd);
+}
+
+static void print_result(const char *what, const BENCH_RESULT *r)
+{
+    printf(",%s_reads,%u,%s_kb,%u,%s_us,%u", what, r->io.reads,
+        what, (r->io.readBytes + 512) / 1024, what, r->us);
+}
+
+/***********************************************************************
+ * Benchmark
+ **********************************************************************/
+static bool bench_level(spiffs *fs, unsigned fill, unsigned fileSize)
+{
+    BENCH_RESULT scanMount, indexMount;
+    BENCH_RESULT scanOpen = { 0 }, indexOpen = { 0 };
+    BENCH_RESULT scanMiss, indexMiss;
+    BENCH_RESULT result;
+    u32_t total, used, scanUsed;
+    SPIFFS_INDEX_INFO info, mountInfo;
+    FLASH_INFO *fi;
+    spiffs_file fd;
+    uint8_t *buf, *chk;
+    char name[32];
+    unsigned files;
+    s32_t res;
+    bool ok;
+
+    buf = malloc(fileSize);
+    chk = malloc(fileSize);
+
+    /* Start from erased flash */
+    memset(ramFlash, 0xFF, RAM_FLASH_SIZE);
+    memset(fs, 0, sizeof(*fs));
+    spiffs_mount(fs, &ramFlashInfo);
+    spiffs_format(fs);
+
+    /* Fill with recordings */
+    files = 0;
+    SPIFFS_info(fs, &total, &used);
+    while ((uint64_t)used * 100 < (uint64_t)total * fill) {
+        file_name(name, files);
+        file_fill(buf, fileSize, files);
+        fd = SPIFFS_open(fs, name, SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_RDWR, 0);
+        if (fd < 0) {
+            break;
+        }
+        res = SPIFFS_write(fs, fd, buf, fileSize);
+        SPIFFS_close(fs, fd);
+        if (res != (s32_t)fileSize) {
+            break;
+        }
+        files++;
+        SPIFFS_info(fs, &total, &used);
+    }
+
+    /* Scan mount, no snapshot */
+    spiffs_index_discard(fs);
+    spiffs_unmount(fs, &fi);
+    memset(fs, 0, sizeof(*fs));
+    bench_start();
+    res = spiffs_mount(fs, fi);
+    bench_stop(&scanMount);
+    ok = (res == SPIFFS_OK);
+    SPIFFS_info(fs, &total, &scanUsed);
+
+    file_name(name, files / 2);
+    if (files) {
+        ok = (bench_open(fs, name, &scanOpen) >= 0) && ok;
+    }
+    ok = (bench_open(fs, "missing.wav", &scanMiss) < 0) && ok;
+
+    /* Unmount snapshots the index, remount from it */
+    spiffs_unmount(fs, &fi);
+    memset(fs, 0, sizeof(*fs));
+    bench_start();
+    res = spiffs_mount(fs, fi);
+    bench_stop(&indexMount);
+    ok = ok && (res == SPIFFS_OK);
+    spiffs_index_info(fs, &mountInfo);
+    ok = ok && mountInfo.mounted;
+
+    if (files) {
+        ok = (bench_open(fs, name, &indexOpen) >= 0) && ok;
+    }
+    ok = (bench_open(fs, "missing.wav", &indexMiss) < 0) && ok;
+
+    /* Index mount must agree with the scan */
+    SPIFFS_info(fs, &total, &used);
+    ok = ok && (used == scanUsed);
+    if (files) {
+        fd = SPIFFS_open(fs, name, SPIFFS_O_RDONLY, 0);
+        file_fill(buf, fileSize, files / 2);
+        ok = ok && (fd >= 0) &&
+            (SPIFFS_read(fs, fd, chk, fileSize) == (s32_t)fileSize) &&
+            (memcmp(buf, chk, fileSize) == 0);
+        SPIFFS_close(fs, fd);
+    }
+
+    /* A change followed by a power loss must fall back to a scan */
+    fd = SPIFFS_open(fs, "new.wav", SPIFFS_O_CREAT | SPIFFS_O_RDWR, 0);
+    ok = ok && (fd >= 0) && (SPIFFS_write(fs, fd, buf, 100) == 100);
+    SPIFFS_close(fs, fd);
+    memset(fs, 0, sizeof(*fs));         /* Leaks the old mount */
+    spiffs_mount(fs, &ramFlashInfo);
+    spiffs_index_info(fs, &info);
+    ok = ok && !info.mounted;
+    ok = ok && (bench_open(fs, "new.wav", &result) >= 0);
+    ok = ok && (SPIFFS_check(fs) == SPIFFS_OK);
+
+    /* So must a live snapshot of a partition changed behind its back */
+    spiffs_unmount(fs, NULL);
+    ramFlash[SPIFFS_ERASE_COUNT_PADDR(fs, fs->block_count - 1)] ^= 0x01;
+    memset(fs, 0, sizeof(*fs));
+    spiffs_mount(fs, &ramFlashInfo);
+    spiffs_index_info(fs, &info);
+    ok = ok && !info.mounted;
+    spiffs_unmount(fs, NULL);
+
+    printf("fill,%u,files,%u,indexed,%u%s", fill, files,
+        (unsigned)mountInfo.files, mountInfo.complete ? "" : "+");
+    print_result("scan_mount", &scanMount);
+    print_result("index_mount", &indexMount);
+    print_result("scan_open", &scanOpen);
+    print_result("index_open", &indexOpen);
+    print_result("scan_miss", &scanMiss);
+    print_result("index_miss", &indexMiss);
+    printf(",%s\n", ok ? "ok" : "FAIL");
+
+    free(buf);
+    free(chk);
+
+    return(ok);
+}
+
+static void usage(void)
+{
+    printf(
+        "usage: spiffs-bench [-s <file size>] [<fill %%> ...]\n"
+        "  -s <size>   Recording size in bytes (default 49152)\n"
+        "  <fill %%>    Fill levels to run (default 0 25 50 75 90)\n"
+    );
+}
+
+int main(int argc, char **argv)
+{
+    static const unsigned defaultFill[] = { 0, 25, 50, 75, 90 };
+    unsigned fill[16];
+    unsigned numFill;
+    unsigned fileSize;
+    spiffs fs;
+    bool ok;
+    int i;
+
+    fileSize = 49152;
+    numFill = 0;
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+            fileSize = strtoul(argv[++i], NULL, 0);
+        } else if ((argv[i][0] >= '0') && (argv[i][0] <= '9') &&
+                   (numFill < sizeof(fill) / sizeof(fill[0]))) {
+            fill[numFill++] = strtoul(argv[i], NULL, 0);
+        } else {
+            usage();
+            return(1);
+        }
+    }
+    if (numFill == 0) {
+        numFill = sizeof(defaultFill) / sizeof(defaultFill[0]);
+        memcpy(fill, defaultFill, sizeof(defaultFill));
+    }
+    if (fileSize == 0) {
+        usage();
+        return(1);
+    }
+
+    ramFlash = malloc(RAM_FLASH_SIZE);
+    if (ramFlash == NULL) {
+        return(1);
+    }
+
+    ok = true;
+    for (i = 0; i < numFill; i++) {
+        ok = bench_level(&fs, fill[i], fileSize) && ok;
+    }
+
+    free(ramFlash);
+
+    return(ok ? 0 : 1);
+}
@@ -0,0 +1,23 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _SXFER_CFG_H
+#define _SXFER_CFG_H
+
+/*! @cond */
+
+/* Host build, frames are allocated with the C library */
+#define SXFER_FRAME_MAX     (16 * 1024)
+#define SXFER_WINDOW        (4)
+
+/*! @endcond example-config */
+
+#endif
@@ -0,0 +1,276 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "sxfer.h"
+#include "sxfer_host.h"
+#include "crc32.h"
+
+/* Response timeout (ms), longer than the target's own NAK timeout */
+#ifndef SXFER_HOST_TIMEOUT
+#define SXFER_HOST_TIMEOUT   (2 * SXFER_TIMEOUT)
+#endif
+
+/* Consecutive response timeouts before giving up */
+#ifndef SXFER_HOST_RETRIES
+#define SXFER_HOST_RETRIES   (10)
+#endif
+
+#define SXFER_HDR_SIZE   (16)
+#define SXFER_CRC_SIZE   (4)
+
+static const uint8_t sxferMagic[4] = { 'S', 'X', 'F', 'R' };
+
+typedef struct SXFER_HOST_HDR {
+    uint8_t type;
+    uint8_t status;
+    uint16_t window;
+    uint32_t offset;
+    uint32_t length;
+} SXFER_HOST_HDR;
+
+typedef enum SXFER_HOST_RX {
+    SXFER_HOST_RX_OK,
+    SXFER_HOST_RX_TIMEOUT,
+    SXFER_HOST_RX_ERROR
+} SXFER_HOST_RX;
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+        ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int send_frame(const SXFER_HOST_LINK *link, uint8_t type,
+    uint32_t offset, const uint8_t *payload, uint32_t length)
+{
+    uint8_t hdr[SXFER_HDR_SIZE];
+    uint8_t crcBytes[SXFER_CRC_SIZE];
+    uint32_t crc;
+
+    memcpy(hdr, sxferMagic, sizeof(sxferMagic));
+    hdr[4] = type;
+    hdr[5] = 0;
+    hdr[6] = 0;
+    hdr[7] = 0;
+    put32(&hdr[8], offset);
+    put32(&hdr[12], length);
+
+    crc = crc32(hdr, sizeof(hdr));
+    crc = crc32_x(payload, length, crc);
+    put32(crcBytes, crc);
+
+    if (link->write(hdr, sizeof(hdr), link->usr) != 0) {
+        return(-1);
+    }
+    if (length && (link->write(payload, length, link->usr) != 0)) {
+        return(-1);
+    }
+    return(link->write(crcBytes, sizeof(crcBytes), link->usr));
+}
+
+static SXFER_HOST_RX read_all(const SXFER_HOST_LINK *link, uint8_t *data,
+    unsigned len)
+{
+    int n;
+
+    while (len) {
+        n = link->read(data, len, SXFER_HOST_TIMEOUT, link->usr);
+        if (n < 0) {
+            return(SXFER_HOST_RX_ERROR);
+        }
+        if (n == 0) {
+            return(SXFER_HOST_RX_TIMEOUT);
+        }
+        data += n;
+        len -= n;
+    }
+    return(SXFER_HOST_RX_OK);
+}
+
+/*
+ * Reads one target frame.  Anything that is not a well formed frame,
+ * such as console output ahead of the READY, is skipped.
+ */
+static SXFER_HOST_RX get_frame(const SXFER_HOST_LINK *link,
+    SXFER_HOST_HDR *hdr)
+{
+    uint8_t raw[SXFER_HDR_SIZE + SXFER_CRC_SIZE];
+    SXFER_HOST_RX rx;
+    unsigned match;
+    uint8_t c;
+
+    while (1) {
+        match = 0;
+        while (match < sizeof(sxferMagic)) {
+            rx = read_all(link, &c, 1);
+            if (rx != SXFER_HOST_RX_OK) {
+                return(rx);
+            }
+            if (c == sxferMagic[match]) {
+                match++;
+            } else {
+                match = (c == sxferMagic[0]) ? 1 : 0;
+            }
+        }
+        memcpy(raw, sxferMagic, sizeof(sxferMagic));
+        rx = read_all(link, &raw[4], sizeof(raw) - 4);
+        if (rx != SXFER_HOST_RX_OK) {
+            return(rx);
+        }
+        if (crc32(raw, SXFER_HDR_SIZE) != get32(&raw[SXFER_HDR_SIZE])) {
+            continue;
+        }
+        hdr->type = raw[4];
+        hdr->status = raw[5];
+        hdr->window = raw[6] | (raw[7] << 8);
+        hdr->offset = get32(&raw[8]);
+        hdr->length = get32(&raw[12]);
+        return(SXFER_HOST_RX_OK);
+    }
+}
+
+int sxfer_host_send(const SXFER_HOST_LINK *link, const uint8_t *image,
+    uint32_t size, uint32_t session, uint32_t stopAt,
+    SXFER_HOST_STATS *stats)
+{
+    SXFER_HOST_STATS dummy;
+    SXFER_HOST_HDR hdr;
+    SXFER_HOST_RX rx;
+    uint8_t start[8];
+    uint32_t frameMax, inFlight;
+    uint32_t base, next, sentMax, len;
+    unsigned retries;
+    bool ending;
+
+    if (stats == NULL) {
+        stats = &dummy;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    /* START until READY */
+    put32(&start[0], size);
+    put32(&start[4], session);
+    for (retries = SXFER_HOST_RETRIES; ; retries--) {
+        if (retries == 0) {
+            return(SXFER_HOST_ERROR);
+        }
+        if (send_frame(link, SXFER_TYPE_START, 0, start, sizeof(start)) != 0) {
+            return(SXFER_HOST_ERROR);
+        }
+        do {
+            rx = get_frame(link, &hdr);
+        } while ((rx == SXFER_HOST_RX_OK) && (hdr.type != SXFER_TYPE_READY) &&
+            (hdr.type != SXFER_TYPE_ERROR));
+        if (rx == SXFER_HOST_RX_ERROR) {
+            return(SXFER_HOST_ERROR);
+        }
+        if (rx == SXFER_HOST_RX_OK) {
+            break;
+        }
+    }
+    if ((hdr.type == SXFER_TYPE_ERROR) || (hdr.offset > size)) {
+        return(SXFER_HOST_REJECTED);
+    }
+
+    frameMax = hdr.length;
+    inFlight = (hdr.window ? hdr.window : 1) * frameMax;
+    if (frameMax == 0) {
+        return(SXFER_HOST_ERROR);
+    }
+
+    stats->resumeOffset = hdr.offset;
+    base = next = sentMax = hdr.offset;
+    retries = SXFER_HOST_RETRIES;
+    ending = false;
+
+    while (1) {
+
+        /* Fill the window */
+        while (!ending && (next < size) && ((next - base) < inFlight)) {
+            if (stopAt && (next >= stopAt)) {
+                return(SXFER_HOST_STOPPED);
+            }
+            len = size - next;
+            if (len > frameMax) {
+                len = frameMax;
+            }
+            if (send_frame(link, SXFER_TYPE_DATA, next, &image[next], len) != 0) {
+                return(SXFER_HOST_ERROR);
+            }
+            stats->frames++;
+            if (next < sentMax) {
+                stats->resent++;
+            }
+            next += len;
+            if (next > sentMax) {
+                sentMax = next;
+            }
+        }
+
+        /* Everything sent, ask for completion */
+        if (!ending && (next == size) && (base == size)) {
+            if (send_frame(link, SXFER_TYPE_END, size, NULL, 0) != 0) {
+                return(SXFER_HOST_ERROR);
+            }
+            ending = true;
+        }
+
+        rx = get_frame(link, &hdr);
+        if (rx == SXFER_HOST_RX_ERROR) {
+            return(SXFER_HOST_ERROR);
+        }
+        if (rx == SXFER_HOST_RX_TIMEOUT) {
+            stats->timeouts++;
+            if (--retries == 0) {
+                return(SXFER_HOST_ERROR);
+            }
+            /* Resend from the last acknowledged offset */
+            next = base;
+            ending = false;
+            continue;
+        }
+
+        switch (hdr.type) {
+            case SXFER_TYPE_ACK:
+                retries = SXFER_HOST_RETRIES;
+                if ((hdr.offset > base) && (hdr.offset <= size)) {
+                    base = hdr.offset;
+                }
+                if (next < base) {
+                    next = base;
+                }
+                break;
+            case SXFER_TYPE_NAK:
+                stats->naks++;
+                if (hdr.offset <= size) {
+                    base = hdr.offset;
+                    next = hdr.offset;
+                }
+                ending = false;
+                break;
+            case SXFER_TYPE_DONE:
+                return((hdr.offset == size) ? SXFER_HOST_OK : SXFER_HOST_ERROR);
+            case SXFER_TYPE_ERROR:
+                return(SXFER_HOST_REJECTED);
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Windowed streaming transfer reference sender
+ *
+ * Host side of the sxfer protocol (see sxfer.h for the wire format).
+ * Keeps as many DATA frames in flight as the target's READY allows,
+ * slides the window on cumulative ACKs and goes back to the NAKed
+ * offset on errors.  Restarting a transfer with the same session id
+ * resumes from the target's committed offset.
+ *
+ * @file      sxfer_host.h
+ * @version   1.0.0
+ * @copyright 2022 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+
+#ifndef _SXFER_HOST_H
+#define _SXFER_HOST_H
+
+#include <stdint.h>
+
+/*!****************************************************************
+ * @brief  Link access
+ *
+ * 'read' returns the number of bytes read, 0 after 'timeout' ms
+ * without data or < 0 on error.  'write' returns 0 on success.
+ ******************************************************************/
+typedef struct SXFER_HOST_LINK {
+    int (*read)(uint8_t *data, unsigned len, unsigned timeout, void *usr);
+    int (*write)(const uint8_t *data, unsigned len, void *usr);
+    void *usr;
+} SXFER_HOST_LINK;
+
+/*!****************************************************************
+ * @brief  Transfer statistics
+ ******************************************************************/
+typedef struct SXFER_HOST_STATS {
+    uint32_t resumeOffset;    /**< Offset the target resumed from */
+    uint32_t frames;          /**< DATA frames sent */
+    uint32_t resent;          /**< DATA frames sent more than once */
+    uint32_t naks;            /**< NAKs received */
+    uint32_t timeouts;        /**< Response timeouts */
+} SXFER_HOST_STATS;
+
+/* Sender return codes */
+#define SXFER_HOST_OK           (0)
+#define SXFER_HOST_ERROR        (-1)   /**< Link or protocol failure */
+#define SXFER_HOST_REJECTED     (-2)   /**< Target sent ERROR */
+#define SXFER_HOST_STOPPED      (-3)   /**< Stopped at 'stopAt' */
+
+/*!****************************************************************
+ * @brief  Send an image
+ *
+ * @param [in]  link     Link to the target
+ * @param [in]  image    Image to send
+ * @param [in]  size     Image size in bytes
+ * @param [in]  session  Session id, reuse it to resume
+ * @param [in]  stopAt   Stop without END once this many bytes have
+ *                       been sent (0 for no limit), to exercise resume
+ * @param [out] stats    Transfer statistics (optional)
+ *
+ * @return SXFER_HOST_OK once the target reports DONE
+ ******************************************************************/
+int sxfer_host_send(const SXFER_HOST_LINK *link, const uint8_t *image,
+    uint32_t size, uint32_t session, uint32_t stopAt,
+    SXFER_HOST_STATS *stats);
+
+#endif
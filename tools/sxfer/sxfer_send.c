@@ -0,0 +1,179 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Windowed streaming transfer command line sender
+ *
+ * Sends a file to the target's 'update ... -s' or 'recv -s' command
+ * over the USB CDC console.  The session id defaults to the file's
+ * CRC32, so running the same command again after an interruption
+ * resumes where the target left off.
+ *
+ *   ./sxfer-send -c "update app -s" /dev/ttyACM0 app.ldr
+ *
+ * @file      sxfer_send.c
+ * @version   1.0.0
+ * @copyright 2022 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+
+#include "sxfer.h"
+#include "sxfer_host.h"
+#include "crc32.h"
+
+static int tty_read(uint8_t *data, unsigned len, unsigned timeout, void *usr)
+{
+    struct pollfd pfd = { .fd = *(int *)usr, .events = POLLIN };
+    int n;
+
+    n = poll(&pfd, 1, timeout);
+    if (n <= 0) {
+        return(n);
+    }
+    n = read(pfd.fd, data, len);
+    return((n == 0) ? -1 : n);
+}
+
+static int tty_write(const uint8_t *data, unsigned len, void *usr)
+{
+    int fd = *(int *)usr;
+    ssize_t n;
+
+    while (len) {
+        n = write(fd, data, len);
+        if (n <= 0) {
+            return(-1);
+        }
+        data += n;
+        len -= n;
+    }
+    return(0);
+}
+
+static uint8_t *load_file(const char *fname, uint32_t *size)
+{
+    uint8_t *data;
+    long len;
+    FILE *f;
+
+    f = fopen(fname, "rb");
+    if (f == NULL) {
+        return(NULL);
+    }
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc(len ? len : 1);
+    if (data && (fread(data, 1, len, f) != (size_t)len)) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = len;
+    return(data);
+}
+
+static void usage(void)
+{
+    printf(
+        "usage: sxfer-send [options] <tty> <file>\n"
+        "  -c <cmd>   Shell command starting the receiver (i.e. \"update app -s\")\n"
+        "  -i <id>    Session id (default: CRC32 of the file)\n"
+    );
+}
+
+int main(int argc, char **argv)
+{
+    SXFER_HOST_LINK link;
+    SXFER_HOST_STATS stats;
+    struct termios tio;
+    struct timespec t0, t1;
+    const char *cmd = NULL;
+    uint8_t *image;
+    uint32_t size, id;
+    int haveId = 0;
+    double secs;
+    int fd, c, err;
+
+    while ((c = getopt(argc, argv, "c:i:h")) != -1) {
+        switch (c) {
+            case 'c': cmd = optarg; break;
+            case 'i': id = strtoul(optarg, NULL, 0); haveId = 1; break;
+            default:
+                usage();
+                return(c == 'h' ? 0 : 1);
+        }
+    }
+    if ((argc - optind) != 2) {
+        usage();
+        return(1);
+    }
+
+    image = load_file(argv[optind + 1], &size);
+    if (image == NULL) {
+        fprintf(stderr, "sxfer-send: cannot read %s\n", argv[optind + 1]);
+        return(1);
+    }
+    if (!haveId) {
+        id = crc32(image, size);
+    }
+
+    fd = open(argv[optind], O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "sxfer-send: cannot open %s\n", argv[optind]);
+        return(1);
+    }
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    tcflush(fd, TCIOFLUSH);
+
+    if (cmd) {
+        tty_write((const uint8_t *)cmd, strlen(cmd), &fd);
+        tty_write((const uint8_t *)"\r", 1, &fd);
+    }
+
+    link.read = tty_read;
+    link.write = tty_write;
+    link.usr = &fd;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    err = sxfer_host_send(&link, image, size, id, 0, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    close(fd);
+    free(image);
+
+    if (err != SXFER_HOST_OK) {
+        fprintf(stderr, "sxfer-send: transfer failed (%d)\n", err);
+        return(1);
+    }
+
+    printf("Sent %u bytes (resumed at %u) in %.2fs, %.1f KB/s\n",
+        (unsigned)size, (unsigned)stats.resumeOffset, secs,
+        (size - stats.resumeOffset) / 1024.0 / secs);
+    printf("%u frames, %u resent, %u NAKs, %u timeouts\n",
+        (unsigned)stats.frames, (unsigned)stats.resent,
+        (unsigned)stats.naks, (unsigned)stats.timeouts);
+
+    return(0);
+}
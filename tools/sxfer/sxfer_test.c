@@ -0,0 +1,328 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Windowed streaming transfer end-to-end test
+ *
+ * Runs the target receiver (sxfer.c) and the reference sender
+ * (sxfer_host.c) on the two ends of a pty, with the receiver writing
+ * into a RAM image that must be erased before programming like the
+ * serial flash.  Covers a clean transfer, a link that corrupts DATA
+ * frames and a transfer that is interrupted and then resumed.
+ *
+ * The receiver is built without FREE_RTOS, so frames are written
+ * inline and the erase-ahead idle callback is not exercised here.
+ *
+ * @file      sxfer_test.c
+ * @version   1.0.0
+ * @copyright 2022 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "sxfer.h"
+#include "sxfer_host.h"
+
+#define TEST_IMAGE_SIZE   (2 * 1024 * 1024 + 1234)
+#define TEST_ERASE_SIZE   (64 * 1024)
+
+typedef struct TARGET {
+    int fd;
+    uint8_t *flash;
+    uint32_t erased;        /* Bytes erased so far */
+    unsigned idleErases;    /* Erases done ahead of the data */
+    unsigned writeErases;   /* Erases the data had to wait for */
+    bool dirty;             /* Programmed over unerased flash */
+    SXFER_SESSION session;
+    long result;
+} TARGET;
+
+typedef struct HOST {
+    int fd;
+    unsigned corruptEvery;
+    unsigned payloads;
+} HOST;
+
+static uint8_t *image;
+static uint32_t imageSize;
+
+/***********************************************************************
+ * Link
+ **********************************************************************/
+static int fd_read(int fd, uint8_t *data, unsigned len, unsigned timeout)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int n;
+
+    n = poll(&pfd, 1, timeout);
+    if (n <= 0) {
+        return(n);
+    }
+    n = read(fd, data, len);
+    return((n == 0) ? -1 : n);
+}
+
+static int fd_write(int fd, const uint8_t *data, unsigned len)
+{
+    ssize_t n;
+
+    while (len) {
+        n = write(fd, data, len);
+        if (n <= 0) {
+            return(-1);
+        }
+        data += n;
+        len -= n;
+    }
+    return(0);
+}
+
+/***********************************************************************
+ * Target side
+ **********************************************************************/
+static int target_read(uint8_t *data, unsigned len, unsigned timeout, void *usr)
+{
+    TARGET *t = (TARGET *)usr;
+    int n = fd_read(t->fd, data, len, timeout);
+    return((n < 0) ? 0 : n);
+}
+
+static int target_send(const uint8_t *data, unsigned len, void *usr)
+{
+    TARGET *t = (TARGET *)usr;
+    return(fd_write(t->fd, data, len));
+}
+
+static int target_start(uint32_t offset, uint32_t size, void *usr)
+{
+    TARGET *t = (TARGET *)usr;
+
+    /* Resuming keeps what has been erased, a new session starts over */
+    if (offset == 0) {
+        memset(t->flash, 0, TEST_IMAGE_SIZE);
+        t->erased = 0;
+    }
+    return(0);
+}
+
+static void target_erase(TARGET *t)
+{
+    memset(&t->flash[t->erased], 0xFF, TEST_ERASE_SIZE);
+    t->erased += TEST_ERASE_SIZE;
+}
+
+static int target_write(uint32_t offset, const uint8_t *data, unsigned len,
+    void *usr)
+{
+    TARGET *t = (TARGET *)usr;
+    unsigned i;
+
+    while (t->erased < (offset + len)) {
+        target_erase(t);
+        t->writeErases++;
+    }
+    for (i = 0; i < len; i++) {
+        if (t->flash[offset + i] != 0xFF) {
+            t->dirty = true;
+        }
+    }
+    memcpy(&t->flash[offset], data, len);
+    return(0);
+}
+
+static int target_idle(void *usr)
+{
+    TARGET *t = (TARGET *)usr;
+
+    if (t->erased >= t->session.size) {
+        return(0);
+    }
+    target_erase(t);
+    t->idleErases++;
+    return(1);
+}
+
+static void *target_thread(void *arg)
+{
+    TARGET *t = (TARGET *)arg;
+    SXFER_CONFIG cfg = {
+        .read = target_read,
+        .send = target_send,
+        .start = target_start,
+        .write = target_write,
+        .idle = target_idle,
+        .usr = t,
+        .maxSize = TEST_IMAGE_SIZE + TEST_ERASE_SIZE,
+        .session = &t->session,
+    };
+
+    t->result = sxfer_receive(&cfg);
+    return(NULL);
+}
+
+/***********************************************************************
+ * Host side
+ **********************************************************************/
+static int host_read(uint8_t *data, unsigned len, unsigned timeout, void *usr)
+{
+    HOST *h = (HOST *)usr;
+    return(fd_read(h->fd, data, len, timeout));
+}
+
+/* Flips a bit in every 'corruptEvery'th DATA payload */
+static int host_write(const uint8_t *data, unsigned len, void *usr)
+{
+    HOST *h = (HOST *)usr;
+    uint8_t *bad;
+    int err;
+
+    if ((len > 64) && h->corruptEvery &&
+        ((++h->payloads % h->corruptEvery) == 0)) {
+        bad = malloc(len);
+        memcpy(bad, data, len);
+        bad[len / 2] ^= 0x10;
+        err = fd_write(h->fd, bad, len);
+        free(bad);
+        return(err);
+    }
+    return(fd_write(h->fd, data, len));
+}
+
+/***********************************************************************
+ * Tests
+ **********************************************************************/
+static int openPty(int *master, int *slave)
+{
+    struct termios tio;
+
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((*master < 0) || grantpt(*master) || unlockpt(*master)) {
+        return(-1);
+    }
+    *slave = open(ptsname(*master), O_RDWR | O_NOCTTY);
+    if (*slave < 0) {
+        return(-1);
+    }
+    tcgetattr(*slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slave, TCSANOW, &tio);
+    return(0);
+}
+
+static int run(const char *name, TARGET *t, HOST *h, uint32_t stopAt,
+    uint32_t session, int expect, SXFER_HOST_STATS *stats)
+{
+    SXFER_HOST_LINK link = { host_read, host_write, h };
+    struct timespec t0, t1;
+    pthread_t thread;
+    double secs;
+    int err;
+
+    pthread_create(&thread, NULL, target_thread, t);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    err = sxfer_host_send(&link, image, imageSize, session, stopAt, stats);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    /* An interrupted receiver gives up after its retries */
+    pthread_join(thread, NULL);
+    tcflush(h->fd, TCIOFLUSH);
+
+    printf("%-12s send %d, receive %ld, resumed at %u, %u frames, "
+        "%u resent, %u NAKs, %.1f MB/s\n", name, err, t->result,
+        (unsigned)stats->resumeOffset, (unsigned)stats->frames,
+        (unsigned)stats->resent, (unsigned)stats->naks,
+        (imageSize - stats->resumeOffset) / secs / (1024 * 1024));
+
+    return(err == expect);
+}
+
+static bool check_image(const char *name, TARGET *t)
+{
+    bool ok = (memcmp(t->flash, image, imageSize) == 0) && !t->dirty;
+
+    printf("%-12s image %s, %u erases\n", name, ok ? "ok" : "MISMATCH",
+        t->idleErases + t->writeErases);
+    return(ok);
+}
+
+int main(int argc, char **argv)
+{
+    SXFER_HOST_STATS stats;
+    TARGET t;
+    HOST h;
+    int master, slave;
+    uint32_t committed;
+    unsigned fails = 0;
+    uint32_t i;
+
+    if (openPty(&master, &slave) != 0) {
+        fprintf(stderr, "sxfer-test: no pty\n");
+        return(1);
+    }
+
+    imageSize = TEST_IMAGE_SIZE;
+    image = malloc(imageSize);
+    srand(1);
+    for (i = 0; i < imageSize; i++) {
+        image[i] = rand();
+    }
+
+    memset(&t, 0, sizeof(t));
+    t.fd = slave;
+    t.flash = malloc(TEST_IMAGE_SIZE + TEST_ERASE_SIZE);
+    memset(&h, 0, sizeof(h));
+    h.fd = master;
+
+    /* Clean link */
+    fails += !run("clean", &t, &h, 0, 1, SXFER_HOST_OK, &stats);
+    fails += !check_image("clean", &t) || (t.result != imageSize) ||
+        (stats.resent != 0);
+
+    /* Corrupt every 7th DATA frame */
+    memset(&t.session, 0, sizeof(t.session));
+    t.idleErases = t.writeErases = 0;
+    h.corruptEvery = 7;
+    fails += !run("corrupt", &t, &h, 0, 2, SXFER_HOST_OK, &stats);
+    fails += !check_image("corrupt", &t) || (stats.naks == 0);
+    h.corruptEvery = 0;
+
+    /* Interrupt half way, then resume the same session */
+    memset(&t.session, 0, sizeof(t.session));
+    t.idleErases = t.writeErases = 0;
+    fails += !run("interrupted", &t, &h, imageSize / 2, 3,
+        SXFER_HOST_STOPPED, &stats);
+    fails += (t.result != SXFER_ERROR_RETRYEXCEED);
+    committed = t.session.offset;
+    fails += !run("resumed", &t, &h, 0, 3, SXFER_HOST_OK, &stats);
+    fails += (committed == 0) || (stats.resumeOffset != committed);
+    fails += !check_image("resumed", &t);
+
+    close(slave);
+    close(master);
+    free(t.flash);
+    free(image);
+
+    printf("%s\n", fails ? "FAIL" : "PASS");
+    return(fails ? 1 : 0);
+}
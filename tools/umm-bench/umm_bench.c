@@ -0,0 +1,616 @@
+/**
+ * Copyright (c) 2021 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*!
+ * @brief  Host side umm_malloc trace-replay benchmark
+ *
+ * Replays an allocation trace against one umm_malloc heap and reports
+ * per-operation times, failed allocations and how fragmented the heap
+ * is at the trace's peak.  The makefile builds it once per backend so
+ * the TLSF and legacy block allocators see exactly the same trace.
+ *
+ * Times are the best of several passes per operation, so the p99 and
+ * max are the allocator's and not the host scheduler's.  The max
+ * operation's index in the trace is reported so it can be looked at.
+ * Failures with a large enough free block still in the heap are
+ * counted separately, they are the allocator's fit and not a full heap.
+ *
+ * Without '-t' a synthetic trace is generated: mostly short lived
+ * small buffers (messages, shell lines), medium stream buffers and a
+ * few long lived large ones (file and audio buffers), held to a
+ * target fill of the heap.  A trace is one operation per line:
+ *
+ *   m <id> <size>     malloc
+ *   r <id> <size>     realloc
+ *   f <id>            free
+ *
+ * @file      umm_bench.c
+ * @version   1.0.0
+ * @copyright 2022 Analog Devices, Inc.  All rights reserved.
+ *
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "umm_malloc.h"
+#include "umm_malloc_cfg.h"
+
+#ifdef UMM_TLSF
+#define BENCH_ALLOCATOR  "tlsf"
+#else
+#define BENCH_ALLOCATOR  "umm"
+#endif
+
+#define BENCH_HEAP  UMM_SDRAM_HEAP
+
+typedef struct TRACE_OP {
+    char op;
+    uint32_t id;
+    uint32_t size;
+} TRACE_OP;
+
+typedef struct TRACE {
+    TRACE_OP *ops;
+    unsigned numOps;
+    unsigned maxOps;
+    uint32_t maxId;
+} TRACE;
+
+static uint32_t randState = 1;
+
+/***********************************************************************
+ * Helpers
+ **********************************************************************/
+static uint32_t rnd(void)
+{
+    randState ^= randState << 13;
+    randState ^= randState >> 17;
+    randState ^= randState << 5;
+    return(randState);
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi)
+{
+    return(lo + rnd() % (hi - lo + 1));
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static bool trace_add(TRACE *t, char op, uint32_t id, uint32_t size)
+{
+    TRACE_OP *ops;
+
+    if (t->numOps == t->maxOps) {
+        t->maxOps = t->maxOps ? 2 * t->maxOps : 4096;
+        ops = realloc(t->ops, t->maxOps * sizeof(*ops));
+        if (ops == NULL) {
+            return(false);
+        }
+        t->ops = ops;
+    }
+    t->ops[t->numOps].op = op;
+    t->ops[t->numOps].id = id;
+    t->ops[t->numOps].size = size;
+    t->numOps++;
+    if (id > t->maxId) {
+        t->maxId = id;
+    }
+    return(true);
+}
+
+/***********************************************************************
+ * Traces
+ **********************************************************************/
+typedef struct LIVE {
+    uint32_t id;
+    uint32_t size;
+    unsigned expires;
+} LIVE;
+
+static bool trace_generate(TRACE *t, unsigned allocs, unsigned heapSize,
+    unsigned fill)
+{
+    LIVE *live;
+    unsigned numLive, oldest;
+    uint64_t liveBytes, target;
+    uint32_t size, id;
+    unsigned life, c;
+    unsigned n, i;
+
+    live = malloc(allocs * sizeof(*live));
+    if (live == NULL) {
+        return(false);
+    }
+    numLive = 0;
+    liveBytes = 0;
+    target = (uint64_t)heapSize * fill / 100;
+
+    for (n = 0, id = 0; n < allocs; n++, id++) {
+
+        /* Retire everything that has expired */
+        for (i = 0; i < numLive; ) {
+            if (live[i].expires <= n) {
+                trace_add(t, 'f', live[i].id, 0);
+                liveBytes -= live[i].size;
+                live[i] = live[--numLive];
+            } else {
+                i++;
+            }
+        }
+
+        c = rnd() % 100;
+        if (c < 60) {
+            size = rnd_range(16, 512);
+            life = rnd_range(1, 32);
+        } else if (c < 92) {
+            size = rnd_range(1024, 16384);
+            life = rnd_range(16, 512);
+        } else {
+            size = rnd_range(32768, 262144);
+            life = rnd_range(256, 4096);
+        }
+
+        /* Hold the fill level by retiring the oldest allocations early */
+        while (numLive && ((liveBytes + size) > target)) {
+            oldest = 0;
+            for (i = 1; i < numLive; i++) {
+                if (live[i].id < live[oldest].id) {
+                    oldest = i;
+                }
+            }
+            trace_add(t, 'f', live[oldest].id, 0);
+            liveBytes -= live[oldest].size;
+            live[oldest] = live[--numLive];
+        }
+
+        /* Some stream buffers grow or shrink once */
+        if ((c >= 60) && (c < 92) && ((rnd() % 16) == 0) && numLive) {
+            i = rnd() % numLive;
+            if (live[i].size >= 1024) {
+                size = live[i].size;
+                live[i].size = rnd_range(size / 2, size + size / 2);
+                trace_add(t, 'r', live[i].id, live[i].size);
+                liveBytes = liveBytes - size + live[i].size;
+            }
+        }
+
+        if (!trace_add(t, 'm', id, size)) {
+            free(live);
+            return(false);
+        }
+        live[numLive].id = id;
+        live[numLive].size = size;
+        live[numLive].expires = n + life;
+        numLive++;
+        liveBytes += size;
+    }
+
+    for (i = 0; i < numLive; i++) {
+        trace_add(t, 'f', live[i].id, 0);
+    }
+
+    free(live);
+
+    return(true);
+}
+
+static bool trace_load(TRACE *t, const char *fname)
+{
+    char line[128];
+    unsigned long id, size;
+    char op;
+    FILE *f;
+    int n;
+
+    f = fopen(fname, "r");
+    if (f == NULL) {
+        return(false);
+    }
+    while (fgets(line, sizeof(line), f)) {
+        size = 0;
+        n = sscanf(line, " %c %lu %lu", &op, &id, &size);
+        if ((n < 2) || (op == '#')) {
+            continue;
+        }
+        if (((op != 'm') && (op != 'r') && (op != 'f')) ||
+            ((op != 'f') && (n != 3))) {
+            fclose(f);
+            return(false);
+        }
+        if (!trace_add(t, op, id, size)) {
+            fclose(f);
+            return(false);
+        }
+    }
+    fclose(f);
+
+    return(true);
+}
+
+static bool trace_save(const TRACE *t, const char *fname)
+{
+    unsigned i;
+    FILE *f;
+
+    f = fopen(fname, "w");
+    if (f == NULL) {
+        return(false);
+    }
+    for (i = 0; i < t->numOps; i++) {
+        if (t->ops[i].op == 'f') {
+            fprintf(f, "f %u\n", (unsigned)t->ops[i].id);
+        } else {
+            fprintf(f, "%c %u %u\n", t->ops[i].op,
+                (unsigned)t->ops[i].id, (unsigned)t->ops[i].size);
+        }
+    }
+    fclose(f);
+
+    return(true);
+}
+
+/***********************************************************************
+ * Replay
+ **********************************************************************/
+#define OP_UNTIMED  UINT32_MAX
+
+typedef struct REPLAY {
+    uint32_t *opNs;             /* Best time per trace op over the passes */
+    unsigned mallocFails;
+    unsigned reallocFails;
+    unsigned fitFails;          /* ... with a large enough block free */
+    uint64_t peakBytes;
+    UMM_HEAP_INFO peakInfo;
+} REPLAY;
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return((x > y) - (x < y));
+}
+
+/* Smallest back to back timestamp difference, taken off every sample */
+static uint32_t timer_overhead(void)
+{
+    uint64_t t0, t1, best = UINT64_MAX;
+    unsigned i;
+
+    for (i = 0; i < 10000; i++) {
+        t0 = now_ns();
+        t1 = now_ns();
+        if ((t1 - t0) < best) {
+            best = t1 - t0;
+        }
+    }
+    return((uint32_t)best);
+}
+
+static void time_op(REPLAY *r, unsigned i, uint64_t ns, uint32_t overhead)
+{
+    ns = (ns > overhead) ? ns - overhead : 0;
+    if (ns < r->opNs[i]) {
+        r->opNs[i] = (uint32_t)ns;
+    }
+}
+
+/* Counts a failed request the largest free block had room for */
+static void count_fail(REPLAY *r, uint32_t size)
+{
+    UMM_HEAP_INFO info;
+
+    umm_info(BENCH_HEAP, &info, NULL, 0);
+    if ((uint64_t)info.maxFreeContiguousBlocks * umm_block_size() >=
+            size + umm_block_size()) {
+        r->fitFails++;
+    }
+}
+
+static void print_times(const char *what, const TRACE *t, const REPLAY *r,
+    char op, uint32_t *ns)
+{
+    unsigned i, n, maxOp;
+    uint64_t sum = 0;
+
+    for (i = 0, n = 0, maxOp = 0; i < t->numOps; i++) {
+        if ((t->ops[i].op == op) && (r->opNs[i] != OP_UNTIMED)) {
+            if ((n == 0) || (r->opNs[i] > r->opNs[maxOp])) {
+                maxOp = i;
+            }
+            ns[n++] = r->opNs[i];
+            sum += r->opNs[i];
+        }
+    }
+    if (n == 0) {
+        printf(",%s_n,0", what);
+        return;
+    }
+    qsort(ns, n, sizeof(ns[0]), cmp_u32);
+    printf(",%s_n,%u,%s_avg_ns,%u,%s_p99_ns,%u,%s_max_ns,%u,%s_max_op,%u",
+        what, n, what, (unsigned)(sum / n),
+        what, (unsigned)ns[(uint64_t)n * 99 / 100],
+        what, (unsigned)ns[n - 1], what, maxOp);
+}
+
+/* The first bytes of every allocation carry its id, realloc must keep them */
+static void stamp(void *p, uint32_t id, uint32_t size)
+{
+    memset(p, (int)(id & 0xFF), size < 64 ? size : 64);
+}
+
+static bool stamp_ok(const void *p, uint32_t id, uint32_t size)
+{
+    const uint8_t *b = p;
+    unsigned i;
+
+    for (i = 0; i < (size < 64 ? size : 64); i++) {
+        if (b[i] != (id & 0xFF)) {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+static bool replay_pass(const TRACE *t, void *heapMem, unsigned heapSize,
+    unsigned checks, uint32_t overhead, REPLAY *r, void **ptrs,
+    uint32_t *sizes)
+{
+    UMM_HEAP_INFO info;
+    uint64_t liveBytes;
+    uint64_t t0, t1;
+    void *p;
+    unsigned i;
+    bool ok;
+
+    memset(ptrs, 0, (t->maxId + 1) * sizeof(*ptrs));
+    memset(sizes, 0, (t->maxId + 1) * sizeof(*sizes));
+
+    /* Fault the heap in first, the legacy umm_init() clears it anyway */
+    memset(heapMem, 0, heapSize);
+    umm_init(BENCH_HEAP, heapMem, heapSize);
+    umm_set_checks(BENCH_HEAP, checks);
+
+    memset(&r->peakInfo, 0, sizeof(r->peakInfo));
+    r->mallocFails = r->reallocFails = r->fitFails = 0;
+    liveBytes = r->peakBytes = 0;
+    ok = true;
+
+    for (i = 0; i < t->numOps; i++) {
+        const TRACE_OP *op = &t->ops[i];
+        switch (op->op) {
+            case 'm':
+                t0 = now_ns();
+                p = umm_malloc_heap(BENCH_HEAP, op->size);
+                t1 = now_ns();
+                time_op(r, i, t1 - t0, overhead);
+                if (p) {
+                    stamp(p, op->id, op->size);
+                    ptrs[op->id] = p;
+                    sizes[op->id] = op->size;
+                    liveBytes += op->size;
+                } else {
+                    r->mallocFails++;
+                    count_fail(r, op->size);
+                }
+                break;
+            case 'r':
+                if (ptrs[op->id] == NULL) {
+                    break;
+                }
+                t0 = now_ns();
+                p = umm_realloc_heap(BENCH_HEAP, ptrs[op->id], op->size);
+                t1 = now_ns();
+                time_op(r, i, t1 - t0, overhead);
+                if (p) {
+                    ok = stamp_ok(p, op->id, op->size < sizes[op->id] ?
+                        op->size : sizes[op->id]) && ok;
+                    stamp(p, op->id, op->size);
+                    ptrs[op->id] = p;
+                    liveBytes = liveBytes - sizes[op->id] + op->size;
+                    sizes[op->id] = op->size;
+                } else {
+                    r->reallocFails++;
+                    count_fail(r, op->size);
+#ifndef UMM_TLSF
+                    /* The legacy realloc frees the old block when it fails */
+                    liveBytes -= sizes[op->id];
+                    ptrs[op->id] = NULL;
+#endif
+                }
+                break;
+            case 'f':
+                if (ptrs[op->id] == NULL) {
+                    break;
+                }
+                ok = stamp_ok(ptrs[op->id], op->id, sizes[op->id]) && ok;
+                t0 = now_ns();
+                umm_free_heap(BENCH_HEAP, ptrs[op->id]);
+                t1 = now_ns();
+                time_op(r, i, t1 - t0, overhead);
+                liveBytes -= sizes[op->id];
+                ptrs[op->id] = NULL;
+                break;
+        }
+
+        /* Fragmentation where it matters, at the highest fill */
+        if (liveBytes > r->peakBytes) {
+            r->peakBytes = liveBytes;
+            if ((i % 64) == 0) {
+                umm_info(BENCH_HEAP, &r->peakInfo, NULL, 0);
+            }
+        }
+    }
+
+    /* Every allocation was freed, the heap must be whole again */
+    umm_info(BENCH_HEAP, &info, NULL, 0);
+
+    return(ok && (info.freeEntries == 1) && (info.usedEntries == 0));
+}
+
+/*
+ * Replays the trace 'passes' times on a fresh heap and keeps each
+ * operation's best time.  Every pass does exactly the same work, so a
+ * slow operation that is slow in every pass is the allocator's and one
+ * that is slow once is the host's (preemption, interrupts, page faults).
+ */
+static bool replay(const TRACE *t, void *heapMem, unsigned heapSize,
+    unsigned checks, unsigned passes)
+{
+    REPLAY r;
+    uint32_t *sizes;
+    uint32_t overhead;
+    uint32_t *ns;
+    void **ptrs;
+    unsigned i;
+    bool ok;
+
+    memset(&r, 0, sizeof(r));
+    ptrs = calloc(t->maxId + 1, sizeof(*ptrs));
+    sizes = calloc(t->maxId + 1, sizeof(*sizes));
+    r.opNs = malloc(t->numOps * sizeof(uint32_t));
+    ns = malloc(t->numOps * sizeof(uint32_t));
+    if (!ptrs || !sizes || !r.opNs || !ns) {
+        return(false);
+    }
+    for (i = 0; i < t->numOps; i++) {
+        r.opNs[i] = OP_UNTIMED;
+    }
+
+    overhead = timer_overhead();
+    ok = true;
+    for (i = 0; i < passes; i++) {
+        ok = replay_pass(t, heapMem, heapSize, checks, overhead, &r,
+            ptrs, sizes) && ok;
+    }
+
+    printf("alloc,%s%s,ops,%u,passes,%u", BENCH_ALLOCATOR,
+        checks ? "+checks" : "", t->numOps, passes);
+    print_times("malloc", t, &r, 'm', ns);
+    print_times("realloc", t, &r, 'r', ns);
+    print_times("free", t, &r, 'f', ns);
+    printf(",malloc_fails,%u,realloc_fails,%u,fit_fails,%u,"
+        "peak_kb,%u,peak_free_kb,%u,peak_largest_kb,%u,%s\n",
+        r.mallocFails, r.reallocFails, r.fitFails,
+        (unsigned)(r.peakBytes / 1024),
+        (unsigned)((uint64_t)r.peakInfo.freeBlocks * umm_block_size() / 1024),
+        (unsigned)((uint64_t)r.peakInfo.maxFreeContiguousBlocks *
+            umm_block_size() / 1024),
+        ok ? "ok" : "FAIL");
+
+    free(ptrs);
+    free(sizes);
+    free(r.opNs);
+    free(ns);
+
+    return(ok);
+}
+
+static void usage(void)
+{
+    printf(
+        "usage: umm-bench [options]\n"
+        "  -t <file>   Replay a trace file instead of a synthetic trace\n"
+        "  -w <file>   Write the trace that is replayed\n"
+        "  -n <num>    Synthetic trace allocations (default 200000)\n"
+        "  -f <pct>    Synthetic trace heap fill (default 70)\n"
+        "  -m <kb>     Heap size in KB (default 4096)\n"
+        "  -s <seed>   Synthetic trace seed (default 1)\n"
+        "  -r <num>    Passes, each operation's best time is kept (default 5)\n"
+        "  -c          Also run with the runtime heap checks on\n"
+    );
+}
+
+int main(int argc, char **argv)
+{
+    const char *traceFile = NULL;
+    const char *saveFile = NULL;
+    unsigned allocs = 200000;
+    unsigned fill = 70;
+    unsigned heapKb = 4096;
+    unsigned passes = 5;
+    bool checks = false;
+    void *heapMem;
+    TRACE trace;
+    bool ok;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) {
+            traceFile = argv[++i];
+        } else if ((strcmp(argv[i], "-w") == 0) && (i + 1 < argc)) {
+            saveFile = argv[++i];
+        } else if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            allocs = strtoul(argv[++i], NULL, 0);
+        } else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc)) {
+            fill = strtoul(argv[++i], NULL, 0);
+        } else if ((strcmp(argv[i], "-m") == 0) && (i + 1 < argc)) {
+            heapKb = strtoul(argv[++i], NULL, 0);
+        } else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+            randState = strtoul(argv[++i], NULL, 0);
+        } else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) {
+            passes = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            checks = true;
+        } else {
+            usage();
+            return(1);
+        }
+    }
+    if ((heapKb == 0) || (fill == 0) || (fill > 100) || (randState == 0) ||
+        (passes == 0)) {
+        usage();
+        return(1);
+    }
+
+    memset(&trace, 0, sizeof(trace));
+    if (traceFile) {
+        ok = trace_load(&trace, traceFile);
+    } else {
+        ok = trace_generate(&trace, allocs, heapKb * 1024, fill);
+    }
+    if (!ok || (trace.numOps == 0)) {
+        fprintf(stderr, "umm-bench: no trace\n");
+        return(1);
+    }
+    if (saveFile && !trace_save(&trace, saveFile)) {
+        fprintf(stderr, "umm-bench: cannot write %s\n", saveFile);
+        return(1);
+    }
+
+    heapMem = malloc(heapKb * 1024);
+    if (heapMem == NULL) {
+        return(1);
+    }
+
+    ok = replay(&trace, heapMem, heapKb * 1024, 0, passes);
+    if (checks) {
+#ifdef UMM_TLSF
+        ok = replay(&trace, heapMem, heapKb * 1024,
+            UMM_CHECK_INTEGRITY | UMM_CHECK_POISON, passes) && ok;
+#else
+        fprintf(stderr, "umm-bench: no runtime checks in this allocator\n");
+#endif
+    }
+
+    free(heapMem);
+    free(trace.ops);
+
+    return(ok ? 0 : 1);
+}